@@ -0,0 +1,138 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "teem/air.h"
+
+/*
+** Tests:
+** airThreadRun: every per-thread struct is given to exactly one thread,
+** and the work handed out under a mutex is all done exactly once, with
+** any number of threads
+**
+** Also uses:
+** airThreadMutexNew, airThreadMutexLock, airThreadMutexUnlock,
+** airThreadMutexNix
+*/
+
+#define WORK_NUM 1000
+
+typedef struct {
+  airThreadMutex *mutex;      /* NULL for a single thread */
+  unsigned int workIdx,       /* next work item to hand out */
+    done[WORK_NUM];           /* how many times each item was done */
+} task_t;
+
+typedef struct {
+  task_t *task;
+  unsigned int runNum,        /* how many times this struct was run */
+    doneNum;                  /* how many items this thread did */
+} arg_t;
+
+static void *
+worker(void *_arg) {
+  arg_t *arg;
+  task_t *task;
+  unsigned int wi;
+
+  arg = AIR_CAST(arg_t *, _arg);
+  task = arg->task;
+  arg->runNum++;
+  for (;;) {
+    if (task->mutex) {
+      airThreadMutexLock(task->mutex);
+    }
+    wi = task->workIdx;
+    if (wi < WORK_NUM) {
+      task->workIdx++;
+    }
+    if (task->mutex) {
+      airThreadMutexUnlock(task->mutex);
+    }
+    if (WORK_NUM == wi) {
+      break;
+    }
+    /* each item is handed out once, so this needs no locking */
+    task->done[wi]++;
+    arg->doneNum++;
+  }
+  return _arg;
+}
+
+int
+main(int argc, const char *argv[]) {
+  const char *me;
+  task_t task;
+  arg_t arg[5];
+  unsigned int threadNum, ti, wi, doneNum;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  for (threadNum=1; threadNum<=5; threadNum++) {
+    task.mutex = 1 < threadNum ? airThreadMutexNew() : NULL;
+    if (1 < threadNum && !task.mutex) {
+      fprintf(stderr, "%s: couldn't make mutex\n", me);
+      return 1;
+    }
+    task.workIdx = 0;
+    for (wi=0; wi<WORK_NUM; wi++) {
+      task.done[wi] = 0;
+    }
+    for (ti=0; ti<threadNum; ti++) {
+      arg[ti].task = &task;
+      arg[ti].runNum = arg[ti].doneNum = 0;
+    }
+    if (airThreadRun(worker, arg, sizeof(arg_t), threadNum)) {
+      fprintf(stderr, "%s: couldn't run %u threads\n", me, threadNum);
+      return 1;
+    }
+    if (task.mutex) {
+      airThreadMutexNix(task.mutex);
+    }
+    doneNum = 0;
+    for (ti=0; ti<threadNum; ti++) {
+      if (1 != arg[ti].runNum) {
+        fprintf(stderr, "%s: %u threads: arg %u run %u times\n", me,
+                threadNum, ti, arg[ti].runNum);
+        return 1;
+      }
+      doneNum += arg[ti].doneNum;
+    }
+    for (wi=0; wi<WORK_NUM; wi++) {
+      if (1 != task.done[wi]) {
+        fprintf(stderr, "%s: %u threads: item %u done %u times\n", me,
+                threadNum, wi, task.done[wi]);
+        return 1;
+      }
+    }
+    if (WORK_NUM != doneNum) {
+      fprintf(stderr, "%s: %u threads: did %u != %u items\n", me,
+              threadNum, doneNum, WORK_NUM);
+      return 1;
+    }
+  }
+  if (!airThreadRun(worker, arg, sizeof(arg_t), 0)) {
+    fprintf(stderr, "%s: zero threads didn't fail\n", me);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,219 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "teem/ell.h"
+
+/*
+** Tests:
+** ell_6ms_eigensolve_d, ell_6ms_eigensolve_batch_d: on symmetric 6x6
+** matrices made from known eigensystems (with distinct and repeated
+** eigenvalues, over many scales), the eigenvalues have to be accurate and
+** sorted, the eigenvectors have to be orthonormal and diagonalize the
+** matrix, and batches have to give the same results with any number of
+** threads
+*/
+
+#define NUM 1001
+
+/* sets in mat the 6x6 matrix (and in sym its upper triangle) with
+   eigenvalues eval and eigenvectors (rows of) a random orthonormal basis */
+static void
+matSet(double mat[36], double sym[21], double eval[6], unsigned int ii) {
+  double basis[36], scl, dot, len;
+  unsigned int rr, cc, kk, si, pass;
+
+  scl = pow(10.0, AIR_AFFINE(0, airDrandMT(), 1, -8, 8));
+  for (rr=0; rr<6; rr++) {
+    eval[rr] = scl*AIR_AFFINE(0, airDrandMT(), 1, -1, 1);
+  }
+  switch (ii % 4) {
+  case 0: /* all the same */
+    for (rr=1; rr<6; rr++) {
+      eval[rr] = eval[0];
+    }
+    break;
+  case 1: /* two triples */
+    eval[1] = eval[2] = eval[0];
+    eval[4] = eval[5] = eval[3];
+    break;
+  case 2: /* a pair, and nearly a pair */
+    eval[1] = eval[0];
+    eval[3] = eval[2]*(1 + 1e-9);
+    break;
+  default: /* distinct */
+    break;
+  }
+  /* Gram-Schmidt on random vectors (twice, so that it is orthonormal to
+     within round-off) */
+  for (rr=0; rr<6; rr++) {
+    for (cc=0; cc<6; cc++) {
+      basis[cc + 6*rr] = AIR_AFFINE(0, airDrandMT(), 1, -1, 1);
+    }
+    for (pass=0; pass<2; pass++) {
+      for (kk=0; kk<rr; kk++) {
+        dot = 0;
+        for (cc=0; cc<6; cc++) {
+          dot += basis[cc + 6*rr]*basis[cc + 6*kk];
+        }
+        for (cc=0; cc<6; cc++) {
+          basis[cc + 6*rr] -= dot*basis[cc + 6*kk];
+        }
+      }
+    }
+    len = 0;
+    for (cc=0; cc<6; cc++) {
+      len += basis[cc + 6*rr]*basis[cc + 6*rr];
+    }
+    len = sqrt(len);
+    for (cc=0; cc<6; cc++) {
+      basis[cc + 6*rr] /= len;
+    }
+  }
+  si = 0;
+  for (rr=0; rr<6; rr++) {
+    for (cc=0; cc<6; cc++) {
+      mat[cc + 6*rr] = 0;
+      for (kk=0; kk<6; kk++) {
+        mat[cc + 6*rr] += eval[kk]*basis[rr + 6*kk]*basis[cc + 6*kk];
+      }
+    }
+    for (cc=rr; cc<6; cc++) {
+      sym[si++] = mat[cc + 6*rr];
+    }
+  }
+  /* sort known eigenvalues, descending */
+  for (rr=1; rr<6; rr++) {
+    for (kk=rr; kk > 0 && eval[kk-1] < eval[kk]; kk--) {
+      ELL_SWAP2(eval[kk-1], eval[kk], dot);
+    }
+  }
+  return;
+}
+
+int
+main(int argc, const char **argv) {
+  const char *me;
+  char *err;
+  airArray *mop;
+  double *mat, *sym, *ans, *eval, *evec, *bval, *bvec, nval[6], scl, tol,
+    dot, res;
+  unsigned int ii, rr, cc, kk, tn;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+
+  airSrandMT(4242);
+  mat = AIR_CALLOC(36*NUM, double);
+  airMopAdd(mop, mat, airFree, airMopAlways);
+  sym = AIR_CALLOC(21*NUM, double);
+  airMopAdd(mop, sym, airFree, airMopAlways);
+  ans = AIR_CALLOC(6*NUM, double);
+  airMopAdd(mop, ans, airFree, airMopAlways);
+  eval = AIR_CALLOC(6*NUM, double);
+  airMopAdd(mop, eval, airFree, airMopAlways);
+  evec = AIR_CALLOC(36*NUM, double);
+  airMopAdd(mop, evec, airFree, airMopAlways);
+  bval = AIR_CALLOC(6*NUM, double);
+  airMopAdd(mop, bval, airFree, airMopAlways);
+  bvec = AIR_CALLOC(36*NUM, double);
+  airMopAdd(mop, bvec, airFree, airMopAlways);
+  if (!( mat && sym && ans && eval && evec && bval && bvec )) {
+    fprintf(stderr, "%s: couldn't allocate\n", me);
+    airMopError(mop); return 1;
+  }
+
+  for (ii=0; ii<NUM; ii++) {
+    matSet(mat + 36*ii, sym + 21*ii, ans + 6*ii, ii);
+    if (ell_6ms_eigensolve_d(eval + 6*ii, evec + 36*ii, sym + 21*ii, 0)
+        || ell_6ms_eigensolve_d(nval, NULL, sym + 21*ii, 0)) {
+      fprintf(stderr, "%s: eigensolve failed on %u\n", me, ii);
+      airMopError(mop); return 1;
+    }
+    scl = AIR_MAX(AIR_ABS(ans[0 + 6*ii]), AIR_ABS(ans[5 + 6*ii]));
+    tol = 1e-13*scl;
+    for (rr=0; rr<6; rr++) {
+      if (!( AIR_ABS(eval[rr + 6*ii] - ans[rr + 6*ii]) <= tol )) {
+        fprintf(stderr, "%s: %u: eval[%u] %.17g not %.17g\n", me, ii, rr,
+                eval[rr + 6*ii], ans[rr + 6*ii]);
+        airMopError(mop); return 1;
+      }
+      if (nval[rr] != eval[rr + 6*ii]) {
+        fprintf(stderr, "%s: %u: eval[%u] %.17g w/out evecs, %.17g with\n",
+                me, ii, rr, nval[rr], eval[rr + 6*ii]);
+        airMopError(mop); return 1;
+      }
+      /* orthonormal */
+      for (kk=0; kk<=rr; kk++) {
+        dot = 0;
+        for (cc=0; cc<6; cc++) {
+          dot += evec[cc + 6*rr + 36*ii]*evec[cc + 6*kk + 36*ii];
+        }
+        if (!( AIR_ABS(dot - (rr == kk)) < 1e-13 )) {
+          fprintf(stderr, "%s: %u: evec[%u].evec[%u] = %.17g\n", me, ii,
+                  rr, kk, dot);
+          airMopError(mop); return 1;
+        }
+      }
+      /* residual |M v - lambda v| */
+      res = 0;
+      for (cc=0; cc<6; cc++) {
+        dot = -eval[rr + 6*ii]*evec[cc + 6*rr + 36*ii];
+        for (kk=0; kk<6; kk++) {
+          dot += mat[kk + 6*cc + 36*ii]*evec[kk + 6*rr + 36*ii];
+        }
+        res += dot*dot;
+      }
+      if (!( sqrt(res) <= tol )) {
+        fprintf(stderr, "%s: %u: evec[%u] residual %g > %g\n", me, ii, rr,
+                sqrt(res), tol);
+        airMopError(mop); return 1;
+      }
+    }
+  }
+
+  for (tn=1; tn<=3; tn += 2) {
+    if (ell_6ms_eigensolve_batch_d(bval, bvec, sym, NUM, 0, tn)) {
+      airMopAdd(mop, err = biffGetDone(ELL), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble with batch:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    for (ii=0; ii<6*NUM; ii++) {
+      if (bval[ii] != eval[ii]) {
+        fprintf(stderr, "%s: %u threads: eval[%u] %.17g != %.17g\n", me, tn,
+                ii, bval[ii], eval[ii]);
+        airMopError(mop); return 1;
+      }
+    }
+    for (ii=0; ii<36*NUM; ii++) {
+      if (bvec[ii] != evec[ii]) {
+        fprintf(stderr, "%s: %u threads: evec[%u] %.17g != %.17g\n", me, tn,
+                ii, bvec[ii], evec[ii]);
+        airMopError(mop); return 1;
+      }
+    }
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
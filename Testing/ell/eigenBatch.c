@@ -0,0 +1,214 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "teem/ell.h"
+
+/*
+** Tests:
+** ell_3ms_eigensolve_batch_d, ell_3ms_eigensolve_batch_f: on symmetric
+** matrices made from known eigensystems (with distinct, repeated, and
+** nearly repeated eigenvalues, over many scales), the eigenvalues have to
+** be as accurate as those of ell_3m_eigensolve_d, the eigenvectors have
+** to be right-handed orthonormal bases that diagonalize the matrix, and
+** the float version has to agree with the double version
+*/
+
+/* not a multiple of the batch size */
+#define NUM 3001
+
+/* sets in eval the eigenvalues for matrix ii, in descending order */
+static void
+evalSet(double eval[3], unsigned int ii) {
+  double scl, tmp;
+
+  scl = pow(10.0, AIR_AFFINE(0, airDrandMT(), 1, -8, 8));
+  ELL_3V_SET(eval, scl*AIR_AFFINE(0, airDrandMT(), 1, -1, 1),
+             scl*AIR_AFFINE(0, airDrandMT(), 1, -1, 1),
+             scl*AIR_AFFINE(0, airDrandMT(), 1, -1, 1));
+  switch (ii % 8) {
+  case 0: /* isotropic */
+    eval[1] = eval[2] = eval[0];
+    break;
+  case 1: /* double root */
+    eval[2] = eval[1];
+    break;
+  case 2: /* nearly double root */
+    eval[2] = eval[1]*(1 + 1e-7);
+    break;
+  case 3: /* all nearly equal */
+    eval[1] = eval[0]*(1 + 2e-9);
+    eval[2] = eval[0]*(1 - 3e-9);
+    break;
+  case 4: /* zero */
+    ELL_3V_SET(eval, 0, 0, 0);
+    break;
+  default: /* distinct */
+    break;
+  }
+  ELL_SORT3(eval[0], eval[1], eval[2], tmp);
+  return;
+}
+
+int
+main(int argc, const char **argv) {
+  const char *me;
+  airArray *mop;
+  double *sym, *eval, *evec, *want, mat[9], rot[9], tmp[9], quat[4],
+    ev[3], vv[3][3], mv[3], len, scl, err, dot;
+  float *symf, *evalf, *evecf;
+  unsigned int ii, ei, ci, cj;
+  static const unsigned int cidx[6] = {0, 1, 2, 4, 5, 8};
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+
+  sym = AIR_CALLOC(6*NUM, double);
+  airMopAdd(mop, sym, airFree, airMopAlways);
+  eval = AIR_CALLOC(3*NUM, double);
+  airMopAdd(mop, eval, airFree, airMopAlways);
+  evec = AIR_CALLOC(9*NUM, double);
+  airMopAdd(mop, evec, airFree, airMopAlways);
+  want = AIR_CALLOC(12*NUM, double);
+  airMopAdd(mop, want, airFree, airMopAlways);
+  symf = AIR_CALLOC(6*NUM, float);
+  airMopAdd(mop, symf, airFree, airMopAlways);
+  evalf = AIR_CALLOC(3*NUM, float);
+  airMopAdd(mop, evalf, airFree, airMopAlways);
+  evecf = AIR_CALLOC(9*NUM, float);
+  airMopAdd(mop, evecf, airFree, airMopAlways);
+  if (!(sym && eval && evec && want && symf && evalf && evecf)) {
+    fprintf(stderr, "%s: couldn't allocate\n", me);
+    airMopError(mop); return 1;
+  }
+
+  airSrandMT(4242);
+  for (ii=0; ii<NUM; ii++) {
+    /* mat = rot^T diag(eval) rot, so the rows of rot are the evecs */
+    evalSet(want + 12*ii, ii);
+    ELL_4V_SET(quat, airDrandMT() - 0.5, airDrandMT() - 0.5,
+               airDrandMT() - 0.5, airDrandMT() - 0.5);
+    ELL_4V_NORM(quat, quat, len);
+    ell_q_to_3m_d(rot, quat);
+    ELL_3M_COPY(want + 12*ii + 3, rot);
+    ELL_3M_ZERO_SET(mat);
+    ELL_3M_DIAG_SET(mat, want[12*ii + 0], want[12*ii + 1], want[12*ii + 2]);
+    ELL_3M_MUL(tmp, mat, rot);
+    ELL_3M_TRANSPOSE(mat, rot);
+    ELL_3M_MUL(rot, mat, tmp);
+    ELL_3M_COPY(mat, rot);
+    for (ci=0; ci<6; ci++) {
+      /* (symmetric to within round-off) */
+      sym[ii + NUM*ci] = mat[cidx[ci]];
+      symf[ii + NUM*ci] = AIR_CAST(float, mat[cidx[ci]]);
+    }
+  }
+
+  if (ell_3ms_eigensolve_batch_d(eval, evec, sym, NUM)
+      || ell_3ms_eigensolve_batch_f(evalf, evecf, symf, NUM)) {
+    fprintf(stderr, "%s: batch solvers failed\n", me);
+    airMopError(mop); return 1;
+  }
+  for (ii=0; ii<NUM; ii++) {
+    const double *wval, *wvec;
+    wval = want + 12*ii;
+    wvec = want + 12*ii + 3;
+    scl = AIR_MAX(AIR_ABS(wval[0]), AIR_ABS(wval[2]));
+    for (ci=0; ci<3; ci++) {
+      for (cj=0; cj<3; cj++) {
+        mat[cj + 3*ci] = sym[ii + NUM*(ci <= cj
+                                       ? (ci ? ci + cj + 1 : cj)
+                                       : (cj ? ci + cj + 1 : ci))];
+      }
+    }
+    /* eigenvalues are at least as accurate as from ell_3m_eigensolve_d */
+    ell_3m_eigensolve_d(ev, tmp, mat, AIR_TRUE);
+    ELL_SORT3(ev[0], ev[1], ev[2], err);
+    for (ei=0; ei<3; ei++) {
+      err = AIR_ABS(eval[ii + NUM*ei] - wval[ei]);
+      if (!( err <= AIR_MAX(2*AIR_ABS(ev[ei] - wval[ei]), 1e-13*scl) )) {
+        fprintf(stderr, "%s: [%u] eval[%u] %.17g != %.17g (err %g; "
+                "ell_3m_eigensolve_d got %.17g)\n", me, ii, ei,
+                eval[ii + NUM*ei], wval[ei], err, ev[ei]);
+        airMopError(mop); return 1;
+      }
+      if (!( AIR_ABS(evalf[ii + NUM*ei] - wval[ei]) <= 1e-6*scl )) {
+        fprintf(stderr, "%s: [%u] float eval[%u] %.17g != %.17g\n", me, ii,
+                ei, evalf[ii + NUM*ei], wval[ei]);
+        airMopError(mop); return 1;
+      }
+    }
+    for (ei=0; ei<3; ei++) {
+      ELL_3V_SET(vv[ei], evec[ii + NUM*(3*ei + 0)], evec[ii + NUM*(3*ei + 1)],
+                 evec[ii + NUM*(3*ei + 2)]);
+    }
+    /* right-handed orthonormal */
+    ELL_3M_SET(tmp, vv[0][0], vv[0][1], vv[0][2], vv[1][0], vv[1][1],
+               vv[1][2], vv[2][0], vv[2][1], vv[2][2]);
+    err = ELL_3M_DET(tmp) - 1;
+    for (ei=0; ei<3; ei++) {
+      for (ci=0; ci<3; ci++) {
+        dot = ELL_3V_DOT(vv[ei], vv[ci]) - (ei == ci);
+        err = AIR_MAX(err, AIR_ABS(dot));
+      }
+    }
+    if (!( AIR_ABS(err) < 1e-13 )) {
+      fprintf(stderr, "%s: [%u] evecs not right-handed orthonormal "
+              "(err %g)\n", me, ii, err);
+      airMopError(mop); return 1;
+    }
+    /* diagonalizing */
+    for (ei=0; ei<3; ei++) {
+      ELL_3MV_MUL(mv, mat, vv[ei]);
+      ELL_3V_SCALE_INCR(mv, -eval[ii + NUM*ei], vv[ei]);
+      if (!( ELL_3V_LEN(mv) <= 1e-13*scl )) {
+        fprintf(stderr, "%s: [%u] |M v%u - l%u v%u| = %g > %g\n", me, ii,
+                ei, ei, ei, ELL_3V_LEN(mv), 1e-13*scl);
+        airMopError(mop); return 1;
+      }
+    }
+    /* the same as the known eigenvectors, when eigenvalues are distinct */
+    if (ii % 8 >= 5) {
+      for (ei=0; ei<3; ei++) {
+        dot = ELL_3V_DOT(vv[ei], wvec + 3*ei);
+        if (!( 1 - AIR_ABS(dot) < 1e-9 )) {
+          fprintf(stderr, "%s: [%u] evec %u off by %g\n", me, ii, ei,
+                  1 - AIR_ABS(dot));
+          airMopError(mop); return 1;
+        }
+        dot = (evecf[ii + NUM*(3*ei + 0)]*vv[ei][0]
+               + evecf[ii + NUM*(3*ei + 1)]*vv[ei][1]
+               + evecf[ii + NUM*(3*ei + 2)]*vv[ei][2]);
+        if (!( 1 - AIR_ABS(dot) < 1e-4 )) {
+          fprintf(stderr, "%s: [%u] float evec %u off by %g\n", me, ii, ei,
+                  1 - AIR_ABS(dot));
+          airMopError(mop); return 1;
+        }
+      }
+    }
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
@@ -0,0 +1,167 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "teem/gage.h"
+
+/*
+** Tests:
+** gageDeconvolveSeparable, gageDeconvolveSeparableThreaded: for the
+** B-splines, probing the deconvolved volume at the samples has to give
+** back the original values (away from the boundary), and the results have
+** to be the same with any number of threads, and in-place
+*/
+
+#define KERN_NUM 3
+
+int
+main(int argc, const char **argv) {
+  static const char *kernStr[KERN_NUM] = {"bspln3", "bspln5", "bspln7"};
+  const char *me;
+  char *err;
+  airArray *mop;
+  Nrrd *nin, *nout, *ntst;
+  NrrdKernelSpec *ksp;
+  gageContext *gctx;
+  gagePerVolume *pvl;
+  const double *ans;
+  unsigned int size[3], ki, xi, yi, zi, margin;
+  size_t ii, NN;
+  const float *in, *out, *tst;
+  int E;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+
+  airSrandMT(4242);
+  nin = nrrdNew();
+  airMopAdd(mop, nin, (airMopper)nrrdNuke, airMopAlways);
+  nout = nrrdNew();
+  airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopAlways);
+  ntst = nrrdNew();
+  airMopAdd(mop, ntst, (airMopper)nrrdNuke, airMopAlways);
+  ksp = nrrdKernelSpecNew();
+  airMopAdd(mop, ksp, (airMopper)nrrdKernelSpecNix, airMopAlways);
+  ELL_3V_SET(size, 19, 13, 70);
+  if (nrrdMaybeAlloc_va(nin, nrrdTypeFloat, 3,
+                        AIR_CAST(size_t, size[0]), AIR_CAST(size_t, size[1]),
+                        AIR_CAST(size_t, size[2]))) {
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  nrrdAxisInfoSet_va(nin, nrrdAxisInfoSpacing, 1.0, 1.0, 1.0);
+  NN = nrrdElementNumber(nin);
+  for (ii=0; ii<NN; ii++) {
+    AIR_CAST(float *, nin->data)[ii] = AIR_CAST(float, airDrandMT());
+  }
+  in = AIR_CAST(const float *, nin->data);
+
+  for (ki=0; ki<KERN_NUM; ki++) {
+    if (nrrdKernelSpecParse(ksp, kernStr[ki])) {
+      airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble parsing kernel:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    if (!gageDeconvolveSeparableKnown(ksp)) {
+      fprintf(stderr, "%s: %s not known\n", me, kernStr[ki]);
+      airMopError(mop); return 1;
+    }
+    if (gageDeconvolveSeparable(nout, nin, gageKindScl, ksp,
+                                nrrdTypeDefault)
+        || gageDeconvolveSeparableThreaded(ntst, nin, gageKindScl, ksp,
+                                           nrrdTypeDefault, 3)) {
+      airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble deconvolving:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    out = AIR_CAST(const float *, nout->data);
+    tst = AIR_CAST(const float *, ntst->data);
+    for (ii=0; ii<NN; ii++) {
+      if (out[ii] != tst[ii]) {
+        fprintf(stderr, "%s: %s: 3 threads gave [%u] %.17g != %.17g\n", me,
+                kernStr[ki], AIR_UINT(ii), tst[ii], out[ii]);
+        airMopError(mop); return 1;
+      }
+    }
+    /* in-place, in a copy of the input */
+    if (nrrdCopy(ntst, nin)) {
+      airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble copying:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    if (gageDeconvolveSeparableThreaded(ntst, ntst, gageKindScl, ksp,
+                                        nrrdTypeDefault, 2)) {
+      airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble deconvolving in-place:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    tst = AIR_CAST(const float *, ntst->data);
+    for (ii=0; ii<NN; ii++) {
+      if (out[ii] != tst[ii]) {
+        fprintf(stderr, "%s: %s: in-place gave [%u] %.17g != %.17g\n", me,
+                kernStr[ki], AIR_UINT(ii), tst[ii], out[ii]);
+        airMopError(mop); return 1;
+      }
+    }
+
+    /* probing the deconvolution interpolates */
+    gctx = gageContextNew();
+    airMopAdd(mop, gctx, (airMopper)gageContextNix, airMopAlways);
+    gageParmSet(gctx, gageParmRenormalize, AIR_FALSE);
+    gageParmSet(gctx, gageParmCheckIntegrals, AIR_FALSE);
+    E = 0;
+    if (!E) E |= !(pvl = gagePerVolumeNew(gctx, nout, gageKindScl));
+    if (!E) E |= gagePerVolumeAttach(gctx, pvl);
+    if (!E) E |= gageKernelSet(gctx, gageKernel00, ksp->kernel, ksp->parm);
+    if (!E) E |= gageQueryItemOn(gctx, pvl, gageSclValue);
+    if (!E) E |= gageUpdate(gctx);
+    if (E) {
+      airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble setting up context:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    ans = gageAnswerPointer(gctx, pvl, gageSclValue);
+    margin = AIR_CAST(unsigned int, ceil(ksp->kernel->support(ksp->parm)));
+    for (zi=margin; zi<size[2]-margin; zi++) {
+      for (yi=margin; yi<size[1]-margin; yi++) {
+        for (xi=margin; xi<size[0]-margin; xi++) {
+          ii = xi + size[0]*(yi + size[1]*zi);
+          if (gageProbe(gctx, xi, yi, zi)) {
+            fprintf(stderr, "%s: %s: probe failed: %s\n", me, kernStr[ki],
+                    gctx->errStr);
+            airMopError(mop); return 1;
+          }
+          if (!( fabs(ans[0] - in[ii]) < 1e-5 )) {
+            fprintf(stderr, "%s: %s: at (%u,%u,%u) got %.17g, not %.17g\n",
+                    me, kernStr[ki], xi, yi, zi, ans[0], in[ii]);
+            airMopError(mop); return 1;
+          }
+        }
+      }
+    }
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
@@ -0,0 +1,131 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "teem/gage.h"
+
+/*
+** Tests:
+** gageOptimSigContextThreadNumSet, gageOptimSigErrorPlot: the errors
+** measured across scale have to be the same with any number of threads,
+** and have to vanish at the scales of the samples
+*/
+
+#define TRUE_NUM 31
+#define SAMP_NUM 3
+
+/* plots the error with threadNum threads into nout */
+static int
+plot(Nrrd *nout, gageOptimSigContext *oscx, unsigned int threadNum,
+     const double *sigma, const NrrdKernelSpec *kss) {
+
+  if (gageOptimSigContextThreadNumSet(oscx, threadNum)
+      || gageOptimSigErrorPlot(oscx, nout, sigma, SAMP_NUM, kss,
+                               nrrdMeasureL2)) {
+    return 1;
+  }
+  return 0;
+}
+
+int
+main(int argc, const char **argv) {
+  const char *me;
+  char *err;
+  airArray *mop;
+  gageOptimSigContext *oscx;
+  NrrdKernelSpec *kss;
+  Nrrd *nout[2];
+  double sigma[SAMP_NUM], rho;
+  const double *out[2];
+  unsigned int ii, si, oi;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+
+  kss = nrrdKernelSpecNew();
+  airMopAdd(mop, kss, (airMopper)nrrdKernelSpecNix, airMopAlways);
+  for (oi=0; oi<2; oi++) {
+    nout[oi] = nrrdNew();
+    airMopAdd(mop, nout[oi], (airMopper)nrrdNuke, airMopAlways);
+  }
+  if (nrrdKernelSpecParse(kss, "hermite")) {
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble parsing kernel:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  oscx = gageOptimSigContextNew(2, SAMP_NUM, TRUE_NUM, 0, 4, 3);
+  if (!oscx) {
+    airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble creating context:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  airMopAdd(mop, oscx, (airMopper)gageOptimSigContextNix, airMopAlways);
+  /* samples at the first, middle, and last of the true scales */
+  for (si=0; si<SAMP_NUM; si++) {
+    rho = AIR_AFFINE(0, si, SAMP_NUM-1,
+                     oscx->rhoRange[0], oscx->rhoRange[1]);
+    sigma[si] = exp(rho) - 1;
+  }
+  sigma[0] = 0;
+  sigma[SAMP_NUM-1] = 4;
+  if (plot(nout[0], oscx, 1, sigma, kss)
+      || plot(nout[1], oscx, 3, sigma, kss)) {
+    airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble plotting:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  for (oi=0; oi<2; oi++) {
+    out[oi] = AIR_CAST(const double *, nout[oi]->data);
+  }
+  for (ii=0; ii<TRUE_NUM; ii++) {
+    if (out[0][0 + 2*ii] != out[1][0 + 2*ii]
+        || out[0][1 + 2*ii] != out[1][1 + 2*ii]) {
+      fprintf(stderr, "%s: [%u] 3 threads gave (%.17g,%.17g) != "
+              "(%.17g,%.17g)\n", me, ii, out[1][0 + 2*ii], out[1][1 + 2*ii],
+              out[0][0 + 2*ii], out[0][1 + 2*ii]);
+      airMopError(mop); return 1;
+    }
+    if (!AIR_EXISTS(out[0][1 + 2*ii])) {
+      fprintf(stderr, "%s: [%u] error %g doesn't exist\n", me, ii,
+              out[0][1 + 2*ii]);
+      airMopError(mop); return 1;
+    }
+  }
+  for (si=0; si<SAMP_NUM; si++) {
+    ii = si*(TRUE_NUM-1)/(SAMP_NUM-1);
+    if (!( out[0][1 + 2*ii] < 1e-8 )) {
+      fprintf(stderr, "%s: error %g at sample %u (rho %g) not ~0\n", me,
+              out[0][1 + 2*ii], si, out[0][0 + 2*ii]);
+      airMopError(mop); return 1;
+    }
+  }
+  if (!( out[0][1 + 2*((TRUE_NUM-1)/4)] > 1e-6 )) {
+    fprintf(stderr, "%s: error %g between samples suspiciously small\n", me,
+            out[0][1 + 2*((TRUE_NUM-1)/4)]);
+    airMopError(mop); return 1;
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
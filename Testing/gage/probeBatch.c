@@ -0,0 +1,301 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "teem/gage.h"
+#include "teem/ell.h"
+
+/*
+** Tests:
+** gageProbeBatch and gageProbeScanline, against gageProbeSpace (or
+** gageProbe) at the same positions with
+** a context whose cached position is reset before every probe (so
+** that all filter weights and value caches are computed from scratch)
+*/
+
+#define SX 19
+#define SY 17
+#define SZ 13
+#define ROWS 40
+#define PER_ROW 50
+#define POS_NUM (ROWS*PER_ROW)
+
+static int
+setup(gageContext **gctxP, gagePerVolume **pvlP, airArray *mop,
+      const Nrrd *nin) {
+  gageContext *gctx;
+  gagePerVolume *pvl;
+  double kparm[NRRD_KERNEL_PARMS_NUM] = {1.0};
+  int E;
+
+  gctx = gageContextNew();
+  airMopAdd(mop, gctx, (airMopper)gageContextNix, airMopAlways);
+  gageParmSet(gctx, gageParmRenormalize, AIR_TRUE);
+  gageParmSet(gctx, gageParmCheckIntegrals, AIR_TRUE);
+  E = 0;
+  if (!E) E |= !(pvl = gagePerVolumeNew(gctx, nin, gageKindScl));
+  if (!E) E |= gageKernelSet(gctx, gageKernel00, nrrdKernelBSpline3, kparm);
+  if (!E) E |= gageKernelSet(gctx, gageKernel11, nrrdKernelBSpline3D, kparm);
+  if (!E) E |= gageKernelSet(gctx, gageKernel22, nrrdKernelBSpline3DD, kparm);
+  if (!E) E |= gagePerVolumeAttach(gctx, pvl);
+  if (!E) E |= gageQueryItemOn(gctx, pvl, gageSclValue);
+  if (!E) E |= gageQueryItemOn(gctx, pvl, gageSclGradVec);
+  if (!E) E |= gageQueryItemOn(gctx, pvl, gageSclHessian);
+  if (!E) E |= gageUpdate(gctx);
+  if (E) {
+    return 1;
+  }
+  *gctxP = gctx;
+  *pvlP = pvl;
+  return 0;
+}
+
+int
+main(int argc, const char **argv) {
+  const char *me;
+  char *err;
+  airArray *mop;
+  Nrrd *nin;
+  double *data, *xx, *yy, *zz, *ans[3];
+  const double *refAns[3];
+  gageContext *bctx, *rctx;
+  gagePerVolume *bpvl, *rpvl;
+  const gagePerVolume *apvl[3];
+  int item[3], *errNum;
+  unsigned int ii, ai, cc, len[3];
+  size_t pi, failNum, refFail;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+
+  nin = nrrdNew();
+  airMopAdd(mop, nin, (airMopper)nrrdNuke, airMopAlways);
+  if (nrrdMaybeAlloc_va(nin, nrrdTypeDouble, 3, AIR_CAST(size_t, SX),
+                        AIR_CAST(size_t, SY), AIR_CAST(size_t, SZ))) {
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  /* anisotropic spacing, so world-space probing is non-trivial */
+  nrrdAxisInfoSet_va(nin, nrrdAxisInfoSpacing, 1.0, 1.3, 0.7);
+  airSrandMT(4242);
+  data = AIR_CAST(double *, nin->data);
+  for (ii=0; ii<SX*SY*SZ; ii++) {
+    data[ii] = airDrandMT();
+  }
+  if (setup(&bctx, &bpvl, mop, nin)
+      || setup(&rctx, &rpvl, mop, nin)) {
+    airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble with set-up:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+
+  xx = AIR_CALLOC(POS_NUM, double);
+  airMopAdd(mop, xx, airFree, airMopAlways);
+  yy = AIR_CALLOC(POS_NUM, double);
+  airMopAdd(mop, yy, airFree, airMopAlways);
+  zz = AIR_CALLOC(POS_NUM, double);
+  airMopAdd(mop, zz, airFree, airMopAlways);
+  errNum = AIR_CALLOC(POS_NUM, int);
+  airMopAdd(mop, errNum, airFree, airMopAlways);
+  item[0] = gageSclValue;
+  item[1] = gageSclGradVec;
+  item[2] = gageSclHessian;
+  for (ai=0; ai<3; ai++) {
+    apvl[ai] = bpvl;
+    len[ai] = gageAnswerLength(bctx, bpvl, item[ai]);
+    ans[ai] = AIR_CALLOC(len[ai]*POS_NUM, double);
+    airMopAdd(mop, ans[ai], airFree, airMopAlways);
+    refAns[ai] = gageAnswerPointer(rctx, rpvl, item[ai]);
+  }
+
+  /* rows of positions, mostly along the fastest axis (some rows with
+     steps that keep the fractional position or change it only along
+     some axes), and some going outside the volume */
+  for (ii=0; ii<ROWS; ii++) {
+    double px, py, pz, dx, dy, dz;
+    px = -2 + 3*airDrandMT();
+    py = SY*airDrandMT();
+    pz = SZ*airDrandMT();
+    switch (ii % 4) {
+    case 0: dx = 0.37; dy = 0; dz = 0; break;
+    case 1: dx = 1; dy = 0; dz = 0; break;
+    case 2: dx = 0.31; dy = 0.11; dz = 0; break;
+    default: dx = 0.29; dy = 0.05; dz = -0.07; break;
+    }
+    for (cc=0; cc<PER_ROW; cc++) {
+      pi = cc + PER_ROW*ii;
+      xx[pi] = px + dx*cc;
+      yy[pi] = py + dy*cc;
+      zz[pi] = pz + dz*cc;
+    }
+  }
+
+  for (ii=0; ii<2; ii++) {
+    int indexSpace;
+    indexSpace = !ii;
+    if (!indexSpace) {
+      /* convert same positions to world-space */
+      for (pi=0; pi<POS_NUM; pi++) {
+        double ipos[4], wpos[4];
+        ELL_4V_SET(ipos, xx[pi], yy[pi], zz[pi], 1);
+        ELL_4MV_MUL(wpos, bctx->shape->ItoW, ipos);
+        ELL_4V_HOMOG(wpos, wpos);
+        xx[pi] = wpos[0];
+        yy[pi] = wpos[1];
+        zz[pi] = wpos[2];
+      }
+    }
+    if (gageProbeBatch(bctx, ans, errNum, &failNum, apvl, item, 3,
+                       xx, yy, zz, NULL, POS_NUM, indexSpace,
+                       AIR_FALSE)) {
+      airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble probing:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    refFail = 0;
+    for (pi=0; pi<POS_NUM; pi++) {
+      int pret;
+      gagePointReset(&(rctx->point));
+      pret = gageProbeSpace(rctx, xx[pi], yy[pi], zz[pi],
+                            indexSpace, AIR_FALSE);
+      if (pret) {
+        refFail++;
+        if (errNum[pi] != rctx->errNum) {
+          fprintf(stderr, "%s: (%s) pos %u: errNum %d != ref %d\n", me,
+                  indexSpace ? "index" : "world", AIR_CAST(unsigned int, pi),
+                  errNum[pi], rctx->errNum);
+          airMopError(mop); return 1;
+        }
+        for (ai=0; ai<3; ai++) {
+          for (cc=0; cc<len[ai]; cc++) {
+            if (AIR_EXISTS(ans[ai][pi + POS_NUM*cc])) {
+              fprintf(stderr, "%s: (%s) pos %u: answer %u[%u] = %g "
+                      "exists despite error\n", me,
+                      indexSpace ? "index" : "world",
+                      AIR_CAST(unsigned int, pi), ai, cc,
+                      ans[ai][pi + POS_NUM*cc]);
+              airMopError(mop); return 1;
+            }
+          }
+        }
+        continue;
+      }
+      if (gageErrNone != errNum[pi]) {
+        fprintf(stderr, "%s: (%s) pos %u: unexpected errNum %d\n", me,
+                indexSpace ? "index" : "world", AIR_CAST(unsigned int, pi),
+                errNum[pi]);
+        airMopError(mop); return 1;
+      }
+      for (ai=0; ai<3; ai++) {
+        for (cc=0; cc<len[ai]; cc++) {
+          double bv, rv;
+          bv = ans[ai][pi + POS_NUM*cc];
+          rv = refAns[ai][cc];
+          if (AIR_ABS(bv - rv) > 1e-12*(1 + AIR_ABS(rv))) {
+            fprintf(stderr, "%s: (%s) pos %u (%g,%g,%g): answer %u[%u] "
+                    "%.17g != ref %.17g\n", me,
+                    indexSpace ? "index" : "world",
+                    AIR_CAST(unsigned int, pi), xx[pi], yy[pi], zz[pi],
+                    ai, cc, bv, rv);
+            airMopError(mop); return 1;
+          }
+        }
+      }
+    }
+    if (failNum != refFail || !failNum || failNum == POS_NUM) {
+      fprintf(stderr, "%s: (%s) failNum %u (expected %u; should be "
+              "some but not all)\n", me, indexSpace ? "index" : "world",
+              AIR_CAST(unsigned int, failNum),
+              AIR_CAST(unsigned int, refFail));
+      airMopError(mop); return 1;
+    }
+  }
+
+  /* scanlines along each axis, stepping up and down by one sample
+     (so that value caches are shifted rather than re-filled), and
+     by a non-integral step, starting outside or next to the volume
+     boundary so that both edge and interior neighborhoods are seen */
+  for (ii=0; ii<3*3*4; ii++) {
+    unsigned int axis, snum, size[3];
+    double step, pos[3];
+    axis = ii % 3;
+    ELL_3V_SET(size, SX, SY, SZ);
+    switch ((ii/3) % 3) {
+    case 0: step = 1; break;
+    case 1: step = -1; break;
+    default: step = 0.43; break;
+    }
+    ELL_3V_SET(pos, (SX-1)*airDrandMT(), (SY-1)*airDrandMT(),
+               (SZ-1)*airDrandMT());
+    pos[axis] = step > 0 ? -1.5 + airDrandMT() : size[axis] - airDrandMT();
+    snum = AIR_CAST(unsigned int, (size[axis] + 1)/AIR_ABS(step));
+    if (gageProbeScanline(bctx, ans, errNum, &failNum, apvl, item, 3,
+                          pos[0], pos[1], pos[2], axis, step, snum,
+                          AIR_FALSE)) {
+      airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble probing scanline:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    refFail = 0;
+    for (pi=0; pi<snum; pi++) {
+      double rpos[3];
+      ELL_3V_COPY(rpos, pos);
+      rpos[axis] += step*pi;
+      gagePointReset(&(rctx->point));
+      if (gageProbe(rctx, rpos[0], rpos[1], rpos[2])) {
+        refFail++;
+        if (errNum[pi] != rctx->errNum) {
+          fprintf(stderr, "%s: scanline %u pos %u: errNum %d != ref %d\n",
+                  me, ii, AIR_CAST(unsigned int, pi), errNum[pi],
+                  rctx->errNum);
+          airMopError(mop); return 1;
+        }
+        continue;
+      }
+      for (ai=0; ai<3; ai++) {
+        for (cc=0; cc<len[ai]; cc++) {
+          double bv, rv;
+          bv = ans[ai][pi + snum*cc];
+          rv = refAns[ai][cc];
+          if (AIR_ABS(bv - rv) > 1e-12*(1 + AIR_ABS(rv))) {
+            fprintf(stderr, "%s: scanline %u (axis %u, step %g) pos %u "
+                    "(%g,%g,%g): answer %u[%u] %.17g != ref %.17g\n", me,
+                    ii, axis, step, AIR_CAST(unsigned int, pi),
+                    rpos[0], rpos[1], rpos[2], ai, cc, bv, rv);
+            airMopError(mop); return 1;
+          }
+        }
+      }
+    }
+    if (failNum != refFail) {
+      fprintf(stderr, "%s: scanline %u failNum %u != ref %u\n", me, ii,
+              AIR_CAST(unsigned int, failNum),
+              AIR_CAST(unsigned int, refFail));
+      airMopError(mop); return 1;
+    }
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
@@ -0,0 +1,263 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "teem/gage.h"
+
+/*
+** Tests:
+** gageBrickMake, gagePerVolumeBrickSet: probing a bricked volume
+** has to give exactly the same answers (and edgeFrac) as probing the
+** original volume, for various brick sizes, kernel sizes, and volume
+** kinds, at random positions (including near and outside the boundary)
+** and along scanlines (for which value caches are shifted)
+*/
+
+#define POS_NUM 3000
+#define LINE_NUM 30
+
+/* sets up context for volume nin of given kind, with three queried
+   items, and kernel spec kss, and (if nbrick), bricked volume */
+static int
+setup(gageContext **gctxP, gagePerVolume **pvlP, const double **ansP,
+      unsigned int *lenP, airArray *mop, const Nrrd *nin,
+      const gageKind *kind, const int *item, const char *kss,
+      const Nrrd *nbrick) {
+  static const char me[]="setup";
+  gageContext *gctx;
+  gagePerVolume *pvl;
+  NrrdKernelSpec *ksp;
+  unsigned int ai;
+  int E;
+
+  ksp = nrrdKernelSpecNew();
+  airMopAdd(mop, ksp, (airMopper)nrrdKernelSpecNix, airMopAlways);
+  if (nrrdKernelSpecParse(ksp, kss)) {
+    biffMovef(GAGE, NRRD, "%s: trouble parsing kernel \"%s\"", me, kss);
+    return 1;
+  }
+  gctx = gageContextNew();
+  airMopAdd(mop, gctx, (airMopper)gageContextNix, airMopAlways);
+  gageParmSet(gctx, gageParmRenormalize, AIR_FALSE);
+  gageParmSet(gctx, gageParmCheckIntegrals, AIR_FALSE);
+  E = 0;
+  if (!E) E |= !(pvl = gagePerVolumeNew(gctx, nin, kind));
+  if (!E) E |= gageKernelSet(gctx, gageKernel00, ksp->kernel, ksp->parm);
+  if (!E) E |= gageKernelSet(gctx, gageKernel11, ksp->kernel, ksp->parm);
+  if (!E) E |= gagePerVolumeAttach(gctx, pvl);
+  for (ai=0; ai<2; ai++) {
+    if (!E) E |= gageQueryItemOn(gctx, pvl, item[ai]);
+  }
+  if (!E) E |= gageUpdate(gctx);
+  if (!E && nbrick) E |= gagePerVolumeBrickSet(pvl, nbrick);
+  if (E) {
+    biffAddf(GAGE, "%s: trouble", me);
+    return 1;
+  }
+  for (ai=0; ai<2; ai++) {
+    ansP[ai] = gageAnswerPointer(gctx, pvl, item[ai]);
+    lenP[ai] = gageAnswerLength(gctx, pvl, item[ai]);
+  }
+  *gctxP = gctx;
+  *pvlP = pvl;
+  return 0;
+}
+
+/* compares answers and edgeFrac from two contexts after probing at the
+   same location, returns non-zero if there's a difference */
+static int
+compare(const char *me, const char *what, const double pos[3],
+        const gageContext *actx, const double **aans,
+        const gageContext *bctx, const double **bans,
+        int aret, int bret, const unsigned int *len) {
+  unsigned int ai, cc;
+
+  if (aret != bret) {
+    fprintf(stderr, "%s: %s (%g,%g,%g): probe return %d != %d\n", me,
+            what, pos[0], pos[1], pos[2], aret, bret);
+    return 1;
+  }
+  if (aret) {
+    return 0;
+  }
+  if (actx->edgeFrac != bctx->edgeFrac) {
+    fprintf(stderr, "%s: %s (%g,%g,%g): edgeFrac %g != %g\n", me,
+            what, pos[0], pos[1], pos[2], actx->edgeFrac, bctx->edgeFrac);
+    return 1;
+  }
+  for (ai=0; ai<2; ai++) {
+    for (cc=0; cc<len[ai]; cc++) {
+      if (aans[ai][cc] != bans[ai][cc]) {
+        fprintf(stderr, "%s: %s (%g,%g,%g): answer %u[%u] %.17g != %.17g\n",
+                me, what, pos[0], pos[1], pos[2], ai, cc,
+                aans[ai][cc], bans[ai][cc]);
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+int
+main(int argc, const char **argv) {
+  const char *me, *kss[2] = {"bspln3", "gauss:1.7,3"};
+  char *err, what[AIR_STRLEN_MED];
+  airArray *mop;
+  Nrrd *nin[2], *nbrick, *nbad;
+  const gageKind *kind[2];
+  int item[2][2];
+  unsigned int vi, ki, shift, ii, size[3], len[2];
+  size_t NN, ei;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+
+  airSrandMT(4242);
+  /* scalar uchar volume, and vector float volume, with sizes that are
+     not multiples of any brick size */
+  nin[0] = nrrdNew();
+  airMopAdd(mop, nin[0], (airMopper)nrrdNuke, airMopAlways);
+  nin[1] = nrrdNew();
+  airMopAdd(mop, nin[1], (airMopper)nrrdNuke, airMopAlways);
+  nbrick = nrrdNew();
+  airMopAdd(mop, nbrick, (airMopper)nrrdNuke, airMopAlways);
+  nbad = nrrdNew();
+  airMopAdd(mop, nbad, (airMopper)nrrdNuke, airMopAlways);
+  ELL_3V_SET(size, 13, 10, 7);
+  if (nrrdMaybeAlloc_va(nin[0], nrrdTypeUChar, 3,
+                        AIR_CAST(size_t, size[0]), AIR_CAST(size_t, size[1]),
+                        AIR_CAST(size_t, size[2]))
+      || nrrdMaybeAlloc_va(nin[1], nrrdTypeFloat, 4, AIR_CAST(size_t, 3),
+                           AIR_CAST(size_t, size[0]),
+                           AIR_CAST(size_t, size[1]),
+                           AIR_CAST(size_t, size[2]))) {
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  nrrdAxisInfoSet_va(nin[0], nrrdAxisInfoSpacing, 1.0, 1.0, 1.0);
+  nrrdAxisInfoSet_va(nin[1], nrrdAxisInfoSpacing, AIR_NAN, 1.0, 1.0, 1.0);
+  NN = nrrdElementNumber(nin[0]);
+  for (ei=0; ei<NN; ei++) {
+    AIR_CAST(unsigned char *, nin[0]->data)[ei] =
+      AIR_CAST(unsigned char, airRandInt(256));
+  }
+  NN = nrrdElementNumber(nin[1]);
+  for (ei=0; ei<NN; ei++) {
+    AIR_CAST(float *, nin[1]->data)[ei] = AIR_CAST(float, airDrandMT());
+  }
+  kind[0] = gageKindScl;
+  item[0][0] = gageSclValue;
+  item[0][1] = gageSclGradVec;
+  kind[1] = gageKindVec;
+  item[1][0] = gageVecVector;
+  item[1][1] = gageVecJacobian;
+
+  /* mismatched bricks are refused */
+  if (gageBrickMake(nbad, nin[0], kind[0], 2)) {
+    airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble making bricks:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  {
+    gageContext *gctx;
+    gagePerVolume *pvl;
+    const double *ans[2];
+    if (setup(&gctx, &pvl, ans, len, mop, nin[1], kind[1], item[1],
+              kss[0], NULL)) {
+      airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble setting up:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    if (!gagePerVolumeBrickSet(pvl, nbad)) {
+      fprintf(stderr, "%s: didn't get expected error with wrong bricks\n",
+              me);
+      airMopError(mop); return 1;
+    }
+    biffDone(GAGE);
+  }
+
+  for (vi=0; vi<2; vi++) {
+    for (shift=1; shift<=3; shift++) {
+      if (gageBrickMake(nbrick, nin[vi], kind[vi], shift)) {
+        airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+        fprintf(stderr, "%s: trouble making bricks:\n%s", me, err);
+        airMopError(mop); return 1;
+      }
+      for (ki=0; ki<2; ki++) {
+        gageContext *actx, *bctx;
+        gagePerVolume *apvl, *bpvl;
+        const double *aans[2], *bans[2];
+        double pos[3];
+        int aret, bret;
+
+        if (setup(&actx, &apvl, aans, len, mop, nin[vi], kind[vi], item[vi],
+                  kss[ki], NULL)
+            || setup(&bctx, &bpvl, bans, len, mop, nin[vi], kind[vi],
+                     item[vi], kss[ki], nbrick)) {
+          airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+          fprintf(stderr, "%s: trouble setting up:\n%s", me, err);
+          airMopError(mop); return 1;
+        }
+        sprintf(what, "%s brick %u %s", kind[vi]->name, 1u << shift,
+                kss[ki]);
+        /* random positions, some outside (for clamping) */
+        for (ii=0; ii<POS_NUM; ii++) {
+          ELL_3V_SET(pos,
+                     AIR_AFFINE(0, airDrandMT(), 1, -1.0, size[0]),
+                     AIR_AFFINE(0, airDrandMT(), 1, -1.0, size[1]),
+                     AIR_AFFINE(0, airDrandMT(), 1, -1.0, size[2]));
+          aret = gageProbeSpace(actx, pos[0], pos[1], pos[2],
+                                AIR_TRUE, AIR_TRUE);
+          bret = gageProbeSpace(bctx, pos[0], pos[1], pos[2],
+                                AIR_TRUE, AIR_TRUE);
+          if (compare(me, what, pos, actx, aans, bctx, bans,
+                      aret, bret, len)) {
+            airMopError(mop); return 1;
+          }
+        }
+        /* unit steps along scanlines, up and down each axis */
+        for (ii=0; ii<LINE_NUM; ii++) {
+          unsigned int axis, si;
+          double step;
+          axis = ii % 3;
+          step = (ii/3) % 2 ? 1 : -1;
+          ELL_3V_SET(pos, (size[0]-1)*airDrandMT(), (size[1]-1)*airDrandMT(),
+                     (size[2]-1)*airDrandMT());
+          for (si=0; si<size[axis]; si++) {
+            pos[axis] = step > 0 ? si + 0.3 : size[axis] - 1.3 - si;
+            aret = gageProbe(actx, pos[0], pos[1], pos[2]);
+            bret = gageProbe(bctx, pos[0], pos[1], pos[2]);
+            if (compare(me, what, pos, actx, aans, bctx, bans,
+                        aret, bret, len)) {
+              airMopError(mop); return 1;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
@@ -0,0 +1,300 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "teem/gage.h"
+
+/*
+** Tests:
+** gagePerVolumeDerivPrecomputeSet: at sample locations, the value,
+** gradient and Hessian from the pre-computed derivatives have to match
+** those from regular filtering, and in between samples they have to
+** be the trilinear interpolation of those at the surrounding samples.
+** Also, the derivatives have to be re-computed when the kernels change,
+** and regular filtering has to come back when pre-computing is turned
+** off
+*/
+
+#define POS_NUM 500
+#define TOL 1e-10
+
+static const int
+_item[3] = {gageSclValue, gageSclGradVec, gageSclHessian};
+
+static const unsigned int
+_len[3] = {1, 3, 9};
+
+static int
+setup(gageContext **gctxP, gagePerVolume **pvlP, airArray *mop,
+      const Nrrd *nin, const char *kss[3], int precompute) {
+  static const char me[]="setup";
+  gageContext *gctx;
+  gagePerVolume *pvl;
+  NrrdKernelSpec *ksp[3];
+  unsigned int ii;
+  int E;
+
+  for (ii=0; ii<3; ii++) {
+    ksp[ii] = nrrdKernelSpecNew();
+    airMopAdd(mop, ksp[ii], (airMopper)nrrdKernelSpecNix, airMopAlways);
+    if (nrrdKernelSpecParse(ksp[ii], kss[ii])) {
+      biffMovef(GAGE, NRRD, "%s: trouble parsing kernel \"%s\"", me,
+                kss[ii]);
+      return 1;
+    }
+  }
+  gctx = gageContextNew();
+  airMopAdd(mop, gctx, (airMopper)gageContextNix, airMopAlways);
+  gageParmSet(gctx, gageParmRenormalize, AIR_FALSE);
+  gageParmSet(gctx, gageParmCheckIntegrals, AIR_FALSE);
+  E = 0;
+  if (!E) E |= !(pvl = gagePerVolumeNew(gctx, nin, gageKindScl));
+  if (!E) E |= gageKernelSet(gctx, gageKernel00,
+                             ksp[0]->kernel, ksp[0]->parm);
+  if (!E) E |= gageKernelSet(gctx, gageKernel11,
+                             ksp[1]->kernel, ksp[1]->parm);
+  if (!E) E |= gageKernelSet(gctx, gageKernel22,
+                             ksp[2]->kernel, ksp[2]->parm);
+  if (!E) E |= gagePerVolumeAttach(gctx, pvl);
+  for (ii=0; ii<3; ii++) {
+    if (!E) E |= gageQueryItemOn(gctx, pvl, _item[ii]);
+  }
+  if (!E) E |= gagePerVolumeDerivPrecomputeSet(pvl, precompute);
+  if (!E) E |= gageUpdate(gctx);
+  if (E) {
+    biffAddf(GAGE, "%s: trouble", me);
+    return 1;
+  }
+  *gctxP = gctx;
+  *pvlP = pvl;
+  return 0;
+}
+
+/* probes at pos in both contexts; if interp, the answers in the
+   reference context rctx are interpolated from the surrounding samples.
+   Returns non-zero if the answers differ */
+static int
+check(const char *me, const char *what, const double pos[3], int interp,
+      gageContext *dctx, gagePerVolume *dpvl,
+      gageContext *rctx, gagePerVolume *rpvl) {
+  double ref[13], wght, dif;
+  const double *ans;
+  unsigned int ci, ii, ti, vi;
+  int base[3];
+
+  if (gageProbe(dctx, pos[0], pos[1], pos[2])) {
+    fprintf(stderr, "%s: %s: probe (%g,%g,%g) failed: %s\n", me, what,
+            pos[0], pos[1], pos[2], dctx->errStr);
+    return 1;
+  }
+  for (ci=0; ci<13; ci++) {
+    ref[ci] = 0;
+  }
+  ELL_3V_SET(base, AIR_CAST(int, pos[0]), AIR_CAST(int, pos[1]),
+             AIR_CAST(int, pos[2]));
+  for (ti=0; ti<(interp ? 8u : 1u); ti++) {
+    double spos[3], frac;
+    wght = 1;
+    for (vi=0; vi<3; vi++) {
+      spos[vi] = interp ? base[vi] + ((ti >> vi) & 1) : pos[vi];
+      frac = pos[vi] - base[vi];
+      wght *= interp ? (((ti >> vi) & 1) ? frac : 1 - frac) : 1;
+    }
+    if (gageProbe(rctx, spos[0], spos[1], spos[2])) {
+      fprintf(stderr, "%s: %s: reference probe (%g,%g,%g) failed: %s\n",
+              me, what, spos[0], spos[1], spos[2], rctx->errStr);
+      return 1;
+    }
+    ci = 0;
+    for (ii=0; ii<3; ii++) {
+      ans = gageAnswerPointer(rctx, rpvl, _item[ii]);
+      for (vi=0; vi<_len[ii]; vi++) {
+        ref[ci++] += wght*ans[vi];
+      }
+    }
+  }
+  ci = 0;
+  for (ii=0; ii<3; ii++) {
+    ans = gageAnswerPointer(dctx, dpvl, _item[ii]);
+    for (vi=0; vi<_len[ii]; vi++) {
+      dif = ans[vi] - ref[ci];
+      if (!( AIR_ABS(dif) <= TOL*(1 + AIR_ABS(ref[ci])) )) {
+        fprintf(stderr, "%s: %s: (%g,%g,%g) %s[%u] %.17g != %.17g\n",
+                me, what, pos[0], pos[1], pos[2],
+                airEnumStr(gageScl, _item[ii]), vi, ans[vi], ref[ci]);
+        return 1;
+      }
+      ci++;
+    }
+  }
+  return 0;
+}
+
+int
+main(int argc, const char **argv) {
+  const char *me,
+    *kssA[3] = {"bspln3", "bspln3d", "bspln3dd"},
+    *kssB[3] = {"c4hexic", "c4hexicd", "c4hexicdd"};
+  char *err;
+  airArray *mop;
+  Nrrd *nin;
+  gageContext *dctx, *rctx;
+  gagePerVolume *dpvl, *rpvl;
+  NrrdKernelSpec *ksp;
+  unsigned int ii, xi, yi, zi, size[3];
+  double pos[3];
+  size_t NN, ei;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+
+  airSrandMT(4343);
+  nin = nrrdNew();
+  airMopAdd(mop, nin, (airMopper)nrrdNuke, airMopAlways);
+  ELL_3V_SET(size, 12, 9, 7);
+  if (nrrdMaybeAlloc_va(nin, nrrdTypeFloat, 3,
+                        AIR_CAST(size_t, size[0]), AIR_CAST(size_t, size[1]),
+                        AIR_CAST(size_t, size[2]))) {
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  /* anisotropic spacing, so that the world-space transforms matter */
+  nrrdAxisInfoSet_va(nin, nrrdAxisInfoSpacing, 0.8, 1.0, 1.7);
+  NN = nrrdElementNumber(nin);
+  for (ei=0; ei<NN; ei++) {
+    AIR_CAST(float *, nin->data)[ei] = AIR_CAST(float, airDrandMT());
+  }
+
+  /* pre-computing isn't for other kinds */
+  {
+    gagePerVolume *pvl;
+    gageContext *gctx;
+    Nrrd *nvec;
+    nvec = nrrdNew();
+    airMopAdd(mop, nvec, (airMopper)nrrdNuke, airMopAlways);
+    gctx = gageContextNew();
+    airMopAdd(mop, gctx, (airMopper)gageContextNix, airMopAlways);
+    if (nrrdMaybeAlloc_va(nvec, nrrdTypeFloat, 4, AIR_CAST(size_t, 3),
+                          AIR_CAST(size_t, 4), AIR_CAST(size_t, 4),
+                          AIR_CAST(size_t, 4))) {
+      airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    nrrdAxisInfoSet_va(nvec, nrrdAxisInfoSpacing, AIR_NAN, 1.0, 1.0, 1.0);
+    if (!(pvl = gagePerVolumeNew(gctx, nvec, gageKindVec))) {
+      airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble setting up vector volume:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    airMopAdd(mop, pvl, (airMopper)gagePerVolumeNix, airMopAlways);
+    if (!gagePerVolumeDerivPrecomputeSet(pvl, AIR_TRUE)) {
+      fprintf(stderr, "%s: didn't get expected error with vector kind\n",
+              me);
+      airMopError(mop); return 1;
+    }
+    biffDone(GAGE);
+  }
+
+  if (setup(&dctx, &dpvl, mop, nin, kssA, AIR_TRUE)
+      || setup(&rctx, &rpvl, mop, nin, kssA, AIR_FALSE)) {
+    airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble setting up:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  if (!dpvl->nderiv || rpvl->nderiv) {
+    fprintf(stderr, "%s: derivatives (not) pre-computed as expected\n", me);
+    airMopError(mop); return 1;
+  }
+  /* at every sample, including along the boundary */
+  for (zi=0; zi<size[2]; zi++) {
+    for (yi=0; yi<size[1]; yi++) {
+      for (xi=0; xi<size[0]; xi++) {
+        ELL_3V_SET(pos, xi, yi, zi);
+        if (check(me, "bspln3 sample", pos, AIR_FALSE,
+                  dctx, dpvl, rctx, rpvl)) {
+          airMopError(mop); return 1;
+        }
+      }
+    }
+  }
+  /* in between samples */
+  for (ii=0; ii<POS_NUM; ii++) {
+    ELL_3V_SET(pos, (size[0]-1)*airDrandMT(), (size[1]-1)*airDrandMT(),
+               (size[2]-1)*airDrandMT());
+    if (check(me, "bspln3 interp", pos, AIR_TRUE, dctx, dpvl, rctx, rpvl)) {
+      airMopError(mop); return 1;
+    }
+  }
+
+  /* new kernels in both contexts: derivatives have to be re-computed */
+  for (ii=0; ii<3; ii++) {
+    ksp = nrrdKernelSpecNew();
+    airMopAdd(mop, ksp, (airMopper)nrrdKernelSpecNix, airMopAlways);
+    if (nrrdKernelSpecParse(ksp, kssB[ii])
+        || gageKernelSet(dctx, ii ? (1 == ii ? gageKernel11 : gageKernel22)
+                         : gageKernel00, ksp->kernel, ksp->parm)
+        || gageKernelSet(rctx, ii ? (1 == ii ? gageKernel11 : gageKernel22)
+                         : gageKernel00, ksp->kernel, ksp->parm)) {
+      airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble setting kernels:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+  }
+  if (gageUpdate(dctx) || gageUpdate(rctx)) {
+    airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble updating:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  for (ii=0; ii<POS_NUM; ii++) {
+    ELL_3V_SET(pos, airRandInt(size[0]), airRandInt(size[1]),
+               airRandInt(size[2]));
+    if (check(me, "c4hexic sample", pos, AIR_FALSE,
+              dctx, dpvl, rctx, rpvl)) {
+      airMopError(mop); return 1;
+    }
+  }
+
+  /* turning pre-computation off gives back regular filtering */
+  if (gagePerVolumeDerivPrecomputeSet(dpvl, AIR_FALSE)
+      || gageUpdate(dctx)) {
+    airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble turning off:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  if (dpvl->nderiv) {
+    fprintf(stderr, "%s: derivatives not freed\n", me);
+    airMopError(mop); return 1;
+  }
+  for (ii=0; ii<POS_NUM; ii++) {
+    ELL_3V_SET(pos, (size[0]-1)*airDrandMT(), (size[1]-1)*airDrandMT(),
+               (size[2]-1)*airDrandMT());
+    if (check(me, "off", pos, AIR_FALSE, dctx, dpvl, rctx, rpvl)) {
+      airMopError(mop); return 1;
+    }
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
@@ -0,0 +1,186 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "teem/gage.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#  include <sys/mman.h>
+#endif
+
+/*
+** Tests:
+** gageIv3Fill (via gageProbeSpace) on a volume with more than 2^32
+** samples, and with more than 2^32 samples in three Z slices, so that
+** both the data index and the iv3 offsets overflow 32 bits.
+**
+** The volume is a huge sparse (anonymously mmap'd, never written except
+** for a few small planted blocks) unsigned char volume; the planted blocks
+** hold a linear function, which both the tent and the (blurring, but
+** linear-preserving) cubic B-spline reconstruct exactly.
+*/
+
+/* 65536 x 32768 x 8 == 2^34 samples; 3 Z slices is 1.5 * 2^32 */
+#define SX 65536
+#define SY 32768
+#define SZ 8
+#define PLANT 6
+
+static double
+lfunc(double xx, double yy, double zz) {
+  return 10 + 3*xx + 5*yy + 7*zz;
+}
+
+/* plant a PLANT^3 block of lfunc starting at (x0,y0,z0) */
+static void
+plant(unsigned char *data, size_t x0, size_t y0, size_t z0) {
+  size_t xi, yi, zi;
+
+  for (zi=0; zi<PLANT; zi++) {
+    for (yi=0; yi<PLANT; yi++) {
+      for (xi=0; xi<PLANT; xi++) {
+        data[(x0 + xi) + SX*((y0 + yi) + AIR_CAST(size_t, SY)*(z0 + zi))]
+          = AIR_CAST(unsigned char, lfunc(AIR_CAST(double, xi),
+                                          AIR_CAST(double, yi),
+                                          AIR_CAST(double, zi)));
+      }
+    }
+  }
+  return;
+}
+
+int
+main(int argc, const char **argv) {
+  const char *me;
+#if defined(MAP_ANONYMOUS) && defined(MAP_NORESERVE)
+  Nrrd *nin;
+  unsigned char *data;
+  size_t dataSize;
+  airArray *mop;
+  gageContext *gctx[2];
+  const NrrdKernel *kern[2];
+  double kparm[NRRD_KERNEL_PARMS_NUM] = {1.0, 1.0, 0.0}, val, want,
+    pos[3][3];
+  const double *vans[2];
+  unsigned int ki, pi;
+  int E;
+#endif
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+#if defined(MAP_ANONYMOUS) && defined(MAP_NORESERVE)
+  if (sizeof(size_t) < 8) {
+    printf("%s: size_t too small for huge volumes; skipping\n", me);
+    return 0;
+  }
+  mop = airMopNew();
+  dataSize = AIR_CAST(size_t, SX)*SY*SZ;
+  data = AIR_CAST(unsigned char *,
+                  mmap(NULL, dataSize, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0));
+  if (MAP_FAILED == AIR_CAST(void *, data)) {
+    printf("%s: couldn't map sparse volume; skipping\n", me);
+    airMopError(mop); return 0;
+  }
+  /* interior block near the far end of the volume: voxels past 2^33 */
+  plant(data, SX - 20, SY - 20, SZ - 1 - PLANT);
+  /* block at the very corner, for probing with clamping */
+  plant(data, SX - PLANT, SY - PLANT, SZ - PLANT);
+  ELL_3V_SET(pos[0], SX - 20 + 2.5, SY - 20 + 2.3, SZ - 1 - PLANT + 2.7);
+  ELL_3V_SET(pos[1], SX - PLANT + 1.5, SY - PLANT + 2.25, SZ - PLANT + 2.5);
+  ELL_3V_SET(pos[2], SX - 1, SY - 1, SZ - 1);
+
+  nin = nrrdNew();
+  airMopAdd(mop, nin, (airMopper)nrrdNix, airMopAlways);
+  if (nrrdWrap_va(nin, data, nrrdTypeUChar, 3, AIR_CAST(size_t, SX),
+                  AIR_CAST(size_t, SY), AIR_CAST(size_t, SZ))) {
+    char *err;
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble wrapping:\n%s", me, err);
+    munmap(AIR_VOIDP(data), dataSize);
+    airMopError(mop); return 1;
+  }
+  nrrdAxisInfoSet_va(nin, nrrdAxisInfoSpacing, 1.0, 1.0, 1.0);
+
+  kern[0] = nrrdKernelTent;
+  kern[1] = nrrdKernelBSpline3;
+  for (ki=0; ki<2; ki++) {
+    gagePerVolume *gpvl;
+    gctx[ki] = gageContextNew();
+    airMopAdd(mop, gctx[ki], (airMopper)gageContextNix, airMopAlways);
+    gageParmSet(gctx[ki], gageParmRenormalize, AIR_FALSE);
+    gageParmSet(gctx[ki], gageParmCheckIntegrals, AIR_TRUE);
+    E = 0;
+    if (!E) E |= !(gpvl = gagePerVolumeNew(gctx[ki], nin, gageKindScl));
+    if (!E) E |= gageKernelSet(gctx[ki], gageKernel00, kern[ki], kparm);
+    if (!E) E |= gagePerVolumeAttach(gctx[ki], gpvl);
+    if (!E) E |= gageQueryItemOn(gctx[ki], gpvl, gageSclValue);
+    if (!E) E |= gageUpdate(gctx[ki]);
+    if (E) {
+      char *err;
+      airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble %s set-up:\n%s\n", me,
+              kern[ki]->name, err);
+      munmap(AIR_VOIDP(data), dataSize);
+      airMopError(mop); return 1;
+    }
+    vans[ki] = gageAnswerPointer(gctx[ki], gpvl, gageSclValue);
+  }
+
+  for (pi=0; pi<3; pi++) {
+    if (pi < 2) {
+      want = (0 == pi
+              ? lfunc(2.5, 2.3, 2.7)
+              : lfunc(1.5, 2.25, 2.5));
+    } else {
+      /* at the corner, clamping sees only the corner value; only the
+         interpolating tent gives it back */
+      want = lfunc(PLANT-1, PLANT-1, PLANT-1);
+    }
+    for (ki=0; ki<(pi < 2 ? 2u : 1u); ki++) {
+      if (gageProbeSpace(gctx[ki], pos[pi][0], pos[pi][1], pos[pi][2],
+                         AIR_TRUE /* indexSpace */,
+                         AIR_TRUE /* clamp */)) {
+        fprintf(stderr, "%s: %s probe error(%d): %s\n", me,
+                kern[ki]->name, gctx[ki]->errNum, gctx[ki]->errStr);
+        munmap(AIR_VOIDP(data), dataSize);
+        airMopError(mop); return 1;
+      }
+      val = vans[ki][0];
+      if (AIR_ABS(val - want) > 1e-10) {
+        fprintf(stderr, "%s: %s probe at (%g,%g,%g) got %g != %g\n", me,
+                kern[ki]->name, pos[pi][0], pos[pi][1], pos[pi][2],
+                val, want);
+        munmap(AIR_VOIDP(data), dataSize);
+        airMopError(mop); return 1;
+      }
+    }
+  }
+  printf("%s: all good\n", me);
+
+  airMopOkay(mop);
+  munmap(AIR_VOIDP(data), dataSize);
+#else
+  printf("%s: no sparse memory mapping on this platform; skipping\n", me);
+#endif
+  return 0;
+}
@@ -0,0 +1,261 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "teem/gage.h"
+
+/*
+** Tests:
+** gageContextPoolNew, gageProbeGrid, gageProbeList: with any number of
+** threads, the answers have to be the same as those from serial
+** gageProbeSpace() calls, and failed probes have to be counted and
+** give AIR_NAN answers
+*/
+
+#define POS_NUM 1000
+
+/* compares answers of length len at index ii in the two outputs; the
+   reference answer is from rctx and rpvl after gageProbeSpace() returned
+   rfail.  Returns non-zero if different */
+static int
+compare(const char *me, const char *what, unsigned int tnum,
+        const Nrrd *nout, unsigned int len, size_t ii,
+        const double *ref, int rfail) {
+  const double *ans;
+  unsigned int vi;
+
+  ans = AIR_CAST(const double *, nout->data) + len*ii;
+  for (vi=0; vi<len; vi++) {
+    if (rfail ? AIR_EXISTS(ans[vi]) : ans[vi] != ref[vi]) {
+      fprintf(stderr, "%s: %s with %u threads: [%u] at %u: %.17g != %.17g\n",
+              me, what, tnum, vi, AIR_UINT(ii), ans[vi],
+              rfail ? AIR_NAN : ref[vi]);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int
+main(int argc, const char **argv) {
+  static const unsigned int tnumTest[3] = {1, 2, 5};
+  const char *me;
+  char *err, stmp[AIR_STRLEN_SMALL];
+  airArray *mop;
+  Nrrd *nin, *npos, *nout[2];
+  gageContext *gctx;
+  gagePerVolume *pvl;
+  gageContextPool *pool;
+  const gagePerVolume *apvl[2];
+  NrrdKernelSpec *ksp[3];
+  const char *kss[3] = {"bspln3", "bspln3d", "bspln3dd"};
+  int E, item[2] = {gageSclValue, gageSclGradVec}, rfail;
+  unsigned int ii, ti, tnum, size[3], len[2];
+  size_t NN, ei, gsize[3], failNum, rfailNum;
+  double orig[4], edge[12], pos[4];
+  const double *ref[2];
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+
+  airSrandMT(4242);
+  nin = nrrdNew();
+  airMopAdd(mop, nin, (airMopper)nrrdNuke, airMopAlways);
+  ELL_3V_SET(size, 14, 11, 9);
+  if (nrrdMaybeAlloc_va(nin, nrrdTypeFloat, 3,
+                        AIR_CAST(size_t, size[0]), AIR_CAST(size_t, size[1]),
+                        AIR_CAST(size_t, size[2]))) {
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  nrrdAxisInfoSet_va(nin, nrrdAxisInfoSpacing, 0.9, 1.0, 1.3);
+  NN = nrrdElementNumber(nin);
+  for (ei=0; ei<NN; ei++) {
+    AIR_CAST(float *, nin->data)[ei] = AIR_CAST(float, airDrandMT());
+  }
+
+  for (ii=0; ii<3; ii++) {
+    ksp[ii] = nrrdKernelSpecNew();
+    airMopAdd(mop, ksp[ii], (airMopper)nrrdKernelSpecNix, airMopAlways);
+    if (nrrdKernelSpecParse(ksp[ii], kss[ii])) {
+      airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble parsing kernel:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+  }
+  gctx = gageContextNew();
+  airMopAdd(mop, gctx, (airMopper)gageContextNix, airMopAlways);
+  gageParmSet(gctx, gageParmRenormalize, AIR_FALSE);
+  gageParmSet(gctx, gageParmCheckIntegrals, AIR_FALSE);
+  E = 0;
+  if (!E) E |= !(pvl = gagePerVolumeNew(gctx, nin, gageKindScl));
+  if (!E) E |= gageKernelSet(gctx, gageKernel00,
+                             ksp[0]->kernel, ksp[0]->parm);
+  if (!E) E |= gageKernelSet(gctx, gageKernel11,
+                             ksp[1]->kernel, ksp[1]->parm);
+  if (!E) E |= gagePerVolumeAttach(gctx, pvl);
+  if (!E) E |= gageQueryItemOn(gctx, pvl, item[0]);
+  if (!E) E |= gageQueryItemOn(gctx, pvl, item[1]);
+  if (!E) E |= gageUpdate(gctx);
+  if (E) {
+    airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble setting up context:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  for (ii=0; ii<2; ii++) {
+    apvl[ii] = pvl;
+    len[ii] = gageAnswerLength(gctx, pvl, item[ii]);
+    ref[ii] = gageAnswerPointer(gctx, pvl, item[ii]);
+    nout[ii] = nrrdNew();
+    airMopAdd(mop, nout[ii], (airMopper)nrrdNuke, airMopAlways);
+  }
+
+  /* an oblique index-space grid that sticks out of the volume, and a list
+     of world-space positions, some of which are outside, given as floats
+     to also exercise the conversion */
+  ELL_3V_SET(gsize, 17, 13, 6);
+  ELL_4V_SET(orig, -1.3, 0.2, 0.7, 0);
+  ELL_4V_SET(edge + 4*0, 0.9, 0.1, 0, 0);
+  ELL_4V_SET(edge + 4*1, -0.2, 0.8, 0.1, 0);
+  ELL_4V_SET(edge + 4*2, 0.1, 0, 1.4, 0);
+  npos = nrrdNew();
+  airMopAdd(mop, npos, (airMopper)nrrdNuke, airMopAlways);
+  if (nrrdMaybeAlloc_va(npos, nrrdTypeFloat, 2, AIR_CAST(size_t, 3),
+                        AIR_CAST(size_t, POS_NUM))) {
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  for (ei=0; ei<3*POS_NUM; ei++) {
+    AIR_CAST(float *, npos->data)[ei] =
+      AIR_CAST(float, AIR_AFFINE(0, airDrandMT(), 1, -1.2, 1.2));
+  }
+
+  for (ti=0; ti<3; ti++) {
+    tnum = tnumTest[ti];
+    if (!(pool = gageContextPoolNew(gctx, tnum))) {
+      airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble making pool:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    airMopAdd(mop, pool, (airMopper)gageContextPoolNix, airMopAlways);
+
+    if (gageProbeGrid(pool, nout, &failNum, apvl, item, 2, nrrdTypeDouble,
+                      3, gsize, orig, edge, AIR_TRUE, AIR_FALSE)) {
+      airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble probing grid:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    if (!( 3 == nout[0]->dim && 4 == nout[1]->dim
+           && 3 == nout[1]->axis[0].size
+           && gsize[2] == nout[0]->axis[2].size )) {
+      fprintf(stderr, "%s: grid output has wrong shape\n", me);
+      airMopError(mop); return 1;
+    }
+    NN = gsize[0]*gsize[1]*gsize[2];
+    rfailNum = 0;
+    for (ei=0; ei<NN; ei++) {
+      ELL_4V_COPY(pos, orig);
+      ELL_4V_SCALE_ADD2(pos, 1, pos, AIR_CAST(double, ei % gsize[0]),
+                        edge + 4*0);
+      ELL_4V_SCALE_ADD2(pos, 1, pos,
+                        AIR_CAST(double, (ei/gsize[0]) % gsize[1]),
+                        edge + 4*1);
+      ELL_4V_SCALE_ADD2(pos, 1, pos,
+                        AIR_CAST(double, ei/(gsize[0]*gsize[1])),
+                        edge + 4*2);
+      rfail = gageProbeSpace(gctx, pos[0], pos[1], pos[2],
+                             AIR_TRUE, AIR_FALSE);
+      rfailNum += !!rfail;
+      for (ii=0; ii<2; ii++) {
+        if (compare(me, "grid", tnum, nout[ii], len[ii], ei,
+                    ref[ii], rfail)) {
+          airMopError(mop); return 1;
+        }
+      }
+    }
+    if (!( rfailNum && rfailNum < NN && failNum == rfailNum )) {
+      fprintf(stderr, "%s: grid with %u threads: %s failures, "
+              "but expected %u (in (0,%u))\n", me, tnum,
+              airSprintSize_t(stmp, failNum), AIR_UINT(rfailNum),
+              AIR_UINT(NN));
+      airMopError(mop); return 1;
+    }
+
+    if (gageProbeList(pool, nout, &failNum, apvl, item, 2, nrrdTypeDouble,
+                      npos, AIR_FALSE, AIR_FALSE)) {
+      airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble probing list:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    if (!( 1 == nout[0]->dim && POS_NUM == nout[1]->axis[1].size )) {
+      fprintf(stderr, "%s: list output has wrong shape\n", me);
+      airMopError(mop); return 1;
+    }
+    rfailNum = 0;
+    for (ei=0; ei<POS_NUM; ei++) {
+      for (ii=0; ii<3; ii++) {
+        pos[ii] = AIR_CAST(float *, npos->data)[ii + 3*ei];
+      }
+      rfail = gageProbeSpace(gctx, pos[0], pos[1], pos[2],
+                             AIR_FALSE, AIR_FALSE);
+      rfailNum += !!rfail;
+      for (ii=0; ii<2; ii++) {
+        if (compare(me, "list", tnum, nout[ii], len[ii], ei,
+                    ref[ii], rfail)) {
+          airMopError(mop); return 1;
+        }
+      }
+    }
+    if (!( rfailNum && rfailNum < POS_NUM && failNum == rfailNum )) {
+      fprintf(stderr, "%s: list with %u threads: %s failures, "
+              "but expected %u (in (0,%u))\n", me, tnum,
+              airSprintSize_t(stmp, failNum), AIR_UINT(rfailNum),
+              POS_NUM);
+      airMopError(mop); return 1;
+    }
+    /* many more calls with the same pool (as vprobe does, once per
+       slice), with fewer answers than before; the gradients go into
+       nout[0], to compare with those just checked in nout[1] */
+    for (ii=0; ii<20; ii++) {
+      if (gageProbeList(pool, nout, &failNum, apvl + 1, item + 1, 1,
+                        nrrdTypeDouble, npos, AIR_FALSE, AIR_FALSE)) {
+        airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+        fprintf(stderr, "%s: trouble re-probing list:\n%s", me, err);
+        airMopError(mop); return 1;
+      }
+      if (!( failNum == rfailNum
+             && nrrdElementNumber(nout[0]) == 3*POS_NUM
+             && !memcmp(nout[0]->data, nout[1]->data,
+                        3*POS_NUM*sizeof(double)) )) {
+        fprintf(stderr, "%s: re-probing list with %u threads (call %u) "
+                "gave different answers\n", me, tnum, ii);
+        airMopError(mop); return 1;
+      }
+    }
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
@@ -0,0 +1,94 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "teem/gage.h"
+
+/*
+** Tests:
+** gageScl3PFilter2, gageScl3PFilter4, gageScl3PFilter6, gageScl3PFilter8:
+** that their results are identical to those of gageScl3PFilterN, for all
+** combinations of needed derivatives, on random values and weights
+*/
+
+#define FD_MAX 8
+
+int
+main(int argc, const char **argv) {
+  const char *me;
+  gageShape *shape;
+  gageScl3PFilter_t *filter[FD_MAX/2+1];
+  double ivX[FD_MAX*FD_MAX*FD_MAX], ivY[FD_MAX*FD_MAX], ivZ[FD_MAX],
+    fw[3][3*FD_MAX], ansN[13], ansF[13];
+  int needD[3];
+  unsigned int ii, fd, trial, nd;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  filter[0] = NULL;
+  filter[1] = gageScl3PFilter2;
+  filter[2] = gageScl3PFilter4;
+  filter[3] = gageScl3PFilter6;
+  filter[4] = gageScl3PFilter8;
+  shape = gageShapeNew();
+  /* a non-trivial (non-symmetric) transform for gradient and hessian */
+  ELL_3M_SET(shape->ItoWSubInv, 1.0, 0.3, 0.0,
+             -0.2, 0.8, 0.1,
+             0.05, 0.0, 1.3);
+  ELL_3M_TRANSPOSE(shape->ItoWSubInvTransp, shape->ItoWSubInv);
+  airSrandMT(4242);
+  for (fd=2; fd<=FD_MAX; fd+=2) {
+    for (trial=0; trial<20; trial++) {
+      for (ii=0; ii<fd*fd*fd; ii++) {
+        ivX[ii] = airDrandMT() - 0.5;
+      }
+      for (ii=0; ii<3*fd; ii++) {
+        fw[0][ii] = airDrandMT();
+        fw[1][ii] = airDrandMT() - 0.5;
+        fw[2][ii] = airDrandMT() - 0.5;
+      }
+      for (nd=0; nd<8; nd++) {
+        needD[0] = !!(nd & 1);
+        needD[1] = !!(nd & 2);
+        needD[2] = !!(nd & 4);
+        for (ii=0; ii<13; ii++) {
+          ansN[ii] = ansF[ii] = 0;
+        }
+        gageScl3PFilterN(shape, fd, ivX, ivY, ivZ, fw[0], fw[1], fw[2],
+                         ansN + 0, ansN + 1, ansN + 4, needD);
+        filter[fd/2](shape, ivX, ivY, ivZ, fw[0], fw[1], fw[2],
+                     ansF + 0, ansF + 1, ansF + 4, needD);
+        for (ii=0; ii<13; ii++) {
+          if (ansN[ii] != ansF[ii]) {
+            fprintf(stderr, "%s: fd=%u, needD=(%d,%d,%d): answer[%u] "
+                    "%.17g != %.17g from gageScl3PFilterN\n", me, fd,
+                    needD[0], needD[1], needD[2], ii, ansF[ii], ansN[ii]);
+            gageShapeNix(shape);
+            return 1;
+          }
+        }
+      }
+    }
+  }
+  gageShapeNix(shape);
+  return 0;
+}
@@ -0,0 +1,276 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "teem/gage.h"
+
+/*
+** Tests:
+** gageParmSinglePrecision: with kernels of every filter diameter handled
+** separately (2, 4, 6, 8, and larger), the value, gradient, hessian, and
+** median from a context filtering in float, and from a copy of it, have
+** to match those of the usual double context to within float precision.
+** The probes go near the volume's edges (where caches are filled with
+** clamping) and along scanlines (where caches are shifted), and also go
+** into bricks of a quantized volume.  The float context must not have
+** the double value caches.
+*/
+
+#define POS_NUM 600
+
+static const int items[4] = {gageSclValue, gageSclGradVec,
+                             gageSclHessian, gageSclMedian};
+
+/* sets up a scalar context on nin (stored as given, and bricked if
+   nbrick is non-NULL), with the given kernels */
+static gageContext *
+ctxMake(gagePerVolume **pvlP, const Nrrd *nin, int store,
+        const Nrrd *nbrick, NrrdKernelSpec *const ksp[3], int single) {
+  static const char me[]="ctxMake";
+  gageContext *ctx;
+  unsigned int ii;
+  int E;
+
+  ctx = gageContextNew();
+  gageParmSet(ctx, gageParmCheckIntegrals, AIR_FALSE);
+  gageParmSet(ctx, gageParmSinglePrecision, single);
+  E = 0;
+  if (!E) E |= !(*pvlP = gagePerVolumeNew(ctx, nin, gageKindScl));
+  if (!E && gageStoreFull != store) {
+    E |= gagePerVolumeStoreSet(*pvlP, store);
+  }
+  if (!E && nbrick) E |= gagePerVolumeBrickSet(*pvlP, nbrick);
+  if (!E) E |= gagePerVolumeAttach(ctx, *pvlP);
+  if (!E) E |= gageKernelSet(ctx, gageKernel00, ksp[0]->kernel, ksp[0]->parm);
+  if (!E) E |= gageKernelSet(ctx, gageKernel11, ksp[1]->kernel, ksp[1]->parm);
+  if (!E) E |= gageKernelSet(ctx, gageKernel22, ksp[2]->kernel, ksp[2]->parm);
+  for (ii=0; ii<4; ii++) {
+    if (!E) E |= gageQueryItemOn(ctx, *pvlP, items[ii]);
+  }
+  if (!E) E |= gageUpdate(ctx);
+  if (E) {
+    biffMovef(GAGE, GAGE, "%s: trouble", me);
+    gageContextNix(ctx);
+    return NULL;
+  }
+  return ctx;
+}
+
+/* probes both contexts at (x,y,z), and compares all the answers;
+   returns non-zero if they differ by more than float precision allows */
+static int
+compare(const char *me, const char *kstr, unsigned int pi,
+        gageContext *dctx, gagePerVolume *dpvl,
+        gageContext *fctx, gagePerVolume *fpvl,
+        double x, double y, double z) {
+  const double *dans, *fans;
+  double tol;
+  unsigned int ii, vi, len;
+
+  if (gageProbe(dctx, x, y, z) || gageProbe(fctx, x, y, z)) {
+    fprintf(stderr, "%s: %s: probe %u at (%g,%g,%g) failed: %s %s\n", me,
+            kstr, pi, x, y, z, dctx->errStr, fctx->errStr);
+    return 1;
+  }
+  for (ii=0; ii<4; ii++) {
+    dans = gageAnswerPointer(dctx, dpvl, items[ii]);
+    fans = gageAnswerPointer(fctx, fpvl, items[ii]);
+    len = gageKindScl->table[items[ii]].answerLength;
+    for (vi=0; vi<len; vi++) {
+      /* the values are in [0,1) */
+      tol = 2e-5*(1 + AIR_ABS(dans[vi]));
+      if (!( AIR_ABS(fans[vi] - dans[vi]) <= tol )) {
+        fprintf(stderr, "%s: %s: probe %u at (%g,%g,%g): %s[%u] "
+                "%.9g (float) vs %.9g (double)\n", me, kstr, pi, x, y, z,
+                airEnumStr(gageScl, items[ii]), vi, fans[vi], dans[vi]);
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+/* compares the contexts at random positions, many of them near the
+   edges, and along a scanline of each axis, moving by one sample at a
+   time */
+static int
+sweep(const char *me, const char *kstr,
+      gageContext *dctx, gagePerVolume *dpvl,
+      gageContext *fctx, gagePerVolume *fpvl,
+      double lo, const double hi[3]) {
+  double pos[3];
+  unsigned int pi, axi;
+
+  if (dpvl->iv3f || dctx->fwf || !fpvl->iv3f || !fctx->fwf || fpvl->iv3) {
+    fprintf(stderr, "%s: %s: float caches %s\n", me, kstr,
+            (dpvl->iv3f || dctx->fwf
+             ? "with double"
+             : (fpvl->iv3 ? "next to double ones" : "missing")));
+    return 1;
+  }
+  for (pi=0; pi<POS_NUM; pi++) {
+    for (axi=0; axi<3; axi++) {
+      pos[axi] = AIR_AFFINE(0, airDrandMT(), 1, lo, hi[axi]);
+    }
+    if (compare(me, kstr, pi, dctx, dpvl, fctx, fpvl,
+                pos[0], pos[1], pos[2])) {
+      return 1;
+    }
+  }
+  for (axi=0; axi<3; axi++) {
+    ELL_3V_SET(pos, 9.3, 8.6, 7.7);
+    for (pi=0; pi<8; pi++) {
+      pos[axi] = 4.2 + pi;
+      if (compare(me, kstr, pi, dctx, dpvl, fctx, fpvl,
+                  pos[0], pos[1], pos[2])) {
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+int
+main(int argc, const char **argv) {
+  static const char *const kernStr[5][3] = {
+    {"tent", "fordif", "fordif"},
+    {"bspl3", "bspl3d", "bspl3dd"},
+    {"bspl5", "bspl5d", "bspl5dd"},
+    {"bspl7", "bspl7d", "bspl7dd"},
+    {"gauss:1.2,4", "gaussd:1.2,4", "gaussdd:1.2,4"}};
+  airArray *mop;
+  char *err;
+  const char *me;
+  Nrrd *nin, *nquant, *nbrick;
+  NrrdKernelSpec *ksp[3];
+  gageContext *dctx, *fctx, *cctx;
+  gagePerVolume *dpvl, *fpvl;
+  float *in;
+  double pos[3], lo, hi[3];
+  size_t ii, nn;
+  unsigned int si, ki, pi, axi;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+  nin = nrrdNew();
+  airMopAdd(mop, nin, AIR_CAST(airMopper, nrrdNuke), airMopAlways);
+  nquant = nrrdNew();
+  airMopAdd(mop, nquant, AIR_CAST(airMopper, nrrdNuke), airMopAlways);
+  nbrick = nrrdNew();
+  airMopAdd(mop, nbrick, AIR_CAST(airMopper, nrrdNuke), airMopAlways);
+  for (ki=0; ki<3; ki++) {
+    ksp[ki] = nrrdKernelSpecNew();
+    airMopAdd(mop, ksp[ki], AIR_CAST(airMopper, nrrdKernelSpecNix),
+              airMopAlways);
+  }
+  if (nrrdMaybeAlloc_va(nin, nrrdTypeFloat, 3,
+                        AIR_CAST(size_t, 23),
+                        AIR_CAST(size_t, 19),
+                        AIR_CAST(size_t, 17))) {
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  airSrandMT(4242);
+  in = AIR_CAST(float *, nin->data);
+  nn = nrrdElementNumber(nin);
+  for (ii=0; ii<nn; ii++) {
+    in[ii] = AIR_CAST(float, airDrandMT());
+  }
+  nrrdAxisInfoSet_va(nin, nrrdAxisInfoSpacing, 1.0, 0.9, 1.3);
+  nrrdAxisInfoSet_va(nin, nrrdAxisInfoCenter,
+                     nrrdCenterCell, nrrdCenterCell, nrrdCenterCell);
+  /* so index-space bounds are [-0.5,size-0.5] */
+  lo = -0.5;
+  for (axi=0; axi<3; axi++) {
+    hi[axi] = AIR_CAST(double, nin->axis[axi].size) - 0.5;
+  }
+
+  for (si=0; si<5; si++) {
+    for (ki=0; ki<3; ki++) {
+      if (nrrdKernelSpecParse(ksp[ki], kernStr[si][ki])) {
+        airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+        fprintf(stderr, "%s: trouble parsing kernel:\n%s", me, err);
+        airMopError(mop); return 1;
+      }
+    }
+    dctx = ctxMake(&dpvl, nin, gageStoreFull, NULL, ksp, AIR_FALSE);
+    fctx = ctxMake(&fpvl, nin, gageStoreFull, NULL, ksp, AIR_TRUE);
+    airMopAdd(mop, dctx, AIR_CAST(airMopper, gageContextNix), airMopAlways);
+    airMopAdd(mop, fctx, AIR_CAST(airMopper, gageContextNix), airMopAlways);
+    if (!( dctx && fctx )) {
+      airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble setting up %s:\n%s", me,
+              kernStr[si][0], err);
+      airMopError(mop); return 1;
+    }
+    if (sweep(me, kernStr[si][0], dctx, dpvl, fctx, fpvl, lo, hi)) {
+      airMopError(mop); return 1;
+    }
+    /* a copy of the float context has to filter in float too */
+    cctx = gageContextCopy(fctx);
+    if (!cctx) {
+      airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble copying:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    airMopAdd(mop, cctx, AIR_CAST(airMopper, gageContextNix), airMopAlways);
+    if (!( cctx->fwf && cctx->pvl[0]->iv3f && !cctx->pvl[0]->iv3 )) {
+      fprintf(stderr, "%s: %s: copy lost float caches\n", me,
+              kernStr[si][0]);
+      airMopError(mop); return 1;
+    }
+    for (pi=0; pi<POS_NUM/10; pi++) {
+      for (axi=0; axi<3; axi++) {
+        pos[axi] = AIR_AFFINE(0, airDrandMT(), 1, lo, hi[axi]);
+      }
+      if (compare(me, kernStr[si][0], pi, dctx, dpvl, cctx, cctx->pvl[0],
+                  pos[0], pos[1], pos[2])) {
+        airMopError(mop); return 1;
+      }
+    }
+  }
+
+  /* the bricks (with the last kernels) of a quantized volume */
+  if (gageStoreMake(nquant, nin, gageStoreQuant16)
+      || gageBrickMake(nbrick, nquant, gageKindScl, 3)) {
+    airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble making bricks:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  dctx = ctxMake(&dpvl, nquant, gageStoreQuant16, nbrick, ksp, AIR_FALSE);
+  fctx = ctxMake(&fpvl, nquant, gageStoreQuant16, nbrick, ksp, AIR_TRUE);
+  airMopAdd(mop, dctx, AIR_CAST(airMopper, gageContextNix), airMopAlways);
+  airMopAdd(mop, fctx, AIR_CAST(airMopper, gageContextNix), airMopAlways);
+  if (!( dctx && fctx )) {
+    airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble setting up bricks:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  if (sweep(me, "quantized bricks", dctx, dpvl, fctx, fpvl, lo, hi)) {
+    airMopError(mop); return 1;
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
@@ -0,0 +1,161 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "teem/gage.h"
+#include <testDataPath.h>
+
+/*
+** Tests:
+** gageStackBlurManage: the manifest saved with the blurrings has to
+** lead to re-use when nothing has changed, and to re-computation when
+** the input data or the blurring parameters change, and blurrings
+** without a manifest still have to be re-used
+*/
+
+#define BLUR_NUM 3
+
+static const char format[] = "stackBlurCache-%u.nrrd";
+static const char mname[] = "stackBlurCache-manifest.nrrd";
+
+/* manages blurring, and returns non-zero if recomputed isn't as wanted */
+static int
+manage(const char *me, const char *what, int recomputedWant,
+       gageStackBlurParm *sbp, const Nrrd *nin, airArray *mop) {
+  Nrrd **nblur;
+  unsigned int bi;
+  int recomputed;
+  char *err;
+
+  if (gageStackBlurManage(&nblur, &recomputed, sbp, format,
+                          AIR_TRUE, NULL, nin, gageKindScl)) {
+    airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+    fprintf(stderr, "%s: %s: trouble managing:\n%s", me, what, err);
+    return 1;
+  }
+  for (bi=0; bi<BLUR_NUM; bi++) {
+    nrrdNuke(nblur[bi]);
+  }
+  free(nblur);
+  if (recomputed != recomputedWant) {
+    fprintf(stderr, "%s: %s: recomputed %d but wanted %d\n", me, what,
+            recomputed, recomputedWant);
+    return 1;
+  }
+  return 0;
+}
+
+int
+main(int argc, const char **argv) {
+  const char *me;
+  char *err, fname[BLUR_NUM][AIR_STRLEN_SMALL];
+  airArray *mop;
+  Nrrd *nin;
+  gageStackBlurParm *sbp;
+  unsigned int bi;
+  size_t ii, NN;
+  FILE *file;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+
+  airSrandMT(4242);
+  nin = nrrdNew();
+  airMopAdd(mop, nin, (airMopper)nrrdNuke, airMopAlways);
+  if (nrrdMaybeAlloc_va(nin, nrrdTypeFloat, 3, AIR_CAST(size_t, 9),
+                        AIR_CAST(size_t, 8), AIR_CAST(size_t, 7))) {
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  nrrdAxisInfoSet_va(nin, nrrdAxisInfoSpacing, 1.0, 1.0, 1.0);
+  NN = nrrdElementNumber(nin);
+  for (ii=0; ii<NN; ii++) {
+    AIR_CAST(float *, nin->data)[ii] = AIR_CAST(float, airDrandMT());
+  }
+  sbp = gageStackBlurParmNew();
+  airMopAdd(mop, sbp, (airMopper)gageStackBlurParmNix, airMopAlways);
+  if (gageStackBlurParmParse(sbp, NULL, NULL,
+                             "0.5-3-2.5/k=dg:1,5/b=bleed/v=0")) {
+    airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble setting up:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  for (bi=0; bi<BLUR_NUM; bi++) {
+    sprintf(fname[bi], format, bi);
+    airMopAdd(mop, fname[bi], testRemoveMop, airMopAlways);
+  }
+  airMopAdd(mop, AIR_CAST(char *, mname), testRemoveMop, airMopAlways);
+  /* in case of leftovers from an earlier failure */
+  remove(mname);
+  remove(fname[0]);
+
+  if (manage(me, "first", AIR_TRUE, sbp, nin, mop)) {
+    airMopError(mop); return 1;
+  }
+  if (!(file = fopen(mname, "r"))) {
+    fprintf(stderr, "%s: didn't save manifest \"%s\"\n", me, mname);
+    airMopError(mop); return 1;
+  }
+  fclose(file);
+  if (manage(me, "unchanged", AIR_FALSE, sbp, nin, mop)) {
+    airMopError(mop); return 1;
+  }
+  /* a change in the data */
+  AIR_CAST(float *, nin->data)[NN/2] += 1;
+  if (manage(me, "new data", AIR_TRUE, sbp, nin, mop)
+      || manage(me, "new data again", AIR_FALSE, sbp, nin, mop)) {
+    airMopError(mop); return 1;
+  }
+  /* a change in the blurring */
+  if (gageStackBlurParmRenormalizeSet(sbp, !sbp->renormalize)) {
+    airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble changing parm:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  if (manage(me, "new parm", AIR_TRUE, sbp, nin, mop)
+      || manage(me, "new parm again", AIR_FALSE, sbp, nin, mop)) {
+    airMopError(mop); return 1;
+  }
+  /* a mismatched manifest, along with an unreadable blurring, has to
+     lead to re-computing and re-saving all of them */
+  if (!(file = fopen(fname[BLUR_NUM-1], "w"))) {
+    fprintf(stderr, "%s: couldn't open \"%s\"\n", me, fname[BLUR_NUM-1]);
+    airMopError(mop); return 1;
+  }
+  fprintf(file, "not a nrrd\n");
+  fclose(file);
+  AIR_CAST(float *, nin->data)[NN/3] += 1;
+  if (manage(me, "unreadable", AIR_TRUE, sbp, nin, mop)
+      || manage(me, "unreadable fixed", AIR_FALSE, sbp, nin, mop)) {
+    airMopError(mop); return 1;
+  }
+  /* without a manifest, blurrings are read and checked, as before */
+  remove(mname);
+  if (manage(me, "no manifest", AIR_FALSE, sbp, nin, mop)) {
+    airMopError(mop); return 1;
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
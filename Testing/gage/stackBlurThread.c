@@ -0,0 +1,174 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "teem/gage.h"
+#include <testDataPath.h>
+
+/*
+** Tests:
+** gageStackBlurParmThreadNumSet, gageStackBlur, gageStackBlurStream:
+** spatial-domain blurring (both iterative and one-shot) has to give
+** exactly the same results with any number of threads, and streamed
+** blurrings have to load back as a valid stack
+*/
+
+#define BLUR_NUM 4
+
+static const char *
+sbpStr[2] = {
+  /* iterative discrete gaussian, with a small dggsm to force many passes */
+  "0.5-4-3.5-p/k=dg:1,5/b=bleed/dggsm=1.2/v=0",
+  /* one-shot blurring with a continuous gaussian */
+  "0.5-4-3.5-p/k=gauss:1,4/b=pad:0.3/v=0"
+};
+
+static int
+compare(const char *me, const char *what, unsigned int tnum,
+        const Nrrd *const nref[], const Nrrd *const ntst[]) {
+  unsigned int bi;
+  size_t ii, NN;
+  double (*lup)(const void *, size_t);
+
+  for (bi=0; bi<BLUR_NUM; bi++) {
+    if (ntst[bi]->type != nref[bi]->type) {
+      fprintf(stderr, "%s: %s with %u threads: blurring %u type %d != %d\n",
+              me, what, tnum, bi, ntst[bi]->type, nref[bi]->type);
+      return 1;
+    }
+    NN = nrrdElementNumber(nref[bi]);
+    if (nrrdElementNumber(ntst[bi]) != NN) {
+      fprintf(stderr, "%s: %s with %u threads: blurring %u wrong size\n",
+              me, what, tnum, bi);
+      return 1;
+    }
+    lup = nrrdDLookup[nref[bi]->type];
+    for (ii=0; ii<NN; ii++) {
+      if (lup(ntst[bi]->data, ii) != lup(nref[bi]->data, ii)) {
+        fprintf(stderr, "%s: %s with %u threads: blurring %u [%u]: "
+                "%.17g != %.17g\n", me, what, tnum, bi, AIR_UINT(ii),
+                lup(ntst[bi]->data, ii), lup(nref[bi]->data, ii));
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+int
+main(int argc, const char **argv) {
+  static const unsigned int tnumTest[3] = {2, 3, 11};
+  static const char format[] = "stackBlurThread-%02u.nrrd";
+  const char *me;
+  char *err, fname[BLUR_NUM][AIR_STRLEN_SMALL];
+  airArray *mop;
+  Nrrd *nin, *nref[BLUR_NUM], *ntst[BLUR_NUM];
+  gageStackBlurParm *sbp;
+  unsigned int si, ti, bi;
+  size_t ii, NN;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+
+  airSrandMT(4242);
+  nin = nrrdNew();
+  airMopAdd(mop, nin, (airMopper)nrrdNuke, airMopAlways);
+  if (nrrdMaybeAlloc_va(nin, nrrdTypeFloat, 3, AIR_CAST(size_t, 13),
+                        AIR_CAST(size_t, 10), AIR_CAST(size_t, 11))) {
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  nrrdAxisInfoSet_va(nin, nrrdAxisInfoSpacing, 0.9, 1.0, 1.3);
+  NN = nrrdElementNumber(nin);
+  for (ii=0; ii<NN; ii++) {
+    AIR_CAST(float *, nin->data)[ii] = AIR_CAST(float, airDrandMT());
+  }
+  for (bi=0; bi<BLUR_NUM; bi++) {
+    nref[bi] = nrrdNew();
+    airMopAdd(mop, nref[bi], (airMopper)nrrdNuke, airMopAlways);
+    ntst[bi] = nrrdNew();
+    airMopAdd(mop, ntst[bi], (airMopper)nrrdNuke, airMopAlways);
+  }
+
+  for (si=0; si<2; si++) {
+    sbp = gageStackBlurParmNew();
+    airMopAdd(mop, sbp, (airMopper)gageStackBlurParmNix, airMopAlways);
+    if (gageStackBlurParmParse(sbp, NULL, NULL, sbpStr[si])
+        || gageStackBlur(nref, sbp, nin, gageKindScl)) {
+      airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble with serial blurring %u:\n%s",
+              me, si, err);
+      airMopError(mop); return 1;
+    }
+    for (ti=0; ti<3; ti++) {
+      if (gageStackBlurParmThreadNumSet(sbp, tnumTest[ti])
+          || gageStackBlur(ntst, sbp, nin, gageKindScl)
+          || gageStackBlurCheck(AIR_CAST(const Nrrd *const *, ntst),
+                                sbp, nin, gageKindScl)) {
+        airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+        fprintf(stderr, "%s: trouble with blurring %u, %u threads:\n%s",
+                me, si, tnumTest[ti], err);
+        airMopError(mop); return 1;
+      }
+      if (compare(me, sbpStr[si], tnumTest[ti],
+                  AIR_CAST(const Nrrd *const *, nref),
+                  AIR_CAST(const Nrrd *const *, ntst))) {
+        airMopError(mop); return 1;
+      }
+    }
+  }
+
+  /* sbp, nref are left with the last (one-shot) blurring; stream it out
+     with multiple threads and read it back in */
+  for (bi=0; bi<BLUR_NUM; bi++) {
+    sprintf(fname[bi], format, bi);
+    airMopAdd(mop, fname[bi], testRemoveMop, airMopAlways);
+  }
+  airMopAdd(mop, AIR_CAST(char *, "stackBlurThread-manifest.nrrd"),
+            testRemoveMop, airMopAlways);
+  if (gageStackBlurStream(sbp, format, NULL, nin, gageKindScl)) {
+    airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble streaming blurring:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  if (nrrdLoadMulti(ntst, BLUR_NUM, format, 0, NULL)) {
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble reading streamed blurring:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  if (gageStackBlurCheck(AIR_CAST(const Nrrd *const *, ntst),
+                         sbp, nin, gageKindScl)) {
+    airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+    fprintf(stderr, "%s: streamed blurring didn't check:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  if (compare(me, "streamed", sbp->threadNum,
+              AIR_CAST(const Nrrd *const *, nref),
+              AIR_CAST(const Nrrd *const *, ntst))) {
+    airMopError(mop); return 1;
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
@@ -0,0 +1,229 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "teem/gage.h"
+
+/*
+** Tests:
+** gageStoreMake, gageStackLazyNew, gageStackLazyPerVolumeNew: scale-space
+** probing of stored blurrings, and of lazily computed blurrings, has to
+** match probing of the blurrings from gageStackBlur, to within the error
+** of the store, and lazy blurrings must only compute the bricks needed
+*/
+
+#define BLUR_NUM 3
+#define POS_NUM 300
+#define BRICK_SHIFT 2
+
+/* largest allowed error in probed values, for each store */
+static const double
+storeTol[GAGE_STORE_MAX+1] = {0, 1e-5, 1e-3, 1e-4, 5e-3};
+
+/* sets up in *gctxP a context for stack probing values of either the
+   blurrings in nblur, or those of lazy.  Returns non-zero on error */
+static int
+setup(gageContext **gctxP, const double **ansP, const Nrrd *nin,
+      const Nrrd *const *nblur, gageStackLazy *lazy,
+      const gageStackBlurParm *sbp, airArray *mop) {
+  static const char me[]="setup";
+  gageContext *gctx;
+  gagePerVolume *pvl, **pvlSS;
+  double kparm[NRRD_KERNEL_PARMS_NUM];
+  int E;
+
+  *gctxP = gctx = gageContextNew();
+  airMopAdd(mop, gctx, (airMopper)gageContextNix, airMopAlways);
+  pvlSS = AIR_CALLOC(BLUR_NUM, gagePerVolume *);
+  airMopAdd(mop, pvlSS, airFree, airMopAlways);
+  gageParmSet(gctx, gageParmRenormalize, AIR_FALSE);
+  gageParmSet(gctx, gageParmCheckIntegrals, AIR_FALSE);
+  gageParmSet(gctx, gageParmStackUse, AIR_TRUE);
+  E = 0;
+  if (!E) E |= !pvlSS;
+  if (!E) E |= !(pvl = gagePerVolumeNew(gctx, nin, gageKindScl));
+  ELL_3V_SET(kparm, 1.0, 0.0, 0.5);
+  if (!E) E |= gageKernelSet(gctx, gageKernel00, nrrdKernelBCCubic, kparm);
+  if (!E) E |= (lazy
+                ? gageStackLazyPerVolumeNew(gctx, pvlSS, lazy)
+                : gageStackPerVolumeNew(gctx, pvlSS, nblur, BLUR_NUM,
+                                        gageKindScl));
+  if (!E) E |= gageStackPerVolumeAttach(gctx, pvl, pvlSS,
+                                        sbp->sigma, BLUR_NUM);
+  kparm[0] = 1.0;
+  if (!E) E |= gageKernelSet(gctx, gageKernelStack, nrrdKernelTent, kparm);
+  if (!E) E |= gageQueryItemOn(gctx, pvl, gageSclValue);
+  if (!E) E |= gageUpdate(gctx);
+  if (E) {
+    char *err;
+    airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble:\n%s", me, err);
+    return 1;
+  }
+  *ansP = gageAnswerPointer(gctx, pvl, gageSclValue);
+  return 0;
+}
+
+/* probes at the first num positions in pos, and either sets ref (if set)
+   or compares with it.  Returns non-zero on error */
+static int
+probe(const char *me, const char *what, double *ref, int set, double tol,
+      gageContext *gctx, const double *ans, const double *pos,
+      unsigned int num) {
+  unsigned int pi;
+  const double *pp;
+
+  for (pi=0; pi<num; pi++) {
+    pp = pos + 4*pi;
+    if (gageStackProbe(gctx, pp[0], pp[1], pp[2], pp[3])) {
+      fprintf(stderr, "%s: %s: probe %u failed: %s (%d)\n", me, what, pi,
+              gctx->errStr, gctx->errNum);
+      return 1;
+    }
+    if (set) {
+      ref[pi] = ans[0];
+    } else if (!( AIR_ABS(ans[0] - ref[pi]) <= tol )) {
+      fprintf(stderr, "%s: %s: at (%g,%g,%g,%g), |%.17g - %.17g| > %g\n",
+              me, what, pp[0], pp[1], pp[2], pp[3], ans[0], ref[pi], tol);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int
+main(int argc, const char **argv) {
+  const char *me;
+  char *err, what[AIR_STRLEN_SMALL];
+  airArray *mop;
+  Nrrd *nin, *nblur[BLUR_NUM], *nstore[BLUR_NUM];
+  gageStackBlurParm *sbp;
+  gageStackLazy *lazy;
+  gageContext *gctx;
+  const double *ans;
+  double pos[4*POS_NUM], ref[POS_NUM];
+  unsigned int size[3], bi, pi, ai;
+  size_t ii, NN, bnum;
+  int store;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+
+  airSrandMT(4242);
+  nin = nrrdNew();
+  airMopAdd(mop, nin, (airMopper)nrrdNuke, airMopAlways);
+  ELL_3V_SET(size, 21, 18, 15);
+  if (nrrdMaybeAlloc_va(nin, nrrdTypeFloat, 3,
+                        AIR_CAST(size_t, size[0]), AIR_CAST(size_t, size[1]),
+                        AIR_CAST(size_t, size[2]))) {
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  nrrdAxisInfoSet_va(nin, nrrdAxisInfoSpacing, 1.0, 1.0, 1.0);
+  NN = nrrdElementNumber(nin);
+  for (ii=0; ii<NN; ii++) {
+    AIR_CAST(float *, nin->data)[ii] = AIR_CAST(float, airDrandMT());
+  }
+  for (bi=0; bi<BLUR_NUM; bi++) {
+    nblur[bi] = nrrdNew();
+    airMopAdd(mop, nblur[bi], (airMopper)nrrdNuke, airMopAlways);
+    nstore[bi] = nrrdNew();
+    airMopAdd(mop, nstore[bi], (airMopper)nrrdNuke, airMopAlways);
+  }
+  sbp = gageStackBlurParmNew();
+  airMopAdd(mop, sbp, (airMopper)gageStackBlurParmNix, airMopAlways);
+  if (gageStackBlurParmParse(sbp, NULL, NULL,
+                             "0.5-3-2.5/k=gauss:1,4/b=bleed/v=0")
+      || gageStackBlur(nblur, sbp, nin, gageKindScl)) {
+    airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble blurring:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  /* the first half of the positions are in the corner of the volume
+     (touching only a few lazy bricks), the rest are anywhere */
+  for (pi=0; pi<POS_NUM; pi++) {
+    for (ai=0; ai<3; ai++) {
+      pos[ai + 4*pi] = (pi < POS_NUM/2
+                        ? AIR_AFFINE(0, airDrandMT(), 1, 1, 3)
+                        : AIR_AFFINE(0, airDrandMT(), 1, 1, size[ai]-2));
+    }
+    pos[3 + 4*pi] = AIR_AFFINE(0, airDrandMT(), 1, 0, BLUR_NUM-1);
+  }
+
+  /* reference answers from the blurrings as computed */
+  if (setup(&gctx, &ans, nin, AIR_CAST(const Nrrd *const *, nblur), NULL,
+            sbp, mop)
+      || probe(me, "ref", ref, AIR_TRUE, 0, gctx, ans, pos, POS_NUM)) {
+    airMopError(mop); return 1;
+  }
+  bnum = 1;
+  for (ai=0; ai<3; ai++) {
+    bnum *= (size[ai] + (1u << BRICK_SHIFT) - 1) >> BRICK_SHIFT;
+  }
+
+  for (store=gageStoreFull; store<=GAGE_STORE_MAX; store++) {
+    /* eagerly computed and then stored */
+    for (bi=0; bi<BLUR_NUM; bi++) {
+      if (gageStoreMake(nstore[bi], nblur[bi], store)) {
+        airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+        fprintf(stderr, "%s: trouble storing:\n%s", me, err);
+        airMopError(mop); return 1;
+      }
+    }
+    sprintf(what, "stored %s", airEnumStr(gageStore, store));
+    if (setup(&gctx, &ans, nin, AIR_CAST(const Nrrd *const *, nstore),
+              NULL, sbp, mop)
+        || probe(me, what, ref, AIR_FALSE, storeTol[store],
+                 gctx, ans, pos, POS_NUM)) {
+      airMopError(mop); return 1;
+    }
+    /* lazily computed; first only in the corner */
+    if (!(lazy = gageStackLazyNew(nin, gageKindScl, sbp, BRICK_SHIFT,
+                                  store))) {
+      airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble with lazy blurring:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    /* added to mop first, so it's freed after the context */
+    airMopAdd(mop, lazy, (airMopper)gageStackLazyNix, airMopAlways);
+    sprintf(what, "lazy %s", airEnumStr(gageStore, store));
+    if (setup(&gctx, &ans, nin, NULL, lazy, sbp, mop)
+        || probe(me, what, ref, AIR_FALSE, storeTol[store],
+                 gctx, ans, pos, POS_NUM/2)) {
+      airMopError(mop); return 1;
+    }
+    if (!( lazy->brickMade && lazy->brickMade < BLUR_NUM*bnum/4 )) {
+      fprintf(stderr, "%s: %s: made %u bricks, not in (0,%u)\n", me, what,
+              AIR_UINT(lazy->brickMade), AIR_UINT(BLUR_NUM*bnum/4));
+      airMopError(mop); return 1;
+    }
+    if (probe(me, what, ref, AIR_FALSE, storeTol[store],
+              gctx, ans, pos, POS_NUM)) {
+      airMopError(mop); return 1;
+    }
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
@@ -0,0 +1,226 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "teem/gage.h"
+#include <testDataPath.h>
+
+/*
+** Tests:
+** the vprobe binary (path given as argv[1]): with any number of threads
+** and any verbosity, its output has to be bitwise the same as that from
+** the serial per-sample gageProbe() loop that vprobe has always used,
+** on a volume with an origin and non-axis-aligned space directions
+*/
+
+#define IN_NAME "vprobe-in.nrrd"
+#define OUT_NAME "vprobe-out.nrrd"
+
+/* what vprobe has always done, one sample at a time */
+static int
+oldProbe(Nrrd *nref, const Nrrd *nin, const char *whatS,
+         const double scale[3], const NrrdKernelSpec *const ksp[3]) {
+  static const char me[]="oldProbe";
+  gageContext *ctx;
+  gagePerVolume *pvl;
+  const double *answer;
+  double (*ins)(void *, size_t, double), min[3], maxOut[3], maxIn[3],
+    x, y, z;
+  size_t ansLen, sout[3], idx, xi, yi, zi, ai;
+  unsigned int axi;
+  int what, E;
+  airArray *mop;
+
+  mop = airMopNew();
+  ctx = gageContextNew();
+  airMopAdd(mop, ctx, AIR_CAST(airMopper, gageContextNix), airMopAlways);
+  gageParmSet(ctx, gageParmGradMagCurvMin, 0.0);
+  gageParmSet(ctx, gageParmVerbose, 0);
+  gageParmSet(ctx, gageParmTwoDimZeroZ, AIR_FALSE);
+  gageParmSet(ctx, gageParmRenormalize, AIR_FALSE);
+  gageParmSet(ctx, gageParmCheckIntegrals, AIR_TRUE);
+  gageParmSet(ctx, gageParmOrientationFromSpacing, AIR_FALSE);
+  what = airEnumVal(gageKindScl->enm, whatS);
+  E = 0;
+  if (!E) E |= !(pvl = gagePerVolumeNew(ctx, nin, gageKindScl));
+  if (!E) E |= gagePerVolumeAttach(ctx, pvl);
+  if (!E) E |= gageKernelSet(ctx, gageKernel00, ksp[0]->kernel, ksp[0]->parm);
+  if (!E) E |= gageKernelSet(ctx, gageKernel11, ksp[1]->kernel, ksp[1]->parm);
+  if (!E) E |= gageKernelSet(ctx, gageKernel22, ksp[2]->kernel, ksp[2]->parm);
+  if (!E) E |= gageQueryItemOn(ctx, pvl, what);
+  if (!E) E |= gageUpdate(ctx);
+  if (E) {
+    biffMovef(GAGE, GAGE, "%s: trouble setting up context", me);
+    airMopError(mop); return 1;
+  }
+  answer = gageAnswerPointer(ctx, pvl, what);
+  ansLen = gageKindScl->table[what].answerLength;
+  for (axi=0; axi<3; axi++) {
+    sout[axi] = AIR_CAST(size_t, scale[axi]
+                         *AIR_CAST(double, nin->axis[axi].size));
+    if (nrrdCenterCell == ctx->shape->center) {
+      min[axi] = -0.5;
+      maxOut[axi] = AIR_CAST(double, sout[axi]) - 0.5;
+      maxIn[axi] = AIR_CAST(double, nin->axis[axi].size) - 0.5;
+    } else {
+      min[axi] = 0;
+      maxOut[axi] = AIR_CAST(double, sout[axi]) - 1;
+      maxIn[axi] = AIR_CAST(double, nin->axis[axi].size) - 1;
+    }
+  }
+  if (nrrdMaybeAlloc_va(nref, nrrdTypeFloat, 4,
+                        ansLen, sout[0], sout[1], sout[2])) {
+    biffMovef(GAGE, NRRD, "%s: trouble allocating output", me);
+    airMopError(mop); return 1;
+  }
+  ins = nrrdDInsert[nref->type];
+  for (zi=0; zi<sout[2]; zi++) {
+    z = AIR_AFFINE(min[2], zi, maxOut[2], min[2], maxIn[2]);
+    for (yi=0; yi<sout[1]; yi++) {
+      y = AIR_AFFINE(min[1], yi, maxOut[1], min[1], maxIn[1]);
+      for (xi=0; xi<sout[0]; xi++) {
+        x = AIR_AFFINE(min[0], xi, maxOut[0], min[0], maxIn[0]);
+        idx = xi + sout[0]*(yi + sout[1]*zi);
+        if (gageProbe(ctx, x, y, z)) {
+          biffAddf(GAGE, "%s: trouble at (%g,%g,%g): %s", me,
+                   x, y, z, ctx->errStr);
+          airMopError(mop); return 1;
+        }
+        for (ai=0; ai<ansLen; ai++) {
+          ins(nref->data, ai + ansLen*idx, answer[ai]);
+        }
+      }
+    }
+  }
+  airMopOkay(mop);
+  return 0;
+}
+
+int
+main(int argc, const char **argv) {
+  static const unsigned int tnumTest[3] = {1, 2, 3};
+  static const int verbTest[3] = {0, 2, 3};
+  static const char *const whatTest[2] = {"val", "gradvec"};
+  static const double scale[3] = {1.3, 0.77, 2.1};
+  airArray *mop;
+  char *err, cmd[AIR_STRLEN_HUGE];
+  const char *me, *vprobe;
+  Nrrd *nin, *nref, *nout;
+  NrrdKernelSpec *ksp[3];
+  double origin[3], sdir[3][3];
+  float *in;
+  size_t ii, nn;
+  unsigned int ki, wi, ti;
+  airRandMTState *rng;
+
+  me = argv[0];
+  if (2 != argc) {
+    fprintf(stderr, "usage: %s <vprobe>\n", me);
+    return 1;
+  }
+  vprobe = argv[1];
+  mop = airMopNew();
+  nin = nrrdNew();
+  airMopAdd(mop, nin, AIR_CAST(airMopper, nrrdNuke), airMopAlways);
+  nref = nrrdNew();
+  airMopAdd(mop, nref, AIR_CAST(airMopper, nrrdNuke), airMopAlways);
+  nout = nrrdNew();
+  airMopAdd(mop, nout, AIR_CAST(airMopper, nrrdNuke), airMopAlways);
+  rng = airRandMTStateNew(4242);
+  airMopAdd(mop, rng, AIR_CAST(airMopper, airRandMTStateNix), airMopAlways);
+  for (ki=0; ki<3; ki++) {
+    ksp[ki] = nrrdKernelSpecNew();
+    airMopAdd(mop, ksp[ki], AIR_CAST(airMopper, nrrdKernelSpecNix),
+              airMopAlways);
+  }
+  if (nrrdMaybeAlloc_va(nin, nrrdTypeFloat, 3,
+                        AIR_CAST(size_t, 24),
+                        AIR_CAST(size_t, 30),
+                        AIR_CAST(size_t, 20))
+      || nrrdKernelSpecParse(ksp[0], "tent")
+      || nrrdKernelSpecParse(ksp[1], "cubicd:1,0")
+      || nrrdKernelSpecParse(ksp[2], "cubicdd:1,0")) {
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble setting up:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  in = AIR_CAST(float *, nin->data);
+  nn = nrrdElementNumber(nin);
+  for (ii=0; ii<nn; ii++) {
+    in[ii] = AIR_CAST(float, airDrandMT_r(rng));
+  }
+  /* an origin and directions that are neither unit-length nor aligned
+     with the world axes, so that positions are not exactly representable */
+  ELL_3V_SET(origin, 1.1, -2.3, 0.7);
+  ELL_3V_SET(sdir[0], 0.9, 0.31, -0.17);
+  ELL_3V_SET(sdir[1], -0.29, 1.13, 0.23);
+  ELL_3V_SET(sdir[2], 0.13, -0.21, 0.77);
+  nrrdSpaceSet(nin, nrrdSpaceRightAnteriorSuperior);
+  nrrdSpaceOriginSet(nin, origin);
+  nrrdAxisInfoSet_va(nin, nrrdAxisInfoSpaceDirection,
+                     sdir[0], sdir[1], sdir[2]);
+  nrrdAxisInfoSet_va(nin, nrrdAxisInfoCenter,
+                     nrrdCenterCell, nrrdCenterCell, nrrdCenterCell);
+  if (nrrdSave(IN_NAME, nin, NULL)) {
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble saving:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  airMopAdd(mop, IN_NAME, testRemoveMop, airMopAlways);
+  airMopAdd(mop, OUT_NAME, testRemoveMop, airMopAlways);
+
+  for (wi=0; wi<2; wi++) {
+    if (oldProbe(nref, nin, whatTest[wi], scale,
+                 AIR_CAST(const NrrdKernelSpec *const *, ksp))) {
+      airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble probing:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    for (ti=0; ti<3; ti++) {
+      sprintf(cmd, "\"%s\" -i " IN_NAME " -k scalar -q %s "
+              "-s %g %g %g -k00 tent -v %d -nt %u -o " OUT_NAME,
+              vprobe, whatTest[wi], scale[0], scale[1], scale[2],
+              verbTest[ti], tnumTest[ti]);
+      if (system(cmd)) {
+        fprintf(stderr, "%s: \"%s\" failed\n", me, cmd);
+        airMopError(mop); return 1;
+      }
+      if (nrrdLoad(nout, OUT_NAME, NULL)) {
+        airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+        fprintf(stderr, "%s: trouble loading:\n%s", me, err);
+        airMopError(mop); return 1;
+      }
+      if (nrrdTypeFloat != nout->type
+          || nrrdElementNumber(nout) != nrrdElementNumber(nref)
+          || memcmp(nout->data, nref->data,
+                    nrrdElementNumber(nref)*sizeof(float))) {
+        fprintf(stderr, "%s: %s with -v %d -nt %u differs from the "
+                "per-sample loop\n", me, whatTest[wi], verbTest[ti],
+                tnumTest[ti]);
+        airMopError(mop); return 1;
+      }
+    }
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
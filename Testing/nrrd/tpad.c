@@ -0,0 +1,210 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "teem/nrrd.h"
+
+/*
+** Tests:
+** nrrdPad_nva (all boundaries, against per-sample reference)
+** nrrdInset (against nrrdCrop)
+** nrrdSplice (against nrrdSlice)
+*/
+
+/* per-sample reference implementation of padding, as nrrdPad_va used
+   to do it, with input coordinates computed for every output sample */
+static void
+refPad(Nrrd *nref, const Nrrd *nin, const ptrdiff_t *min,
+       int boundary, double padValue) {
+  size_t II, idxIn, cOut[NRRD_DIM_MAX], cIn[NRRD_DIM_MAX],
+    szIn[NRRD_DIM_MAX], szOut[NRRD_DIM_MAX], NN, typeSize;
+  ptrdiff_t ci, sz;
+  unsigned int ai;
+  int outside;
+
+  nrrdAxisInfoGet_nva(nin, nrrdAxisInfoSize, szIn);
+  nrrdAxisInfoGet_nva(nref, nrrdAxisInfoSize, szOut);
+  NN = nrrdElementNumber(nref);
+  typeSize = nrrdElementSize(nin);
+  for (II=0; II<NN; II++) {
+    NRRD_COORD_GEN(cOut, szOut, nin->dim, II);
+    outside = AIR_FALSE;
+    for (ai=0; ai<nin->dim; ai++) {
+      ci = AIR_CAST(ptrdiff_t, cOut[ai]) + min[ai];
+      sz = AIR_CAST(ptrdiff_t, szIn[ai]);
+      if (!AIR_IN_CL(0, ci, sz-1)) {
+        outside = AIR_TRUE;
+        switch (boundary) {
+        case nrrdBoundaryPad:
+        case nrrdBoundaryBleed:
+          ci = AIR_CLAMP(0, ci, sz-1);
+          break;
+        case nrrdBoundaryWrap:
+          ci = AIR_MOD(ci, sz);
+          break;
+        case nrrdBoundaryMirror:
+          ci = (ci < 0 ? -ci : ci) % (2*sz);
+          ci = (ci >= sz ? 2*sz - 1 - ci : ci);
+          break;
+        }
+      }
+      cIn[ai] = AIR_CAST(size_t, ci);
+    }
+    if (outside && nrrdBoundaryPad == boundary) {
+      nrrdDInsert[nref->type](nref->data, II, padValue);
+    } else {
+      NRRD_INDEX_GEN(idxIn, cIn, szIn, nin->dim);
+      memcpy(AIR_CAST(char *, nref->data) + II*typeSize,
+             AIR_CAST(char *, nin->data) + idxIn*typeSize, typeSize);
+    }
+  }
+  return;
+}
+
+static int
+sameData(const Nrrd *na, const Nrrd *nb) {
+  return (nrrdElementNumber(na) == nrrdElementNumber(nb)
+          && !memcmp(na->data, nb->data,
+                     nrrdElementNumber(na)*nrrdElementSize(na)));
+}
+
+int
+main(int argc, const char *argv[]) {
+  const char *me;
+  static const int bound[4] = {nrrdBoundaryPad, nrrdBoundaryBleed,
+                               nrrdBoundaryWrap, nrrdBoundaryMirror};
+  static const int type[2] = {nrrdTypeUChar, nrrdTypeFloat};
+  size_t szIn[NRRD_DIM_MAX], szOut[NRRD_DIM_MAX], szSub[NRRD_DIM_MAX],
+    cmin[NRRD_DIM_MAX], cmax[NRRD_DIM_MAX], II, NN;
+  ptrdiff_t min[NRRD_DIM_MAX], max[NRRD_DIM_MAX];
+  unsigned int dim, ai, bi, ti, trial, pos;
+  Nrrd *nin, *nout, *nref, *nsub, *ntmp;
+  airArray *mop;
+  char *err;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+  nin = nrrdNew();
+  airMopAdd(mop, nin, (airMopper)nrrdNuke, airMopAlways);
+  nout = nrrdNew();
+  airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopAlways);
+  nref = nrrdNew();
+  airMopAdd(mop, nref, (airMopper)nrrdNuke, airMopAlways);
+  nsub = nrrdNew();
+  airMopAdd(mop, nsub, (airMopper)nrrdNuke, airMopAlways);
+  ntmp = nrrdNew();
+  airMopAdd(mop, ntmp, (airMopper)nrrdNuke, airMopAlways);
+
+  airSrandMT(4242);
+  for (trial=0; trial<200; trial++) {
+    dim = 1 + trial % 4;
+    ti = (trial/4) % 2;
+    for (ai=0; ai<dim; ai++) {
+      szIn[ai] = 1 + airRandInt(6);
+      /* sometimes leave axes unpadded, to exercise lumping of axes */
+      if (airRandInt(3)) {
+        min[ai] = -AIR_CAST(ptrdiff_t, airRandInt(15));
+        max[ai] = AIR_CAST(ptrdiff_t, szIn[ai]-1 + airRandInt(15));
+      } else {
+        min[ai] = 0;
+        max[ai] = AIR_CAST(ptrdiff_t, szIn[ai]-1);
+      }
+      szOut[ai] = AIR_CAST(size_t, max[ai] - min[ai] + 1);
+    }
+    if (nrrdMaybeAlloc_nva(nin, type[ti], dim, szIn)) {
+      airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    NN = nrrdElementNumber(nin);
+    for (II=0; II<NN; II++) {
+      nrrdDInsert[nin->type](nin->data, II, AIR_CAST(double, II % 250));
+    }
+    for (bi=0; bi<4; bi++) {
+      if (nrrdPad_nva(nout, nin, min, max, bound[bi], 251.0)
+          || nrrdMaybeAlloc_nva(nref, type[ti], dim, szOut)) {
+        airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+        fprintf(stderr, "%s: trouble padding:\n%s", me, err);
+        airMopError(mop); return 1;
+      }
+      refPad(nref, nin, min, bound[bi], 251.0);
+      if (!sameData(nout, nref)) {
+        fprintf(stderr, "%s: trial %u: %u-D %s pad with %s differs from "
+                "reference\n", me, trial, dim,
+                airEnumStr(nrrdType, type[ti]),
+                airEnumStr(nrrdBoundary, bound[bi]));
+        airMopError(mop); return 1;
+      }
+    }
+
+    /* inset a random sub-volume of the input into the padded output,
+       and make sure that cropping it back out recovers it */
+    for (ai=0; ai<dim; ai++) {
+      szSub[ai] = 1 + airRandInt(AIR_UINT(szOut[ai]));
+      cmin[ai] = airRandInt(AIR_UINT(szOut[ai] - szSub[ai] + 1));
+      cmax[ai] = cmin[ai] + szSub[ai] - 1;
+    }
+    if (nrrdMaybeAlloc_nva(nsub, type[ti], dim, szSub)) {
+      airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    NN = nrrdElementNumber(nsub);
+    for (II=0; II<NN; II++) {
+      nrrdDInsert[nsub->type](nsub->data, II, AIR_CAST(double, 3*II % 7));
+    }
+    if (nrrdInset(nref, nout, nsub, cmin)
+        || nrrdCrop(ntmp, nref, cmin, cmax)) {
+      airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble with inset:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    if (!sameData(ntmp, nsub)) {
+      fprintf(stderr, "%s: trial %u: inset didn't crop back out\n",
+              me, trial);
+      airMopError(mop); return 1;
+    }
+
+    /* splice a slice of the inset result back into the padded output,
+       and make sure that slicing it back out recovers it */
+    ai = airRandInt(dim);
+    pos = airRandInt(AIR_UINT(szOut[ai]));
+    if (1 < dim) {
+      if (nrrdSlice(ntmp, nref, ai, pos)
+          || nrrdSplice(nout, nout, ntmp, ai, pos)
+          || nrrdSlice(nsub, nout, ai, pos)) {
+        airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+        fprintf(stderr, "%s: trouble with splice:\n%s", me, err);
+        airMopError(mop); return 1;
+      }
+      if (!sameData(ntmp, nsub)) {
+        fprintf(stderr, "%s: trial %u: splice didn't slice back out\n",
+                me, trial);
+        airMopError(mop); return 1;
+      }
+    }
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
@@ -0,0 +1,273 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "teem/ten.h"
+
+/*
+** Tests:
+** tenEstimate1TensorVolume4D: with every estimation method, estimating
+** with multiple threads has to give exactly the same tensors, B0s and
+** errors as with one thread.  For LLS and WLS, for which many samples are
+** estimated at once, the results have to be the same as (for WLS, within
+** round-off of) those from tenEstimate1TensorSingle_d at each sample
+*/
+
+#define SX 9
+#define SY 8
+#define SZ 7
+#define GRAD_NUM 13
+
+/* non-DWI first, then 12 directions (not normalized) */
+static const double
+gradList[3*GRAD_NUM] = {
+  0, 0, 0,
+  1, 0, 0,    0, 1, 0,    0, 0, 1,
+  1, 1, 0,    1, 0, 1,    0, 1, 1,
+  1, -1, 0,   1, 0, -1,   0, 1, -1,
+  1, 1, 1,    -1, 1, 1,   1, -1, 1
+};
+
+/* sets up a context for the given method and threads */
+static tenEstimateContext *
+context(const Nrrd *ngrad, int method, unsigned int threadNum,
+        airArray *mop) {
+  tenEstimateContext *tec;
+  int E;
+
+  tec = tenEstimateContextNew();
+  airMopAdd(mop, tec, (airMopper)tenEstimateContextNix, airMopAlways);
+  E = 0;
+  if (!E) E |= tenEstimateMethodSet(tec, method);
+  if (!E) E |= tenEstimateGradientsSet(tec, ngrad, 1000, AIR_TRUE);
+  if (!E) E |= tenEstimateValueMinSet(tec, 1.0);
+  if (!E) E |= tenEstimateSigmaSet(tec, 5.0);
+  if (!E) E |= tenEstimateThresholdSet(tec, 100, 0);
+  if (!E) E |= tenEstimateThreadNumSet(tec, threadNum);
+  tec->recordErrorDwi = AIR_TRUE;
+  if (!E) E |= tenEstimateUpdate(tec);
+  return E ? NULL : tec;
+}
+
+/* estimates in nten, nB0, nterr with given method and threads */
+static int
+estimate(Nrrd *nten, Nrrd **nB0P, Nrrd **nterrP, const Nrrd *ndwi,
+         const Nrrd *ngrad, int method, unsigned int threadNum,
+         airArray *mop) {
+  static const char me[]="estimate";
+  tenEstimateContext *tec;
+  char *err;
+  int E;
+
+  E = 0;
+  if (!E) E |= !(tec = context(ngrad, method, threadNum, mop));
+  if (!E) E |= tenEstimate1TensorVolume4D(tec, nten, nB0P, nterrP, ndwi,
+                                          nrrdTypeDouble);
+  if (E) {
+    airMopAdd(mop, err = biffGetDone(TEN), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble with %s, %u threads:\n%s", me,
+            airEnumStr(tenEstimate1Method, method), threadNum, err);
+    return 1;
+  }
+  airMopAdd(mop, *nB0P, (airMopper)nrrdNuke, airMopAlways);
+  airMopAdd(mop, *nterrP, (airMopper)nrrdNuke, airMopAlways);
+  return 0;
+}
+
+/* returns non-zero if the values in na and nb are not all the same */
+static int
+differ(const char *me, const char *what, int method,
+       const Nrrd *na, const Nrrd *nb) {
+  const double *aa, *bb;
+  size_t ii, NN;
+
+  NN = nrrdElementNumber(na);
+  if (NN != nrrdElementNumber(nb)) {
+    fprintf(stderr, "%s: %s: %s: different sizes\n", me,
+            airEnumStr(tenEstimate1Method, method), what);
+    return 1;
+  }
+  aa = AIR_CAST(const double *, na->data);
+  bb = AIR_CAST(const double *, nb->data);
+  for (ii=0; ii<NN; ii++) {
+    /* (nan values must also be the same) */
+    if (!( aa[ii] == bb[ii] || (airIsNaN(aa[ii]) && airIsNaN(bb[ii])) )) {
+      fprintf(stderr, "%s: %s: %s[%u] %.17g != %.17g\n", me,
+              airEnumStr(tenEstimate1Method, method), what,
+              AIR_UINT(ii), aa[ii], bb[ii]);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* returns non-zero if aa and bb differ by more than tol, relative to the
+   larger of them (or to low, if that is larger) */
+static int
+far(const char *me, const char *what, int method, unsigned int ii,
+    double aa, double bb, double tol, double low) {
+  double scl;
+
+  scl = AIR_MAX(AIR_ABS(aa), AIR_ABS(bb));
+  scl = AIR_MAX(scl, low);
+  if (!( AIR_ABS(aa - bb) <= tol*scl
+         || (airIsNaN(aa) && airIsNaN(bb)) )) {
+    fprintf(stderr, "%s: %s: %s[%u] %.17g != %.17g (tol %g)\n", me,
+            airEnumStr(tenEstimate1Method, method), what, ii, aa, bb, tol);
+    return 1;
+  }
+  return 0;
+}
+
+/* returns non-zero if the volume results don't match estimating one
+   sample at a time */
+static int
+single(const char *me, int method, double tol, const Nrrd *nten,
+       const Nrrd *nB0, const Nrrd *nterr, const Nrrd *ndwi,
+       const Nrrd *ngrad, airArray *mop) {
+  tenEstimateContext *tec;
+  const double *vten, *vB0, *vterr, *dwi;
+  double ten[7];
+  unsigned int ii, ci, NN;
+  char *err;
+
+  if (!(tec = context(ngrad, method, 1, mop))) {
+    airMopAdd(mop, err = biffGetDone(TEN), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble setting up %s:\n%s", me,
+            airEnumStr(tenEstimate1Method, method), err);
+    return 1;
+  }
+  vten = AIR_CAST(const double *, nten->data);
+  vB0 = AIR_CAST(const double *, nB0->data);
+  vterr = AIR_CAST(const double *, nterr->data);
+  dwi = AIR_CAST(const double *, ndwi->data);
+  NN = SX*SY*SZ;
+  for (ii=0; ii<NN; ii++) {
+    if (tenEstimate1TensorSingle_d(tec, ten, dwi + GRAD_NUM*ii)) {
+      airMopAdd(mop, err = biffGetDone(TEN), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble with %s at %u:\n%s", me,
+              airEnumStr(tenEstimate1Method, method), ii, err);
+      return 1;
+    }
+    /* tensor coefficients are relative to the largest */
+    for (ci=0; ci<7; ci++) {
+      if (far(me, "single ten", method, 7*ii + ci, vten[ci + 7*ii], ten[ci],
+              tol, AIR_MAX(AIR_ABS(ten[1]), AIR_ABS(ten[4])))) {
+        return 1;
+      }
+    }
+    if (far(me, "single B0", method, ii, vB0[ii], tec->estimatedB0, tol, 0)
+        || far(me, "single err", method, ii, vterr[ii], tec->errorDwi,
+               tol, 0)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int
+main(int argc, const char **argv) {
+  const char *me;
+  char *err;
+  airArray *mop;
+  Nrrd *ngrad, *ndwi, *nten[2], *nB0[2], *nterr[2];
+  double *dwi, ten[7], eval[3], evec[9], qq[4], len, B0, gg[3], dot, nr,
+    ni;
+  unsigned int ii, gi, ti, NN;
+  int method;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+
+  airSrandMT(4242);
+  ngrad = nrrdNew();
+  airMopAdd(mop, ngrad, (airMopper)nrrdNuke, airMopAlways);
+  ndwi = nrrdNew();
+  airMopAdd(mop, ndwi, (airMopper)nrrdNuke, airMopAlways);
+  for (ti=0; ti<2; ti++) {
+    nten[ti] = nrrdNew();
+    airMopAdd(mop, nten[ti], (airMopper)nrrdNuke, airMopAlways);
+  }
+  NN = SX*SY*SZ;
+  if (nrrdMaybeAlloc_va(ngrad, nrrdTypeDouble, 2,
+                        AIR_CAST(size_t, 3), AIR_CAST(size_t, GRAD_NUM))
+      || nrrdMaybeAlloc_va(ndwi, nrrdTypeDouble, 4,
+                           AIR_CAST(size_t, GRAD_NUM), AIR_CAST(size_t, SX),
+                           AIR_CAST(size_t, SY), AIR_CAST(size_t, SZ))) {
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  /* normalized gradients */
+  for (gi=0; gi<GRAD_NUM; gi++) {
+    double *grad, len;
+    grad = AIR_CAST(double *, ngrad->data) + 3*gi;
+    ELL_3V_COPY(grad, gradList + 3*gi);
+    if (gi) {
+      ELL_3V_NORM(grad, grad, len);
+    }
+  }
+
+  /* simulated DWIs, with Rician noise, from random tensors; the last
+     samples are pure noise, for which estimation is harder */
+  dwi = AIR_CAST(double *, ndwi->data);
+  for (ii=0; ii<NN; ii++) {
+    ELL_3V_SET(eval, AIR_AFFINE(0, airDrandMT(), 1, 0.5, 2.0),
+               AIR_AFFINE(0, airDrandMT(), 1, 0.2, 0.8),
+               AIR_AFFINE(0, airDrandMT(), 1, 0.1, 0.4));
+    ELL_3V_SCALE(eval, 0.001, eval);
+    ELL_4V_SET(qq, airDrandMT() - 0.5, airDrandMT() - 0.5,
+               airDrandMT() - 0.5, airDrandMT() - 0.5);
+    ELL_4V_NORM(qq, qq, len);
+    ell_q_to_3m_d(evec, qq);
+    tenMakeSingle_d(ten, 1.0, eval, evec);
+    B0 = ii < NN - 20 ? AIR_AFFINE(0, airDrandMT(), 1, 200, 1000) : 0;
+    for (gi=0; gi<GRAD_NUM; gi++) {
+      ELL_3V_COPY(gg, AIR_CAST(double *, ngrad->data) + 3*gi);
+      dot = TEN_T3V_CONTR(ten, gg);
+      airNormalRand(&nr, &ni);
+      dot = B0*exp(-1000*dot);
+      dwi[gi + GRAD_NUM*ii] = sqrt((dot + 5*nr)*(dot + 5*nr) + 25*ni*ni);
+    }
+  }
+
+  for (method=tenEstimate1MethodLLS; method<=tenEstimate1MethodMLE;
+       method++) {
+    if (estimate(nten[0], nB0 + 0, nterr + 0, ndwi, ngrad, method, 1, mop)
+        || estimate(nten[1], nB0 + 1, nterr + 1, ndwi, ngrad, method, 3, mop)
+        || differ(me, "ten", method, nten[0], nten[1])
+        || differ(me, "B0", method, nB0[0], nB0[1])
+        || differ(me, "err", method, nterr[0], nterr[1])
+        || (tenEstimate1MethodLLS == method
+            && single(me, method, 0, nten[0], nB0[0], nterr[0],
+                      ndwi, ngrad, mop))
+        || (tenEstimate1MethodWLS == method
+            && single(me, method, 1e-10, nten[0], nB0[0], nterr[0],
+                      ndwi, ngrad, mop))) {
+      airMopError(mop); return 1;
+    }
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
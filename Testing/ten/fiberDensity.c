@@ -0,0 +1,273 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "teem/ten.h"
+#include <testDataPath.h>
+
+/*
+** Tests:
+** tenFiberDensity, tenFiberConnectivity: in a field of linear tensors
+** along X, every fiber is a straight line along X through the center of
+** its voxel row, from one end of the volume to the other, so the density
+** and the connectivity between labels at the two ends are known.  The
+** results have to be the same with any number of threads, from a
+** tenFiberMulti or a tenFiberStream, and with the vertices in index or in
+** (here, the same) world space.
+*/
+
+#define SX 16
+#define SY 8
+#define SZ 8
+#define SUPER 3
+
+static const char fname[] = "fiberDensity.nhdr",
+  dname[] = "fiberDensity.raw",
+  oname[] = "fiberDensity-offset.nrrd";
+
+/* the two matrices have to match, with lengths up to a tolerance */
+static int
+matCompare(const char *me, const char *what, const Nrrd *nc0,
+           const Nrrd *nl0, const Nrrd *nc1, const Nrrd *nl1) {
+  const unsigned int *c0, *c1;
+  const double *l0, *l1;
+  size_t ii, NN;
+
+  NN = nrrdElementNumber(nc0);
+  c0 = AIR_CAST(const unsigned int *, nc0->data);
+  c1 = AIR_CAST(const unsigned int *, nc1->data);
+  l0 = AIR_CAST(const double *, nl0->data);
+  l1 = AIR_CAST(const double *, nl1->data);
+  if (NN != nrrdElementNumber(nc1)) {
+    fprintf(stderr, "%s: %s: matrix size differs\n", me, what);
+    return 1;
+  }
+  for (ii=0; ii<NN; ii++) {
+    if (c0[ii] != c1[ii] || fabs(l0[ii] - l1[ii]) > 1e-4) {
+      fprintf(stderr, "%s: %s: entry %u: (%u,%g) != (%u,%g)\n", me, what,
+              AIR_CAST(unsigned int, ii), c0[ii], l0[ii], c1[ii], l1[ii]);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int
+main(int argc, const char **argv) {
+  const char *me;
+  char *err;
+  airArray *mop;
+  tenFiberContext *tfx;
+  tenFiberMulti *tfml;
+  tenFiberStream *tfst;
+  Nrrd *nten, *nseed, *nlabel, *ndens[4], *ncnt[3], *nlen[3];
+  float *ten;
+  double *seed, nanv[3], orig[3], xx[3], yy[3], zz[3], len;
+  unsigned char *label;
+  const unsigned int *dens, *cnt;
+  unsigned int xi, yi, zi, si, ti, LL, sum, want;
+  size_t ii, NN;
+  int E;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+
+  nten = nrrdNew();
+  airMopAdd(mop, nten, (airMopper)nrrdNuke, airMopAlways);
+  nseed = nrrdNew();
+  airMopAdd(mop, nseed, (airMopper)nrrdNuke, airMopAlways);
+  nlabel = nrrdNew();
+  airMopAdd(mop, nlabel, (airMopper)nrrdNuke, airMopAlways);
+  for (ti=0; ti<4; ti++) {
+    ndens[ti] = nrrdNew();
+    airMopAdd(mop, ndens[ti], (airMopper)nrrdNuke, airMopAlways);
+  }
+  for (ti=0; ti<3; ti++) {
+    ncnt[ti] = nrrdNew();
+    airMopAdd(mop, ncnt[ti], (airMopper)nrrdNuke, airMopAlways);
+    nlen[ti] = nrrdNew();
+    airMopAdd(mop, nlen[ti], (airMopper)nrrdNuke, airMopAlways);
+  }
+  airMopAdd(mop, AIR_CAST(char *, fname), testRemoveMop, airMopAlways);
+  airMopAdd(mop, AIR_CAST(char *, dname), testRemoveMop, airMopAlways);
+  airMopAdd(mop, AIR_CAST(char *, oname), testRemoveMop, airMopAlways);
+  if (nrrdMaybeAlloc_va(nten, nrrdTypeFloat, 4, AIR_CAST(size_t, 7),
+                        AIR_CAST(size_t, SX), AIR_CAST(size_t, SY),
+                        AIR_CAST(size_t, SZ))
+      || nrrdMaybeAlloc_va(nseed, nrrdTypeDouble, 2, AIR_CAST(size_t, 3),
+                           AIR_CAST(size_t, 2*SY*SZ))
+      || nrrdMaybeAlloc_va(nlabel, nrrdTypeUChar, 3, AIR_CAST(size_t, SX),
+                           AIR_CAST(size_t, SY), AIR_CAST(size_t, SZ))) {
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  /* world space is index space */
+  nten->axis[0].kind = nrrdKind3DMaskedSymMatrix;
+  ELL_3V_SET(nanv, AIR_NAN, AIR_NAN, AIR_NAN);
+  ELL_3V_SET(orig, 0, 0, 0);
+  ELL_3V_SET(xx, 1, 0, 0);
+  ELL_3V_SET(yy, 0, 1, 0);
+  ELL_3V_SET(zz, 0, 0, 1);
+  nrrdSpaceDimensionSet(nten, 3);
+  nrrdSpaceOriginSet(nten, orig);
+  nrrdAxisInfoSet_va(nten, nrrdAxisInfoSpaceDirection, nanv, xx, yy, zz);
+  nrrdAxisInfoSet_va(nten, nrrdAxisInfoCenter, nrrdCenterUnknown,
+                     nrrdCenterCell, nrrdCenterCell, nrrdCenterCell);
+  nrrdSpaceDimensionSet(nlabel, 3);
+  nrrdSpaceOriginSet(nlabel, orig);
+  nrrdAxisInfoSet_va(nlabel, nrrdAxisInfoSpaceDirection, xx, yy, zz);
+  nrrdAxisInfoSet_va(nlabel, nrrdAxisInfoCenter,
+                     nrrdCenterCell, nrrdCenterCell, nrrdCenterCell);
+
+  /* linear tensors along X; label 1 at the low end of X, and at the high
+     end label 2 for low Y, and label 3 for high Y */
+  ten = AIR_CAST(float *, nten->data);
+  label = AIR_CAST(unsigned char *, nlabel->data);
+  for (zi=0; zi<SZ; zi++) {
+    for (yi=0; yi<SY; yi++) {
+      for (xi=0; xi<SX; xi++) {
+        ii = xi + SX*(yi + SY*zi);
+        TEN_T_SET(ten + 7*ii, 1.0f, 0.0017f, 0, 0, 0.0003f, 0, 0.0003f);
+        label[ii] = (xi < 2
+                     ? 1
+                     : (xi >= SX - 2 ? (yi < SY/2 ? 2 : 3) : 0));
+      }
+    }
+  }
+  /* two seeds in every row along X */
+  seed = AIR_CAST(double *, nseed->data);
+  si = 0;
+  for (zi=0; zi<SZ; zi++) {
+    for (yi=0; yi<SY; yi++) {
+      ELL_3V_SET(seed + 3*si, 5.3, yi, zi); si++;
+      ELL_3V_SET(seed + 3*si, 9.8, yi, zi); si++;
+    }
+  }
+
+  tfml = tenFiberMultiNew();
+  airMopAdd(mop, tfml, (airMopper)tenFiberMultiNix, airMopAlways);
+  tfst = tenFiberStreamNew();
+  airMopAdd(mop, tfst, (airMopper)tenFiberStreamNix, airMopAlways);
+  E = 0;
+  if (!E) E |= !(tfx = tenFiberContextNew(nten));
+  if (!E) airMopAdd(mop, tfx, (airMopper)tenFiberContextNix, airMopAlways);
+  if (!E) E |= tenFiberTypeSet(tfx, tenFiberTypeEvec0);
+  if (!E) E |= tenFiberStopSet(tfx, tenFiberStopAniso, tenAniso_FA, 0.2);
+  if (!E) E |= tenFiberStopSet(tfx, tenFiberStopNumSteps, 100);
+  if (!E) E |= tenFiberParmSet(tfx, tenFiberParmStepSize, 0.5);
+  if (!E) E |= tenFiberParmSet(tfx, tenFiberParmUseIndexSpace, AIR_TRUE);
+  if (!E) E |= tenFiberUpdate(tfx);
+  if (!E) E |= tenFiberMultiTrace(tfx, tfml, nseed);
+  if (!E) E |= tenFiberStreamOpen(tfst, fname, AIR_FALSE, 0);
+  for (si=0; !E && si<tfml->fiberNum; si++) {
+    E |= tenFiberStreamAdd(tfst, tfml->fiber + si);
+  }
+  if (!E) E |= tenFiberStreamClose(tfst);
+  if (!E) E |= tenFiberStreamMap(tfst, fname);
+  if (!E) E |= tenFiberDensity(ndens[0], tfml, NULL, nten, AIR_TRUE,
+                               SUPER, 1);
+  if (!E) E |= tenFiberDensity(ndens[1], tfml, NULL, nten, AIR_TRUE,
+                               SUPER, 3);
+  if (!E) E |= tenFiberDensity(ndens[2], NULL, tfst, nten, AIR_TRUE,
+                               SUPER, 2);
+  if (!E) E |= tenFiberDensity(ndens[3], tfml, NULL, nten, AIR_FALSE,
+                               SUPER, 1);
+  if (!E) E |= tenFiberConnectivity(ncnt[0], nlen[0], tfml, NULL, nlabel,
+                                    AIR_TRUE, 1);
+  if (!E) E |= tenFiberConnectivity(ncnt[1], nlen[1], tfml, NULL, nlabel,
+                                    AIR_TRUE, 3);
+  if (!E) E |= tenFiberConnectivity(ncnt[2], nlen[2], NULL, tfst, nlabel,
+                                    AIR_FALSE, 2);
+  if (E) {
+    airMopAdd(mop, err = biffGetDone(TEN), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  if (tfml->fiberNum != 2*SY*SZ) {
+    fprintf(stderr, "%s: got %u fibers, not %u\n", me, tfml->fiberNum,
+            2*SY*SZ);
+    airMopError(mop); return 1;
+  }
+
+  NN = nrrdElementNumber(ndens[0]);
+  if (NN != SUPER*SX*SUPER*SY*SUPER*SZ) {
+    fprintf(stderr, "%s: density has %u voxels, not %u\n", me,
+            AIR_CAST(unsigned int, NN), SUPER*SX*SUPER*SY*SUPER*SZ);
+    airMopError(mop); return 1;
+  }
+  for (ti=1; ti<4; ti++) {
+    if (memcmp(ndens[0]->data, ndens[ti]->data, NN*sizeof(unsigned int))) {
+      fprintf(stderr, "%s: density %u differs from density 0\n", me, ti);
+      airMopError(mop); return 1;
+    }
+  }
+  /* the two fibers of each row go through the row's finer voxels on the
+     center line of the row, and nowhere else */
+  dens = AIR_CAST(const unsigned int *, ndens[0]->data);
+  sum = 0;
+  for (ii=0; ii<NN; ii++) {
+    sum += dens[ii];
+  }
+  want = 0;
+  for (zi=0; zi<SZ; zi++) {
+    for (yi=0; yi<SY; yi++) {
+      for (xi=1; xi+1<SUPER*SX; xi++) {
+        ii = xi + SUPER*SX*(SUPER*yi + 1 + SUPER*SY*(SUPER*zi + 1));
+        if (2 != dens[ii]) {
+          fprintf(stderr, "%s: density %u (not 2) at (%u,%u,%u)\n", me,
+                  dens[ii], xi, SUPER*yi + 1, SUPER*zi + 1);
+          airMopError(mop); return 1;
+        }
+        want += 2;
+      }
+    }
+  }
+  if (!( want <= sum && sum <= want + 2*2*SY*SZ )) {
+    fprintf(stderr, "%s: density sum %u not in [%u,%u]\n", me, sum, want,
+            want + 2*2*SY*SZ);
+    airMopError(mop); return 1;
+  }
+
+  if (matCompare(me, "3 threads", ncnt[0], nlen[0], ncnt[1], nlen[1])
+      || matCompare(me, "stream", ncnt[0], nlen[0], ncnt[2], nlen[2])) {
+    airMopError(mop); return 1;
+  }
+  LL = AIR_CAST(unsigned int, ncnt[0]->axis[0].size);
+  cnt = AIR_CAST(const unsigned int *, ncnt[0]->data);
+  len = AIR_CAST(const double *, nlen[0]->data)[1 + LL*2];
+  if (!( 4 == LL
+         && SY*SZ == cnt[1 + LL*2] && SY*SZ == cnt[2 + LL*1]
+         && SY*SZ == cnt[1 + LL*3] && SY*SZ == cnt[3 + LL*1]
+         && 0 == cnt[0] && 0 == cnt[2 + LL*3] && 0 == cnt[1 + LL*1]
+         && SX - 2 < len && len <= SX )) {
+    fprintf(stderr, "%s: wrong connectivity: %u labels, (1,2) %u (1,3) %u "
+            "(0,0) %u (2,3) %u (1,1) %u; length %g\n", me, LL,
+            cnt[1 + LL*2], cnt[1 + LL*3], cnt[0], cnt[2 + LL*3],
+            cnt[1 + LL*1], len);
+    airMopError(mop); return 1;
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
@@ -0,0 +1,224 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "teem/ten.h"
+#include "fiberTest.h"
+
+/*
+** Tests:
+** tenFiberParmDirCache: tracing with the direction cache has to follow
+** (closely, since it interpolates eigenvectors rather than tensors) the
+** fibers traced by probing with gage, has to give the same fibers with
+** any number of threads, and has to only compute bricks that are needed
+*/
+
+#define SX 20
+#define SY 18
+#define SZ 6
+#define SEED_NUM 200
+/* largest allowed distance between cached and probed fiber vertices */
+#define DIST_MAX 0.25
+
+/* traces from nseed into tfml, with cache and threads as given */
+static int
+trace(const char *me, tenFiberMulti *tfml, tenFiberContext **tfxP,
+      const Nrrd *nten, const Nrrd *nseed, unsigned int threadNum,
+      int dirCache, airArray *mop) {
+  char *err;
+
+  if (!(*tfxP = fiberTestContext(nten, threadNum, 100, tenGageFA,
+                                  dirCache, mop))
+      || tenFiberMultiTrace(*tfxP, tfml, nseed)) {
+    airMopAdd(mop, err = biffGetDone(TEN), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble tracing (%u threads, cache %d):\n%s", me,
+            threadNum, dirCache, err);
+    return 1;
+  }
+  return 0;
+}
+
+/* the index of the seed point among the vertices of tfbs */
+static unsigned int
+seedFind(const tenFiberSingle *tfbs) {
+  const double *vert;
+  unsigned int vi, ret;
+  double dd, best;
+
+  vert = AIR_CAST(const double *, tfbs->nvert->data);
+  ret = 0;
+  best = DBL_MAX;
+  for (vi=0; vi<tfbs->nvert->axis[1].size; vi++) {
+    dd = ELL_3V_DIST(vert + 3*vi, tfbs->seedPos);
+    if (dd < best) {
+      best = dd;
+      ret = vi;
+    }
+  }
+  return ret;
+}
+
+/* the largest distance between vertices of tfbs and ref, out to the
+   shorter of the two on each side of the seed.  Eigenvectors have no
+   sign, so the fiber halves may be in either order */
+static double
+distance(const tenFiberSingle *tfbs, const tenFiberSingle *ref) {
+  const double *vv, *rr;
+  double dist[2], dd;
+  unsigned int num, vnum, rnum, vseed, rseed, ki, flip;
+  int sgn;
+
+  vseed = seedFind(tfbs);
+  rseed = seedFind(ref);
+  vv = AIR_CAST(const double *, tfbs->nvert->data) + 3*vseed;
+  rr = AIR_CAST(const double *, ref->nvert->data) + 3*rseed;
+  vnum = AIR_CAST(unsigned int, tfbs->nvert->axis[1].size);
+  rnum = AIR_CAST(unsigned int, ref->nvert->axis[1].size);
+  for (flip=0; flip<2; flip++) {
+    dist[flip] = 0;
+    for (sgn=-1; sgn<=1; sgn+=2) {
+      num = AIR_MIN(sgn > 0 ? vnum - 1 - vseed : vseed,
+                    (sgn > 0) != !!flip ? rnum - 1 - rseed : rseed);
+      for (ki=0; ki<=num; ki++) {
+        int vi = sgn*AIR_CAST(int, ki), ri = flip ? -vi : vi;
+        dd = ELL_3V_DIST(vv + 3*vi, rr + 3*ri);
+        dist[flip] = AIR_MAX(dist[flip], dd);
+      }
+    }
+  }
+  return AIR_MIN(dist[0], dist[1]);
+}
+
+int
+main(int argc, const char **argv) {
+  const char *me;
+  char *err;
+  airArray *mop;
+  Nrrd *nten, *nseed, *nseed1;
+  tenFiberContext *tfx;
+  tenFiberMulti *tfml, *tfmlC1, *tfmlC3;
+  tenFiberSingle *aa, *bb;
+  double tt[2], dist;
+  unsigned int fi, started, bnum;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+
+  airSrandMT(4242);
+  nten = nrrdNew();
+  airMopAdd(mop, nten, (airMopper)nrrdNuke, airMopAlways);
+  nseed = nrrdNew();
+  airMopAdd(mop, nseed, (airMopper)nrrdNuke, airMopAlways);
+  nseed1 = nrrdNew();
+  airMopAdd(mop, nseed1, (airMopper)nrrdNuke, airMopAlways);
+  tfml = tenFiberMultiNew();
+  airMopAdd(mop, tfml, (airMopper)tenFiberMultiNix, airMopAlways);
+  tfmlC1 = tenFiberMultiNew();
+  airMopAdd(mop, tfmlC1, (airMopper)tenFiberMultiNix, airMopAlways);
+  tfmlC3 = tenFiberMultiNew();
+  airMopAdd(mop, tfmlC3, (airMopper)tenFiberMultiNix, airMopAlways);
+  if (!( tfml && tfmlC1 && tfmlC3 )) {
+    airMopAdd(mop, err = biffGetDone(TEN), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  if (fiberTestVolume(nten, nseed, SX, SY, SZ, SEED_NUM)
+      || nrrdMaybeAlloc_va(nseed1, nrrdTypeDouble, 2, AIR_CAST(size_t, 3),
+                           AIR_CAST(size_t, 1))) {
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  ELL_3V_SET(AIR_CAST(double *, nseed1->data), 2.0, 2.0, 2.0);
+
+  /* a short fiber in the corner only needs the bricks around it */
+  if (!(tfx = fiberTestContext(nten, 1, 5, tenGageFA, AIR_TRUE, mop))
+      || tenFiberMultiTrace(tfx, tfml, nseed1)) {
+    airMopAdd(mop, err = biffGetDone(TEN), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble tracing in corner:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  bnum = ((SX + 7)/8)*((SY + 7)/8)*((SZ + 7)/8);
+  if (!( tfx->dcache->brickMade && tfx->dcache->brickMade < bnum )) {
+    fprintf(stderr, "%s: made %u bricks, not in (0,%u)\n", me,
+            AIR_CAST(unsigned int, tfx->dcache->brickMade), bnum);
+    airMopError(mop); return 1;
+  }
+
+  if (trace(me, tfml, &tfx, nten, nseed, 1, AIR_FALSE, mop)
+      || trace(me, tfmlC3, &tfx, nten, nseed, 3, AIR_TRUE, mop)
+      || trace(me, tfmlC1, &tfx, nten, nseed, 1, AIR_TRUE, mop)) {
+    airMopError(mop); return 1;
+  }
+  started = 0;
+  for (fi=0; fi<SEED_NUM; fi++) {
+    aa = tfmlC1->fiber + fi;
+    bb = tfmlC3->fiber + fi;
+    if (aa->whyNowhere != bb->whyNowhere
+        || (tenFiberStopUnknown == aa->whyNowhere
+            && (aa->nvert->axis[1].size != bb->nvert->axis[1].size
+                || memcmp(aa->nvert->data, bb->nvert->data,
+                          nrrdElementSize(aa->nvert)
+                          *nrrdElementNumber(aa->nvert))
+                || memcmp(aa->nval->data, bb->nval->data,
+                          nrrdElementSize(aa->nval)
+                          *nrrdElementNumber(aa->nval))))) {
+      fprintf(stderr, "%s: fiber %u differs with 3 threads\n", me, fi);
+      airMopError(mop); return 1;
+    }
+    bb = tfml->fiber + fi;
+    if (tenFiberStopUnknown != aa->whyNowhere
+        || tenFiberStopUnknown != bb->whyNowhere) {
+      continue;
+    }
+    /* near the isotropic middle, interpolating eigenvectors is too
+       different from interpolating tensors to compare */
+    ELL_2V_SET(tt, aa->seedPos[0] - (SX-1)/2.0,
+               aa->seedPos[1] - (SY-1)/2.0);
+    if (ELL_2V_LEN(tt) < 4) {
+      continue;
+    }
+    started++;
+    if (aa->nval->axis[1].size != aa->nvert->axis[1].size) {
+      fprintf(stderr, "%s: fiber %u has %u values for %u vertices\n", me,
+              fi, AIR_CAST(unsigned int, aa->nval->axis[1].size),
+              AIR_CAST(unsigned int, aa->nvert->axis[1].size));
+      airMopError(mop); return 1;
+    }
+    dist = distance(aa, bb);
+    if (!( dist <= DIST_MAX )) {
+      fprintf(stderr, "%s: fiber %u is %g > %g from probed fiber\n", me,
+              fi, dist, DIST_MAX);
+      airMopError(mop); return 1;
+    }
+  }
+  /* the test is meaningless if fibers don't go anywhere */
+  if (!( started > SEED_NUM/2 )) {
+    fprintf(stderr, "%s: only %u/%u fibers started\n", me, started,
+            SEED_NUM);
+    airMopError(mop); return 1;
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
@@ -0,0 +1,282 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "teem/ten.h"
+
+/*
+** Tests:
+** tenFiberIndexBuild, tenFiberIndexSelect, tenFiberIndexNearest: on
+** random walk fibers, the index has to be the same with any number of
+** threads, and the queries have to find the same fibers as looking at
+** every segment of every fiber
+*/
+
+#define FIBER_NUM 400
+#define VERT_MAX 40
+#define SIZE 20
+#define QUERY_NUM 50
+
+/* squared distance from pos to the segment from v0 to v1 */
+static double
+segDist2(const double pos[3], const float v0[3], const float v1[3]) {
+  double dd[3], pp[3], len2, tt;
+
+  ELL_3V_SUB(dd, v1, v0);
+  ELL_3V_SUB(pp, pos, v0);
+  len2 = ELL_3V_DOT(dd, dd);
+  tt = len2 ? AIR_CLAMP(0, ELL_3V_DOT(pp, dd)/len2, 1) : 0;
+  ELL_3V_SCALE_INCR(pp, -tt, dd);
+  return ELL_3V_DOT(pp, pp);
+}
+
+/* the index's copy of the vertices of fiber fi */
+static const float *
+fiberVert(unsigned int *vertNumP, const tenFiberIndex *tfix,
+          unsigned int fi) {
+
+  *vertNumP = AIR_CAST(unsigned int,
+                       tfix->vertStart[fi+1] - tfix->vertStart[fi]);
+  return tfix->vert + 3*tfix->vertStart[fi];
+}
+
+/* whether fiber fi goes through the region, by looking at all of it */
+static int
+regionHit(const tenFiberIndex *tfix, unsigned int fi,
+          const tenFiberRegion *rgn) {
+  const float *vert;
+  const unsigned char *mask;
+  unsigned int vi, vertNum, ai;
+  int vv[3], in;
+
+  vert = fiberVert(&vertNum, tfix, fi);
+  for (vi=0; vi<vertNum; vi++) {
+    if (rgn->nmask) {
+      mask = AIR_CAST(const unsigned char *, rgn->nmask->data);
+      in = AIR_TRUE;
+      for (ai=0; ai<3; ai++) {
+        vv[ai] = AIR_CAST(int, floor(vert[ai + 3*vi] + 0.5));
+        in &= (-0.5 <= vert[ai + 3*vi] && vv[ai] < SIZE);
+      }
+      if (in && mask[vv[0] + SIZE*(vv[1] + SIZE*vv[2])]) {
+        return AIR_TRUE;
+      }
+    } else {
+      if (segDist2(rgn->center, vert + 3*vi,
+                   vert + 3*(vi + 1 < vertNum ? vi + 1 : vi))
+          <= rgn->radius*rgn->radius) {
+        return AIR_TRUE;
+      }
+    }
+  }
+  return AIR_FALSE;
+}
+
+/* compares the selection against looking at every fiber */
+static int
+selectCheck(const char *me, const tenFiberIndex *tfix,
+       const tenFiberRegion *region, unsigned int regionNum, airArray *mop) {
+  Nrrd *nlist;
+  const unsigned int *list;
+  unsigned int fi, ri, li, listNum;
+  char *err;
+  int want;
+
+  nlist = nrrdNew();
+  airMopAdd(mop, nlist, (airMopper)nrrdNuke, airMopAlways);
+  if (tenFiberIndexSelect(nlist, tfix, region, regionNum, AIR_FALSE)) {
+    airMopAdd(mop, err = biffGetDone(TEN), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble selecting:\n%s", me, err);
+    return 1;
+  }
+  list = AIR_CAST(const unsigned int *, nlist->data);
+  listNum = nlist->dim ? AIR_CAST(unsigned int, nlist->axis[0].size) : 0;
+  li = 0;
+  for (fi=0; fi<tfix->fiberNum; fi++) {
+    want = AIR_TRUE;
+    for (ri=0; ri<regionNum; ri++) {
+      if (region[ri].exclude == regionHit(tfix, fi, region + ri)) {
+        want = AIR_FALSE;
+      }
+    }
+    if (want != (li < listNum && list[li] == fi)) {
+      fprintf(stderr, "%s: fiber %u %s but %s selected (%u regions)\n",
+              me, fi, want ? "should be" : "shouldn't be",
+              want ? "wasn't" : "was", regionNum);
+      return 1;
+    }
+    li += want;
+  }
+  return 0;
+}
+
+int
+main(int argc, const char **argv) {
+  const char *me;
+  char *err;
+  airArray *mop;
+  limnPolyData *lpld;
+  tenFiberIndex *tfix, *tfix3;
+  tenFiberRegion region[3];
+  Nrrd *nmask;
+  unsigned char *mask;
+  double pos[3], step[3], dist, best2, dd, orig[3], xx[3], yy[3], zz[3];
+  const float *vert;
+  unsigned int fi, vi, qi, ii, vertNum, icnt[FIBER_NUM], fiberIdx,
+    bestFi, xi, yi, zi;
+  size_t cellNum;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+
+  airSrandMT(4242);
+  lpld = limnPolyDataNew();
+  airMopAdd(mop, lpld, (airMopper)limnPolyDataNix, airMopAlways);
+  tfix = tenFiberIndexNew();
+  airMopAdd(mop, tfix, (airMopper)tenFiberIndexNix, airMopAlways);
+  tfix3 = tenFiberIndexNew();
+  airMopAdd(mop, tfix3, (airMopper)tenFiberIndexNix, airMopAlways);
+  nmask = nrrdNew();
+  airMopAdd(mop, nmask, (airMopper)nrrdNuke, airMopAlways);
+
+  /* random walks, the first of which is a single vertex */
+  vertNum = 0;
+  for (fi=0; fi<FIBER_NUM; fi++) {
+    icnt[fi] = fi ? 2 + airRandInt(VERT_MAX - 1) : 1;
+    vertNum += icnt[fi];
+  }
+  if (limnPolyDataAlloc(lpld, 0, vertNum, vertNum, FIBER_NUM)
+      || nrrdMaybeAlloc_va(nmask, nrrdTypeUChar, 3, AIR_CAST(size_t, SIZE),
+                           AIR_CAST(size_t, SIZE), AIR_CAST(size_t, SIZE))) {
+    fprintf(stderr, "%s: trouble allocating\n", me);
+    airMopError(mop); return 1;
+  }
+  ii = 0;
+  for (fi=0; fi<FIBER_NUM; fi++) {
+    lpld->type[fi] = limnPrimitiveLineStrip;
+    lpld->icnt[fi] = icnt[fi];
+    ELL_3V_SET(pos, SIZE*airDrandMT(), SIZE*airDrandMT(),
+               SIZE*airDrandMT());
+    ELL_3V_SET(step, airDrandMT() - 0.5, airDrandMT() - 0.5,
+               airDrandMT() - 0.5);
+    for (vi=0; vi<icnt[fi]; vi++, ii++) {
+      ELL_4V_SET_TT(lpld->xyzw + 4*ii, float, pos[0], pos[1], pos[2], 1);
+      lpld->indx[ii] = ii;
+      step[0] += 0.3*(airDrandMT() - 0.5);
+      step[1] += 0.3*(airDrandMT() - 0.5);
+      step[2] += 0.3*(airDrandMT() - 0.5);
+      ELL_3V_INCR(pos, step);
+    }
+  }
+  /* a box mask, in a volume with world space the same as index space */
+  ELL_3V_SET(orig, 0, 0, 0);
+  ELL_3V_SET(xx, 1, 0, 0);
+  ELL_3V_SET(yy, 0, 1, 0);
+  ELL_3V_SET(zz, 0, 0, 1);
+  nrrdSpaceDimensionSet(nmask, 3);
+  nrrdSpaceOriginSet(nmask, orig);
+  nrrdAxisInfoSet_va(nmask, nrrdAxisInfoSpaceDirection, xx, yy, zz);
+  nrrdAxisInfoSet_va(nmask, nrrdAxisInfoCenter,
+                     nrrdCenterCell, nrrdCenterCell, nrrdCenterCell);
+  mask = AIR_CAST(unsigned char *, nmask->data);
+  for (zi=0; zi<SIZE; zi++) {
+    for (yi=0; yi<SIZE; yi++) {
+      for (xi=0; xi<SIZE; xi++) {
+        mask[xi + SIZE*(yi + SIZE*zi)] = (AIR_IN_CL(4, xi, 7)
+                                          && AIR_IN_CL(10, yi, 12)
+                                          && AIR_IN_CL(2, zi, 16));
+      }
+    }
+  }
+
+  if (tenFiberIndexBuild(tfix, NULL, NULL, lpld, 0, 1)
+      || tenFiberIndexBuild(tfix3, NULL, NULL, lpld, 0, 3)) {
+    airMopAdd(mop, err = biffGetDone(TEN), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble building:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  cellNum = AIR_CAST(size_t, tfix->size[0])*tfix->size[1]*tfix->size[2];
+  if (!( tfix->vertNum == vertNum
+         && cellNum == (AIR_CAST(size_t, tfix3->size[0])*tfix3->size[1]
+                        *tfix3->size[2])
+         && !memcmp(tfix->vert, tfix3->vert, 3*vertNum*sizeof(float))
+         && !memcmp(tfix->cellStart, tfix3->cellStart,
+                    (cellNum+1)*sizeof(size_t))
+         && !memcmp(tfix->seg, tfix3->seg,
+                    tfix->cellStart[cellNum]*sizeof(size_t)) )) {
+    fprintf(stderr, "%s: index differs with 3 threads\n", me);
+    airMopError(mop); return 1;
+  }
+
+  /* spheres, alone and with an exclusion sphere, and the mask */
+  for (qi=0; qi<QUERY_NUM; qi++) {
+    for (ii=0; ii<2; ii++) {
+      region[ii].nmask = NULL;
+      ELL_3V_SET(region[ii].center, SIZE*airDrandMT(), SIZE*airDrandMT(),
+                 SIZE*airDrandMT());
+      region[ii].radius = 4*airDrandMT();
+      region[ii].exclude = ii;
+    }
+    region[2].nmask = nmask;
+    region[2].exclude = qi % 2;
+    if (selectCheck(me, tfix, region, 1, mop)
+        || selectCheck(me, tfix, region, 2, mop)
+        || selectCheck(me, tfix, region, 3, mop)
+        || selectCheck(me, tfix, region + 1, 2, mop)) {
+      airMopError(mop); return 1;
+    }
+  }
+
+  /* nearest fibers, including from outside the fibers' bounding box */
+  for (qi=0; qi<QUERY_NUM; qi++) {
+    ELL_3V_SET(pos, 2*SIZE*airDrandMT() - SIZE/2,
+               2*SIZE*airDrandMT() - SIZE/2, 2*SIZE*airDrandMT() - SIZE/2);
+    if (tenFiberIndexNearest(&fiberIdx, &dist, tfix, pos, 0)) {
+      airMopAdd(mop, err = biffGetDone(TEN), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble finding nearest:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    best2 = AIR_POS_INF;
+    bestFi = UINT_MAX;
+    for (fi=0; fi<tfix->fiberNum; fi++) {
+      vert = fiberVert(&vertNum, tfix, fi);
+      for (vi=0; vi<vertNum; vi++) {
+        dd = segDist2(pos, vert + 3*vi,
+                      vert + 3*(vi + 1 < vertNum ? vi + 1 : vi));
+        if (dd < best2) {
+          best2 = dd;
+          bestFi = fi;
+        }
+      }
+    }
+    if (!( bestFi == fiberIdx && fabs(dist - sqrt(best2)) < 1e-9 )) {
+      fprintf(stderr, "%s: nearest to (%g,%g,%g) is %u at %g, not %u "
+              "at %g\n", me, pos[0], pos[1], pos[2], bestFi, sqrt(best2),
+              fiberIdx, dist);
+      airMopError(mop); return 1;
+    }
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
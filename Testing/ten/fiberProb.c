@@ -0,0 +1,249 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "teem/ten.h"
+
+/*
+** Tests:
+** tenEstimate1TensorBootstrap, tenFiberProbTrace: bootstrapping and
+** probabilistic tracking have to give the same results with any number
+** of threads, the bootstrap tensors have to vary, and walks in a field of
+** linear tensors along X have to stay near the line of the seeds
+*/
+
+#define SX 24
+#define SY 9
+#define SZ 9
+#define GRAD_NUM 13
+#define BOOT_NUM 20
+#define WALK_NUM 100
+#define SEED_NUM 3
+
+/* non-DWI first, then 12 directions (not normalized) */
+static const double
+gradList[3*GRAD_NUM] = {
+  0, 0, 0,
+  1, 0, 0,    0, 1, 0,    0, 0, 1,
+  1, 1, 0,    1, 0, 1,    0, 1, 1,
+  1, -1, 0,   1, 0, -1,   0, 1, -1,
+  1, 1, 1,    -1, 1, 1,   1, -1, 1
+};
+
+static const double
+seedList[3*SEED_NUM] = {6, 4, 4,   12, 4, 4,   18, 4, 4};
+
+/* bootstraps the tensors in ndwi with given threads into nboot */
+static int
+bootstrap(const char *me, Nrrd *nboot, const Nrrd *ndwi, const Nrrd *ngrad,
+          unsigned int threadNum, airArray *mop) {
+  tenEstimateContext *tec;
+  char *err;
+  int E;
+
+  tec = tenEstimateContextNew();
+  airMopAdd(mop, tec, (airMopper)tenEstimateContextNix, airMopAlways);
+  E = 0;
+  if (!E) E |= tenEstimateMethodSet(tec, tenEstimate1MethodLLS);
+  if (!E) E |= tenEstimateGradientsSet(tec, ngrad, 1000, AIR_TRUE);
+  if (!E) E |= tenEstimateValueMinSet(tec, 1.0);
+  if (!E) E |= tenEstimateThresholdSet(tec, 100, 0);
+  if (!E) E |= tenEstimateThreadNumSet(tec, threadNum);
+  if (!E) E |= tenEstimateUpdate(tec);
+  if (!E) E |= tenEstimate1TensorBootstrap(tec, nboot, ndwi, BOOT_NUM,
+                                           42, nrrdTypeDouble);
+  if (E) {
+    airMopAdd(mop, err = biffGetDone(TEN), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble bootstrapping with %u threads:\n%s", me,
+            threadNum, err);
+    return 1;
+  }
+  return 0;
+}
+
+/* probabilistic tracking in nboot with given threads into nvisit */
+static int
+track(const char *me, Nrrd *nvisit, const Nrrd *nten, const Nrrd *nboot,
+      const Nrrd *nseed, unsigned int threadNum, airArray *mop) {
+  tenFiberContext *tfx;
+  char *err;
+  int E;
+
+  E = 0;
+  if (!E) E |= !(tfx = tenFiberContextNew(nten));
+  if (!E) airMopAdd(mop, tfx, (airMopper)tenFiberContextNix, airMopAlways);
+  if (!E) E |= tenFiberTypeSet(tfx, tenFiberTypeEvec0);
+  if (!E) E |= tenFiberStopSet(tfx, tenFiberStopAniso, tenAniso_FA, 0.2);
+  if (!E) E |= tenFiberStopSet(tfx, tenFiberStopNumSteps, 100);
+  if (!E) E |= tenFiberStopSet(tfx, tenFiberStopRadius, 1.0);
+  if (!E) E |= tenFiberParmSet(tfx, tenFiberParmStepSize, 0.5);
+  if (!E) E |= tenFiberParmSet(tfx, tenFiberParmUseIndexSpace, AIR_TRUE);
+  if (!E) E |= tenFiberParmSet(tfx, tenFiberParmThreadNum, threadNum);
+  if (!E) E |= tenFiberUpdate(tfx);
+  if (!E) E |= tenFiberProbTrace(nvisit, tfx, nboot, nseed, WALK_NUM, 7);
+  if (E) {
+    airMopAdd(mop, err = biffGetDone(TEN), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble tracking with %u threads:\n%s", me,
+            threadNum, err);
+    return 1;
+  }
+  return 0;
+}
+
+int
+main(int argc, const char **argv) {
+  const char *me;
+  char *err;
+  airArray *mop;
+  Nrrd *nten, *ngrad, *ndwi, *nseed, *nboot1, *nboot3, *nvisit1,
+    *nvisit3;
+  float *ten;
+  double *dwi, dten[7], *gg, dot, nr, ni;
+  const unsigned int *vis;
+  unsigned int xi, si, gi, line, off;
+  size_t ii, NN;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+
+  airSrandMT(4242);
+  nten = nrrdNew();
+  airMopAdd(mop, nten, (airMopper)nrrdNuke, airMopAlways);
+  ngrad = nrrdNew();
+  airMopAdd(mop, ngrad, (airMopper)nrrdNuke, airMopAlways);
+  ndwi = nrrdNew();
+  airMopAdd(mop, ndwi, (airMopper)nrrdNuke, airMopAlways);
+  nseed = nrrdNew();
+  airMopAdd(mop, nseed, (airMopper)nrrdNix, airMopAlways);
+  nboot1 = nrrdNew();
+  airMopAdd(mop, nboot1, (airMopper)nrrdNuke, airMopAlways);
+  nboot3 = nrrdNew();
+  airMopAdd(mop, nboot3, (airMopper)nrrdNuke, airMopAlways);
+  nvisit1 = nrrdNew();
+  airMopAdd(mop, nvisit1, (airMopper)nrrdNuke, airMopAlways);
+  nvisit3 = nrrdNew();
+  airMopAdd(mop, nvisit3, (airMopper)nrrdNuke, airMopAlways);
+  NN = SX*SY*SZ;
+  if (nrrdMaybeAlloc_va(nten, nrrdTypeFloat, 4, AIR_CAST(size_t, 7),
+                        AIR_CAST(size_t, SX), AIR_CAST(size_t, SY),
+                        AIR_CAST(size_t, SZ))
+      || nrrdMaybeAlloc_va(ngrad, nrrdTypeDouble, 2,
+                           AIR_CAST(size_t, 3), AIR_CAST(size_t, GRAD_NUM))
+      || nrrdMaybeAlloc_va(ndwi, nrrdTypeDouble, 4,
+                           AIR_CAST(size_t, GRAD_NUM), AIR_CAST(size_t, SX),
+                           AIR_CAST(size_t, SY), AIR_CAST(size_t, SZ))
+      || nrrdWrap_va(nseed, AIR_CAST(void *, seedList), nrrdTypeDouble, 2,
+                     AIR_CAST(size_t, 3), AIR_CAST(size_t, SEED_NUM))) {
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  nten->axis[0].kind = nrrdKind3DMaskedSymMatrix;
+  /* world space is index space, so that steps are in voxels */
+  {
+    double nanv[3], orig[3], xx[3], yy[3], zz[3];
+    ELL_3V_SET(nanv, AIR_NAN, AIR_NAN, AIR_NAN);
+    ELL_3V_SET(orig, 0, 0, 0);
+    ELL_3V_SET(xx, 1, 0, 0);
+    ELL_3V_SET(yy, 0, 1, 0);
+    ELL_3V_SET(zz, 0, 0, 1);
+    nrrdSpaceDimensionSet(nten, 3);
+    nrrdSpaceOriginSet(nten, orig);
+    nrrdAxisInfoSet_va(nten, nrrdAxisInfoSpaceDirection, nanv, xx, yy, zz);
+    nrrdAxisInfoSet_va(nten, nrrdAxisInfoCenter, nrrdCenterUnknown,
+                       nrrdCenterCell, nrrdCenterCell, nrrdCenterCell);
+  }
+  /* normalized gradients */
+  for (gi=0; gi<GRAD_NUM; gi++) {
+    double *grad, len;
+    grad = AIR_CAST(double *, ngrad->data) + 3*gi;
+    ELL_3V_COPY(grad, gradList + 3*gi);
+    if (gi) {
+      ELL_3V_NORM(grad, grad, len);
+    }
+  }
+
+  /* linear tensors along X everywhere, and DWIs of them with Rician
+     noise */
+  TEN_T_SET(dten, 1.0, 0.0017, 0, 0, 0.0003, 0, 0.0003);
+  ten = AIR_CAST(float *, nten->data);
+  dwi = AIR_CAST(double *, ndwi->data);
+  for (ii=0; ii<NN; ii++) {
+    TEN_T_COPY(ten + 7*ii, dten);
+    for (gi=0; gi<GRAD_NUM; gi++) {
+      gg = AIR_CAST(double *, ngrad->data) + 3*gi;
+      dot = 1000*exp(-1000*TEN_T3V_CONTR(dten, gg));
+      airNormalRand(&nr, &ni);
+      dwi[gi + GRAD_NUM*ii] = sqrt((dot + 20*nr)*(dot + 20*nr)
+                                   + 400*ni*ni);
+    }
+  }
+
+  if (bootstrap(me, nboot1, ndwi, ngrad, 1, mop)
+      || bootstrap(me, nboot3, ndwi, ngrad, 3, mop)) {
+    airMopError(mop); return 1;
+  }
+  if (memcmp(nboot1->data, nboot3->data,
+             nrrdElementSize(nboot1)*nrrdElementNumber(nboot1))) {
+    fprintf(stderr, "%s: bootstrap differs with 3 threads\n", me);
+    airMopError(mop); return 1;
+  }
+  /* the first two bootstrap tensors at the first voxel */
+  if (!memcmp(nboot1->data, AIR_CAST(double *, nboot1->data) + 7,
+              7*sizeof(double))) {
+    fprintf(stderr, "%s: bootstrap tensors all the same\n", me);
+    airMopError(mop); return 1;
+  }
+
+  if (track(me, nvisit1, nten, nboot1, nseed, 1, mop)
+      || track(me, nvisit3, nten, nboot1, nseed, 3, mop)) {
+    airMopError(mop); return 1;
+  }
+  if (memcmp(nvisit1->data, nvisit3->data, NN*sizeof(unsigned int))) {
+    fprintf(stderr, "%s: visitation differs with 3 threads\n", me);
+    airMopError(mop); return 1;
+  }
+  vis = AIR_CAST(const unsigned int *, nvisit1->data);
+  for (si=0; si<SEED_NUM; si++) {
+    ii = AIR_CAST(size_t, seedList[0 + 3*si]
+                  + SX*(seedList[1 + 3*si] + SY*seedList[2 + 3*si]));
+    if (vis[ii] < WALK_NUM) {
+      fprintf(stderr, "%s: seed %u visited %u < %u times\n", me, si,
+              vis[ii], WALK_NUM);
+      airMopError(mop); return 1;
+    }
+  }
+  /* most visits are along the line of the seeds */
+  line = off = 0;
+  for (xi=0; xi<SX; xi++) {
+    line += vis[xi + SX*(4 + SY*4)];
+    off += vis[xi + SX*(0 + SY*4)] + vis[xi + SX*(4 + SY*0)];
+  }
+  if (!( line > 10*off && line > SX*WALK_NUM )) {
+    fprintf(stderr, "%s: %u visits along line, %u off it\n", me, line, off);
+    airMopError(mop); return 1;
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
@@ -0,0 +1,220 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "teem/ten.h"
+#include <testDataPath.h>
+#include "fiberTest.h"
+
+/*
+** Tests:
+** tenFiberStreamTrace, tenFiberStreamMap, tenFiberStreamGet,
+** tenFiberStreamPolyData: fibers and probed values streamed to disk
+** (with any number of threads) and mapped back have to be those from
+** tenFiberMultiTrace, converted to float or half float, and the stream
+** has to be plain nrrds, mapped (where there is mmap) rather than read.
+** tenFiberStreamClose: a stream with no fibers is still a stream.
+*/
+
+#define SX 20
+#define SY 18
+#define SZ 6
+#define SEED_NUM 200
+
+static const char fname[] = "fiberStream.nhdr",
+  dname[] = "fiberStream.raw",
+  oname[] = "fiberStream-offset.nrrd";
+
+/* what storing val in the stream gives back */
+static double
+stored(double val, int half) {
+  float fv;
+
+  fv = AIR_CAST(float, val);
+  return half ? airHalfToFloat(airHalfFromFloat(fv)) : fv;
+}
+
+/* streams with given threads and store, and compares with tfml */
+static int
+check(const char *me, const tenFiberMulti *tfml, const Nrrd *nten,
+      const Nrrd *nseed, unsigned int threadNum, int half, airArray *mop) {
+  tenFiberContext *tfx;
+  tenFiberStream *tfst;
+  tenFiberSingle *tfbs;
+  limnPolyData *lpld;
+  Nrrd *nvert, *nval;
+  unsigned int fi, si, vi, ci;
+  const double *vert, *val, *rvert, *rval;
+  char *err;
+
+  tfst = tenFiberStreamNew();
+  airMopAdd(mop, tfst, (airMopper)tenFiberStreamNix, airMopAlways);
+  nvert = nrrdNew();
+  airMopAdd(mop, nvert, (airMopper)nrrdNuke, airMopAlways);
+  nval = nrrdNew();
+  airMopAdd(mop, nval, (airMopper)nrrdNuke, airMopAlways);
+  lpld = limnPolyDataNew();
+  airMopAdd(mop, lpld, (airMopper)limnPolyDataNix, airMopAlways);
+  if (!(tfx = fiberTestContext(nten, threadNum, 200, tenGageFA,
+                               AIR_FALSE, mop))
+      || tenFiberStreamOpen(tfst, fname, half, 1)
+      || tenFiberStreamTrace(tfx, tfst, nseed)
+      || tenFiberStreamClose(tfst)
+      || tenFiberStreamMap(tfst, fname)
+      || tenFiberStreamPolyData(lpld, tfst)) {
+    airMopAdd(mop, err = biffGetDone(TEN), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble streaming with %u threads:\n%s", me,
+            threadNum, err);
+    return 1;
+  }
+#ifndef _WIN32
+  if (!( tfst->map[0] && tfst->map[1] )) {
+    fprintf(stderr, "%s: stream was read, not mapped\n", me);
+    return 1;
+  }
+#endif
+  fi = 0;
+  for (si=0; si<tfml->fiberNum; si++) {
+    tfbs = tfml->fiber + si;
+    if (tenFiberStopUnknown != tfbs->whyNowhere) {
+      continue;
+    }
+    if (!( fi < tfst->fiberNum )) {
+      fprintf(stderr, "%s: only %u fibers streamed\n", me, tfst->fiberNum);
+      return 1;
+    }
+    if (tenFiberStreamGet(nvert, nval, tfst, fi)) {
+      airMopAdd(mop, err = biffGetDone(TEN), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble getting fiber %u:\n%s", me, fi, err);
+      return 1;
+    }
+    if (!( nvert->axis[1].size == tfbs->nvert->axis[1].size
+           && lpld->icnt[fi] == nvert->axis[1].size )) {
+      fprintf(stderr, "%s: fiber %u has %u vertices, not %u\n", me, fi,
+              AIR_CAST(unsigned int, nvert->axis[1].size),
+              AIR_CAST(unsigned int, tfbs->nvert->axis[1].size));
+      return 1;
+    }
+    vert = AIR_CAST(const double *, nvert->data);
+    val = AIR_CAST(const double *, nval->data);
+    rvert = AIR_CAST(const double *, tfbs->nvert->data);
+    rval = AIR_CAST(const double *, tfbs->nval->data);
+    for (vi=0; vi<nvert->axis[1].size; vi++) {
+      for (ci=0; ci<3; ci++) {
+        if (vert[ci + 3*vi] != stored(rvert[ci + 3*vi], half)) {
+          fprintf(stderr, "%s: fiber %u vertex %u: %.17g != %.17g\n", me,
+                  fi, vi, vert[ci + 3*vi], rvert[ci + 3*vi]);
+          return 1;
+        }
+      }
+      if (val[vi] != stored(rval[vi], half)) {
+        fprintf(stderr, "%s: fiber %u value %u: %.17g != %.17g\n", me,
+                fi, vi, val[vi], rval[vi]);
+        return 1;
+      }
+    }
+    fi++;
+  }
+  if (fi != tfst->fiberNum) {
+    fprintf(stderr, "%s: streamed %u fibers, not %u\n", me,
+            tfst->fiberNum, fi);
+    return 1;
+  }
+  return 0;
+}
+
+int
+main(int argc, const char **argv) {
+  const char *me;
+  char *err;
+  airArray *mop;
+  Nrrd *nten, *nseed;
+  tenFiberContext *tfx;
+  tenFiberMulti *tfml;
+  tenFiberStream *tfst;
+  unsigned int fi, started;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+
+  airSrandMT(4242);
+  nten = nrrdNew();
+  airMopAdd(mop, nten, (airMopper)nrrdNuke, airMopAlways);
+  nseed = nrrdNew();
+  airMopAdd(mop, nseed, (airMopper)nrrdNuke, airMopAlways);
+  airMopAdd(mop, AIR_CAST(char *, fname), testRemoveMop, airMopAlways);
+  airMopAdd(mop, AIR_CAST(char *, dname), testRemoveMop, airMopAlways);
+  airMopAdd(mop, AIR_CAST(char *, oname), testRemoveMop, airMopAlways);
+  if (!(tfml = tenFiberMultiNew())) {
+    airMopAdd(mop, err = biffGetDone(TEN), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  airMopAdd(mop, tfml, (airMopper)tenFiberMultiNix, airMopAlways);
+  if (fiberTestVolume(nten, nseed, SX, SY, SZ, SEED_NUM)) {
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+
+  if (!(tfx = fiberTestContext(nten, 1, 200, tenGageFA, AIR_FALSE, mop))
+      || tenFiberMultiTrace(tfx, tfml, nseed)) {
+    airMopAdd(mop, err = biffGetDone(TEN), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble tracing:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  started = 0;
+  for (fi=0; fi<tfml->fiberNum; fi++) {
+    started += (tenFiberStopUnknown == tfml->fiber[fi].whyNowhere);
+  }
+  /* the test is meaningless if fibers don't go anywhere */
+  if (!( started > SEED_NUM/2 )) {
+    fprintf(stderr, "%s: only %u/%u fibers started\n", me, started,
+            SEED_NUM);
+    airMopError(mop); return 1;
+  }
+  if (check(me, tfml, nten, nseed, 1, AIR_FALSE, mop)
+      || check(me, tfml, nten, nseed, 3, AIR_FALSE, mop)
+      || check(me, tfml, nten, nseed, 3, AIR_TRUE, mop)) {
+    airMopError(mop); return 1;
+  }
+
+  /* a stream with no fibers */
+  tfst = tenFiberStreamNew();
+  airMopAdd(mop, tfst, (airMopper)tenFiberStreamNix, airMopAlways);
+  if (tenFiberStreamOpen(tfst, fname, AIR_TRUE, 1)
+      || tenFiberStreamClose(tfst)
+      || tenFiberStreamMap(tfst, fname)) {
+    airMopAdd(mop, err = biffGetDone(TEN), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble with empty stream:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  if (!( 0 == tfst->fiberNum && 0 == tfst->vertNum && tfst->half )) {
+    fprintf(stderr, "%s: empty stream has %u fibers, %u vertices\n", me,
+            tfst->fiberNum, AIR_CAST(unsigned int, tfst->vertNum));
+    airMopError(mop); return 1;
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
@@ -0,0 +1,120 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#ifndef FIBERTEST_HAS_BEEN_INCLUDED
+#define FIBERTEST_HAS_BEEN_INCLUDED
+
+/*
+** the volume and tracing context shared by the fiber tests
+*/
+
+/*
+** fiberTestVolume allocates and sets nten to a sx-by-sy-by-sz volume of
+** linear tensors along circles around the z axis, isotropic in the
+** middle, with some noise, and nseed to seedNum random (double) seed
+** points inside it, using airDrandMT.  Returns non-zero, with a biff
+** NRRD message, if allocation fails.
+*/
+static int
+fiberTestVolume(Nrrd *nten, Nrrd *nseed, unsigned int sx, unsigned int sy,
+                unsigned int sz, unsigned int seedNum) {
+  float *ten;
+  double tt[3], len, dten[7];
+  unsigned int xi, yi, zi, si;
+
+  if (nrrdMaybeAlloc_va(nten, nrrdTypeFloat, 4, AIR_CAST(size_t, 7),
+                        AIR_CAST(size_t, sx), AIR_CAST(size_t, sy),
+                        AIR_CAST(size_t, sz))
+      || nrrdMaybeAlloc_va(nseed, nrrdTypeDouble, 2, AIR_CAST(size_t, 3),
+                           AIR_CAST(size_t, seedNum))) {
+    return 1;
+  }
+  nten->axis[0].kind = nrrdKind3DMaskedSymMatrix;
+  nrrdAxisInfoSet_va(nten, nrrdAxisInfoSpacing, AIR_NAN, 1.0, 1.0, 1.0);
+  ten = AIR_CAST(float *, nten->data);
+  for (zi=0; zi<sz; zi++) {
+    for (yi=0; yi<sy; yi++) {
+      for (xi=0; xi<sx; xi++) {
+        ELL_3V_SET(tt, -(yi - (sy-1)/2.0), xi - (sx-1)/2.0,
+                   0.1*(airDrandMT() - 0.5));
+        ELL_3V_NORM(tt, tt, len);
+        len = len < 2 ? 0 : 1;
+        TEN_T_SET(dten, 1.0,
+                  0.2 + len*tt[0]*tt[0], len*tt[0]*tt[1], len*tt[0]*tt[2],
+                  0.2 + len*tt[1]*tt[1], len*tt[1]*tt[2],
+                  0.2 + len*tt[2]*tt[2]);
+        TEN_T_COPY_TT(ten, float, dten);
+        ten += 7;
+      }
+    }
+  }
+  for (si=0; si<seedNum; si++) {
+    ELL_3V_SET(AIR_CAST(double *, nseed->data) + 3*si,
+               AIR_AFFINE(0, airDrandMT(), 1, 0, sx-1),
+               AIR_AFFINE(0, airDrandMT(), 1, 0, sy-1),
+               AIR_AFFINE(0, airDrandMT(), 1, 0, sz-1));
+  }
+  return 0;
+}
+
+/*
+** fiberTestContext sets up (and adds to mop) a context for tracing
+** (RK4, along evec0 of tent-interpolated tensors, in index space, with
+** step size 0.1, until FA drops below 0.3) in nten with given threads,
+** at most stepNum steps, probing probe (unless it is tenGageUnknown),
+** and with or without the direction cache.  Returns NULL, with a biff
+** TEN message, on trouble.
+*/
+static tenFiberContext *
+fiberTestContext(const Nrrd *nten, unsigned int threadNum,
+                 unsigned int stepNum, int probe, int dirCache,
+                 airArray *mop) {
+  tenFiberContext *tfx;
+  double kparm[NRRD_KERNEL_PARMS_NUM];
+  int E;
+
+  tfx = tenFiberContextNew(nten);
+  if (!tfx) {
+    return NULL;
+  }
+  airMopAdd(mop, tfx, (airMopper)tenFiberContextNix, airMopAlways);
+  kparm[0] = 1.0;
+  E = 0;
+  if (!E) E |= tenFiberTypeSet(tfx, tenFiberTypeEvec0);
+  if (!E) E |= tenFiberKernelSet(tfx, nrrdKernelTent, kparm);
+  if (!E) E |= tenFiberIntgSet(tfx, tenFiberIntgRK4);
+  if (!E && tenGageUnknown != probe) {
+    E |= tenFiberProbeItemSet(tfx, probe);
+  }
+  if (!E) E |= tenFiberStopSet(tfx, tenFiberStopAniso, tenAniso_FA, 0.3);
+  if (!E) E |= tenFiberStopSet(tfx, tenFiberStopNumSteps, stepNum);
+  if (!E) E |= tenFiberParmSet(tfx, tenFiberParmStepSize, 0.1);
+  if (!E) E |= tenFiberParmSet(tfx, tenFiberParmUseIndexSpace, AIR_TRUE);
+  if (!E) E |= tenFiberParmSet(tfx, tenFiberParmThreadNum, threadNum);
+  if (!E) E |= tenFiberParmSet(tfx, tenFiberParmDirCache, dirCache);
+  if (!E) E |= tenFiberUpdate(tfx);
+  return E ? NULL : tfx;
+}
+
+#endif /* FIBERTEST_HAS_BEEN_INCLUDED */
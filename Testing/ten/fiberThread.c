@@ -0,0 +1,147 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "teem/ten.h"
+#include "fiberTest.h"
+
+/*
+** Tests:
+** tenFiberMultiTrace: tracing with multiple threads has to give exactly
+** the same fibers, in the same order, as with one thread, including when
+** re-using the fibers from a previous tracing
+*/
+
+#define SX 24
+#define SY 22
+#define SZ 8
+#define SEED_NUM 300
+
+/* traces from the first seedNum seeds into tfml, with given threads */
+static int
+trace(const char *me, tenFiberMulti *tfml, const Nrrd *nten,
+      const Nrrd *nseed, unsigned int seedNum, unsigned int threadNum,
+      airArray *mop) {
+  tenFiberContext *tfx;
+  Nrrd *nsub;
+  size_t cmin[2], cmax[2];
+  char *err;
+
+  nsub = nrrdNew();
+  airMopAdd(mop, nsub, (airMopper)nrrdNuke, airMopAlways);
+  cmin[0] = 0; cmin[1] = 0;
+  cmax[0] = 2; cmax[1] = seedNum-1;
+  if (nrrdCrop(nsub, nseed, cmin, cmax)) {
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble cropping seeds:\n%s", me, err);
+    return 1;
+  }
+  if (!(tfx = fiberTestContext(nten, threadNum, 300, tenGageUnknown,
+                               AIR_FALSE, mop))
+      || tenFiberMultiTrace(tfx, tfml, nsub)) {
+    airMopAdd(mop, err = biffGetDone(TEN), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble tracing with %u threads:\n%s", me,
+            threadNum, err);
+    return 1;
+  }
+  return 0;
+}
+
+int
+main(int argc, const char **argv) {
+  const char *me;
+  char *err;
+  airArray *mop;
+  Nrrd *nten, *nseed;
+  tenFiberMulti *tfml[2];
+  tenFiberSingle *fa, *fb;
+  unsigned int si, fi, started;
+  size_t NN;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+
+  airSrandMT(4242);
+  nten = nrrdNew();
+  airMopAdd(mop, nten, (airMopper)nrrdNuke, airMopAlways);
+  nseed = nrrdNew();
+  airMopAdd(mop, nseed, (airMopper)nrrdNuke, airMopAlways);
+  for (si=0; si<2; si++) {
+    if (!(tfml[si] = tenFiberMultiNew())) {
+      airMopAdd(mop, err = biffGetDone(TEN), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    airMopAdd(mop, tfml[si], (airMopper)tenFiberMultiNix, airMopAlways);
+  }
+  if (fiberTestVolume(nten, nseed, SX, SY, SZ, SEED_NUM)) {
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+
+  /* the second is first traced from fewer seeds, so that its fibers
+     are then partly re-used */
+  if (trace(me, tfml[0], nten, nseed, SEED_NUM, 1, mop)
+      || trace(me, tfml[1], nten, nseed, SEED_NUM/3, 1, mop)
+      || trace(me, tfml[1], nten, nseed, SEED_NUM, 3, mop)) {
+    airMopError(mop); return 1;
+  }
+  if (tfml[0]->fiberNum != tfml[1]->fiberNum) {
+    fprintf(stderr, "%s: got %u fibers with 3 threads, not %u\n", me,
+            tfml[1]->fiberNum, tfml[0]->fiberNum);
+    airMopError(mop); return 1;
+  }
+  started = 0;
+  for (fi=0; fi<tfml[0]->fiberNum; fi++) {
+    fa = tfml[0]->fiber + fi;
+    fb = tfml[1]->fiber + fi;
+    if (!( ELL_3V_EQUAL(fa->seedPos, fb->seedPos)
+           && fa->whyNowhere == fb->whyNowhere )) {
+      fprintf(stderr, "%s: fiber %u: different seed or whyNowhere\n",
+              me, fi);
+      airMopError(mop); return 1;
+    }
+    if (tenFiberStopUnknown != fa->whyNowhere) {
+      continue;
+    }
+    started++;
+    NN = nrrdElementNumber(fa->nvert);
+    if (!( fa->seedIdx == fb->seedIdx
+           && NN == nrrdElementNumber(fb->nvert)
+           && !memcmp(fa->nvert->data, fb->nvert->data,
+                      NN*sizeof(double)) )) {
+      fprintf(stderr, "%s: fiber %u: different vertices\n", me, fi);
+      airMopError(mop); return 1;
+    }
+  }
+  /* the test is meaningless if fibers don't go anywhere */
+  if (!( started > SEED_NUM/2 )) {
+    fprintf(stderr, "%s: only %u/%u fibers started\n", me, started,
+            SEED_NUM);
+    airMopError(mop); return 1;
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
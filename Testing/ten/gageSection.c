@@ -0,0 +1,166 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "teem/ten.h"
+
+/*
+** Tests:
+** the per-query sections of the tensor kind's answer function: every
+** item, when it is the only item queried, has to have the same answer
+** as when every item is queried (an item missing from its section in
+** _tenGageSectionItem would be skipped, and left unset)
+*/
+
+#define SIZE 11
+
+/* items whose answers, independent of the sections, already depend on
+   which other items are in the query */
+static const int
+_queryDependent[] = {
+  tenGageTensorGradMag,
+  tenGageFAKappa1,
+  tenGageFAKappa2,
+  tenGageFAShapeIndex,
+  tenGageFAGaussCurv,
+  tenGageFACurvDir1,
+  tenGageUnknown
+};
+
+static int
+setup(gageContext **gctxP, gagePerVolume **pvlP, airArray *mop,
+      const Nrrd *nin, int item) {
+  gageContext *gctx;
+  gagePerVolume *pvl;
+  double kparm[NRRD_KERNEL_PARMS_NUM] = {1.0};
+  int E, ii;
+
+  gctx = gageContextNew();
+  airMopAdd(mop, gctx, (airMopper)gageContextNix, airMopAlways);
+  E = 0;
+  if (!E) E |= !(pvl = gagePerVolumeNew(gctx, nin, tenGageKind));
+  if (!E) E |= gageKernelSet(gctx, gageKernel00, nrrdKernelBSpline3, kparm);
+  if (!E) E |= gageKernelSet(gctx, gageKernel11, nrrdKernelBSpline3D, kparm);
+  if (!E) E |= gageKernelSet(gctx, gageKernel22, nrrdKernelBSpline3DD, kparm);
+  if (!E) E |= gagePerVolumeAttach(gctx, pvl);
+  if (item) {
+    if (!E) E |= gageQueryItemOn(gctx, pvl, item);
+  } else {
+    for (ii=tenGageUnknown+1; !E && ii<=TEN_GAGE_ITEM_MAX; ii++) {
+      E |= gageQueryItemOn(gctx, pvl, ii);
+    }
+  }
+  if (!E) E |= gageUpdate(gctx);
+  if (E) {
+    return 1;
+  }
+  *gctxP = gctx;
+  *pvlP = pvl;
+  return 0;
+}
+
+int
+main(int argc, const char **argv) {
+  const char *me;
+  char *err;
+  airArray *mop;
+  Nrrd *nin;
+  double *data, pos[3][3] = {{4.3, 5.6, 5.1},
+                             {5.5, 4.2, 6.7},
+                             {6.1, 6.9, 4.4}};
+  gageContext *actx, *ictx;
+  gagePerVolume *apvl, *ipvl;
+  const double *aans, *ians;
+  unsigned int ii, pi, vi, len;
+  int item, qdi, skip;
+  airRandMTState *rng;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+
+  nin = nrrdNew();
+  airMopAdd(mop, nin, (airMopper)nrrdNuke, airMopAlways);
+  if (nrrdMaybeAlloc_va(nin, nrrdTypeDouble, 4, AIR_CAST(size_t, 7),
+                        AIR_CAST(size_t, SIZE), AIR_CAST(size_t, SIZE),
+                        AIR_CAST(size_t, SIZE))) {
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  nrrdAxisInfoSet_va(nin, nrrdAxisInfoSpacing, AIR_NAN, 1.0, 1.0, 1.0);
+  rng = airRandMTStateNew(42);
+  airMopAdd(mop, rng, (airMopper)airRandMTStateNix, airMopAlways);
+  data = AIR_CAST(double *, nin->data);
+  for (ii=0; ii<SIZE*SIZE*SIZE; ii++) {
+    TEN_T_SET(data + 7*ii, 1.0,
+              1.0 + airDrandMT_r(rng), 0.3*airDrandMT_r(rng),
+              0.3*airDrandMT_r(rng), 1.0 + airDrandMT_r(rng),
+              0.3*airDrandMT_r(rng), 1.0 + airDrandMT_r(rng));
+  }
+
+  if (setup(&actx, &apvl, mop, nin, 0)) {
+    airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble setting up all-item context:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  for (item=tenGageUnknown+1; item<=TEN_GAGE_ITEM_MAX; item++) {
+    skip = AIR_FALSE;
+    for (qdi=0; _queryDependent[qdi]; qdi++) {
+      skip |= (item == _queryDependent[qdi]);
+    }
+    if (skip) {
+      continue;
+    }
+    if (setup(&ictx, &ipvl, mop, nin, item)) {
+      airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble setting up context for %s:\n%s", me,
+              airEnumStr(tenGage, item), err);
+      airMopError(mop); return 1;
+    }
+    len = gageAnswerLength(ictx, ipvl, item);
+    for (pi=0; pi<3; pi++) {
+      if (gageProbe(actx, pos[pi][0], pos[pi][1], pos[pi][2])
+          || gageProbe(ictx, pos[pi][0], pos[pi][1], pos[pi][2])) {
+        fprintf(stderr, "%s: probe %u failed\n", me, pi);
+        airMopError(mop); return 1;
+      }
+      aans = gageAnswerPointer(actx, apvl, item);
+      ians = gageAnswerPointer(ictx, ipvl, item);
+      for (vi=0; vi<len; vi++) {
+        if (!(AIR_EXISTS(aans[vi]) || AIR_EXISTS(ians[vi]))) {
+          continue;
+        }
+        if (!(AIR_ABS(aans[vi] - ians[vi])
+              <= 1e-6*(1 + AIR_ABS(aans[vi])))) {
+          fprintf(stderr, "%s: %s[%u] at pos %u: %g (alone) != %g (all)\n",
+                  me, airEnumStr(tenGage, item), vi, pi,
+                  ians[vi], aans[vi]);
+          airMopError(mop); return 1;
+        }
+      }
+    }
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
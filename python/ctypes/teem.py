@@ -428,6 +428,12 @@ nrrdBinaryOpIf = 21
 alanParmTextureType = 2
 nrrdSpaceLeftPosteriorSuperior = 3
 gageErrLast = 7
+gageStoreUnknown = 0
+gageStoreFull = 1
+gageStoreHalf = 2
+gageStoreQuant16 = 3
+gageStoreQuant8 = 4
+gageStoreLast = 5
 nrrdBinaryOpExists = 20
 gageErrStackUnused = 6
 limnPrimitiveNoop = 1
@@ -1008,7 +1014,9 @@ limnQN14checker = 6
 nrrdTypeLast = 12
 gageSclHessEvec1 = 17
 gageSclHessEvec0 = 16
-tenFiberParmLast = 5
+tenFiberParmThreadNum = 5
+tenFiberParmDirCache = 6
+tenFiberParmLast = 7
 nrrdMeasureHistoProduct = 26
 nrrdBoundaryMirror = 5
 nrrdMeasureHistoMode = 25
@@ -1304,8 +1312,9 @@ baneIncRangeRatio = 2
 baneIncAbsolute = 1
 gageKernelUnknown = 0
 nrrdUnaryOpNormalRand = 27
-gagePvlFlagLast = 4
+gagePvlFlagLast = 5
 gagePvlFlagNeedD = 3
+gagePvlFlagDeriv = 4
 tenGageQNormal = 50
 tenGageQGradMag = 49
 tenGageQGradVec = 48
@@ -1317,7 +1326,8 @@ tenGageDetGradVec = 42
 gageCtxFlagNeedD = 1
 nrrdUnaryOpExists = 25
 tenGageBGradVec = 39
-gageParmLast = 16
+gageParmLast = 17
+gageParmSinglePrecision = 16
 gageParmTwoDimZeroZ = 15
 gageVecGradient1 = 26
 gageParmGenerateErrStr = 14
@@ -1646,6 +1656,9 @@ airThreadBarrierWait.argtypes = [POINTER(airThreadBarrier)]
 airThreadBarrierNix = libteem.airThreadBarrierNix
 airThreadBarrierNix.restype = POINTER(airThreadBarrier)
 airThreadBarrierNix.argtypes = [POINTER(airThreadBarrier)]
+airThreadRun = libteem.airThreadRun
+airThreadRun.restype = c_int
+airThreadRun.argtypes = [CFUNCTYPE(c_void_p, c_void_p), c_void_p, c_size_t, c_uint]
 class airFloat(Union):
     pass
 airFloat._fields_ = [
@@ -1709,6 +1722,12 @@ airIsInf_d.argtypes = [c_double]
 airExists = libteem.airExists
 airExists.restype = c_int
 airExists.argtypes = [c_double]
+airHalfFromFloat = libteem.airHalfFromFloat
+airHalfFromFloat.restype = c_ushort
+airHalfFromFloat.argtypes = [c_float]
+airHalfToFloat = libteem.airHalfToFloat
+airHalfToFloat.restype = c_float
+airHalfToFloat.argtypes = [c_ushort]
 class airRandMTState(Structure):
     pass
 airRandMTState._fields_ = [
@@ -2510,6 +2529,9 @@ biffMovef.argtypes = [STRING, STRING, STRING]
 biffSetStrDone = libteem.biffSetStrDone
 biffSetStrDone.restype = None
 biffSetStrDone.argtypes = [STRING, STRING]
+biffThreadSafe = libteem.biffThreadSafe
+biffThreadSafe.restype = c_int
+biffThreadSafe.argtypes = []
 biffDone = libteem.biffDone
 biffDone.restype = None
 biffDone.argtypes = [STRING]
@@ -3457,6 +3479,15 @@ ell_3m_svd_d.argtypes = [POINTER(c_double), POINTER(c_double), POINTER(c_double)
 ell_6ms_eigensolve_d = libteem.ell_6ms_eigensolve_d
 ell_6ms_eigensolve_d.restype = c_int
 ell_6ms_eigensolve_d.argtypes = [POINTER(c_double), POINTER(c_double), POINTER(c_double), c_double]
+ell_6ms_eigensolve_batch_d = libteem.ell_6ms_eigensolve_batch_d
+ell_6ms_eigensolve_batch_d.restype = c_int
+ell_6ms_eigensolve_batch_d.argtypes = [POINTER(c_double), POINTER(c_double), POINTER(c_double), c_size_t, c_double, c_uint]
+ell_3ms_eigensolve_batch_d = libteem.ell_3ms_eigensolve_batch_d
+ell_3ms_eigensolve_batch_d.restype = c_int
+ell_3ms_eigensolve_batch_d.argtypes = [POINTER(c_double), POINTER(c_double), POINTER(c_double), c_size_t]
+ell_3ms_eigensolve_batch_f = libteem.ell_3ms_eigensolve_batch_f
+ell_3ms_eigensolve_batch_f.restype = c_int
+ell_3ms_eigensolve_batch_f.argtypes = [POINTER(c_float), POINTER(c_float), POINTER(c_float), c_size_t]
 class gageItemEntry(Structure):
     pass
 gageItemEntry._fields_ = [
@@ -3502,6 +3533,7 @@ gageParm_t._fields_ = [
     ('orientationFromSpacing', c_int),
     ('generateErrStr', c_int),
     ('twoDimZeroZ', c_int),
+    ('singlePrecision', c_int),
 ]
 gageParm = gageParm_t
 class gagePoint_t(Structure):
@@ -3535,7 +3567,8 @@ gageContext_t._fields_ = [
     ('radius', c_uint),
     ('fsl', POINTER(c_double)),
     ('fw', POINTER(c_double)),
-    ('off', POINTER(c_uint)),
+    ('fwf', POINTER(c_float)),
+    ('off', POINTER(c_size_t)),
     ('point', gagePoint),
     ('errStr', c_char * 513),
     ('errNum', c_int),
@@ -3561,16 +3594,32 @@ gageKind_t._fields_ = [
     ('pvlDataUpdate', CFUNCTYPE(c_int, POINTER(gageKind_t), POINTER(gageContext), POINTER(gagePerVolume), c_void_p)),
     ('data', c_void_p),
 ]
+class gageStackLazy_t(Structure):
+    pass
 gagePerVolume_t._fields_ = [
     ('verbose', c_int),
     ('kind', POINTER(gageKind_t)),
     ('query', gageQuery),
     ('needD', c_int * 3),
     ('nin', POINTER(Nrrd)),
-    ('flag', c_int * 4),
+    ('flag', c_int * 5),
     ('iv3', POINTER(c_double)),
     ('iv2', POINTER(c_double)),
     ('iv1', POINTER(c_double)),
+    ('iv3f', POINTER(c_float)),
+    ('iv2f', POINTER(c_float)),
+    ('iv1f', POINTER(c_float)),
+    ('nbrick', POINTER(Nrrd)),
+    ('brickShift', c_uint),
+    ('derivPrecompute', c_int),
+    ('nderiv', POINTER(Nrrd)),
+    ('nderivOwn', c_int),
+    ('store', c_int),
+    ('storeMin', c_double),
+    ('storeStep', c_double),
+    ('lazy', POINTER(gageStackLazy_t)),
+    ('lazyIdx', c_uint),
+    ('lazySeen', POINTER(c_ubyte)),
     ('lup', CFUNCTYPE(c_double, c_void_p, c_size_t)),
     ('answer', POINTER(c_double)),
     ('directAnswer', POINTER(POINTER(c_double))),
@@ -3606,6 +3655,49 @@ gageStackBlurParm._fields_ = [
     ('needSpatialBlur', c_int),
     ('verbose', c_int),
     ('dgGoodSigmaMax', c_double),
+    ('threadNum', c_uint),
+]
+gageStackLazy_t._fields_ = [
+    ('nin', POINTER(Nrrd)),
+    ('kind', POINTER(gageKind)),
+    ('num', c_uint),
+    ('brickShift', c_uint),
+    ('size', c_uint * 3),
+    ('bnum', c_uint * 3),
+    ('store', c_int),
+    ('type', c_int),
+    ('boundary', c_int),
+    ('padValue', c_double),
+    ('range', c_double * 2),
+    ('storeMin', c_double),
+    ('storeStep', c_double),
+    ('wlo', POINTER(c_int)),
+    ('wlen', POINTER(c_uint)),
+    ('weight', POINTER(POINTER(c_double))),
+    ('integral', POINTER(c_double)),
+    ('oneDim', c_int),
+    ('brick', POINTER(POINTER(c_void_p))),
+    ('brickMade', c_size_t),
+    ('mutex', POINTER(airThreadMutex)),
+]
+gageStackLazy = gageStackLazy_t
+class gageContextPool(Structure):
+    pass
+gageContextPool._pack_ = 4
+gageContextPool._fields_ = [
+    ('threadNum', c_uint),
+    ('tctx', POINTER(POINTER(gageContext))),
+    ('arg', c_void_p),
+    ('pvlIdx', POINTER(c_uint)),
+    ('ansAlloc', c_uint),
+    ('thread', POINTER(POINTER(airThread))),
+    ('threadStarted', c_uint),
+    ('mutex', POINTER(airThreadMutex)),
+    ('workCond', POINTER(airThreadCond)),
+    ('doneCond', POINTER(airThreadCond)),
+    ('generation', c_uint),
+    ('busyNum', c_uint),
+    ('finished', c_int),
 ]
 class gageOptimSigContext(Structure):
     pass
@@ -3622,6 +3714,7 @@ gageOptimSigContext._fields_ = [
     ('imgMeasr', c_int),
     ('allMeasr', c_int),
     ('convEps', c_double),
+    ('threadNum', c_uint),
     ('sx', c_uint),
     ('sy', c_uint),
     ('sz', c_uint),
@@ -3634,7 +3727,10 @@ gageOptimSigContext._fields_ = [
     ('ktmp1', POINTER(c_double)),
     ('ktmp2', POINTER(c_double)),
     ('kone', c_double * 1),
+    ('ktrue', POINTER(c_double)),
+    ('tbuff', POINTER(c_double)),
     ('gctx', POINTER(gageContext)),
+    ('pool', POINTER(gageContextPool)),
     ('pvlBase', POINTER(gagePerVolume)),
     ('pvlSS', POINTER(POINTER(gagePerVolume))),
     ('nsampleImg', POINTER(POINTER(Nrrd))),
@@ -3661,6 +3757,7 @@ gageDefStackNormalizeDerivBias = (c_double).in_dll(libteem, 'gageDefStackNormali
 gageDefOrientationFromSpacing = (c_int).in_dll(libteem, 'gageDefOrientationFromSpacing')
 gageDefGenerateErrStr = (c_int).in_dll(libteem, 'gageDefGenerateErrStr')
 gageDefTwoDimZeroZ = (c_int).in_dll(libteem, 'gageDefTwoDimZeroZ')
+gageDefSinglePrecision = (c_int).in_dll(libteem, 'gageDefSinglePrecision')
 gagePresent = (c_int).in_dll(libteem, 'gagePresent')
 gageZeroNormal = (c_double * 3).in_dll(libteem, 'gageZeroNormal')
 gageErr = (POINTER(airEnum)).in_dll(libteem, 'gageErr')
@@ -3783,6 +3880,9 @@ gageOptimSigContextNew.argtypes = [c_uint, c_uint, c_uint, c_double, c_double, c
 gageOptimSigContextNix = libteem.gageOptimSigContextNix
 gageOptimSigContextNix.restype = POINTER(gageOptimSigContext)
 gageOptimSigContextNix.argtypes = [POINTER(gageOptimSigContext)]
+gageOptimSigContextThreadNumSet = libteem.gageOptimSigContextThreadNumSet
+gageOptimSigContextThreadNumSet.restype = c_int
+gageOptimSigContextThreadNumSet.argtypes = [POINTER(gageOptimSigContext), c_uint]
 NrrdKernelSpec._pack_ = 4
 NrrdKernelSpec._fields_ = [
     ('kernel', POINTER(NrrdKernel)),
@@ -3863,6 +3963,9 @@ gageStackBlurParmNeedSpatialBlurSet.argtypes = [POINTER(gageStackBlurParm), c_in
 gageStackBlurParmVerboseSet = libteem.gageStackBlurParmVerboseSet
 gageStackBlurParmVerboseSet.restype = c_int
 gageStackBlurParmVerboseSet.argtypes = [POINTER(gageStackBlurParm), c_int]
+gageStackBlurParmThreadNumSet = libteem.gageStackBlurParmThreadNumSet
+gageStackBlurParmThreadNumSet.restype = c_int
+gageStackBlurParmThreadNumSet.argtypes = [POINTER(gageStackBlurParm), c_uint]
 gageStackBlurParmOneDimSet = libteem.gageStackBlurParmOneDimSet
 gageStackBlurParmOneDimSet.restype = c_int
 gageStackBlurParmOneDimSet.argtypes = [POINTER(gageStackBlurParm), c_int]
@@ -3879,6 +3982,9 @@ gageStackBlurParmSprint.argtypes = [STRING, POINTER(gageStackBlurParm), POINTER(
 gageStackBlur = libteem.gageStackBlur
 gageStackBlur.restype = c_int
 gageStackBlur.argtypes = [POINTER(POINTER(Nrrd)), POINTER(gageStackBlurParm), POINTER(Nrrd), POINTER(gageKind)]
+gageStackBlurStream = libteem.gageStackBlurStream
+gageStackBlurStream.restype = c_int
+gageStackBlurStream.argtypes = [POINTER(gageStackBlurParm), STRING, POINTER(NrrdEncoding), POINTER(Nrrd), POINTER(gageKind)]
 gageStackBlurCheck = libteem.gageStackBlurCheck
 gageStackBlurCheck.restype = c_int
 gageStackBlurCheck.argtypes = [POINTER(POINTER(Nrrd)), POINTER(gageStackBlurParm), POINTER(Nrrd), POINTER(gageKind)]
@@ -3891,6 +3997,22 @@ NrrdEncoding = NrrdEncoding_t
 gageStackBlurManage = libteem.gageStackBlurManage
 gageStackBlurManage.restype = c_int
 gageStackBlurManage.argtypes = [POINTER(POINTER(POINTER(Nrrd))), POINTER(c_int), POINTER(gageStackBlurParm), STRING, c_int, POINTER(NrrdEncoding), POINTER(Nrrd), POINTER(gageKind)]
+gageStore = (POINTER(airEnum)).in_dll(libteem, 'gageStore')
+gageStoreMake = libteem.gageStoreMake
+gageStoreMake.restype = c_int
+gageStoreMake.argtypes = [POINTER(Nrrd), POINTER(Nrrd), c_int]
+gagePerVolumeStoreSet = libteem.gagePerVolumeStoreSet
+gagePerVolumeStoreSet.restype = c_int
+gagePerVolumeStoreSet.argtypes = [POINTER(gagePerVolume), c_int]
+gageStackLazyNew = libteem.gageStackLazyNew
+gageStackLazyNew.restype = POINTER(gageStackLazy)
+gageStackLazyNew.argtypes = [POINTER(Nrrd), POINTER(gageKind), POINTER(gageStackBlurParm), c_uint, c_int]
+gageStackLazyNix = libteem.gageStackLazyNix
+gageStackLazyNix.restype = POINTER(gageStackLazy)
+gageStackLazyNix.argtypes = [POINTER(gageStackLazy)]
+gageStackLazyPerVolumeNew = libteem.gageStackLazyPerVolumeNew
+gageStackLazyPerVolumeNew.restype = c_int
+gageStackLazyPerVolumeNew.argtypes = [POINTER(gageContext), POINTER(POINTER(gagePerVolume)), POINTER(gageStackLazy)]
 gageContextNew = libteem.gageContextNew
 gageContextNew.restype = POINTER(gageContext)
 gageContextNew.argtypes = []
@@ -3924,18 +4046,48 @@ gageProbe.argtypes = [POINTER(gageContext), c_double, c_double, c_double]
 gageProbeSpace = libteem.gageProbeSpace
 gageProbeSpace.restype = c_int
 gageProbeSpace.argtypes = [POINTER(gageContext), c_double, c_double, c_double, c_int, c_int]
+gageProbeBatch = libteem.gageProbeBatch
+gageProbeBatch.restype = c_int
+gageProbeBatch.argtypes = [POINTER(gageContext), POINTER(POINTER(c_double)), POINTER(c_int), POINTER(c_size_t), POINTER(POINTER(gagePerVolume)), POINTER(c_int), c_uint, POINTER(c_double), POINTER(c_double), POINTER(c_double), POINTER(c_double), c_size_t, c_int, c_int]
+gageBrickMake = libteem.gageBrickMake
+gageBrickMake.restype = c_int
+gageBrickMake.argtypes = [POINTER(Nrrd), POINTER(Nrrd), POINTER(gageKind), c_uint]
+gagePerVolumeBrickSet = libteem.gagePerVolumeBrickSet
+gagePerVolumeBrickSet.restype = c_int
+gagePerVolumeBrickSet.argtypes = [POINTER(gagePerVolume), POINTER(Nrrd)]
+gagePerVolumeDerivPrecomputeSet = libteem.gagePerVolumeDerivPrecomputeSet
+gagePerVolumeDerivPrecomputeSet.restype = c_int
+gagePerVolumeDerivPrecomputeSet.argtypes = [POINTER(gagePerVolume), c_int]
+gageProbeScanline = libteem.gageProbeScanline
+gageProbeScanline.restype = c_int
+gageProbeScanline.argtypes = [POINTER(gageContext), POINTER(POINTER(c_double)), POINTER(c_int), POINTER(c_size_t), POINTER(POINTER(gagePerVolume)), POINTER(c_int), c_uint, c_double, c_double, c_double, c_uint, c_double, c_size_t, c_int]
 gageUpdate = libteem.gageUpdate
 gageUpdate.restype = c_int
 gageUpdate.argtypes = [POINTER(gageContext)]
 gageStructureTensor = libteem.gageStructureTensor
 gageStructureTensor.restype = c_int
 gageStructureTensor.argtypes = [POINTER(Nrrd), POINTER(Nrrd), c_int, c_int, c_int]
+gageContextPoolNew = libteem.gageContextPoolNew
+gageContextPoolNew.restype = POINTER(gageContextPool)
+gageContextPoolNew.argtypes = [POINTER(gageContext), c_uint]
+gageContextPoolNix = libteem.gageContextPoolNix
+gageContextPoolNix.restype = POINTER(gageContextPool)
+gageContextPoolNix.argtypes = [POINTER(gageContextPool)]
+gageProbeList = libteem.gageProbeList
+gageProbeList.restype = c_int
+gageProbeList.argtypes = [POINTER(gageContextPool), POINTER(POINTER(Nrrd)), POINTER(c_size_t), POINTER(POINTER(gagePerVolume)), POINTER(c_int), c_uint, c_int, POINTER(Nrrd), c_int, c_int]
+gageProbeGrid = libteem.gageProbeGrid
+gageProbeGrid.restype = c_int
+gageProbeGrid.argtypes = [POINTER(gageContextPool), POINTER(POINTER(Nrrd)), POINTER(c_size_t), POINTER(POINTER(gagePerVolume)), POINTER(c_int), c_uint, c_int, c_uint, POINTER(c_size_t), POINTER(c_double), POINTER(c_double), c_int, c_int]
 gageDeconvolve = libteem.gageDeconvolve
 gageDeconvolve.restype = c_int
 gageDeconvolve.argtypes = [POINTER(Nrrd), POINTER(c_double), POINTER(Nrrd), POINTER(gageKind), POINTER(NrrdKernelSpec), c_int, c_uint, c_int, c_double, c_double, c_int]
 gageDeconvolveSeparableKnown = libteem.gageDeconvolveSeparableKnown
 gageDeconvolveSeparableKnown.restype = c_int
 gageDeconvolveSeparableKnown.argtypes = [POINTER(NrrdKernelSpec)]
+gageDeconvolveSeparableThreaded = libteem.gageDeconvolveSeparableThreaded
+gageDeconvolveSeparableThreaded.restype = c_int
+gageDeconvolveSeparableThreaded.argtypes = [POINTER(Nrrd), POINTER(Nrrd), POINTER(gageKind), POINTER(NrrdKernelSpec), c_int, c_uint]
 gageDeconvolveSeparable = libteem.gageDeconvolveSeparable
 gageDeconvolveSeparable.restype = c_int
 gageDeconvolveSeparable.argtypes = [POINTER(Nrrd), POINTER(Nrrd), POINTER(gageKind), POINTER(NrrdKernelSpec), c_int]
@@ -5934,6 +6086,24 @@ nrrdFFT.argtypes = [POINTER(Nrrd), POINTER(Nrrd), POINTER(c_uint), c_uint, c_int
 nrrdFFTWWisdomWrite = libteem.nrrdFFTWWisdomWrite
 nrrdFFTWWisdomWrite.restype = c_int
 nrrdFFTWWisdomWrite.argtypes = [POINTER(FILE)]
+class NrrdFFTPlan(Structure):
+    pass
+NrrdFFTPlan._pack_ = 4
+NrrdFFTPlan._fields_ = [
+    ('plan', c_void_p),
+    ('dim', c_uint),
+    ('size', c_size_t * 16),
+    ('nprod', c_size_t),
+]
+nrrdFFTPlanNew = libteem.nrrdFFTPlanNew
+nrrdFFTPlanNew.restype = POINTER(NrrdFFTPlan)
+nrrdFFTPlanNew.argtypes = [POINTER(Nrrd), POINTER(c_uint), c_uint, c_int, c_int]
+nrrdFFTPlanNix = libteem.nrrdFFTPlanNix
+nrrdFFTPlanNix.restype = POINTER(NrrdFFTPlan)
+nrrdFFTPlanNix.argtypes = [POINTER(NrrdFFTPlan)]
+nrrdFFTPlanExecute = libteem.nrrdFFTPlanExecute
+nrrdFFTPlanExecute.restype = c_int
+nrrdFFTPlanExecute.argtypes = [POINTER(Nrrd), POINTER(NrrdFFTPlan), c_int]
 nrrdKernelTMF = (POINTER(NrrdKernel) * 5 * 5 * 4).in_dll(libteem, 'nrrdKernelTMF')
 nrrdKernelTMF_maxD = (c_uint).in_dll(libteem, 'nrrdKernelTMF_maxD')
 nrrdKernelTMF_maxC = (c_uint).in_dll(libteem, 'nrrdKernelTMF_maxC')
@@ -6970,6 +7140,19 @@ tenEvecRGBParm._fields_ = [
     ('typeOut', c_int),
     ('genAlpha', c_int),
 ]
+class tenFiberDirCache(Structure):
+    pass
+tenFiberDirCache._fields_ = [
+    ('nin', POINTER(Nrrd)),
+    ('size', c_uint * 3),
+    ('bnum', c_uint * 3),
+    ('evecIdx', c_uint),
+    ('anisoStopType', c_int),
+    ('anisoSpeedType', c_int),
+    ('brick', POINTER(POINTER(c_float))),
+    ('brickMade', c_size_t),
+    ('mutex', POINTER(airThreadMutex)),
+]
 class tenFiberContext(Structure):
     pass
 tenFiberContext._pack_ = 4
@@ -6997,6 +7180,11 @@ tenFiberContext._fields_ = [
     ('minFraction', c_double),
     ('wPunct', c_double),
     ('ten2Which', c_uint),
+    ('threadNum', c_uint),
+    ('dirCache', c_int),
+    ('dcache', POINTER(tenFiberDirCache)),
+    ('dcacheOwn', c_int),
+    ('dcacheSeen', POINTER(POINTER(c_float))),
     ('query', gageQuery),
     ('halfIdx', c_int),
     ('mframeUse', c_int),
@@ -7052,6 +7240,47 @@ tenFiberMulti._fields_ = [
     ('fiberNum', c_uint),
     ('fiberArr', POINTER(airArray)),
 ]
+class tenFiberStream(Structure):
+    pass
+tenFiberStream._fields_ = [
+    ('half', c_int),
+    ('valLen', c_uint),
+    ('fiberNum', c_uint),
+    ('vertNum', c_size_t),
+    ('record', c_void_p),
+    ('offset', POINTER(airULLong)),
+    ('headName', STRING),
+    ('file', POINTER(FILE)),
+    ('off', POINTER(airULLong)),
+    ('offArr', POINTER(airArray)),
+    ('buff', c_void_p),
+    ('buffSize', c_size_t),
+    ('map', c_void_p * 2),
+    ('mapSize', c_size_t * 2),
+    ('nrecord', POINTER(Nrrd)),
+    ('noffset', POINTER(Nrrd)),
+]
+class tenFiberIndex(Structure):
+    pass
+tenFiberIndex._fields_ = [
+    ('fiberNum', c_uint),
+    ('vertNum', c_size_t),
+    ('vert', POINTER(c_float)),
+    ('vertStart', POINTER(c_size_t)),
+    ('origin', c_double * 3),
+    ('cellSize', c_double),
+    ('size', c_uint * 3),
+    ('cellStart', POINTER(c_size_t)),
+    ('seg', POINTER(c_size_t)),
+]
+class tenFiberRegion(Structure):
+    pass
+tenFiberRegion._fields_ = [
+    ('nmask', POINTER(Nrrd)),
+    ('center', c_double * 3),
+    ('radius', c_double),
+    ('exclude', c_int),
+]
 class tenEMBimodalParm(Structure):
     pass
 tenEMBimodalParm._pack_ = 4
@@ -7136,6 +7365,7 @@ tenEstimateContext._fields_ = [
     ('negEvalShift', c_int),
     ('progress', c_int),
     ('WLSIterNum', c_uint),
+    ('threadNum', c_uint),
     ('flag', c_int * 128),
     ('allNum', c_uint),
     ('dwiNum', c_uint),
@@ -7526,6 +7756,9 @@ tenEstimateSigmaSet.argtypes = [POINTER(tenEstimateContext), c_double]
 tenEstimateValueMinSet = libteem.tenEstimateValueMinSet
 tenEstimateValueMinSet.restype = c_int
 tenEstimateValueMinSet.argtypes = [POINTER(tenEstimateContext), c_double]
+tenEstimateThreadNumSet = libteem.tenEstimateThreadNumSet
+tenEstimateThreadNumSet.restype = c_int
+tenEstimateThreadNumSet.argtypes = [POINTER(tenEstimateContext), c_uint]
 tenEstimateGradientsSet = libteem.tenEstimateGradientsSet
 tenEstimateGradientsSet.restype = c_int
 tenEstimateGradientsSet.argtypes = [POINTER(tenEstimateContext), POINTER(Nrrd), c_double, c_int]
@@ -7562,6 +7795,9 @@ tenEstimate1TensorSingle_d.argtypes = [POINTER(tenEstimateContext), POINTER(c_do
 tenEstimate1TensorVolume4D = libteem.tenEstimate1TensorVolume4D
 tenEstimate1TensorVolume4D.restype = c_int
 tenEstimate1TensorVolume4D.argtypes = [POINTER(tenEstimateContext), POINTER(Nrrd), POINTER(POINTER(Nrrd)), POINTER(POINTER(Nrrd)), POINTER(Nrrd), c_int]
+tenEstimate1TensorBootstrap = libteem.tenEstimate1TensorBootstrap
+tenEstimate1TensorBootstrap.restype = c_int
+tenEstimate1TensorBootstrap.argtypes = [POINTER(tenEstimateContext), POINTER(Nrrd), POINTER(Nrrd), c_uint, c_uint, c_int]
 tenEstimateContextNix = libteem.tenEstimateContextNix
 tenEstimateContextNix.restype = POINTER(tenEstimateContext)
 tenEstimateContextNix.argtypes = [POINTER(tenEstimateContext)]
@@ -7709,6 +7945,57 @@ tenFiberMultiPolyData.argtypes = [POINTER(tenFiberContext), POINTER(limnPolyData
 tenFiberMultiProbeVals = libteem.tenFiberMultiProbeVals
 tenFiberMultiProbeVals.restype = c_int
 tenFiberMultiProbeVals.argtypes = [POINTER(tenFiberContext), POINTER(Nrrd), POINTER(tenFiberMulti)]
+tenFiberStreamTrace = libteem.tenFiberStreamTrace
+tenFiberStreamTrace.restype = c_int
+tenFiberStreamTrace.argtypes = [POINTER(tenFiberContext), POINTER(tenFiberStream), POINTER(Nrrd)]
+tenFiberStreamNew = libteem.tenFiberStreamNew
+tenFiberStreamNew.restype = POINTER(tenFiberStream)
+tenFiberStreamNew.argtypes = []
+tenFiberStreamNix = libteem.tenFiberStreamNix
+tenFiberStreamNix.restype = POINTER(tenFiberStream)
+tenFiberStreamNix.argtypes = [POINTER(tenFiberStream)]
+tenFiberStreamOpen = libteem.tenFiberStreamOpen
+tenFiberStreamOpen.restype = c_int
+tenFiberStreamOpen.argtypes = [POINTER(tenFiberStream), STRING, c_int, c_uint]
+tenFiberStreamAdd = libteem.tenFiberStreamAdd
+tenFiberStreamAdd.restype = c_int
+tenFiberStreamAdd.argtypes = [POINTER(tenFiberStream), POINTER(tenFiberSingle)]
+tenFiberStreamClose = libteem.tenFiberStreamClose
+tenFiberStreamClose.restype = c_int
+tenFiberStreamClose.argtypes = [POINTER(tenFiberStream)]
+tenFiberStreamMap = libteem.tenFiberStreamMap
+tenFiberStreamMap.restype = c_int
+tenFiberStreamMap.argtypes = [POINTER(tenFiberStream), STRING]
+tenFiberStreamGet = libteem.tenFiberStreamGet
+tenFiberStreamGet.restype = c_int
+tenFiberStreamGet.argtypes = [POINTER(Nrrd), POINTER(Nrrd), POINTER(tenFiberStream), c_uint]
+tenFiberStreamPolyData = libteem.tenFiberStreamPolyData
+tenFiberStreamPolyData.restype = c_int
+tenFiberStreamPolyData.argtypes = [POINTER(limnPolyData), POINTER(tenFiberStream)]
+tenFiberDensity = libteem.tenFiberDensity
+tenFiberDensity.restype = c_int
+tenFiberDensity.argtypes = [POINTER(Nrrd), POINTER(tenFiberMulti), POINTER(tenFiberStream), POINTER(Nrrd), c_int, c_uint, c_uint]
+tenFiberConnectivity = libteem.tenFiberConnectivity
+tenFiberConnectivity.restype = c_int
+tenFiberConnectivity.argtypes = [POINTER(Nrrd), POINTER(Nrrd), POINTER(tenFiberMulti), POINTER(tenFiberStream), POINTER(Nrrd), c_int, c_uint]
+tenFiberIndexNew = libteem.tenFiberIndexNew
+tenFiberIndexNew.restype = POINTER(tenFiberIndex)
+tenFiberIndexNew.argtypes = []
+tenFiberIndexNix = libteem.tenFiberIndexNix
+tenFiberIndexNix.restype = POINTER(tenFiberIndex)
+tenFiberIndexNix.argtypes = [POINTER(tenFiberIndex)]
+tenFiberIndexBuild = libteem.tenFiberIndexBuild
+tenFiberIndexBuild.restype = c_int
+tenFiberIndexBuild.argtypes = [POINTER(tenFiberIndex), POINTER(tenFiberMulti), POINTER(tenFiberStream), POINTER(limnPolyData), c_double, c_uint]
+tenFiberIndexSelect = libteem.tenFiberIndexSelect
+tenFiberIndexSelect.restype = c_int
+tenFiberIndexSelect.argtypes = [POINTER(Nrrd), POINTER(tenFiberIndex), POINTER(tenFiberRegion), c_uint, c_int]
+tenFiberIndexNearest = libteem.tenFiberIndexNearest
+tenFiberIndexNearest.restype = c_int
+tenFiberIndexNearest.argtypes = [POINTER(c_uint), POINTER(c_double), POINTER(tenFiberIndex), POINTER(c_double), c_double]
+tenFiberProbTrace = libteem.tenFiberProbTrace
+tenFiberProbTrace.restype = c_int
+tenFiberProbTrace.argtypes = [POINTER(Nrrd), POINTER(tenFiberContext), POINTER(Nrrd), POINTER(Nrrd), c_uint, c_uint]
 tenEpiRegister3D = libteem.tenEpiRegister3D
 tenEpiRegister3D.restype = c_int
 tenEpiRegister3D.argtypes = [POINTER(POINTER(Nrrd)), POINTER(POINTER(Nrrd)), c_uint, POINTER(Nrrd), c_int, c_double, c_double, c_double, c_double, c_int, POINTER(NrrdKernel), POINTER(c_double), c_int, c_int]
@@ -8538,7 +8825,7 @@ __all__ = ['tenFiberStopUIntSet', 'biffMsgAddf',
            'nrrdField_endian', 'alanRun', 'pullProcessModeNixing',
            'airFPGen_f', 'airFPGen_d', 'airInsane_FltDblFPClass',
            'pullInfoSpecNew', 'nrrdBinaryOpIf', 'nrrdAxisInfoSpacing',
-           'airExists', 'pullInfoLiveThresh', 'gageStackBlurParmNix',
+           'airExists', 'airHalfFromFloat', 'airHalfToFloat', 'pullInfoLiveThresh', 'gageStackBlurParmNix',
            'tenDWMRINexKeyFmt', 'pullInfoInside',
            'tijk_approx_heur_3d_f', 'nrrdBinaryOpLTE',
            'gageErrStackUnused', 'nrrdZeroSet',
@@ -8546,6 +8833,7 @@ __all__ = ['tenFiberStopUIntSet', 'biffMsgAddf',
            'pullEnergyTypeQuartic', 'airHeapMerge',
            'nrrdRangePercentileFromStringSet', 'limnPolyDataCopy',
            'coilMethodArray', 'gageDeconvolveSeparableKnown',
+           'gageDeconvolveSeparableThreaded',
            'coilMethodTypeLast', 'tijk_zero_f', 'nrrdAxisInfoUnknown',
            'tijk_zero_d', 'meetHestConstGageKind', 'miteThreadBegin',
            'nrrdKernelBSpline2DD', 'nrrdTernaryOpMinSmooth',
@@ -8631,7 +8919,7 @@ __all__ = ['tenFiberStopUIntSet', 'biffMsgAddf',
            'nrrdHestBoundarySpec', 'pullIterParmSet',
            'airNoDio_setfl', 'tend_anhistCmd', 'ell_3m_print_f',
            'nrrdKernelBSpline7DDD', 'ell_3m_print_d',
-           'seekTypeMaximalSurface', 'gagePvlFlagNeedD',
+           'seekTypeMaximalSurface', 'gagePvlFlagNeedD', 'gagePvlFlagDeriv',
            'nrrdAxisInfoCompare', 'nrrdBasicInfoComments',
            'airRandInt', 'echoSuperquad', 'nrrdKind3DMaskedSymMatrix',
            'limnPolyDataTransform_f', 'tenGlyphTypeCylinder',
@@ -8972,7 +9260,17 @@ __all__ = ['tenFiberStopUIntSet', 'biffMsgAddf',
            'tijk_approx_rankk_2d_f', 'gageBiffKey', 'gageSclCurvDir2',
            'tenGageRotTans', 'gageSclCurvDir1',
            'nrrdSpaceLeftPosteriorSuperior', 'baneIncLast',
-           'alanTensorSet', 'nrrdHasNonExistTrue', 'gageProbeSpace',
+           'alanTensorSet', 'nrrdHasNonExistTrue', 'gageProbeSpace', 'gageProbeBatch', 'gageProbeScanline',
+           'gageBrickMake', 'gagePerVolumeBrickSet',
+           'gagePerVolumeDerivPrecomputeSet',
+           'gageContextPool', 'gageContextPoolNew', 'gageContextPoolNix',
+           'gageOptimSigContextThreadNumSet',
+           'gageProbeList', 'gageProbeGrid',
+           'gageStoreUnknown', 'gageStoreFull', 'gageStoreHalf',
+           'gageStoreQuant16', 'gageStoreQuant8', 'gageStoreLast',
+           'gageStore', 'gageStoreMake', 'gagePerVolumeStoreSet',
+           'gageStackLazy_t', 'gageStackLazy', 'gageStackLazyNew',
+           'gageStackLazyNix', 'gageStackLazyPerVolumeNew',
            'baneAxis', 'limnSplineInfo', 'pullEnergyTypeLast',
            'nrrdIoStateCharsPerLine', 'NrrdEncoding_t', 'tenGageCa2',
            'pullEnergyBspln', 'pullCountForceFromImage',
@@ -8987,11 +9285,12 @@ __all__ = ['tenFiberStopUIntSet', 'biffMsgAddf',
            'unrrdu_jhistoCmd', 'hestRespFileEnable', 'nrrdSpaceSet',
            'pullCountProbe', 'limnPolyDataNeighborList',
            'limnSplineEvaluate', 'hooverStubRenderBegin',
-           'tijk_refine_rank1_3d_d', 'biffSetStrDone',
+           'tijk_refine_rank1_3d_d', 'biffSetStrDone', 'biffThreadSafe',
            'pullInfoStrength', 'gageKernel10', 'gageKernel11',
            'tenFiberTypeTensorLine', 'airFPFprintf_f',
            'airFPFprintf_d', 'limnSpaceUnknown', 'tenAniso_Mode',
            'gageQueryItemOn', 'nrrdILoad', 'gageDefTwoDimZeroZ',
+           'gageDefSinglePrecision', 'gageParmSinglePrecision',
            'pullPropPosition', 'gageVecVector', 'tenExpSingle_d',
            'airMopPrint', 'tenExpSingle_f', 'Nrrd',
            'tenInterpDistanceTwo_d', 'ell_4m_to_aa_f',
@@ -9213,7 +9512,7 @@ __all__ = ['tenFiberStopUIntSet', 'biffMsgAddf',
            'tenFiberIntgMidpoint', 'meetPullInfoAddMulti',
            'limnWindow', 'tend_bfitCmd', 'nrrdField_old_min',
            'unrrduScaleExact', 'pullConstraintFailIterMaxed',
-           'airThreadBarrierNix', 'ell_q_avg4_d',
+           'airThreadBarrierNix', 'airThreadRun', 'ell_q_avg4_d',
            'coilKindTypeUnknown', 'nrrdTypeFloat', 'airParseStrUI',
            'coilContextNew', 'nrrdKernelBSpline1D', 'airEqvMap',
            'seekTypeLast', 'gageKind_t',
@@ -9345,7 +9644,9 @@ __all__ = ['tenFiberStopUIntSet', 'biffMsgAddf',
            'tenGageOmegaHessianEvec1', 'nrrdBoundary',
            'nrrdAxesPermute', 'tenFiberParmWPunct',
            'limnCameraPathTrackBoth', 'echoMatterMetalSet',
-           'ell_6ms_eigensolve_d', 'limnSplineTypeLinear',
+           'ell_6ms_eigensolve_d', 'ell_6ms_eigensolve_batch_d',
+           'ell_3ms_eigensolve_batch_d',
+           'ell_3ms_eigensolve_batch_f', 'limnSplineTypeLinear',
            'tijk_esh_deconvolve_f', 'gageParmCurvNormalSide',
            'gageSclHessMode', 'tenGageFAGradMag', 'pullPointNumber',
            'pullContextNix', 'limnSplineInfoNormal',
@@ -9478,6 +9779,7 @@ __all__ = ['tenFiberStopUIntSet', 'biffMsgAddf',
            'nrrdField_last', 'NrrdBoundarySpec', 'nrrdHestIter',
            'alanParmVerbose', 'gageVecImaginaryPart',
            'nrrdBasicInfoContent', 'tenEstimateValueMinSet',
+           'tenEstimateThreadNumSet',
            'tijk_3d_sym_to_esh_f', 'limnPolyDataInfoTang',
            'dyeSpaceRGB', 'mossImageAlloc', 'tenGlyphTypeLast',
            'airRandMTStateNew', 'nrrdEnvVarDefaultCenterOld',
@@ -9726,7 +10028,8 @@ __all__ = ['tenFiberStopUIntSet', 'biffMsgAddf',
            'tenDwiGage2TensorPeledLevmarInfo', 'baneMeasrNew',
            'airLogRician', 'tenGageTraceGradVecDotEvec0',
            'tenDwiGageTensorWLSLikelihood', 'nrrdSplice',
-           'nrrdKernelGaussianDD', 'nrrdFFTWEnabled',
+           'nrrdKernelGaussianDD', 'nrrdFFTWEnabled', 'NrrdFFTPlan',
+           'nrrdFFTPlanNew', 'nrrdFFTPlanNix', 'nrrdFFTPlanExecute',
            'nrrdRangeReset', 'nrrdKind3Color', 'airSrandMT',
            'tenGageModeHessianFrob', 'tenGageConfGradVecDotEvec0',
            'echoThreadState', 'tenDwiGageTensorNLS', 'baneInputCheck',
@@ -9765,6 +10068,7 @@ __all__ = ['tenFiberStopUIntSet', 'biffMsgAddf',
            'miteValLast', 'gageErrStackSearch', 'tenGageTraceNormal',
            'nrrdKernelBSpline7DD', 'baneRangeAnswer',
            'gageStackBlurParmOneDimSet', 'airFPPartsToVal_d',
+           'gageStackBlurParmThreadNumSet', 'gageStackBlurStream',
            'nrrdAxesMerge', 'echoJitterLast', 'airIntPow',
            'tenModelBall', 'hooverThreadEnd_t', 'limnQN8checker',
            'nrrdAxisInfoSet_nva', 'nrrdEnvVarStateGrayscaleImage3D',
@@ -9863,7 +10167,16 @@ __all__ = ['tenFiberStopUIntSet', 'biffMsgAddf',
            'meetPullVolStackBlurParmFinishMulti',
            'tenFiberParmVerbose', 'gageStackBlurParmCompare',
            'limnObjectLookAdd', 'tijk_refine_rankk_2d_f',
-           'tenModelNllFit', 'tenFiberMultiTrace',
+           'tenModelNllFit', 'tenFiberStream', 'tenFiberStreamTrace',
+           'tenFiberDirCache', 'tenFiberParmDirCache',
+           'tenFiberProbTrace', 'tenEstimate1TensorBootstrap',
+           'tenFiberDensity', 'tenFiberConnectivity',
+           'tenFiberIndex', 'tenFiberRegion', 'tenFiberIndexNew',
+           'tenFiberIndexNix', 'tenFiberIndexBuild', 'tenFiberIndexSelect',
+           'tenFiberIndexNearest',
+           'tenFiberStreamNew', 'tenFiberStreamNix', 'tenFiberStreamOpen',
+           'tenFiberStreamAdd', 'tenFiberStreamClose', 'tenFiberStreamMap',
+           'tenFiberStreamGet', 'tenFiberStreamPolyData', 'tenFiberMultiTrace',
            'limnEdgeTypeBorder', 'nrrdSpaceOriginGet',
            'nrrdBoundaryUnknown', 'tenInv_f', 'tenInv_d',
            'baneHVolCheck', 'pullInitLiveThreshUseSet',
@@ -10093,7 +10406,7 @@ TEN_DWI_FIBER_TYPE_MAX = 3
 TEN_FIBER_INTG_MAX = 3
 TEN_FIBER_STOP_MAX = 10
 TEN_FIBER_NUM_STEPS_MAX = 10240
-TEN_FIBER_PARM_MAX = 4
+TEN_FIBER_PARM_MAX = 5
 TEN_TRIPLE_TYPE_MAX = 9
 TEN_MODEL_B0_MAX = 65500    # HEY: fairly arbitrary, but is set to be
 TEN_MODEL_DIFF_MAX = 0.006  # in units of mm^2/sec; diffusivity of
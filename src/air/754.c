@@ -676,3 +676,75 @@ airFPFprintf_d(FILE *file, double val) {
   }
 }
 
+
+/*
+******** airHalfFromFloat, airHalfToFloat
+**
+** conversion between float and IEEE 754 half-precision floats (1 sign
+** bit, 5 exponent bits, 10 mantissa bits), stored in an unsigned short,
+** with round-to-nearest-even, and with overflow going to infinity.
+** Every half is exactly representable as a float.
+*/
+unsigned short
+airHalfFromFloat(float val) {
+  airFloat fv;
+  unsigned int sign, expo, mant, shift, rem, half, hh;
+  int ee;
+
+  fv.f = val;
+  sign = (fv.i >> 16) & 0x8000;
+  expo = (fv.i >> 23) & 0xff;
+  mant = fv.i & 0x7fffff;
+  if (0xff == expo) {
+    /* inf or nan, keeping nan-ness */
+    return AIR_CAST(unsigned short, sign | 0x7c00 | (mant ? 0x200 : 0));
+  }
+  ee = AIR_CAST(int, expo) - 127 + 15;
+  if (ee >= 31) {
+    return AIR_CAST(unsigned short, sign | 0x7c00);
+  }
+  if (ee <= 0) {
+    /* half-precision subnormal, or zero */
+    if (ee < -10) {
+      return AIR_CAST(unsigned short, sign);
+    }
+    mant |= 0x800000;
+    shift = AIR_CAST(unsigned int, 14 - ee);
+    hh = mant >> shift;
+    rem = mant & ((1u << shift) - 1);
+    half = 1u << (shift - 1);
+    if (rem > half || (rem == half && (hh & 1))) {
+      hh++;
+    }
+    return AIR_CAST(unsigned short, sign | hh);
+  }
+  hh = (AIR_CAST(unsigned int, ee) << 10) | (mant >> 13);
+  rem = mant & 0x1fff;
+  if (rem > 0x1000 || (rem == 0x1000 && (hh & 1))) {
+    /* a carry into the exponent is correct, including to infinity */
+    hh++;
+  }
+  return AIR_CAST(unsigned short, sign | hh);
+}
+
+float
+airHalfToFloat(unsigned short hv) {
+  airFloat fv;
+  unsigned int sign, expo, mant;
+  float ret;
+
+  sign = AIR_CAST(unsigned int, hv & 0x8000) << 16;
+  expo = (hv >> 10) & 0x1f;
+  mant = hv & 0x3ff;
+  if (!expo) {
+    /* subnormal or zero: mant * 2^-24 */
+    ret = AIR_CAST(float, mant/16777216.0);
+    return sign ? -ret : ret;
+  }
+  if (0x1f == expo) {
+    fv.i = sign | 0x7f800000 | (mant << 13);
+  } else {
+    fv.i = sign | ((expo - 15 + 127) << 23) | (mant << 13);
+  }
+  return fv.f;
+}
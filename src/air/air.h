@@ -356,6 +356,9 @@ AIR_EXPORT airThreadBarrier *airThreadBarrierNew(unsigned numUsers);
 AIR_EXPORT int airThreadBarrierWait(airThreadBarrier *barrier);
 AIR_EXPORT airThreadBarrier *airThreadBarrierNix(airThreadBarrier *barrier);
 
+AIR_EXPORT int airThreadRun(void *(*threadBody)(void *), void *arg,
+                            size_t argSize, unsigned int threadNum);
+
 /* ---- END non-NrrdIO */
 
 /*
@@ -426,6 +429,8 @@ AIR_EXPORT int airIsNaN(double d);
 AIR_EXPORT int airIsInf_f(float f);
 AIR_EXPORT int airIsInf_d(double d);
 AIR_EXPORT int airExists(double d);
+AIR_EXPORT unsigned short airHalfFromFloat(float val);
+AIR_EXPORT float airHalfToFloat(unsigned short hv);
 
 /* ---- BEGIN non-NrrdIO */
 
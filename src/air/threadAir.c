@@ -593,3 +593,64 @@ airThreadBarrierNix(airThreadBarrier *barrier) {
   airFree(barrier);
   return NULL;
 }
+
+/*
+******** airThreadRun
+**
+** runs threadBody in threadNum threads, with (char *)arg + ti*argSize as
+** the argument of thread ti (so arg is usually an array of per-thread
+** structs).  Thread 0 is the calling thread, which works alongside the
+** threadNum-1 threads started here, and this returns only after all of
+** them are done.
+**
+** If a thread can't be started, the threads that were started are still
+** joined before this returns (and the calling thread doesn't do its share
+** of the work), so that the caller can safely free what the threads use.
+** Because of this, threadBody should not wait on the other threads (as
+** with airThreadBarrierWait).  Returns non-zero if there was a problem
+** starting or joining any thread.
+*/
+int
+airThreadRun(void *(*threadBody)(void *), void *arg, size_t argSize,
+             unsigned int threadNum) {
+  airThread **thread;
+  char *carg;
+  void *ret;
+  unsigned int ti, startNum;
+  int err;
+
+  if (!( threadBody && arg && threadNum )) {
+    return 1;
+  }
+  carg = AIR_CAST(char *, arg);
+  thread = NULL;
+  if (1 < threadNum) {
+    if (!( thread = AIR_CALLOC(threadNum, airThread *) )) {
+      return 1;
+    }
+  }
+  err = 0;
+  for (startNum=1; startNum<threadNum; startNum++) {
+    if (!( thread[startNum] = airThreadNew() )
+        || airThreadStart(thread[startNum], threadBody,
+                          AIR_CAST(void *, carg + startNum*argSize))) {
+      err = 1;
+      break;
+    }
+  }
+  if (!err) {
+    threadBody(AIR_CAST(void *, carg));
+  }
+  for (ti=1; ti<startNum; ti++) {
+    if (airThreadJoin(thread[ti], &ret)) {
+      err = 1;
+    }
+  }
+  for (ti=1; ti<threadNum; ti++) {
+    if (thread[ti]) {
+      airThreadNix(thread[ti]);
+    }
+  }
+  airFree(thread);
+  return err;
+}
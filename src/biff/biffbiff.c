@@ -38,6 +38,28 @@ static unsigned int
 _bmsgNum=0;            /* length of _biffErr == # keys maintained */
 static airArray *
 _bmsgArr=NULL;         /* air array of _biffErr and _biffNum */
+/* ---- BEGIN non-NrrdIO */
+static airThreadMutex *
+_bmsgMutex=NULL;       /* if non-NULL (from biffThreadSafe()), held
+                          around all use of the above */
+#define _BMSG_LOCK                                \
+  do {                                            \
+    if (_bmsgMutex) {                             \
+      airThreadMutexLock(_bmsgMutex);             \
+    }                                             \
+  } while (0)
+#define _BMSG_UNLOCK                              \
+  do {                                            \
+    if (_bmsgMutex) {                             \
+      airThreadMutexUnlock(_bmsgMutex);           \
+    }                                             \
+  } while (0)
+/* ---- END non-NrrdIO */
+#ifndef _BMSG_LOCK
+/* NrrdIO has no threads, so there is nothing to lock */
+#  define _BMSG_LOCK do { } while (0)
+#  define _BMSG_UNLOCK do { } while (0)
+#endif
 
 #define __INCR 2
 
@@ -175,9 +197,11 @@ void
 biffAdd(const char *key, const char *err) {
   biffMsg *msg;
 
+  _BMSG_LOCK;
   _bmsgStart();
   msg = _bmsgAdd(key);
   biffMsgAdd(msg, err);
+  _BMSG_UNLOCK;
   return;
 }
 
@@ -185,9 +209,11 @@ static void
 _biffAddVL(const char *key, const char *errfmt, va_list args) {
   biffMsg *msg;
 
+  _BMSG_LOCK;
   _bmsgStart();
   msg = _bmsgAdd(key);
   _biffMsgAddVL(msg, errfmt, args);
+  _BMSG_UNLOCK;
   return;
 }
 
@@ -265,8 +291,8 @@ biffMaybeAddf(int useBiff, const char *key, const char *errfmt, ...) {
 ** be considered a glorified strdup(): it is the callers responsibility
 ** to free() this string later
 */
-char * /*Teem: allocates char* */     /* this comment is an experiment */
-biffGet(const char *key) {
+static char *
+_biffGet(const char *key) {
   static const char me[]="biffGet";
   char *ret;
   biffMsg *msg;
@@ -296,6 +322,16 @@ biffGet(const char *key) {
   return ret;
 }
 
+char * /*Teem: allocates char* */     /* this comment is an experiment */
+biffGet(const char *key) {
+  char *ret;
+
+  _BMSG_LOCK;
+  ret = _biffGet(key);
+  _BMSG_UNLOCK;
+  return ret;
+}
+
 /*
 ******** biffGetStrlen()
 **
@@ -308,13 +344,16 @@ biffGetStrlen(const char *key) {
   biffMsg *msg;
   unsigned int len;
 
+  _BMSG_LOCK;
   _bmsgStart();
   msg = _bmsgFind(key);
   if (!msg) {
+    _BMSG_UNLOCK;
     fprintf(stderr, "%s: WARNING: no information for key \"%s\"\n", me, key);
     return 0;
   }
   len = biffMsgStrlen(msg);
+  _BMSG_UNLOCK;
   len += 1;  /* GLK forgets if the convention is that the caller allocates
                 for one more to include '\0'; this is safer */
   return len;
@@ -326,8 +365,8 @@ biffGetStrlen(const char *key) {
 ** for when you want to allocate the buffer for the biff string, this is
 ** how you get the error message itself
 */
-void
-biffSetStr(char *str, const char *key) {
+static void
+_biffSetStr(char *str, const char *key) {
   static const char me[]="biffSetStr";
   biffMsg *msg;
 
@@ -347,6 +386,15 @@ biffSetStr(char *str, const char *key) {
   return;
 }
 
+void
+biffSetStr(char *str, const char *key) {
+
+  _BMSG_LOCK;
+  _biffSetStr(str, key);
+  _BMSG_UNLOCK;
+  return;
+}
+
 /*
 ******** biffCheck()
 **
@@ -355,9 +403,13 @@ biffSetStr(char *str, const char *key) {
 */
 unsigned int
 biffCheck(const char *key) {
+  unsigned int ret;
 
+  _BMSG_LOCK;
   _bmsgStart();
-  return biffMsgErrNum(_bmsgFind(key));
+  ret = biffMsgErrNum(_bmsgFind(key));
+  _BMSG_UNLOCK;
+  return ret;
 }
 
 /*
@@ -366,8 +418,8 @@ biffCheck(const char *key) {
 ** frees everything associated with given key, and shrinks list of keys,
 ** and calls _bmsgFinish() if there are no keys left
 */
-void
-biffDone(const char *key) {
+static void
+_biffDone(const char *key) {
   static const char me[]="biffDone";
   unsigned int idx;
   biffMsg *msg;
@@ -395,19 +447,31 @@ biffDone(const char *key) {
   return;
 }
 
+void
+biffDone(const char *key) {
+
+  _BMSG_LOCK;
+  _biffDone(key);
+  _BMSG_UNLOCK;
+  return;
+}
+
 void
 biffMove(const char *destKey, const char *err, const char *srcKey) {
   static const char me[]="biffMove";
   biffMsg *dest, *src;
 
+  _BMSG_LOCK;
   _bmsgStart();
   dest = _bmsgAdd(destKey);
   src = _bmsgFind(srcKey);
   if (!src) {
+    _BMSG_UNLOCK;
     fprintf(stderr, "%s: WARNING: key \"%s\" unknown\n", me, srcKey);
     return;
   }
   biffMsgMove(dest, src, err);
+  _BMSG_UNLOCK;
   return;
 }
 
@@ -417,14 +481,17 @@ _biffMoveVL(const char *destKey, const char *srcKey,
   static const char me[]="biffMovev";
   biffMsg *dest, *src;
 
+  _BMSG_LOCK;
   _bmsgStart();
   dest = _bmsgAdd(destKey);
   src = _bmsgFind(srcKey);
   if (!src) {
+    _BMSG_UNLOCK;
     fprintf(stderr, "%s: WARNING: key \"%s\" unknown\n", me, srcKey);
     return;
   }
   _biffMsgMoveVL(dest, src, errfmt, args);
+  _BMSG_UNLOCK;
   return;
 }
 
@@ -443,11 +510,13 @@ char *
 biffGetDone(const char *key) {
   char *ret;
 
+  _BMSG_LOCK;
   _bmsgStart();
 
-  ret = biffGet(key);
-  biffDone(key);  /* will call _bmsgFinish if this is the last key */
+  ret = _biffGet(key);
+  _biffDone(key);  /* will call _bmsgFinish if this is the last key */
 
+  _BMSG_UNLOCK;
   return ret;
 }
 
@@ -455,12 +524,45 @@ biffGetDone(const char *key) {
 void
 biffSetStrDone(char *str, const char *key) {
 
+  _BMSG_LOCK;
   _bmsgStart();
 
-  biffSetStr(str, key);
-  biffDone(key);  /* will call _bmsgFinish if this is the last key */
+  _biffSetStr(str, key);
+  _biffDone(key);  /* will call _bmsgFinish if this is the last key */
 
+  _BMSG_UNLOCK;
   return;
 }
+
+/*
+******** biffThreadSafe()
+**
+** biff's record of messages for all keys is global, so by default biff
+** can't be used by more than one thread at a time.  After this is called,
+** all the biff functions (but not the biffMsg functions) lock a mutex
+** around their use of that record, so that code which uses biff can be
+** run by multiple threads at once.  There is no going back, and it can
+** be harmlessly called multiple times, but the first call creates the
+** mutex without any locking, so it has to happen while only one thread
+** is running biff-using code: before the threads that use biff are
+** started.  Library functions that start such threads (like
+** tenEstimate1TensorVolume4D and tenFiberMultiTrace) call this in their
+** single-threaded setup, so a program that itself calls those from more
+** than one thread at a time has to first call this from its main thread.
+** Returns non-zero if the mutex couldn't be created.
+**
+** The mutex lives for the rest of the process: it is not freed by
+** biffDone(), even for the last key, because another thread may be
+** waiting on it at that moment, and a later biffAdd() would have to
+** re-create it behind the back of any running threads.
+*/
+int
+biffThreadSafe(void) {
+
+  if (!_bmsgMutex) {
+    _bmsgMutex = airThreadMutexNew();
+  }
+  return !_bmsgMutex;
+}
 /* ---- END non-NrrdIO */
 /* this is the end */
@@ -53,7 +53,7 @@ main(int argc, const char *argv[]) {
   hestOpt *hopt = NULL;
   NrrdKernelSpec *ksp;
   int otype, separ, ret;
-  unsigned int maxIter;
+  unsigned int maxIter, threadNum;
   double epsilon, lastDiff, step;
   Nrrd *nin, *nout;
   airArray *mop;
@@ -86,6 +86,8 @@ main(int argc, const char *argv[]) {
   hestOptAdd(&hopt, "sep", "bool", airTypeBool, 1, 1, &separ, "false",
              "use fast separable deconvolution instead of brain-dead "
              "brute-force iterative method");
+  hestOptAdd(&hopt, "nt", "# threads", airTypeUInt, 1, 1, &threadNum, "1",
+             "number of threads to use for separable deconvolution");
   hestOptAdd(&hopt, "o", "nout", airTypeString, 1, 1, &outS, "-",
              "output volume");
   hestParseOrDie(hopt, argc-1, argv+1, hparm,
@@ -97,7 +99,8 @@ main(int argc, const char *argv[]) {
   airMopAdd(mop, nout, AIR_CAST(airMopper, nrrdNuke), airMopAlways);
 
   if (separ) {
-    ret = gageDeconvolveSeparable(nout, nin, kind, ksp, otype);
+    ret = gageDeconvolveSeparableThreaded(nout, nin, kind, ksp, otype,
+                                          threadNum);
   } else {
     ret = gageDeconvolve(nout, &lastDiff,
                          nin, kind,
@@ -45,23 +45,23 @@ printans(FILE *file, const double *ans, unsigned int len) {
 }
 
 static int
-gridProbe(gageContext *ctx, gagePerVolume *pvl, int what,
+gridProbe(gageContextPool *pool, gagePerVolume *pvl, int what,
           Nrrd *nout, int typeOut, Nrrd *_ngrid,
-          int indexSpace, int verbose, int clamp) {
+          int indexSpace, int clamp) {
   char me[]="gridProbe";
+  gageContext *ctx;
   Nrrd *ngrid;
   airArray *mop;
-  double *grid, pos[4];
-  const double *answer;
-  unsigned int ansLen, dim, aidx, baseDim, gridDim;
-  size_t sizeOut[NRRD_DIM_MAX], coordOut[NRRD_DIM_MAX], II, NN;
-  double (*ins)(void *v, size_t I, double d);
-  char stmp[2][AIR_STRLEN_SMALL];
+  double *grid, edge[4*NRRD_DIM_MAX];
+  unsigned int aidx, gridDim;
+  size_t sizeOut[NRRD_DIM_MAX], failNum;
+  char stmp[AIR_STRLEN_SMALL];
 
-  if (!(ctx && pvl && nout && _ngrid)) {
+  if (!(pool && pvl && nout && _ngrid)) {
     biffAddf(GAGE, "%s: got NULL pointer", me);
     return 1;
   }
+  ctx = pool->tctx[0];
   if (airEnumValCheck(nrrdType, typeOut)) {
     biffAddf(GAGE, "%s: type %d not valid", me, typeOut);
     return 1;
@@ -115,83 +115,30 @@ gridProbe(gageContext *ctx, gagePerVolume *pvl, int what,
              1 + gridDim, gridDim);
     airMopError(mop); return 1;
   }
-  answer = gageAnswerPointer(ctx, pvl, what);
-  ansLen = pvl->kind->table[what].answerLength;
-  baseDim = 1 == ansLen ? 0 : 1;
-  dim = baseDim + gridDim;
-  if (dim > NRRD_DIM_MAX) {
-    biffAddf(GAGE, "%s: output dimension %u unreasonable", me, dim);
+  if (!( 1 <= gridDim && gridDim <= NRRD_DIM_MAX-1 )) {
+    biffAddf(GAGE, "%s: grid dimension %u unreasonable", me, gridDim);
     airMopError(mop); return 1;
   }
-  if (ansLen > 1) {
-    sizeOut[0] = ansLen;
-    coordOut[0] = 0;
-  }
-  NN = 1;
   for (aidx=0; aidx<gridDim; aidx++) {
-    sizeOut[aidx + baseDim] = AIR_ROUNDUP_UI(grid[0 + 5*(aidx+1)]);
-    NN *= sizeOut[aidx + baseDim];
-    coordOut[aidx + baseDim] = 0;
+    sizeOut[aidx] = AIR_ROUNDUP_UI(grid[0 + 5*(aidx+1)]);
+    ELL_4V_COPY(edge + 4*aidx, grid + 1 + 5*(1+aidx));
   }
-  if (nrrdMaybeAlloc_nva(nout, typeOut, dim, sizeOut)) {
-    biffMovef(GAGE, NRRD, "%s: couldn't allocate output", me);
+  if (gageProbeGrid(pool, &nout, &failNum,
+                    AIR_CAST(const gagePerVolume *const *, &pvl), &what, 1,
+                    typeOut, gridDim, sizeOut, grid + 1 + 5*0, edge,
+                    indexSpace, clamp)) {
+    biffAddf(GAGE, "%s: trouble probing", me);
     airMopError(mop); return 1;
   }
-  ins = nrrdDInsert[nout->type];
-  for (II=0; II<NN; II++) {
-    int E;
-    if (verbose && 3 == gridDim && !coordOut[0] && !coordOut[1]) {
-      if (verbose > 1) {
-        fprintf(stderr, "z = ");
-      }
-      fprintf(stderr, " %s/%s",
-              airSprintSize_t(stmp[0], coordOut[2]),
-              airSprintSize_t(stmp[1], sizeOut[2]));
-      fflush(stderr);
-      if (verbose > 1) {
-        fprintf(stderr, "\n");
-      }
-    }
-    ELL_4V_COPY(pos, grid + 1 + 5*0);
-    for (aidx=0; aidx<gridDim; aidx++) {
-      ELL_4V_SCALE_ADD2(pos, 1, pos,
-                        AIR_CAST(double, coordOut[aidx + baseDim]),
-                        grid + 1 + 5*(1+aidx));
-    }
-    /*
-    printf("%s: %u -> (%u %u) -> %g %g %g %g (%s)\n", me,
-           AIR_UINT(II),
-           AIR_UINT(coordOut[0+baseDim]),
-           AIR_UINT(coordOut[1+baseDim]),
-           pos[0], pos[1], pos[2], pos[3],
-           indexSpace ? "index" : "world");
-    */
-    E = (ctx->stackPos
-         ? gageStackProbeSpace(ctx, pos[0], pos[1], pos[2], pos[3],
-                               indexSpace, clamp)
-         : gageProbeSpace(ctx, pos[0], pos[1], pos[2],
-                          indexSpace, clamp));
-    if (E) {
-      biffAddf(GAGE, "%s: trouble at II=%s =(%g,%g,%g,%g):\n%s\n(%d)\n", me,
-               airSprintSize_t(stmp[0], II),
-               pos[0], pos[1], pos[2], pos[3],
-               ctx->errStr, ctx->errNum);
-      airMopError(mop); return 1;
-    }
-    if (1 == ansLen) {
-      ins(nout->data, II, *answer);
-    } else {
-      for (aidx=0; aidx<ansLen; aidx++) {
-        ins(nout->data, aidx + ansLen*II, answer[aidx]);
-      }
-    }
-    NRRD_COORD_INCR(coordOut, sizeOut, dim, baseDim);
-  }
-  if (verbose && verbose <= 1) {
-    fprintf(stderr, "\n");
+  if (failNum) {
+    biffAddf(GAGE, "%s: %s probes failed", me,
+             airSprintSize_t(stmp, failNum));
+    airMopError(mop); return 1;
   }
 
   if (!indexSpace) {
+    unsigned int baseDim;
+    baseDim = nout->dim - gridDim;
     /* set the output space directions, but (being conservative/cautious)
        only do so when grid had specified world-space positions */
     /* HEY: untested! whipped up out of frustration for GLK Bonn talk */
@@ -224,14 +171,15 @@ main(int argc, const char *argv[]) {
   NrrdKernelSpec *k00, *k11, *k22, *kSS, *kSSblur;
   int what, E=0, renorm, uniformSS, optimSS, verbose, zeroZ,
     orientationFromSpacing, probeSpaceIndex, normdSS;
-  unsigned int iBaseDim, oBaseDim, axi, numSS, seed;
+  unsigned int iBaseDim, oBaseDim, axi, numSS, seed, threadNum;
   const double *answer;
-  Nrrd *nin, *_npos, *npos, *_ngrid, *ngrid, *nout, **ninSS=NULL;
+  Nrrd *nin, *_npos, *_ngrid, *ngrid, *nout, **ninSS=NULL;
   Nrrd *ngrad=NULL, *nbmat=NULL;
   size_t six, siy, siz, sox, soy, soz;
   double bval=0, eps, gmc, rangeSS[2], *pntPos, scale[3], posSS, biasSS,
     dsix, dsiy, dsiz, dsox, dsoy, dsoz;
   gageContext *ctx;
+  gageContextPool *pool;
   gagePerVolume *pvl=NULL;
   double t0, t1, rscl[3], min[3], maxOut[3], maxIn[3];
   airArray *mop;
@@ -386,6 +334,10 @@ main(int argc, const char *argv[]) {
              "whether the probe location specification (by any of "
              "the four previous flags) are in index space");
 
+  hestOptAdd(&hopt, "nt", "# threads", airTypeUInt, 1, 1, &threadNum, "1",
+             "number of threads to probe with, when probing on a grid or "
+             "at a list of positions, and to compute scale-space blurrings "
+             "with (when not given by \"-sbp\")");
   hestOptAdd(&hopt, "t", "type", airTypeEnum, 1, 1, &otype, "float",
              "type of output volume", NULL, nrrdType);
   hestOptAdd(&hopt, "o", "nout", airTypeString, 1, 1, &outS, "-",
@@ -475,6 +427,7 @@ main(int argc, const char *argv[]) {
           || gageStackBlurParmKernelSet(sbpIN, kSSblur)
           || gageStackBlurParmRenormalizeSet(sbpIN, AIR_TRUE)
           || gageStackBlurParmBoundarySet(sbpIN, nrrdBoundaryBleed, AIR_NAN)
+          || gageStackBlurParmThreadNumSet(sbpIN, threadNum)
           || gageStackBlurManage(&ninSS, &recompute, sbpIN,
                                  stackFnameFormat, AIR_TRUE, NULL,
                                  nin, kind)) {
@@ -636,9 +589,7 @@ main(int argc, const char *argv[]) {
 
   if (_npos) {
     /* given a nrrd of probe locations */
-    double *pos, (*ins)(void *v, size_t I, double d);
-    size_t II, NN;
-    unsigned int aidx;
+    size_t failNum;
     if (!(2 == _npos->dim
           && (3 == _npos->axis[0].size || 4 == _npos->axis[0].size))) {
       fprintf(stderr, "%s: need npos 2-D 3-by-N or 4-by-N "
@@ -653,51 +604,31 @@ main(int argc, const char *argv[]) {
               sbp ? "are" : "are not");
       airMopError(mop); return 1;
     }
-    NN = _npos->axis[1].size;
-    npos = nrrdNew();
-    airMopAdd(mop, npos, AIR_CAST(airMopper, nrrdNuke), airMopAlways);
     nout = nrrdNew();
     airMopAdd(mop, nout, AIR_CAST(airMopper, nrrdNuke), airMopAlways);
-    if (nrrdConvert(npos, _npos, nrrdTypeDouble)
-        || nrrdMaybeAlloc_va(nout, otype, 2,
-                             AIR_CAST(size_t, ansLen),
-                             AIR_CAST(size_t, NN))) {
-      airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
-      fprintf(stderr, "%s: trouble with npos or nout:\n%s\n", me, err);
+    E = 0;
+    if (!E) E |= !(pool = gageContextPoolNew(ctx, threadNum));
+    if (!E) airMopAdd(mop, pool, AIR_CAST(airMopper, gageContextPoolNix),
+                      airMopAlways);
+    if (!E) E |= gageProbeList(pool, &nout, &failNum,
+                               AIR_CAST(const gagePerVolume *const *, &pvl),
+                               &what, 1, otype, _npos,
+                               probeSpaceIndex, clamp);
+    if (E) {
+      airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble probing:\n%s\n", me, err);
       airMopError(mop); return 1;
     }
-
-    pos = AIR_CAST(double *, npos->data);
-    ins = nrrdDInsert[nout->type];
-    for (II=0; II<NN; II++) {
-      if (sbp) {
-        gageStackProbeSpace(ctx, pos[0], pos[1], pos[2], pos[3],
-                            probeSpaceIndex, clamp);
-      } else {
-        gageProbeSpace(ctx, pos[0], pos[1], pos[2],
-                       probeSpaceIndex, clamp);
-      }
-      if (1 == ansLen) {
-        ins(nout->data, II, *answer);
-      } else {
-        for (aidx=0; aidx<ansLen; aidx++) {
-          ins(nout->data, aidx + ansLen*II, answer[aidx]);
-        }
-      }
-      /*
-      if (sbp) {
-        printf("%s: %s(%s:%g,%g,%g,%g) = ", me, airEnumStr(kind->enm, what),
-               probeSpaceIndex ? "index" : "world",
-               pos[0], pos[1], pos[2], pos[3]);
-      } else {
-        printf("%s: %s(%s:%g,%g,%g) = ", me, airEnumStr(kind->enm, what),
-               probeSpaceIndex ? "index" : "world",
-               pos[0], pos[1], pos[2]);
-      }
-      printans(stdout, answer, ansLen);
-      printf("\n");
-      */
-      pos += _npos->axis[0].size;
+    if (failNum && verbose) {
+      fprintf(stderr, "%s: %s of %s probes failed (answers are NaN)\n", me,
+              airSprintSize_t(stmp[0], failNum),
+              airSprintSize_t(stmp[1], _npos->axis[1].size));
+    }
+    /* output is always ansLen-by-N, even for scalar answers */
+    if (1 == ansLen && nrrdAxesInsert(nout, nout, 0)) {
+      airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble with nout:\n%s\n", me, err);
+      airMopError(mop); return 1;
     }
     if (nrrdSave(outS, nout, NULL)) {
       airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
@@ -832,12 +763,19 @@ main(int argc, const char *argv[]) {
   nout = nrrdNew();
   airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopAlways);
   gageParmSet(ctx, gageParmVerbose, verbose);
+  pool = gageContextPoolNew(ctx, threadNum);
+  if (!pool) {
+    airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble making context pool:\n%s\n", me, err);
+    airMopError(mop); return 1;
+  }
+  airMopAdd(mop, pool, AIR_CAST(airMopper, gageContextPoolNix), airMopAlways);
   t0 = airTime();
-  if (gridProbe(ctx, pvl, what, nout, otype, ngrid,
+  if (gridProbe(pool, pvl, what, nout, otype, ngrid,
                 (_ngrid
                  ? probeSpaceIndex  /* user specifies grid space */
                  : AIR_TRUE),       /* copying vprobe index-space behavior */
-                verbose, clamp)) {
+                clamp)) {
     /* note hijacking of GAGE key */
     airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
     fprintf(stderr, "%s: trouble probing on grid:\n%s\n", me, err);
@@ -70,7 +70,7 @@ main(int argc, const char *argv[]) {
   NrrdKernelSpec *k00, *k11, *k22, *kSS, *kSSblur;
   float pos[3], lineInfo[4];
   double gmc, rangeSS[2], posSS;
-  unsigned int ansLen, numSS, ninSSIdx, lineStepNum;
+  unsigned int ansLen, numSS, ninSSIdx, lineStepNum, threadNum;
   int what, E=0, renorm, SSnormd, SSuniform, verbose, orientationFromSpacing;
   const double *answer;
   Nrrd *nin, **ninSS=NULL, *nout=NULL;
@@ -163,6 +163,10 @@ main(int argc, const char *argv[]) {
   hestOptAdd(&hopt, "ofs", "ofs", airTypeInt, 0, 0, &orientationFromSpacing,
              NULL, "If only per-axis spacing is available, use that to "
              "guess orientation info");
+  hestOptAdd(&hopt, "nt", "# threads", airTypeUInt, 1, 1, &threadNum, "1",
+             "number of threads to probe with, when probing on polydata "
+             "vertices or along a line, and to compute scale-space "
+             "blurrings with");
   hestOptAdd(&hopt, "o", "nout", airTypeString, 1, 1, &outS, "-",
              "output array, when probing on polydata vertices");
   hestParseOrDie(hopt, argc-1, argv+1, hparm,
@@ -232,6 +236,7 @@ main(int argc, const char *argv[]) {
         || gageStackBlurParmKernelSet(sbp, kSSblur)
         || gageStackBlurParmRenormalizeSet(sbp, AIR_TRUE)
         || gageStackBlurParmBoundarySet(sbp, nrrdBoundaryBleed, AIR_NAN)
+        || gageStackBlurParmThreadNumSet(sbp, threadNum)
         || gageStackBlurParmVerboseSet(sbp, verbose)
         || gageStackBlur(ninSS, sbp, nin, kind)) {
       airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
@@ -293,103 +298,93 @@ main(int argc, const char *argv[]) {
 
   /* test with original context */
   answer = gageAnswerPointer(ctx, pvl, what);
-  if (lpld) {
-    /* probing on locations of polydata */
-    double *dout, xyzw[4];
-    unsigned int vidx, ai;
+  if (lpld || lineStepNum) {
+    /* probing on locations of polydata, or along a line */
+    Nrrd *npos;
+    gageContextPool *pool;
+    double *ppos;
+    size_t posNum, failNum;
+    unsigned int vidx, posLen;
+    int clamp;
+    char stmp[2][AIR_STRLEN_SMALL];
+    posLen = numSS ? 4 : 3;
+    posNum = lpld ? lpld->xyzwNum : lineStepNum;
+    npos = nrrdNew();
+    airMopAdd(mop, npos, (airMopper)nrrdNuke, airMopAlways);
     nout = nrrdNew();
     airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopAlways);
-    if (1 == ansLen) {
-      E = nrrdAlloc_va(nout, nrrdTypeDouble, 1,
-                       AIR_CAST(size_t, lpld->xyzwNum));
-    } else {
-      E = nrrdAlloc_va(nout, nrrdTypeDouble, 2,
-                       AIR_CAST(size_t, ansLen),
-                       AIR_CAST(size_t, lpld->xyzwNum));
-    }
-    if (E) {
+    if (nrrdAlloc_va(npos, nrrdTypeDouble, 2,
+                     AIR_CAST(size_t, posLen), posNum)) {
       airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
       fprintf(stderr, "%s: trouble:\n%s\n", me, err);
       airMopError(mop);
       return 1;
     }
-    dout = AIR_CAST(double *, nout->data);
-    for (vidx=0; vidx<lpld->xyzwNum; vidx++) {
-      ELL_4V_COPY(xyzw, lpld->xyzw + 4*vidx);
-      ELL_4V_HOMOG(xyzw, xyzw);
-      if (gageProbeSpace(ctx, xyzw[0], xyzw[1], xyzw[2],
-                         !worldSpace, AIR_TRUE)) {
-        fprintf(stderr, "%s: trouble:\n%s\n(%d)\n",
-                me, ctx->errStr, ctx->errNum);
-        airMopError(mop);
-        return 1;
+    ppos = AIR_CAST(double *, npos->data);
+    if (lpld) {
+      double xyzw[4];
+      for (vidx=0; vidx<lpld->xyzwNum; vidx++) {
+        ELL_4V_COPY(xyzw, lpld->xyzw + 4*vidx);
+        ELL_4V_HOMOG(xyzw, xyzw);
+        ELL_3V_COPY(ppos + posLen*vidx, xyzw);
       }
-      for (ai=0; ai<ansLen; ai++) {
-        dout[ai + ansLen*vidx] = answer[ai];
+      clamp = AIR_TRUE;
+    } else {
+      /* we're probing along a line */
+      double start[3], dir[3], end[3];
+      ELL_3V_COPY(start, pos);
+      if (lineInfo[3]) {
+        double tmp;
+        /* stepping along vector */
+        ELL_3V_COPY(dir, 0 + lineInfo);
+        ELL_3V_SET(end, AIR_NAN, AIR_NAN, AIR_NAN);
+        ELL_3V_NORM(dir, dir, tmp);
+        if (!tmp) {
+          fprintf(stderr, "%s: requested vector stepping, but vlen = 0", me);
+          airMopError(mop);
+          return 1;
+        }
+        ELL_3V_SCALE(dir, lineInfo[3], dir);
+      } else {
+        /* stepping between points */
+        ELL_3V_SET(dir, AIR_NAN, AIR_NAN, AIR_NAN);
+        ELL_3V_COPY(end, 0 + lineInfo);
       }
+      for (vidx=0; vidx<lineStepNum; vidx++) {
+        if (lineInfo[3]) {
+          ELL_3V_SCALE_ADD2(ppos + posLen*vidx, 1, start, vidx, dir);
+        } else {
+          ELL_3V_AFFINE(ppos + posLen*vidx, 0, vidx, lineStepNum-1,
+                        start, end);
+        }
+      }
+      clamp = AIR_FALSE;
     }
-    if (nrrdSave(outS, nout, NULL)) {
-      airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
-      fprintf(stderr, "%s: trouble saving output:\n%s\n", me, err);
-      airMopError(mop);
-      return 1;
-    }
-  } else if (lineStepNum) {
-    /* we're probing along a line */
-    double *dout;
-    double start[3], dir[3], end[3], lpos[3];
-    unsigned int vidx, ai;
-    nout = nrrdNew();
-    airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopAlways);
-    if (1 == ansLen) {
-      E = nrrdAlloc_va(nout, nrrdTypeDouble, 1,
-                       AIR_CAST(size_t, lineStepNum));
-    } else {
-      E = nrrdAlloc_va(nout, nrrdTypeDouble, 2,
-                       AIR_CAST(size_t, ansLen),
-                       AIR_CAST(size_t, lineStepNum));
+    if (numSS) {
+      for (vidx=0; vidx<posNum; vidx++) {
+        ppos[3 + posLen*vidx] = posSS;
+      }
     }
+    E = 0;
+    if (!E) E |= !(pool = gageContextPoolNew(ctx, threadNum));
+    if (!E) airMopAdd(mop, pool, (airMopper)gageContextPoolNix,
+                      airMopAlways);
+    if (!E) E |= gageProbeList(pool, &nout, &failNum,
+                               AIR_CAST(const gagePerVolume *const *, &pvl),
+                               &what, 1, nrrdTypeDouble, npos,
+                               !worldSpace, clamp);
     if (E) {
-      airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+      airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
       fprintf(stderr, "%s: trouble:\n%s\n", me, err);
       airMopError(mop);
       return 1;
     }
-    dout = AIR_CAST(double *, nout->data);
-    ELL_3V_COPY(start, pos);
-    if (lineInfo[3]) {
-      double tmp;
-      /* stepping along vector */
-      ELL_3V_COPY(dir, 0 + lineInfo);
-      ELL_3V_SET(end, AIR_NAN, AIR_NAN, AIR_NAN);
-      ELL_3V_NORM(dir, dir, tmp);
-      if (!tmp) {
-        fprintf(stderr, "%s: requested vector stepping, but vlen = 0", me);
-        airMopError(mop);
-        return 1;
-      }
-      ELL_3V_SCALE(dir, lineInfo[3], dir);
-    } else {
-      /* stepping between points */
-      ELL_3V_SET(dir, AIR_NAN, AIR_NAN, AIR_NAN);
-      ELL_3V_COPY(end, 0 + lineInfo);
-    }
-    for (vidx=0; vidx<lineStepNum; vidx++) {
-      if (lineInfo[3]) {
-        ELL_3V_SCALE_ADD2(lpos, 1, start, vidx, dir);
-      } else {
-        ELL_3V_AFFINE(lpos, 0, vidx, lineStepNum-1, start, end);
-      }
-      if (gageProbeSpace(ctx, lpos[0], lpos[1], lpos[2],
-                         !worldSpace, AIR_FALSE)) {
-        fprintf(stderr, "%s: trouble:\n%s\n(%d)\n",
-                me, ctx->errStr, ctx->errNum);
-        airMopError(mop);
-        return 1;
-      }
-      for (ai=0; ai<ansLen; ai++) {
-        dout[ai + ansLen*vidx] = answer[ai];
-      }
+    if (failNum) {
+      fprintf(stderr, "%s: %s of %s probes failed\n", me,
+              airSprintSize_t(stmp[0], failNum),
+              airSprintSize_t(stmp[1], posNum));
+      airMopError(mop);
+      return 1;
     }
     if (nrrdSave(outS, nout, NULL)) {
       airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
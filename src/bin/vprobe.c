@@ -48,24 +48,25 @@ main(int argc, const char *argv[]) {
   NrrdKernelSpec *k00, *k11, *k22, *kSS, *kSSblur;
   int what, E=0, renorm, SSuniform, SSoptim, verbose, zeroZ,
     orientationFromSpacing, SSnormd;
-  unsigned int iBaseDim, oBaseDim, axi, numSS, ninSSIdx, seed;
-  const double *answer;
-  Nrrd *nin, *nout, **ninSS=NULL;
+  unsigned int iBaseDim, oBaseDim, axi, numSS, ninSSIdx, seed, threadNum,
+    posLen;
+  Nrrd *nin, *nout, **ninSS=NULL, *npos, *nrun;
   Nrrd *ngrad=NULL, *nbmat=NULL;
-  size_t ai, ansLen, idx, xi, yi, zi, six, siy, siz, sox, soy, soz;
+  size_t ansLen, idx, xi, yi, zi, six, siy, siz, sox, soy, soz, failNum,
+    runLen, posNum, runBytes;
   double bval=0, gmc, rangeSS[2], wrlSS, idxSS=AIR_NAN,
-    dsix, dsiy, dsiz, dsox, dsoy, dsoz;
+    dsix, dsiy, dsiz, dsox, dsoy, dsoz, *pos;
   gageContext *ctx;
+  gageContextPool *pool;
   gagePerVolume *pvl=NULL;
   double t0, t1, x, y, z, scale[3], rscl[3], min[3], maxOut[3], maxIn[3];
   airArray *mop;
   unsigned int hackZi, *skip, skipNum;
-  double (*ins)(void *v, size_t I, double d);
   gageStackBlurParm *sbp;
 
   char hackKeyStr[]="TEEM_VPROBE_HACK_ZI", *hackValStr;
   int otype, hackSet;
-  char stmp[4][AIR_STRLEN_SMALL];
+  char stmp[5][AIR_STRLEN_SMALL];
 
   me = argv[0];
   /* parse environment variables first, in case they break nrrdDefault*
@@ -169,6 +170,9 @@ main(int argc, const char *argv[]) {
   hestOptAdd(&hopt, "ofs", "ofs", airTypeInt, 0, 0, &orientationFromSpacing,
              NULL, "If only per-axis spacing is available, use that to "
              "contrive full orientation info");
+  hestOptAdd(&hopt, "nt", "# threads", airTypeUInt, 1, 1, &threadNum, "1",
+             "number of threads to probe with, and to compute "
+             "scale-space blurrings with");
   hestOptAdd(&hopt, "t", "type", airTypeEnum, 1, 1, &otype, "float",
              "type of output volume", NULL, nrrdType);
   hestOptAdd(&hopt, "o", "nout", airTypeString, 1, 1, &outS, "-",
@@ -229,6 +233,7 @@ main(int argc, const char *argv[]) {
         || gageStackBlurParmKernelSet(sbp, kSSblur)
         || gageStackBlurParmRenormalizeSet(sbp, AIR_TRUE)
         || gageStackBlurParmBoundarySet(sbp, nrrdBoundaryBleed, AIR_NAN)
+        || gageStackBlurParmThreadNumSet(sbp, threadNum)
         || gageStackBlurParmVerboseSet(sbp, verbose)) {
       airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
       fprintf(stderr, "%s: trouble with stack blur info:\n%s\n", me, err);
@@ -294,9 +299,9 @@ main(int argc, const char *argv[]) {
   }
 
   /***
-  **** Except for the gageProbe() call in the inner loop below,
-  **** and the gageContextNix() call at the very end, all the gage
-  **** calls which set up (and take down) the context and state are here.
+  **** Except for the gageProbeList() call below, and the
+  **** gageContextNix() call at the very end, all the gage calls
+  **** which set up (and take down) the context and state are here.
   ***/
   ctx = gageContextNew();
   airMopAdd(mop, ctx, AIR_CAST(airMopper, gageContextNix), airMopAlways);
@@ -328,13 +333,17 @@ main(int argc, const char *argv[]) {
   }
   if (!E) E |= gageQueryItemOn(ctx, pvl, what);
   if (!E) E |= gageUpdate(ctx);
+  /* the pool's contexts copy ctx, including this verbosity */
+  if (!E) gageParmSet(ctx, gageParmVerbose, verbose/10);
+  if (!E) E |= !(pool = gageContextPoolNew(ctx, threadNum));
   if (E) {
     airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
     fprintf(stderr, "%s: trouble:\n%s\n", me, err);
     airMopError(mop);
     return 1;
   }
-  answer = gageAnswerPointer(ctx, pvl, what);
+  airMopAdd(mop, pool, AIR_CAST(airMopper, gageContextPoolNix),
+            airMopAlways);
   /***
   **** end gage setup.
   ***/
@@ -424,9 +433,28 @@ main(int argc, const char *argv[]) {
     ELL_3V_SET(maxOut, dsox-1, dsoy-1, dsoz-1);
     ELL_3V_SET(maxIn, dsix-1, dsiy-1, dsiz-1);
   }
+  /* The positions are computed as they always have been, and then
+     probed by all the threads of the pool, one slice (or with more
+     verbosity, one scanline or one sample) at a time. */
+  posLen = numSS ? 4 : 3;
+  runLen = (verbose > 2
+            ? 1
+            : (2 == verbose ? sox : sox*soy));
+  npos = nrrdNew();
+  airMopAdd(mop, npos, AIR_CAST(airMopper, nrrdNuke), airMopAlways);
+  nrun = nrrdNew();
+  airMopAdd(mop, nrun, AIR_CAST(airMopper, nrrdNuke), airMopAlways);
+  if (nrrdMaybeAlloc_va(npos, nrrdTypeDouble, 2,
+                        AIR_CAST(size_t, posLen), runLen)) {
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating positions:\n%s\n", me, err);
+    airMopError(mop);
+    return 1;
+  }
+  pos = AIR_CAST(double *, npos->data);
+  runBytes = nrrdElementSize(nout)*ansLen*runLen;
+  posNum = 0;
   t0 = airTime();
-  ins = nrrdDInsert[nout->type];
-  gageParmSet(ctx, gageParmVerbose, verbose/10);
   for (zi=0; zi<soz; zi++) {
     if (verbose) {
       if (verbose > 1) {
@@ -462,27 +490,38 @@ main(int argc, const char *argv[]) {
           fflush(stderr);
         }
         x = AIR_AFFINE(min[0], xi, maxOut[0], min[0], maxIn[0]);
-        idx = xi + sox*(yi + soy*zi);
-        E = (numSS
-             ? gageStackProbe(ctx, x, y, z, idxSS)
-             : gageProbe(ctx, x, y, z));
-        if (E) {
-          fprintf(stderr,
-                  "%s: trouble at i=(%s,%s,%s) -> f=(%g,%g,%g):\n%s\n(%d)\n",
-                  me, airSprintSize_t(stmp[0], xi),
-                  airSprintSize_t(stmp[1], yi),
-                  airSprintSize_t(stmp[2], zi), x, y, z,
-                  ctx->errStr, ctx->errNum);
+        ELL_3V_SET(pos + posLen*posNum, x, y, z);
+        if (numSS) {
+          pos[3 + posLen*posNum] = idxSS;
+        }
+        if (runLen > ++posNum) {
+          continue;
+        }
+        /* the run of positions ending at this sample is complete */
+        posNum = 0;
+        idx = xi + sox*(yi + soy*zi) + 1 - runLen;
+        if (gageProbeList(pool, &nrun, &failNum,
+                          AIR_CAST(const gagePerVolume *const *, &pvl),
+                          &what, 1, otype, npos,
+                          AIR_TRUE /* indexSpace */, AIR_FALSE /* clamp */)) {
+          airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+          fprintf(stderr, "%s: trouble probing:\n%s\n", me, err);
           airMopError(mop);
           return 1;
         }
-        if (1 == ansLen) {
-          ins(nout->data, idx, *answer);
-        } else {
-          for (ai=0; ai<=ansLen-1; ai++) {
-            ins(nout->data, ai + ansLen*idx, answer[ai]);
-          }
+        if (failNum) {
+          fprintf(stderr, "%s: trouble at %s of the %s samples up to "
+                  "i=(%s,%s,%s) -> f=(%g,%g,%g)\n", me,
+                  airSprintSize_t(stmp[0], failNum),
+                  airSprintSize_t(stmp[1], runLen),
+                  airSprintSize_t(stmp[2], xi),
+                  airSprintSize_t(stmp[3], yi),
+                  airSprintSize_t(stmp[4], zi), x, y, z);
+          airMopError(mop);
+          return 1;
         }
+        memcpy(AIR_CAST(char *, nout->data) + idx*runBytes/runLen,
+               nrun->data, runBytes);
       }
     }
   }
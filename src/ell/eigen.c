@@ -561,71 +561,252 @@ ell_3m_svd_d(double uu[9], double sval[3], double vv[9],
 }
 
 /*
-** NOTE: profiling showed that about a quarter of the execution time of
-** ell_6ms_eigensolve_d() is spent here; so reconsider its need and
-** implementation . . . (fabs vs. AIR_ABS() made no difference)
+** sqrt(aa*aa + bb*bb) without overflow or underflow in the squaring
+*/
+static double
+_ell_6ms_hypot(double aa, double bb) {
+  double ret;
+
+  aa = AIR_ABS(aa);
+  bb = AIR_ABS(bb);
+  if (aa > bb) {
+    bb /= aa;
+    ret = aa*sqrt(1 + bb*bb);
+  } else if (bb) {
+    aa /= bb;
+    ret = bb*sqrt(1 + aa*aa);
+  } else {
+    ret = 0;
+  }
+  return ret;
+}
+
+/*
+** _ell_6ms_tridiag
+**
+** Householder reduction of the symmetric 6x6 matrix in vv[][] to
+** tridiagonal form, with the diagonal put in dd[] and the sub-diagonal in
+** ee[1] through ee[5] (ee[0] is zero).  If doVec, vv[][] is then set to
+** the orthogonal matrix effecting the reduction (so that the eigenvectors
+** of the tridiagonal matrix are rotated back to those of the original);
+** otherwise vv[][] is left as garbage.  Follows "tred2" from the EISPACK
+** (and later JAMA) eigensolvers.
 */
 static void
-_maxI_sum_find(unsigned int maxI[2], double *sumon, double *sumoff,
-               double mat[6][6]) {
-  double maxm, tmp;
-  unsigned int rrI, ccI;
+_ell_6ms_tridiag(double dd[6], double ee[6], double vv[6][6], int doVec) {
+  double scale, ff, gg, hh, hhh;
+  unsigned int ii, jj, kk;
 
-  /* we hope that all these loops are unrolled by the optimizer */
-  *sumon = *sumoff = 0.0;
-  for (rrI=0; rrI<6; rrI++) {
-    *sumon += AIR_ABS(mat[rrI][rrI]);
-  }
-  maxm = -1;
-  maxI[0] = maxI[1] = 0;
-  for (rrI=0; rrI<5; rrI++) {
-    for (ccI=rrI+1; ccI<6; ccI++) {
-      tmp = AIR_ABS(mat[rrI][ccI]);
-      *sumoff += tmp;
-      if (tmp > maxm) {
-        maxm = tmp;
-        maxI[0] = rrI;
-        maxI[1] = ccI;
+  for (jj=0; jj<6; jj++) {
+    dd[jj] = vv[5][jj];
+  }
+  for (ii=5; ii>0; ii--) {
+    scale = hh = 0.0;
+    for (kk=0; kk<ii; kk++) {
+      scale += AIR_ABS(dd[kk]);
+    }
+    if (!scale) {
+      ee[ii] = dd[ii-1];
+      for (jj=0; jj<ii; jj++) {
+        dd[jj] = vv[ii-1][jj];
+        vv[ii][jj] = 0.0;
+        vv[jj][ii] = 0.0;
+      }
+    } else {
+      /* generate Householder vector */
+      for (kk=0; kk<ii; kk++) {
+        dd[kk] /= scale;
+        hh += dd[kk]*dd[kk];
+      }
+      ff = dd[ii-1];
+      gg = sqrt(hh);
+      if (ff > 0) {
+        gg = -gg;
+      }
+      ee[ii] = scale*gg;
+      hh -= ff*gg;
+      dd[ii-1] = ff - gg;
+      for (jj=0; jj<ii; jj++) {
+        ee[jj] = 0.0;
+      }
+      /* apply similarity transformation to remaining columns */
+      for (jj=0; jj<ii; jj++) {
+        ff = dd[jj];
+        vv[jj][ii] = ff;
+        gg = ee[jj] + vv[jj][jj]*ff;
+        for (kk=jj+1; kk<ii; kk++) {
+          gg += vv[kk][jj]*dd[kk];
+          ee[kk] += vv[kk][jj]*ff;
+        }
+        ee[jj] = gg;
+      }
+      ff = 0.0;
+      for (jj=0; jj<ii; jj++) {
+        ee[jj] /= hh;
+        ff += ee[jj]*dd[jj];
+      }
+      hhh = ff/(hh + hh);
+      for (jj=0; jj<ii; jj++) {
+        ee[jj] -= hhh*dd[jj];
+      }
+      for (jj=0; jj<ii; jj++) {
+        ff = dd[jj];
+        gg = ee[jj];
+        for (kk=jj; kk<ii; kk++) {
+          vv[kk][jj] -= (ff*ee[kk] + gg*dd[kk]);
+        }
+        dd[jj] = vv[ii-1][jj];
+        vv[ii][jj] = 0.0;
       }
     }
+    dd[ii] = hh;
   }
-
-  /*
-  if (1) {
-    double nrm, trc;
-    nrm = trc = 0;
-    for (rrI=0; rrI<6; rrI++) {
-      trc += mat[rrI][rrI];
-      nrm += mat[rrI][rrI]*mat[rrI][rrI];
+  ee[0] = 0.0;
+  if (!doVec) {
+    /* the diagonal was left on the diagonal of vv[][] */
+    for (jj=0; jj<6; jj++) {
+      dd[jj] = vv[jj][jj];
     }
-    for (rrI=0; rrI<5; rrI++) {
-      for (ccI=rrI+1; ccI<6; ccI++) {
-        nrm += 2*mat[rrI][ccI]*mat[rrI][ccI];
+    return;
+  }
+  /* accumulate transformations */
+  for (ii=0; ii<5; ii++) {
+    vv[5][ii] = vv[ii][ii];
+    vv[ii][ii] = 1.0;
+    hh = dd[ii+1];
+    if (hh) {
+      for (kk=0; kk<=ii; kk++) {
+        dd[kk] = vv[kk][ii+1]/hh;
+      }
+      for (jj=0; jj<=ii; jj++) {
+        gg = 0.0;
+        for (kk=0; kk<=ii; kk++) {
+          gg += vv[kk][ii+1]*vv[kk][jj];
+        }
+        for (kk=0; kk<=ii; kk++) {
+          vv[kk][jj] -= gg*dd[kk];
+        }
       }
     }
-    fprintf(stderr, "---------------- invars = %g %g\n", trc, nrm);
+    for (kk=0; kk<=ii; kk++) {
+      vv[kk][ii+1] = 0.0;
+    }
   }
-  */
-
+  for (jj=0; jj<6; jj++) {
+    dd[jj] = vv[5][jj];
+    vv[5][jj] = 0.0;
+  }
+  vv[5][5] = 1.0;
   return;
 }
 
-static int
-_compar(const void *A_void, const void *B_void) {
-  const double *A, *B;
-  A = AIR_CAST(const double *, A_void);
-  B = AIR_CAST(const double *, B_void);
-  return (A[0] < B[0] ? 1 : (A[0] > B[0] ? -1 : 0));
+/*
+** the most QL iterations spent on any one eigenvalue; convergence is
+** normally in two or three
+*/
+#define _ELL_6MS_ITER_MAX 60
+
+/*
+** _ell_6ms_ql
+**
+** finds the eigensystem of the symmetric tridiagonal matrix with diagonal
+** dd[] and sub-diagonal ee[1] through ee[5], with the implicit QL method
+** ("tql2" in EISPACK and JAMA).  The eigenvalues replace dd[] (unsorted),
+** and if doVec, the columns of vv[][] (which should start as the output
+** of _ell_6ms_tridiag) are rotated into the corresponding eigenvectors.
+** A sub-diagonal element is considered zero when it is below eps times
+** the largest |diagonal| + |sub-diagonal| seen so far.
+*/
+static void
+_ell_6ms_ql(double dd[6], double ee[6], double vv[6][6], int doVec,
+            double eps) {
+  double ff, tst1, gg, pp, rr, hh, dl1, el1, cc, c2, c3, ss, s2;
+  unsigned int ll, mm, ii, kk, iter;
+
+  for (ii=1; ii<6; ii++) {
+    ee[ii-1] = ee[ii];
+  }
+  ee[5] = 0.0;
+  ff = tst1 = 0.0;
+  for (ll=0; ll<6; ll++) {
+    /* find small sub-diagonal element */
+    tst1 = AIR_MAX(tst1, AIR_ABS(dd[ll]) + AIR_ABS(ee[ll]));
+    for (mm=ll; mm<5; mm++) {
+      if (AIR_ABS(ee[mm]) <= eps*tst1) {
+        break;
+      }
+    }
+    /* if mm == ll, dd[ll] is already an eigenvalue; otherwise iterate */
+    if (mm > ll) {
+      iter = 0;
+      do {
+        /* compute implicit shift */
+        gg = dd[ll];
+        pp = (dd[ll+1] - gg)/(2.0*ee[ll]);
+        rr = _ell_6ms_hypot(pp, 1.0);
+        if (pp < 0) {
+          rr = -rr;
+        }
+        dd[ll] = ee[ll]/(pp + rr);
+        dd[ll+1] = ee[ll]*(pp + rr);
+        dl1 = dd[ll+1];
+        hh = gg - dd[ll];
+        for (ii=ll+2; ii<6; ii++) {
+          dd[ii] -= hh;
+        }
+        ff += hh;
+        /* implicit QL transformation */
+        pp = dd[mm];
+        cc = c2 = c3 = 1.0;
+        el1 = ee[ll+1];
+        ss = s2 = 0.0;
+        for (ii=mm; ii-- > ll; ) {
+          c3 = c2;
+          c2 = cc;
+          s2 = ss;
+          gg = cc*ee[ii];
+          hh = cc*pp;
+          rr = _ell_6ms_hypot(pp, ee[ii]);
+          ee[ii+1] = ss*rr;
+          ss = ee[ii]/rr;
+          cc = pp/rr;
+          pp = cc*dd[ii] - ss*gg;
+          dd[ii+1] = hh + ss*(cc*gg + ss*dd[ii]);
+          if (doVec) {
+            for (kk=0; kk<6; kk++) {
+              hh = vv[kk][ii+1];
+              vv[kk][ii+1] = ss*vv[kk][ii] + cc*hh;
+              vv[kk][ii] = cc*vv[kk][ii] - ss*hh;
+            }
+          }
+        }
+        pp = -ss*s2*c3*el1*ee[ll]/dl1;
+        ee[ll] = ss*pp;
+        dd[ll] = cc*pp;
+        iter++;
+        /* (comparison also false for nan, so that won't loop forever) */
+      } while (AIR_ABS(ee[ll]) > eps*tst1 && iter < _ELL_6MS_ITER_MAX);
+    }
+    dd[ll] += ff;
+    ee[ll] = 0.0;
+  }
+  return;
 }
 
 /*
 ******* ell_6ms_eigensolve_d
 **
-** uses Jacobi iterations to find eigensystem of 6x6 symmetric matrix,
-** given in sym[21], to within convergence threshold eps.  Puts
+** finds eigensystem of 6x6 symmetric matrix, given in sym[21], to within
+** convergence threshold eps (relative to the magnitude of the matrix;
+** values below DBL_EPSILON are treated as DBL_EPSILON).  Puts
 ** eigenvalues, in descending order, in eval[6], and corresponding
 ** eigenvectors in _evec+0, _evec+6, . . ., _evec+30.  NOTE: you can
-** pass a NULL _evec if eigenvectors aren't needed.
+** pass a NULL _evec if eigenvectors aren't needed, which saves time.
+**
+** This used to be done with Jacobi iterations (each zeroing the largest
+** off-diagonal element); now the matrix is reduced to tridiagonal form
+** with Householder reflections, and then diagonalized with implicit QL
+** iterations, which takes a fixed and much smaller amount of work.
 **
 ** does NOT use biff
 */
@@ -633,167 +814,493 @@ int
 ell_6ms_eigensolve_d(double eval[6], double _evec[36],
                      const double sym[21], const double eps) {
   /* char me[]="ell_6ms_eigensolve_d"; */
-  double mat[2][6][6], evec[2][6][6], sumon, sumoff, evtmp[12];
-  unsigned int cur, rrI, ccI, maxI[2], iter;
+  double mat[6][6], dd[6], ee[6], tmp;
+  unsigned int rrI, ccI, si, idx[6];
 
   if (!( eval && sym && eps >= 0 )) {
     return 1;
   }
-  /* copy symmetric matrix sym[] into upper tris of mat[0][][] & mat[1][][] */
-  mat[0][0][0] = sym[ 0];
-  mat[0][0][1] = sym[ 1];
-  mat[0][0][2] = sym[ 2];
-  mat[0][0][3] = sym[ 3];
-  mat[0][0][4] = sym[ 4];
-  mat[0][0][5] = sym[ 5];
-  mat[0][1][1] = sym[ 6];
-  mat[0][1][2] = sym[ 7];
-  mat[0][1][3] = sym[ 8];
-  mat[0][1][4] = sym[ 9];
-  mat[0][1][5] = sym[10];
-  mat[0][2][2] = sym[11];
-  mat[0][2][3] = sym[12];
-  mat[0][2][4] = sym[13];
-  mat[0][2][5] = sym[14];
-  mat[0][3][3] = sym[15];
-  mat[0][3][4] = sym[16];
-  mat[0][3][5] = sym[17];
-  mat[0][4][4] = sym[18];
-  mat[0][4][5] = sym[19];
-  mat[0][5][5] = sym[20];
-  if (_evec) {
-    /* initialize evec[0]; */
-    for (rrI=0; rrI<6; rrI++) {
-      for (ccI=0; ccI<6; ccI++) {
-        evec[0][ccI][rrI] = (rrI == ccI);
-      }
+  /* copy symmetric matrix sym[] into all of mat[][] */
+  si = 0;
+  for (rrI=0; rrI<6; rrI++) {
+    for (ccI=rrI; ccI<6; ccI++) {
+      mat[rrI][ccI] = mat[ccI][rrI] = sym[si++];
     }
   }
-  /*
-  fprintf(stderr, "!%s(INIT): m = [", me);
-  for (rrI=0; rrI<6; rrI++) {
-    for (ccI=0; ccI<6; ccI++) {
-      fprintf(stderr, "%f%s",
-              (rrI <= ccI ? mat[0][rrI][ccI] : mat[0][ccI][rrI]),
-              ccI<5 ? "," : (rrI<5 ? ";" : "]"));
+  _ell_6ms_tridiag(dd, ee, mat, !!_evec);
+  _ell_6ms_ql(dd, ee, mat, !!_evec, AIR_MAX(eps, DBL_EPSILON));
+
+  /* sort evals (by insertion, into idx[]) */
+  for (ccI=0; ccI<6; ccI++) {
+    tmp = dd[ccI];
+    for (rrI=ccI; rrI > 0 && dd[idx[rrI-1]] < tmp; rrI--) {
+      idx[rrI] = idx[rrI-1];
     }
-    fprintf(stderr, "\n");
+    idx[rrI] = ccI;
   }
-  */
-  maxI[0] = maxI[1] = UINT_MAX; /* quiet warnings about using maxI unset */
-  _maxI_sum_find(maxI, &sumon, &sumoff, mat[0]);
-  cur = 1;         /* fake out anticipating first line of loop */
-  iter = 0;
-  while (sumoff/sumon > eps) {
-    double th, tt, cc, ss;
-    unsigned int P, Q;
-    /*
-    fprintf(stderr, "!%s(%u): sumoff/sumon = %g/%g = %g > %g\n", me, iter,
-            sumoff, sumon, sumoff/sumon, eps);
-    */
-    cur = 1 - cur;
-
-    P = maxI[0];
-    Q = maxI[1];
-    th = (mat[cur][Q][Q] - mat[cur][P][P])/(2*mat[cur][P][Q]);
-    tt = (th > 0 ? +1 : -1)/(AIR_ABS(th) + sqrt(th*th + 1));
-    cc = 1/sqrt(tt*tt + 1);
-    ss = cc*tt;
-    /*
-    fprintf(stderr, "!%s(%u): maxI = (P,Q) = (%u,%u) --> ss=%f, cc=%f\n",
-            me, iter, P, Q, ss, cc);
-    fprintf(stderr, "     r = [");
-    for (rrI=0; rrI<6; rrI++) {
-      for (ccI=0; ccI<6; ccI++) {
-        fprintf(stderr, "%g%s",
-                (rrI == ccI
-                 ? (rrI == P || rrI == Q ? cc : 1.0)
-                 : (rrI == P && ccI == Q
-                    ? ss
-                    : (rrI == Q && ccI == P
-                       ? -ss
-                       : 0))),
-                ccI<5 ? "," : (rrI<5 ? ";" : "]"));
+
+  /* copy out solution */
+  for (ccI=0; ccI<6; ccI++) {
+    eval[ccI] = dd[idx[ccI]];
+    if (_evec) {
+      for (rrI=0; rrI<6; rrI++) {
+        _evec[rrI + 6*ccI] = mat[rrI][idx[ccI]];
       }
-      fprintf(stderr, "\n");
     }
-    */
-    /* initialize by copying whole matrix */
-    for (rrI=0; rrI<6; rrI++) {
-      for (ccI=rrI; ccI<6; ccI++) {
-        mat[1-cur][rrI][ccI] = mat[cur][rrI][ccI];
-      }
+  }
+
+  return 0;
+}
+
+/*
+** how many matrices a thread in ell_6ms_eigensolve_batch_d takes at once
+*/
+#define _ELL_6MS_CHUNK 256
+
+/*
+** _ell6msTask, _ell6msThreadArg: for ell_6ms_eigensolve_batch_d, with
+** chunks of matrices handed out to threads
+*/
+typedef struct {
+  double *eval, *evec;
+  const double *sym;
+  double eps;
+  size_t num,                  /* how many matrices */
+    workIdx;                   /* first matrix of next chunk to hand out */
+  airThreadMutex *workMutex;   /* NULL for a single thread */
+} _ell6msTask;
+
+typedef struct {
+  _ell6msTask *task;
+} _ell6msThreadArg;
+
+static void *
+_ell6msWorker(void *_arg) {
+  _ell6msThreadArg *arg;
+  _ell6msTask *task;
+  size_t ii, lo, hi;
+
+  arg = AIR_CAST(_ell6msThreadArg *, _arg);
+  task = arg->task;
+  for (;;) {
+    if (task->workMutex) {
+      airThreadMutexLock(task->workMutex);
+    }
+    lo = task->workIdx;
+    hi = AIR_MIN(lo + _ELL_6MS_CHUNK, task->num);
+    task->workIdx = hi;
+    if (task->workMutex) {
+      airThreadMutexUnlock(task->workMutex);
     }
-    /* perform Jacobi rotation */
-    for (rrI=0; rrI<P; rrI++) {
-      mat[1-cur][rrI][P] = cc*mat[cur][rrI][P] - ss*mat[cur][rrI][Q];
+    if (lo == hi) {
+      /* no more work */
+      break;
     }
-    for (ccI=P+1; ccI<6; ccI++) {
-      mat[1-cur][P][ccI] = cc*mat[cur][P][ccI] - ss*(Q <= ccI
-                                                     ? mat[cur][Q][ccI]
-                                                     : mat[cur][ccI][Q]);
+    for (ii=lo; ii<hi; ii++) {
+      ell_6ms_eigensolve_d(task->eval + 6*ii,
+                           task->evec ? task->evec + 36*ii : NULL,
+                           task->sym + 21*ii, task->eps);
+    }
+  }
+  return _arg;
+}
+
+/*
+******** ell_6ms_eigensolve_batch_d
+**
+** ell_6ms_eigensolve_d on each of num matrices, one after the other in
+** memory (as in a volume of 21-component values): matrix i is in
+** sym[21*i] through sym[21*i + 20], and its eigenvalues and (if evec is
+** non-NULL) eigenvectors go to eval + 6*i and evec + 36*i.  The matrices
+** are divided among threadNum threads; the results don't depend on
+** threadNum.
+**
+** This DOES use biff (for trouble with threads)
+*/
+int
+ell_6ms_eigensolve_batch_d(double *eval, double *evec, const double *sym,
+                           size_t num, double eps, unsigned int threadNum) {
+  static const char me[]="ell_6ms_eigensolve_batch_d";
+  _ell6msTask task;
+  _ell6msThreadArg *arg;
+  unsigned int ti;
+  airArray *mop;
+
+  if (!( eval && sym )) {
+    biffAddf(ELL, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (!( eps >= 0 && threadNum > 0 )) {
+    biffAddf(ELL, "%s: need eps >= 0 (not %g) and threadNum > 0 (not %u)",
+             me, eps, threadNum);
+    return 1;
+  }
+  task.eval = eval;
+  task.evec = evec;
+  task.sym = sym;
+  task.eps = eps;
+  task.num = num;
+  task.workIdx = 0;
+  /* no more threads than chunks */
+  threadNum = AIR_CAST(unsigned int,
+                       AIR_MIN(threadNum, (num + _ELL_6MS_CHUNK - 1)
+                               /_ELL_6MS_CHUNK));
+  threadNum = AIR_MAX(threadNum, 1);
+  mop = airMopNew();
+  arg = AIR_CALLOC(threadNum, _ell6msThreadArg);
+  airMopAdd(mop, arg, airFree, airMopAlways);
+  if (!arg) {
+    biffAddf(ELL, "%s: couldn't allocate per-thread info", me);
+    airMopError(mop); return 1;
+  }
+  if (1 < threadNum) {
+    if (!( task.workMutex = airThreadMutexNew() )) {
+      biffAddf(ELL, "%s: couldn't create work mutex", me);
+      airMopError(mop); return 1;
     }
-    for (rrI=0; rrI<Q; rrI++) {
-      mat[1-cur][rrI][Q] = ss*(rrI <= P
-                               ? mat[cur][rrI][P]
-                               : mat[cur][P][rrI]) + cc*mat[cur][rrI][Q];
+    airMopAdd(mop, task.workMutex, (airMopper)airThreadMutexNix,
+              airMopAlways);
+    if (!airThreadCapable) {
+      fprintf(stderr, "%s: WARNING: not multi-threaded; will do %u "
+              "\"threads\" serially !!!\n", me, threadNum);
     }
-    for (ccI=Q+1; ccI<6; ccI++) {
-      mat[1-cur][Q][ccI] = ss*mat[cur][P][ccI] + cc*mat[cur][Q][ccI];
+  } else {
+    task.workMutex = NULL;
+  }
+  for (ti=0; ti<threadNum; ti++) {
+    arg[ti].task = &task;
+  }
+  if (airThreadRun(_ell6msWorker, arg, sizeof(*arg), threadNum)) {
+    biffAddf(ELL, "%s: couldn't run %u threads", me, threadNum);
+    airMopError(mop); return 1;
+  }
+  airMopOkay(mop);
+  return 0;
+}
+
+/* ____________________________ 3ms batch ____________________________ */
+
+/*
+** how many matrices ell_3ms_eigensolve_batch_d and _f work on at once;
+** all the per-matrix intermediate results for this many matrices
+** should fit in L1 cache
+*/
+#define _ELL_3MS_BATCH 64
+
+/*
+** matrices whose (normalized) eigenvalues are closer together than this
+** are "near-degenerate": their eigenvectors can't be accurately found by
+** the cross products in _ell_3ms_evec_d, so _ell_3ms_jacobi_d is used
+*/
+#define _ELL_3MS_GAP 1e-3
+
+/*
+** _ell_3ms_jacobi_d
+**
+** Jacobi iterations on the symmetric 3x3 matrix given by the sym[0],
+** sym[stride], ..., sym[5*stride] (xx, xy, xz, yy, yz, zz), putting the
+** eigenvalues, in descending order, in eval[0], eval[stride],
+** eval[2*stride], and the eigenvectors (if evec is non-NULL) with the
+** same ordering as ell_3ms_eigensolve_batch_d.  This is slower than the
+** analytic solution, but it has no trouble with repeated eigenvalues.
+*/
+static void
+_ell_3ms_jacobi_d(double *eval, double *evec, const double *sym,
+                  size_t stride) {
+  double mm[3][3], vv[3][3], mean, nrm, off, th, tt, cc, ss, aP, aQ, tmp;
+  unsigned int sweep, PP, QQ, RR, idx[3];
+
+  mean = (sym[0*stride] + sym[3*stride] + sym[5*stride])/3;
+  mm[0][0] = sym[0*stride] - mean;
+  mm[0][1] = mm[1][0] = sym[1*stride];
+  mm[0][2] = mm[2][0] = sym[2*stride];
+  mm[1][1] = sym[3*stride] - mean;
+  mm[1][2] = mm[2][1] = sym[4*stride];
+  mm[2][2] = sym[5*stride] - mean;
+  ELL_3V_SET(vv[0], 1, 0, 0);
+  ELL_3V_SET(vv[1], 0, 1, 0);
+  ELL_3V_SET(vv[2], 0, 0, 1);
+  nrm = (mm[0][0]*mm[0][0] + mm[1][1]*mm[1][1] + mm[2][2]*mm[2][2]
+         + 2*(mm[0][1]*mm[0][1] + mm[0][2]*mm[0][2] + mm[1][2]*mm[1][2]));
+  /* convergence is quadratic; 20 sweeps is far more than enough */
+  for (sweep=0; sweep<20; sweep++) {
+    off = mm[0][1]*mm[0][1] + mm[0][2]*mm[0][2] + mm[1][2]*mm[1][2];
+    if (!( off > 1e-32*nrm )) {
+      break;
     }
-    /* set special entries */
-    mat[1-cur][P][P] = mat[cur][P][P] - tt*mat[cur][P][Q];
-    mat[1-cur][Q][Q] = mat[cur][Q][Q] + tt*mat[cur][P][Q];
-    mat[1-cur][P][Q] = 0.0;
-    if (_evec) {
-      /* NOTE: the eigenvectors use transpose of indexing of mat */
-      /* start by copying all */
-      for (rrI=0; rrI<6; rrI++) {
-        for (ccI=0; ccI<6; ccI++) {
-          evec[1-cur][ccI][rrI] = evec[cur][ccI][rrI];
+    for (PP=0; PP<2; PP++) {
+      for (QQ=PP+1; QQ<3; QQ++) {
+        if (!mm[PP][QQ]) {
+          continue;
+        }
+        th = (mm[QQ][QQ] - mm[PP][PP])/(2*mm[PP][QQ]);
+        tt = (th >= 0 ? +1 : -1)/(AIR_ABS(th) + sqrt(th*th + 1));
+        cc = 1/sqrt(tt*tt + 1);
+        ss = cc*tt;
+        /* mm = R^T mm R, and vv = vv R */
+        for (RR=0; RR<3; RR++) {
+          aP = mm[RR][PP];
+          aQ = mm[RR][QQ];
+          mm[RR][PP] = cc*aP - ss*aQ;
+          mm[RR][QQ] = ss*aP + cc*aQ;
+        }
+        for (RR=0; RR<3; RR++) {
+          aP = mm[PP][RR];
+          aQ = mm[QQ][RR];
+          mm[PP][RR] = cc*aP - ss*aQ;
+          mm[QQ][RR] = ss*aP + cc*aQ;
+        }
+        mm[PP][QQ] = mm[QQ][PP] = 0.0;
+        for (RR=0; RR<3; RR++) {
+          aP = vv[RR][PP];
+          aQ = vv[RR][QQ];
+          vv[RR][PP] = cc*aP - ss*aQ;
+          vv[RR][QQ] = ss*aP + cc*aQ;
         }
       }
-      for (rrI=0; rrI<6; rrI++) {
-        evec[1-cur][P][rrI] = cc*evec[cur][P][rrI] - ss*evec[cur][Q][rrI];
-        evec[1-cur][Q][rrI] = ss*evec[cur][P][rrI] + cc*evec[cur][Q][rrI];
+    }
+  }
+  /* sort into descending order */
+  ELL_3V_SET(idx, 0, 1, 2);
+  if (mm[idx[0]][idx[0]] < mm[idx[1]][idx[1]]) {
+    ELL_SWAP2(idx[0], idx[1], RR);
+  }
+  if (mm[idx[1]][idx[1]] < mm[idx[2]][idx[2]]) {
+    ELL_SWAP2(idx[1], idx[2], RR);
+  }
+  if (mm[idx[0]][idx[0]] < mm[idx[1]][idx[1]]) {
+    ELL_SWAP2(idx[0], idx[1], RR);
+  }
+  for (PP=0; PP<3; PP++) {
+    eval[PP*stride] = mm[idx[PP]][idx[PP]] + mean;
+  }
+  if (evec) {
+    double ev[9], xx[3];
+    for (PP=0; PP<3; PP++) {
+      for (RR=0; RR<3; RR++) {
+        ev[RR + 3*PP] = vv[RR][idx[PP]];
       }
     }
+    ELL_3V_CROSS(xx, ev+0, ev+3);
+    tmp = ELL_3V_DOT(xx, ev+6) < 0 ? -1 : 1;
+    for (PP=0; PP<9; PP++) {
+      evec[PP*stride] = (PP < 6 ? 1 : tmp)*ev[PP];
+    }
+  }
+  return;
+}
 
-    _maxI_sum_find(maxI, &sumon, &sumoff, mat[1-cur]);
+/*
+** _ell_3ms_evec_d
+**
+** for the (normalized, non-degenerate) symmetric matrix with entries a,
+** b, c, d, e, f (xx, xy, xz, yy, yz, zz), and one of its eigenvalues x,
+** finds the unit-length eigenvector as the longest of the cross products
+** of pairs of rows of M - x*I
+*/
+static void
+_ell_3ms_evec_d(double vv[3], double aa, double bb, double cc, double dd,
+                double ee, double ff, double xx) {
+  double r0[3], r1[3], r2[3], c0[3], c1[3], c2[3], n0, n1, n2, len;
 
-    /*
-    fprintf(stderr, "!%s(%u): m = [", me, iter);
-    for (rrI=0; rrI<6; rrI++) {
-      for (ccI=0; ccI<6; ccI++) {
-        fprintf(stderr, "%f%s",
-                (rrI <= ccI ? mat[1-cur][rrI][ccI] : mat[1-cur][ccI][rrI]),
-                ccI<5 ? "," : (rrI<5 ? ";" : "]"));
-      }
-      fprintf(stderr, "\n");
+  ELL_3V_SET(r0, aa - xx, bb, cc);
+  ELL_3V_SET(r1, bb, dd - xx, ee);
+  ELL_3V_SET(r2, cc, ee, ff - xx);
+  ELL_3V_CROSS(c0, r0, r1);
+  ELL_3V_CROSS(c1, r0, r2);
+  ELL_3V_CROSS(c2, r1, r2);
+  n0 = ELL_3V_DOT(c0, c0);
+  n1 = ELL_3V_DOT(c1, c1);
+  n2 = ELL_3V_DOT(c2, c2);
+  if (n0 >= n1 && n0 >= n2) {
+    len = 1/sqrt(n0);
+    ELL_3V_SCALE(vv, len, c0);
+  } else if (n1 >= n2) {
+    len = 1/sqrt(n1);
+    ELL_3V_SCALE(vv, len, c1);
+  } else {
+    len = 1/sqrt(n2);
+    ELL_3V_SCALE(vv, len, c2);
+  }
+  return;
+}
+
+/*
+** _ell_3ms_batch_d
+**
+** does the work of ell_3ms_eigensolve_batch_d for num <= _ELL_3MS_BATCH
+** matrices, with component stride "stride".  The loops over the matrices
+** are free of data-dependent control flow (so they can be vectorized),
+** except for the last, over the near-degenerate matrices.
+*/
+static void
+_ell_3ms_batch_d(double *eval, double *evec, const double *sym,
+                 size_t stride, unsigned int num) {
+  double root[2][_ELL_3MS_BATCH];
+  unsigned char degen[_ELL_3MS_BATCH];
+  unsigned int ii;
+
+  for (ii=0; ii<num; ii++) {
+    double aa, bb, cc, dd, ee, ff, mean, pp, ip, det, rr, phi,
+      x0, x1, x2, gg, gd, gap;
+    aa = sym[0*stride + ii];
+    bb = sym[1*stride + ii];
+    cc = sym[2*stride + ii];
+    dd = sym[3*stride + ii];
+    ee = sym[4*stride + ii];
+    ff = sym[5*stride + ii];
+    /* normalize deviatoric part to have eigenvalues in [-2,2], the roots
+       of x^3 - 3x - det = 0, found with the trigonometric solution */
+    mean = (aa + dd + ff)/3;
+    aa -= mean;
+    dd -= mean;
+    ff -= mean;
+    pp = sqrt((aa*aa + dd*dd + ff*ff + 2*(bb*bb + cc*cc + ee*ee))/6);
+    ip = pp ? 1/pp : 0;
+    aa *= ip; bb *= ip; cc *= ip; dd *= ip; ee *= ip; ff *= ip;
+    det = aa*(dd*ff - ee*ee) - bb*(bb*ff - ee*cc) + cc*(bb*ee - dd*cc);
+    rr = AIR_CLAMP(-1, det/2, 1);
+    phi = acos(rr)/3;
+    x0 = 2*cos(phi);
+    /* = 2*cos(phi + 2*AIR_PI/3), without a second cos() */
+    x2 = -x0/2 - sqrt(AIR_MAX(0, 3 - 0.75*x0*x0));
+    /* one Newton step on the two outer roots repairs the precision lost
+       by acos() near rr = +/-1 (when the derivative isn't ~0) */
+    gg = x0*(x0*x0 - 3) - det;
+    gd = 3*(x0*x0 - 1);
+    x0 -= gd > 0.1 ? gg/gd : 0;
+    gg = x2*(x2*x2 - 3) - det;
+    gd = 3*(x2*x2 - 1);
+    x2 -= gd > 0.1 ? gg/gd : 0;
+    x1 = -x0 - x2;
+    gap = AIR_MIN(x0 - x1, x1 - x2);
+    degen[ii] = !pp || !(gap > _ELL_3MS_GAP);
+    root[0][ii] = x0;
+    root[1][ii] = x2;
+    eval[0*stride + ii] = mean + pp*x0;
+    eval[1*stride + ii] = mean + pp*x1;
+    eval[2*stride + ii] = mean + pp*x2;
+  }
+  if (evec) {
+    for (ii=0; ii<num; ii++) {
+      double aa, bb, cc, dd, ee, ff, mean, pp, ip, v0[3], v1[3], v2[3], dot;
+      aa = sym[0*stride + ii];
+      bb = sym[1*stride + ii];
+      cc = sym[2*stride + ii];
+      dd = sym[3*stride + ii];
+      ee = sym[4*stride + ii];
+      ff = sym[5*stride + ii];
+      mean = (aa + dd + ff)/3;
+      aa -= mean;
+      dd -= mean;
+      ff -= mean;
+      pp = sqrt((aa*aa + dd*dd + ff*ff + 2*(bb*bb + cc*cc + ee*ee))/6);
+      ip = pp ? 1/pp : 0;
+      aa *= ip; bb *= ip; cc *= ip; dd *= ip; ee *= ip; ff *= ip;
+      _ell_3ms_evec_d(v0, aa, bb, cc, dd, ee, ff, root[0][ii]);
+      _ell_3ms_evec_d(v2, aa, bb, cc, dd, ee, ff, root[1][ii]);
+      /* make v2 exactly orthogonal to v0, and v1 completes a
+         right-handed basis */
+      dot = ELL_3V_DOT(v0, v2);
+      ELL_3V_SCALE_INCR(v2, -dot, v0);
+      ip = 1/ELL_3V_LEN(v2);
+      ELL_3V_SCALE(v2, ip, v2);
+      ELL_3V_CROSS(v1, v2, v0);
+      evec[0*stride + ii] = v0[0];
+      evec[1*stride + ii] = v0[1];
+      evec[2*stride + ii] = v0[2];
+      evec[3*stride + ii] = v1[0];
+      evec[4*stride + ii] = v1[1];
+      evec[5*stride + ii] = v1[2];
+      evec[6*stride + ii] = v2[0];
+      evec[7*stride + ii] = v2[1];
+      evec[8*stride + ii] = v2[2];
+    }
+  }
+  for (ii=0; ii<num; ii++) {
+    if (degen[ii]) {
+      _ell_3ms_jacobi_d(eval + ii, evec ? evec + ii : NULL, sym + ii, stride);
     }
-    */
-    iter++;
   }
-  /* 1-cur is index of final solution */
+  return;
+}
 
-  /* sort evals */
-  for (ccI=0; ccI<6; ccI++) {
-    evtmp[0 + 2*ccI] = mat[1-cur][ccI][ccI];
-    evtmp[1 + 2*ccI] = ccI;
+/*
+******** ell_3ms_eigensolve_batch_d
+**
+** finds the eigensystems of num symmetric 3x3 matrices, given in
+** "structure of arrays" layout: sym[c*num + i] is component c (in the
+** order xx, xy, xz, yy, yz, zz) of matrix i.  Puts eigenvalues, in
+** descending order, in eval[e*num + i] for e = 0, 1, 2, and if evec is
+** non-NULL, component c of the corresponding eigenvector in
+** evec[(3*e + c)*num + i].  The eigenvectors form a right-handed
+** orthonormal basis.
+**
+** The analytic (trigonometric) solution of the characteristic cubic,
+** polished with a Newton step, is used for the eigenvalues, and cross
+** products for the eigenvectors; matrices with near-repeated eigenvalues
+** are instead solved with Jacobi iterations.  Unlike
+** ell_3m_eigensolve_d, there are no per-matrix decisions about root
+** multiplicity, and the matrices are processed in batches that can be
+** vectorized by the compiler.
+**
+** returns non-zero only if given NULL pointers.  This does NOT use biff
+*/
+int
+ell_3ms_eigensolve_batch_d(double *eval, double *evec,
+                           const double *sym, size_t num) {
+  size_t base;
+
+  if (!( eval && sym )) {
+    return 1;
+  }
+  for (base=0; base<num; base += _ELL_3MS_BATCH) {
+    _ell_3ms_batch_d(eval + base, evec ? evec + base : NULL, sym + base,
+                     num, AIR_CAST(unsigned int,
+                                   AIR_MIN(_ELL_3MS_BATCH, num - base)));
   }
-  qsort(evtmp, 6, 2*sizeof(double), _compar);
+  return 0;
+}
 
-  /* copy out solution */
-  for (ccI=0; ccI<6; ccI++) {
-    eval[ccI] = evtmp[0 + 2*ccI];
-    if (_evec) {
-      unsigned eeI;
-      for (rrI=0; rrI<6; rrI++) {
-        eeI = AIR_CAST(unsigned int, evtmp[1 + 2*ccI]);
-        _evec[rrI + 6*ccI] = evec[1-cur][eeI][rrI];
+/*
+******** ell_3ms_eigensolve_batch_f
+**
+** same as ell_3ms_eigensolve_batch_d, but for float arrays; the
+** computation is done in double (as with tenEigensolve_f)
+*/
+int
+ell_3ms_eigensolve_batch_f(float *eval, float *evec,
+                           const float *sym, size_t num) {
+  double dsym[6*_ELL_3MS_BATCH], deval[3*_ELL_3MS_BATCH],
+    devec[9*_ELL_3MS_BATCH];
+  size_t base;
+  unsigned int ii, cc, bnum;
+
+  if (!( eval && sym )) {
+    return 1;
+  }
+  for (base=0; base<num; base += _ELL_3MS_BATCH) {
+    bnum = AIR_CAST(unsigned int, AIR_MIN(_ELL_3MS_BATCH, num - base));
+    for (cc=0; cc<6; cc++) {
+      for (ii=0; ii<bnum; ii++) {
+        dsym[ii + _ELL_3MS_BATCH*cc] = sym[base + ii + num*cc];
+      }
+    }
+    _ell_3ms_batch_d(deval, evec ? devec : NULL, dsym, _ELL_3MS_BATCH, bnum);
+    for (cc=0; cc<3; cc++) {
+      for (ii=0; ii<bnum; ii++) {
+        eval[base + ii + num*cc] = AIR_CAST(float,
+                                            deval[ii + _ELL_3MS_BATCH*cc]);
+      }
+    }
+    if (evec) {
+      for (cc=0; cc<9; cc++) {
+        for (ii=0; ii<bnum; ii++) {
+          evec[base + ii + num*cc] = AIR_CAST(float,
+                                              devec[ii + _ELL_3MS_BATCH*cc]);
+        }
       }
     }
   }
-
   return 0;
 }
@@ -265,6 +265,14 @@ ELL_EXPORT int ell_3m_svd_d(double uu[9], double sval[3], double vv[9],
                             const double mat[9], const int newton);
 ELL_EXPORT int ell_6ms_eigensolve_d(double eval[6], double evec[36],
                                     const double mat[21], const double eps);
+ELL_EXPORT int ell_6ms_eigensolve_batch_d(double *eval, double *evec,
+                                          const double *sym, size_t num,
+                                          double eps,
+                                          unsigned int threadNum);
+ELL_EXPORT int ell_3ms_eigensolve_batch_d(double *eval, double *evec,
+                                          const double *sym, size_t num);
+ELL_EXPORT int ell_3ms_eigensolve_batch_f(float *eval, float *evec,
+                                          const float *sym, size_t num);
 
 #ifdef __cplusplus
 }
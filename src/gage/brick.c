@@ -0,0 +1,279 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "gage.h"
+#include "privateGage.h"
+
+/*
+** Bricked volumes: a copy of a volume in which the samples are
+** re-ordered so that each (2^brickShift)^3 cube of samples ("brick") is
+** contiguous in memory.  Probing at a random location then touches one
+** or a few bricks, rather than 2*fr^2 different scanlines (each on a
+** different cache line, and for big volumes, often a different page).
+** The per-sample tuple (for non-scalar kinds) is still fastest.  The
+** bricked nrrd has axes: (baseDim tuple axes), brick X, Y, Z, and then
+** the bricks themselves, in x-fastest order.  Bricks are zero-padded
+** where the volume size isn't a multiple of the brick size.
+**
+** The bricked nrrd is made by gageBrickMake(), and then attached to a
+** pervolume with gagePerVolumeBrickSet(), after which gageIv3Fill()
+** gathers from it instead of pvl->nin.  Like pvl->nin, the bricked nrrd
+** is owned by the caller, and is shared by pervolumes copied with
+** gageContextCopy().
+*/
+
+/* the brick shift is the log2 of the brick edge length */
+#define _GAGE_BRICK_SHIFT_MAX 8
+
+static int
+_gageBrickSizes(unsigned int size[3], unsigned int bnum[3],
+                const Nrrd *nin, unsigned int baseDim,
+                unsigned int brickShift) {
+  static const char me[]="_gageBrickSizes";
+  unsigned int ai, bmask;
+
+  if (!( 1 <= brickShift && brickShift <= _GAGE_BRICK_SHIFT_MAX )) {
+    biffAddf(GAGE, "%s: brickShift %u not in range [1,%u]", me,
+             brickShift, _GAGE_BRICK_SHIFT_MAX);
+    return 1;
+  }
+  bmask = (1u << brickShift) - 1;
+  for (ai=0; ai<3; ai++) {
+    size[ai] = AIR_CAST(unsigned int, nin->axis[baseDim + ai].size);
+    bnum[ai] = (size[ai] + bmask) >> brickShift;
+  }
+  return 0;
+}
+
+/*
+******** gageBrickMake
+**
+** makes a bricked copy nout of volume nin (of the given kind), with
+** bricks that are 2^brickShift samples on edge
+*/
+int
+gageBrickMake(Nrrd *nout, const Nrrd *nin, const gageKind *kind,
+              unsigned int brickShift) {
+  static const char me[]="gageBrickMake";
+  size_t size[NRRD_DIM_MAX], valSize, brickSize, dataIdx, outIdx;
+  unsigned int ai, vsize[3], bnum[3], bedge, bmask, xi, yi, zi, xlen;
+  const char *in;
+  char *out;
+
+  if (!( nout && nin && kind )) {
+    biffAddf(GAGE, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (nout == nin) {
+    biffAddf(GAGE, "%s: can't operate in-place", me);
+    return 1;
+  }
+  if (gageKindVolumeCheck(kind, nin)) {
+    biffAddf(GAGE, "%s: problem with volume as %s kind", me, kind->name);
+    return 1;
+  }
+  if (_gageBrickSizes(vsize, bnum, nin, kind->baseDim, brickShift)) {
+    biffAddf(GAGE, "%s: problem with brick sizes", me);
+    return 1;
+  }
+  bedge = 1u << brickShift;
+  bmask = bedge - 1;
+  for (ai=0; ai<kind->baseDim; ai++) {
+    size[ai] = nin->axis[ai].size;
+  }
+  size[kind->baseDim + 0] = bedge;
+  size[kind->baseDim + 1] = bedge;
+  size[kind->baseDim + 2] = bedge;
+  size[kind->baseDim + 3] = (AIR_CAST(size_t, bnum[0])*bnum[1])*bnum[2];
+  if (nrrdMaybeAlloc_nva(nout, nin->type, kind->baseDim + 4, size)) {
+    biffMovef(GAGE, NRRD, "%s: couldn't allocate output", me);
+    return 1;
+  }
+  /* padding is all zeros */
+  memset(nout->data, 0, nrrdElementNumber(nout)*nrrdElementSize(nout));
+
+  valSize = kind->valLen*nrrdElementSize(nin);
+  brickSize = AIR_CAST(size_t, bedge)*bedge*bedge;
+  in = AIR_CAST(const char *, nin->data);
+  out = AIR_CAST(char *, nout->data);
+  dataIdx = 0;
+  for (zi=0; zi<vsize[2]; zi++) {
+    for (yi=0; yi<vsize[1]; yi++) {
+      /* copy one scanline, as runs that are contiguous within bricks */
+      for (xi=0; xi<vsize[0]; xi+=bedge) {
+        xlen = AIR_MIN(bedge, vsize[0] - xi);
+        outIdx = (((xi >> brickShift)
+                   + bnum[0]*((yi >> brickShift)
+                            + AIR_CAST(size_t, bnum[1])*(zi >> brickShift)))
+                  *brickSize
+                  + ((yi & bmask) << brickShift)
+                  + (AIR_CAST(size_t, zi & bmask) << (2*brickShift)));
+        memcpy(out + outIdx*valSize, in + dataIdx*valSize, xlen*valSize);
+        dataIdx += xlen;
+      }
+    }
+  }
+  if (nrrdContentSet_va(nout, "gageBrick", nin, "%u", bedge)) {
+    biffMovef(GAGE, NRRD, "%s: couldn't set content", me);
+    return 1;
+  }
+  return 0;
+}
+
+/*
+******** gagePerVolumeBrickSet
+**
+** tells the pervolume to get its values from the given bricked copy
+** (from gageBrickMake()) of pvl->nin, or, if nbrick is NULL, to go back
+** to using pvl->nin.  Answers from probing are not changed by this.
+*/
+int
+gagePerVolumeBrickSet(gagePerVolume *pvl, const Nrrd *nbrick) {
+  static const char me[]="gagePerVolumeBrickSet";
+  unsigned int ai, baseDim, bedge, brickShift, vsize[3], bnum[3];
+
+  if (!pvl) {
+    biffAddf(GAGE, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (!nbrick) {
+    pvl->nbrick = NULL;
+    pvl->brickShift = 0;
+    return 0;
+  }
+  if (pvl->lazy) {
+    biffAddf(GAGE, "%s: lazily computed blurring is already bricked", me);
+    return 1;
+  }
+  baseDim = pvl->kind->baseDim;
+  if (!( nbrick->type == pvl->nin->type
+         && nbrick->dim == baseDim + 4 )) {
+    biffAddf(GAGE, "%s: bricked volume (%s, dim %u) doesn't match "
+             "%s volume (%s, dim %u)", me,
+             airEnumStr(nrrdType, nbrick->type), nbrick->dim,
+             pvl->kind->name, airEnumStr(nrrdType, pvl->nin->type),
+             baseDim + 4);
+    return 1;
+  }
+  for (ai=0; ai<baseDim; ai++) {
+    if (nbrick->axis[ai].size != pvl->nin->axis[ai].size) {
+      biffAddf(GAGE, "%s: bricked axis %u size doesn't match volume", me, ai);
+      return 1;
+    }
+  }
+  bedge = AIR_CAST(unsigned int, nbrick->axis[baseDim].size);
+  brickShift = 0;
+  while (brickShift < _GAGE_BRICK_SHIFT_MAX && (1u << brickShift) < bedge) {
+    brickShift++;
+  }
+  if (!( (1u << brickShift) == bedge
+         && nbrick->axis[baseDim+1].size == bedge
+         && nbrick->axis[baseDim+2].size == bedge )) {
+    biffAddf(GAGE, "%s: brick edges (%u,%u,%u) not equal powers of 2", me,
+             bedge, AIR_CAST(unsigned int, nbrick->axis[baseDim+1].size),
+             AIR_CAST(unsigned int, nbrick->axis[baseDim+2].size));
+    return 1;
+  }
+  if (_gageBrickSizes(vsize, bnum, pvl->nin, baseDim, brickShift)) {
+    biffAddf(GAGE, "%s: problem with brick sizes", me);
+    return 1;
+  }
+  if (nbrick->axis[baseDim+3].size
+      != (AIR_CAST(size_t, bnum[0])*bnum[1])*bnum[2]) {
+    biffAddf(GAGE, "%s: number of bricks %u != %u*%u*%u needed for volume",
+             me, AIR_CAST(unsigned int, nbrick->axis[baseDim+3].size),
+             bnum[0], bnum[1], bnum[2]);
+    return 1;
+  }
+  pvl->nbrick = nbrick;
+  pvl->brickShift = brickShift;
+  return 0;
+}
+
+/*
+** _gageBrickGather
+**
+** fills the part of pvl->iv3 (or of pvl->iv3f, for a pervolume filtered
+** in float) at cache coordinates in [cmin,cmax] along each axis, for the neighborhood starting at sample lo[], from the
+** bricked volume, with clamping at the volume boundary.  The brick
+** address of a sample is the sum of separate contributions from x, y, z,
+** which are computed in the loops over those axes. Returns the number of
+** (filled) neighborhood samples that needed clamping.
+*/
+unsigned int
+_gageBrickGather(gageContext *ctx, gagePerVolume *pvl, const int lo[3],
+                 const unsigned int cmin[3], const unsigned int cmax[3]) {
+  unsigned int ai, size[3], bnum[3], sh, bmask, fd, fddd, valLen, tup,
+    cx, cy, cz, xx, yy, zz, cacheIdx, edgeNum;
+  int pp, yout, zout;
+  size_t xpart, ypart, zpart, sampIdx;
+  const void *data;
+  double *iv3;
+  float *iv3f;
+
+  sh = pvl->brickShift;
+  bmask = (1u << sh) - 1;
+  for (ai=0; ai<3; ai++) {
+    size[ai] = ctx->shape->size[ai];
+    bnum[ai] = (size[ai] + bmask) >> sh;
+  }
+  fd = 2*ctx->radius;
+  fddd = fd*fd*fd;
+  valLen = pvl->kind->valLen;
+  data = pvl->nbrick->data;
+  iv3 = pvl->iv3;
+  iv3f = pvl->iv3f;
+  edgeNum = 0;
+  for (cz=cmin[2]; cz<=cmax[2]; cz++) {
+    pp = lo[2] + AIR_CAST(int, cz);
+    zz = AIR_CAST(unsigned int, AIR_CLAMP(0, pp, AIR_CAST(int, size[2]-1)));
+    zout = (AIR_CAST(int, zz) != pp);
+    zpart = (((zz >> sh)*AIR_CAST(size_t, bnum[0])*bnum[1]) << (3*sh))
+      + (AIR_CAST(size_t, zz & bmask) << (2*sh));
+    for (cy=cmin[1]; cy<=cmax[1]; cy++) {
+      pp = lo[1] + AIR_CAST(int, cy);
+      yy = AIR_CAST(unsigned int, AIR_CLAMP(0, pp, AIR_CAST(int, size[1]-1)));
+      yout = (AIR_CAST(int, yy) != pp);
+      ypart = (((yy >> sh)*AIR_CAST(size_t, bnum[0])) << (3*sh))
+        + (AIR_CAST(size_t, yy & bmask) << sh);
+      for (cx=cmin[0]; cx<=cmax[0]; cx++) {
+        pp = lo[0] + AIR_CAST(int, cx);
+        xx = AIR_CAST(unsigned int,
+                      AIR_CLAMP(0, pp, AIR_CAST(int, size[0]-1)));
+        edgeNum += (zout || yout || AIR_CAST(int, xx) != pp);
+        xpart = (AIR_CAST(size_t, xx >> sh) << (3*sh)) + (xx & bmask);
+        sampIdx = xpart + ypart + zpart;
+        cacheIdx = cx + fd*(cy + fd*cz);
+        for (tup=0; tup<valLen; tup++) {
+          if (iv3f) {
+            iv3f[cacheIdx + fddd*tup] =
+              AIR_CAST(float, pvl->lup(data, tup + valLen*sampIdx));
+          } else {
+            iv3[cacheIdx + fddd*tup] = pvl->lup(data, tup + valLen*sampIdx);
+          }
+        }
+      }
+    }
+  }
+  return edgeNum;
+}
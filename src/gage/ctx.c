@@ -70,6 +70,7 @@ gageContextNew() {
     }
     ctx->radius = 0;
     ctx->fsl = ctx->fw = NULL;
+    ctx->fwf = NULL;
     ctx->off = NULL;
     gagePointReset(&ctx->point);
     strcpy(ctx->errStr, "");
@@ -148,15 +149,18 @@ gageContextCopy(gageContext *ctx) {
   fd = 2*ntx->radius;
   ntx->fsl = AIR_CALLOC(fd*3, double);
   ntx->fw = AIR_CALLOC(fd*3*(GAGE_KERNEL_MAX+1), double);
-  ntx->off = AIR_CALLOC(fd*fd*fd, unsigned int);
-  if (!( ntx->fsl && ntx->fw && ntx->off )) {
+  ntx->off = AIR_CALLOC(fd*fd*fd, size_t);
+  ntx->fwf = (ctx->fwf
+              ? AIR_CALLOC(fd*3*(GAGE_KERNEL_MAX+1), float)
+              : NULL);
+  if (!( ntx->fsl && ntx->fw && ntx->off && (!ctx->fwf || ntx->fwf) )) {
     biffAddf(GAGE, "%s: couldn't allocate new filter caches for fd=%d",
              me, fd);
     return NULL;
   }
   /* the content of the offset array needs to be copied because
      it won't be refilled simply by calls to gageProbe() */
-  memcpy(ntx->off, ctx->off, fd*fd*fd*sizeof(unsigned int));
+  memcpy(ntx->off, ctx->off, fd*fd*fd*sizeof(size_t));
 
   /* make sure gageProbe() has to refill caches */
   gagePointReset(&ntx->point);
@@ -190,8 +194,9 @@ gageContextNix(gageContext *ctx) {
     ctx->stackFsl = AIR_CAST(double *, airFree(ctx->stackFsl));
     ctx->stackFw = AIR_CAST(double *, airFree(ctx->stackFw));
     ctx->fw = AIR_CAST(double *, airFree(ctx->fw));
+    ctx->fwf = AIR_CAST(float *, airFree(ctx->fwf));
     ctx->fsl = AIR_CAST(double *, airFree(ctx->fsl));
-    ctx->off = AIR_CAST(unsigned int *, airFree(ctx->off));
+    ctx->off = AIR_CAST(size_t *, airFree(ctx->off));
   }
   airFree(ctx);
   return NULL;
@@ -353,6 +358,9 @@ gageParmSet(gageContext *ctx, int which, double val) {
     break;
   case gageParmStackUse:
     ctx->parm.stackUse = AIR_CAST(int, val);
+    /* with singlePrecision, this decides between float and double value
+       caches, which gageUpdate() re-allocates along with a radius change */
+    ctx->flag[gageCtxFlagRadius] = AIR_TRUE;
     /* no flag to set, right? simply affects future calls to gageProbe()? */
     /* HEY: no? because if you're turning on the stack behavior, you now
        should be doing the error checking to make sure that all the pvls
@@ -378,6 +386,12 @@ gageParmSet(gageContext *ctx, int which, double val) {
   case gageParmTwoDimZeroZ:
     ctx->parm.twoDimZeroZ = AIR_CAST(int, val);
     break;
+  case gageParmSinglePrecision:
+    ctx->parm.singlePrecision = val ? AIR_TRUE : AIR_FALSE;
+    /* the caches have to be re-allocated (with or without their float
+       versions), which gageUpdate() does along with a radius change */
+    ctx->flag[gageCtxFlagRadius] = AIR_TRUE;
+    break;
   default:
     fprintf(stderr, "\n%s: sorry, which = %d not valid\n\n", me, which);
     break;
@@ -498,6 +512,101 @@ gagePerVolumeDetach(gageContext *ctx, gagePerVolume *pvl) {
   return 0;
 }
 
+/*
+** _gageIv3FillTyped()
+**
+** for the common case of the neighborhood being entirely inside the
+** volume, fills iv3 by directly converting the values from the known
+** type of the volume, instead of calling pvl->lup() (a function pointer)
+** for every value.  The values are the same as from pvl->lup(), since
+** that does the same conversion to double.  With non-NULL iv3f, it is
+** filled instead (with the values from pvl->lup() converted to float).
+** Returns non-zero, doing nothing, for types not handled here, for which
+** the caller has to use pvl->lup().
+*/
+#define _GAGE_IV3_FILL_INTO(IV, IT, TT)                                 \
+  if (1 == valLen) {                                                    \
+    for (ci=0; ci<fddd; ci++) {                                         \
+      IV[ci] = AIR_CAST(IT, AIR_CAST(double, vv[off[ci]]));             \
+    }                                                                   \
+  } else {                                                              \
+    for (ci=0; ci<fddd; ci++) {                                         \
+      for (tup=0; tup<valLen; tup++) {                                  \
+        IV[ci + fddd*tup] = AIR_CAST(IT, AIR_CAST(double,               \
+                                                  vv[tup + valLen*off[ci]])); \
+      }                                                                 \
+    }                                                                   \
+  }
+#define _GAGE_IV3_FILL(TT)                                              \
+  {                                                                     \
+    const TT *vv;                                                       \
+    vv = AIR_CAST(const TT *, here);                                    \
+    if (iv3f) {                                                         \
+      _GAGE_IV3_FILL_INTO(iv3f, float, TT);                             \
+    } else {                                                            \
+      _GAGE_IV3_FILL_INTO(iv3, double, TT);                             \
+    }                                                                   \
+  }
+
+static int
+_gageIv3FillTyped(double *iv3, float *iv3f, const void *here, int type,
+                  const size_t *off, unsigned int fddd, unsigned int valLen) {
+  unsigned int ci, tup;
+
+  switch (type) {
+  case nrrdTypeChar:   _GAGE_IV3_FILL(signed char);    break;
+  case nrrdTypeUChar:  _GAGE_IV3_FILL(unsigned char);  break;
+  case nrrdTypeShort:  _GAGE_IV3_FILL(signed short);   break;
+  case nrrdTypeUShort: _GAGE_IV3_FILL(unsigned short); break;
+  case nrrdTypeInt:    _GAGE_IV3_FILL(signed int);     break;
+  case nrrdTypeUInt:   _GAGE_IV3_FILL(unsigned int);   break;
+  case nrrdTypeLLong:  _GAGE_IV3_FILL(airLLong);       break;
+  case nrrdTypeFloat:  _GAGE_IV3_FILL(float);          break;
+  case nrrdTypeDouble: _GAGE_IV3_FILL(double);         break;
+  default:
+    /* nrrdTypeULLong: conversion to double not available on all
+       platforms, so leave that to pvl->lup() */
+    return 1;
+  }
+  return 0;
+}
+#undef _GAGE_IV3_FILL
+#undef _GAGE_IV3_FILL_INTO
+
+/*
+** _gageIv3Decode()
+**
+** with a quantized store (see gagePerVolumeStoreSet()), converts the
+** first fddd stored values of each tuple component in pvl->iv3 (or
+** pvl->iv3f) to the values they represent.  The stored values are small
+** integers, exact in float, so decoding in double and then rounding to
+** float gives the same as the double path rounded to float.
+*/
+static void
+_gageIv3Decode(gagePerVolume *pvl, unsigned int fddd) {
+  unsigned int ci, num;
+  double *iv3, min, step;
+  float *iv3f;
+
+  if (_GAGE_STORE_QUANT(pvl->store)) {
+    iv3 = pvl->iv3;
+    iv3f = pvl->iv3f;
+    min = pvl->storeMin;
+    step = pvl->storeStep;
+    num = fddd*pvl->kind->valLen;
+    if (iv3f) {
+      for (ci=0; ci<num; ci++) {
+        iv3f[ci] = AIR_CAST(float, min + step*iv3f[ci]);
+      }
+    } else {
+      for (ci=0; ci<num; ci++) {
+        iv3[ci] = min + step*iv3[ci];
+      }
+    }
+  }
+  return;
+}
+
 /*
 ** gageIv3Fill()
 **
@@ -508,7 +617,9 @@ gagePerVolumeDetach(gageContext *ctx, gagePerVolume *pvl) {
 ** the verbose comments seems like one way of trying to speed it up.
 ** However, temporarily if-def'ing out unused branches of the
 ** "switch(pvl->kind->valLen)", and #define'ing fddd to 64 (for 4x4x4
-** neighborhoods) did not noticeably speed anything up.
+** neighborhoods) did not noticeably speed anything up.  What did help
+** was avoiding the per-value pvl->lup() call, which is what
+** _gageIv3FillTyped() is for.
 **
 */
 void
@@ -516,11 +627,18 @@ gageIv3Fill(gageContext *ctx, gagePerVolume *pvl) {
   static const char me[]="gageIv3Fill";
   int lx, ly, lz, hx, hy, hz, _xx, _yy, _zz;
   unsigned int xx, yy, zz,
-    fr, cacheIdx, dataIdx, fddd;
+    fr, cacheIdx, fddd;
   unsigned int sx, sy, sz;
+  /* all index arithmetic into the volume data is done with size_t,
+     since the number of samples (or values) can exceed 2^32 */
+  size_t dataIdx, valSize;
   char *data, *here;
   unsigned int tup;
+  int ivf;
+  char stmp[AIR_STRLEN_SMALL];
 
+  /* whether iv3f (and not iv3) is the cache to fill */
+  ivf = _GAGE_PVL_FLOAT(ctx, pvl);
   sx = ctx->shape->size[0];
   sy = ctx->shape->size[1];
   sz = ctx->shape->size[2];
@@ -541,79 +659,81 @@ gageIv3Fill(gageContext *ctx, gagePerVolume *pvl) {
     fprintf(stderr, "%s:     l %d %d %d; h %d %d %d; fddd %u\n", me,
             lx, ly, lz, hx, hy, hz, fddd);
   }
+  if (pvl->nbrick || pvl->lazy) {
+    /* gathering from bricked copy of volume also handles clamping */
+    int lo[3];
+    unsigned int cmin[3], cmax[3];
+    ELL_3V_SET(lo, lx, ly, lz);
+    ELL_3V_SET(cmin, 0, 0, 0);
+    ELL_3V_SET(cmax, 2*fr-1, 2*fr-1, 2*fr-1);
+    ctx->edgeFrac = AIR_CAST(double,
+                             (pvl->lazy
+                              ? _gageStackLazyGather(ctx, pvl, lo, cmin, cmax)
+                              : _gageBrickGather(ctx, pvl, lo,
+                                                 cmin, cmax)))/fddd;
+    _gageIv3Decode(pvl, fddd);
+    if (ctx->verbose > 1) {
+      fprintf(stderr, "%s: ^^^ bye (from bricks)\n", me);
+    }
+    return;
+  }
   data = (char*)pvl->nin->data;
+  valSize = pvl->kind->valLen*nrrdTypeSize[pvl->nin->type];
   if (lx >= 0 && ly >= 0 && lz >= 0
       && hx < AIR_CAST(int, sx)
       && hy < AIR_CAST(int, sy)
       && hz < AIR_CAST(int, sz)) {
     /* all the samples we need are inside the existing volume */
-    dataIdx = lx + sx*(ly + sy*(lz));
+    dataIdx = AIR_CAST(size_t, lx)
+      + AIR_CAST(size_t, sx)*(AIR_CAST(size_t, ly)
+                              + AIR_CAST(size_t, sy)*AIR_CAST(size_t, lz));
     if (ctx->verbose > 1) {
       fprintf(stderr, "%s:     hello, valLen = %d, pvl->nin = %p, data = %p\n",
               me, pvl->kind->valLen,
               AIR_CVOIDP(pvl->nin), pvl->nin->data);
     }
-    here = data + dataIdx*pvl->kind->valLen*nrrdTypeSize[pvl->nin->type];
+    here = data + dataIdx*valSize;
     if (ctx->verbose > 1) {
       fprintf(stderr, "%s:     size = (%u,%u,%u);\n"
-              "%s:     fd = %d; coord = (%u,%u,%u) --> dataIdx = %d\n",
+              "%s:     fd = %d; coord = (%u,%u,%u) --> dataIdx = %s\n",
               me, sx, sy, sz, me, 2*fr,
               ctx->point.idx[0], ctx->point.idx[1], ctx->point.idx[2],
-              dataIdx);
-      fprintf(stderr, "%s:     here = %p; iv3 = %p; off[0,1,2,3,4,5,6,7] = "
-              "%d,%d,%d,%d,%d,%d,%d,%d\n",
-              me, here, AIR_CAST(void*, pvl->iv3),
-              ctx->off[0], ctx->off[1], ctx->off[2], ctx->off[3],
-              ctx->off[4], ctx->off[5], ctx->off[6], ctx->off[7]);
-    }
-    switch(pvl->kind->valLen) {
-    case 1:
-      for (cacheIdx=0; cacheIdx<fddd; cacheIdx++) {
-        pvl->iv3[cacheIdx] = pvl->lup(here, ctx->off[cacheIdx]);
-      }
-      break;
-      /* NOTE: the tuple axis is being shifted from the fastest to
-         the slowest axis, to anticipate component-wise filtering
-         operations */
-    case 3:
-      for (cacheIdx=0; cacheIdx<fddd; cacheIdx++) {
-        pvl->iv3[cacheIdx + fddd*0] = pvl->lup(here, 0 + 3*ctx->off[cacheIdx]);
-        pvl->iv3[cacheIdx + fddd*1] = pvl->lup(here, 1 + 3*ctx->off[cacheIdx]);
-        pvl->iv3[cacheIdx + fddd*2] = pvl->lup(here, 2 + 3*ctx->off[cacheIdx]);
-      }
-      break;
-    case 7:
-      /* this might come in handy for tenGage . . . */
-      for (cacheIdx=0; cacheIdx<fddd; cacheIdx++) {
-        pvl->iv3[cacheIdx + fddd*0] = pvl->lup(here, 0 + 7*ctx->off[cacheIdx]);
-        pvl->iv3[cacheIdx + fddd*1] = pvl->lup(here, 1 + 7*ctx->off[cacheIdx]);
-        pvl->iv3[cacheIdx + fddd*2] = pvl->lup(here, 2 + 7*ctx->off[cacheIdx]);
-        pvl->iv3[cacheIdx + fddd*3] = pvl->lup(here, 3 + 7*ctx->off[cacheIdx]);
-        pvl->iv3[cacheIdx + fddd*4] = pvl->lup(here, 4 + 7*ctx->off[cacheIdx]);
-        pvl->iv3[cacheIdx + fddd*5] = pvl->lup(here, 5 + 7*ctx->off[cacheIdx]);
-        pvl->iv3[cacheIdx + fddd*6] = pvl->lup(here, 6 + 7*ctx->off[cacheIdx]);
-      }
-      break;
-    default:
+              airSprintSize_t(stmp, dataIdx));
+      fprintf(stderr, "%s:     here = %p; iv3 = %p\n",
+              me, AIR_VOIDP(here), AIR_CAST(void*, pvl->iv3));
+      _gagePrint_off(stderr, ctx);
+    }
+    if (gageStoreHalf == pvl->store
+        || _gageIv3FillTyped(ivf ? NULL : pvl->iv3, ivf ? pvl->iv3f : NULL,
+                             here, pvl->nin->type,
+                             ctx->off, fddd, pvl->kind->valLen)) {
+      /* type (or store) not handled by _gageIv3FillTyped(); NOTE: the
+         tuple axis is being shifted from the fastest to the slowest axis,
+         to anticipate component-wise filtering operations */
       for (cacheIdx=0; cacheIdx<fddd; cacheIdx++) {
         for (tup=0; tup<pvl->kind->valLen; tup++) {
-          pvl->iv3[cacheIdx + fddd*tup] =
-            pvl->lup(here, tup + pvl->kind->valLen*ctx->off[cacheIdx]);
+          double val;
+          val = pvl->lup(here, tup + pvl->kind->valLen*ctx->off[cacheIdx]);
+          if (ivf) {
+            pvl->iv3f[cacheIdx + fddd*tup] = AIR_CAST(float, val);
+          } else {
+            pvl->iv3[cacheIdx + fddd*tup] = val;
+          }
         }
       }
-      break;
     }
     ctx->edgeFrac = 0;
   } else {
-    unsigned int edgeNum, dataStride, valLen;
+    unsigned int edgeNum, valLen;
     /* the query requires samples which don't actually lie
        within the volume- more care has to be taken */
-    double *iv3;
+    double *iv3, val;
+    float *iv3f;
     cacheIdx = 0;
     edgeNum = 0;
     valLen = pvl->kind->valLen;
-    dataStride = AIR_UINT(valLen*nrrdTypeSize[pvl->nin->type]);
     iv3 = pvl->iv3;
+    iv3f = ivf ? pvl->iv3f : NULL;
     if (1 == sz) {
       /* working with 2D images is now common enough that we try to make
          simplifications for that (HEY copy and paste). We first do the
@@ -624,10 +744,15 @@ gageIv3Fill(gageContext *ctx, gagePerVolume *pvl) {
           xx = AIR_CLAMP(0, _xx, AIR_CAST(int, sx-1));
           edgeNum += ((AIR_CAST(int, yy) != _yy)
                       || (AIR_CAST(int, xx) != _xx));
-          dataIdx = xx + sx*yy;
-          here = data+dataIdx*dataStride;
+          dataIdx = xx + AIR_CAST(size_t, sx)*yy;
+          here = data + dataIdx*valSize;
           for (tup=0; tup<valLen; tup++) {
-            iv3[cacheIdx + fddd*tup] = pvl->lup(here, tup);
+            val = pvl->lup(here, tup);
+            if (iv3f) {
+              iv3f[cacheIdx + fddd*tup] = AIR_CAST(float, val);
+            } else {
+              iv3[cacheIdx + fddd*tup] = val;
+            }
           }
           cacheIdx++;
         }
@@ -639,7 +764,11 @@ gageIv3Fill(gageContext *ctx, gagePerVolume *pvl) {
         for (_yy=ly; _yy<=hy; _yy++) {
           for (_xx=lx; _xx<=hx; _xx++) {
             for (tup=0; tup<valLen; tup++) {
-              iv3[cacheIdx + fddd*tup] = iv3[z0ci + fddd*tup];
+              if (iv3f) {
+                iv3f[cacheIdx + fddd*tup] = iv3f[z0ci + fddd*tup];
+              } else {
+                iv3[cacheIdx + fddd*tup] = iv3[z0ci + fddd*tup];
+              }
             }
             cacheIdx++;
             z0ci++;
@@ -660,20 +789,25 @@ gageIv3Fill(gageContext *ctx, gagePerVolume *pvl) {
             edgeNum += ((AIR_CAST(int, zz) != _zz)
                         || (AIR_CAST(int, yy) != _yy)
                         || (AIR_CAST(int, xx) != _xx));
-            dataIdx = xx + sx*(yy + sy*zz);
-            here = data+dataIdx*pvl->kind->valLen*nrrdTypeSize[pvl->nin->type];
+            dataIdx = xx + AIR_CAST(size_t, sx)*(yy + AIR_CAST(size_t, sy)*zz);
+            here = data + dataIdx*valSize;
             if (ctx->verbose > 2) {
               fprintf(stderr, "%s:    (%d,%d,%d) --clamp--> (%u,%u,%u)\n", me,
                       _xx, _yy, _zz, xx, yy, zz);
-              fprintf(stderr, "    --> dataIdx = %d; data = %p -> here = %p\n",
-                      dataIdx, data, here);
+              fprintf(stderr, "    --> dataIdx = %s; data = %p -> here = %p\n",
+                      airSprintSize_t(stmp, dataIdx),
+                      AIR_VOIDP(data), AIR_VOIDP(here));
             }
             for (tup=0; tup<pvl->kind->valLen; tup++) {
-              iv3[cacheIdx + fddd*tup] = pvl->lup(here, tup);
+              val = pvl->lup(here, tup);
+              if (iv3f) {
+                iv3f[cacheIdx + fddd*tup] = AIR_CAST(float, val);
+              } else {
+                iv3[cacheIdx + fddd*tup] = val;
+              }
               if (ctx->verbose > 3) {
                 fprintf(stderr, "%s:    iv3[%u + %u*%u=%u] = %g\n", me,
-                        cacheIdx, fddd, tup, cacheIdx + fddd*tup,
-                        iv3[cacheIdx + fddd*tup]);
+                        cacheIdx, fddd, tup, cacheIdx + fddd*tup, val);
               }
             }
             cacheIdx++;
@@ -683,12 +817,122 @@ gageIv3Fill(gageContext *ctx, gagePerVolume *pvl) {
     }
     ctx->edgeFrac = AIR_CAST(double, edgeNum)/fddd;
   }
+  _gageIv3Decode(pvl, fddd);
   if (ctx->verbose > 1) {
     fprintf(stderr, "%s: ^^^ bye\n", me);
   }
   return;
 }
 
+/*
+** _gageIv3Slide()
+**
+** when the probe location has moved by exactly one sample along one
+** axis, most of the (2*fr)^3 values in pvl->iv3 are still valid, just
+** shifted by one along that axis.  This does that shift (for every
+** tuple component), and reads from the volume only the (2*fr)^2 face of
+** new values.  This is only correct when the new neighborhood is entirely
+** inside the volume (values in the neighborhood from the last probe
+** may have come from clamping, but not the ones that are kept), so this
+** returns non-zero without doing anything otherwise, in which case
+** gageIv3Fill() has to be called instead.  The result is identical to
+** what gageIv3Fill() would have produced.  For pervolumes filtered in
+** float, this shifts iv3f instead.
+*/
+static int
+_gageIv3Slide(gageContext *ctx, gagePerVolume *pvl,
+              unsigned int axis, int up) {
+  int lo[3], fd, ivf;
+  unsigned int ai, fddd, inner, outer, oi, ii, face, tup, valLen,
+    cacheIdx, size[3];
+  size_t dataIdx, valSize, vsz;
+  double *iv3;
+  char *here, *blk;
+
+  ivf = _GAGE_PVL_FLOAT(ctx, pvl);
+  fd = 2*AIR_CAST(int, ctx->radius);
+  for (ai=0; ai<3; ai++) {
+    size[ai] = ctx->shape->size[ai];
+    /* idx[0]-1: see Thu Jan 14 comment in filter.c */
+    lo[ai] = AIR_CAST(int, ctx->point.idx[ai]) - 1 - (fd/2 - 1);
+    if (!( lo[ai] >= 0 && lo[ai] + fd - 1 < AIR_CAST(int, size[ai]) )) {
+      return 1;
+    }
+  }
+  fddd = fd*fd*fd;
+  valLen = pvl->kind->valLen;
+  iv3 = pvl->iv3;
+  vsz = ivf ? sizeof(float) : sizeof(double);
+  /* as seen along the given axis, the iv3 (including its tuple axis)
+     is (outer) blocks of fd slices, each slice being (inner) long */
+  inner = (0 == axis ? 1 : (1 == axis ? fd : fd*fd));
+  outer = fddd*valLen/(fd*inner);
+  for (oi=0; oi<outer; oi++) {
+    blk = (AIR_CAST(char *, ivf ? AIR_VOIDP(pvl->iv3f) : AIR_VOIDP(iv3))
+           + oi*fd*inner*vsz);
+    if (up) {
+      memmove(blk, blk + inner*vsz, (fd-1)*inner*vsz);
+    } else {
+      memmove(blk + inner*vsz, blk, (fd-1)*inner*vsz);
+    }
+  }
+  /* read in the new face */
+  face = up ? fd-1 : 0;
+  if (pvl->nbrick || pvl->lazy) {
+    unsigned int cmin[3], cmax[3];
+    ELL_3V_SET(cmin, 0, 0, 0);
+    ELL_3V_SET(cmax, fd-1, fd-1, fd-1);
+    cmin[axis] = cmax[axis] = face;
+    if (pvl->lazy) {
+      _gageStackLazyGather(ctx, pvl, lo, cmin, cmax);
+    } else {
+      _gageBrickGather(ctx, pvl, lo, cmin, cmax);
+    }
+  } else {
+    valSize = valLen*nrrdTypeSize[pvl->nin->type];
+    dataIdx = AIR_CAST(size_t, lo[0])
+      + AIR_CAST(size_t, size[0])*(AIR_CAST(size_t, lo[1])
+                                   + AIR_CAST(size_t, size[1])
+                                   *AIR_CAST(size_t, lo[2]));
+    here = AIR_CAST(char *, pvl->nin->data) + dataIdx*valSize;
+    for (oi=0; oi<fddd/(fd*inner); oi++) {
+      for (ii=0; ii<inner; ii++) {
+        cacheIdx = ii + inner*(face + fd*oi);
+        for (tup=0; tup<valLen; tup++) {
+          if (ivf) {
+            pvl->iv3f[cacheIdx + fddd*tup] =
+              AIR_CAST(float, pvl->lup(here,
+                                       tup + valLen*ctx->off[cacheIdx]));
+          } else {
+            iv3[cacheIdx + fddd*tup] =
+              pvl->lup(here, tup + valLen*ctx->off[cacheIdx]);
+          }
+        }
+      }
+    }
+  }
+  if (_GAGE_STORE_QUANT(pvl->store)) {
+    /* as in _gageIv3Decode(), but only for the new face */
+    for (oi=0; oi<fddd/(fd*inner); oi++) {
+      for (ii=0; ii<inner; ii++) {
+        cacheIdx = ii + inner*(face + fd*oi);
+        for (tup=0; tup<valLen; tup++) {
+          if (ivf) {
+            pvl->iv3f[cacheIdx + fddd*tup] =
+              AIR_CAST(float, (pvl->storeMin + pvl->storeStep
+                               *pvl->iv3f[cacheIdx + fddd*tup]));
+          } else {
+            iv3[cacheIdx + fddd*tup] = (pvl->storeMin + pvl->storeStep
+                                        *iv3[cacheIdx + fddd*tup]);
+          }
+        }
+      }
+    }
+  }
+  ctx->edgeFrac = 0;
+  return 0;
+}
+
 /*
 ** _gageProbe
 **
@@ -751,7 +995,32 @@ _gageProbe(gageContext *ctx, double _xi, double _yi, double _zi, double _si) {
   }
   if (idxChanged) {
     if (!ctx->parm.stackUse) {
+      /* see if we moved by one sample along exactly one axis, in which
+         case the iv3s can (maybe) be shifted instead of re-filled */
+      unsigned int axi, slideAxis=0, slideNum=0;
+      int slideUp=AIR_FALSE;
+      for (axi=0; axi<3; axi++) {
+        if (oldIdx[axi] != ctx->point.idx[axi]) {
+          slideNum += (oldIdx[axi] + 1 == ctx->point.idx[axi]
+                       || oldIdx[axi] == ctx->point.idx[axi] + 1) ? 1 : 3;
+          slideAxis = axi;
+          slideUp = oldIdx[axi] < ctx->point.idx[axi];
+        }
+      }
       for (pvlIdx=0; pvlIdx<ctx->pvlNum; pvlIdx++) {
+        if (ctx->pvl[pvlIdx]->nderiv) {
+          /* value cache not used; see _gageDerivProbe() */
+          continue;
+        }
+        if (1 == slideNum
+            && !_gageIv3Slide(ctx, ctx->pvl[pvlIdx], slideAxis, slideUp)) {
+          if (ctx->verbose > 3) {
+            fprintf(stderr, "%s: _gageIv3Slide(pvl[%u/%u] %s, %u, %s)\n", me,
+                    pvlIdx, ctx->pvlNum, ctx->pvl[pvlIdx]->kind->name,
+                    slideAxis, slideUp ? "up" : "down");
+          }
+          continue;
+        }
         if (ctx->verbose > 3) {
           fprintf(stderr, "%s: gageIv3Fill(pvl[%u/%u] %s): .......\n", me,
                   pvlIdx, ctx->pvlNum, ctx->pvl[pvlIdx]->kind->name);
@@ -809,7 +1078,11 @@ _gageProbe(gageContext *ctx, double _xi, double _yi, double _zi, double _si) {
                 ctx->point.idx[0], ctx->point.idx[1], ctx->point.idx[2]);
         ctx->pvl[pvlIdx]->kind->iv3Print(stderr, ctx, ctx->pvl[pvlIdx]);
       }
-      ctx->pvl[pvlIdx]->kind->filter(ctx, ctx->pvl[pvlIdx]);
+      if (ctx->pvl[pvlIdx]->nderiv) {
+        _gageDerivProbe(ctx, ctx->pvl[pvlIdx]);
+      } else {
+        ctx->pvl[pvlIdx]->kind->filter(ctx, ctx->pvl[pvlIdx]);
+      }
       ctx->pvl[pvlIdx]->kind->answer(ctx, ctx->pvl[pvlIdx]);
     }
   }
@@ -940,3 +1213,245 @@ gageProbeSpace(gageContext *ctx, double xx, double yy, double zz,
 
   return _gageProbeSpace(ctx, xx, yy, zz, AIR_NAN, indexSpace, clamp);
 }
+
+/*
+** _gageBatchAnswerSetup
+**
+** for gageProbeBatch and gageProbeScanline: checks the requested answers,
+** and learns (once per batch) where to copy them from and how long they are
+*/
+static int
+_gageBatchAnswerSetup(const double **ansSrc, unsigned int *ansLen,
+                      const gageContext *ctx, double *const *ans,
+                      const gagePerVolume *const *pvl, const int *item,
+                      unsigned int ansNum) {
+  static const char me[]="_gageBatchAnswerSetup";
+  unsigned int ai;
+
+  for (ai=0; ai<ansNum; ai++) {
+    if (!( pvl[ai] && ans[ai] )) {
+      biffAddf(GAGE, "%s: got NULL pvl or ans for answer %u", me, ai);
+      return 1;
+    }
+    if (!gagePerVolumeIsAttached(ctx, pvl[ai])) {
+      biffAddf(GAGE, "%s: pvl for answer %u not attached to context",
+               me, ai);
+      return 1;
+    }
+    ansSrc[ai] = gageAnswerPointer(ctx, pvl[ai], item[ai]);
+    ansLen[ai] = gageAnswerLength(ctx, pvl[ai], item[ai]);
+    if (!ansSrc[ai]) {
+      biffAddf(GAGE, "%s: item %d not valid for %s kind (answer %u)", me,
+               item[ai], pvl[ai]->kind->name, ai);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/*
+** _gageBatchAnswerSave
+**
+** saves the answers from the last probe (or, if it failed, AIR_NAN)
+** at position pi of posNum
+*/
+static void
+_gageBatchAnswerSave(double *const *ans, int *errNum,
+                     const double *const *ansSrc, const unsigned int *ansLen,
+                     unsigned int ansNum, size_t pi, size_t posNum,
+                     const gageContext *ctx, int failed) {
+  unsigned int ai, cc;
+
+  if (errNum) {
+    errNum[pi] = failed ? ctx->errNum : gageErrNone;
+  }
+  if (failed) {
+    for (ai=0; ai<ansNum; ai++) {
+      for (cc=0; cc<ansLen[ai]; cc++) {
+        ans[ai][pi + posNum*cc] = AIR_NAN;
+      }
+    }
+    return;
+  }
+  for (ai=0; ai<ansNum; ai++) {
+    switch (ansLen[ai]) {
+    case 1:
+      ans[ai][pi] = ansSrc[ai][0];
+      break;
+    case 3:
+      ans[ai][pi + posNum*0] = ansSrc[ai][0];
+      ans[ai][pi + posNum*1] = ansSrc[ai][1];
+      ans[ai][pi + posNum*2] = ansSrc[ai][2];
+      break;
+    default:
+      for (cc=0; cc<ansLen[ai]; cc++) {
+        ans[ai][pi + posNum*cc] = ansSrc[ai][cc];
+      }
+      break;
+    }
+  }
+  return;
+}
+
+/*
+******** gageProbeBatch()
+**
+** probes at posNum locations, given as separate (structure-of-arrays)
+** coordinate arrays xx, yy, zz (and ss, the scale-space positions, which
+** are only used with parm.stackUse, and otherwise may be NULL), and
+** copies answers into caller-allocated (also structure-of-arrays) output
+** arrays: ans[ai] has to be allocated for gageAnswerLength(pvl[ai],
+** item[ai])*posNum doubles, and component cc of the answer at the pi-th
+** position is saved to ans[ai][pi + posNum*cc].  indexSpace and clamp
+** are as with gageProbeSpace().
+**
+** Probing failures (such as being outside the volume) don't stop the
+** batch; the answers at that position are set to AIR_NAN, and the
+** gageErr value for each position is saved to errNum[pi] if errNum is
+** non-NULL (gageErrNone for success).  The number of failures is saved
+** to *failNum if failNum is non-NULL.  Biff error is only for problems
+** with the arguments themselves.
+**
+** The answer pointers and lengths are looked up once for the whole
+** batch, and when successive positions are coherent (such as along a
+** scanline) the filter weights are re-computed only along the axes for
+** which fractional position has changed, and the value caches are
+** re-filled only when the integral position has changed.  So sorting
+** the positions along the fastest axis of the volume will help.
+*/
+int
+gageProbeBatch(gageContext *ctx, double *const *ans, int *errNum,
+               size_t *failNum,
+               const gagePerVolume *const *pvl, const int *item,
+               unsigned int ansNum,
+               const double *xx, const double *yy, const double *zz,
+               const double *ss, size_t posNum,
+               int indexSpace, int clamp) {
+  static const char me[]="gageProbeBatch";
+  const double **ansSrc;
+  unsigned int *ansLen;
+  size_t pi, fnum;
+  int failed;
+  airArray *mop;
+
+  if (!(ctx && ans && pvl && item && xx && yy && zz)) {
+    biffAddf(GAGE, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (!ansNum) {
+    biffAddf(GAGE, "%s: need at least one answer to save", me);
+    return 1;
+  }
+  if (ctx->parm.stackUse && !ss) {
+    biffAddf(GAGE, "%s: need scale positions when parm.stackUse", me);
+    return 1;
+  }
+  mop = airMopNew();
+  ansSrc = AIR_CALLOC(ansNum, const double *);
+  airMopAdd(mop, AIR_CAST(void *, ansSrc), airFree, airMopAlways);
+  ansLen = AIR_CALLOC(ansNum, unsigned int);
+  airMopAdd(mop, ansLen, airFree, airMopAlways);
+  if (!(ansSrc && ansLen)) {
+    biffAddf(GAGE, "%s: couldn't allocate answer info", me);
+    airMopError(mop); return 1;
+  }
+  if (_gageBatchAnswerSetup(ansSrc, ansLen, ctx, ans, pvl, item, ansNum)) {
+    biffAddf(GAGE, "%s: problem with answers", me);
+    airMopError(mop); return 1;
+  }
+
+  fnum = 0;
+  for (pi=0; pi<posNum; pi++) {
+    failed = _gageProbeSpace(ctx, xx[pi], yy[pi], zz[pi],
+                             ctx->parm.stackUse ? ss[pi] : AIR_NAN,
+                             indexSpace, clamp);
+    fnum += !!failed;
+    _gageBatchAnswerSave(ans, errNum, ansSrc, ansLen, ansNum,
+                         pi, posNum, ctx, failed);
+  }
+  if (failNum) {
+    *failNum = fnum;
+  }
+  airMopOkay(mop);
+  return 0;
+}
+
+/*
+******** gageProbeScanline()
+**
+** like gageProbeBatch(), but for posNum index-space positions along a
+** line parallel to index-space axis "axis": position pi is (xi,yi,zi)
+** plus pi*step along that axis.  With an integral step of +1 or -1, the
+** filter weights are computed once for the whole scanline, and instead
+** of re-filling the value caches at every position, they are shifted by
+** one sample, with only the new (2*radius)^2 face read from the volume.
+** Not for use with parm.stackUse (use gageProbeBatch() instead).
+*/
+int
+gageProbeScanline(gageContext *ctx, double *const *ans, int *errNum,
+                  size_t *failNum,
+                  const gagePerVolume *const *pvl, const int *item,
+                  unsigned int ansNum,
+                  double xi, double yi, double zi,
+                  unsigned int axis, double step, size_t posNum,
+                  int clamp) {
+  static const char me[]="gageProbeScanline";
+  const double **ansSrc;
+  unsigned int *ansLen;
+  size_t pi, fnum;
+  double pos[3];
+  int failed;
+  airArray *mop;
+
+  if (!(ctx && ans && pvl && item)) {
+    biffAddf(GAGE, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (!ansNum) {
+    biffAddf(GAGE, "%s: need at least one answer to save", me);
+    return 1;
+  }
+  if (!( axis <= 2 )) {
+    biffAddf(GAGE, "%s: axis %u not in range [0,2]", me, axis);
+    return 1;
+  }
+  if (!AIR_EXISTS(step)) {
+    biffAddf(GAGE, "%s: got non-existent step %g", me, step);
+    return 1;
+  }
+  if (ctx->parm.stackUse) {
+    biffAddf(GAGE, "%s: can't use with parm.stackUse", me);
+    return 1;
+  }
+  mop = airMopNew();
+  ansSrc = AIR_CALLOC(ansNum, const double *);
+  airMopAdd(mop, AIR_CAST(void *, ansSrc), airFree, airMopAlways);
+  ansLen = AIR_CALLOC(ansNum, unsigned int);
+  airMopAdd(mop, ansLen, airFree, airMopAlways);
+  if (!(ansSrc && ansLen)) {
+    biffAddf(GAGE, "%s: couldn't allocate answer info", me);
+    airMopError(mop); return 1;
+  }
+  if (_gageBatchAnswerSetup(ansSrc, ansLen, ctx, ans, pvl, item, ansNum)) {
+    biffAddf(GAGE, "%s: problem with answers", me);
+    airMopError(mop); return 1;
+  }
+
+  fnum = 0;
+  ELL_3V_SET(pos, xi, yi, zi);
+  for (pi=0; pi<posNum; pi++) {
+    /* computing (instead of incrementing) the position avoids
+       accumulating round-off along long scanlines */
+    pos[axis] = (0 == axis ? xi : (1 == axis ? yi : zi)) + step*pi;
+    failed = _gageProbeSpace(ctx, pos[0], pos[1], pos[2], AIR_NAN,
+                             AIR_TRUE /* indexSpace */, clamp);
+    fnum += !!failed;
+    _gageBatchAnswerSave(ans, errNum, ansSrc, ansLen, ansNum,
+                         pi, posNum, ctx, failed);
+  }
+  if (failNum) {
+    *failNum = fnum;
+  }
+  airMopOkay(mop);
+  return 0;
+}
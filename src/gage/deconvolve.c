@@ -154,28 +154,242 @@ gageDeconvolve(Nrrd *_nout, double *lastDiffP,
   return 0;
 }
 
+/*
+******** gageDeconvolveSeparable
+**
+** gageDeconvolveSeparableThreaded() with a single thread
+*/
+int
+gageDeconvolveSeparable(Nrrd *nout, const Nrrd *nin,
+                        const gageKind *kind,
+                        const NrrdKernelSpec *ksp,
+                        int typeOut) {
+  static const char me[]="gageDeconvolveSeparable";
+
+  if (gageDeconvolveSeparableThreaded(nout, nin, kind, ksp, typeOut, 1)) {
+    biffAddf(GAGE, "%s: trouble", me);
+    return 1;
+  }
+  return 0;
+}
+
 /*
 *******************************
 ** all the following functionality should at some point be
 ** pushed down to nrrd . . .
 */
 
-static void
-deconvLine(double *line, size_t llen, const NrrdKernelSpec *ksp) {
+/*
+** The separable deconvolution for the B-splines is the recursive (IIR)
+** prefilter of Unser, Aldroubi, and Eden ("B-Spline Signal Processing:
+** Part II", IEEE Trans. Signal Processing, 41(2):834-848, 1993) as
+** described by Thevenaz, Blu, and Unser ("Interpolation Revisited",
+** IEEE Trans. Medical Imaging, 19(7):739-758, 2000): after scaling by
+** the gain, each pole z gets a causal and then an anti-causal
+** first-order recursion, with initial values from a mirror-symmetric
+** extension of the line.
+*/
+
+/* lines are processed in "panels" of up to this many lines that are
+   next to each other in memory, so that the recursions along an axis
+   have a contiguous inner loop */
+#define DECONV_PANEL 64
 
-  /* Add as many other parameters to this as you want,
-     like number and location of poles, or whatever other
-     buffers you think you need (they should be passed,
-     not allocated and freed on a per-line basis) */
+/* more than the number of poles of any known kernel */
+#define DECONV_POLE_MAX 4
+
+/*
+** sets in pole[] the poles of the prefilter for the B-spline that kern
+** is (or is a derivative of), and returns how many there are, or 0 if
+** there is no such prefilter
+*/
+static unsigned int
+deconvPoles(double pole[DECONV_POLE_MAX], const NrrdKernel *kern) {
+  unsigned int ret;
 
-  /* comment these out when there is a real function body */
-  AIR_UNUSED(line);
-  AIR_UNUSED(llen);
-  AIR_UNUSED(ksp);
+  if (nrrdKernelBSpline3 == kern
+      || nrrdKernelBSpline3D == kern
+      || nrrdKernelBSpline3DD == kern
+      || nrrdKernelBSpline3DDD == kern) {
+    /* sqrt(3) - 2 */
+    pole[0] = -0.26794919243112270647255365849413;
+    ret = 1;
+  } else if (nrrdKernelBSpline5 == kern
+             || nrrdKernelBSpline5D == kern
+             || nrrdKernelBSpline5DD == kern
+             || nrrdKernelBSpline5DDD == kern) {
+    pole[0] = -0.43057534709997379185143478349328;
+    pole[1] = -0.043096288203264653867903183689290;
+    ret = 2;
+  } else if (nrrdKernelBSpline7 == kern
+             || nrrdKernelBSpline7D == kern
+             || nrrdKernelBSpline7DD == kern
+             || nrrdKernelBSpline7DDD == kern) {
+    pole[0] = -0.53528043079643816554240378168165;
+    pole[1] = -0.12255461519232669051527226435936;
+    pole[2] = -0.0091486948096082769285930216516478;
+    ret = 3;
+  } else {
+    ret = 0;
+  }
+  return ret;
+}
 
+/*
+** deconvPanel
+**
+** deconvolves in place the ww lines in buff, each of length llen, with
+** sample ii of line jj at buff[jj + ww*ii]; acc is a buffer for ww
+** values.  Each line is taken to be mirrored (without repeating the end
+** samples) at both ends.
+*/
+static void
+deconvPanel(double *buff, double *acc, size_t llen, size_t ww,
+            const double *pole, unsigned int poleNum, double gain) {
+  size_t ii, jj, horiz, NN;
+  unsigned int pi;
+  double zz, zn, z2n, iz, *row, *prev;
+
+  if (1 == llen) {
+    /* the mirrored line is constant, and so is its deconvolution */
+    return;
+  }
+  NN = llen*ww;
+  for (ii=0; ii<NN; ii++) {
+    buff[ii] *= gain;
+  }
+  for (pi=0; pi<poleNum; pi++) {
+    zz = pole[pi];
+    /* initial value for causal recursion */
+    horiz = AIR_CAST(size_t, ceil(log(DBL_EPSILON)/log(fabs(zz))));
+    if (horiz < llen) {
+      /* the sum is truncated where z^n is negligible */
+      for (jj=0; jj<ww; jj++) {
+        acc[jj] = buff[jj];
+      }
+      zn = zz;
+      for (ii=1; ii<horiz; ii++) {
+        row = buff + ww*ii;
+        for (jj=0; jj<ww; jj++) {
+          acc[jj] += zn*row[jj];
+        }
+        zn *= zz;
+      }
+    } else {
+      /* the full sum over the mirrored line */
+      iz = 1.0/zz;
+      zn = zz;
+      z2n = pow(zz, AIR_CAST(double, llen - 1));
+      row = buff + ww*(llen - 1);
+      for (jj=0; jj<ww; jj++) {
+        acc[jj] = buff[jj] + z2n*row[jj];
+      }
+      z2n *= z2n*iz;
+      for (ii=1; ii<llen-1; ii++) {
+        row = buff + ww*ii;
+        for (jj=0; jj<ww; jj++) {
+          acc[jj] += (zn + z2n)*row[jj];
+        }
+        zn *= zz;
+        z2n *= iz;
+      }
+      for (jj=0; jj<ww; jj++) {
+        acc[jj] /= (1.0 - zn*zn);
+      }
+    }
+    for (jj=0; jj<ww; jj++) {
+      buff[jj] = acc[jj];
+    }
+    /* causal recursion */
+    for (ii=1; ii<llen; ii++) {
+      row = buff + ww*ii;
+      prev = row - ww;
+      for (jj=0; jj<ww; jj++) {
+        row[jj] += zz*prev[jj];
+      }
+    }
+    /* initial value for anti-causal recursion */
+    row = buff + ww*(llen - 1);
+    prev = row - ww;
+    for (jj=0; jj<ww; jj++) {
+      row[jj] = (zz/(zz*zz - 1.0))*(zz*prev[jj] + row[jj]);
+    }
+    /* anti-causal recursion */
+    for (ii=llen-1; ii>0; ii--) {
+      row = buff + ww*(ii - 1);
+      prev = row + ww;
+      for (jj=0; jj<ww; jj++) {
+        row[jj] = zz*(prev[jj] - row[jj]);
+      }
+    }
+  }
   return;
 }
 
+/*
+** the work of one thread in gageDeconvolveSeparable(): the data (of type
+** float or double) is seen as an array of "outer" slabs, each of which
+** is llen rows (one for each sample along the axis being deconvolved)
+** of "inner" contiguous values.  Panels are numbered with panelNum
+** panels across each slab, and the thread does panels [lo,hi).
+*/
+typedef struct {
+  void *data;
+  int type;
+  size_t inner, llen, lo, hi;
+  const double *pole;
+  unsigned int poleNum;
+  double gain, *buff, *acc;
+} deconvTask;
+
+static void *
+deconvWorker(void *_task) {
+  deconvTask *task;
+  size_t pidx, panelNum, ww, ii, jj, start;
+  float *fdata;
+  double *ddata;
+
+  task = AIR_CAST(deconvTask *, _task);
+  panelNum = (task->inner + DECONV_PANEL - 1)/DECONV_PANEL;
+  fdata = AIR_CAST(float *, task->data);
+  ddata = AIR_CAST(double *, task->data);
+  for (pidx=task->lo; pidx<task->hi; pidx++) {
+    start = (pidx % panelNum)*DECONV_PANEL;
+    ww = AIR_MIN(DECONV_PANEL, task->inner - start);
+    start += (pidx/panelNum)*task->llen*task->inner;
+    if (nrrdTypeFloat == task->type) {
+      for (ii=0; ii<task->llen; ii++) {
+        for (jj=0; jj<ww; jj++) {
+          task->buff[jj + ww*ii] = fdata[start + jj + task->inner*ii];
+        }
+      }
+    } else {
+      for (ii=0; ii<task->llen; ii++) {
+        for (jj=0; jj<ww; jj++) {
+          task->buff[jj + ww*ii] = ddata[start + jj + task->inner*ii];
+        }
+      }
+    }
+    deconvPanel(task->buff, task->acc, task->llen, ww,
+                task->pole, task->poleNum, task->gain);
+    if (nrrdTypeFloat == task->type) {
+      for (ii=0; ii<task->llen; ii++) {
+        for (jj=0; jj<ww; jj++) {
+          fdata[start + jj + task->inner*ii] =
+            AIR_CAST(float, task->buff[jj + ww*ii]);
+        }
+      }
+    } else {
+      for (ii=0; ii<task->llen; ii++) {
+        for (jj=0; jj<ww; jj++) {
+          ddata[start + jj + task->inner*ii] = task->buff[jj + ww*ii];
+        }
+      }
+    }
+  }
+  return _task;
+}
+
 static int
 deconvTrivial(const NrrdKernelSpec *ksp) {
   int ret;
@@ -197,13 +411,13 @@ deconvTrivial(const NrrdKernelSpec *ksp) {
 
 int
 gageDeconvolveSeparableKnown(const NrrdKernelSpec *ksp) {
+  double pole[DECONV_POLE_MAX];
   int ret;
 
   if (!ksp) {
     ret = 0;
   } else if (deconvTrivial(ksp)
-             || nrrdKernelBSpline3 == ksp->kernel
-             || nrrdKernelBSpline5 == ksp->kernel) {
+             || deconvPoles(pole, ksp->kernel)) {
     ret = 1;
   } else {
     ret = 0;
@@ -211,17 +425,37 @@ gageDeconvolveSeparableKnown(const NrrdKernelSpec *ksp) {
   return ret;
 }
 
+/*
+******** gageDeconvolveSeparableThreaded
+**
+** deconvolves nin by the given kernel, separably along the three spatial
+** axes, so that reconstructing from nout with the kernel (or its
+** derivatives) interpolates nin.  For the B-splines (orders 3, 5, and
+** 7) this is done with recursive filtering, in threadNum threads; the
+** result doesn't depend on threadNum.  The line ends are handled as
+** mirror-symmetric, so with gage's clamping at the volume boundary the
+** interpolation is exact only for samples that are at least the kernel
+** support away from the boundary.
+**
+** Output type typeOut can be nrrdTypeDefault for the type of nin.  The
+** work is done in-place in the output when it is float or double, and
+** nout can be nin (with typeOut nrrdTypeDefault or nin->type) to avoid
+** any allocation.  Otherwise, the work is done in a double-precision
+** copy, which is then clamped and converted to the output type.
+*/
 int
-gageDeconvolveSeparable(Nrrd *nout, const Nrrd *nin,
-                        const gageKind *kind,
-                        const NrrdKernelSpec *ksp,
-                        int typeOut) {
-  static const char me[]="gageDeconvolveSeparable";
-  double *line, (*lup)(const void *, size_t),
-    (*ins)(void *, size_t, double);
+gageDeconvolveSeparableThreaded(Nrrd *nout, const Nrrd *nin,
+                                const gageKind *kind,
+                                const NrrdKernelSpec *ksp,
+                                int typeOut, unsigned int threadNum) {
+  static const char me[]="gageDeconvolveSeparableThreaded";
+  double pole[DECONV_POLE_MAX], gain;
+  deconvTask *task;
   airArray *mop;
-  size_t lineLen, sx, sy, sz, idx, ii, jj;
-  unsigned int vi, valLen;
+  Nrrd *nwork;
+  size_t size[3], lineLen, inner, outer, panelNum;
+  unsigned int ai, ti, pi, poleNum;
+  int type;
 
   if (!(nout && nin && kind && ksp)) {
     biffAddf(GAGE, "%s: got NULL pointer", me);
@@ -232,6 +466,10 @@ gageDeconvolveSeparable(Nrrd *nout, const Nrrd *nin,
     biffAddf(GAGE, "%s: typeOut %d not valid", me, typeOut);
     return 1;
   }
+  if (!threadNum) {
+    biffAddf(GAGE, "%s: need non-zero threadNum", me);
+    return 1;
+  }
   if (!gageDeconvolveSeparableKnown(ksp)) {
     biffAddf(GAGE, "%s: separable deconv not known for %s kernel",
              me, ksp->kernel->name);
@@ -242,9 +480,24 @@ gageDeconvolveSeparable(Nrrd *nout, const Nrrd *nin,
              me, kind->name);
     return 1;
   }
-  if (nrrdTypeDefault == typeOut
-      ? nrrdCopy(nout, nin)
-      : nrrdConvert(nout, nin, typeOut)) {
+  type = (nrrdTypeDefault == typeOut ? nin->type : typeOut);
+  if (nout == nin && type != nin->type) {
+    biffAddf(GAGE, "%s: can't work in-place with output type %s "
+             "different from input %s", me, airEnumStr(nrrdType, type),
+             airEnumStr(nrrdType, nin->type));
+    return 1;
+  }
+  if (nout == nin && !( nrrdTypeFloat == type || nrrdTypeDouble == type )) {
+    biffAddf(GAGE, "%s: can only work in-place with %s or %s (not %s)", me,
+             airEnumStr(nrrdType, nrrdTypeFloat),
+             airEnumStr(nrrdType, nrrdTypeDouble),
+             airEnumStr(nrrdType, type));
+    return 1;
+  }
+  if (nout != nin
+      && (type == nin->type
+          ? nrrdCopy(nout, nin)
+          : nrrdConvert(nout, nin, type))) {
     biffMovef(GAGE, NRRD, "%s: problem allocating output", me);
     return 1;
   }
@@ -254,84 +507,76 @@ gageDeconvolveSeparable(Nrrd *nout, const Nrrd *nin,
     return 0;
   }
 
-  valLen = kind->valLen;
-  sx = nin->axis[kind->baseDim + 0].size;
-  sy = nin->axis[kind->baseDim + 1].size;
-  sz = nin->axis[kind->baseDim + 2].size;
-  lineLen = sx;
-  lineLen = AIR_MAX(lineLen, sy);
-  lineLen = AIR_MAX(lineLen, sz);
-  lup = nrrdDLookup[nin->type];
-  ins = nrrdDInsert[nout->type];
-
   mop = airMopNew();
-  line = AIR_CALLOC(lineLen*valLen, double);
-  airMopAdd(mop, line, airFree, airMopAlways);
-
-  /* process along X scanlines */
-  for (jj=0; jj<sy*sz; jj++) {
-    /* xi = 0, yi = jj%sy, zi = jj/sy
-       ==> xi + sx*(yi + sy*zi)
-       == 0 + sx*(jj%sy + sy*(jj/sy)) == 0 + sx*jj */
-    idx = 0 + valLen*(0 + sx*jj);
-    for (ii=0; ii<sx; ii++) {
-      for (vi=0; vi<valLen; vi++) {
-        line[ii + sx*vi] = lup(nin->data, idx + vi + valLen*ii);
-      }
-    }
-    for (vi=0; vi<valLen; vi++) {
-      deconvLine(line + sx*vi, sx, ksp);
-    }
-    for (ii=0; ii<sx; ii++) {
-      for (vi=0; vi<valLen; vi++) {
-        ins(nout->data, idx + vi + valLen*ii, line[ii + sx*vi]);
-      }
+  if (nrrdTypeFloat == type || nrrdTypeDouble == type) {
+    nwork = nout;
+  } else {
+    nwork = nrrdNew();
+    airMopAdd(mop, nwork, (airMopper)nrrdNuke, airMopAlways);
+    if (nrrdConvert(nwork, nin, nrrdTypeDouble)) {
+      biffMovef(GAGE, NRRD, "%s: couldn't allocate working buffer", me);
+      airMopError(mop); return 1;
     }
   }
-
-  /* process along Y scanlines */
-  for (jj=0; jj<sx*sz; jj++) {
-    /* xi = jj%sx, yi = 0, zi = jj/sx
-       ==> xi + sx*(yi + sy*zi)
-       == jj%sx + sx*(0 + sy*jj/sx) */
-    idx = 0 + valLen*((jj%sx) + sx*(0 + sy*(jj/sx)));
-    for (ii=0; ii<sy; ii++) {
-      for (vi=0; vi<valLen; vi++) {
-        line[ii + sy*vi] = lup(nin->data, idx + vi + valLen*sx*ii);
-      }
-    }
-    for (vi=0; vi<valLen; vi++) {
-      deconvLine(line + sy*vi, sy, ksp);
-    }
-    for (ii=0; ii<sx; ii++) {
-      for (vi=0; vi<valLen; vi++) {
-        ins(nout->data, idx + vi + valLen*sx*ii, line[ii + sy*vi]);
-      }
+  poleNum = deconvPoles(pole, ksp->kernel);
+  gain = 1.0;
+  for (pi=0; pi<poleNum; pi++) {
+    gain *= (1.0 - pole[pi])*(1.0 - 1.0/pole[pi]);
+  }
+  lineLen = 0;
+  for (ai=0; ai<3; ai++) {
+    size[ai] = nin->axis[kind->baseDim + ai].size;
+    lineLen = AIR_MAX(lineLen, size[ai]);
+  }
+  task = AIR_CALLOC(threadNum, deconvTask);
+  airMopAdd(mop, task, airFree, airMopAlways);
+  if (!task) {
+    biffAddf(GAGE, "%s: couldn't allocate %u tasks", me, threadNum);
+    airMopError(mop); return 1;
+  }
+  for (ti=0; ti<threadNum; ti++) {
+    task[ti].data = nwork->data;
+    task[ti].type = nwork->type;
+    task[ti].pole = pole;
+    task[ti].poleNum = poleNum;
+    task[ti].gain = gain;
+    task[ti].buff = AIR_CALLOC(lineLen*DECONV_PANEL, double);
+    airMopAdd(mop, task[ti].buff, airFree, airMopAlways);
+    task[ti].acc = AIR_CALLOC(DECONV_PANEL, double);
+    airMopAdd(mop, task[ti].acc, airFree, airMopAlways);
+    if (!( task[ti].buff && task[ti].acc )) {
+      biffAddf(GAGE, "%s: couldn't allocate buffers for thread %u", me, ti);
+      airMopError(mop); return 1;
     }
   }
+  if (1 < threadNum && !airThreadCapable) {
+    fprintf(stderr, "%s: WARNING: not multi-threaded; will do %u "
+            "\"threads\" serially !!!\n", me, threadNum);
+  }
 
-  /* process along Z scanlines */
-  for (jj=0; jj<sx*sy; jj++) {
-    /* xi = jj%sx, yi = jj/sx, zi = 0
-       ==> xi + sx*(yi + sy*zi)
-       == jj%sx + sx*(jj/sx + sy*0)
-       == jj%sx + sx*(jj/sx) == jj */
-    idx = 0 + valLen*jj;
-    for (ii=0; ii<sz; ii++) {
-      for (vi=0; vi<valLen; vi++) {
-        line[ii + sz*vi] = lup(nin->data, idx + vi + valLen*sx*sy*ii);
-      }
-    }
-    for (vi=0; vi<valLen; vi++) {
-      deconvLine(line + sz*vi, sz, ksp);
+  /* along X, Y, and then Z */
+  inner = kind->valLen;
+  outer = size[0]*size[1]*size[2];
+  for (ai=0; ai<3; ai++) {
+    outer /= size[ai];
+    panelNum = outer*((inner + DECONV_PANEL - 1)/DECONV_PANEL);
+    for (ti=0; ti<threadNum; ti++) {
+      task[ti].inner = inner;
+      task[ti].llen = size[ai];
+      task[ti].lo = panelNum*ti/threadNum;
+      task[ti].hi = panelNum*(ti+1)/threadNum;
     }
-    for (ii=0; ii<sx; ii++) {
-      for (vi=0; vi<valLen; vi++) {
-        ins(nout->data, idx + vi + valLen*sx*sy*ii, line[ii + sz*vi]);
-      }
+    if (airThreadRun(deconvWorker, task, sizeof(*task), threadNum)) {
+      biffAddf(GAGE, "%s: couldn't run %u threads", me, threadNum);
+      airMopError(mop); return 1;
     }
+    inner *= size[ai];
   }
 
+  if (nwork != nout && nrrdClampConvert(nout, nwork, type)) {
+    biffMovef(GAGE, NRRD, "%s: couldn't create output", me);
+    airMopError(mop); return 1;
+  }
   airMopOkay(mop);
   return 0;
 }
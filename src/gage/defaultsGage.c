@@ -80,3 +80,6 @@ gageDefGenerateErrStr = AIR_TRUE;
 
 int
 gageDefTwoDimZeroZ = AIR_FALSE; /* no way this can default to true */
+
+int
+gageDefSinglePrecision = AIR_FALSE;
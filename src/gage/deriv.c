@@ -0,0 +1,351 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "gage.h"
+#include "privateGage.h"
+
+/*
+** Pre-filtered derivative volumes: when a pervolume is probed densely
+** (volume rendering, isosurfacing, probing on a grid), the same
+** neighborhoods get re-convolved many times over.  With
+** gagePerVolumeDerivPrecomputeSet(), gageUpdate() instead convolves the
+** whole volume once with the context's kernels (k00, k11, k22), one
+** axis at a time with nrrdResampleExecute(), to get the value and the
+** needed index-space gradient and Hessian components at every sample.
+** Probing then trilinearly interpolates those, and the kind's answer
+** method works as usual from the interpolated results.  This trades
+** memory (up to 10 doubles per sample) and some accuracy (the
+** interpolation between samples is only linear) for much less work per
+** probe.
+**
+** The derivative volume has the components along the fastest axis:
+** value (if needD[0]), then gradient x,y,z (if needD[1]), then
+** Hessian xx,xy,xz,yy,yz,zz (if needD[2]).  Currently only the scalar
+** kind, without a scale-space stack, can use this.
+*/
+
+/* derivative orders along x, y, z, of the possible components */
+static const unsigned int
+_gageDerivOrder[10][3] = {
+  {0, 0, 0},
+  {1, 0, 0}, {0, 1, 0}, {0, 0, 1},
+  {2, 0, 0}, {1, 1, 0}, {1, 0, 1}, {0, 2, 0}, {0, 1, 1}, {0, 0, 2}
+};
+
+/*
+******** gagePerVolumeDerivPrecomputeSet
+**
+** turns on or off derivative pre-computation for this pervolume; the
+** derivative volume is (re-)computed or freed by the next gageUpdate()
+*/
+int
+gagePerVolumeDerivPrecomputeSet(gagePerVolume *pvl, int precompute) {
+  static const char me[]="gagePerVolumeDerivPrecomputeSet";
+
+  if (!pvl) {
+    biffAddf(GAGE, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (precompute && pvl->kind != gageKindScl) {
+    biffAddf(GAGE, "%s: sorry, can only pre-compute derivatives of "
+             "%s kind, not %s", me, gageKindScl->name, pvl->kind->name);
+    return 1;
+  }
+  pvl->derivPrecompute = !!precompute;
+  pvl->flag[gagePvlFlagDeriv] = AIR_TRUE;
+  return 0;
+}
+
+/*
+** convolves nin along axis "axis" with the kernel for derivative order
+** "order", leaving the number of samples unchanged
+*/
+static int
+_gageDerivConvolve(Nrrd *nout, NrrdResampleContext *rsmc, const Nrrd *nin,
+                   const gageContext *ctx, unsigned int axis,
+                   unsigned int order) {
+  static const char me[]="_gageDerivConvolve";
+  static const int kidx[3] = {gageKernel00, gageKernel11, gageKernel22};
+  NrrdKernelSpec *ksp;
+  unsigned int ai;
+  int E;
+
+  ksp = ctx->ksp[kidx[order]];
+  if (!ksp) {
+    biffAddf(GAGE, "%s: need kernel %s for derivative %u", me,
+             airEnumStr(gageKernel, kidx[order]), order);
+    return 1;
+  }
+  E = 0;
+  if (!E) E |= nrrdResampleInputSet(rsmc, nin);
+  for (ai=0; ai<3; ai++) {
+    if (ai == axis) {
+      if (!E) E |= nrrdResampleKernelSet(rsmc, ai, ksp->kernel, ksp->parm);
+      if (!E) E |= nrrdResampleSamplesSet(rsmc, ai, nin->axis[ai].size);
+      if (!E) E |= nrrdResampleRangeFullSet(rsmc, ai);
+    } else {
+      if (!E) E |= nrrdResampleKernelSet(rsmc, ai, NULL, NULL);
+    }
+  }
+  if (!E) E |= nrrdResampleExecute(rsmc, nout);
+  if (E) {
+    biffMovef(GAGE, NRRD, "%s: trouble convolving axis %u with %s", me,
+              axis, ksp->kernel->name);
+    return 1;
+  }
+  return 0;
+}
+
+/*
+** computes pvl->nderiv from pvl->nin, according to pvl->needD
+*/
+static int
+_gageDerivCompute(gageContext *ctx, gagePerVolume *pvl) {
+  static const char me[]="_gageDerivCompute";
+  NrrdResampleContext *rsmc;
+  Nrrd *nx[3], *nxy[3][3], *nxyz, *nout;
+  unsigned int ci, compNum, comp[10], ox, oy, oz;
+  size_t ii, NN;
+  double *out;
+  const double *in;
+  airArray *mop;
+  int E;
+
+  compNum = 0;
+  if (pvl->needD[0]) {
+    comp[compNum++] = 0;
+  }
+  if (pvl->needD[1]) {
+    comp[compNum++] = 1; comp[compNum++] = 2; comp[compNum++] = 3;
+  }
+  if (pvl->needD[2]) {
+    for (ci=4; ci<10; ci++) {
+      comp[compNum++] = ci;
+    }
+  }
+  if (!compNum) {
+    /* nothing to compute */
+    return 0;
+  }
+
+  mop = airMopNew();
+  rsmc = nrrdResampleContextNew();
+  airMopAdd(mop, rsmc, (airMopper)nrrdResampleContextNix, airMopAlways);
+  E = 0;
+  if (!E) E |= nrrdResampleDefaultCenterSet(rsmc, ctx->shape->center);
+  if (!E) E |= nrrdResampleBoundarySet(rsmc, nrrdBoundaryBleed);
+  if (!E) E |= nrrdResampleTypeOutSet(rsmc, nrrdTypeDouble);
+  if (!E) E |= nrrdResampleRenormalizeSet(rsmc, AIR_FALSE);
+  if (!E) E |= nrrdResampleRoundSet(rsmc, AIR_FALSE);
+  if (!E) E |= nrrdResampleClampSet(rsmc, AIR_FALSE);
+  if (E) {
+    biffMovef(GAGE, NRRD, "%s: trouble setting up resampling", me);
+    airMopError(mop); return 1;
+  }
+  for (ox=0; ox<3; ox++) {
+    nx[ox] = NULL;
+    for (oy=0; oy<3; oy++) {
+      nxy[ox][oy] = NULL;
+    }
+  }
+  nxyz = nrrdNew();
+  airMopAdd(mop, nxyz, (airMopper)nrrdNuke, airMopAlways);
+  nout = nrrdNew();
+  airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopOnError);
+  NN = nrrdElementNumber(pvl->nin);
+  if (nrrdMaybeAlloc_va(nout, nrrdTypeDouble, 4,
+                        AIR_CAST(size_t, compNum),
+                        pvl->nin->axis[0].size,
+                        pvl->nin->axis[1].size,
+                        pvl->nin->axis[2].size)) {
+    biffMovef(GAGE, NRRD, "%s: couldn't allocate derivative volume", me);
+    airMopError(mop); return 1;
+  }
+  out = AIR_CAST(double *, nout->data);
+  for (ci=0; ci<compNum; ci++) {
+    ox = _gageDerivOrder[comp[ci]][0];
+    oy = _gageDerivOrder[comp[ci]][1];
+    oz = _gageDerivOrder[comp[ci]][2];
+    /* the partial results of the x and y passes are shared among the
+       components that need them */
+    if (!nx[ox]) {
+      nx[ox] = nrrdNew();
+      airMopAdd(mop, nx[ox], (airMopper)nrrdNuke, airMopAlways);
+      if (_gageDerivConvolve(nx[ox], rsmc, pvl->nin, ctx, 0, ox)) {
+        biffAddf(GAGE, "%s: trouble on component %u x pass", me, ci);
+        airMopError(mop); return 1;
+      }
+    }
+    if (!nxy[ox][oy]) {
+      nxy[ox][oy] = nrrdNew();
+      airMopAdd(mop, nxy[ox][oy], (airMopper)nrrdNuke, airMopAlways);
+      if (_gageDerivConvolve(nxy[ox][oy], rsmc, nx[ox], ctx, 1, oy)) {
+        biffAddf(GAGE, "%s: trouble on component %u y pass", me, ci);
+        airMopError(mop); return 1;
+      }
+    }
+    if (_gageDerivConvolve(nxyz, rsmc, nxy[ox][oy], ctx, 2, oz)) {
+      biffAddf(GAGE, "%s: trouble on component %u z pass", me, ci);
+      airMopError(mop); return 1;
+    }
+    in = AIR_CAST(const double *, nxyz->data);
+    for (ii=0; ii<NN; ii++) {
+      out[ci + compNum*ii] = in[ii];
+    }
+  }
+  pvl->nderiv = nout;
+  pvl->nderivOwn = AIR_TRUE;
+  airMopOkay(mop);
+  return 0;
+}
+
+/*
+** _gageDerivUpdate
+**
+** (re-)computes, or frees, the derivative volumes of the pervolumes
+** whose gagePvlFlagDeriv flag is up.  Called by gageUpdate() once the
+** kernels and the pvl->needD are known.
+*/
+int
+_gageDerivUpdate(gageContext *ctx) {
+  static const char me[]="_gageDerivUpdate";
+  gagePerVolume *pvl;
+  unsigned int pvlIdx;
+
+  for (pvlIdx=0; pvlIdx<ctx->pvlNum; pvlIdx++) {
+    pvl = ctx->pvl[pvlIdx];
+    if (!pvl->flag[gagePvlFlagDeriv]) {
+      continue;
+    }
+    if (pvl->nderivOwn) {
+      nrrdNuke(pvl->nderiv);
+    }
+    pvl->nderiv = NULL;
+    pvl->nderivOwn = AIR_FALSE;
+    if (!pvl->derivPrecompute) {
+      continue;
+    }
+    if (ctx->parm.stackUse) {
+      biffAddf(GAGE, "%s: sorry, can't pre-compute derivatives (of "
+               "pvl[%u]) when using a scale-space stack", me, pvlIdx);
+      return 1;
+    }
+    if (gageStoreFull != pvl->store) {
+      biffAddf(GAGE, "%s: sorry, can't pre-compute derivatives of pvl[%u] "
+               "with %s store", me, pvlIdx,
+               airEnumStr(gageStore, pvl->store));
+      return 1;
+    }
+    if (!ctx->parm.k3pack) {
+      biffAddf(GAGE, "%s: sorry, can only pre-compute derivatives (of "
+               "pvl[%u]) with k3pack", me, pvlIdx);
+      return 1;
+    }
+    if (ctx->verbose) {
+      fprintf(stderr, "%s: pre-computing derivatives of pvl[%u]\n",
+              me, pvlIdx);
+    }
+    if (_gageDerivCompute(ctx, pvl)) {
+      biffAddf(GAGE, "%s: trouble pre-computing derivatives of pvl[%u]",
+               me, pvlIdx);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/*
+** _gageDerivProbe
+**
+** in place of gageIv3Fill() and kind->filter(): sets the value,
+** gradient, and Hessian answers of the pervolume by trilinear
+** interpolation in pvl->nderiv, at the location last set by
+** _gageLocationSet()
+*/
+void
+_gageDerivProbe(gageContext *ctx, gagePerVolume *pvl) {
+  unsigned int ai, ci, ti, compNum, size[3], inNum[3], fr;
+  int lo[3], hi[3], lx, hx;
+  size_t cidx[2][3];
+  double ww[2][3], wght, val[10], *gvec, *hess;
+  const double *data, *here;
+
+  compNum = AIR_CAST(unsigned int, pvl->nderiv->axis[0].size);
+  data = AIR_CAST(const double *, pvl->nderiv->data);
+  fr = ctx->radius;
+  for (ai=0; ai<3; ai++) {
+    size[ai] = ctx->shape->size[ai];
+    /* idx-1: see Thu Jan 14 comment in filter.c */
+    lo[ai] = AIR_CAST(int, ctx->point.idx[ai]) - 1;
+    hi[ai] = lo[ai] + 1;
+    cidx[0][ai] = AIR_CAST(size_t, AIR_CLAMP(0, lo[ai],
+                                             AIR_CAST(int, size[ai]-1)));
+    cidx[1][ai] = AIR_CAST(size_t, AIR_CLAMP(0, hi[ai],
+                                             AIR_CAST(int, size[ai]-1)));
+    ww[0][ai] = 1 - ctx->point.frac[ai];
+    ww[1][ai] = ctx->point.frac[ai];
+    /* for ctx->edgeFrac: how many of the samples in the support of the
+       kernels (had they been used) are inside the volume */
+    lx = lo[ai] - AIR_CAST(int, fr - 1);
+    hx = lx + 2*AIR_CAST(int, fr) - 1;
+    inNum[ai] = AIR_CAST(unsigned int,
+                         AIR_MIN(hx, AIR_CAST(int, size[ai]-1))
+                         - AIR_MAX(lx, 0) + 1);
+  }
+  ctx->edgeFrac = 1 - (AIR_CAST(double, inNum[0]*inNum[1]*inNum[2])
+                       /(8*fr*fr*fr));
+  for (ci=0; ci<compNum; ci++) {
+    val[ci] = 0;
+  }
+  for (ti=0; ti<8; ti++) {
+    unsigned int bx = ti & 1, by = (ti >> 1) & 1, bz = ti >> 2;
+    wght = ww[bx][0]*ww[by][1]*ww[bz][2];
+    here = data + compNum*(cidx[bx][0]
+                           + size[0]*(cidx[by][1]
+                                      + size[1]*cidx[bz][2]));
+    for (ci=0; ci<compNum; ci++) {
+      val[ci] += wght*here[ci];
+    }
+  }
+  ci = 0;
+  if (pvl->needD[0]) {
+    pvl->directAnswer[gageSclValue][0] = val[ci++];
+  }
+  if (pvl->needD[1]) {
+    gvec = pvl->directAnswer[gageSclGradVec];
+    ELL_3V_COPY(gvec, val + ci);
+    ci += 3;
+    ell_3mv_mul_d(gvec, ctx->shape->ItoWSubInvTransp, gvec);
+  }
+  if (pvl->needD[2]) {
+    double matA[9];
+    hess = pvl->directAnswer[gageSclHessian];
+    ELL_3M_SET(hess,
+               val[ci+0], val[ci+1], val[ci+2],
+               val[ci+1], val[ci+3], val[ci+4],
+               val[ci+2], val[ci+4], val[ci+5]);
+    ELL_3M_MUL(matA, ctx->shape->ItoWSubInvTransp, hess);
+    ELL_3M_MUL(hess, matA, ctx->shape->ItoWSubInv);
+  }
+  return;
+}
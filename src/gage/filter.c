@@ -34,7 +34,7 @@
 ** weights may not be the desired ones.  Forward differencing (via
 ** nrrdKernelForwDiff) is a good example of this.
 */
-void
+static void
 _gageFslSet(gageContext *ctx) {
   int fr, i;
   double *fslx, *fsly, *fslz;
@@ -71,89 +71,92 @@ _gageFslSet(gageContext *ctx) {
 }
 
 /*
-** renormalize weights of a reconstruction kernel with
+** renormalize weights (along one axis) of a reconstruction kernel with
 ** constraint: the sum of the weights must equal the continuous
 ** integral of the kernel
 */
-void
-_gageFwValueRenormalize(gageContext *ctx, int wch) {
-  double integral, sumX, sumY, sumZ, *fwX, *fwY, *fwZ;
+static void
+_gageFwValueRenormalize(gageContext *ctx, int wch, unsigned int axis) {
+  double integral, sum, *fw;
   int i, fd;
 
   fd = 2*ctx->radius;
-  fwX = ctx->fw + 0 + fd*(0 + 3*wch);
-  fwY = ctx->fw + 0 + fd*(1 + 3*wch);
-  fwZ = ctx->fw + 0 + fd*(2 + 3*wch);
+  fw = ctx->fw + 0 + fd*(axis + 3*wch);
   integral = ctx->ksp[wch]->kernel->integral(ctx->ksp[wch]->parm);
-  sumX = sumY = sumZ = 0;
+  sum = 0;
   for (i=0; i<fd; i++) {
-    sumX += fwX[i];
-    sumY += fwY[i];
-    sumZ += fwZ[i];
+    sum += fw[i];
   }
   for (i=0; i<fd; i++) {
-    fwX[i] *= integral/sumX;
-    fwY[i] *= integral/sumY;
-    fwZ[i] *= integral/sumZ;
+    fw[i] *= integral/sum;
   }
   return;
 }
 
 /*
-** renormalize weights of a derivative kernel with
+** renormalize weights (along one axis) of a derivative kernel with
 ** constraint: the sum of the weights must be zero, but
 ** sign of individual weights must be preserved
 */
-void
-_gageFwDerivRenormalize(gageContext *ctx, int wch) {
+static void
+_gageFwDerivRenormalize(gageContext *ctx, int wch, unsigned int axis) {
   char me[]="_gageFwDerivRenormalize";
-  double negX, negY, negZ, posX, posY, posZ, fixX, fixY, fixZ,
-    *fwX, *fwY, *fwZ;
+  double neg, pos, fix, *fw;
   int i, fd;
 
   fd = 2*ctx->radius;
-  fwX = ctx->fw + 0 + fd*(0 + 3*wch);
-  fwY = ctx->fw + 0 + fd*(1 + 3*wch);
-  fwZ = ctx->fw + 0 + fd*(2 + 3*wch);
-  negX = negY = negZ = 0;
-  posX = posY = posZ = 0;
+  fw = ctx->fw + 0 + fd*(axis + 3*wch);
+  neg = pos = 0;
   for (i=0; i<fd; i++) {
-    if (fwX[i] <= 0) { negX += -fwX[i]; } else { posX += fwX[i]; }
-    if (fwY[i] <= 0) { negY += -fwY[i]; } else { posY += fwY[i]; }
-    if (fwZ[i] <= 0) { negZ += -fwZ[i]; } else { posZ += fwZ[i]; }
+    if (fw[i] <= 0) { neg += -fw[i]; } else { pos += fw[i]; }
   }
   /* fix is the sqrt() of factor by which the positive values
      are too big.  negative values are scaled up by fix;
      positive values are scaled down by fix */
-  fixX = sqrt(posX/negX);
-  fixY = sqrt(posY/negY);
-  fixZ = sqrt(posZ/negZ);
+  fix = sqrt(pos/neg);
   if (ctx->verbose > 2) {
-    fprintf(stderr, "%s: fixX = % 10.4f, fixY = % 10.4f, fixX = % 10.4f\n",
-            me, (float)fixX, (float)fixY, (float)fixZ);
+    fprintf(stderr, "%s: fix[%u] = % 10.4f\n", me, axis, (float)fix);
   }
   for (i=0; i<fd; i++) {
-    if (fwX[i] <= 0) { fwX[i] *= fixX; } else { fwX[i] /= fixX; }
-    if (fwY[i] <= 0) { fwY[i] *= fixY; } else { fwY[i] /= fixY; }
-    if (fwZ[i] <= 0) { fwZ[i] *= fixZ; } else { fwZ[i] /= fixZ; }
+    if (fw[i] <= 0) { fw[i] *= fix; } else { fw[i] /= fix; }
   }
   return;
 }
 
-void
-_gageFwSet(gageContext *ctx, unsigned int sidx, double sfrac) {
+/*
+** sets the filter weights ctx->fw (and its float copy ctx->fwf, if
+** allocated), but only along the axes for which
+** fchange[axis] is non-zero: for probes that are coherent (as with
+** probing along scanlines of a grid, or along a path that is nearly
+** axis-aligned), the fractional position along the other axes hasn't
+** changed, so their weights can be re-used.  Everything done here is
+** per-axis, so re-using weights doesn't change their values.
+*/
+static void
+_gageFwSet(gageContext *ctx, unsigned int sidx, double sfrac,
+           const int fchange[3]) {
   char me[]="_gageFwSet";
   int kidx;
-  unsigned int fd;
+  unsigned int fd, axi;
 
   fd = 2*ctx->radius;
   for (kidx=gageKernelUnknown+1; kidx<gageKernelLast; kidx++) {
     if (!ctx->needK[kidx] || kidx==gageKernelStack) {
       continue;
     }
-    /* we evaluate weights for all three axes with one call */
-    ctx->ksp[kidx]->kernel->evalN_d(ctx->fw + fd*3*kidx, ctx->fsl,
-                                    fd*3, ctx->ksp[kidx]->parm);
+    if (fchange[0] && fchange[1] && fchange[2]) {
+      /* we evaluate weights for all three axes with one call */
+      ctx->ksp[kidx]->kernel->evalN_d(ctx->fw + fd*3*kidx, ctx->fsl,
+                                      fd*3, ctx->ksp[kidx]->parm);
+    } else {
+      for (axi=0; axi<3; axi++) {
+        if (fchange[axi]) {
+          ctx->ksp[kidx]->kernel->evalN_d(ctx->fw + fd*(axi + 3*kidx),
+                                          ctx->fsl + fd*axi,
+                                          fd, ctx->ksp[kidx]->parm);
+        }
+      }
+    }
   }
 
   if (ctx->verbose > 2) {
@@ -165,15 +168,20 @@ _gageFwSet(gageContext *ctx, unsigned int sidx, double sfrac) {
       if (!ctx->needK[kidx] || kidx==gageKernelStack) {
         continue;
       }
-      switch (kidx) {
-      case gageKernel00:
-      case gageKernel10:
-      case gageKernel20:
-        _gageFwValueRenormalize(ctx, kidx);
-        break;
-      default:
-        _gageFwDerivRenormalize(ctx, kidx);
-        break;
+      for (axi=0; axi<3; axi++) {
+        if (!fchange[axi]) {
+          continue;
+        }
+        switch (kidx) {
+        case gageKernel00:
+        case gageKernel10:
+        case gageKernel20:
+          _gageFwValueRenormalize(ctx, kidx, axi);
+          break;
+        default:
+          _gageFwDerivRenormalize(ctx, kidx, axi);
+          break;
+        }
       }
     }
     if (ctx->verbose > 2) {
@@ -184,7 +192,7 @@ _gageFwSet(gageContext *ctx, unsigned int sidx, double sfrac) {
 
   if (ctx->parm.stackUse && ctx->parm.stackNormalizeDeriv) {
     unsigned int jj;
-    double scl, norm, *fwX, *fwY, *fwZ;
+    double scl, norm, *fwA;
 
     scl = AIR_AFFINE(0.0, sfrac, 1.0,
                      ctx->stackPos[sidx],
@@ -203,24 +211,39 @@ _gageFwSet(gageContext *ctx, unsigned int sidx, double sfrac) {
     /* really simple; no lindeberg normalization, possible bias */
     norm = scl + ctx->parm.stackNormalizeDerivBias;
 
-    fd = 2*ctx->radius;
-    kidx = gageKernel11;
-    fwX = ctx->fw + 0 + fd*(0 + 3*kidx);
-    fwY = ctx->fw + 0 + fd*(1 + 3*kidx);
-    fwZ = ctx->fw + 0 + fd*(2 + 3*kidx);
-    for (jj=0; jj<fd; jj++) {
-      fwX[jj] *= norm;
-      fwY[jj] *= norm;
-      fwZ[jj] *= norm;
+    /* (with stackNormalizeDeriv, any change in scale position has
+       the caller set fchange[] on all axes) */
+    for (axi=0; axi<3; axi++) {
+      if (!fchange[axi]) {
+        continue;
+      }
+      fwA = ctx->fw + 0 + fd*(axi + 3*gageKernel11);
+      for (jj=0; jj<fd; jj++) {
+        fwA[jj] *= norm;
+      }
+      fwA = ctx->fw + 0 + fd*(axi + 3*gageKernel22);
+      for (jj=0; jj<fd; jj++) {
+        fwA[jj] *= norm*norm;
+      }
     }
-    kidx = gageKernel22;
-    fwX = ctx->fw + 0 + fd*(0 + 3*kidx);
-    fwY = ctx->fw + 0 + fd*(1 + 3*kidx);
-    fwZ = ctx->fw + 0 + fd*(2 + 3*kidx);
-    for (jj=0; jj<fd; jj++) {
-      fwX[jj] *= norm*norm;
-      fwY[jj] *= norm*norm;
-      fwZ[jj] *= norm*norm;
+  }
+
+  if (ctx->fwf) {
+    /* with parm.singlePrecision: update the float copy of the weights */
+    unsigned int jj, off;
+    for (kidx=gageKernelUnknown+1; kidx<gageKernelLast; kidx++) {
+      if (!ctx->needK[kidx] || kidx==gageKernelStack) {
+        continue;
+      }
+      for (axi=0; axi<3; axi++) {
+        if (!fchange[axi]) {
+          continue;
+        }
+        off = fd*(axi + 3*kidx);
+        for (jj=0; jj<fd; jj++) {
+          ctx->fwf[off + jj] = AIR_CAST(float, ctx->fw[off + jj]);
+        }
+      }
     }
   }
 
@@ -248,7 +271,8 @@ _gageLocationSet(gageContext *ctx,
   char me[]="_gageProbeLocationSet";
   unsigned int top[3],  /* "top" x, y, z: highest valid index in volume */
     idx[4];
-  int sdiff;      /* computed integral positions in volume */
+  int sdiff,      /* computed integral positions in volume */
+    fchange[3];   /* per-axis: whether filter weights need updating */
   double frac[4], min, max[3];
 
   /* **** bounds checking **** */
@@ -350,21 +374,37 @@ _gageLocationSet(gageContext *ctx,
   }
 
   /* **** compute *spatial* fsl and fw ****
-     these have to be reconsidered if anything changes about the
-     fractional spatial position, or (if no fractional spatial change),
+     these have to be reconsidered (per-axis) if anything changes about
+     the fractional spatial position, or (if no fractional spatial change),
      movement along scale AND using normalization based on scale */
-  if ( ctx->point.frac[0] != frac[0]
-       || ctx->point.frac[1] != frac[1]
-       || ctx->point.frac[2] != frac[2]
-       || (ctx->parm.stackUse && sdiff && ctx->parm.stackNormalizeDeriv)) {
+  if (ctx->parm.stackUse && sdiff && ctx->parm.stackNormalizeDeriv) {
+    ELL_3V_SET(fchange, AIR_TRUE, AIR_TRUE, AIR_TRUE);
+  } else {
+    ELL_3V_SET(fchange,
+               ctx->point.frac[0] != frac[0],
+               ctx->point.frac[1] != frac[1],
+               ctx->point.frac[2] != frac[2]);
+  }
+  if (fchange[0] || fchange[1] || fchange[2]) {
+    unsigned int pvlIdx;
+    int needFw;
     /* We don't yet record the scale position in ctx->point because
        that's done below while setting stackFsl and stackFw. So, have
        to pass stack pos info to _gageFwSet() */
     ELL_3V_COPY(ctx->point.frac, frac);
-    /* these may take some time (especially if using renormalization),
-       hence the conditional above */
-    _gageFslSet(ctx);
-    _gageFwSet(ctx, idx[3], frac[3]);
+    /* the filter weights aren't needed if all pervolumes interpolate
+       pre-computed derivatives instead (see deriv.c); if that changes,
+       gageUpdate() resets ctx->point, which forces new weights */
+    needFw = AIR_FALSE;
+    for (pvlIdx=0; pvlIdx<ctx->pvlNum; pvlIdx++) {
+      needFw |= !ctx->pvl[pvlIdx]->nderiv;
+    }
+    if (needFw) {
+      /* these may take some time (especially if using renormalization),
+         hence the conditional above */
+      _gageFslSet(ctx);
+      _gageFwSet(ctx, idx[3], frac[3], fchange);
+    }
   }
 
   /* **** compute *stack* fsl and fw ****  */
@@ -132,6 +132,7 @@ enum {
   gageParmOrientationFromSpacing,  /* int */
   gageParmGenerateErrStr,          /* int */
   gageParmTwoDimZeroZ,             /* int */
+  gageParmSinglePrecision,         /* int */
   gageParmLast
 };
 
@@ -177,9 +178,10 @@ enum {
   gagePvlFlagVolume,     /*  1: got a new volume */
   gagePvlFlagQuery,      /*  2: what do you really care about */
   gagePvlFlagNeedD,      /*  3: derivatives required for query */
+  gagePvlFlagDeriv,      /*  4: pre-computed derivatives need (re-)doing */
   gagePvlFlagLast
 };
-#define GAGE_PVL_FLAG_MAX    3
+#define GAGE_PVL_FLAG_MAX    4
 
 
 /*
@@ -382,6 +384,29 @@ enum {
 
 struct gageKind_t;       /* dumb forward declaraction, ignore */
 struct gagePerVolume_t;  /* dumb forward declaraction, ignore */
+struct gageStackLazy_t;  /* dumb forward declaraction, ignore */
+struct _gagePoolThreadArg_t; /* dumb forward declaraction, ignore */
+
+/*
+******** gageStore* enum
+**
+** the different ways that the values of a volume (typically a blurring in
+** a scale-space stack) can be stored, trading precision for memory.  The
+** values are converted back to double in gageIv3Fill().  The quantized
+** stores use nrrdQuantize(), so the per-volume value range is in the
+** nrrd's oldMin and oldMax, and the values gage sees are the same as from
+** nrrdUnquantize().
+*/
+enum {
+  gageStoreUnknown,         /* 0: nobody knows */
+  gageStoreFull,            /* 1: values used as is, in whatever type */
+  gageStoreHalf,            /* 2: IEEE 754 half-precision (16-bit) floats,
+                               held in unsigned shorts */
+  gageStoreQuant16,         /* 3: 16-bit quantized (unsigned short) */
+  gageStoreQuant8,          /* 4: 8-bit quantized (unsigned char) */
+  gageStoreLast
+};
+#define GAGE_STORE_MAX         4
 
 /*
 ******** gageItemPackPart* enum
@@ -552,6 +577,15 @@ typedef struct gageParm_t {
                                  correctly handling it ultimately falls to the
                                  "answer" functions of the various
                                  gageKinds */
+  int singlePrecision;        /* if non-zero, the value caches and filter
+                                 weights of scalar volumes are float instead
+                                 of double, and so is the filtering that
+                                 produces the value, gradient, and hessian.
+                                 The answers are still stored (and computed
+                                 from the filtered results) in double.  Not
+                                 used with stackUse, or by kinds other than
+                                 gageKindScl, for which filtering is always
+                                 in double */
 } gageParm;
 
 /*
@@ -752,13 +786,16 @@ typedef struct gageContext_t {
      fd x 3 x GAGE_KERNEL_MAX+1 (fast-to-slow) array */
   double *fw;
 
+  /* with parm.singlePrecision: a float copy of fw (same layout), used by
+     the pervolumes with float value caches.  Otherwise NULL */
+  float *fwf;
+
   /* offsets to other fd^3 samples needed to fill 3D intermediate
      value cache. Allocated size is dependent on kernels, values
-     inside are dependent on the dimensions of the volume. It may be
-     more correct to be using size_t instead of uint, but the X and Y
-     dimensions of the volume would have to be super-outrageous for
-     that to be a problem */
-  unsigned int *off;
+     inside are dependent on the dimensions of the volume. These are
+     size_t (as is all the index arithmetic in gageIv3Fill) so that
+     volumes with more than 2^32 samples (or values) can be probed */
+  size_t *off;
 
   /* last probe location */
   gagePoint point;
@@ -803,6 +840,38 @@ typedef struct gagePerVolume_t {
                                  length valLen) always slowest.  However, use
                                  of iv2 and iv1 is entirely up the kind's
                                  filter method. */
+  float *iv3f, *iv2f, *iv1f;  /* with ctx->parm.singlePrecision (and not
+                                 stackUse), for scalar volumes: float
+                                 versions of the caches above, which are
+                                 then NULL.  Otherwise NULL */
+  const Nrrd *nbrick;         /* if non-NULL, a bricked copy of nin (from
+                                 gageBrickMake()), from which gageIv3Fill()
+                                 gets values instead of from nin */
+  unsigned int brickShift;    /* bricks in nbrick are 2^brickShift samples
+                                 on edge */
+  int derivPrecompute;        /* if non-zero, gageUpdate() pre-computes
+                                 the needed derivatives of nin into nderiv
+                                 (see gagePerVolumeDerivPrecomputeSet()) */
+  Nrrd *nderiv;               /* if non-NULL, the value and derivatives of
+                                 nin at every sample, which probing
+                                 interpolates instead of filtering nin */
+  int nderivOwn;              /* non-zero if nderiv was allocated for this
+                                 pvl, rather than shared by the pvl it was
+                                 copied from */
+  int store;                  /* from the gageStore* enum: how the values
+                                 are stored in nin (or nbrick, or the bricks
+                                 of lazy) */
+  double storeMin, storeStep; /* with quantized stores, the value of the
+                                 stored 0, and the step between the values
+                                 of successive stored integers */
+  struct gageStackLazy_t *lazy; /* if non-NULL, the values are from
+                                 blurring number lazyIdx of this lazily
+                                 computed stack (see gageStackLazyNew()),
+                                 rather than from nin (which is the volume
+                                 being blurred) */
+  unsigned int lazyIdx;       /* which blurring of lazy this is */
+  unsigned char *lazySeen;    /* per brick of lazy: whether this pvl has
+                                 already seen that the brick is computed */
   double (*lup)(const void *ptr, size_t I);
                               /* nrrd{F,D}Lookup[] element, according to
                                  nin->type and double */
@@ -946,8 +1015,100 @@ typedef struct {
                             doing spatial as opposed to frequency-space
                             blurring), the diffusion is done iteratively, with
                             steps in diffusion time of goodSigmaMax^2 */
+  unsigned int threadNum; /* # threads to blur with: scales are blurred in
+                            parallel with FFT-based blurring (each thread
+                            needing 16 bytes per voxel), and each
+                            spatial blurring is split into slabs. The
+                            results don't depend on this */
 } gageStackBlurParm;
 
+/*
+******** gageStackLazy struct
+**
+** A scale-space stack that is computed lazily: each blurring is bricked
+** (as by gageBrickMake()), and its bricks are allocated and blurred only
+** when gageIv3Fill() first needs them, so a stack that is only probed in
+** some places only takes the memory for those places.  Made by
+** gageStackLazyNew(), and used via the pervolumes made by
+** gageStackLazyPerVolumeNew().  It can be shared by the pervolumes of
+** contexts copied with gageContextCopy() (as in a gageContextPool); the
+** bricks are computed in whichever thread first needs them.
+**
+** The blurring is by separable convolution with the kernel, boundary,
+** renormalization, and sigmas of a gageStackBlurParm, with the same
+** kernel weights as the spatial-domain blurring of gageStackBlur().  When
+** gageStackBlur() iterates (with nrrdKernelDiscreteGaussian), the kernel
+** weights of the iterations are here convolved into one set of weights,
+** which gives the same blurring (up to floating point error), except near
+** the boundary, when the boundary is neither wrap nor mirror.
+*/
+typedef struct gageStackLazy_t {
+  const Nrrd *nin;          /* volume being blurred (not owned) */
+  const gageKind *kind;     /* what kind of volume nin is */
+  unsigned int num,         /* number of blurrings */
+    brickShift,             /* bricks are 2^brickShift samples on edge */
+    size[3],                /* volume size along each spatial axis */
+    bnum[3];                /* number of bricks along each spatial axis */
+  int store,                /* from the gageStore* enum: how the blurred
+                               values are stored (gageStoreFull is the
+                               type of nin) */
+    type,                   /* the nrrd type that this store uses */
+    boundary;               /* from the nrrdBoundary* enum */
+  double padValue,          /* value for nrrdBoundaryPad */
+    range[2],               /* for quantized stores, the range of values
+                               that is quantized: that of nin (and of
+                               padValue, with nrrdBoundaryPad), which
+                               contains that of the blurrings when the
+                               kernel is non-negative */
+    storeMin, storeStep;    /* for quantized stores, as in gagePerVolume */
+  int *wlo;                 /* wlo[bi]: offset of first kernel weight of
+                               blurring bi */
+  unsigned int *wlen;       /* wlen[bi]: number of weights of blurring bi */
+  double **weight,          /* weight[bi][wi]: weight of the sample at
+                               offset wlo[bi] + wi, along any blurred axis */
+    *integral;              /* integral[bi]: the kernel integral, for
+                               nrrdBoundaryWeight */
+  int oneDim;               /* only blur along the first spatial axis */
+  void ***brick;            /* brick[bi][bidx]: the data for brick bidx of
+                               blurring bi, or NULL if not yet computed */
+  size_t brickMade;         /* how many bricks have been computed */
+  airThreadMutex *mutex;    /* controls access to brick and brickMade */
+} gageStackLazy;
+
+/*
+******** gageContextPool struct
+**
+** A set of contexts for probing with multiple threads at once, as done by
+** gageProbeList and gageProbeGrid. The first context is the one the pool
+** was made from (and is not owned by the pool); the others are copies of
+** it made by gageContextCopy, which share the volume data but have their
+** own value caches, filter weights, and answers.  The threads that probe
+** with tctx[1] through tctx[threadNum-1] are started by gageContextPoolNew
+** and wait between calls, so that many small calls (as by vprobe, one per
+** slice) don't each pay for starting and joining threads.
+*/
+typedef struct {
+  unsigned int threadNum;  /* number of threads, and of contexts in tctx */
+  gageContext **tctx;      /* tctx[0] is the context given to
+                              gageContextPoolNew, tctx[1] through
+                              tctx[threadNum-1] are copies of it */
+  /* --------- internal ----------- */
+  struct _gagePoolThreadArg_t *arg; /* per-thread state */
+  unsigned int *pvlIdx,    /* pvlIdx[ai]: which pvl answer ai comes from */
+    ansAlloc;              /* room in pvlIdx and per-thread state for
+                              this many answers */
+  airThread **thread;      /* thread[1] through thread[threadNum-1], or
+                              NULL if not using threads */
+  unsigned int threadStarted; /* how many threads have been started */
+  airThreadMutex *mutex;   /* controls all of the following, and is
+                              used to hand out work within a call */
+  airThreadCond *workCond, /* signaled when there is a new call */
+    *doneCond;             /* signaled when the last thread is done */
+  unsigned int generation, /* incremented for each call */
+    busyNum;               /* how many threads are still working */
+  int finished;            /* threads should quit */
+} gageContextPool;
+
 /*
 ******** gageOptimSigContext struct
 **
@@ -997,6 +1158,10 @@ typedef struct {
                               scale (in the scale-interpolated image) */
     allMeasr;              /* how to summarize errors across all scales */
   double convEps;          /* convergence threshold */
+  /* this is set with gageOptimSigContextThreadNumSet */
+  unsigned int threadNum;  /* how many threads to use for measuring the
+                              errors at the trueImgNum scales; 1 by
+                              default */
 
   /* INTERNAL ------------------------- */
   /* NOTE: all internal computations are parameterized by a tau-like
@@ -1014,8 +1179,16 @@ typedef struct {
     *kern, *ktmp1, *ktmp2, /* allocated for length sx to store a high-quality
                               nrrdKernelDiscreteGaussian evaluation, or
                               buffers related to that */
-    kone[1];               /* stores 1.0 */
+    kone[1],               /* stores 1.0 */
+    *ktrue,                /* trueImgNum-by-sx array of the 1-D kernels
+                              for the correct blurrings at the trueImgNum
+                              scales, which never change, so they are
+                              computed once in gageOptimSigContextNew */
+    *tbuff;                /* for threads after the first, their own
+                              versions of ninterp and ndiff data */
   gageContext *gctx;       /* context around pvlBase, pvlSS, and nsampleImg */
+  gageContextPool *pool;   /* threadNum contexts made from gctx, for
+                              measuring errors at many scales at once */
   /* buffers for kernel evaluation */
   /* except for pvlBase, these are allocated for sampleNumMax */
   gagePerVolume *pvlBase,  /* the base pvl for getting answers */
@@ -1050,6 +1223,7 @@ GAGE_EXPORT double gageDefStackNormalizeDerivBias;
 GAGE_EXPORT int gageDefOrientationFromSpacing;
 GAGE_EXPORT int gageDefGenerateErrStr;
 GAGE_EXPORT int gageDefTwoDimZeroZ;
+GAGE_EXPORT int gageDefSinglePrecision;
 
 /* miscGage.c */
 GAGE_EXPORT const int gagePresent;
@@ -1155,6 +1329,8 @@ GAGE_EXPORT gageOptimSigContext *
                          double cutoff);
 GAGE_EXPORT gageOptimSigContext *gageOptimSigContextNix(gageOptimSigContext
                                                         *oscx);
+GAGE_EXPORT int gageOptimSigContextThreadNumSet(gageOptimSigContext *oscx,
+                                                unsigned int threadNum);
 GAGE_EXPORT int gageOptimSigCalculate(gageOptimSigContext *oscx,
                                       /* output */ double *sigma,
                                       unsigned int sigmaNum,
@@ -1201,6 +1377,22 @@ GAGE_EXPORT int gageStackProbeSpace(gageContext *ctx,
                                     double x, double y, double z, double s,
                                     int indexSpace, int clamp);
 
+/* stackStore.c */
+GAGE_EXPORT const airEnum *const gageStore;
+GAGE_EXPORT int gageStoreMake(Nrrd *nout, const Nrrd *nin, int store);
+GAGE_EXPORT int gagePerVolumeStoreSet(gagePerVolume *pvl, int store);
+
+/* stackLazy.c */
+GAGE_EXPORT gageStackLazy *gageStackLazyNew(const Nrrd *nin,
+                                            const gageKind *kind,
+                                            const gageStackBlurParm *sbp,
+                                            unsigned int brickShift,
+                                            int store);
+GAGE_EXPORT gageStackLazy *gageStackLazyNix(gageStackLazy *lazy);
+GAGE_EXPORT int gageStackLazyPerVolumeNew(gageContext *ctx,
+                                          gagePerVolume **pvlStack,
+                                          gageStackLazy *lazy);
+
 /* stackBlur.c */
 GAGE_EXPORT const airEnum *const gageSigmaSampling;
 GAGE_EXPORT gageStackBlurParm *gageStackBlurParmNew(void);
@@ -1238,6 +1430,8 @@ GAGE_EXPORT int gageStackBlurParmNeedSpatialBlurSet(gageStackBlurParm *sbp,
                                                     int sblur);
 GAGE_EXPORT int gageStackBlurParmVerboseSet(gageStackBlurParm *sbp,
                                             int verbose);
+GAGE_EXPORT int gageStackBlurParmThreadNumSet(gageStackBlurParm *sbp,
+                                             unsigned int threadNum);
 GAGE_EXPORT int gageStackBlurParmOneDimSet(gageStackBlurParm *sbp,
                                            int oneDim);
 GAGE_EXPORT int gageStackBlurParmCheck(const gageStackBlurParm *sbp);
@@ -1252,6 +1446,9 @@ GAGE_EXPORT int gageStackBlurParmSprint(char str[AIR_STRLEN_LARGE],
                                         char *extraParm);
 GAGE_EXPORT int gageStackBlur(Nrrd *const nblur[], gageStackBlurParm *sbp,
                               const Nrrd *nin, const gageKind *kind);
+GAGE_EXPORT int gageStackBlurStream(gageStackBlurParm *sbp,
+                                    const char *format, NrrdEncoding *enc,
+                                    const Nrrd *nin, const gageKind *kind);
 GAGE_EXPORT int gageStackBlurCheck(const Nrrd *const nblur[],
                                    gageStackBlurParm *sbp,
                                    const Nrrd *nin, const gageKind *kind);
@@ -1280,6 +1477,20 @@ GAGE_EXPORT void gageKernelReset(gageContext *ctx);
 GAGE_EXPORT int gageProbe(gageContext *ctx, double xi, double yi, double zi);
 GAGE_EXPORT int gageProbeSpace(gageContext *ctx, double x, double y, double z,
                                int indexSpace, int clamp);
+GAGE_EXPORT int gageProbeBatch(gageContext *ctx, double *const *ans,
+                               int *errNum, size_t *failNum,
+                               const gagePerVolume *const *pvl,
+                               const int *item, unsigned int ansNum,
+                               const double *xx, const double *yy,
+                               const double *zz, const double *ss,
+                               size_t posNum, int indexSpace, int clamp);
+GAGE_EXPORT int gageProbeScanline(gageContext *ctx, double *const *ans,
+                                  int *errNum, size_t *failNum,
+                                  const gagePerVolume *const *pvl,
+                                  const int *item, unsigned int ansNum,
+                                  double xi, double yi, double zi,
+                                  unsigned int axis, double step,
+                                  size_t posNum, int clamp);
 
 /* update.c */
 GAGE_EXPORT int gageUpdate(gageContext *ctx);
@@ -1288,6 +1499,34 @@ GAGE_EXPORT int gageUpdate(gageContext *ctx);
 GAGE_EXPORT int gageStructureTensor(Nrrd *nout, const Nrrd *nin,
                                     int dScale, int iScale, int dsmp);
 
+/* brick.c */
+GAGE_EXPORT int gageBrickMake(Nrrd *nout, const Nrrd *nin,
+                              const gageKind *kind, unsigned int brickShift);
+GAGE_EXPORT int gagePerVolumeBrickSet(gagePerVolume *pvl,
+                                      const Nrrd *nbrick);
+
+/* deriv.c */
+GAGE_EXPORT int gagePerVolumeDerivPrecomputeSet(gagePerVolume *pvl,
+                                                int precompute);
+
+/* pool.c */
+GAGE_EXPORT gageContextPool *gageContextPoolNew(gageContext *ctx,
+                                                unsigned int threadNum);
+GAGE_EXPORT gageContextPool *gageContextPoolNix(gageContextPool *pool);
+GAGE_EXPORT int gageProbeList(gageContextPool *pool, Nrrd *const *nout,
+                              size_t *failNum,
+                              const gagePerVolume *const *pvl,
+                              const int *item, unsigned int ansNum,
+                              int typeOut, const Nrrd *npos,
+                              int indexSpace, int clamp);
+GAGE_EXPORT int gageProbeGrid(gageContextPool *pool, Nrrd *const *nout,
+                              size_t *failNum,
+                              const gagePerVolume *const *pvl,
+                              const int *item, unsigned int ansNum,
+                              int typeOut, unsigned int gridDim,
+                              const size_t *gridSize, const double *orig,
+                              const double *edge, int indexSpace, int clamp);
+
 /* deconvolve.c */
 GAGE_EXPORT int gageDeconvolve(Nrrd *nout, double *lastDiffP,
                                const Nrrd *nin, const gageKind *kind,
@@ -1295,6 +1534,11 @@ GAGE_EXPORT int gageDeconvolve(Nrrd *nout, double *lastDiffP,
                                unsigned int maxIter, int saveAnyway,
                                double step, double epsilon, int verbose);
 GAGE_EXPORT int gageDeconvolveSeparableKnown(const NrrdKernelSpec *ksp);
+GAGE_EXPORT int gageDeconvolveSeparableThreaded(Nrrd *nout, const Nrrd *nin,
+                                                const gageKind *kind,
+                                                const NrrdKernelSpec *ksp,
+                                                int typeOut,
+                                                unsigned int threadNum);
 GAGE_EXPORT int gageDeconvolveSeparable(Nrrd *nout, const Nrrd *nin,
                                         const gageKind *kind,
                                         const NrrdKernelSpec *ksp,
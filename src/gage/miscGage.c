@@ -123,6 +123,7 @@ gageParmReset(gageParm *parm) {
     parm->orientationFromSpacing = gageDefOrientationFromSpacing;
     parm->generateErrStr = gageDefGenerateErrStr;
     parm->twoDimZeroZ = gageDefTwoDimZeroZ;
+    parm->singlePrecision = gageDefSinglePrecision;
   }
   return;
 }
@@ -304,6 +304,61 @@ _SigOfRho(double rho) {
   return exp(rho)-1;
 }
 
+static void
+_kernset(double **kzP, double **kyP, double **kxP,
+         gageOptimSigContext *oscx,
+         double rho) {
+  NrrdKernel *dg;
+  double sig, kparm[NRRD_KERNEL_PARMS_NUM],
+    *kloc, *kern, *ktmp1, *ktmp2;
+  unsigned int ki, kj, kk, sx;
+
+  kern = oscx->kern;
+  kloc = oscx->kloc;
+  ktmp1 = oscx->ktmp1;
+  ktmp2 = oscx->ktmp2;
+  sx = oscx->sx;
+  sig = _SigOfRho(rho);
+  dg = nrrdKernelDiscreteGaussian;
+  kparm[1] = oscx->cutoff;
+  if (sig < GOOD_SIGMA_MAX) {
+    /* for small sigma, can evaluate directly into kern */
+    kparm[0] = sig;
+    dg->evalN_d(kern, kloc, sx, kparm);
+  } else {
+    double timeleft, tdelta;
+    unsigned int rx;
+    rx = (sx + 1)/2 - 1;
+    /* we have to iteratively blur */
+    kparm[0] = GOOD_SIGMA_MAX;
+    dg->evalN_d(kern, kloc, sx, kparm);
+    timeleft = sig*sig - GOOD_SIGMA_MAX*GOOD_SIGMA_MAX;
+    do {
+      tdelta = AIR_MIN( GOOD_SIGMA_MAX*GOOD_SIGMA_MAX, timeleft );
+      kparm[0] = sqrt(tdelta);
+      dg->evalN_d(ktmp1, kloc, sx, kparm);
+      for (ki=0; ki<sx; ki++) {
+        double csum = 0.0;
+        for (kj=0; kj<sx; kj++) {
+          kk = ki - kj + rx;
+          if (kk < sx) {
+            csum += kern[kk]*ktmp1[kj];
+          }
+        }
+        ktmp2[ki] = csum;
+      }
+      for (ki=0; ki<sx; ki++) {
+        kern[ki] = ktmp2[ki];
+      }
+      timeleft -= tdelta;
+    } while (timeleft);
+  }
+  *kzP = oscx->dim >= 3 ? kern : oscx->kone;
+  *kyP = oscx->dim >= 2 ? kern : oscx->kone;
+  *kxP = kern;
+  return;
+}
+
 
 /*
 ** allocates context, with error checking
@@ -356,6 +411,7 @@ gageOptimSigContext *gageOptimSigContextNew(unsigned int dim,
   oscx->imgMeasr = nrrdMeasureUnknown;
   oscx->allMeasr = nrrdMeasureUnknown;
   oscx->convEps = AIR_NAN;
+  oscx->threadNum = 1;
 
   /* allocate internal buffers based on arguments */
   kparm[0] = oscx->sigmaRange[1];
@@ -431,8 +487,22 @@ gageOptimSigContext *gageOptimSigContextNew(unsigned int dim,
     oscx->kloc[ii] = AIR_CAST(double, ii) - ((oscx->sx + 1)/2 - 1);
   }
   oscx->kone[0] = 1.0;
+  oscx->ktrue = AIR_CALLOC(oscx->trueImgNum*oscx->sx, double);
+  if (!oscx->ktrue) {
+    biffAddf(GAGE, "%s: couldn't allocate true kernels", me);
+    return NULL;
+  }
+  for (ii=0; ii<oscx->trueImgNum; ii++) {
+    double *kz, *ky, *kx;
+    _kernset(&kz, &ky, &kx, oscx,
+             AIR_AFFINE(0, ii, oscx->trueImgNum-1,
+                        oscx->rhoRange[0], oscx->rhoRange[1]));
+    memcpy(oscx->ktrue + oscx->sx*ii, kx, oscx->sx*sizeof(double));
+  }
+  oscx->tbuff = NULL;
 
   oscx->gctx = NULL;
+  oscx->pool = NULL;
   oscx->pvlBase = NULL;
   oscx->pvlSS = AIR_CALLOC(oscx->sampleNumMax, gagePerVolume *);
   oscx->nsampleImg = AIR_CALLOC(oscx->sampleNumMax, Nrrd *);
@@ -480,6 +550,9 @@ gageOptimSigContextNix(gageOptimSigContext *oscx) {
     airFree(oscx->kern);
     airFree(oscx->ktmp1);
     airFree(oscx->ktmp2);
+    airFree(oscx->ktrue);
+    airFree(oscx->tbuff);
+    gageContextPoolNix(oscx->pool);
     gageContextNix(oscx->gctx);
     /* airFree(oscx->pvlSS); needed? */
     for (si=0; si<oscx->sampleNumMax; si++) {
@@ -497,12 +570,43 @@ gageOptimSigContextNix(gageOptimSigContext *oscx) {
   return NULL;
 }
 
+/*
+******** gageOptimSigContextThreadNumSet
+**
+** sets how many threads are used to measure the reconstruction errors
+** at the different scales (each thread has its own copy of the gage
+** context); this takes effect with the next call to
+** gageOptimSigCalculate or one of the gageOptimSigErrorPlot functions
+*/
+int
+gageOptimSigContextThreadNumSet(gageOptimSigContext *oscx,
+                                unsigned int threadNum) {
+  static const char me[]="gageOptimSigContextThreadNumSet";
+
+  if (!oscx) {
+    biffAddf(GAGE, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (!threadNum) {
+    biffAddf(GAGE, "%s: need non-zero threadNum", me);
+    return 1;
+  }
+  oscx->threadNum = threadNum;
+  return 0;
+}
+
+/*
+** probes the scale-space reconstruction at rho into interp, using gctx,
+** which is either oscx->gctx or one of its copies in oscx->pool.
+** Does NOT use biff (so it can be called from any thread); on a probe
+** error, returns non-zero with gctx->errStr and gctx->errNum set
+*/
 static int
-_volInterp(Nrrd *ninterp, double rho, gageOptimSigContext *oscx) {
-  static const char me[]="_volInterp";
-  double *interp, scaleIdx, sigma;
+_volInterp(double *interp, gageContext *gctx, double rho,
+           gageOptimSigContext *oscx) {
+  double scaleIdx, sigma;
   const double *answer;
-  unsigned int xi, yi, zi;
+  unsigned int xi, yi, zi, pi;
   int outside;
 
   /*
@@ -510,23 +614,21 @@ _volInterp(Nrrd *ninterp, double rho, gageOptimSigContext *oscx) {
   gageParmSet(oscx->gctx, gageParmVerbose, 2*debugging);
   */
   sigma = _SigOfRho(rho);
-  scaleIdx = gageStackWtoI(oscx->gctx, sigma, &outside);
+  scaleIdx = gageStackWtoI(gctx, sigma, &outside);
   /* Because of limited numerical precision, _SigOfRho(rhoRange[1])
      can end up "outside" stack, which should really be a bug.
      However, since the use of gage is pretty straight-forward here,
      we're okay with ignoring the "outside" here, and also clamping
      the probe below */
-  answer = gageAnswerPointer(oscx->gctx, oscx->pvlBase, gageSclValue);
-  interp = AIR_CAST(double *, ninterp->data);
+  /* the copy of pvlBase in gctx is at the same index as in oscx->gctx */
+  for (pi=0; oscx->gctx->pvl[pi] != oscx->pvlBase; pi++);
+  answer = gageAnswerPointer(gctx, gctx->pvl[pi], gageSclValue);
   for (zi=0; zi<oscx->sz; zi++) {
     for (yi=0; yi<oscx->sy; yi++) {
       for (xi=0; xi<oscx->sx; xi++) {
-        if (gageStackProbeSpace(oscx->gctx, xi, yi, zi, scaleIdx,
+        if (gageStackProbeSpace(gctx, xi, yi, zi, scaleIdx,
                                 AIR_TRUE /* index space */,
                                 AIR_TRUE /* clamping */)) {
-          biffAddf(GAGE, "%s: probe error at (%u,%u,%u,%.17g): %s (%d)", me,
-                   xi, yi, zi, scaleIdx,
-                   oscx->gctx->errStr, oscx->gctx->errNum);
           return 1;
         }
         interp[xi + oscx->sx*(yi + oscx->sy*zi)] = answer[0];
@@ -546,61 +648,6 @@ _volInterp(Nrrd *ninterp, double rho, gageOptimSigContext *oscx) {
   return 0;
 }
 
-static void
-_kernset(double **kzP, double **kyP, double **kxP,
-         gageOptimSigContext *oscx,
-         double rho) {
-  NrrdKernel *dg;
-  double sig, kparm[NRRD_KERNEL_PARMS_NUM],
-    *kloc, *kern, *ktmp1, *ktmp2;
-  unsigned int ki, kj, kk, sx;
-
-  kern = oscx->kern;
-  kloc = oscx->kloc;
-  ktmp1 = oscx->ktmp1;
-  ktmp2 = oscx->ktmp2;
-  sx = oscx->sx;
-  sig = _SigOfRho(rho);
-  dg = nrrdKernelDiscreteGaussian;
-  kparm[1] = oscx->cutoff;
-  if (sig < GOOD_SIGMA_MAX) {
-    /* for small sigma, can evaluate directly into kern */
-    kparm[0] = sig;
-    dg->evalN_d(kern, kloc, sx, kparm);
-  } else {
-    double timeleft, tdelta;
-    unsigned int rx;
-    rx = (sx + 1)/2 - 1;
-    /* we have to iteratively blur */
-    kparm[0] = GOOD_SIGMA_MAX;
-    dg->evalN_d(kern, kloc, sx, kparm);
-    timeleft = sig*sig - GOOD_SIGMA_MAX*GOOD_SIGMA_MAX;
-    do {
-      tdelta = AIR_MIN( GOOD_SIGMA_MAX*GOOD_SIGMA_MAX, timeleft );
-      kparm[0] = sqrt(tdelta);
-      dg->evalN_d(ktmp1, kloc, sx, kparm);
-      for (ki=0; ki<sx; ki++) {
-        double csum = 0.0;
-        for (kj=0; kj<sx; kj++) {
-          kk = ki - kj + rx;
-          if (kk < sx) {
-            csum += kern[kk]*ktmp1[kj];
-          }
-        }
-        ktmp2[ki] = csum;
-      }
-      for (ki=0; ki<sx; ki++) {
-        kern[ki] = ktmp2[ki];
-      }
-      timeleft -= tdelta;
-    } while (timeleft);
-  }
-  *kzP = oscx->dim >= 3 ? kern : oscx->kone;
-  *kyP = oscx->dim >= 2 ? kern : oscx->kone;
-  *kxP = kern;
-  return;
-}
-
 /*
 ** sets one of the sampleImg, to be used as a sample in scale-space interp
 */
@@ -622,25 +669,45 @@ _sampleSet(gageOptimSigContext *oscx, unsigned int si, double rho) {
       }
     }
   }
-  if (oscx->gctx) {
-    /* the gage stack needs to know new scale pos */
-    oscx->gctx->stackPos[si] = oscx->sampleSigma[si];
-    /* HEY: GLK forgets why this is needed,
-       but remembers it was a tricky bug to find */
-    gagePointReset(&(oscx->gctx->point));
+  if (oscx->pool) {
+    unsigned int ti;
+    for (ti=0; ti<oscx->pool->threadNum; ti++) {
+      gageContext *gctx;
+      gctx = oscx->pool->tctx[ti];
+      /* the gage stack needs to know new scale pos */
+      gctx->stackPos[si] = oscx->sampleSigma[si];
+      /* HEY: GLK forgets why this is needed,
+         but remembers it was a tricky bug to find */
+      gagePointReset(&(gctx->point));
+    }
   }
   return;
 }
 
+/*
+** measures the error of reconstructing at rho, with thread ti (using
+** oscx->pool->tctx[ti]).  ktrue is the 1-D kernel of the correct
+** blurring at rho, if known (from oscx->ktrue); if NULL, it is computed
+** here, with buffers in oscx that aren't thread-safe, so then ti must be
+** 0 and this must be the only thread running.  Does NOT use biff; on a
+** probe error, returns non-zero with the errStr of the thread's context
+*/
 static int
-_errSingle(double *retP, gageOptimSigContext *oscx, double rho) {
-  static const char me[]="_errSingle";
-  double *diff, *kx, *ky, *kz;
-  const double *interp;
-  unsigned int ii, xi, yi, zi;
-
-  if (_volInterp(oscx->ninterp, rho, oscx)) {
-    biffAddf(GAGE, "%s: trouble at rho %.17g\n", me, rho);
+_errCompute(double *retP, gageOptimSigContext *oscx, unsigned int ti,
+            double rho, const double *ktrue) {
+  double *interp, *diff, *kern;
+  const double *kx, *ky, *kz;
+  unsigned int ii, xi, yi, zi, NN;
+
+  if (!ti) {
+    interp = AIR_CAST(double *, oscx->ninterp->data);
+    diff = AIR_CAST(double *, oscx->ndiff->data);
+  } else {
+    NN = oscx->sx*oscx->sy*oscx->sz;
+    interp = oscx->tbuff + 2*NN*(ti-1);
+    diff = interp + NN;
+  }
+  if (_volInterp(interp, oscx->pool->tctx[ti], rho, oscx)) {
     return 1;
   }
   /*
@@ -650,9 +717,17 @@ _errSingle(double *retP, gageOptimSigContext *oscx, double rho) {
     nrrdSave(fname, oscx->ninterp, NULL);
   }
   */
-  interp = AIR_CAST(const double *, oscx->ninterp->data);
-  diff = AIR_CAST(double *, oscx->ndiff->data);
-  _kernset(&kz, &ky, &kx, oscx, rho);
+  if (ktrue) {
+    kz = oscx->dim >= 3 ? ktrue : oscx->kone;
+    ky = oscx->dim >= 2 ? ktrue : oscx->kone;
+    kx = ktrue;
+  } else {
+    double *tz, *ty;
+    _kernset(&tz, &ty, &kern, oscx, rho);
+    kz = tz;
+    ky = ty;
+    kx = kern;
+  }
   ii = 0;
   for (zi=0; zi<oscx->sz; zi++) {
     for (yi=0; yi<oscx->sy; yi++) {
@@ -660,7 +735,9 @@ _errSingle(double *retP, gageOptimSigContext *oscx, double rho) {
         double tru;
         tru = kz[zi]*ky[yi]*kx[xi];
         diff[ii] = interp[ii] - tru;
-        if (debugReconErrArr) {
+        /* only gageOptimSigErrorPlotSliding (serial, and at arbitrary
+           rho, so without ktrue) records these */
+        if (debugReconErrArr && !ktrue) {
           unsigned int idx = airArrayLenIncr(debugReconErrArr, 2);
           debugReconErr[idx + 0] = tru;
           debugReconErr[idx + 1] = interp[ii];
@@ -676,21 +753,142 @@ _errSingle(double *retP, gageOptimSigContext *oscx, double rho) {
   return 0;
 }
 
+static int
+_errSingle(double *retP, gageOptimSigContext *oscx, double rho) {
+  static const char me[]="_errSingle";
+
+  if (_errCompute(retP, oscx, 0, rho, NULL)) {
+    biffAddf(GAGE, "%s: probe error at rho %.17g: %s (%d)", me, rho,
+             oscx->gctx->errStr, oscx->gctx->errNum);
+    return 1;
+  }
+  return 0;
+}
+
+/*
+** _optsigTask, _optsigThreadArg: for measuring, with multiple threads,
+** the errors at the first num of the trueImgNum scales, which are
+** handed out one at a time
+*/
+typedef struct {
+  gageOptimSigContext *oscx;
+  unsigned int num;           /* how many scales to measure error at */
+  airThreadMutex *workMutex;  /* NULL for a single thread */
+  unsigned int workIdx;       /* next scale to hand out */
+} _optsigTask;
+
+typedef struct {
+  _optsigTask *task;
+  unsigned int ti;            /* which thread (and context in pool) */
+  int failed;                 /* a probe failed */
+  unsigned int failIdx;       /* which scale the failure was at */
+} _optsigThreadArg;
+
+static void *
+_optsigWorker(void *_arg) {
+  _optsigThreadArg *arg;
+  _optsigTask *task;
+  gageOptimSigContext *oscx;
+  double *err;
+  unsigned int ii;
+
+  arg = AIR_CAST(_optsigThreadArg *, _arg);
+  task = arg->task;
+  oscx = task->oscx;
+  err = AIR_CAST(double *, oscx->nerr->data);
+  while (!arg->failed) {
+    if (task->workMutex) {
+      airThreadMutexLock(task->workMutex);
+    }
+    ii = task->workIdx;
+    if (ii < task->num) {
+      task->workIdx++;
+    }
+    if (task->workMutex) {
+      airThreadMutexUnlock(task->workMutex);
+    }
+    if (ii == task->num) {
+      /* no more work */
+      break;
+    }
+    if (_errCompute(err + ii, oscx, arg->ti,
+                    AIR_AFFINE(0, ii, oscx->trueImgNum-1,
+                               oscx->rhoRange[0], oscx->rhoRange[1]),
+                    oscx->ktrue + oscx->sx*ii)) {
+      arg->failed = AIR_TRUE;
+      arg->failIdx = ii;
+    }
+  }
+  return _arg;
+}
+
+/*
+** measures (into oscx->nerr) the errors at the first num of the
+** trueImgNum scales, with all the threads of oscx->pool
+*/
+static int
+_errMeasure(gageOptimSigContext *oscx, unsigned int num) {
+  static const char me[]="_errMeasure";
+  _optsigTask task;
+  _optsigThreadArg *arg;
+  unsigned int ti, threadNum;
+  airArray *mop;
+
+  threadNum = oscx->pool->threadNum;
+  mop = airMopNew();
+  arg = AIR_CALLOC(threadNum, _optsigThreadArg);
+  airMopAdd(mop, arg, airFree, airMopAlways);
+  if (!arg) {
+    biffAddf(GAGE, "%s: couldn't allocate per-thread info", me);
+    airMopError(mop); return 1;
+  }
+  task.oscx = oscx;
+  task.num = num;
+  task.workIdx = 0;
+  if (1 < threadNum) {
+    if (!( task.workMutex = airThreadMutexNew() )) {
+      biffAddf(GAGE, "%s: couldn't create work mutex", me);
+      airMopError(mop); return 1;
+    }
+    airMopAdd(mop, task.workMutex, (airMopper)airThreadMutexNix,
+              airMopAlways);
+    if (!airThreadCapable) {
+      fprintf(stderr, "%s: WARNING: not multi-threaded; will do %u "
+              "\"threads\" serially !!!\n", me, threadNum);
+    }
+  } else {
+    task.workMutex = NULL;
+  }
+  for (ti=0; ti<threadNum; ti++) {
+    arg[ti].task = &task;
+    arg[ti].ti = ti;
+    arg[ti].failed = AIR_FALSE;
+  }
+  if (airThreadRun(_optsigWorker, arg, sizeof(*arg), threadNum)) {
+    biffAddf(GAGE, "%s: couldn't run %u threads", me, threadNum);
+    airMopError(mop); return 1;
+  }
+  for (ti=0; ti<threadNum; ti++) {
+    if (arg[ti].failed) {
+      biffAddf(GAGE, "%s: thread %u: probe error at ii %u: %s (%d)", me, ti,
+               arg[ti].failIdx, oscx->pool->tctx[ti]->errStr,
+               oscx->pool->tctx[ti]->errNum);
+      airMopError(mop); return 1;
+    }
+  }
+  airMopOkay(mop);
+  return 0;
+}
+
 static int
 _errTotal(double *retP, gageOptimSigContext *oscx) {
   static const char me[]="_errTotal";
-  unsigned int ii;
   double *err;
 
   err = AIR_CAST(double *, oscx->nerr->data);
-  for (ii=0; ii<oscx->trueImgNum; ii++) {
-    /* debugii = ii; */
-    if (_errSingle(err + ii, oscx, AIR_AFFINE(0, ii, oscx->trueImgNum-1,
-                                              oscx->rhoRange[0],
-                                              oscx->rhoRange[1]))) {
-      biffAddf(GAGE, "%s: trouble at ii %u", me, ii);
-      return 1;
-    }
+  if (_errMeasure(oscx, oscx->trueImgNum)) {
+    biffAddf(GAGE, "%s: trouble", me);
+    return 1;
   }
   nrrdMeasureLine[oscx->allMeasr](retP, nrrdTypeDouble,
                                   err, nrrdTypeDouble,
@@ -732,13 +930,12 @@ _errTotalLinf(double *retP, gageOptimSigContext *oscx,
   }
   /* NOTE: we don't bother with last "true image": it will always be a
      low error, and not meaningfully associated with a gap */
+  if (_errMeasure(oscx, oscx->trueImgNum-1)) {
+    biffAddf(GAGE, "%s: trouble", me);
+    return 1;
+  }
   for (ii=0; ii<oscx->trueImgNum-1; ii++) {
-    /* debugii = ii; */
     rho = AIR_AFFINE(0, ii, oscx->trueImgNum-1, rr[0], rr[1]);
-    if (_errSingle(err + ii, oscx, rho)) {
-      biffAddf(GAGE, "%s: trouble at ii %u", me, ii);
-      return 1;
-    }
     sig = _SigOfRho(rho);
     pid = gageStackWtoI(oscx->gctx, sig, &outside);
     pi = AIR_CAST(unsigned int, pid);
@@ -783,6 +980,7 @@ _gageSetup(gageOptimSigContext *oscx) {
   double kparm[NRRD_KERNEL_PARMS_NUM];
   int E;
 
+  oscx->pool = gageContextPoolNix(oscx->pool);
   if (oscx->gctx) {
     gageContextNix(oscx->gctx);
   }
@@ -810,10 +1008,23 @@ _gageSetup(gageOptimSigContext *oscx) {
                              oscx->kssSpec->kernel, oscx->kssSpec->parm);
   if (!E) E |= gageQueryItemOn(oscx->gctx, oscx->pvlBase, gageSclValue);
   if (!E) E |= gageUpdate(oscx->gctx);
+  if (!E) E |= !(oscx->pool = gageContextPoolNew(oscx->gctx,
+                                                 oscx->threadNum));
   if (E) {
     biffAddf(GAGE, "%s: problem setting up gage", me);
     return 1;
   }
+  airFree(oscx->tbuff);
+  oscx->tbuff = NULL;
+  if (1 < oscx->threadNum) {
+    oscx->tbuff = AIR_CALLOC(2*oscx->sx*oscx->sy*oscx->sz
+                             *(oscx->threadNum-1), double);
+    if (!oscx->tbuff) {
+      biffAddf(GAGE, "%s: couldn't allocate buffers for %u threads", me,
+               oscx->threadNum);
+      return 1;
+    }
+  }
   return 0;
 }
 
@@ -1141,6 +1352,11 @@ gageOptimSigCalculate(gageOptimSigContext *oscx,
     return 1;
   }
 
+  /* the contexts from a previous call may have fewer stack pervolumes
+     than there are samples now; _gageSetup() will make new ones */
+  oscx->pool = gageContextPoolNix(oscx->pool);
+  oscx->gctx = gageContextNix(oscx->gctx);
+
   /* initialize to uniform samples in rho */
   oscx->sampleNum = sigmaNum;
   fprintf(stderr, "%s: initializing %u samples ... ", me, oscx->sampleNum);
@@ -1203,7 +1419,7 @@ gageOptimSigErrorPlot(gageOptimSigContext *oscx, Nrrd *nout,
                       const NrrdKernelSpec *kssSpec,
                       int imgMeasr) {
   static const char me[]="gageOptimSigErrorPlot";
-  char doneStr[AIR_STRLEN_SMALL];
+  const double *err;
   double *out;
   unsigned int ii;
 
@@ -1237,7 +1453,9 @@ gageOptimSigErrorPlot(gageOptimSigContext *oscx, Nrrd *nout,
   }
   out = AIR_CAST(double *, nout->data);
 
-  /* set up requested samples */
+  /* set up requested samples (in new contexts, as above) */
+  oscx->pool = gageContextPoolNix(oscx->pool);
+  oscx->gctx = gageContextNix(oscx->gctx);
   for (ii=0; ii<oscx->sampleNum; ii++) {
     _sampleSet(oscx, ii, _RhoOfSig(sigma[ii]));
   }
@@ -1245,27 +1463,18 @@ gageOptimSigErrorPlot(gageOptimSigContext *oscx, Nrrd *nout,
     biffAddf(GAGE, "%s: problem setting up gage", me);
     return 1;
   }
-  fprintf(stderr, "%s: plotting ...       ", me); fflush(stderr);
+  fprintf(stderr, "%s: plotting ... ", me); fflush(stderr);
+  if (_errMeasure(oscx, oscx->trueImgNum)) {
+    biffAddf(GAGE, "%s: plotting", me);
+    return 1;
+  }
+  err = AIR_CAST(const double *, oscx->nerr->data);
   for (ii=0; ii<oscx->trueImgNum; ii++) {
-    double rho, err;
-    fprintf(stderr, "%s", airDoneStr(0, ii, oscx->trueImgNum, doneStr));
-    fflush(stderr);
-    rho = AIR_AFFINE(0, ii, oscx->trueImgNum-1,
-                     oscx->rhoRange[0], oscx->rhoRange[1]);
-    out[0 + 2*ii] = rho;
-    /* debugii = ii; */
-    if (_errSingle(&err, oscx, rho)) {
-      biffAddf(GAGE, "%s: plotting %u", me, ii);
-      return 1;
-    }
-    out[1 + 2*ii] = err;
-    /*
-    if (AIR_IN_CL(69,ii,71)) {
-      fprintf(stderr, "!%s: ----- %u : %g\n", me, ii, err);
-    }
-    */
+    out[0 + 2*ii] = AIR_AFFINE(0, ii, oscx->trueImgNum-1,
+                               oscx->rhoRange[0], oscx->rhoRange[1]);
+    out[1 + 2*ii] = err[ii];
   }
-  fprintf(stderr, "%s\n", airDoneStr(0, ii, oscx->trueImgNum, doneStr));
+  fprintf(stderr, "done.\n");
 
   /*
   if (0) {
@@ -0,0 +1,601 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "gage.h"
+#include "privateGage.h"
+
+/*
+** how many list positions are handed to a thread at a time; grids
+** are instead handed out one scanline (along grid axis 0) at a time
+*/
+#define _GAGE_POOL_LIST_CHUNK 512
+
+/*
+** _gagePoolTask
+**
+** everything about a gageProbeList or gageProbeGrid call that is
+** shared between the threads
+*/
+typedef struct {
+  /* where to probe */
+  const double *pos;           /* list: posStride-by-posNum positions */
+  unsigned int posStride,      /* list: 3 or 4 */
+    gridDim;                   /* grid: dimension of grid (0 for list) */
+  const size_t *gridSize;      /* grid: size along each grid axis */
+  double gridOrig[4],          /* grid: (x,y,z,s) of first sample */
+    gridEdge[4*NRRD_DIM_MAX];  /* grid: step along each grid axis */
+  size_t posNum,               /* total number of positions */
+    chunkLen;                  /* positions handed out at a time */
+  int indexSpace, clamp;
+  /* what to learn, and where to put it */
+  unsigned int ansNum;
+  const int *item;
+  Nrrd *const *nout;
+  /* work assignment */
+  airThreadMutex *workMutex;   /* NULL for a single thread */
+  size_t workIdx;              /* next position to hand out */
+} _gagePoolTask;
+
+/*
+** _gagePoolThreadArg
+**
+** per-thread state, kept in the pool between calls; a pointer to this
+** is passed to _gagePoolWorker
+*/
+typedef struct _gagePoolThreadArg_t {
+  gageContextPool *pool;
+  _gagePoolTask *task;         /* the current call's task */
+  gageContext *ctx;            /* this thread's context */
+  const double **ansSrc;       /* this thread's answer pointers, ... */
+  unsigned int *ansLen;        /* ... and answer lengths, both with room
+                                  for pool->ansAlloc answers */
+  size_t failNum;              /* number of failed probes */
+} _gagePoolThreadArg;
+
+static void
+_gagePoolPos(double pos[4], const _gagePoolTask *task, size_t II) {
+  unsigned int gi;
+  size_t coord;
+
+  if (!task->gridDim) {
+    const double *pp;
+    pp = task->pos + task->posStride*II;
+    ELL_3V_COPY(pos, pp);
+    pos[3] = 4 == task->posStride ? pp[3] : AIR_NAN;
+  } else {
+    ELL_4V_COPY(pos, task->gridOrig);
+    for (gi=0; gi<task->gridDim; gi++) {
+      coord = II % task->gridSize[gi];
+      II /= task->gridSize[gi];
+      ELL_4V_SCALE_ADD2(pos, 1, pos, AIR_CAST(double, coord),
+                        task->gridEdge + 4*gi);
+    }
+  }
+  return;
+}
+
+/* does one thread's share of one call's task */
+static void
+_gagePoolWorker(_gagePoolThreadArg *arg) {
+  _gagePoolTask *task;
+  double (*ins)(void *v, size_t I, double d), pos[4];
+  size_t II, lo, hi;
+  unsigned int ai, cc;
+  int failed;
+
+  task = arg->task;
+  while (1) {
+    if (task->workMutex) {
+      airThreadMutexLock(task->workMutex);
+    }
+    lo = task->workIdx;
+    hi = AIR_MIN(lo + task->chunkLen, task->posNum);
+    task->workIdx = hi;
+    if (task->workMutex) {
+      airThreadMutexUnlock(task->workMutex);
+    }
+    if (lo == hi) {
+      /* no more work */
+      break;
+    }
+    for (II=lo; II<hi; II++) {
+      _gagePoolPos(pos, task, II);
+      failed = _gageProbeSpace(arg->ctx, pos[0], pos[1], pos[2],
+                               arg->ctx->parm.stackUse ? pos[3] : AIR_NAN,
+                               task->indexSpace, task->clamp);
+      arg->failNum += !!failed;
+      for (ai=0; ai<task->ansNum; ai++) {
+        ins = nrrdDInsert[task->nout[ai]->type];
+        for (cc=0; cc<arg->ansLen[ai]; cc++) {
+          ins(task->nout[ai]->data, cc + arg->ansLen[ai]*II,
+              failed ? AIR_NAN : arg->ansSrc[ai][cc]);
+        }
+      }
+    }
+  }
+  return;
+}
+
+/*
+** the body of the pool's threads, which (as in pullStart and pullFinish)
+** live from gageContextPoolNew to gageContextPoolNix: each waits on
+** workCond for a new call (a new generation), does its share of it, and
+** signals doneCond if it was the last thread to finish
+*/
+static void *
+_gagePoolThreadBody(void *_arg) {
+  _gagePoolThreadArg *arg;
+  gageContextPool *pool;
+  unsigned int seen;
+
+  arg = AIR_CAST(_gagePoolThreadArg *, _arg);
+  pool = arg->pool;
+  seen = 0;
+  airThreadMutexLock(pool->mutex);
+  while (1) {
+    while (!pool->finished && seen == pool->generation) {
+      airThreadCondWait(pool->workCond, pool->mutex);
+    }
+    if (pool->finished) {
+      break;
+    }
+    seen = pool->generation;
+    airThreadMutexUnlock(pool->mutex);
+    _gagePoolWorker(arg);
+    airThreadMutexLock(pool->mutex);
+    if (!(--pool->busyNum)) {
+      airThreadCondSignal(pool->doneCond);
+    }
+  }
+  airThreadMutexUnlock(pool->mutex);
+  return _arg;
+}
+
+/*
+******** gageContextPoolNew()
+**
+** makes a pool of threadNum contexts for probing with gageProbeList
+** and gageProbeGrid. ctx should be fully set up (with gageUpdate()),
+** and becomes the pool's first context; the others are made with
+** gageContextCopy(), so they share the volume data of ctx.  The pool
+** does not own ctx, and if ctx is changed and re-updated, the pool
+** should be nixed and re-made.  The threadNum-1 threads that probe
+** with the other contexts (the calling thread probes with ctx) are
+** started here, and wait between calls until gageContextPoolNix().
+*/
+gageContextPool * /*Teem: biff if (!ret) */
+gageContextPoolNew(gageContext *ctx, unsigned int threadNum) {
+  static const char me[]="gageContextPoolNew";
+  gageContextPool *pool;
+  unsigned int ti;
+
+  if (!ctx) {
+    biffAddf(GAGE, "%s: got NULL pointer", me);
+    return NULL;
+  }
+  if (!threadNum) {
+    biffAddf(GAGE, "%s: need non-zero threadNum", me);
+    return NULL;
+  }
+  pool = AIR_CALLOC(1, gageContextPool);
+  if (!pool) {
+    biffAddf(GAGE, "%s: couldn't allocate pool", me);
+    return NULL;
+  }
+  pool->tctx = AIR_CALLOC(threadNum, gageContext *);
+  pool->arg = AIR_CALLOC(threadNum, _gagePoolThreadArg);
+  if (!( pool->tctx && pool->arg )) {
+    biffAddf(GAGE, "%s: couldn't allocate %u contexts", me, threadNum);
+    airFree(pool->tctx);
+    airFree(pool->arg);
+    free(pool);
+    return NULL;
+  }
+  pool->threadNum = threadNum;
+  pool->pvlIdx = NULL;
+  pool->ansAlloc = 0;
+  pool->thread = NULL;
+  pool->threadStarted = 0;
+  pool->mutex = NULL;
+  pool->workCond = pool->doneCond = NULL;
+  pool->generation = 0;
+  pool->busyNum = 0;
+  pool->finished = AIR_FALSE;
+  pool->tctx[0] = ctx;
+  for (ti=1; ti<threadNum; ti++) {
+    pool->tctx[ti] = gageContextCopy(ctx);
+    if (!pool->tctx[ti]) {
+      biffAddf(GAGE, "%s: couldn't copy context for thread %u", me, ti);
+      gageContextPoolNix(pool);
+      return NULL;
+    }
+  }
+  for (ti=0; ti<threadNum; ti++) {
+    pool->arg[ti].pool = pool;
+    pool->arg[ti].ctx = pool->tctx[ti];
+  }
+  if (1 == threadNum) {
+    return pool;
+  }
+  if (!airThreadCapable) {
+    fprintf(stderr, "%s: WARNING: not multi-threaded; will do %u "
+            "\"threads\" serially !!!\n", me, threadNum);
+    return pool;
+  }
+  pool->mutex = airThreadMutexNew();
+  pool->workCond = airThreadCondNew();
+  pool->doneCond = airThreadCondNew();
+  pool->thread = AIR_CALLOC(threadNum, airThread *);
+  if (!( pool->mutex && pool->workCond && pool->doneCond && pool->thread )) {
+    biffAddf(GAGE, "%s: couldn't create mutex, conditions, or threads", me);
+    gageContextPoolNix(pool);
+    return NULL;
+  }
+  for (ti=1; ti<threadNum; ti++) {
+    if (!( pool->thread[ti] = airThreadNew() )
+        || airThreadStart(pool->thread[ti], _gagePoolThreadBody,
+                          AIR_CAST(void *, pool->arg + ti))) {
+      biffAddf(GAGE, "%s: couldn't start thread %u", me, ti);
+      gageContextPoolNix(pool);
+      return NULL;
+    }
+    pool->threadStarted = ti;
+  }
+  return pool;
+}
+
+/*
+******** gageContextPoolNix()
+**
+** stops the threads and frees everything created by gageContextPoolNew(),
+** but not the context that was passed to it.
+*/
+gageContextPool *
+gageContextPoolNix(gageContextPool *pool) {
+  unsigned int ti;
+  void *ret;
+
+  if (pool) {
+    if (pool->threadStarted) {
+      airThreadMutexLock(pool->mutex);
+      pool->finished = AIR_TRUE;
+      airThreadCondBroadcast(pool->workCond);
+      airThreadMutexUnlock(pool->mutex);
+      for (ti=1; ti<=pool->threadStarted; ti++) {
+        airThreadJoin(pool->thread[ti], &ret);
+      }
+    }
+    if (pool->thread) {
+      for (ti=1; ti<pool->threadNum; ti++) {
+        if (pool->thread[ti]) {
+          airThreadNix(pool->thread[ti]);
+        }
+      }
+      free(pool->thread);
+    }
+    airThreadMutexNix(pool->mutex);
+    airThreadCondNix(pool->workCond);
+    airThreadCondNix(pool->doneCond);
+    if (pool->arg) {
+      for (ti=0; ti<pool->threadNum; ti++) {
+        airFree(AIR_CAST(void *, pool->arg[ti].ansSrc));
+        airFree(pool->arg[ti].ansLen);
+      }
+      free(pool->arg);
+    }
+    airFree(pool->pvlIdx);
+    if (pool->tctx) {
+      for (ti=1; ti<pool->threadNum; ti++) {
+        gageContextNix(pool->tctx[ti]);
+      }
+      free(pool->tctx);
+    }
+    free(pool);
+  }
+  return NULL;
+}
+
+/*
+** makes sure that pool->pvlIdx, and the answer pointers and lengths of
+** each thread, have room for ansNum answers; they only ever grow
+*/
+static int
+_gagePoolAnsAlloc(gageContextPool *pool, unsigned int ansNum) {
+  static const char me[]="_gagePoolAnsAlloc";
+  unsigned int ti;
+
+  if (ansNum <= pool->ansAlloc) {
+    return 0;
+  }
+  airFree(pool->pvlIdx);
+  pool->pvlIdx = AIR_CALLOC(ansNum, unsigned int);
+  for (ti=0; ti<pool->threadNum; ti++) {
+    airFree(AIR_CAST(void *, pool->arg[ti].ansSrc));
+    airFree(pool->arg[ti].ansLen);
+    pool->arg[ti].ansSrc = AIR_CALLOC(ansNum, const double *);
+    pool->arg[ti].ansLen = AIR_CALLOC(ansNum, unsigned int);
+  }
+  for (ti=0; ti<pool->threadNum; ti++) {
+    if (!( pool->pvlIdx && pool->arg[ti].ansSrc && pool->arg[ti].ansLen )) {
+      biffAddf(GAGE, "%s: couldn't allocate info for %u answers", me,
+               ansNum);
+      /* the buffers are freed, or re-allocated next time */
+      pool->ansAlloc = 0;
+      return 1;
+    }
+  }
+  pool->ansAlloc = ansNum;
+  return 0;
+}
+
+/*
+** _gagePoolProbe
+**
+** common to gageProbeList and gageProbeGrid: learns which pvl each answer
+** comes from, allocates output (outDim axes of sizes outSize, after an
+** initial axis for non-scalar answers), and has the pool's threads do
+** the probing, with the calling thread doing the share of tctx[0].
+*/
+static int
+_gagePoolProbe(gageContextPool *pool, _gagePoolTask *task, size_t *failNum,
+               const gagePerVolume *const *pvl, int typeOut,
+               unsigned int outDim, const size_t *outSize) {
+  static const char me[]="_gagePoolProbe";
+  gageContext *ctx;
+  _gagePoolThreadArg *arg;
+  unsigned int ai, ti, *pvlIdx, ansLen, dim;
+  size_t size[NRRD_DIM_MAX];
+
+  if (!(pool && task->nout && pvl && task->item)) {
+    biffAddf(GAGE, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (!task->ansNum) {
+    biffAddf(GAGE, "%s: need at least one answer to save", me);
+    return 1;
+  }
+  if (airEnumValCheck(nrrdType, typeOut) || nrrdTypeBlock == typeOut) {
+    biffAddf(GAGE, "%s: output type %d not valid", me, typeOut);
+    return 1;
+  }
+  if (_gagePoolAnsAlloc(pool, task->ansNum)) {
+    biffAddf(GAGE, "%s: trouble", me);
+    return 1;
+  }
+  ctx = pool->tctx[0];
+  pvlIdx = pool->pvlIdx;
+  for (ai=0; ai<task->ansNum; ai++) {
+    if (!( pvl[ai] && task->nout[ai] )) {
+      biffAddf(GAGE, "%s: got NULL pvl or nout for answer %u", me, ai);
+      return 1;
+    }
+    for (pvlIdx[ai]=0; pvlIdx[ai]<ctx->pvlNum; pvlIdx[ai]++) {
+      if (pvl[ai] == ctx->pvl[pvlIdx[ai]]) {
+        break;
+      }
+    }
+    if (pvlIdx[ai] == ctx->pvlNum) {
+      biffAddf(GAGE, "%s: pvl for answer %u not attached to pool's context",
+               me, ai);
+      return 1;
+    }
+    if (!gageAnswerPointer(ctx, pvl[ai], task->item[ai])) {
+      biffAddf(GAGE, "%s: item %d not valid for %s kind (answer %u)", me,
+               task->item[ai], pvl[ai]->kind->name, ai);
+      return 1;
+    }
+    ansLen = gageAnswerLength(ctx, pvl[ai], task->item[ai]);
+    if (1 == ansLen) {
+      dim = outDim;
+      memcpy(size, outSize, outDim*sizeof(size_t));
+    } else {
+      dim = outDim + 1;
+      size[0] = ansLen;
+      memcpy(size + 1, outSize, outDim*sizeof(size_t));
+    }
+    if (nrrdMaybeAlloc_nva(task->nout[ai], typeOut, dim, size)) {
+      biffMovef(GAGE, NRRD, "%s: couldn't allocate output %u", me, ai);
+      return 1;
+    }
+  }
+
+  for (ti=0; ti<pool->threadNum; ti++) {
+    gageContext *tctx;
+    arg = pool->arg + ti;
+    tctx = arg->ctx;
+    arg->task = task;
+    arg->failNum = 0;
+    for (ai=0; ai<task->ansNum; ai++) {
+      arg->ansSrc[ai] = gageAnswerPointer(tctx, tctx->pvl[pvlIdx[ai]],
+                                          task->item[ai]);
+      arg->ansLen[ai] = gageAnswerLength(tctx, tctx->pvl[pvlIdx[ai]],
+                                         task->item[ai]);
+    }
+  }
+
+  task->workIdx = 0;
+  /* the threads hand out work under the same mutex they wait with */
+  task->workMutex = pool->threadStarted ? pool->mutex : NULL;
+  if (pool->threadStarted) {
+    airThreadMutexLock(pool->mutex);
+    pool->busyNum = pool->threadStarted;
+    pool->generation++;
+    airThreadCondBroadcast(pool->workCond);
+    airThreadMutexUnlock(pool->mutex);
+    _gagePoolWorker(pool->arg + 0);
+    airThreadMutexLock(pool->mutex);
+    while (pool->busyNum) {
+      airThreadCondWait(pool->doneCond, pool->mutex);
+    }
+    airThreadMutexUnlock(pool->mutex);
+  } else {
+    /* one thread, or not multi-threaded: each context's share in turn */
+    for (ti=0; ti<pool->threadNum; ti++) {
+      _gagePoolWorker(pool->arg + ti);
+    }
+  }
+  if (failNum) {
+    *failNum = 0;
+    for (ti=0; ti<pool->threadNum; ti++) {
+      *failNum += pool->arg[ti].failNum;
+    }
+  }
+  return 0;
+}
+
+/*
+******** gageProbeList()
+**
+** using all the threads of the given pool, probes at the positions in
+** npos, a 2-D 3-by-N (or, with parm.stackUse, 4-by-N) array of
+** (x,y,z[,s]) positions, in index or world space according to
+** indexSpace (as with gageProbeSpace(), as is clamp).  For each of the
+** ansNum answers, item[ai] is measured in pvl[ai] (which must be
+** attached to the context the pool was made from), and saved in
+** nout[ai], which is allocated here as type typeOut, and as an
+** L-by-N array for answers of length L>1, or an N-element array
+** for scalar answers.
+**
+** As with gageProbeBatch(), probing failures do not stop the probing:
+** those answers are set to AIR_NAN, and the number of failures is
+** saved in *failNum, when failNum is non-NULL.
+*/
+int
+gageProbeList(gageContextPool *pool, Nrrd *const *nout, size_t *failNum,
+              const gagePerVolume *const *pvl, const int *item,
+              unsigned int ansNum, int typeOut, const Nrrd *npos,
+              int indexSpace, int clamp) {
+  static const char me[]="gageProbeList";
+  _gagePoolTask task;
+  Nrrd *ntmp;
+  size_t posNum;
+  unsigned int posStride;
+  airArray *mop;
+
+  if (!(pool && npos)) {
+    biffAddf(GAGE, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (!( 2 == npos->dim
+         && (3 == npos->axis[0].size || 4 == npos->axis[0].size) )) {
+    biffAddf(GAGE, "%s: need npos 2-D 3-by-N or 4-by-N (not %u-D %u-by-N)",
+             me, npos->dim, AIR_UINT(npos->axis[0].size));
+    return 1;
+  }
+  posStride = AIR_UINT(npos->axis[0].size);
+  posNum = npos->axis[1].size;
+  if (pool->tctx[0]->parm.stackUse && 4 != posStride) {
+    biffAddf(GAGE, "%s: need 4-vector positions with parm.stackUse", me);
+    return 1;
+  }
+  mop = airMopNew();
+  if (nrrdTypeDouble == npos->type) {
+    task.pos = AIR_CAST(const double *, npos->data);
+  } else {
+    ntmp = nrrdNew();
+    airMopAdd(mop, ntmp, (airMopper)nrrdNuke, airMopAlways);
+    if (nrrdConvert(ntmp, npos, nrrdTypeDouble)) {
+      biffMovef(GAGE, NRRD, "%s: couldn't convert positions to double", me);
+      airMopError(mop); return 1;
+    }
+    task.pos = AIR_CAST(const double *, ntmp->data);
+  }
+  task.posStride = posStride;
+  task.gridDim = 0;
+  task.gridSize = NULL;
+  task.posNum = posNum;
+  task.chunkLen = _GAGE_POOL_LIST_CHUNK;
+  task.indexSpace = indexSpace;
+  task.clamp = clamp;
+  task.ansNum = ansNum;
+  task.item = item;
+  task.nout = nout;
+  if (_gagePoolProbe(pool, &task, failNum, pvl, typeOut, 1, &posNum)) {
+    biffAddf(GAGE, "%s: trouble", me);
+    airMopError(mop); return 1;
+  }
+  airMopOkay(mop);
+  return 0;
+}
+
+/*
+******** gageProbeGrid()
+**
+** like gageProbeList(), but probes on a regular gridDim-dimensional
+** grid of positions, with gridSize[gi] samples along grid axis gi. The
+** position of the first sample is orig, and the step between samples
+** along grid axis gi is edge + 4*gi.  orig and edges are (x,y,z,s)
+** 4-vectors; s is ignored without parm.stackUse.  The outputs are
+** L-by-gridSize[0]-by-...-by-gridSize[gridDim-1] arrays (without
+** the L axis for scalar answers).  Each thread probes one scanline
+** (along grid axis 0) at a time, so that successive probes in each
+** context are coherent.
+*/
+int
+gageProbeGrid(gageContextPool *pool, Nrrd *const *nout, size_t *failNum,
+              const gagePerVolume *const *pvl, const int *item,
+              unsigned int ansNum, int typeOut,
+              unsigned int gridDim, const size_t *gridSize,
+              const double *orig, const double *edge,
+              int indexSpace, int clamp) {
+  static const char me[]="gageProbeGrid";
+  _gagePoolTask task;
+  unsigned int gi;
+  size_t posNum;
+
+  if (!(pool && gridSize && orig && edge)) {
+    biffAddf(GAGE, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (!( 1 <= gridDim && gridDim <= NRRD_DIM_MAX-1 )) {
+    biffAddf(GAGE, "%s: gridDim %u not in range [1,%u]", me,
+             gridDim, NRRD_DIM_MAX-1);
+    return 1;
+  }
+  posNum = 1;
+  for (gi=0; gi<gridDim; gi++) {
+    if (!gridSize[gi]) {
+      biffAddf(GAGE, "%s: gridSize[%u] is zero", me, gi);
+      return 1;
+    }
+    posNum *= gridSize[gi];
+    ELL_4V_COPY(task.gridEdge + 4*gi, edge + 4*gi);
+  }
+  ELL_4V_COPY(task.gridOrig, orig);
+  task.pos = NULL;
+  task.posStride = 0;
+  task.gridDim = gridDim;
+  task.gridSize = gridSize;
+  task.posNum = posNum;
+  task.chunkLen = gridSize[0];
+  task.indexSpace = indexSpace;
+  task.clamp = clamp;
+  task.ansNum = ansNum;
+  task.item = item;
+  task.nout = nout;
+  if (_gagePoolProbe(pool, &task, failNum, pvl, typeOut, gridDim, gridSize)) {
+    biffAddf(GAGE, "%s: trouble", me);
+    return 1;
+  }
+  return 0;
+}
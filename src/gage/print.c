@@ -27,44 +27,47 @@
 void
 _gagePrint_off(FILE *file, gageContext *ctx) {
   int i, fd;
-  unsigned int *off;
+  size_t *off;
+  char stmp[4][AIR_STRLEN_SMALL];
 
+#define OFF(ii, jj) airSprintSize_t(stmp[jj], off[ii])
   fd = 2*ctx->radius;
   off = ctx->off;
   fprintf(file, "off[]:\n");
   switch(fd) {
   case 2:
-    fprintf(file, "% 6d   % 6d\n", off[6], off[7]);
-    fprintf(file, "   % 6d   % 6d\n\n", off[4], off[5]);
-    fprintf(file, "% 6d   % 6d\n", off[2], off[3]);
-    fprintf(file, "   % 6d   % 6d\n", off[0], off[1]);
+    fprintf(file, "%6s   %6s\n", OFF(6, 0), OFF(7, 1));
+    fprintf(file, "   %6s   %6s\n\n", OFF(4, 0), OFF(5, 1));
+    fprintf(file, "%6s   %6s\n", OFF(2, 0), OFF(3, 1));
+    fprintf(file, "   %6s   %6s\n", OFF(0, 0), OFF(1, 1));
     break;
   case 4:
     for (i=3; i>=0; i--) {
-      fprintf(file, "% 6d   % 6d   % 6d   % 6d\n",
-              off[12+16*i], off[13+16*i],
-              off[14+16*i], off[15+16*i]);
-      fprintf(file, "   % 6d  %c% 6d   % 6d%c   % 6d\n",
-              off[ 8+16*i], (i==1||i==2)?'\\':' ',
-              off[ 9+16*i], off[10+16*i], (i==1||i==2)?'\\':' ',
-              off[11+16*i]);
-      fprintf(file, "      % 6d  %c% 6d   % 6d%c   % 6d\n",
-              off[ 4+16*i], (i==1||i==2)?'\\':' ',
-              off[ 5+16*i], off[ 6+16*i], (i==1||i==2)?'\\':' ',
-              off[ 7+16*i]);
-      fprintf(file, "         % 6d   % 6d   % 6d   % 6d\n",
-              off[ 0+16*i], off[ 1+16*i],
-              off[ 2+16*i], off[ 3+16*i]);
+      fprintf(file, "%6s   %6s   %6s   %6s\n",
+              OFF(12+16*i, 0), OFF(13+16*i, 1),
+              OFF(14+16*i, 2), OFF(15+16*i, 3));
+      fprintf(file, "   %6s  %c%6s   %6s%c   %6s\n",
+              OFF( 8+16*i, 0), (i==1||i==2)?'\\':' ',
+              OFF( 9+16*i, 1), OFF(10+16*i, 2), (i==1||i==2)?'\\':' ',
+              OFF(11+16*i, 3));
+      fprintf(file, "      %6s  %c%6s   %6s%c   %6s\n",
+              OFF( 4+16*i, 0), (i==1||i==2)?'\\':' ',
+              OFF( 5+16*i, 1), OFF( 6+16*i, 2), (i==1||i==2)?'\\':' ',
+              OFF( 7+16*i, 3));
+      fprintf(file, "         %6s   %6s   %6s   %6s\n",
+              OFF( 0+16*i, 0), OFF( 1+16*i, 1),
+              OFF( 2+16*i, 2), OFF( 3+16*i, 3));
       if (i) fprintf(file, "\n");
     }
     break;
   default:
     for (i=0; i<fd*fd*fd; i++) {
-      fprintf(file, "  off[% 3d,% 3d,% 3d] = % 6d\n",
-              i%fd, (i/fd)%fd, i/(fd*fd), off[i]);
+      fprintf(file, "  off[% 3d,% 3d,% 3d] = %6s\n",
+              i%fd, (i/fd)%fd, i/(fd*fd), OFF(i, 0));
     }
     break;
   }
+#undef OFF
 }
 
 #define PRINT_2(NN,C)                                  \
@@ -39,6 +39,11 @@ extern "C" {
 /* the what to put in gctx->errStr when !generateErrStr */
 #define _GAGE_NON_ERR_STR "(error)"
 
+/* whether the value cache of pvl that is filtered is its float pvl->iv3f
+   (see gageParmSinglePrecision), rather than pvl->iv3.  With a stack,
+   the base pvl's iv3 is computed (in double) from the others */
+#define _GAGE_PVL_FLOAT(ctx, pvl) ((pvl)->iv3f && !(ctx)->parm.stackUse)
+
 /* shape.c */
 extern int _gageShapeSet(const gageContext *ctx, gageShape *shape,
                          const Nrrd *nin, unsigned int baseDim);
@@ -65,6 +70,32 @@ extern int _gageLocationSet(gageContext *ctx,
 /* stack.c */
 extern int _gageStackBaseIv3Fill(gageContext *ctx);
 
+/* brick.c */
+extern unsigned int _gageBrickGather(gageContext *ctx, gagePerVolume *pvl,
+                                     const int lo[3],
+                                     const unsigned int cmin[3],
+                                     const unsigned int cmax[3]);
+
+/* stackStore.c */
+#define _GAGE_STORE_QUANT(st) \
+  (gageStoreQuant16 == (st) || gageStoreQuant8 == (st))
+extern double _gageHalfLookup(const void *ptr, size_t I);
+extern int _gageStoreType(int store, int typeIn);
+extern void _gageStoreRange(double *minP, double *stepP, int store,
+                            double oldMin, double oldMax);
+extern int _gageStoreKnown(const Nrrd *nin);
+
+/* stackLazy.c */
+extern unsigned int _gageStackLazyGather(gageContext *ctx,
+                                         gagePerVolume *pvl,
+                                         const int lo[3],
+                                         const unsigned int cmin[3],
+                                         const unsigned int cmax[3]);
+
+/* deriv.c */
+extern int _gageDerivUpdate(gageContext *ctx);
+extern void _gageDerivProbe(gageContext *ctx, gagePerVolume *pvl);
+
 /* sclprint.c */
 extern void _gageSclIv3Print(FILE *, gageContext *ctx, gagePerVolume *pvl);
 
@@ -96,6 +96,18 @@ gagePerVolumeNew(gageContext *ctx, const Nrrd *nin, const gageKind *kind) {
     pvl->flag[ii] = AIR_FALSE;
   }
   pvl->iv3 = pvl->iv2 = pvl->iv1 = NULL;
+  pvl->iv3f = pvl->iv2f = pvl->iv1f = NULL;
+  pvl->nbrick = NULL;
+  pvl->brickShift = 0;
+  pvl->derivPrecompute = AIR_FALSE;
+  pvl->nderiv = NULL;
+  pvl->nderivOwn = AIR_FALSE;
+  pvl->store = gageStoreFull;
+  pvl->storeMin = 0;
+  pvl->storeStep = 1;
+  pvl->lazy = NULL;
+  pvl->lazyIdx = 0;
+  pvl->lazySeen = NULL;
   pvl->lup = nrrdDLookup[nin->type];
   pvl->answer = AIR_CALLOC(gageKindTotalAnswerLength(kind), double);
   airMopAdd(mop, pvl->answer, airFree, airMopOnError);
@@ -146,17 +158,44 @@ _gagePerVolumeCopy(gagePerVolume *pvl, unsigned int fd) {
      constant state of gage construction, this seems much simpler.
      Pointers to per-pervolume-allocated arrays are fixed below */
   memcpy(nvl, pvl, sizeof(gagePerVolume));
-  nvl->iv3 = AIR_CALLOC(fd*fd*fd*nvl->kind->valLen, double);
-  nvl->iv2 = AIR_CALLOC(fd*fd*nvl->kind->valLen, double);
-  nvl->iv1 = AIR_CALLOC(fd*nvl->kind->valLen, double);
-  airMopAdd(mop, nvl->iv3, airFree, airMopOnError);
-  airMopAdd(mop, nvl->iv2, airFree, airMopOnError);
-  airMopAdd(mop, nvl->iv1, airFree, airMopOnError);
+  /* any pre-computed derivatives are shared with the original */
+  nvl->nderivOwn = AIR_FALSE;
+  /* which bricks of a lazy stack have been seen is per-pervolume */
+  if (nvl->lazy) {
+    nvl->lazySeen = AIR_CALLOC((AIR_CAST(size_t, nvl->lazy->bnum[0])
+                                *nvl->lazy->bnum[1])*nvl->lazy->bnum[2],
+                               unsigned char);
+    airMopAdd(mop, nvl->lazySeen, airFree, airMopOnError);
+    if (!nvl->lazySeen) {
+      biffAddf(GAGE, "%s: couldn't allocate lazy brick flags", me);
+      airMopError(mop); return NULL;
+    }
+  }
+  /* the copy has the same (double or float) caches as the original */
+  if (pvl->iv3f) {
+    nvl->iv3 = nvl->iv2 = nvl->iv1 = NULL;
+    nvl->iv3f = AIR_CALLOC(fd*fd*fd*nvl->kind->valLen, float);
+    nvl->iv2f = AIR_CALLOC(fd*fd*nvl->kind->valLen, float);
+    nvl->iv1f = AIR_CALLOC(fd*nvl->kind->valLen, float);
+    airMopAdd(mop, nvl->iv3f, airFree, airMopOnError);
+    airMopAdd(mop, nvl->iv2f, airFree, airMopOnError);
+    airMopAdd(mop, nvl->iv1f, airFree, airMopOnError);
+  } else {
+    nvl->iv3 = AIR_CALLOC(fd*fd*fd*nvl->kind->valLen, double);
+    nvl->iv2 = AIR_CALLOC(fd*fd*nvl->kind->valLen, double);
+    nvl->iv1 = AIR_CALLOC(fd*nvl->kind->valLen, double);
+    airMopAdd(mop, nvl->iv3, airFree, airMopOnError);
+    airMopAdd(mop, nvl->iv2, airFree, airMopOnError);
+    airMopAdd(mop, nvl->iv1, airFree, airMopOnError);
+    nvl->iv3f = nvl->iv2f = nvl->iv1f = NULL;
+  }
   nvl->answer = AIR_CALLOC(gageKindTotalAnswerLength(nvl->kind), double);
   airMopAdd(mop, nvl->answer, airFree, airMopOnError);
   nvl->directAnswer = AIR_CALLOC(nvl->kind->itemMax+1, double*);
   airMopAdd(mop, nvl->directAnswer, airFree, airMopOnError);
-  if (!( nvl->iv3 && nvl->iv2 && nvl->iv1
+  if (!( (pvl->iv3f
+          ? (nvl->iv3f && nvl->iv2f && nvl->iv1f)
+          : (nvl->iv3 && nvl->iv2 && nvl->iv1))
          && nvl->answer && nvl->directAnswer )) {
     biffAddf(GAGE, "%s: couldn't allocate all caches "
              "(fd=%u, valLen=%u, totAnsLen=%u, itemMax=%u)", me,
@@ -199,8 +238,15 @@ gagePerVolumeNix(gagePerVolume *pvl) {
     pvl->iv3 = (double *)airFree(pvl->iv3);
     pvl->iv2 = (double *)airFree(pvl->iv2);
     pvl->iv1 = (double *)airFree(pvl->iv1);
+    pvl->iv3f = (float *)airFree(pvl->iv3f);
+    pvl->iv2f = (float *)airFree(pvl->iv2f);
+    pvl->iv1f = (float *)airFree(pvl->iv1f);
     pvl->answer = (double *)airFree(pvl->answer);
     pvl->directAnswer = (double **)airFree(pvl->directAnswer);
+    pvl->lazySeen = (unsigned char *)airFree(pvl->lazySeen);
+    if (pvl->nderivOwn) {
+      nrrdNuke(pvl->nderiv);
+    }
     airFree(pvl);
   }
   return NULL;
@@ -0,0 +1,147 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+/*********** THIS IS A HACK !!!
+ *********** THIS ISN'T REALLY A SOURCE FILE !!!
+ *********** ITS JUST A MACRO (sorry) */
+
+  /* Like scl3pfilterbody.c, but instead of going over ivX (and ivY)
+     once for every needed derivative order along X (and Y), this does
+     one pass that computes all the needed orders at once, two
+     scanlines at a time.  Each value is loaded once and shared by up
+     to six independent accumulations, instead of there being a single
+     chain of dependent multiply-adds per dot-product.  The order of
+     operations within each dot-product is the same as with
+     scl3pfilterbody.c, so results are identical.
+
+     fd has to be #define'd as a (even) constant, since the filtered
+     results for X derivative orders 1 and 2 (and Y orders 1 and 2) are
+     saved in local arrays.  SCL3P_TYPE has to be #define'd as the type
+     (double or float) of the caches and weights, which is also the type
+     of all the arithmetic.  The fw? and iv? naming is as with
+     scl3pfilterbody.c */
+{
+  SCL3P_TYPE ivY1[fd*fd], ivY2[fd*fd], ivZ1[fd], ivZ2[fd],
+    a0, a1, a2, b0, b1, b2, av, bv;
+  const SCL3P_TYPE *ra, *rb;
+  int i, j, ord;
+
+#define DOT_F(ANS, a, b) \
+  for (a0=0.0f,i=0; i<fd; i++) { a0 += (a)[i]*(b)[i]; } \
+  ANS = a0
+
+  /* highest derivative order needed */
+  ord = doD2 ? 2 : (doD1 ? 1 : 0);
+
+  /* x0, x1, x2 */
+  for (j=0; j<fd*fd; j+=2) {
+    ra = ivX + j*fd;
+    rb = ra + fd;
+    a0 = a1 = a2 = b0 = b1 = b2 = 0.0f;
+    switch (ord) {
+    case 2:
+      for (i=0; i<fd; i++) {
+        av = ra[i]; bv = rb[i];
+        a0 += fw0[i]*av; a1 += fw1[i]*av; a2 += fw2[i]*av;
+        b0 += fw0[i]*bv; b1 += fw1[i]*bv; b2 += fw2[i]*bv;
+      }
+      ivY2[j] = a2; ivY2[j+1] = b2;
+      ivY1[j] = a1; ivY1[j+1] = b1;
+      break;
+    case 1:
+      for (i=0; i<fd; i++) {
+        av = ra[i]; bv = rb[i];
+        a0 += fw0[i]*av; a1 += fw1[i]*av;
+        b0 += fw0[i]*bv; b1 += fw1[i]*bv;
+      }
+      ivY1[j] = a1; ivY1[j+1] = b1;
+      break;
+    default:
+      for (i=0; i<fd; i++) {
+        a0 += fw0[i]*ra[i];
+        b0 += fw0[i]*rb[i];
+      }
+      break;
+    }
+    ivY[j] = a0; ivY[j+1] = b0;
+  }
+
+  /* x0y0, x0y1, x0y2 */
+  for (j=0; j<fd; j++) {
+    ra = ivY + j*fd;
+    a0 = a1 = a2 = 0.0f;
+    for (i=0; i<fd; i++) {
+      av = ra[i];
+      a0 += fw0[fd+i]*av; a1 += fw1[fd+i]*av; a2 += fw2[fd+i]*av;
+    }
+    ivZ[j] = a0; ivZ1[j] = a1; ivZ2[j] = a2;
+  }
+  /* x0y0z0 */
+  if (doV) {
+    DOT_F(*val, fw0 + 2*fd, ivZ);                 /* f */
+  }
+
+  if (ord) {
+    if (doD1) {
+      DOT_F(gvec[2], fw1 + 2*fd, ivZ);            /* g_z */
+      DOT_F(gvec[1], fw0 + 2*fd, ivZ1);           /* g_y */
+    }
+    if (doD2) {
+      DOT_F(hess[8], fw2 + 2*fd, ivZ);            /* h_zz */
+      DOT_F(hess[7], fw1 + 2*fd, ivZ1);           /* h_yz */
+      hess[5] = hess[7];
+      DOT_F(hess[4], fw0 + 2*fd, ivZ2);           /* h_yy */
+    }
+    /* x1y0, x1y1 */
+    for (j=0; j<fd; j++) {
+      ra = ivY1 + j*fd;
+      a0 = a1 = 0.0f;
+      for (i=0; i<fd; i++) {
+        av = ra[i];
+        a0 += fw0[fd+i]*av; a1 += fw1[fd+i]*av;
+      }
+      ivZ[j] = a0; ivZ1[j] = a1;
+    }
+    if (doD1) {
+      DOT_F(gvec[0], fw0 + 2*fd, ivZ);            /* g_x */
+    }
+    ell_3mv_mul_d(gvec, shape->ItoWSubInvTransp, gvec);
+    if (doD2) {
+      double matA[9];
+      DOT_F(hess[6], fw1 + 2*fd, ivZ);            /* h_xz */
+      hess[2] = hess[6];
+      DOT_F(hess[3], fw0 + 2*fd, ivZ1);           /* h_xy */
+      hess[1] = hess[3];
+      /* x2y0 */
+      for (j=0; j<fd; j++) {
+        DOT_F(ivZ[j], fw0 + fd, ivY2 + j*fd);
+      }
+      DOT_F(hess[0], fw0 + 2*fd, ivZ);            /* h_xx */
+      ELL_3M_MUL(matA, shape->ItoWSubInvTransp, hess);
+      ELL_3M_MUL(hess, matA, shape->ItoWSubInv);
+    }
+  }
+
+#undef DOT_F
+}
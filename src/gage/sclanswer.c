@@ -361,7 +361,9 @@ _gageSclAnswer(gageContext *ctx, gagePerVolume *pvl) {
     for (xi=0; xi<fd; xi++) {
       for (yi=0; yi<fd; yi++) {
         for (zi=0; zi<fd; zi++) {
-          iv3wght[0 + 2*nidx] = pvl->iv3[nidx];
+          iv3wght[0 + 2*nidx] = (_GAGE_PVL_FLOAT(ctx, pvl)
+                                 ? pvl->iv3f[nidx]
+                                 : pvl->iv3[nidx]);
           iv3wght[1 + 2*nidx] = fw[xi + 0*fd]*fw[yi + 1*fd]*fw[zi + 2*fd];
           wghtSum += iv3wght[1 + 2*nidx];
           nidx++;
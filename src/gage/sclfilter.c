@@ -337,15 +337,15 @@ gageScl3PFilter6(gageShape *shape,
                  double *fw0, double *fw1, double *fw2,
                  double *val, double *gvec, double *hess,
                  const int *needD) {
-  int i, j;
-  double T;
   int doV, doD1, doD2;
   doV = needD[0];
   doD1 = needD[1];
   doD2 = needD[2];
 
 #define fd 6
-#include "scl3pfilterbody.c"
+#define SCL3P_TYPE double
+#include "scl3pfusedbody.c"
+#undef SCL3P_TYPE
 #undef fd
 
   return;
@@ -357,15 +357,15 @@ gageScl3PFilter8(gageShape *shape,
                  double *fw0, double *fw1, double *fw2,
                  double *val, double *gvec, double *hess,
                  const int *needD) {
-  int i, j;
-  double T;
   int doV, doD1, doD2;
   doV = needD[0];
   doD1 = needD[1];
   doD2 = needD[2];
 
 #define fd 8
-#include "scl3pfilterbody.c"
+#define SCL3P_TYPE double
+#include "scl3pfusedbody.c"
+#undef SCL3P_TYPE
 #undef fd
 
   return;
@@ -389,6 +389,112 @@ gageScl3PFilterN(gageShape *shape, int fd,
   return;
 }
 
+/*
+** the float versions of the above, for gageParmSinglePrecision: the
+** caches, the weights, and all the filtering arithmetic are float, but
+** the results are stored in double, and transformed to world space in
+** double, as usual.  For all small fd these use scl3pfusedbody.c
+*/
+typedef void (_gageScl3PFilterF_t)(gageShape *shape,
+                                   float *ivX, float *ivY, float *ivZ,
+                                   float *fw0, float *fw1, float *fw2,
+                                   double *val, double *gvec, double *hess,
+                                   const int *needD);
+
+#define SCL3P_TYPE float
+
+static void
+_gageScl3PFilter2F(gageShape *shape,
+                   float *ivX, float *ivY, float *ivZ,
+                   float *fw0, float *fw1, float *fw2,
+                   double *val, double *gvec, double *hess,
+                   const int *needD) {
+  int doV, doD1, doD2;
+  doV = needD[0];
+  doD1 = needD[1];
+  doD2 = needD[2];
+
+#define fd 2
+#include "scl3pfusedbody.c"
+#undef fd
+
+  return;
+}
+
+static void
+_gageScl3PFilter4F(gageShape *shape,
+                   float *ivX, float *ivY, float *ivZ,
+                   float *fw0, float *fw1, float *fw2,
+                   double *val, double *gvec, double *hess,
+                   const int *needD) {
+  int doV, doD1, doD2;
+  doV = needD[0];
+  doD1 = needD[1];
+  doD2 = needD[2];
+
+#define fd 4
+#include "scl3pfusedbody.c"
+#undef fd
+
+  return;
+}
+
+static void
+_gageScl3PFilter6F(gageShape *shape,
+                   float *ivX, float *ivY, float *ivZ,
+                   float *fw0, float *fw1, float *fw2,
+                   double *val, double *gvec, double *hess,
+                   const int *needD) {
+  int doV, doD1, doD2;
+  doV = needD[0];
+  doD1 = needD[1];
+  doD2 = needD[2];
+
+#define fd 6
+#include "scl3pfusedbody.c"
+#undef fd
+
+  return;
+}
+
+static void
+_gageScl3PFilter8F(gageShape *shape,
+                   float *ivX, float *ivY, float *ivZ,
+                   float *fw0, float *fw1, float *fw2,
+                   double *val, double *gvec, double *hess,
+                   const int *needD) {
+  int doV, doD1, doD2;
+  doV = needD[0];
+  doD1 = needD[1];
+  doD2 = needD[2];
+
+#define fd 8
+#include "scl3pfusedbody.c"
+#undef fd
+
+  return;
+}
+
+#undef SCL3P_TYPE
+
+static void
+_gageScl3PFilterNF(gageShape *shape, int fd,
+                   float *ivX, float *ivY, float *ivZ,
+                   float *fw0, float *fw1, float *fw2,
+                   double *val, double *gvec, double *hess,
+                   const int *needD) {
+  int i, j;
+  float T;
+  int doV, doD1, doD2;
+  doV = needD[0];
+  doD1 = needD[1];
+  doD2 = needD[2];
+
+#include "scl3pfilterbody.c"
+
+  return;
+}
+
 void
 _gageSclFilter(gageContext *ctx, gagePerVolume *pvl) {
   char me[]="_gageSclFilter";
@@ -402,6 +508,32 @@ _gageSclFilter(gageContext *ctx, gagePerVolume *pvl) {
     fprintf(stderr, "!%s: sorry, 6-pack filtering not implemented\n", me);
     return;
   }
+  if (_GAGE_PVL_FLOAT(ctx, pvl)) {
+    float *fwf00, *fwf11, *fwf22;
+    _gageScl3PFilterF_t *filterF[5] = {NULL,
+                                       _gageScl3PFilter2F, _gageScl3PFilter4F,
+                                       _gageScl3PFilter6F, _gageScl3PFilter8F};
+    fwf00 = ctx->fwf + fd*3*gageKernel00;
+    fwf11 = ctx->fwf + fd*3*gageKernel11;
+    fwf22 = ctx->fwf + fd*3*gageKernel22;
+    if (fd <= 8) {
+      filterF[ctx->radius](ctx->shape, pvl->iv3f, pvl->iv2f, pvl->iv1f,
+                           fwf00, fwf11, fwf22,
+                           pvl->directAnswer[gageSclValue],
+                           pvl->directAnswer[gageSclGradVec],
+                           pvl->directAnswer[gageSclHessian],
+                           pvl->needD);
+    } else {
+      _gageScl3PFilterNF(ctx->shape, fd,
+                         pvl->iv3f, pvl->iv2f, pvl->iv1f,
+                         fwf00, fwf11, fwf22,
+                         pvl->directAnswer[gageSclValue],
+                         pvl->directAnswer[gageSclGradVec],
+                         pvl->directAnswer[gageSclHessian],
+                         pvl->needD);
+    }
+    return;
+  }
   fw00 = ctx->fw + fd*3*gageKernel00;
   fw11 = ctx->fw + fd*3*gageKernel11;
   fw22 = ctx->fw + fd*3*gageKernel22;
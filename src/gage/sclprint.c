@@ -24,46 +24,53 @@
 #include "gage.h"
 #include "privateGage.h"
 
+/* the value at index ii of whichever of iv3 and iv3f is in use */
+#define IV3(ii) (iv3f ? iv3f[ii] : AIR_CAST(float, iv3[ii]))
+
 void
 _gageSclIv3Print (FILE *file, gageContext *ctx, gagePerVolume *pvl) {
   double *iv3;
+  float *iv3f;
   int i, fd;
 
   iv3 = pvl->iv3;
+  iv3f = _GAGE_PVL_FLOAT(ctx, pvl) ? pvl->iv3f : NULL;
   fd = 2*ctx->radius;
   fprintf(file, "iv3[]:\n");
   switch(fd) {
   case 2:
-    fprintf(file, "% 10.4f   % 10.4f\n", (float)iv3[6], (float)iv3[7]);
-    fprintf(file, "   % 10.4f   % 10.4f\n\n", (float)iv3[4], (float)iv3[5]);
-    fprintf(file, "% 10.4f   % 10.4f\n", (float)iv3[2], (float)iv3[3]);
-    fprintf(file, "   % 10.4f   % 10.4f\n", (float)iv3[0], (float)iv3[1]);
+    fprintf(file, "% 10.4f   % 10.4f\n", IV3(6), IV3(7));
+    fprintf(file, "   % 10.4f   % 10.4f\n\n", IV3(4), IV3(5));
+    fprintf(file, "% 10.4f   % 10.4f\n", IV3(2), IV3(3));
+    fprintf(file, "   % 10.4f   % 10.4f\n", IV3(0), IV3(1));
     break;
   case 4:
     for (i=3; i>=0; i--) {
       fprintf(file, "% 10.4f   % 10.4f   % 10.4f   % 10.4f\n",
-              (float)iv3[12+16*i], (float)iv3[13+16*i],
-              (float)iv3[14+16*i], (float)iv3[15+16*i]);
+              IV3(12+16*i), IV3(13+16*i),
+              IV3(14+16*i), IV3(15+16*i));
       fprintf(file, "   % 10.4f  %c% 10.4f   % 10.4f%c   % 10.4f\n",
-              (float)iv3[ 8+16*i], (i==1||i==2)?'\\':' ',
-              (float)iv3[ 9+16*i], (float)iv3[10+16*i], (i==1||i==2)?'\\':' ',
-              (float)iv3[11+16*i]);
+              IV3(8+16*i), (i==1||i==2)?'\\':' ',
+              IV3(9+16*i), IV3(10+16*i), (i==1||i==2)?'\\':' ',
+              IV3(11+16*i));
       fprintf(file, "      % 10.4f  %c% 10.4f   % 10.4f%c   % 10.4f\n",
-              (float)iv3[ 4+16*i], (i==1||i==2)?'\\':' ',
-              (float)iv3[ 5+16*i], (float)iv3[ 6+16*i], (i==1||i==2)?'\\':' ',
-              (float)iv3[ 7+16*i]);
+              IV3(4+16*i), (i==1||i==2)?'\\':' ',
+              IV3(5+16*i), IV3(6+16*i), (i==1||i==2)?'\\':' ',
+              IV3(7+16*i));
       fprintf(file, "         % 10.4f   % 10.4f   % 10.4f   % 10.4f\n",
-              (float)iv3[ 0+16*i], (float)iv3[ 1+16*i],
-              (float)iv3[ 2+16*i], (float)iv3[ 3+16*i]);
+              IV3(0+16*i), IV3(1+16*i),
+              IV3(2+16*i), IV3(3+16*i));
       if (i) fprintf(file, "\n");
     }
     break;
   default:
     for (i=0; i<fd*fd*fd; i++) {
       fprintf(file, "  iv3[% 3d,% 3d,% 3d] = % 10.4f\n",
-              i%fd, (i/fd)%fd, i/(fd*fd), (float)iv3[i]);
+              i%fd, (i/fd)%fd, i/(fd*fd), IV3(i));
     }
     break;
   }
   return;
 }
+
+#undef IV3
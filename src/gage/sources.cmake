@@ -1,13 +1,16 @@
 # This variable will help provide a master list of all the sources.
 # Add new source files here.
 set(GAGE_SOURCES
+  brick.c
   ctx.c
   deconvolve.c
   defaultsGage.c
+  deriv.c
   filter.c
   gage.h
   kind.c
   miscGage.c
+  pool.c
   print.c
   privateGage.h
   pvl.c
@@ -19,6 +22,8 @@ set(GAGE_SOURCES
   st.c
   stack.c
   stackBlur.c
+  stackLazy.c
+  stackStore.c
   update.c
   vecGage.c
   vecprint.c
@@ -96,6 +96,8 @@ gageStackItoW(gageContext *ctx, double si, int *outside) {
 ** by the caller to hold blNum gagePerVolume pointers, BUT, the values
 ** of pvlStack[i] shouldn't be set to anything: as with gagePerVolumeNew(),
 ** gage allocates the pervolume itself.
+**
+** Blurrings made by gageStoreMake() are used according to their store.
 */
 int
 gageStackPerVolumeNew(gageContext *ctx,
@@ -115,7 +117,9 @@ gageStackPerVolumeNew(gageContext *ctx,
   }
 
   for (blIdx=0; blIdx<blNum; blIdx++) {
-    if (!( pvlStack[blIdx] = gagePerVolumeNew(ctx, nblur[blIdx], kind) )) {
+    if (!( pvlStack[blIdx] = gagePerVolumeNew(ctx, nblur[blIdx], kind) )
+        || gagePerVolumeStoreSet(pvlStack[blIdx],
+                                 _gageStoreKnown(nblur[blIdx]))) {
       biffAddf(GAGE, "%s: on pvl %u of %u", me, blIdx, blNum);
       return 1;
     }
@@ -91,6 +91,7 @@ gageStackBlurParmInit(gageStackBlurParm *parm) {
     parm->needSpatialBlur = AIR_FALSE;
     parm->verbose = 1; /* HEY: this may be revisited */
     parm->dgGoodSigmaMax = nrrdKernelDiscreteGaussianGoodSigmaMax;
+    parm->threadNum = 1;
   }
   return;
 }
@@ -181,6 +182,8 @@ gageStackBlurParmCompare(const gageStackBlurParm *aa, const char *_nameA,
      leeching in meet.  And for leeching, a difference in verbose is moot */
   /* CHECK(verbose, %d); */
   CHECK(dgGoodSigmaMax, %.17g);
+  /* the number of threads doesn't change the blurring results */
+  /* CHECK(threadNum, %u); */
 #undef CHECK
   if (aa->sigmaSampling != bb->sigmaSampling) {
     if (explain) {
@@ -250,6 +253,7 @@ gageStackBlurParmCopy(gageStackBlurParm *dst,
       || gageStackBlurParmBoundarySpecSet(dst, src->bspec)
       || gageStackBlurParmNeedSpatialBlurSet(dst, src->needSpatialBlur)
       || gageStackBlurParmVerboseSet(dst, src->verbose)
+      || gageStackBlurParmThreadNumSet(dst, src->threadNum)
       || gageStackBlurParmOneDimSet(dst, src->oneDim)) {
     biffAddf(GAGE, "%s: problem setting dst parm", me);
     return 1;
@@ -493,6 +497,22 @@ gageStackBlurParmVerboseSet(gageStackBlurParm *sbp, int verbose) {
   return 0;
 }
 
+int
+gageStackBlurParmThreadNumSet(gageStackBlurParm *sbp, unsigned int threadNum) {
+  static const char me[]="gageStackBlurParmThreadNumSet";
+
+  if (!sbp) {
+    biffAddf(GAGE, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (!threadNum) {
+    biffAddf(GAGE, "%s: need non-zero threadNum", me);
+    return 1;
+  }
+  sbp->threadNum = threadNum;
+  return 0;
+}
+
 int
 gageStackBlurParmDgGoodSigmaMaxSet(gageStackBlurParm *sbp,
                                  double dgGoodSigmaMax) {
@@ -535,6 +555,10 @@ gageStackBlurParmCheck(const gageStackBlurParm *sbp) {
     biffAddf(GAGE, "%s: boundary specification not set", me);
     return 1;
   }
+  if (!sbp->threadNum) {
+    biffAddf(GAGE, "%s: need non-zero threadNum", me);
+    return 1;
+  }
   for (ii=0; ii<sbp->num; ii++) {
     if (!AIR_EXISTS(sbp->sigma[ii])) {
       biffAddf(GAGE, "%s: sigma[%u] = %g doesn't exist", me, ii,
@@ -567,8 +591,9 @@ gageStackBlurParmParse(gageStackBlurParm *sbp,
   char *str, *mnmfS, *stok, *slast=NULL, *parmS, *eps;
   int flagSeen[256];
   double sigmaMin, sigmaMax, dggsm;
-  unsigned int sigmaNum, parmNum;
+  unsigned int sigmaNum, parmNum, threadNum;
   int haveFlags, verbose, verboseGot=AIR_FALSE, dggsmGot=AIR_FALSE,
+    threadNumGot=AIR_FALSE,
     sampling = AIR_FALSE, samplingGot=AIR_FALSE, E;
   airArray *mop, *epsArr;
   NrrdKernelSpec *kspec=NULL;
@@ -720,6 +745,14 @@ gageStackBlurParmParse(gageStackBlurParm *sbp,
           airMopError(mop); return 1;
         }
         dggsmGot = AIR_TRUE;
+      } else if (strcpy(xeq, "nt=") && strstr(stok, xeq) == stok) {
+        pval = stok + strlen(xeq);
+        if (!( 1 == sscanf(pval, "%u", &threadNum) && threadNum )) {
+          biffAddf(GAGE, "%s: couldn't parse \"%s\" as non-zero # threads",
+                   me, pval);
+          airMopError(mop); return 1;
+        }
+        threadNumGot = AIR_TRUE;
       } else {
         /* doesn't match any of the parms we know how to parse */
         if (extraParmsP) {
@@ -778,6 +811,9 @@ gageStackBlurParmParse(gageStackBlurParm *sbp,
   if (verboseGot) {
     if (!E) E |= gageStackBlurParmVerboseSet(sbp, verbose);
   }
+  if (threadNumGot) {
+    if (!E) E |= gageStackBlurParmThreadNumSet(sbp, threadNum);
+  }
   if (flagSeen['1']) {
     if (!E) E |= gageStackBlurParmOneDimSet(sbp, AIR_TRUE);
   }
@@ -880,6 +916,10 @@ gageStackBlurParmSprint(char str[AIR_STRLEN_LARGE],
     strcat(out, stmp);
   }
 
+  /* threadNum is not printed: it doesn't change the blurring, so (as with
+     the key/value pairs saved with a stack) it isn't part of what
+     identifies the parms */
+
   if (extraParm) {
     strcat(out, "/");
     strcat(out, extraParm);
@@ -958,6 +998,7 @@ _checkNrrd(Nrrd *const nblur[], const Nrrd *const ncheck[],
 }
 
 #define KVP_NUM 9
+#define KVP_SCALE_IDX 2
 
 static const char
 _blurKey[KVP_NUM][AIR_STRLEN_LARGE] = {/*  0  */ "gageStackBlur",
@@ -977,19 +1018,22 @@ typedef struct {
   char val[KVP_NUM][AIR_STRLEN_LARGE];
 } blurVal_t;
 
+/*
+** cksum is nrrdCRC32(nin, airEndianLittle) of the input; it is passed
+** in so that it needn't be re-computed for every use of the KVPs
+*/
 static blurVal_t *
 _blurValAlloc(airArray *mop, gageStackBlurParm *sbp, NrrdKernelSpec *kssb,
-              const Nrrd *nin, int spatialBlurred) {
+              unsigned int cksum, int spatialBlurred) {
   static const char me[]="_blurValAlloc";
   blurVal_t *blurVal;
-  unsigned int blIdx, cksum;
+  unsigned int blIdx;
 
   blurVal = AIR_CAST(blurVal_t *, calloc(sbp->num, sizeof(blurVal_t)));
   if (!blurVal) {
     biffAddf(GAGE, "%s: couldn't alloc blurVal for %u", me, sbp->num);
     return NULL;
   }
-  cksum = nrrdCRC32(nin, airEndianLittle);
 
   for (blIdx=0; blIdx<sbp->num; blIdx++) {
     kssb->parm[0] = sbp->sigma[blIdx];
@@ -1009,41 +1053,224 @@ _blurValAlloc(airArray *mop, gageStackBlurParm *sbp, NrrdKernelSpec *kssb,
   return blurVal;
 }
 
+/*
+** _stackBlurOut_t: what to do with each blurring as soon as it has
+** been computed.  The KVPs documenting the blurring are added, and if
+** format is non-NULL, the blurring is saved right away (rather than
+** after all the blurrings are done), and then emptied if !keep, so that
+** the whole stack never has to be in memory at once.
+*/
+typedef struct {
+  Nrrd *const *nblur;
+  const blurVal_t *blurVal;
+  int dggsmSave;           /* add the KVP_DGGSM_IDX KVP */
+  const char *format;      /* if non-NULL, sprintf format for saving */
+  NrrdIoState *nio;        /* how to save (may be NULL) */
+  int keep;                /* keep blurring in memory after saving */
+  char *fname;             /* buffer for filename */
+  airThreadMutex *mutex;   /* non-NULL when finishing in multiple threads */
+} _stackBlurOut_t;
+
+static int
+_stackBlurFinish(_stackBlurOut_t *sbo, unsigned int blIdx) {
+  static const char me[]="_stackBlurFinish";
+  unsigned int kvpIdx;
+  Nrrd *nblur;
+  int E;
+
+  nblur = sbo->nblur[blIdx];
+  E = 0;
+  for (kvpIdx=0; kvpIdx<KVP_NUM; kvpIdx++) {
+    /* only need to save dgGoodSigmaMax if it was spatially blurred
+       with the discrete gaussian kernel */
+    if (KVP_DGGSM_IDX != kvpIdx || sbo->dggsmSave) {
+      if (!E) E |= nrrdKeyValueAdd(nblur, _blurKey[kvpIdx],
+                                   sbo->blurVal[blIdx].val[kvpIdx]);
+    }
+  }
+  if (E) {
+    biffMovef(GAGE, NRRD, "%s: trouble adding KVPs to blurring %u",
+              me, blIdx);
+    return 1;
+  }
+  if (sbo->format) {
+    if (sbo->mutex) {
+      airThreadMutexLock(sbo->mutex);
+    }
+    sprintf(sbo->fname, sbo->format, blIdx);
+    if ((E = nrrdSave(sbo->fname, nblur, sbo->nio))) {
+      biffMovef(GAGE, NRRD, "%s: trouble saving blurring %u to \"%s\"",
+                me, blIdx, sbo->fname);
+    }
+    if (sbo->mutex) {
+      airThreadMutexUnlock(sbo->mutex);
+    }
+    if (E) {
+      return 1;
+    }
+    if (!sbo->keep) {
+      nrrdEmpty(nblur);
+    }
+  }
+  return 0;
+}
+
+/*
+** state shared by all threads of FFT-based blurring; the scales are
+** handed out one at a time
+*/
+typedef struct {
+  gageStackBlurParm *sbp;
+  const Nrrd *nin, *ninFT;
+  const NrrdFFTPlan *fplan;    /* in-place backward transform, shared by
+                                  all threads (nrrdFFTPlanExecute is
+                                  thread-safe, only the planning isn't) */
+  _stackBlurOut_t *sbo;
+  unsigned int workIdx;        /* next scale to blur */
+  airThreadMutex *workMutex;   /* NULL for a single thread */
+} _stackBlurFFTTask;
+
+/*
+** per-thread state of FFT-based blurring; nbuff is the only large
+** buffer, so each thread needs 16 bytes (a complex double) per voxel,
+** on top of the blurrings themselves
+*/
+typedef struct {
+  _stackBlurFFTTask *task;
+  Nrrd *nbuff,   /* FT of output, values set from ninFT, as complex double,
+                    and transformed in place back to the output */
+    *nreal;      /* wraps the start of nbuff->data, where the real part
+                    of the output is packed, to convert/clamp to nblur[i] */
+  double *ww[3];
+  int E;
+} _stackBlurFFTArg;
+
+static void *
+_stackBlurFFTWorker(void *_arg) {
+  static const char me[]="_stackBlurFFTWorker";
+  _stackBlurFFTArg *arg;
+  _stackBlurFFTTask *task;
+  gageStackBlurParm *sbp;
+  Nrrd *nblur;
+  size_t size[3], ii, nn, xi, yi, zi;
+  const double *inFT;
+  double *outFT, tblur, theta;
+  unsigned int blIdx, axi;
+
+  arg = AIR_CAST(_stackBlurFFTArg *, _arg);
+  task = arg->task;
+  sbp = task->sbp;
+  for (axi=0; axi<3; axi++) {
+    size[axi] = task->ninFT->axis[1+axi].size;
+  }
+  nn = size[0]*size[1]*size[2];
+  inFT = AIR_CAST(const double *, task->ninFT->data);
+  outFT = AIR_CAST(double *, arg->nbuff->data);
+  while (1) {
+    if (task->workMutex) {
+      airThreadMutexLock(task->workMutex);
+    }
+    blIdx = task->workIdx;
+    if (blIdx < sbp->num) {
+      task->workIdx++;
+    }
+    if (task->workMutex) {
+      airThreadMutexUnlock(task->workMutex);
+    }
+    if (blIdx == sbp->num) {
+      /* no more work */
+      break;
+    }
+    if (sbp->verbose) {
+      fprintf(stderr, "%s: . . . %u/%u (scale %g, tau %g) . . . ", me,
+              blIdx, sbp->num, sbp->sigma[blIdx],
+              gageTauOfSig(sbp->sigma[blIdx]));
+      fflush(stderr);
+    }
+    tblur = sbp->sigma[blIdx]*sbp->sigma[blIdx];
+    for (axi=0; axi<3; axi++) {
+      for (ii=0; ii<size[axi]; ii++) {
+        theta = AIR_AFFINE(0, ii, size[axi], 0.0, 2*AIR_PI);
+        /* from eq (22) of T. Lindeberg "Scale-Space for Discrete
+           Signals", IEEE PAMI 12(234-254); 1990 */
+        arg->ww[axi][ii] = exp(tblur*(cos(theta)-1.0));
+      }
+    }
+    ii=0;
+    for (zi=0; zi<size[2]; zi++) {
+      for (yi=0; yi<size[1]; yi++) {
+        for (xi=0; xi<size[0]; xi++) {
+          double wght;
+          wght = sbp->oneDim ? 1.0 : arg->ww[1][yi]*arg->ww[2][zi];
+          wght *= arg->ww[0][xi];
+          outFT[0 + 2*ii] = wght*inFT[0 + 2*ii];
+          outFT[1 + 2*ii] = wght*inFT[1 + 2*ii];
+          ii++;
+        }
+      }
+    }
+    if (nrrdFFTPlanExecute(arg->nbuff, task->fplan, AIR_TRUE /* rescale */)) {
+      biffMovef(GAGE, NRRD, "%s: trouble with back transform %u", me, blIdx);
+      arg->E = 1; break;
+    }
+    /* pack the real parts at the start of nbuff (where nreal is) */
+    for (ii=0; ii<nn; ii++) {
+      outFT[ii] = outFT[0 + 2*ii];
+    }
+    nblur = task->sbo->nblur[blIdx];
+    if ((nrrdTypeDouble == task->nin->type
+         ? nrrdCopy(nblur, arg->nreal)
+         : nrrdCastClampRound(nblur, arg->nreal, task->nin->type,
+                              AIR_TRUE /* clamp */,
+                              +1 /* roundDir, when needed */))
+        || nrrdContentSet_va(nblur, "blur", task->nin, "")) {
+      biffMovef(GAGE, NRRD, "%s: trouble with output %u", me, blIdx);
+      arg->E = 1; break;
+    }
+    if (_stackBlurFinish(task->sbo, blIdx)) {
+      biffAddf(GAGE, "%s: trouble finishing blurring %u", me, blIdx);
+      arg->E = 1; break;
+    }
+    if (sbp->verbose) {
+      fprintf(stderr, "done\n");
+    }
+  }
+  return _arg;
+}
+
 /*
 ** some spot checks suggest that where the PSF of lindeberg-gaussian blurring
 ** should be significantly non-zero, this is more accurate than the current
 ** "discrete gauss" kernel, but for small values near zero, the spatial
 ** blurring is more accurate.  This is due to how with limited numerical
 ** precision, the FFT can produce very low amplitude noise.
+**
+** The forward transform is done once, as is the planning of the backward
+** transform; with sbp->threadNum > 1 the scales are then blurred and
+** transformed back in parallel, each thread in its own complex double
+** buffer (so with N voxels, this needs 16*N bytes for the input's
+** transform, and 16*N more per thread).
 */
 static int
-_stackBlurDiscreteGaussFFT(Nrrd *const nblur[], gageStackBlurParm *sbp,
+_stackBlurDiscreteGaussFFT(_stackBlurOut_t *sbo, gageStackBlurParm *sbp,
                            const Nrrd *nin, const gageKind *kind) {
   static const char me[]="_stackBlurDiscreteGaussFFT";
-  size_t sizeAll[NRRD_DIM_MAX], *size, ii, xi, yi, zi, nn;
+  size_t sizeAll[NRRD_DIM_MAX], *size, ii, nn;
   Nrrd *ninC, /* complex version of input, same as input type */
-    *ninFT,   /* FT of input, type double */
-    *noutFT,  /* FT of output, values set manually from ninFT, as double */
-    *noutCd,  /* complex version of output, still as double */
-    *noutC;   /* complex version of output, as input type;
-                 will convert/clamp this to get nblur[i] */
-  double (*lup)(const void *, size_t), (*ins)(void *, size_t, double),
-    *ww[3], tblur, theta, *inFT, *outFT;
-  unsigned int blIdx, axi, ftaxes[3] = {1,2,3};
+    *ninFT;   /* FT of input, type double */
+  double (*lup)(const void *, size_t), (*ins)(void *, size_t, double);
+  unsigned int axi, ti, threadNum, ftaxes[3] = {1,2,3};
   airArray *mop;
   int axmap[NRRD_DIM_MAX];
+  _stackBlurFFTTask task;
+  _stackBlurFFTArg *arg;
+  NrrdFFTPlan *fplan;
 
   mop = airMopNew();
   ninC = nrrdNew();
   airMopAdd(mop, ninC, (airMopper)nrrdNuke, airMopAlways);
   ninFT = nrrdNew();
   airMopAdd(mop, ninFT, (airMopper)nrrdNuke, airMopAlways);
-  noutFT = nrrdNew();
-  airMopAdd(mop, noutFT, (airMopper)nrrdNuke, airMopAlways);
-  noutCd = nrrdNew();
-  airMopAdd(mop, noutCd, (airMopper)nrrdNuke, airMopAlways);
-  noutC = nrrdNew();
-  airMopAdd(mop, noutC, (airMopper)nrrdNuke, airMopAlways);
 
   if (gageKindScl != kind) {
     biffAddf(GAGE, "%s: sorry, non-scalar kind not yet implemented", me);
@@ -1066,13 +1293,6 @@ _stackBlurDiscreteGaussFFT(Nrrd *const nblur[], gageStackBlurParm *sbp,
     biffMovef(GAGE, NRRD, "%s: couldn't allocate complex-valued input", me);
     airMopError(mop); return 1;
   }
-  for (axi=0; axi<3; axi++) {
-    if (!( ww[axi] = AIR_CALLOC(size[axi], double) )) {
-      biffAddf(GAGE, "%s: couldn't allocate axis %u buffer", me, axi);
-      airMopError(mop); return 1;
-    }
-    airMopAdd(mop, ww[axi], airFree, airMopAlways);
-  }
   nn = size[0]*size[1]*size[2];
   for (ii=0; ii<nn; ii++) {
     ins(ninC->data, 0 + 2*ii, lup(nin->data, ii));
@@ -1096,100 +1316,235 @@ _stackBlurDiscreteGaussFFT(Nrrd *const nblur[], gageStackBlurParm *sbp,
     airMopError(mop); return 1;
   }
   ninC->axis[0].kind = nrrdKindComplex; /* should use API */
-  /*
-  nrrdSave("ninC.nrrd", ninC, NULL);
-  */
-  /* the copy to noutFT is just to allocate it; the values
-     there will be re-written over and over in the loop below */
   if (nrrdFFT(ninFT, ninC, ftaxes, 3,
               +1 /* forward */,
               AIR_TRUE /* rescale */,
-              nrrdFFTWPlanRigorEstimate /* should generalize! */)
-      || nrrdCopy(noutFT, ninFT)) {
-    biffMovef(GAGE, NRRD, "%s: trouble with initial transforms", me);
+              nrrdFFTWPlanRigorEstimate /* should generalize! */)) {
+    biffMovef(GAGE, NRRD, "%s: trouble with initial transform", me);
     airMopError(mop); return 1;
   }
-  /*
-  nrrdSave("ninFT.nrrd", ninFT, NULL);
-  */
-  inFT = AIR_CAST(double *, ninFT->data);
-  outFT = AIR_CAST(double *, noutFT->data);
-  for (blIdx=0; blIdx<sbp->num; blIdx++) {
-    if (sbp->verbose) {
-      fprintf(stderr, "%s: . . . %u/%u (scale %g, tau %g) . . . ", me,
-              blIdx, sbp->num, sbp->sigma[blIdx],
-              gageTauOfSig(sbp->sigma[blIdx]));
-      fflush(stderr);
+  /* don't need the complex-valued input any more */
+  nrrdEmpty(ninC);
+
+  threadNum = AIR_MIN(sbp->threadNum, sbp->num);
+  arg = AIR_CALLOC(threadNum, _stackBlurFFTArg);
+  if (!arg) {
+    biffAddf(GAGE, "%s: couldn't allocate %u thread args", me, threadNum);
+    airMopError(mop); return 1;
+  }
+  airMopAdd(mop, arg, airFree, airMopAlways);
+  for (ti=0; ti<threadNum; ti++) {
+    arg[ti].task = &task;
+    arg[ti].nbuff = nrrdNew();
+    airMopAdd(mop, arg[ti].nbuff, (airMopper)nrrdNuke, airMopAlways);
+    arg[ti].nreal = nrrdNew();
+    airMopAdd(mop, arg[ti].nreal, (airMopper)nrrdNix /* NOT Nuke */,
+              airMopAlways);
+    if (nrrdMaybeAlloc_nva(arg[ti].nbuff, nrrdTypeDouble, 4, sizeAll)
+        || nrrdWrap_nva(arg[ti].nreal, arg[ti].nbuff->data, nrrdTypeDouble,
+                        3, size)
+        || nrrdAxisInfoCopy(arg[ti].nreal, nin, NULL, NRRD_AXIS_INFO_NONE)
+        || nrrdBasicInfoCopy(arg[ti].nreal, nin,
+                             (NRRD_BASIC_INFO_DATA_BIT |
+                              NRRD_BASIC_INFO_TYPE_BIT |
+                              NRRD_BASIC_INFO_BLOCKSIZE_BIT |
+                              NRRD_BASIC_INFO_DIMENSION_BIT |
+                              NRRD_BASIC_INFO_CONTENT_BIT |
+                              NRRD_BASIC_INFO_COMMENTS_BIT |
+                              NRRD_BASIC_INFO_KEYVALUEPAIRS_BIT))) {
+      biffMovef(GAGE, NRRD, "%s: couldn't allocate FT buffer %u", me, ti);
+      airMopError(mop); return 1;
     }
-    tblur = sbp->sigma[blIdx]*sbp->sigma[blIdx];
     for (axi=0; axi<3; axi++) {
-      for (ii=0; ii<size[axi]; ii++) {
-        theta = AIR_AFFINE(0, ii, size[axi], 0.0, 2*AIR_PI);
-        /* from eq (22) of T. Lindeberg "Scale-Space for Discrete
-           Signals", IEEE PAMI 12(234-254); 1990 */
-        ww[axi][ii] = exp(tblur*(cos(theta)-1.0));
-        /*
-        fprintf(stderr, "!%s: ww[%u][%u] = %g\n", me, axi,
-                AIR_CAST(unsigned int, ii), ww[axi][ii]);
-        */
+      if (!( arg[ti].ww[axi] = AIR_CALLOC(size[axi], double) )) {
+        biffAddf(GAGE, "%s: couldn't allocate axis %u buffer", me, axi);
+        airMopError(mop); return 1;
       }
+      airMopAdd(mop, arg[ti].ww[axi], airFree, airMopAlways);
     }
-    ii=0;
-    /*
-    for (axi=0; axi<3; axi++) {
-      fprintf(stderr, "!%s: size[%u] = %u\n", me, axi,
-              AIR_CAST(unsigned int, size[axi]));
+  }
+  /* the one plan for all threads; estimating doesn't touch nbuff values */
+  fplan = nrrdFFTPlanNew(arg[0].nbuff, ftaxes, 3, -1 /* backward */,
+                         nrrdFFTWPlanRigorEstimate /* should generalize! */);
+  if (!fplan) {
+    biffMovef(GAGE, NRRD, "%s: trouble planning back transform", me);
+    airMopError(mop); return 1;
+  }
+  airMopAdd(mop, fplan, (airMopper)nrrdFFTPlanNix, airMopAlways);
+  task.sbp = sbp;
+  task.nin = nin;
+  task.ninFT = ninFT;
+  task.fplan = fplan;
+  task.sbo = sbo;
+  task.workIdx = 0;
+  if (1 < threadNum) {
+    task.workMutex = airThreadMutexNew();
+    airMopAdd(mop, task.workMutex, (airMopper)airThreadMutexNix,
+              airMopAlways);
+    sbo->mutex = airThreadMutexNew();
+    airMopAdd(mop, sbo->mutex, (airMopper)airThreadMutexNix, airMopAlways);
+    airMopAdd(mop, &(sbo->mutex), (airMopper)airSetNull, airMopAlways);
+    if (!( task.workMutex && sbo->mutex )) {
+      biffAddf(GAGE, "%s: couldn't create mutexes", me);
+      airMopError(mop); return 1;
     }
-    */
-    for (zi=0; zi<size[2]; zi++) {
-      for (yi=0; yi<size[1]; yi++) {
-        for (xi=0; xi<size[0]; xi++) {
-          double wght;
-          wght = sbp->oneDim ? 1.0 : ww[1][yi]*ww[2][zi];
-          wght *= ww[0][xi];
-          outFT[0 + 2*ii] = wght*inFT[0 + 2*ii];
-          outFT[1 + 2*ii] = wght*inFT[1 + 2*ii];
-          /*
-          fprintf(stderr, "!%s: out[%u] = (%g,%g) = %g * (%g,%g)\n", me,
-                  AIR_CAST(unsigned int, ii),
-                  outFT[0 + 2*ii], outFT[1 + 2*ii],
-                  wght,
-                  inFT[0 + 2*ii], inFT[1 + 2*ii]);
-          */
-          ii++;
-        }
-      }
+    if (!airThreadCapable) {
+      fprintf(stderr, "%s: WARNING: not multi-threaded; will do %u "
+              "\"threads\" serially !!!\n", me, threadNum);
     }
-    if (nrrdFFT(noutCd, noutFT, ftaxes, 3,
-                -1 /* backward */,
-                AIR_TRUE /* rescale */,
-                nrrdFFTWPlanRigorEstimate /* should generalize! */)
-        || (nrrdTypeDouble == nin->type
-            ? nrrdCopy(noutC, noutCd)
-            : nrrdCastClampRound(noutC, noutCd, nin->type,
-                                 AIR_TRUE /* clamp */,
-                                 +1 /* roundDir, when needed */))
-        || nrrdSlice(nblur[blIdx], noutC, 0, 0)
-        || nrrdContentSet_va(nblur[blIdx], "blur", nin, "")) {
-      biffMovef(GAGE, NRRD, "%s: trouble with back transform %u", me, blIdx);
+  } else {
+    task.workMutex = NULL;
+  }
+  if (airThreadRun(_stackBlurFFTWorker, arg, sizeof(*arg), threadNum)) {
+    biffAddf(GAGE, "%s: couldn't run %u threads", me, threadNum);
+    airMopError(mop); return 1;
+  }
+  for (ti=0; ti<threadNum; ti++) {
+    if (arg[ti].E) {
+      biffAddf(GAGE, "%s: trouble in thread %u", me, ti);
       airMopError(mop); return 1;
     }
-    if (sbp->verbose) {
-      fprintf(stderr, "done\n");
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
+
+/*
+** _stackBlurSlab: for spatial-domain blurring with multiple threads,
+** each blurring is parallelized by cutting the volume into slabs along
+** its slowest axis, one per thread.  Each slab is cropped out with a
+** margin as wide as the support of the kernel on that axis, so that
+** resampling the slab gives exactly the same values (away from the
+** margin) as resampling the whole volume, regardless of the number of
+** threads. This can't work with nrrdBoundaryWrap (the margin at one end
+** of the volume comes from the other end), so then one slab is used.
+*/
+typedef struct {
+  NrrdResampleContext *rsmc;
+  Nrrd *nsin, *nsout;        /* slab input (with margin) and output */
+  size_t lo, hi;             /* slab is [lo,hi] (inclusive) on slow axis */
+  int E;
+} _stackBlurSlab;
+
+static void *
+_stackBlurSlabWorker(void *_slab) {
+  _stackBlurSlab *slab;
+
+  slab = AIR_CAST(_stackBlurSlab *, _slab);
+  slab->E = nrrdResampleExecute(slab->rsmc, slab->nsout);
+  return _slab;
+}
+
+/*
+** resamples nin into nout with kernel ksp[axi] on spatial axis axi (no
+** resampling on that axis if ksp[axi] is NULL), using all the slabs.
+** nout and nin may be the same Nrrd
+*/
+static int
+_stackBlurSlabExecute(Nrrd *nout, const Nrrd *nin,
+                      _stackBlurSlab *slab, unsigned int slabNum,
+                      unsigned int baseDim,
+                      NrrdKernelSpec *const ksp[3]) {
+  static const char me[]="_stackBlurSlabExecute";
+  size_t cmin[NRRD_DIM_MAX], cmax[NRRD_DIM_MAX], size[NRRD_DIM_MAX],
+    margin, slowSize, sliceBytes;
+  unsigned int si, axi, slowAxis;
+  double slowMin, slowMax;
+  airArray *mop;
+  int E;
+
+  slowAxis = baseDim + 2;
+  slowSize = nin->axis[slowAxis].size;
+  if (ksp[2]) {
+    margin = 1 + AIR_CAST(size_t, ceil(ksp[2]->kernel->support(ksp[2]->parm)));
+  } else {
+    margin = 0;
+  }
+  nrrdAxisInfoGet_nva(nin, nrrdAxisInfoSize, size);
+  E = 0;
+  for (si=0; si<slabNum; si++) {
+    const Nrrd *nsin;
+    if (1 == slabNum) {
+      nsin = nin;
+    } else {
+      /* all slabs are cropped before any output is written, so its
+         okay for nout to be nin */
+      for (axi=0; axi<nin->dim; axi++) {
+        cmin[axi] = 0;
+        cmax[axi] = size[axi]-1;
+      }
+      cmin[slowAxis] = slab[si].lo > margin ? slab[si].lo - margin : 0;
+      cmax[slowAxis] = AIR_MIN(slab[si].hi + margin, slowSize-1);
+      if (!E) E |= nrrdCrop(slab[si].nsin, nin, cmin, cmax);
+      nsin = slab[si].nsin;
+    }
+    if (!E) E |= nrrdResampleInputSet(slab[si].rsmc, nsin);
+    for (axi=0; axi<3; axi++) {
+      if (ksp[axi]) {
+        if (!E) E |= nrrdResampleKernelSet(slab[si].rsmc, baseDim + axi,
+                                           ksp[axi]->kernel, ksp[axi]->parm);
+      } else {
+        if (!E) E |= nrrdResampleKernelSet(slab[si].rsmc, baseDim + axi,
+                                           NULL, NULL);
+      }
+      if (!E) E |= nrrdResampleSamplesSet(slab[si].rsmc, baseDim + axi,
+                                          nsin->axis[baseDim + axi].size);
+      if (!E) E |= nrrdResampleRangeFullSet(slab[si].rsmc, baseDim + axi);
+    }
+  }
+  if (E) {
+    biffMovef(GAGE, NRRD, "%s: trouble setting up slabs", me);
+    return 1;
+  }
+  if (1 == slabNum) {
+    if (nrrdResampleExecute(slab[0].rsmc, nout)) {
+      biffMovef(GAGE, NRRD, "%s: trouble resampling", me);
+      return 1;
     }
-    /*
-    if (0) {
-      char fname[AIR_STRLEN_SMALL];
-      sprintf(fname, "noutFT-%03u.nrrd", blIdx);
-      nrrdSave(fname, noutFT, NULL);
-      sprintf(fname, "noutCd-%03u.nrrd", blIdx);
-      nrrdSave(fname, noutCd, NULL);
-      sprintf(fname, "noutC-%03u.nrrd", blIdx);
-      nrrdSave(fname, noutC, NULL);
-      sprintf(fname, "nblur-%03u.nrrd", blIdx);
-      nrrdSave(fname, nblur[blIdx], NULL);
+    return 0;
+  }
+
+  mop = airMopNew();
+  if (!airThreadCapable) {
+    fprintf(stderr, "%s: WARNING: not multi-threaded; will do %u "
+            "\"threads\" serially !!!\n", me, slabNum);
+  }
+  if (airThreadRun(_stackBlurSlabWorker, slab, sizeof(*slab), slabNum)) {
+    biffAddf(GAGE, "%s: couldn't run %u threads", me, slabNum);
+    airMopError(mop); return 1;
+  }
+  for (si=0; si<slabNum; si++) {
+    if (slab[si].E) {
+      biffMovef(GAGE, NRRD, "%s: trouble resampling slab %u", me, si);
+      airMopError(mop); return 1;
     }
-    */
+  }
+  /* assemble output; the peripheral info is that of the first slab
+     (which starts where the volume does), except for the extent of the
+     slow axis */
+  slowMin = nin->axis[slowAxis].min;
+  slowMax = nin->axis[slowAxis].max;
+  if (nrrdMaybeAlloc_nva(nout, slab[0].nsout->type, nin->dim, size)
+      || nrrdAxisInfoCopy(nout, slab[0].nsout, NULL,
+                          NRRD_AXIS_INFO_SIZE_BIT)
+      || nrrdBasicInfoCopy(nout, slab[0].nsout,
+                           (NRRD_BASIC_INFO_DATA_BIT |
+                            NRRD_BASIC_INFO_TYPE_BIT |
+                            NRRD_BASIC_INFO_BLOCKSIZE_BIT |
+                            NRRD_BASIC_INFO_DIMENSION_BIT))) {
+    biffMovef(GAGE, NRRD, "%s: trouble allocating output", me);
+    airMopError(mop); return 1;
+  }
+  nout->axis[slowAxis].min = slowMin;
+  nout->axis[slowAxis].max = slowMax;
+  sliceBytes = nrrdElementSize(nout)*(nrrdElementNumber(nout)/slowSize);
+  for (si=0; si<slabNum; si++) {
+    size_t off;
+    off = slab[si].lo - (slab[si].lo > margin ? slab[si].lo - margin : 0);
+    memcpy(AIR_CAST(char *, nout->data) + sliceBytes*slab[si].lo,
+           AIR_CAST(char *, slab[si].nsout->data) + sliceBytes*off,
+           sliceBytes*(slab[si].hi - slab[si].lo + 1));
   }
 
   airMopOkay(mop);
@@ -1197,14 +1552,16 @@ _stackBlurDiscreteGaussFFT(Nrrd *const nblur[], gageStackBlurParm *sbp,
 }
 
 static int
-_stackBlurSpatial(Nrrd *const nblur[], gageStackBlurParm *sbp,
+_stackBlurSpatial(_stackBlurOut_t *sbo, gageStackBlurParm *sbp,
                   NrrdKernelSpec *kssb,
                   const Nrrd *nin, const gageKind *kind) {
   static const char me[]="_stackBlurSpatial";
-  NrrdResampleContext *rsmc;
-  Nrrd *niter;
-  unsigned int axi, blIdx;
+  _stackBlurSlab *slab;
+  NrrdKernelSpec *kspBox, *ksp[3];
+  Nrrd *niter, *const *nblur;
+  unsigned int axi, blIdx, si, slabNum;
   int E, iterative, rsmpType;
+  size_t slowSize;
   double timeStepMax, /* max length of diffusion time allowed per blur,
                          as determined by sbp->dgGoodSigmaMax */
     timeDone,         /* amount of diffusion time just applied */
@@ -1212,8 +1569,7 @@ _stackBlurSpatial(Nrrd *const nblur[], gageStackBlurParm *sbp,
   airArray *mop;
 
   mop = airMopNew();
-  rsmc = nrrdResampleContextNew();
-  airMopAdd(mop, rsmc, (airMopper)nrrdResampleContextNix, airMopAlways);
+  nblur = sbo->nblur;
   if (nrrdKernelDiscreteGaussian == kssb->kernel) {
     iterative = AIR_TRUE;
     /* we don't want to lose precision when iterating */
@@ -1226,31 +1582,55 @@ _stackBlurSpatial(Nrrd *const nblur[], gageStackBlurParm *sbp,
     rsmpType = nrrdTypeDefault;
     niter = NULL;
   }
-
+  kspBox = nrrdKernelSpecNew();
+  airMopAdd(mop, kspBox, (airMopper)nrrdKernelSpecNix, airMopAlways);
+  kspBox->kernel = nrrdKernelBox;
+  kspBox->parm[0] = 1.0;
+
+  slowSize = nin->axis[kind->baseDim + 2].size;
+  slabNum = (nrrdBoundaryWrap == sbp->bspec->boundary
+             ? 1 : AIR_UINT(AIR_MIN(sbp->threadNum, slowSize)));
+  slab = AIR_CALLOC(slabNum, _stackBlurSlab);
+  if (!slab) {
+    biffAddf(GAGE, "%s: couldn't allocate %u slabs", me, slabNum);
+    airMopError(mop); return 1;
+  }
+  airMopAdd(mop, slab, airFree, airMopAlways);
   E = 0;
-  if (!E) E |= nrrdResampleDefaultCenterSet(rsmc, nrrdDefaultCenter);
-  /* the input for the first scale is indeed nin, regardless
-     of iterative */
-  if (!E) E |= nrrdResampleInputSet(rsmc, nin);
-  if (kind->baseDim) {
-    unsigned int bai;
-    for (bai=0; bai<kind->baseDim; bai++) {
-      if (!E) E |= nrrdResampleKernelSet(rsmc, bai, NULL, NULL);
+  for (si=0; si<slabNum; si++) {
+    slab[si].rsmc = nrrdResampleContextNew();
+    airMopAdd(mop, slab[si].rsmc, (airMopper)nrrdResampleContextNix,
+              airMopAlways);
+    slab[si].nsin = nrrdNew();
+    airMopAdd(mop, slab[si].nsin, (airMopper)nrrdNuke, airMopAlways);
+    slab[si].nsout = nrrdNew();
+    airMopAdd(mop, slab[si].nsout, (airMopper)nrrdNuke, airMopAlways);
+    slab[si].lo = si*slowSize/slabNum;
+    slab[si].hi = (si+1)*slowSize/slabNum - 1;
+    if (!E) E |= nrrdResampleDefaultCenterSet(slab[si].rsmc,
+                                              nrrdDefaultCenter);
+    /* the input is (re-)set for every resampling, but setting it now
+       allows the per-axis settings below */
+    if (!E) E |= nrrdResampleInputSet(slab[si].rsmc, nin);
+    if (kind->baseDim) {
+      unsigned int bai;
+      for (bai=0; bai<kind->baseDim; bai++) {
+        if (!E) E |= nrrdResampleKernelSet(slab[si].rsmc, bai, NULL, NULL);
+      }
     }
+    if (!E) E |= nrrdResampleBoundarySpecSet(slab[si].rsmc, sbp->bspec);
+    if (!E) E |= nrrdResampleTypeOutSet(slab[si].rsmc, rsmpType);
+    /* probably moot */
+    if (!E) E |= nrrdResampleClampSet(slab[si].rsmc, AIR_TRUE);
+    if (!E) E |= nrrdResampleRenormalizeSet(slab[si].rsmc, sbp->renormalize);
   }
-  for (axi=0; axi<3; axi++) {
-    if (!E) E |= nrrdResampleSamplesSet(rsmc, kind->baseDim + axi,
-                                        nin->axis[kind->baseDim + axi].size);
-    if (!E) E |= nrrdResampleRangeFullSet(rsmc, kind->baseDim + axi);
-  }
-  if (!E) E |= nrrdResampleBoundarySpecSet(rsmc, sbp->bspec);
-  if (!E) E |= nrrdResampleTypeOutSet(rsmc, rsmpType);
-  if (!E) E |= nrrdResampleClampSet(rsmc, AIR_TRUE); /* probably moot */
-  if (!E) E |= nrrdResampleRenormalizeSet(rsmc, sbp->renormalize);
   if (E) {
-    biffAddf(GAGE, "%s: trouble setting up resampling", me);
+    biffMovef(GAGE, NRRD, "%s: trouble setting up resampling", me);
     airMopError(mop); return 1;
   }
+  if (sbp->verbose && 1 < slabNum) {
+    fprintf(stderr, "%s: blurring with %u threads\n", me, slabNum);
+  }
 
   timeDone = 0;
   timeStepMax = (sbp->dgGoodSigmaMax)*(sbp->dgGoodSigmaMax);
@@ -1276,20 +1656,19 @@ _stackBlurSpatial(Nrrd *const nblur[], gageStackBlurParm *sbp,
         }
         fflush(stderr);
       }
+      /* we set the blurring kernel on every axis if we are NOT doing
+         oneDim, or, we are, but this is axi == 0 */
+      ksp[0] = kssb;
+      for (axi=1; axi<3; axi++) {
+        /* what to do with oneDom on axi 1, 2 */
+        /* you might think that we should just do no resampling at all
+           on this axis, but that would undermine the in==out==niter
+           trick described below; and produce the mysterious behavior
+           that the second scale-space volume is all 0.0 */
+        ksp[axi] = sbp->oneDim ? kspBox : kssb;
+      }
       do {
         double timeDo;
-        if (blIdx || passIdx) {
-          /* either we're past the first scale (blIdx >= 1), or
-             (unlikely) we're on the first scale but after the first
-             pass of a multi-pass blurring, so we have to feed the
-             previous result back in as input.
-             AND: the way that niter is being used is very sneaky,
-             and probably too clever: the resampling happens in
-             multiple passes, among buffers internal to nrrdResample;
-             so its okay have the output and input nrrds be the same:
-             they're never used at the same time. */
-          if (!E) E |= nrrdResampleInputSet(rsmc, niter);
-        }
         timeDo = (timeLeft > timeStepMax
                   ? timeStepMax
                   : timeLeft);
@@ -1297,44 +1676,26 @@ _stackBlurSpatial(Nrrd *const nblur[], gageStackBlurParm *sbp,
            copying to our own kernel spec, so that the given one in the
            gageStackBlurParm can stay untouched */
         kssb->parm[0] = sqrt(timeDo);
-        for (axi=0; axi<3; axi++) {
-          if (!sbp->oneDim || !axi) {
-            /* we set the blurring kernel on this axis if
-               we are NOT doing oneDim, or, we are,
-               but this is axi == 0 */
-            if (!E) E |= nrrdResampleKernelSet(rsmc, kind->baseDim + axi,
-                                               kssb->kernel,
-                                               kssb->parm);
-          } else {
-            /* what to do with oneDom on axi 1, 2 */
-            /* you might think that we should just do no resampling at all
-               on this axis, but that would undermine the in==out==niter
-               trick described above; and produce the mysterious behavior
-               that the second scale-space volume is all 0.0 */
-            double boxparm[NRRD_KERNEL_PARMS_NUM] = {1.0};
-            if (!E) E |= nrrdResampleKernelSet(rsmc, kind->baseDim + axi,
-                                               nrrdKernelBox, boxparm);
-          }
-        }
         if (sbp->verbose) {
           fprintf(stderr, "  pass %u (timeLeft=%g => "
                   "time=%g, sigma=%g) ...\n",
                   passIdx, timeLeft, timeDo, kssb->parm[0]);
         }
-        if (!E) E |= nrrdResampleExecute(rsmc, niter);
-        /* for debugging problem with getting zero output
-        if (!E) {
-          NrrdRange *nrange;
-          nrange = nrrdRangeNewSet(niter, AIR_FALSE);
-          fprintf(stderr, "%s: min/max = %g/%g\n", me,
-                  nrange->min, nrange->max);
-          if (!nrange->min || !nrange->max) {
-            fprintf(stderr, "%s: what? zero zero\n", me);
-            biffAddf(GAGE, "%s: no good", me);
-            airMopError(mop); return 1;
-          }
-        }
-        */
+        /* when either we're past the first scale (blIdx >= 1), or
+           (unlikely) we're on the first scale but after the first
+           pass of a multi-pass blurring, we have to feed the
+           previous result back in as input.
+           AND: the way that niter is being used is very sneaky,
+           and probably too clever: the resampling happens in
+           multiple passes, among buffers internal to nrrdResample;
+           so its okay have the output and input nrrds be the same:
+           they're never used at the same time. */
+        if (!E) E |= _stackBlurSlabExecute(niter,
+                                           (blIdx || passIdx
+                                            ? niter
+                                            : nin),
+                                           slab, slabNum, kind->baseDim,
+                                           ksp);
         timeLeft -= timeDo;
         passIdx++;
       } while (!E && timeLeft > 0.0);
@@ -1343,26 +1704,29 @@ _stackBlurSpatial(Nrrd *const nblur[], gageStackBlurParm *sbp,
          in nrrd/resampleContext.c), since we've gently hijacked
          the resampling to access the nrrdResample_t blurring
          result (for further blurring) */
-      if (!E) E |= nrrdCastClampRound(nblur[blIdx], niter, nin->type,
-                                      AIR_TRUE,
-                                      nrrdTypeIsIntegral[nin->type]);
-      if (!E) E |= nrrdContentSet_va(nblur[blIdx], "blur", nin, "");
+      if (!E && (nrrdCastClampRound(nblur[blIdx], niter, nin->type,
+                                    AIR_TRUE,
+                                    nrrdTypeIsIntegral[nin->type])
+                 || nrrdContentSet_va(nblur[blIdx], "blur", nin, ""))) {
+        biffMovef(GAGE, NRRD, "%s: trouble converting blurring", me);
+        E = 1;
+      }
       timeDone = timeNow;
     } else { /* do blurring in one shot */
       kssb->parm[0] = sbp->sigma[blIdx];
-      for (axi=0; axi<(sbp->oneDim ? 1u : 3u); axi++) {
-        if (!E) E |= nrrdResampleKernelSet(rsmc, kind->baseDim + axi,
-                                           kssb->kernel,
-                                           kssb->parm);
+      for (axi=0; axi<3; axi++) {
+        ksp[axi] = (!sbp->oneDim || !axi) ? kssb : NULL;
       }
-      if (!E) E |= nrrdResampleExecute(rsmc, nblur[blIdx]);
+      if (!E) E |= _stackBlurSlabExecute(nblur[blIdx], nin,
+                                         slab, slabNum, kind->baseDim, ksp);
     }
+    if (!E) E |= _stackBlurFinish(sbo, blIdx);
     if (E) {
       if (sbp->verbose) {
         fprintf(stderr, "problem!\n");
       }
-      biffMovef(GAGE, NRRD, "%s: trouble w/ %u of %u (scale %g)",
-                me, blIdx, sbp->num, sbp->sigma[blIdx]);
+      biffAddf(GAGE, "%s: trouble w/ %u of %u (scale %g)",
+               me, blIdx, sbp->num, sbp->sigma[blIdx]);
       airMopError(mop); return 1;
     }
     if (sbp->verbose) {
@@ -1375,35 +1739,166 @@ _stackBlurSpatial(Nrrd *const nblur[], gageStackBlurParm *sbp,
 }
 
 /*
-** little helper function to do pre-blurring of a given nrrd
-** of the sort that might be useful for scale-space gage use
+** The manifest of a stack saved with sprintf format "format" is a small
+** NRRD file, named by replacing the conversion specification in format
+** with "manifest" (so "blur-%02u.nrrd" has manifest "blur-manifest.nrrd").
+** Its data is the vector of sigmas, and its KVPs are those of the first
+** blurring (except for "scale"), including the checksum of the input.
+** It is written only after all the blurrings have been saved, so that
+** whether they can be re-used can be learned from it alone, without
+** reading any of them.
 **
-** nblur has to already be allocated for "blNum" Nrrd*s, AND, they all
-** have to point to valid (possibly empty) Nrrds, so they can hold the
-** results of blurring
+** returns NULL (without biff) if there is no conversion specification
 */
-int
-gageStackBlur(Nrrd *const nblur[], gageStackBlurParm *sbp,
-              const Nrrd *nin, const gageKind *kind) {
-  static const char me[]="gageStackBlur";
-  unsigned int blIdx, kvpIdx;
-  NrrdKernelSpec *kssb;
-  blurVal_t *blurVal;
+static char *
+_stackBlurManifestName(const char *format) {
+  const char *pp, *qq;
+  char *ret;
+
+  if (!( format && (pp = strchr(format, '%')) )) {
+    return NULL;
+  }
+  for (qq=pp+1; *qq && !strchr("diouxX", *qq); qq++)
+    ;
+  if (!*qq) {
+    return NULL;
+  }
+  ret = AIR_CALLOC(strlen(format) + strlen("manifest") + 1, char);
+  if (ret) {
+    strncpy(ret, format, pp - format);
+    ret[pp - format] = '\0';
+    strcat(ret, "manifest");
+    strcat(ret, qq+1);
+  }
+  return ret;
+}
+
+static int
+_stackBlurManifestSave(const char *mname, gageStackBlurParm *sbp,
+                       const blurVal_t *blurVal, int dggsmSave) {
+  static const char me[]="_stackBlurManifestSave";
+  Nrrd *nman;
+  NrrdIoState *nio;
+  unsigned int kvpIdx;
   airArray *mop;
-  int E, fftable, spatialBlurred;
+  int E;
 
-  if (!(nblur && sbp && nin && kind)) {
-    biffAddf(GAGE, "%s: got NULL pointer", me);
-    return 1;
+  mop = airMopNew();
+  nman = nrrdNew();
+  airMopAdd(mop, nman, (airMopper)nrrdNuke, airMopAlways);
+  nio = nrrdIoStateNew();
+  airMopAdd(mop, nio, (airMopper)nrrdIoStateNix, airMopAlways);
+  E = 0;
+  if (!E) E |= nrrdMaybeAlloc_va(nman, nrrdTypeDouble, 1,
+                                 AIR_CAST(size_t, sbp->num));
+  if (!E) {
+    memcpy(nman->data, sbp->sigma, sbp->num*sizeof(double));
+    E |= nrrdKeyValueAdd(nman, _blurKey[0], "manifest");
+  }
+  for (kvpIdx=1; kvpIdx<KVP_NUM; kvpIdx++) {
+    if (KVP_SCALE_IDX == kvpIdx
+        || (KVP_DGGSM_IDX == kvpIdx && !dggsmSave)) {
+      continue;
+    }
+    if (!E) E |= nrrdKeyValueAdd(nman, _blurKey[kvpIdx],
+                                 blurVal[0].val[kvpIdx]);
   }
-  if (gageStackBlurParmCheck(sbp)) {
-    biffAddf(GAGE, "%s: problem with parms", me);
-    return 1;
+  /* it's small, and may as well be readable */
+  if (!E) E |= nrrdIoStateEncodingSet(nio, nrrdEncodingAscii);
+  if (!E) E |= nrrdSave(mname, nman, nio);
+  if (E) {
+    biffMovef(GAGE, NRRD, "%s: trouble saving manifest \"%s\"", me, mname);
+    airMopError(mop); return 1;
   }
-  if (_checkNrrd(nblur, NULL, sbp->num, AIR_FALSE, nin, kind)) {
-    biffAddf(GAGE, "%s: problem with input ", me);
-    return 1;
+  airMopOkay(mop);
+  return 0;
+}
+
+/*
+** sets *matchP to whether the manifest mname describes the blurrings
+** that sbp would produce from the input (with KVPs blurVal); if not,
+** explain says why.  As with _stackBlurCheck, what kind of blurring was
+** done only matters if sbp->needSpatialBlur
+*/
+static int
+_stackBlurManifestCheck(int *matchP, char explain[AIR_STRLEN_LARGE],
+                        const char *mname, gageStackBlurParm *sbp,
+                        const blurVal_t *blurVal) {
+  static const char me[]="_stackBlurManifestCheck";
+  Nrrd *nman;
+  unsigned int kvpIdx, si;
+  /* the manifest values can be any length, so each string in explain is
+     truncated to this, which fits the three of them with room to spare */
+  int strLen = AIR_STRLEN_LARGE/4;
+  const double *sig;
+  airArray *mop;
+  char *tmpval;
+
+  mop = airMopNew();
+  nman = nrrdNew();
+  airMopAdd(mop, nman, (airMopper)nrrdNuke, airMopAlways);
+  if (nrrdLoad(nman, mname, NULL)) {
+    biffMovef(GAGE, NRRD, "%s: couldn't read manifest \"%s\"", me, mname);
+    airMopError(mop); return 1;
   }
+  *matchP = AIR_FALSE;
+  if (!( nrrdTypeDouble == nman->type && 1 == nman->dim
+         && sbp->num == nman->axis[0].size )) {
+    sprintf(explain, "manifest doesn't hold %u doubles", sbp->num);
+    airMopOkay(mop); return 0;
+  }
+  sig = AIR_CAST(const double *, nman->data);
+  for (si=0; si<sbp->num; si++) {
+    if (sig[si] != sbp->sigma[si]) {
+      sprintf(explain, "manifest sigma[%u] %.17g != wanted %.17g",
+              si, sig[si], sbp->sigma[si]);
+      airMopOkay(mop); return 0;
+    }
+  }
+  for (kvpIdx=0; kvpIdx<KVP_NUM; kvpIdx++) {
+    if (KVP_SCALE_IDX == kvpIdx
+        || ((KVP_SBLUR_IDX == kvpIdx || KVP_DGGSM_IDX == kvpIdx)
+            && !sbp->needSpatialBlur)) {
+      continue;
+    }
+    tmpval = nrrdKeyValueGet(nman, _blurKey[kvpIdx]);
+    airMopAdd(mop, tmpval, airFree, airMopAlways);
+    if (KVP_DGGSM_IDX == kvpIdx && !tmpval) {
+      /* not saved when not needed */
+      continue;
+    }
+    if (!tmpval || strcmp(tmpval, (kvpIdx
+                                   ? blurVal[0].val[kvpIdx]
+                                   : "manifest"))) {
+      sprintf(explain, "manifest key[%.*s] \"%.*s\" != wanted \"%.*s\"",
+              strLen, _blurKey[kvpIdx],
+              strLen, tmpval ? tmpval : "(not set)",
+              strLen, kvpIdx ? blurVal[0].val[kvpIdx] : "manifest");
+      airMopOkay(mop); return 0;
+    }
+  }
+  *matchP = AIR_TRUE;
+  airMopOkay(mop);
+  return 0;
+}
+
+/*
+** does the work of gageStackBlur and gageStackBlurStream; with non-NULL
+** format, each blurring is saved as soon as it is done, and with !keep,
+** it is then emptied
+*/
+static int
+_stackBlur(Nrrd *const nblur[], gageStackBlurParm *sbp,
+           const char *format, NrrdIoState *nio, int keep,
+           unsigned int cksum, const Nrrd *nin, const gageKind *kind) {
+  static const char me[]="_stackBlur";
+  NrrdKernelSpec *kssb;
+  blurVal_t *blurVal;
+  _stackBlurOut_t sbo;
+  airArray *mop;
+  char *mname;
+  int fftable, spatialBlurred;
+
   mop = airMopNew();
   kssb = nrrdKernelSpecCopy(sbp->kspec);
   airMopAdd(mop, kssb, (airMopper)nrrdKernelSpecNix, airMopAlways);
@@ -1411,13 +1906,41 @@ gageStackBlur(Nrrd *const nblur[], gageStackBlurParm *sbp,
   fftable = (!sbp->needSpatialBlur
              && nrrdBoundaryWrap == sbp->bspec->boundary
              && nrrdKernelDiscreteGaussian == sbp->kspec->kernel);
-  if (fftable && nrrdFFTWEnabled) {
+  spatialBlurred = !(fftable && nrrdFFTWEnabled);
+  /* the KVPs to document how these were blurred */
+  if (!( blurVal = _blurValAlloc(mop, sbp, kssb, cksum, spatialBlurred) )) {
+    biffAddf(GAGE, "%s: problem getting KVP buffer", me);
+    airMopError(mop); return 1;
+  }
+  if ((mname = _stackBlurManifestName(format))) {
+    airMopAdd(mop, mname, airFree, airMopAlways);
+    /* until all the new blurrings are saved, any old manifest is wrong */
+    remove(mname);
+  }
+  sbo.nblur = nblur;
+  sbo.blurVal = blurVal;
+  sbo.dggsmSave = (spatialBlurred
+                   && nrrdKernelDiscreteGaussian == kssb->kernel);
+  sbo.format = format;
+  sbo.nio = nio;
+  sbo.keep = keep;
+  if (format) {
+    sbo.fname = AIR_CALLOC(strlen(format) + AIR_STRLEN_SMALL, char);
+    if (!sbo.fname) {
+      biffAddf(GAGE, "%s: couldn't allocate fname", me);
+      airMopError(mop); return 1;
+    }
+    airMopAdd(mop, sbo.fname, airFree, airMopAlways);
+  } else {
+    sbo.fname = NULL;
+  }
+  sbo.mutex = NULL;
+  if (!spatialBlurred) {
     /* go directly to FFT-based blurring */
-    if (_stackBlurDiscreteGaussFFT(nblur, sbp, nin, kind)) {
+    if (_stackBlurDiscreteGaussFFT(&sbo, sbp, nin, kind)) {
       biffAddf(GAGE, "%s: trouble with frequency-space blurring", me);
       airMopError(mop); return 1;
     }
-    spatialBlurred = AIR_FALSE;
   } else { /* else either not fft-able, or not it was, but not available;
               in either case we have to do spatial blurring */
     if (fftable && !nrrdFFTWEnabled) {
@@ -1428,43 +1951,20 @@ gageStackBlur(Nrrd *const nblur[], gageStackBlurParm *sbp,
     } else {
       if (sbp->verbose) {
         char kstr[AIR_STRLEN_LARGE], bstr[AIR_STRLEN_LARGE];
-        nrrdKernelSpecSprint(kstr, kssb);
+        nrrdKernelSpecSprint(kstr, sbp->kspec);
         nrrdBoundarySpecSprint(bstr, sbp->bspec);
         fprintf(stderr, "%s: (FFT-based blurring not applicable: "
                 "need spatial blur=%s, boundary=%s, kernel=%s)\n", me,
                 sbp->needSpatialBlur ? "yes" : "no", bstr, kstr);
       }
     }
-    if (_stackBlurSpatial(nblur, sbp, kssb, nin, kind)) {
+    if (_stackBlurSpatial(&sbo, sbp, kssb, nin, kind)) {
       biffAddf(GAGE, "%s: trouble with spatial-domain blurring", me);
       airMopError(mop); return 1;
     }
-    spatialBlurred = AIR_TRUE;
   }
-  /* add the KVPs to document how these were blurred */
-  if (!( blurVal = _blurValAlloc(mop, sbp, kssb, nin, spatialBlurred) )) {
-    biffAddf(GAGE, "%s: problem getting KVP buffer", me);
-    airMopError(mop); return 1;
-  }
-  E = 0;
-  for (blIdx=0; blIdx<sbp->num; blIdx++) {
-    for (kvpIdx=0; kvpIdx<KVP_NUM; kvpIdx++) {
-      if (KVP_DGGSM_IDX != kvpIdx) {
-        if (!E) E |= nrrdKeyValueAdd(nblur[blIdx], _blurKey[kvpIdx],
-                                     blurVal[blIdx].val[kvpIdx]);
-      } else {
-        /* only need to save dgGoodSigmaMax if it was spatially blurred
-           with the discrete gaussian kernel */
-        if (spatialBlurred
-            && nrrdKernelDiscreteGaussian == kssb->kernel) {
-          if (!E) E |= nrrdKeyValueAdd(nblur[blIdx], _blurKey[kvpIdx],
-                                       blurVal[blIdx].val[kvpIdx]);
-        }
-      }
-    }
-  }
-  if (E) {
-    biffMovef(GAGE, NRRD, "%s: trouble adding KVPs", me);
+  if (mname && _stackBlurManifestSave(mname, sbp, blurVal, sbo.dggsmSave)) {
+    biffAddf(GAGE, "%s: trouble saving manifest", me);
     airMopError(mop); return 1;
   }
 
@@ -1473,39 +1973,142 @@ gageStackBlur(Nrrd *const nblur[], gageStackBlurParm *sbp,
 }
 
 /*
-******** gageStackBlurCheck
+** little helper function to do pre-blurring of a given nrrd
+** of the sort that might be useful for scale-space gage use
 **
-** (docs)
+** nblur has to already be allocated for "blNum" Nrrd*s, AND, they all
+** have to point to valid (possibly empty) Nrrds, so they can hold the
+** results of blurring
+*/
+int
+gageStackBlur(Nrrd *const nblur[], gageStackBlurParm *sbp,
+              const Nrrd *nin, const gageKind *kind) {
+  static const char me[]="gageStackBlur";
+
+  if (!(nblur && sbp && nin && kind)) {
+    biffAddf(GAGE, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (gageStackBlurParmCheck(sbp)) {
+    biffAddf(GAGE, "%s: problem with parms", me);
+    return 1;
+  }
+  if (_checkNrrd(nblur, NULL, sbp->num, AIR_FALSE, nin, kind)) {
+    biffAddf(GAGE, "%s: problem with input ", me);
+    return 1;
+  }
+  if (_stackBlur(nblur, sbp, NULL, NULL, AIR_TRUE,
+                 nrrdCRC32(nin, airEndianLittle), nin, kind)) {
+    biffAddf(GAGE, "%s: trouble blurring", me);
+    return 1;
+  }
+  return 0;
+}
+
+/*
+** sets *nioP to NULL if enc is NULL, and otherwise to a new NrrdIoState
+** (owned by mop) that will save with encoding enc
+*/
+static int
+_stackBlurIoStateSet(NrrdIoState **nioP, airArray *mop, NrrdEncoding *enc) {
+  static const char me[]="_stackBlurIoStateSet";
+
+  if (!enc) {
+    *nioP = NULL;
+    return 0;
+  }
+  if (!enc->available()) {
+    biffAddf(GAGE, "%s: requested %s encoding which is not "
+             "available in this build", me, enc->name);
+    return 1;
+  }
+  *nioP = nrrdIoStateNew();
+  airMopAdd(mop, *nioP, (airMopper)nrrdIoStateNix, airMopAlways);
+  if (nrrdIoStateEncodingSet(*nioP, enc)) {
+    biffMovef(GAGE, NRRD, "%s: trouble setting encoding", me);
+    return 1;
+  }
+  return 0;
+}
+
+/*
+******** gageStackBlurStream
 **
+** like gageStackBlur, but instead of returning the blurrings, saves
+** each one (to the filename made by sprintf'ing the blurring index into
+** format, as with gageStackBlurGet) as soon as it has been computed,
+** so that only one blurring (per thread) is ever held in memory.
+** The manifest (see gageStackBlurGet) is saved last.
+** With a NULL enc, the default encoding is used.
 */
 int
-gageStackBlurCheck(const Nrrd *const nblur[],
-                   gageStackBlurParm *sbp,
-                   const Nrrd *nin, const gageKind *kind) {
-  static const char me[]="gageStackBlurCheck";
-  gageShape *shapeOld, *shapeNew;
-  blurVal_t *blurVal;
+gageStackBlurStream(gageStackBlurParm *sbp, const char *format,
+                    NrrdEncoding *enc,
+                    const Nrrd *nin, const gageKind *kind) {
+  static const char me[]="gageStackBlurStream";
+  Nrrd **nblur;
+  NrrdIoState *nio;
+  unsigned int ii;
   airArray *mop;
-  unsigned int blIdx, kvpIdx;
-  NrrdKernelSpec *kssb;
 
-  if (!(nblur && sbp && nin && kind)) {
+  if (!(sbp && format && nin && kind)) {
     biffAddf(GAGE, "%s: got NULL pointer", me);
     return 1;
   }
+  if (!strchr(format, '%')) {
+    biffAddf(GAGE, "%s: given format \"%s\" doesn't seem to have a "
+             "conversion specification for the blurring index", me, format);
+    return 1;
+  }
+  if (gageStackBlurParmCheck(sbp)) {
+    biffAddf(GAGE, "%s: problem with parms", me);
+    return 1;
+  }
   mop = airMopNew();
-  kssb = nrrdKernelSpecCopy(sbp->kspec);
-  airMopAdd(mop, kssb, (airMopper)nrrdKernelSpecNix, airMopAlways);
-  if (gageStackBlurParmCheck(sbp)
-      || _checkNrrd(NULL, nblur, sbp->num, AIR_TRUE, nin, kind)
-      || (!( blurVal = _blurValAlloc(mop, sbp, kssb, nin,
-                                     (sbp->needSpatialBlur
-                                      ? AIR_TRUE
-                                      : AIR_FALSE)) )) ) {
-    biffAddf(GAGE, "%s: problem", me);
+  nblur = AIR_CALLOC(sbp->num, Nrrd *);
+  if (!nblur) {
+    biffAddf(GAGE, "%s: couldn't alloc %u Nrrd*s", me, sbp->num);
+    airMopError(mop); return 1;
+  }
+  airMopAdd(mop, nblur, airFree, airMopAlways);
+  for (ii=0; ii<sbp->num; ii++) {
+    nblur[ii] = nrrdNew();
+    airMopAdd(mop, nblur[ii], (airMopper)nrrdNuke, airMopAlways);
+  }
+  if (_checkNrrd(nblur, NULL, sbp->num, AIR_FALSE, nin, kind)) {
+    biffAddf(GAGE, "%s: problem with input ", me);
+    airMopError(mop); return 1;
+  }
+  if (_stackBlurIoStateSet(&nio, mop, enc)
+      || _stackBlur(nblur, sbp, format, nio, AIR_FALSE,
+                    nrrdCRC32(nin, airEndianLittle), nin, kind)) {
+    biffAddf(GAGE, "%s: trouble blurring", me);
     airMopError(mop); return 1;
   }
 
+  airMopOkay(mop);
+  return 0;
+}
+
+/*
+** checks nblur against the blurrings that sbp would produce from nin,
+** with KVPs blurVal (from _blurValAlloc with spatialBlurred set to
+** sbp->needSpatialBlur)
+*/
+static int
+_stackBlurCheck(const Nrrd *const nblur[], gageStackBlurParm *sbp,
+                const blurVal_t *blurVal,
+                const Nrrd *nin, const gageKind *kind) {
+  static const char me[]="_stackBlurCheck";
+  gageShape *shapeOld, *shapeNew;
+  airArray *mop;
+  unsigned int blIdx, kvpIdx;
+
+  if (_checkNrrd(NULL, nblur, sbp->num, AIR_TRUE, nin, kind)) {
+    biffAddf(GAGE, "%s: problem", me);
+    return 1;
+  }
+  mop = airMopNew();
   shapeNew = gageShapeNew();
   airMopAdd(mop, shapeNew, (airMopper)gageShapeNix, airMopAlways);
   if (gageShapeSet(shapeNew, nin, kind->baseDim)) {
@@ -1583,15 +2186,60 @@ gageStackBlurCheck(const Nrrd *const nblur[],
   return 0;
 }
 
+/*
+******** gageStackBlurCheck
+**
+** checks that nblur are the blurrings that sbp would produce from nin:
+** same type and shape as nin, and with KVPs (as added by gageStackBlur)
+** that document the same blurring of the same data
+*/
 int
-gageStackBlurGet(Nrrd *const nblur[], int *recomputedP,
-                 gageStackBlurParm *sbp,
-                 const char *format,
-                 const Nrrd *nin, const gageKind *kind) {
+gageStackBlurCheck(const Nrrd *const nblur[],
+                   gageStackBlurParm *sbp,
+                   const Nrrd *nin, const gageKind *kind) {
+  static const char me[]="gageStackBlurCheck";
+  blurVal_t *blurVal;
+  airArray *mop;
+  NrrdKernelSpec *kssb;
+
+  if (!(nblur && sbp && nin && kind)) {
+    biffAddf(GAGE, "%s: got NULL pointer", me);
+    return 1;
+  }
+  mop = airMopNew();
+  kssb = nrrdKernelSpecCopy(sbp->kspec);
+  airMopAdd(mop, kssb, (airMopper)nrrdKernelSpecNix, airMopAlways);
+  if (gageStackBlurParmCheck(sbp)
+      || (!( blurVal = _blurValAlloc(mop, sbp, kssb,
+                                     nrrdCRC32(nin, airEndianLittle),
+                                     (sbp->needSpatialBlur
+                                      ? AIR_TRUE
+                                      : AIR_FALSE)) ))
+      || _stackBlurCheck(nblur, sbp, blurVal, nin, kind)) {
+    biffAddf(GAGE, "%s: problem", me);
+    airMopError(mop); return 1;
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
+
+/*
+** does the work of gageStackBlurGet; if the blurrings have to be
+** recomputed, and save is non-zero, each blurring is saved (via nio)
+** as soon as it has been computed, followed by the manifest
+*/
+static int
+_stackBlurGet(Nrrd *const nblur[], int *recomputedP,
+              gageStackBlurParm *sbp,
+              const char *format, int save, NrrdIoState *nio,
+              const Nrrd *nin, const gageKind *kind) {
   static const char me[]="gageStackBlurGet";
   airArray *mop;
   int recompute;
-  unsigned int ii;
+  unsigned int ii, cksum;
+  NrrdKernelSpec *kssb;
+  blurVal_t *blurVal;
 
 
   if (!( nblur && sbp && nin && kind )) {
@@ -1608,7 +2256,22 @@ gageStackBlurGet(Nrrd *const nblur[], int *recomputedP,
     biffAddf(GAGE, "%s: trouble with blur parms", me);
     return 1;
   }
+  if (_checkNrrd(nblur, NULL, sbp->num, AIR_FALSE, nin, kind)) {
+    biffAddf(GAGE, "%s: problem with input ", me);
+    return 1;
+  }
   mop = airMopNew();
+  /* the checksum is computed once, for checking and for re-computing */
+  cksum = nrrdCRC32(nin, airEndianLittle);
+  kssb = nrrdKernelSpecCopy(sbp->kspec);
+  airMopAdd(mop, kssb, (airMopper)nrrdKernelSpecNix, airMopAlways);
+  if (!( blurVal = _blurValAlloc(mop, sbp, kssb, cksum,
+                                 (sbp->needSpatialBlur
+                                  ? AIR_TRUE
+                                  : AIR_FALSE)) )) {
+    biffAddf(GAGE, "%s: problem getting KVP buffer", me);
+    airMopError(mop); return 1;
+  }
 
   /* set recompute flag */
   if (!airStrlen(format)) {
@@ -1618,8 +2281,8 @@ gageStackBlurGet(Nrrd *const nblur[], int *recomputedP,
     }
     recompute = AIR_TRUE;
   } else {
-    char *fname, *suberr;
-    int firstExists;
+    char *fname, *mname, *suberr, explain[AIR_STRLEN_LARGE];
+    int firstExists, manExists, manMatch=AIR_FALSE;
     FILE *file;
     /* do have info about files to load, but may fail in many ways */
     fname = AIR_CALLOC(strlen(format) + AIR_STRLEN_SMALL, char);
@@ -1632,7 +2295,30 @@ gageStackBlurGet(Nrrd *const nblur[], int *recomputedP,
     sprintf(fname, format, 0);
     firstExists = !!(file = fopen(fname, "r"));
     airFclose(file);
-    if (!firstExists) {
+    /* see if there's a manifest, which can tell us without reading
+       any blurrings whether they can be re-used */
+    if ((mname = _stackBlurManifestName(format))) {
+      airMopAdd(mop, mname, airFree, airMopAlways);
+      manExists = !!(file = fopen(mname, "r"));
+      airFclose(file);
+    } else {
+      manExists = AIR_FALSE;
+    }
+    if (manExists
+        && _stackBlurManifestCheck(&manMatch, explain, mname, sbp, blurVal)) {
+      airMopAdd(mop, suberr = biffGetDone(GAGE), airFree, airMopAlways);
+      if (sbp->verbose) {
+        fprintf(stderr, "%s: will recompute blurrings with unreadable "
+                "manifest:\n%s\n", me, suberr);
+      }
+      recompute = AIR_TRUE;
+    } else if (manExists && !manMatch) {
+      if (sbp->verbose) {
+        fprintf(stderr, "%s: will recompute blurrings (from \"%s\") "
+                "that don't match: %s\n", me, format, explain);
+      }
+      recompute = AIR_TRUE;
+    } else if (!firstExists) {
       if (sbp->verbose) {
         fprintf(stderr, "%s: no file \"%s\"; will recompute blurrings\n",
                 me, fname);
@@ -1645,8 +2331,8 @@ gageStackBlurGet(Nrrd *const nblur[], int *recomputedP,
                 "read:\n%s\n", me, suberr);
       }
       recompute = AIR_TRUE;
-    } else if (gageStackBlurCheck(AIR_CAST(const Nrrd*const*, nblur),
-                                  sbp, nin, kind)) {
+    } else if (_stackBlurCheck(AIR_CAST(const Nrrd*const*, nblur),
+                               sbp, blurVal, nin, kind)) {
       airMopAdd(mop, suberr = biffGetDone(GAGE), airFree, airMopAlways);
       if (sbp->verbose) {
         fprintf(stderr, "%s: will recompute blurrings (from \"%s\") "
@@ -1663,7 +2349,8 @@ gageStackBlurGet(Nrrd *const nblur[], int *recomputedP,
     }
   }
   if (recompute) {
-    if (gageStackBlur(nblur, sbp, nin, kind)) {
+    if (_stackBlur(nblur, sbp, save ? format : NULL, nio, AIR_TRUE,
+                   cksum, nin, kind)) {
       biffAddf(GAGE, "%s: trouble computing blurrings", me);
       airMopError(mop); return 1;
     }
@@ -1676,12 +2363,40 @@ gageStackBlurGet(Nrrd *const nblur[], int *recomputedP,
   return 0;
 }
 
+/*
+******** gageStackBlurGet
+**
+** sets nblur to the blurrings of nin described by sbp, either by
+** loading them from the files named by sprintf'ing the blurring index
+** into format, or (if there are no such files, or they don't match) by
+** computing them.  If there is a manifest for format (the same name with
+** "manifest" in place of the conversion specification, as saved by
+** gageStackBlurManage and gageStackBlurStream), it alone determines
+** whether the files are worth reading: a mismatch in the input checksum
+** or the blurring parameters means re-computing right away.
+*/
+int
+gageStackBlurGet(Nrrd *const nblur[], int *recomputedP,
+                 gageStackBlurParm *sbp,
+                 const char *format,
+                 const Nrrd *nin, const gageKind *kind) {
+  static const char me[]="gageStackBlurGet";
+
+  if (_stackBlurGet(nblur, recomputedP, sbp, format, AIR_FALSE, NULL,
+                    nin, kind)) {
+    biffAddf(GAGE, "%s: trouble", me);
+    return 1;
+  }
+  return 0;
+}
+
 /*
 ******** gageStackBlurManage
 **
 ** does the work of gageStackBlurGet and then some:
-** allocates the array of Nrrds, allocates an array of doubles for scale,
-** and saves output if recomputed
+** allocates the array of Nrrds, and if the blurrings had to be
+** recomputed (and saveIfComputed), saves each one (with encoding enc,
+** if non-NULL) as soon as it has been computed
 */
 int
 gageStackBlurManage(Nrrd ***nblurP, int *recomputedP,
@@ -1691,9 +2406,10 @@ gageStackBlurManage(Nrrd ***nblurP, int *recomputedP,
                     const Nrrd *nin, const gageKind *kind) {
   static const char me[]="gageStackBlurManage";
   Nrrd **nblur;
+  NrrdIoState *nio;
   unsigned int ii;
   airArray *mop;
-  int recomputed;
+  int recomputed, save;
 
   if (!( nblurP && sbp && nin && kind )) {
     biffAddf(GAGE, "%s: got NULL pointer", me);
@@ -1712,37 +2428,19 @@ gageStackBlurManage(Nrrd ***nblurP, int *recomputedP,
     nblur[ii] = nrrdNew();
     airMopAdd(mop, nblur[ii], (airMopper)nrrdNuke, airMopOnError);
   }
-  if (gageStackBlurGet(nblur, &recomputed, sbp, format, nin, kind)) {
+  save = airStrlen(format) && saveIfComputed;
+  if (_stackBlurIoStateSet(&nio, mop, save ? enc : NULL)) {
+    biffAddf(GAGE, "%s: trouble setting up saving", me);
+    airMopError(mop); return 1;
+  }
+  if (_stackBlurGet(nblur, &recomputed, sbp, format, save, nio,
+                    nin, kind)) {
     biffAddf(GAGE, "%s: trouble getting nblur", me);
     airMopError(mop); return 1;
   }
   if (recomputedP) {
     *recomputedP = recomputed;
   }
-  if (recomputed && format && saveIfComputed) {
-    NrrdIoState *nio;
-    int E;
-    E = 0;
-    if (enc) {
-      if (!enc->available()) {
-        biffAddf(GAGE, "%s: requested %s encoding which is not "
-                 "available in this build", me, enc->name);
-        airMopError(mop); return 1;
-      }
-      nio = nrrdIoStateNew();
-      airMopAdd(mop, nio, (airMopper)nrrdIoStateNix, airMopAlways);
-      if (!E) E |= nrrdIoStateEncodingSet(nio, nrrdEncodingGzip);
-    } else {
-      nio = NULL;
-    }
-    if (!E) E |= nrrdSaveMulti(format, AIR_CAST(const Nrrd *const *,
-                                                nblur),
-                               sbp->num, 0, nio);
-    if (E) {
-      biffMovef(GAGE, NRRD, "%s: trouble saving blurrings", me);
-      airMopError(mop); return 1;
-    }
-  }
 
   airMopOkay(mop);
   return 0;
@@ -0,0 +1,754 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "gage.h"
+#include "privateGage.h"
+
+/* same as in brick.c */
+#define _GAGE_BRICK_SHIFT_MAX 8
+
+/*
+** _gageLazyKernelWeights
+**
+** allocates in *wP the weights of kernel kern (with parm) at the sample
+** offsets that nrrdResample uses when not changing the sampling: offset
+** oo (from *loP to *loP + *lenP - 1) gets weight kern(-oo), and the
+** weights are renormalized as nrrdResample does.  Sets in *integralP the
+** integral of the kernel.
+*/
+static int
+_gageLazyKernelWeights(double **wP, int *loP, unsigned int *lenP,
+                       double *integralP,
+                       const NrrdKernel *kern, const double *parm,
+                       int renormalize) {
+  static const char me[]="_gageLazyKernelWeights";
+  unsigned int wi, len;
+  double sum, *ww;
+
+  len = AIR_CAST(unsigned int, 2*ceil(kern->support(parm)));
+  len = AIR_MAX(2, len);
+  if (!( ww = AIR_CALLOC(len, double) )) {
+    biffAddf(GAGE, "%s: couldn't allocate %u weights", me, len);
+    return 1;
+  }
+  *loP = 1 - AIR_CAST(int, len/2);
+  sum = 0;
+  for (wi=0; wi<len; wi++) {
+    ww[wi] = kern->eval1_d(-(*loP + AIR_CAST(double, wi)), parm);
+    sum += ww[wi];
+  }
+  *integralP = kern->integral(parm);
+  if (renormalize && *integralP && sum) {
+    for (wi=0; wi<len; wi++) {
+      ww[wi] /= sum;
+    }
+  }
+  *wP = ww;
+  *lenP = len;
+  return 0;
+}
+
+/*
+** _gageLazyConvolve
+**
+** replaces the weights (*wP, *loP, *lenP) with their convolution with
+** (ww, lo, len)
+*/
+static int
+_gageLazyConvolve(double **wP, int *loP, unsigned int *lenP,
+                  const double *ww, int lo, unsigned int len) {
+  static const char me[]="_gageLazyConvolve";
+  unsigned int ii, jj, clen;
+  double *cw;
+
+  clen = *lenP + len - 1;
+  if (!( cw = AIR_CALLOC(clen, double) )) {
+    biffAddf(GAGE, "%s: couldn't allocate %u weights", me, clen);
+    return 1;
+  }
+  for (ii=0; ii<*lenP; ii++) {
+    for (jj=0; jj<len; jj++) {
+      cw[ii + jj] += (*wP)[ii]*ww[jj];
+    }
+  }
+  airFree(*wP);
+  *wP = cw;
+  *loP += lo;
+  *lenP = clen;
+  return 0;
+}
+
+/*
+** _gageLazyWeightsSet
+**
+** sets lazy->wlo, wlen, weight, and integral, following what
+** _stackBlurSpatial() in stackBlur.c does
+*/
+static int
+_gageLazyWeightsSet(gageStackLazy *lazy, const gageStackBlurParm *sbp) {
+  static const char me[]="_gageLazyWeightsSet";
+  NrrdKernelSpec *kssb;
+  double *pw, pint, timeStepMax, timeDone, timeLeft, timeNow, timeDo;
+  unsigned int bi, plen, clen;
+  int plo, clo;
+  airArray *mop;
+
+  mop = airMopNew();
+  kssb = nrrdKernelSpecCopy(sbp->kspec);
+  airMopAdd(mop, kssb, (airMopper)nrrdKernelSpecNix, airMopAlways);
+  if (nrrdKernelDiscreteGaussian == kssb->kernel) {
+    /* gageStackBlur() diffuses iteratively, each blurring continuing
+       from the last, which is mimicked by convolving the weights of all
+       the iterations so far into (clo, clen, cw) */
+    double *cw;
+    clo = 0;
+    clen = 1;
+    if (!( cw = AIR_CALLOC(1, double) )) {
+      biffAddf(GAGE, "%s: couldn't allocate weight", me);
+      airMopError(mop); return 1;
+    }
+    cw[0] = 1;
+    pint = 1;
+    timeDone = 0;
+    timeStepMax = (sbp->dgGoodSigmaMax)*(sbp->dgGoodSigmaMax);
+    for (bi=0; bi<lazy->num; bi++) {
+      timeNow = sbp->sigma[bi]*sbp->sigma[bi];
+      timeLeft = timeNow - timeDone;
+      do {
+        double iint;
+        timeDo = (timeLeft > timeStepMax
+                  ? timeStepMax
+                  : timeLeft);
+        kssb->parm[0] = sqrt(timeDo);
+        if (_gageLazyKernelWeights(&pw, &plo, &plen, &iint,
+                                   kssb->kernel, kssb->parm,
+                                   sbp->renormalize)) {
+          airFree(cw);
+          biffAddf(GAGE, "%s: trouble on blurring %u", me, bi);
+          airMopError(mop); return 1;
+        }
+        if (_gageLazyConvolve(&cw, &clo, &clen, pw, plo, plen)) {
+          airFree(pw);
+          airFree(cw);
+          biffAddf(GAGE, "%s: trouble on blurring %u", me, bi);
+          airMopError(mop); return 1;
+        }
+        airFree(pw);
+        pint *= iint;
+        timeLeft -= timeDo;
+      } while (timeLeft > 0.0);
+      timeDone = timeNow;
+      if (!( lazy->weight[bi] = AIR_CALLOC(clen, double) )) {
+        airFree(cw);
+        biffAddf(GAGE, "%s: couldn't allocate weights %u", me, bi);
+        airMopError(mop); return 1;
+      }
+      memcpy(lazy->weight[bi], cw, clen*sizeof(double));
+      lazy->wlo[bi] = clo;
+      lazy->wlen[bi] = clen;
+      lazy->integral[bi] = pint;
+    }
+    airFree(cw);
+  } else {
+    for (bi=0; bi<lazy->num; bi++) {
+      kssb->parm[0] = sbp->sigma[bi];
+      if (_gageLazyKernelWeights(lazy->weight + bi, lazy->wlo + bi,
+                                 lazy->wlen + bi, lazy->integral + bi,
+                                 kssb->kernel, kssb->parm,
+                                 sbp->renormalize)) {
+        biffAddf(GAGE, "%s: trouble on blurring %u", me, bi);
+        airMopError(mop); return 1;
+      }
+    }
+  }
+  airMopOkay(mop);
+  return 0;
+}
+
+/*
+******** gageStackLazyNew
+**
+** sets up the lazy computation of the blurrings of nin (of the given
+** kind) described by sbp, in bricks that are 2^brickShift samples on
+** edge, with values stored according to store (from the gageStore*
+** enum).  No bricks are computed here.  The returned struct has to be
+** freed (with gageStackLazyNix()) only after all the pervolumes using it.
+*/
+gageStackLazy *
+gageStackLazyNew(const Nrrd *nin, const gageKind *kind,
+                 const gageStackBlurParm *sbp, unsigned int brickShift,
+                 int store) {
+  static const char me[]="gageStackLazyNew";
+  gageStackLazy *lazy;
+  unsigned int ai, bi, bmask;
+  size_t bnum;
+  airArray *mop;
+
+  if (!( nin && kind && sbp )) {
+    biffAddf(GAGE, "%s: got NULL pointer", me);
+    return NULL;
+  }
+  if (gageKindVolumeCheck(kind, nin)) {
+    biffAddf(GAGE, "%s: problem with volume as %s kind", me, kind->name);
+    return NULL;
+  }
+  if (gageStackBlurParmCheck(sbp)) {
+    biffAddf(GAGE, "%s: problem with blurring parms", me);
+    return NULL;
+  }
+  if (!( 1 <= brickShift && brickShift <= _GAGE_BRICK_SHIFT_MAX )) {
+    biffAddf(GAGE, "%s: brickShift %u not in range [1,%u]", me,
+             brickShift, _GAGE_BRICK_SHIFT_MAX);
+    return NULL;
+  }
+  if (airEnumValCheck(gageStore, store)) {
+    biffAddf(GAGE, "%s: store %d not valid", me, store);
+    return NULL;
+  }
+  if (nrrdBoundaryPad != sbp->bspec->boundary
+      && nrrdBoundaryBleed != sbp->bspec->boundary
+      && nrrdBoundaryWrap != sbp->bspec->boundary
+      && nrrdBoundaryMirror != sbp->bspec->boundary
+      && nrrdBoundaryWeight != sbp->bspec->boundary) {
+    biffAddf(GAGE, "%s: boundary %s not handled", me,
+             airEnumStr(nrrdBoundary, sbp->bspec->boundary));
+    return NULL;
+  }
+
+  mop = airMopNew();
+  lazy = AIR_CALLOC(1, gageStackLazy);
+  if (!lazy) {
+    biffAddf(GAGE, "%s: couldn't allocate struct", me);
+    airMopError(mop); return NULL;
+  }
+  airMopAdd(mop, lazy, (airMopper)gageStackLazyNix, airMopOnError);
+  lazy->nin = nin;
+  lazy->kind = kind;
+  lazy->num = sbp->num;
+  lazy->brickShift = brickShift;
+  bmask = (1u << brickShift) - 1;
+  bnum = 1;
+  for (ai=0; ai<3; ai++) {
+    lazy->size[ai] = AIR_CAST(unsigned int,
+                              nin->axis[kind->baseDim + ai].size);
+    lazy->bnum[ai] = (lazy->size[ai] + bmask) >> brickShift;
+    bnum *= lazy->bnum[ai];
+  }
+  lazy->store = store;
+  lazy->type = _gageStoreType(store, nin->type);
+  lazy->boundary = sbp->bspec->boundary;
+  lazy->padValue = sbp->bspec->padValue;
+  lazy->oneDim = sbp->oneDim;
+  lazy->range[0] = lazy->range[1] = AIR_NAN;
+  if (gageStoreQuant16 == store || gageStoreQuant8 == store) {
+    NrrdRange *range;
+    range = nrrdRangeNewSet(nin, AIR_FALSE);
+    airMopAdd(mop, range, (airMopper)nrrdRangeNix, airMopAlways);
+    if (range->hasNonExist) {
+      biffAddf(GAGE, "%s: can't quantize non-existent values", me);
+      airMopError(mop); return NULL;
+    }
+    lazy->range[0] = range->min;
+    lazy->range[1] = range->max;
+    if (nrrdBoundaryPad == lazy->boundary) {
+      lazy->range[0] = AIR_MIN(lazy->range[0], lazy->padValue);
+      lazy->range[1] = AIR_MAX(lazy->range[1], lazy->padValue);
+    }
+  }
+  _gageStoreRange(&(lazy->storeMin), &(lazy->storeStep), store,
+                  lazy->range[0], lazy->range[1]);
+  lazy->wlo = AIR_CALLOC(lazy->num, int);
+  lazy->wlen = AIR_CALLOC(lazy->num, unsigned int);
+  lazy->weight = AIR_CALLOC(lazy->num, double *);
+  lazy->integral = AIR_CALLOC(lazy->num, double);
+  lazy->brick = AIR_CALLOC(lazy->num, void **);
+  if (!( lazy->wlo && lazy->wlen && lazy->weight && lazy->integral
+         && lazy->brick )) {
+    biffAddf(GAGE, "%s: couldn't allocate per-blurring arrays", me);
+    airMopError(mop); return NULL;
+  }
+  for (bi=0; bi<lazy->num; bi++) {
+    if (!( lazy->brick[bi] = AIR_CALLOC(bnum, void *) )) {
+      biffAddf(GAGE, "%s: couldn't allocate %u brick pointers for "
+               "blurring %u", me, AIR_UINT(bnum), bi);
+      airMopError(mop); return NULL;
+    }
+  }
+  if (_gageLazyWeightsSet(lazy, sbp)) {
+    biffAddf(GAGE, "%s: trouble with kernel weights", me);
+    airMopError(mop); return NULL;
+  }
+  lazy->brickMade = 0;
+  if (!( lazy->mutex = airThreadMutexNew() )) {
+    biffAddf(GAGE, "%s: couldn't create brick mutex", me);
+    airMopError(mop); return NULL;
+  }
+
+  airMopOkay(mop);
+  return lazy;
+}
+
+gageStackLazy *
+gageStackLazyNix(gageStackLazy *lazy) {
+  unsigned int bi;
+  size_t ii, bnum;
+
+  if (lazy) {
+    bnum = (AIR_CAST(size_t, lazy->bnum[0])*lazy->bnum[1])*lazy->bnum[2];
+    for (bi=0; bi<lazy->num; bi++) {
+      if (lazy->weight) {
+        airFree(lazy->weight[bi]);
+      }
+      if (lazy->brick && lazy->brick[bi]) {
+        for (ii=0; ii<bnum; ii++) {
+          airFree(lazy->brick[bi][ii]);
+        }
+        airFree(lazy->brick[bi]);
+      }
+    }
+    airFree(lazy->wlo);
+    airFree(lazy->wlen);
+    airFree(lazy->weight);
+    airFree(lazy->integral);
+    airFree(lazy->brick);
+    if (lazy->mutex) {
+      airThreadMutexNix(lazy->mutex);
+    }
+    airFree(lazy);
+  }
+  return NULL;
+}
+
+/*
+******** gageStackLazyPerVolumeNew
+**
+** like gageStackPerVolumeNew(), but for a lazily computed stack: makes
+** lazy->num pervolumes in the given pvlStack (allocated by the caller),
+** each of which gets its values from one blurring of lazy.  These are
+** then attached with gageStackPerVolumeAttach(), with a base pervolume
+** of lazy->nin.
+*/
+int
+gageStackLazyPerVolumeNew(gageContext *ctx, gagePerVolume **pvlStack,
+                          gageStackLazy *lazy) {
+  static const char me[]="gageStackLazyPerVolumeNew";
+  gagePerVolume *pvl;
+  unsigned int bi;
+  size_t bnum;
+
+  if (!( ctx && pvlStack && lazy )) {
+    biffAddf(GAGE, "%s: got NULL pointer", me);
+    return 1;
+  }
+  bnum = (AIR_CAST(size_t, lazy->bnum[0])*lazy->bnum[1])*lazy->bnum[2];
+  for (bi=0; bi<lazy->num; bi++) {
+    if (!( pvl = gagePerVolumeNew(ctx, lazy->nin, lazy->kind) )) {
+      biffAddf(GAGE, "%s: on pvl %u of %u", me, bi, lazy->num);
+      return 1;
+    }
+    if (!( pvl->lazySeen = AIR_CALLOC(bnum, unsigned char) )) {
+      gagePerVolumeNix(pvl);
+      biffAddf(GAGE, "%s: couldn't allocate brick flags for pvl %u",
+               me, bi);
+      return 1;
+    }
+    pvl->lazy = lazy;
+    pvl->lazyIdx = bi;
+    pvl->store = lazy->store;
+    pvl->storeMin = lazy->storeMin;
+    pvl->storeStep = lazy->storeStep;
+    pvl->lup = (gageStoreHalf == lazy->store
+                ? _gageHalfLookup
+                : nrrdDLookup[lazy->type]);
+    pvlStack[bi] = pvl;
+  }
+  return 0;
+}
+
+/*
+** the index along an axis of the given size from which the value at
+** index jj is taken, or -1 when the value is the pad value (with
+** nrrdBoundaryPad), or when it isn't used (with nrrdBoundaryWeight)
+*/
+static int
+_gageLazyIndex(int jj, unsigned int size, int boundary) {
+  int ss, mm;
+
+  ss = AIR_CAST(int, size);
+  if (0 <= jj && jj < ss) {
+    return jj;
+  }
+  switch (boundary) {
+  case nrrdBoundaryBleed:
+    mm = AIR_CLAMP(0, jj, ss-1);
+    break;
+  case nrrdBoundaryWrap:
+    mm = AIR_MOD(jj, ss);
+    break;
+  case nrrdBoundaryMirror:
+    mm = (jj < 0 ? -jj : jj) % (2*ss);
+    mm = (mm >= ss ? 2*ss - 1 - mm : mm);
+    break;
+  default:
+    /* nrrdBoundaryPad, nrrdBoundaryWeight */
+    mm = -1;
+    break;
+  }
+  return mm;
+}
+
+/*
+** _gageLazyAxisWeights
+**
+** fills ww[pi + num*wi] with the weight, for output sample start + pi
+** along an axis of the given size, of the input sample at offset
+** lo + wi.  Only nrrdBoundaryWeight makes these vary with position.
+*/
+static void
+_gageLazyAxisWeights(double *ww, const gageStackLazy *lazy,
+                     const double *weight, int lo, unsigned int len,
+                     double integral, unsigned int start, unsigned int num,
+                     unsigned int size) {
+  unsigned int pi, wi;
+  int jj;
+  double sum;
+
+  for (pi=0; pi<num; pi++) {
+    sum = 0;
+    for (wi=0; wi<len; wi++) {
+      jj = AIR_CAST(int, start + pi) + lo + AIR_CAST(int, wi);
+      if (nrrdBoundaryWeight == lazy->boundary
+          && -1 == _gageLazyIndex(jj, size, lazy->boundary)) {
+        ww[pi + num*wi] = 0;
+      } else {
+        ww[pi + num*wi] = weight[wi];
+        sum += weight[wi];
+      }
+    }
+    if (nrrdBoundaryWeight == lazy->boundary && integral && sum) {
+      for (wi=0; wi<len; wi++) {
+        ww[pi + num*wi] *= integral/sum;
+      }
+    }
+  }
+  return;
+}
+
+/*
+** _gageLazyBrickCompute
+**
+** allocates and computes brick bidx of blurring bi, by separable
+** convolution: first along X for all the (Y,Z) scanlines needed (in xx),
+** then along Y for all the Z slices needed (in yy), and then along Z.
+** Out-of-volume scanlines and slices are handled according to the
+** boundary in the same way as in nrrdResample.  Returns NULL if
+** allocation failed.
+*/
+static void *
+_gageLazyBrickCompute(gageStackLazy *lazy, unsigned int bi, size_t bidx) {
+  const double *weight[3];
+  double *wax[3], *line, *xx, *yy, dwone, sum, val;
+  unsigned int ai, bedge, start[3], num[3], ext[3], len[3], valLen, vi,
+    pi, wi, ei, ej, xi, yi, zi;
+  int lo[3], ym, zm, jm;
+  size_t bcoord[3], lineLen, outIdx;
+  double (*lup)(const void *, size_t);
+  void *brick;
+  airArray *mop;
+
+  mop = airMopNew();
+  bedge = 1u << lazy->brickShift;
+  valLen = lazy->kind->valLen;
+  bcoord[0] = bidx % lazy->bnum[0];
+  bcoord[1] = (bidx/lazy->bnum[0]) % lazy->bnum[1];
+  bcoord[2] = bidx/(AIR_CAST(size_t, lazy->bnum[0])*lazy->bnum[1]);
+  dwone = 1;
+  lineLen = 0;
+  for (ai=0; ai<3; ai++) {
+    start[ai] = AIR_CAST(unsigned int, bcoord[ai]) << lazy->brickShift;
+    num[ai] = AIR_MIN(bedge, lazy->size[ai] - start[ai]);
+    if (!ai || !lazy->oneDim) {
+      weight[ai] = lazy->weight[bi];
+      lo[ai] = lazy->wlo[bi];
+      len[ai] = lazy->wlen[bi];
+    } else {
+      /* no blurring on this axis */
+      weight[ai] = &dwone;
+      lo[ai] = 0;
+      len[ai] = 1;
+    }
+    ext[ai] = num[ai] + len[ai] - 1;
+    lineLen = AIR_MAX(lineLen, ext[ai]);
+    wax[ai] = AIR_CALLOC(num[ai]*len[ai], double);
+    airMopAdd(mop, wax[ai], airFree, airMopAlways);
+    if (wax[ai]) {
+      _gageLazyAxisWeights(wax[ai], lazy, weight[ai], lo[ai], len[ai],
+                           (!ai || !lazy->oneDim ? lazy->integral[bi] : 1),
+                           start[ai], num[ai], lazy->size[ai]);
+    }
+  }
+  line = AIR_CALLOC(lineLen*valLen, double);
+  airMopAdd(mop, line, airFree, airMopAlways);
+  xx = AIR_CALLOC(valLen*num[0]*ext[1]*ext[2], double);
+  airMopAdd(mop, xx, airFree, airMopAlways);
+  yy = AIR_CALLOC(valLen*num[0]*num[1]*ext[2], double);
+  airMopAdd(mop, yy, airFree, airMopAlways);
+  brick = calloc((AIR_CAST(size_t, bedge)*bedge)*bedge*valLen,
+                 nrrdTypeSize[lazy->type]);
+  airMopAdd(mop, brick, airFree, airMopOnError);
+  if (!( wax[0] && wax[1] && wax[2] && line && xx && yy && brick )) {
+    airMopError(mop); return NULL;
+  }
+  lup = nrrdDLookup[lazy->nin->type];
+
+  /* along X, for every needed scanline; the (unused) out-of-volume ones
+     with nrrdBoundaryWeight are left at zero */
+  for (ej=0; ej<ext[2]; ej++) {
+    zm = _gageLazyIndex(AIR_CAST(int, start[2] + ej) + lo[2],
+                        lazy->size[2], lazy->boundary);
+    for (ei=0; ei<ext[1]; ei++) {
+      double *xrow;
+      xrow = xx + valLen*num[0]*(ei + ext[1]*ej);
+      ym = _gageLazyIndex(AIR_CAST(int, start[1] + ei) + lo[1],
+                          lazy->size[1], lazy->boundary);
+      if (-1 == ym || -1 == zm) {
+        if (nrrdBoundaryPad == lazy->boundary) {
+          for (pi=0; pi<valLen*num[0]; pi++) {
+            xrow[pi] = lazy->padValue;
+          }
+        }
+        continue;
+      }
+      /* the scanline, with boundary handling, as double */
+      for (wi=0; wi<ext[0]; wi++) {
+        jm = _gageLazyIndex(AIR_CAST(int, start[0] + wi) + lo[0],
+                            lazy->size[0], lazy->boundary);
+        for (vi=0; vi<valLen; vi++) {
+          line[vi + valLen*wi] =
+            (-1 == jm
+             ? (nrrdBoundaryPad == lazy->boundary ? lazy->padValue : 0)
+             : lup(lazy->nin->data,
+                   vi + valLen*(AIR_CAST(size_t, jm)
+                                + lazy->size[0]*(AIR_CAST(size_t, ym)
+                                                 + AIR_CAST(size_t,
+                                                            lazy->size[1])
+                                                 *zm))));
+        }
+      }
+      for (pi=0; pi<num[0]; pi++) {
+        for (vi=0; vi<valLen; vi++) {
+          sum = 0;
+          for (wi=0; wi<len[0]; wi++) {
+            sum += wax[0][pi + num[0]*wi]*line[vi + valLen*(pi + wi)];
+          }
+          xrow[vi + valLen*pi] = sum;
+        }
+      }
+    }
+  }
+  /* along Y, for every needed slice */
+  for (ej=0; ej<ext[2]; ej++) {
+    zm = _gageLazyIndex(AIR_CAST(int, start[2] + ej) + lo[2],
+                        lazy->size[2], lazy->boundary);
+    for (yi=0; yi<num[1]; yi++) {
+      double *yrow;
+      yrow = yy + valLen*num[0]*(yi + num[1]*ej);
+      for (pi=0; pi<valLen*num[0]; pi++) {
+        if (-1 == zm) {
+          yrow[pi] = (nrrdBoundaryPad == lazy->boundary
+                      ? lazy->padValue : 0);
+          continue;
+        }
+        sum = 0;
+        for (wi=0; wi<len[1]; wi++) {
+          sum += (wax[1][yi + num[1]*wi]
+                  *xx[pi + valLen*num[0]*(yi + wi + ext[1]*ej)]);
+        }
+        yrow[pi] = sum;
+      }
+    }
+  }
+  /* along Z, and storing the result */
+  for (zi=0; zi<num[2]; zi++) {
+    for (yi=0; yi<num[1]; yi++) {
+      for (xi=0; xi<num[0]; xi++) {
+        outIdx = valLen*(xi + bedge*(yi + AIR_CAST(size_t, bedge)*zi));
+        for (vi=0; vi<valLen; vi++) {
+          sum = 0;
+          for (wi=0; wi<len[2]; wi++) {
+            sum += (wax[2][zi + num[2]*wi]
+                    *yy[vi + valLen*(xi + num[0]*(yi + num[1]*(zi + wi)))]);
+          }
+          switch (lazy->store) {
+          case gageStoreHalf:
+            AIR_CAST(unsigned short *, brick)[outIdx + vi] =
+              airHalfFromFloat(AIR_CAST(float, sum));
+            break;
+          case gageStoreQuant16:
+          case gageStoreQuant8:
+            val = AIR_CLAMP(lazy->range[0], sum, lazy->range[1]);
+            nrrdDInsert[lazy->type](brick, outIdx + vi,
+                                    airIndex(lazy->range[0], val,
+                                             lazy->range[1]
+                                             + (lazy->range[0]
+                                                == lazy->range[1]),
+                                             (gageStoreQuant16 == lazy->store
+                                              ? 1u << 16 : 1u << 8)));
+            break;
+          default:
+            /* gageStoreFull, as nrrdResample would make it */
+            if (nrrdTypeIsIntegral[lazy->type]) {
+              sum = nrrdDClamp[lazy->type](floor(sum + 0.5));
+            }
+            nrrdDInsert[lazy->type](brick, outIdx + vi, sum);
+            break;
+          }
+        }
+      }
+    }
+  }
+  airMopOkay(mop);
+  return brick;
+}
+
+/*
+** _gageStackLazyBrickNeed
+**
+** makes sure that brick bidx of blurring bi is computed.  The computation
+** is done without holding the mutex, so that different bricks can be
+** computed by different threads at the same time; if another thread
+** finished the same brick first, its result is kept.  Returns non-zero
+** if the brick couldn't be allocated.
+*/
+static int
+_gageStackLazyBrickNeed(gageStackLazy *lazy, unsigned int bi, size_t bidx) {
+  void *data;
+
+  airThreadMutexLock(lazy->mutex);
+  data = lazy->brick[bi][bidx];
+  airThreadMutexUnlock(lazy->mutex);
+  if (data) {
+    return 0;
+  }
+  if (!( data = _gageLazyBrickCompute(lazy, bi, bidx) )) {
+    return 1;
+  }
+  airThreadMutexLock(lazy->mutex);
+  if (!lazy->brick[bi][bidx]) {
+    lazy->brick[bi][bidx] = data;
+    lazy->brickMade++;
+    data = NULL;
+  }
+  airThreadMutexUnlock(lazy->mutex);
+  airFree(data);
+  return 0;
+}
+
+/*
+** _gageStackLazyGather
+**
+** like _gageBrickGather(), but from the bricks of pvl's blurring in
+** pvl->lazy, first computing the ones that are needed and haven't been
+** yet.  A pervolume only looks at lazy->brick[][] for the bricks that it
+** has already needed (as recorded in pvl->lazySeen) after going through
+** lazy->mutex.  Values from bricks that couldn't be allocated are AIR_NAN.
+*/
+unsigned int
+_gageStackLazyGather(gageContext *ctx, gagePerVolume *pvl, const int lo[3],
+                     const unsigned int cmin[3], const unsigned int cmax[3]) {
+  gageStackLazy *lazy;
+  unsigned int ai, size[3], bnum[3], bmin[3], bmax[3], sh, bmask, fd, fddd,
+    valLen, tup, cx, cy, cz, xx, yy, zz, cacheIdx, edgeNum, bx, by, bz;
+  int pp, yout, zout;
+  size_t bidx, yzbidx, sampIdx, ypart, zpart;
+  void **brick;
+  const void *data;
+  double *iv3, val;
+  float *iv3f;
+
+  lazy = pvl->lazy;
+  sh = lazy->brickShift;
+  bmask = (1u << sh) - 1;
+  for (ai=0; ai<3; ai++) {
+    size[ai] = lazy->size[ai];
+    bnum[ai] = lazy->bnum[ai];
+    pp = lo[ai] + AIR_CAST(int, cmin[ai]);
+    bmin[ai] = AIR_CAST(unsigned int,
+                        AIR_CLAMP(0, pp, AIR_CAST(int, size[ai]-1))) >> sh;
+    pp = lo[ai] + AIR_CAST(int, cmax[ai]);
+    bmax[ai] = AIR_CAST(unsigned int,
+                        AIR_CLAMP(0, pp, AIR_CAST(int, size[ai]-1))) >> sh;
+  }
+  for (bz=bmin[2]; bz<=bmax[2]; bz++) {
+    for (by=bmin[1]; by<=bmax[1]; by++) {
+      for (bx=bmin[0]; bx<=bmax[0]; bx++) {
+        bidx = bx + bnum[0]*(by + AIR_CAST(size_t, bnum[1])*bz);
+        if (!pvl->lazySeen[bidx]
+            && !_gageStackLazyBrickNeed(lazy, pvl->lazyIdx, bidx)) {
+          pvl->lazySeen[bidx] = AIR_TRUE;
+        }
+      }
+    }
+  }
+  fd = 2*ctx->radius;
+  fddd = fd*fd*fd;
+  valLen = pvl->kind->valLen;
+  brick = lazy->brick[pvl->lazyIdx];
+  iv3 = pvl->iv3;
+  iv3f = pvl->iv3f;
+  edgeNum = 0;
+  for (cz=cmin[2]; cz<=cmax[2]; cz++) {
+    pp = lo[2] + AIR_CAST(int, cz);
+    zz = AIR_CAST(unsigned int, AIR_CLAMP(0, pp, AIR_CAST(int, size[2]-1)));
+    zout = (AIR_CAST(int, zz) != pp);
+    zpart = AIR_CAST(size_t, zz & bmask) << (2*sh);
+    for (cy=cmin[1]; cy<=cmax[1]; cy++) {
+      pp = lo[1] + AIR_CAST(int, cy);
+      yy = AIR_CAST(unsigned int, AIR_CLAMP(0, pp, AIR_CAST(int, size[1]-1)));
+      yout = (AIR_CAST(int, yy) != pp);
+      ypart = AIR_CAST(size_t, yy & bmask) << sh;
+      yzbidx = bnum[0]*((yy >> sh) + AIR_CAST(size_t, bnum[1])*(zz >> sh));
+      for (cx=cmin[0]; cx<=cmax[0]; cx++) {
+        pp = lo[0] + AIR_CAST(int, cx);
+        xx = AIR_CAST(unsigned int,
+                      AIR_CLAMP(0, pp, AIR_CAST(int, size[0]-1)));
+        edgeNum += (zout || yout || AIR_CAST(int, xx) != pp);
+        bidx = (xx >> sh) + yzbidx;
+        sampIdx = (xx & bmask) + ypart + zpart;
+        cacheIdx = cx + fd*(cy + fd*cz);
+        data = pvl->lazySeen[bidx] ? brick[bidx] : NULL;
+        for (tup=0; tup<valLen; tup++) {
+          val = (data
+                 ? pvl->lup(data, tup + valLen*sampIdx)
+                 : AIR_NAN);
+          if (iv3f) {
+            iv3f[cacheIdx + fddd*tup] = AIR_CAST(float, val);
+          } else {
+            iv3[cacheIdx + fddd*tup] = val;
+          }
+        }
+      }
+    }
+  }
+  return edgeNum;
+}
@@ -0,0 +1,264 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "gage.h"
+#include "privateGage.h"
+
+static const char *
+_gageStoreStr[] = {
+  "(unknown_store)",
+  "full",
+  "half",
+  "q16",
+  "q8"
+};
+
+static const char *
+_gageStoreDesc[] = {
+  "unknown store",
+  "values used as is",
+  "16-bit half-precision floats",
+  "16-bit quantized",
+  "8-bit quantized"
+};
+
+static const airEnum
+_gageStore_enum = {
+  "store",
+  GAGE_STORE_MAX,
+  _gageStoreStr, NULL,
+  _gageStoreDesc,
+  NULL, NULL,
+  AIR_FALSE
+};
+const airEnum *const
+gageStore = &_gageStore_enum;
+
+/*
+** the key of the KVP with which gageStoreMake() records the store, so that
+** gageStackPerVolumeNew() can know how to use the blurrings
+*/
+#define _GAGE_STORE_KEY "gageStore"
+
+/*
+** _gageHalfLookup
+**
+** pvl->lup for gageStoreHalf
+*/
+double
+_gageHalfLookup(const void *ptr, size_t I) {
+
+  return airHalfToFloat(AIR_CAST(const unsigned short *, ptr)[I]);
+}
+
+/*
+** _gageStoreType
+**
+** the nrrd type for the given store and volume type, or nrrdTypeUnknown
+** (without biff) if the store is invalid
+*/
+int
+_gageStoreType(int store, int typeIn) {
+  int ret;
+
+  switch (store) {
+  case gageStoreFull:    ret = typeIn;               break;
+  case gageStoreHalf:    ret = nrrdTypeUShort;       break;
+  case gageStoreQuant16: ret = nrrdTypeUShort;       break;
+  case gageStoreQuant8:  ret = nrrdTypeUChar;        break;
+  default:               ret = nrrdTypeUnknown;      break;
+  }
+  return ret;
+}
+
+/*
+** _gageStoreRange
+**
+** for quantized stores, sets the value of the stored 0 (*minP) and the
+** step between the values of successive stored integers (*stepP), from
+** the range [oldMin, oldMax] of the values before quantizing, the same as
+** used by nrrdUnquantize()
+*/
+void
+_gageStoreRange(double *minP, double *stepP, int store,
+                double oldMin, double oldMax) {
+  unsigned int bits;
+
+  if (gageStoreQuant16 == store || gageStoreQuant8 == store) {
+    bits = gageStoreQuant16 == store ? 16 : 8;
+    *stepP = (oldMax - oldMin)/(1u << bits);
+    *minP = oldMin + (*stepP)/2;
+  } else {
+    *minP = 0;
+    *stepP = 1;
+  }
+  return;
+}
+
+/*
+******** gageStoreMake
+**
+** makes in nout a copy of nin (typically one blurring in a scale-space
+** stack) with its values stored according to the given store, from the
+** gageStore* enum.  The store is recorded in a key/value pair, which
+** gageStackPerVolumeNew() uses to set up the pervolumes for the
+** blurrings (with gagePerVolumeStoreSet()), so for scale-space probing,
+** nout can be used (and saved and read back) in place of nin.
+*/
+int
+gageStoreMake(Nrrd *nout, const Nrrd *nin, int store) {
+  static const char me[]="gageStoreMake";
+  unsigned short *out;
+  size_t II, NN;
+  double (*lup)(const void *, size_t);
+  int E;
+
+  if (!( nout && nin )) {
+    biffAddf(GAGE, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (airEnumValCheck(gageStore, store)) {
+    biffAddf(GAGE, "%s: store %d not valid", me, store);
+    return 1;
+  }
+  if (nout == nin) {
+    biffAddf(GAGE, "%s: can't operate in-place", me);
+    return 1;
+  }
+  if (nrrdTypeBlock == nin->type) {
+    biffAddf(GAGE, "%s: can't store type %s", me,
+             airEnumStr(nrrdType, nrrdTypeBlock));
+    return 1;
+  }
+  E = 0;
+  switch (store) {
+  case gageStoreFull:
+    E = nrrdCopy(nout, nin);
+    break;
+  case gageStoreQuant16:
+  case gageStoreQuant8:
+    E = nrrdQuantize(nout, nin, NULL, gageStoreQuant16 == store ? 16 : 8);
+    break;
+  case gageStoreHalf:
+    if (nrrdTypeDouble != nin->type && nrrdTypeFloat != nin->type) {
+      biffAddf(GAGE, "%s: need %s or %s input for %s store (not %s)", me,
+               airEnumStr(nrrdType, nrrdTypeFloat),
+               airEnumStr(nrrdType, nrrdTypeDouble),
+               airEnumStr(gageStore, store),
+               airEnumStr(nrrdType, nin->type));
+      return 1;
+    }
+    if (nrrdConvert(nout, nin, nrrdTypeUShort)) {
+      biffMovef(GAGE, NRRD, "%s: couldn't allocate output", me);
+      return 1;
+    }
+    NN = nrrdElementNumber(nin);
+    lup = nrrdDLookup[nin->type];
+    out = AIR_CAST(unsigned short *, nout->data);
+    for (II=0; II<NN; II++) {
+      out[II] = airHalfFromFloat(AIR_CAST(float, lup(nin->data, II)));
+    }
+    break;
+  }
+  if (E) {
+    biffMovef(GAGE, NRRD, "%s: trouble storing as %s", me,
+              airEnumStr(gageStore, store));
+    return 1;
+  }
+  if (nrrdKeyValueAdd(nout, _GAGE_STORE_KEY, airEnumStr(gageStore, store))) {
+    biffMovef(GAGE, NRRD, "%s: couldn't record store", me);
+    return 1;
+  }
+  return 0;
+}
+
+/*
+** _gageStoreKnown
+**
+** the store recorded (by gageStoreMake) in the given nrrd, or
+** gageStoreFull if there is none
+*/
+int
+_gageStoreKnown(const Nrrd *nin) {
+  char *str;
+  int ret;
+
+  str = nrrdKeyValueGet(nin, _GAGE_STORE_KEY);
+  if (str) {
+    ret = airEnumVal(gageStore, str);
+    free(str);
+  } else {
+    ret = gageStoreFull;
+  }
+  return ret;
+}
+
+/*
+******** gagePerVolumeStoreSet
+**
+** tells the pervolume how the values in its nin (and nbrick, if set) are
+** stored: gageStoreHalf needs unsigned shorts, and the quantized stores
+** need unsigned shorts or chars (as from nrrdQuantize) with nin->oldMin
+** and nin->oldMax set.  Answers from probing are then the same as from
+** probing the volume with the values converted back (as by
+** nrrdUnquantize(), for quantized values).
+*/
+int
+gagePerVolumeStoreSet(gagePerVolume *pvl, int store) {
+  static const char me[]="gagePerVolumeStoreSet";
+  int type;
+
+  if (!pvl) {
+    biffAddf(GAGE, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (airEnumValCheck(gageStore, store)) {
+    biffAddf(GAGE, "%s: store %d not valid", me, store);
+    return 1;
+  }
+  if (pvl->lazy) {
+    biffAddf(GAGE, "%s: can't set store of lazily computed blurring", me);
+    return 1;
+  }
+  type = _gageStoreType(store, pvl->nin->type);
+  if (type != pvl->nin->type) {
+    biffAddf(GAGE, "%s: %s store needs %s volume, not %s", me,
+             airEnumStr(gageStore, store), airEnumStr(nrrdType, type),
+             airEnumStr(nrrdType, pvl->nin->type));
+    return 1;
+  }
+  if ((gageStoreQuant16 == store || gageStoreQuant8 == store)
+      && !( AIR_EXISTS(pvl->nin->oldMin) && AIR_EXISTS(pvl->nin->oldMax) )) {
+    biffAddf(GAGE, "%s: %s store needs existent oldMin, oldMax (not %g, %g)",
+             me, airEnumStr(gageStore, store),
+             pvl->nin->oldMin, pvl->nin->oldMax);
+    return 1;
+  }
+  pvl->store = store;
+  _gageStoreRange(&(pvl->storeMin), &(pvl->storeStep), store,
+                  pvl->nin->oldMin, pvl->nin->oldMax);
+  pvl->lup = (gageStoreHalf == store
+              ? _gageHalfLookup
+              : nrrdDLookup[pvl->nin->type]);
+  return 0;
+}
@@ -36,7 +36,8 @@ main(int argc, const char *argv[]) {
   char *err, *outS;
   double sigma[2], convEps, cutoff;
   int measr[2], tentRecon;
-  unsigned int sampleNum[2], dim, measrSampleNum, maxIter, num, ii;
+  unsigned int sampleNum[2], dim, measrSampleNum, maxIter, num, ii,
+    threadNum;
   gageOptimSigContext *osctx;
   double *scalePos, *out, info[512];
   Nrrd *nout;
@@ -77,6 +78,8 @@ main(int argc, const char *argv[]) {
              "kernel for gageKernelStack", NULL, NULL, nrrdHestKernelSpec);
   hestOptAdd(&hopt, "tent", NULL, airTypeInt, 0, 0, &tentRecon, NULL,
              "same hack: plot error with tent recon, not hermite");
+  hestOptAdd(&hopt, "nt", "# threads", airTypeUInt, 1, 1, &threadNum, "1",
+             "number of threads to use for measuring error across scales");
   hestOptAdd(&hopt, "o", "nout", airTypeString, 1, 1, &outS, NULL,
              "output array");
   hestParseOrDie(hopt, argc-1, argv+1, hparm,
@@ -98,6 +101,11 @@ main(int argc, const char *argv[]) {
   }
   airMopAdd(mop, osctx, AIR_CAST(airMopper, gageOptimSigContextNix),
             airMopAlways);
+  if (gageOptimSigContextThreadNumSet(osctx, threadNum)) {
+    airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
 
   scalePos = AIR_CALLOC(sampleNum[1], double);
   airMopAdd(mop, scalePos, airFree, airMopAlways);
@@ -84,6 +84,7 @@ _gagePvlNeedDUpdate(gageContext *ctx) {
         }
         GAGE_DV_COPY(pvl->needD, needD);
         pvl->flag[gagePvlFlagNeedD] = AIR_TRUE;
+        pvl->flag[gagePvlFlagDeriv] = AIR_TRUE;
       }
     }
   }
@@ -255,11 +256,16 @@ _gageCacheSizeUpdate(gageContext *ctx) {
   fd = 2*ctx->radius;
   ctx->fsl = (double *)airFree(ctx->fsl);
   ctx->fw = (double *)airFree(ctx->fw);
-  ctx->off = (unsigned int *)airFree(ctx->off);
+  ctx->fwf = (float *)airFree(ctx->fwf);
+  ctx->off = (size_t *)airFree(ctx->off);
   ctx->fsl = (double *)calloc(fd*3, sizeof(double));
   ctx->fw = (double *)calloc(fd*3*(GAGE_KERNEL_MAX+1), sizeof(double));
-  ctx->off = (unsigned int *)calloc(fd*fd*fd, sizeof(unsigned int));
-  if (!(ctx->fsl && ctx->fw && ctx->off)) {
+  if (ctx->parm.singlePrecision) {
+    ctx->fwf = (float *)calloc(fd*3*(GAGE_KERNEL_MAX+1), sizeof(float));
+  }
+  ctx->off = (size_t *)calloc(fd*fd*fd, sizeof(size_t));
+  if (!(ctx->fsl && ctx->fw && ctx->off
+        && (!ctx->parm.singlePrecision || ctx->fwf))) {
     biffAddf(GAGE, "%s: couldn't allocate filter caches for fd=%d", me, fd);
     return 1;
   }
@@ -271,13 +277,31 @@ _gageCacheSizeUpdate(gageContext *ctx) {
     pvl->iv3 = (double *)airFree(pvl->iv3);
     pvl->iv2 = (double *)airFree(pvl->iv2);
     pvl->iv1 = (double *)airFree(pvl->iv1);
-    pvl->iv3 = (double *)calloc(fd*fd*fd*pvl->kind->valLen, sizeof(double));
-    pvl->iv2 = (double *)calloc(fd*fd*pvl->kind->valLen, sizeof(double));
-    pvl->iv1 = (double *)calloc(fd*pvl->kind->valLen, sizeof(double));
-    if (!(pvl->iv3 && pvl->iv2 && pvl->iv1)) {
-      biffAddf(GAGE, "%s: couldn't allocate pvl[%d]'s value caches for fd=%d",
-               me, pvlIdx, fd);
-      return 1;
+    pvl->iv3f = (float *)airFree(pvl->iv3f);
+    pvl->iv2f = (float *)airFree(pvl->iv2f);
+    pvl->iv1f = (float *)airFree(pvl->iv1f);
+    /* only the scalar kind knows how to filter in float, and the stack
+       blends in double; a pvl filtered in float has only float caches */
+    if (ctx->parm.singlePrecision && !ctx->parm.stackUse
+        && gageKindScl == pvl->kind) {
+      pvl->iv3f = (float *)calloc(fd*fd*fd, sizeof(float));
+      pvl->iv2f = (float *)calloc(fd*fd, sizeof(float));
+      pvl->iv1f = (float *)calloc(fd, sizeof(float));
+      if (!(pvl->iv3f && pvl->iv2f && pvl->iv1f)) {
+        biffAddf(GAGE, "%s: couldn't allocate pvl[%d]'s float value caches "
+                 "for fd=%d", me, pvlIdx, fd);
+        return 1;
+      }
+    } else {
+      pvl->iv3 = (double *)calloc(fd*fd*fd*pvl->kind->valLen,
+                                  sizeof(double));
+      pvl->iv2 = (double *)calloc(fd*fd*pvl->kind->valLen, sizeof(double));
+      pvl->iv1 = (double *)calloc(fd*pvl->kind->valLen, sizeof(double));
+      if (!(pvl->iv3 && pvl->iv2 && pvl->iv1)) {
+        biffAddf(GAGE, "%s: couldn't allocate pvl[%d]'s value caches "
+                 "for fd=%d", me, pvlIdx, fd);
+        return 1;
+      }
     }
   }
   if (ctx->verbose) fprintf(stderr, "%s: bye\n", me);
@@ -289,7 +313,7 @@ void
 _gageOffValueUpdate(gageContext *ctx) {
   static const char me[]="_gageOffValueUpdate";
   int fd, i, j, k;
-  unsigned int sx, sy;
+  size_t sx, sy;
 
   if (ctx->verbose) fprintf(stderr, "%s: hello\n", me);
 
@@ -300,7 +324,8 @@ _gageOffValueUpdate(gageContext *ctx) {
   for (k=0; k<fd; k++) {
     for (j=0; j<fd; j++) {
       for (i=0; i<fd; i++) {
-        ctx->off[i + fd*(j + fd*k)] = i + sx*(j + sy*k);
+        ctx->off[i + fd*(j + fd*k)] = AIR_CAST(size_t, i)
+          + sx*(AIR_CAST(size_t, j) + sy*AIR_CAST(size_t, k));
       }
     }
   }
@@ -394,6 +419,10 @@ gageUpdate(gageContext *ctx) {
     if (_gageRadiusUpdate(ctx)) {
       biffAddf(GAGE, "%s: trouble", me); return 1;
     }
+    /* any pre-computed derivatives were made with the old kernels */
+    for (pi=0; pi<ctx->pvlNum; pi++) {
+      ctx->pvl[pi]->flag[gagePvlFlagDeriv] = AIR_TRUE;
+    }
     ctx->flag[gageCtxFlagKernel] = AIR_FALSE;
     ctx->flag[gageCtxFlagNeedK] = AIR_FALSE;
   }
@@ -432,6 +461,12 @@ gageUpdate(gageContext *ctx) {
       }
     }
   }
+  if (_gagePvlFlagCheck(ctx, gagePvlFlagDeriv)) {
+    if (_gageDerivUpdate(ctx)) {
+      biffAddf(GAGE, "%s: trouble", me); return 1;
+    }
+    _gagePvlFlagDown(ctx, gagePvlFlagDeriv);
+  }
 
   if (ctx->verbose > 3 && ctx->stackPos) {
     fprintf(stderr, "%s: pvlNum = %u -> stack of %u [0,%u]\n", me,
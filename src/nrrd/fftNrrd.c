@@ -76,37 +76,21 @@ _nrrdDimsReverse(fftw_iodim *dims, unsigned int len) {
 }
 
 /*
-******** nrrdFFT
-**
-** First pass at a wrapper around FFTW.  This was implemented out of need for a
-** specific project; and better decisions and different interfaces will become
-** apparent with time and experience; these can be in Teem 2.0.
-**
-** currently *requires* that input be complex-valued, in that axis 0 has to
-** have size 2.  nrrdKindComplex would be sensible for input axis 0 but we don't
-** require it, though it is set on the output.
+** checks that nin is complex-valued with axes transformable, and sets up
+** what fftw_plan_guru_dft needs to transform them (with the given rigor);
+** also learns nprod, the product of the transformed axis sizes
 */
-int
-nrrdFFT(Nrrd *nout, const Nrrd *_nin,
-        unsigned int *axes, unsigned int axesNum,
-        int sign, int rescale, int rigor) {
-  static const char me[]="nrrdFFT";
-  size_t inSize[NRRD_DIM_MAX], II, NN, nprod;
-  double *inData, *outData;
-  airArray *mop;
-  Nrrd *nin;
+static int
+_nrrdFFTSetup(fftw_iodim *txfDims, int *txfRank,
+              fftw_iodim *howDims, int *howRank,
+              size_t *nprod, unsigned int *flags,
+              const Nrrd *nin, const unsigned int *axes,
+              unsigned int axesNum, int rigor) {
+  static const char me[]="_nrrdFFTSetup";
   unsigned int axi, axisDo[NRRD_DIM_MAX];
-  fftw_plan plan;
-  void *dataBef;
-  unsigned int txfRank, howRank, flags;
   size_t stride;
-  fftw_iodim txfDims[NRRD_DIM_MAX], howDims[NRRD_DIM_MAX];
 
-  if (!(nout && _nin && axes)) {
-    biffAddf(NRRD, "%s: got NULL pointer", me);
-    return 1;
-  }
-  if (!( _nin->dim > 1 && 2 == _nin->axis[0].size )) {
+  if (!( nin->dim > 1 && 2 == nin->axis[0].size )) {
     biffAddf(NRRD, "%s: nin doesn't look like a complex-valued array", me);
     return 1;
   }
@@ -114,7 +98,7 @@ nrrdFFT(Nrrd *nout, const Nrrd *_nin,
     biffAddf(NRRD, "%s: axesNum 0, no axes to transform?", me);
     return 1;
   }
-  for (axi=0; axi<_nin->dim; axi++) {
+  for (axi=0; axi<nin->dim; axi++) {
     axisDo[axi] = 0;
   }
   for (axi=0; axi<axesNum; axi++) {
@@ -123,9 +107,9 @@ nrrdFFT(Nrrd *nout, const Nrrd *_nin,
                "real/complex values", me, axi);
       return 1;
     }
-    if (!( axes[axi] < _nin->dim )) {
+    if (!( axes[axi] < nin->dim )) {
       biffAddf(NRRD, "%s: axis %u (axes[%u]) out of range [1,%u]", me,
-               axes[axi], axi, _nin->dim-1);
+               axes[axi], axi, nin->dim-1);
       return 1;
     }
     axisDo[axes[axi]]++;
@@ -135,6 +119,86 @@ nrrdFFT(Nrrd *nout, const Nrrd *_nin,
       return 1;
     }
   }
+  switch (rigor) {
+  case nrrdFFTWPlanRigorEstimate:
+    *flags = FFTW_ESTIMATE;
+    break;
+  case nrrdFFTWPlanRigorMeasure:
+    *flags = FFTW_MEASURE;
+    break;
+  case nrrdFFTWPlanRigorPatient:
+    *flags = FFTW_PATIENT;
+    break;
+  case nrrdFFTWPlanRigorExhaustive:
+    *flags = FFTW_EXHAUSTIVE;
+    break;
+  default:
+    biffAddf(NRRD, "%s: unsupported rigor %d", me, rigor);
+    return 1;
+  }
+
+  /* As far as GLK can tell, the guru interface is needed, and the "advanced"
+     fftw_plan_many_dft won't work, because its simplistic accounting of stride
+     can't handle having non-contiguous non-transformed axes (e.g. transforming
+     only axes 2 and not 1, 3 in a 3-D complex-valued array) */
+  /* HEY: figure out why fftw expects txfRank and howRank to be
+     signed and not unsigned */
+  *txfRank = *howRank = 0;
+  stride = 1;
+  *nprod = 1;
+  for (axi=1; axi<nin->dim; axi++) {
+    if (axisDo[axi]) {
+      txfDims[*txfRank].n = AIR_CAST(int, nin->axis[axi].size);
+      txfDims[*txfRank].is = txfDims[*txfRank].os = AIR_CAST(int, stride);
+      *nprod *= nin->axis[axi].size;
+      (*txfRank)++;
+    } else {
+      howDims[*howRank].n = AIR_CAST(int, nin->axis[axi].size);
+      howDims[*howRank].is = howDims[*howRank].os = AIR_CAST(int, stride);
+      (*howRank)++;
+    }
+    stride *= nin->axis[axi].size;
+  }
+  _nrrdDimsReverse(txfDims, AIR_CAST(unsigned int, *txfRank));
+  _nrrdDimsReverse(howDims, AIR_CAST(unsigned int, *howRank));
+  return 0;
+}
+
+/*
+******** nrrdFFT
+**
+** First pass at a wrapper around FFTW.  This was implemented out of need for a
+** specific project; and better decisions and different interfaces will become
+** apparent with time and experience; these can be in Teem 2.0.
+**
+** currently *requires* that input be complex-valued, in that axis 0 has to
+** have size 2.  nrrdKindComplex would be sensible for input axis 0 but we don't
+** require it, though it is set on the output.
+*/
+int
+nrrdFFT(Nrrd *nout, const Nrrd *_nin,
+        unsigned int *axes, unsigned int axesNum,
+        int sign, int rescale, int rigor) {
+  static const char me[]="nrrdFFT";
+  size_t inSize[NRRD_DIM_MAX], II, NN, nprod;
+  double *inData, *outData;
+  airArray *mop;
+  Nrrd *nin;
+  fftw_plan plan;
+  void *dataBef;
+  int txfRank, howRank;
+  unsigned int flags;
+  fftw_iodim txfDims[NRRD_DIM_MAX], howDims[NRRD_DIM_MAX];
+
+  if (!(nout && _nin && axes)) {
+    biffAddf(NRRD, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (_nrrdFFTSetup(txfDims, &txfRank, howDims, &howRank, &nprod, &flags,
+                    _nin, axes, axesNum, rigor)) {
+    biffAddf(NRRD, "%s: trouble", me);
+    return 1;
+  }
 
   NN = nrrdElementNumber(_nin);
   /* We always make a new buffer to hold the double-type copy of input for two
@@ -171,63 +235,7 @@ nrrdFFT(Nrrd *nout, const Nrrd *_nin,
   }
   outData = AIR_CAST(double *, nout->data);
 
-  /* As far as GLK can tell, the guru interface is needed, and the "advanced"
-     fftw_plan_many_dft won't work, because its simplistic accounting of stride
-     can't handle having non-contiguous non-transformed axes (e.g. transforming
-     only axes 2 and not 1, 3 in a 3-D complex-valued array) */
-  txfRank = howRank = 0;
-  stride = 1;
-  nprod = 1;
-  for (axi=1; axi<nin->dim; axi++) {
-    if (axisDo[axi]) {
-      txfDims[txfRank].n = AIR_CAST(int, inSize[axi]);
-      txfDims[txfRank].is = txfDims[txfRank].os = AIR_CAST(int, stride);
-      nprod *= inSize[axi];
-      txfRank++;
-    } else {
-      howDims[howRank].n = AIR_CAST(int, inSize[axi]);
-      howDims[howRank].is = howDims[howRank].os = AIR_CAST(int, stride);
-      howRank++;
-    }
-    stride *= inSize[axi];
-  }
-  _nrrdDimsReverse(txfDims, txfRank);
-  _nrrdDimsReverse(howDims, howRank);
-
-  /*
-  fprintf(stderr, "!%s: ------------- txfRank %u, howRank %u\n",
-          me, txfRank, howRank);
-  for (axi=0; axi<txfRank; axi++) {
-    fprintf(stderr, "!%s: txfDims[%u]: n %d; s %d\n", me, axi,
-            txfDims[axi].n, txfDims[axi].is);
-  }
-  for (axi=0; axi<howRank; axi++) {
-    fprintf(stderr, "!%s: howDims[%u]: n %d; s %d\n", me, axi,
-            howDims[axi].n, howDims[axi].is);
-  }
-  */
-
-  switch (rigor) {
-  case nrrdFFTWPlanRigorEstimate:
-    flags = FFTW_ESTIMATE;
-    break;
-  case nrrdFFTWPlanRigorMeasure:
-    flags = FFTW_MEASURE;
-    break;
-  case nrrdFFTWPlanRigorPatient:
-    flags = FFTW_PATIENT;
-    break;
-  case nrrdFFTWPlanRigorExhaustive:
-    flags = FFTW_EXHAUSTIVE;
-    break;
-  default:
-    biffAddf(NRRD, "%s: unsupported rigor %d", me, rigor);
-    airMopError(mop); return 1;
-  }
-  /* HEY: figure out why fftw expects txfRank and howRank to be
-     signed and not unsigned */
-  plan = fftw_plan_guru_dft(AIR_CAST(int, txfRank), txfDims,
-                            AIR_CAST(int, howRank), howDims,
+  plan = fftw_plan_guru_dft(txfRank, txfDims, howRank, howDims,
                             AIR_CAST(fftw_complex *, inData),
                             AIR_CAST(fftw_complex *, outData),
                             sign, flags);
@@ -283,6 +291,130 @@ nrrdFFT(Nrrd *nout, const Nrrd *_nin,
   return 0;
 }
 
+/*
+******** nrrdFFTPlanNew
+**
+** makes a plan for transforming (as by nrrdFFT, along the given axes, with
+** the given sign and rigor) complex-valued double arrays shaped like nbuff
+** in place: nrrdFFTPlanExecute over-writes its given array with its
+** transform.  Planning with rigor other than nrrdFFTWPlanRigorEstimate can
+** over-write the contents of nbuff.  The plan is made with FFTW_UNALIGNED,
+** so that it can be executed on any array of the same shape, including
+** those allocated by nrrd.  Like FFTW's planner, this isn't thread-safe.
+*/
+NrrdFFTPlan *
+nrrdFFTPlanNew(Nrrd *nbuff, unsigned int *axes, unsigned int axesNum,
+               int sign, int rigor) {
+  static const char me[]="nrrdFFTPlanNew";
+  NrrdFFTPlan *fplan;
+  int txfRank, howRank;
+  unsigned int axi, flags;
+  fftw_iodim txfDims[NRRD_DIM_MAX], howDims[NRRD_DIM_MAX];
+  fftw_complex *data;
+
+  if (!(nbuff && axes)) {
+    biffAddf(NRRD, "%s: got NULL pointer", me);
+    return NULL;
+  }
+  if (!( nrrdTypeDouble == nbuff->type && nbuff->data )) {
+    biffAddf(NRRD, "%s: need allocated array of type %s (not %s)", me,
+             airEnumStr(nrrdType, nrrdTypeDouble),
+             airEnumStr(nrrdType, nbuff->type));
+    return NULL;
+  }
+  fplan = AIR_CALLOC(1, NrrdFFTPlan);
+  if (!fplan) {
+    biffAddf(NRRD, "%s: couldn't allocate plan", me);
+    return NULL;
+  }
+  if (_nrrdFFTSetup(txfDims, &txfRank, howDims, &howRank, &(fplan->nprod),
+                    &flags, nbuff, axes, axesNum, rigor)) {
+    biffAddf(NRRD, "%s: trouble", me);
+    free(fplan);
+    return NULL;
+  }
+  data = AIR_CAST(fftw_complex *, nbuff->data);
+  fplan->plan = fftw_plan_guru_dft(txfRank, txfDims, howRank, howDims,
+                                   data, data, sign, flags | FFTW_UNALIGNED);
+  if (!fplan->plan) {
+    biffAddf(NRRD, "%s: unable to create plan", me);
+    free(fplan);
+    return NULL;
+  }
+  fplan->dim = nbuff->dim;
+  for (axi=0; axi<nbuff->dim; axi++) {
+    fplan->size[axi] = nbuff->axis[axi].size;
+  }
+  return fplan;
+}
+
+/*
+******** nrrdFFTPlanNix
+**
+** like FFTW's fftw_destroy_plan, this isn't thread-safe
+*/
+NrrdFFTPlan *
+nrrdFFTPlanNix(NrrdFFTPlan *fplan) {
+
+  if (fplan) {
+    if (fplan->plan) {
+      fftw_destroy_plan(AIR_CAST(fftw_plan, fplan->plan));
+    }
+    free(fplan);
+  }
+  return NULL;
+}
+
+/*
+******** nrrdFFTPlanExecute
+**
+** transforms nbuff in place with the plan from nrrdFFTPlanNew, and, if
+** rescale, removes the scaling by the number of transformed values, as
+** with nrrdFFT.  nbuff has to be the same type and shape as the nbuff the
+** plan was made with.  This is thread-safe: different threads can use
+** the same plan on different arrays at once.
+*/
+int
+nrrdFFTPlanExecute(Nrrd *nbuff, const NrrdFFTPlan *fplan, int rescale) {
+  static const char me[]="nrrdFFTPlanExecute";
+  fftw_complex *data;
+  size_t II, NN;
+  unsigned int axi;
+  char stmp[2][AIR_STRLEN_SMALL];
+
+  if (!(nbuff && fplan && nbuff->data)) {
+    biffAddf(NRRD, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (!( nrrdTypeDouble == nbuff->type && fplan->dim == nbuff->dim )) {
+    biffAddf(NRRD, "%s: need %u-D %s array (not %u-D %s)", me, fplan->dim,
+             airEnumStr(nrrdType, nrrdTypeDouble), nbuff->dim,
+             airEnumStr(nrrdType, nbuff->type));
+    return 1;
+  }
+  for (axi=0; axi<nbuff->dim; axi++) {
+    if (fplan->size[axi] != nbuff->axis[axi].size) {
+      biffAddf(NRRD, "%s: axis %u size %s different than plan's %s", me, axi,
+               airSprintSize_t(stmp[0], nbuff->axis[axi].size),
+               airSprintSize_t(stmp[1], fplan->size[axi]));
+      return 1;
+    }
+  }
+  data = AIR_CAST(fftw_complex *, nbuff->data);
+  /* the new-array execute is the only thread-safe part of FFTW */
+  fftw_execute_dft(AIR_CAST(fftw_plan, fplan->plan), data, data);
+  if (rescale) {
+    double scale, *ddata;
+    scale = sqrt(1.0/AIR_CAST(double, fplan->nprod));
+    ddata = AIR_CAST(double *, nbuff->data);
+    NN = nrrdElementNumber(nbuff);
+    for (II=0; II<NN; II++) {
+      ddata[II] *= scale;
+    }
+  }
+  return 0;
+}
+
 int
 nrrdFFTWWisdomWrite(FILE *file) {
   static const char me[]="nrrdFFTWWisdomWrite";
@@ -327,6 +459,38 @@ nrrdFFT(Nrrd *nout, const Nrrd *nin,
   return 1;
 }
 
+NrrdFFTPlan *
+nrrdFFTPlanNew(Nrrd *nbuff, unsigned int *axes, unsigned int axesNum,
+               int sign, int rigor) {
+  static const char me[]="nrrdFFTPlanNew";
+
+  AIR_UNUSED(nbuff);
+  AIR_UNUSED(axes);
+  AIR_UNUSED(axesNum);
+  AIR_UNUSED(sign);
+  AIR_UNUSED(rigor);
+  biffAddf(NRRD, "%s: sorry, non-fftw3 version not yet implemented\n", me);
+  return NULL;
+}
+
+NrrdFFTPlan *
+nrrdFFTPlanNix(NrrdFFTPlan *fplan) {
+
+  airFree(fplan);
+  return NULL;
+}
+
+int
+nrrdFFTPlanExecute(Nrrd *nbuff, const NrrdFFTPlan *fplan, int rescale) {
+  static const char me[]="nrrdFFTPlanExecute";
+
+  AIR_UNUSED(nbuff);
+  AIR_UNUSED(fplan);
+  AIR_UNUSED(rescale);
+  biffAddf(NRRD, "%s: sorry, non-fftw3 version not yet implemented\n", me);
+  return 1;
+}
+
 int
 nrrdFFTWWisdomWrite(FILE *file) {
   AIR_UNUSED(file);
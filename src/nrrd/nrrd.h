@@ -1467,6 +1467,27 @@ NRRD_EXPORT int nrrdFFT(Nrrd *nout, const Nrrd *nin,
                         unsigned int *axes, unsigned int axesLen,
                         int sign, int rescale, int preCompLevel);
 NRRD_EXPORT int nrrdFFTWWisdomWrite(FILE *file);
+/*
+******** NrrdFFTPlan struct
+**
+** An FFTW plan for in-place transforms of complex-valued double arrays
+** of one shape, made by nrrdFFTPlanNew.  As with FFTW itself, making and
+** nixing plans is not thread-safe, but nrrdFFTPlanExecute is, so one plan
+** can transform the arrays of many threads at once.
+*/
+typedef struct {
+  void *plan;                  /* the fftw_plan */
+  unsigned int dim;            /* dimension of arrays transformed, ... */
+  size_t size[NRRD_DIM_MAX],   /* ... and their sizes */
+    nprod;                     /* product of sizes of transformed axes */
+} NrrdFFTPlan;
+NRRD_EXPORT NrrdFFTPlan *nrrdFFTPlanNew(Nrrd *nbuff,
+                                        unsigned int *axes,
+                                        unsigned int axesLen,
+                                        int sign, int rigor);
+NRRD_EXPORT NrrdFFTPlan *nrrdFFTPlanNix(NrrdFFTPlan *fplan);
+NRRD_EXPORT int nrrdFFTPlanExecute(Nrrd *nbuff, const NrrdFFTPlan *fplan,
+                                   int rescale);
 
 /******** kernels (interpolation, 1st and 2nd derivatives) */
 /* new kernels should also be registered with
@@ -24,6 +24,47 @@
 #include "nrrd.h"
 #include "privateNrrd.h"
 
+/*
+** _nrrdInsetCopy()
+**
+** copies all of the "sub" array (with sizes szSub) into the "big" array
+** (with sizes szBig), starting at coordinates min, with as few memcpy()s
+** as possible: leading axes along which the sub-array spans all of the
+** big array are lumped together with the first axis along which it
+** doesn't, so that each memcpy() is as long as possible.  This is the
+** copying shared by nrrdSplice() and nrrdInset().
+*/
+static void
+_nrrdInsetCopy(char *dataBig, const size_t *szBig,
+               const char *dataSub, const size_t *szSub,
+               const size_t *min, unsigned int dim, size_t typeSize) {
+  unsigned int ai, cax;
+  size_t lumpSize, runSize, lineNum, LI, idxBig, cSub[NRRD_DIM_MAX];
+
+  lumpSize = typeSize;
+  for (cax=0; cax<dim-1 && szSub[cax] == szBig[cax]; cax++) {
+    lumpSize *= szBig[cax];
+  }
+  runSize = lumpSize*szSub[cax];
+  lineNum = 1;
+  for (ai=cax+1; ai<dim; ai++) {
+    lineNum *= szSub[ai];
+  }
+  for (ai=0; ai<NRRD_DIM_MAX; ai++) {
+    cSub[ai] = 0;
+  }
+  for (LI=0; LI<lineNum; LI++) {
+    idxBig = 0;
+    for (ai=dim-1; ai>cax; ai--) {
+      idxBig = cSub[ai] + min[ai] + szBig[ai]*idxBig;
+    }
+    idxBig = min[cax] + szBig[cax]*idxBig;
+    memcpy(dataBig + idxBig*lumpSize, dataSub + LI*runSize, runSize);
+    NRRD_COORD_INCR(cSub, szSub, dim, cax+1);
+  }
+  return;
+}
+
 /*
 ******** nrrdSplice()
 **
@@ -35,12 +76,11 @@ nrrdSplice(Nrrd *nout, const Nrrd *nin, const Nrrd *nslice,
            unsigned int axis, size_t pos) {
   static const char me[]="nrrdSplice", func[]="splice";
   size_t
-    I,
-    rowLen,                  /* length of segment */
-    colStep,                 /* distance between start of each segment */
-    colLen;                  /* number of periods */
+    szIn[NRRD_DIM_MAX],
+    szSlc[NRRD_DIM_MAX],     /* sizes of slice, as if axis were kept */
+    min[NRRD_DIM_MAX];       /* where slice starts in input */
   unsigned int ai;
-  char *src, *dest, *sliceCont;
+  char *sliceCont;
   char stmp[2][AIR_STRLEN_SMALL];
 
   if (!(nin && nout && nslice)) {
@@ -107,29 +147,15 @@ nrrdSplice(Nrrd *nout, const Nrrd *nin, const Nrrd *nslice,
   }
   /* else we're going to splice in place */
 
-  /* the following was copied from nrrdSlice() */
-  /* set up control variables */
-  rowLen = colLen = 1;
+  /* the slice is copied as an inset that is one sample thick */
+  nrrdAxisInfoGet_nva(nin, nrrdAxisInfoSize, szIn);
   for (ai=0; ai<nin->dim; ai++) {
-    if (ai < axis) {
-      rowLen *= nin->axis[ai].size;
-    } else if (ai > axis) {
-      colLen *= nin->axis[ai].size;
-    }
-  }
-  rowLen *= nrrdElementSize(nin);
-  colStep = rowLen*nin->axis[axis].size;
-
-  /* the skinny */
-  src = (char *)nout->data;    /* switched src,dest from nrrdSlice() */
-  dest = (char *)nslice->data;
-  src += rowLen*pos;
-  for (I=0; I<colLen; I++) {
-    /* HEY: replace with AIR_MEMCPY() or similar, when applicable */
-    memcpy(src, dest, rowLen);  /* switched src,dest from nrrdSlice() */
-    src += colStep;
-    dest += rowLen;
+    szSlc[ai] = (ai == axis ? 1 : szIn[ai]);
+    min[ai] = (ai == axis ? pos : 0);
   }
+  _nrrdInsetCopy(AIR_CAST(char *, nout->data), szIn,
+                 AIR_CAST(const char *, nslice->data), szSlc,
+                 min, nin->dim, nrrdElementSize(nin));
 
   sliceCont = _nrrdContentGet(nslice);
   if (nrrdContentSet_va(nout, func, nin, "%s,%d,%s", sliceCont, axis,
@@ -155,16 +181,10 @@ nrrdInset(Nrrd *nout, const Nrrd *nin, const Nrrd *nsub, const size_t *min) {
   static const char me[]="nrrdInset", func[] = "inset";
   char buff1[NRRD_DIM_MAX*30], buff2[AIR_STRLEN_SMALL];
   unsigned int ai;
-  size_t I,
-    lineSize,                /* #bytes in one scanline to be copied */
-    typeSize,                /* size of data type */
-    cIn[NRRD_DIM_MAX],       /* coords for line start, in input */
-    cOut[NRRD_DIM_MAX],      /* coords for line start, in output */
+  size_t
     szIn[NRRD_DIM_MAX],
-    szOut[NRRD_DIM_MAX],
-    idxIn, idxOut,           /* linear indices for input and output */
-    numLines;                /* number of scanlines in output nrrd */
-  char *dataIn, *dataOut, *subCont, stmp[3][AIR_STRLEN_SMALL];
+    szSub[NRRD_DIM_MAX];
+  char *subCont, stmp[3][AIR_STRLEN_SMALL];
 
   /* errors */
   if (!(nout && nin && nsub && min)) {
@@ -221,35 +241,12 @@ nrrdInset(Nrrd *nout, const Nrrd *nin, const Nrrd *nsub, const size_t *min) {
   }
   /* else we're going to inset in place */
 
-  /* WARNING: following code copied/modified from nrrdCrop(),
-     so the meanings of "in"/"out", "src"/"dest" are all messed up */
-
-  nrrdAxisInfoGet_nva(nin, nrrdAxisInfoSize, szIn);
-  nrrdAxisInfoGet_nva(nsub, nrrdAxisInfoSize, szOut);
-  numLines = 1;
-  for (ai=1; ai<nin->dim; ai++) {
-    numLines *= szOut[ai];
-  }
-  lineSize = szOut[0]*nrrdElementSize(nin);
-
   /* the skinny */
-  typeSize = nrrdElementSize(nin);
-  dataIn = (char *)nout->data;
-  dataOut = (char *)nsub->data;
-  for (ai=0; ai<NRRD_DIM_MAX; ai++) {
-    cOut[ai] = 0;
-  }
-  for (I=0; I<numLines; I++) {
-    for (ai=0; ai<nin->dim; ai++) {
-      cIn[ai] = cOut[ai] + min[ai];
-    }
-    NRRD_INDEX_GEN(idxOut, cOut, szOut, nin->dim);
-    NRRD_INDEX_GEN(idxIn, cIn, szIn, nin->dim);
-    memcpy(dataIn + idxIn*typeSize, dataOut + idxOut*typeSize, lineSize);
-    /* the lowest coordinate in cOut[] will stay zero, since we are
-       copying one (1-D) scanline at a time */
-    NRRD_COORD_INCR(cOut, szOut, nin->dim, 1);
-  }
+  nrrdAxisInfoGet_nva(nin, nrrdAxisInfoSize, szIn);
+  nrrdAxisInfoGet_nva(nsub, nrrdAxisInfoSize, szSub);
+  _nrrdInsetCopy(AIR_CAST(char *, nout->data), szIn,
+                 AIR_CAST(const char *, nsub->data), szSub,
+                 min, nin->dim, nrrdElementSize(nin));
 
   /* HEY: before Teem version 2.0 figure out nrrdKind stuff here */
 
@@ -302,6 +299,51 @@ _nrrdMirror_32(unsigned int N, int I) {
   return M;
 }
 
+/*
+** _nrrdPadIndex()
+**
+** the input index (along an axis of size sz) from which the value at
+** input index ci is taken, given the boundary behavior, or -1 when the
+** value should be the pad value
+*/
+static ptrdiff_t
+_nrrdPadIndex(ptrdiff_t ci, size_t sz, int boundary) {
+  ptrdiff_t ret;
+
+  if (AIR_IN_CL(0, ci, AIR_CAST(ptrdiff_t, sz)-1)) {
+    ret = ci;
+  } else {
+    switch(boundary) {
+    case nrrdBoundaryBleed:
+      ret = AIR_CLAMP(0, ci, AIR_CAST(ptrdiff_t, sz)-1);
+      break;
+    case nrrdBoundaryWrap:
+      ret = AIR_MOD(ci, AIR_CAST(ptrdiff_t, sz));
+      break;
+    case nrrdBoundaryMirror:
+      ret = AIR_CAST(ptrdiff_t, _nrrdMirror_64(sz, ci));
+      break;
+    case nrrdBoundaryPad:
+    default:
+      ret = -1;
+      break;
+    }
+  }
+  return ret;
+}
+
+/*
+** _nrrdPadRun: one piece of an output scanline in nrrdPad_va(), with len
+** values either all set to the pad value (if pad), or copied from input
+** starting at index inIdx, stepping by step (+1: interior or wrapping,
+** 0: bleeding, -1: mirroring)
+*/
+typedef struct {
+  size_t len;
+  ptrdiff_t inIdx, step;
+  int pad;
+} _nrrdPadRun;
+
 /*
 ******** nrrdPad_va()
 **
@@ -313,21 +355,30 @@ nrrdPad_va(Nrrd *nout, const Nrrd *nin,
   static const char me[]="nrrdPad_va", func[]="pad";
   char buff1[NRRD_DIM_MAX*30], buff2[AIR_STRLEN_MED];
   double padValue=AIR_NAN;
-  int outside; /* whether current sample in output has any coordinates
-                  that are outside the input volume (this is per-sample,
-                  not per-axis) */
-  unsigned int ai;
+  int outside; /* whether current scanline in output has any coordinates
+                  that are outside the input volume (on the axes above
+                  the scanline axis) */
+  unsigned int ai,
+    cax;                     /* axis along which scanlines are assembled */
   ptrdiff_t
-    cIn[NRRD_DIM_MAX];       /* coords for line start, in input */
+    ii,
+    *lut,                    /* for all axes above cax, input coords for
+                                each output coord, or -1 for padding */
+    *axLut[NRRD_DIM_MAX];    /* per-axis pointers into lut */
   size_t
-    typeSize,
-    idxIn, idxOut,           /* linear indices for input and output */
+    typeSize,                /* size of an element, lumped with all axes
+                                below cax */
+    lineSize,                /* #bytes in one output scanline */
+    idxIn, LI, RI, oi, done, len,
+    lineNum, lutLen, runNum,
     numOut,                  /* number of elements in output nrrd */
     szIn[NRRD_DIM_MAX],
     szOut[NRRD_DIM_MAX],
     cOut[NRRD_DIM_MAX];      /* coords for line start, in output */
+  _nrrdPadRun *run, *rr;
   va_list ap;
-  char *dataIn, *dataOut;
+  airArray *mop;
+  char *dataIn, *dataOut, *padLine, *dOut;
   char stmp[2][AIR_STRLEN_SMALL];
 
   if (!(nout && nin && min && max)) {
@@ -404,60 +455,125 @@ nrrdPad_va(Nrrd *nout, const Nrrd *nin,
     return 1;
   }
 
-  /* the skinny */
+  /* the skinny: the leading axes that aren't padded at all are lumped
+     together with the element, and output scanlines along the following
+     axis (cax) are assembled from a short list of runs, which are set up
+     once.  The position of each scanline in the input is found with
+     per-axis look-up tables, so no boundary logic happens per-sample */
+  mop = airMopNew();
   typeSize = nrrdElementSize(nin);
+  for (cax=0; cax<nin->dim-1; cax++) {
+    if (!( 0 == min[cax] && szOut[cax] == szIn[cax] )) {
+      break;
+    }
+    typeSize *= szIn[cax];
+  }
+  lineSize = szOut[cax]*typeSize;
+  lineNum = 1;
+  lutLen = 0;
+  for (ai=cax+1; ai<nin->dim; ai++) {
+    lineNum *= szOut[ai];
+    lutLen += szOut[ai];
+  }
+  run = AIR_CALLOC(szOut[cax], _nrrdPadRun);
+  airMopAdd(mop, run, airFree, airMopAlways);
+  lut = AIR_CALLOC(lutLen ? lutLen : 1, ptrdiff_t);
+  airMopAdd(mop, lut, airFree, airMopAlways);
+  padLine = (nrrdBoundaryPad == boundary
+             ? AIR_CALLOC(lineSize, char)
+             : NULL);
+  airMopAdd(mop, padLine, airFree, airMopAlways);
+  if (!( run && lut && (nrrdBoundaryPad != boundary || padLine) )) {
+    biffAddf(NRRD, "%s: couldn't allocate buffers", me);
+    airMopError(mop); return 1;
+  }
+  if (padLine) {
+    len = lineSize/nrrdElementSize(nin);
+    for (oi=0; oi<len; oi++) {
+      nrrdDInsert[nin->type](padLine, oi, padValue);
+    }
+  }
+  runNum = 0;
+  rr = NULL;
+  for (oi=0; oi<szOut[cax]; oi++) {
+    ii = _nrrdPadIndex(AIR_CAST(ptrdiff_t, oi) + min[cax], szIn[cax],
+                       boundary);
+    if (rr && rr->pad && -1 == ii) {
+      rr->len++;
+    } else if (rr && !rr->pad && -1 != ii && 1 == rr->len
+               && AIR_IN_CL(-1, ii - rr->inIdx, 1)) {
+      rr->step = ii - rr->inIdx;
+      rr->len++;
+    } else if (rr && !rr->pad && -1 != ii
+               && ii == rr->inIdx + rr->step*AIR_CAST(ptrdiff_t, rr->len)) {
+      rr->len++;
+    } else {
+      rr = run + runNum++;
+      rr->len = 1;
+      rr->inIdx = ii;
+      rr->step = 1;
+      rr->pad = (-1 == ii);
+    }
+  }
+  lutLen = 0;
+  for (ai=cax+1; ai<nin->dim; ai++) {
+    axLut[ai] = lut + lutLen;
+    for (oi=0; oi<szOut[ai]; oi++) {
+      axLut[ai][oi] = _nrrdPadIndex(AIR_CAST(ptrdiff_t, oi) + min[ai],
+                                    szIn[ai], boundary);
+    }
+    lutLen += szOut[ai];
+  }
+
   dataIn = (char *)nin->data;
   dataOut = (char *)nout->data;
   for (ai=0; ai<NRRD_DIM_MAX; ai++) {
     cOut[ai] = 0;
   }
-  for (idxOut=0; idxOut<numOut; idxOut++) {
-    outside = 0;
-    for (ai=0; ai<nin->dim; ai++) {
-      cIn[ai] = cOut[ai] + min[ai];
-      switch(boundary) {
-      case nrrdBoundaryPad: /* HEY, this shouldn't result in any
-                               input coordinate being set */
-      case nrrdBoundaryBleed:
-        if (!AIR_IN_CL(0, cIn[ai], (ptrdiff_t)szIn[ai]-1)) {
-          cIn[ai] = AIR_CLAMP(0, cIn[ai], (ptrdiff_t)szIn[ai]-1);
-          outside = 1;
-        }
-        break;
-      case nrrdBoundaryWrap:
-        if (!AIR_IN_CL(0, cIn[ai], (ptrdiff_t)szIn[ai]-1)) {
-          /* HEY: shouldn't have to cast szIn[ai] to ptrdiff_t */
-          cIn[ai] = AIR_MOD(cIn[ai], (ptrdiff_t)szIn[ai]);
-          outside = 1;
-        }
-        break;
-      case nrrdBoundaryMirror:
-        if (!AIR_IN_CL(0, cIn[ai], (ptrdiff_t)szIn[ai]-1)) {
-          cIn[ai] = _nrrdMirror_64(szIn[ai], cIn[ai]);
-          outside = 1;
-        }
+  for (LI=0; LI<lineNum; LI++) {
+    dOut = dataOut + LI*lineSize;
+    outside = AIR_FALSE;
+    idxIn = 0;
+    for (ai=nin->dim-1; ai>cax; ai--) {
+      ii = axLut[ai][cOut[ai]];
+      if (-1 == ii) {
+        outside = AIR_TRUE;
         break;
       }
+      idxIn = AIR_CAST(size_t, ii) + szIn[ai]*idxIn;
     }
-    NRRD_INDEX_GEN(idxIn, cIn, szIn, nin->dim);
-    if (!outside) {
-      /* the cIn coords are within the input nrrd: do memcpy() of whole
-         1-D scanline, then artificially bump for-loop to the end of
-         the scanline */
-      memcpy(dataOut + idxOut*typeSize, dataIn + idxIn*typeSize,
-             szIn[0]*typeSize);
-      idxOut += nin->axis[0].size-1;
-      cOut[0] += nin->axis[0].size-1;
+    if (outside) {
+      memcpy(dOut, padLine, lineSize);
     } else {
-      /* we copy only a single value */
-      if (nrrdBoundaryPad == boundary) {
-        nrrdDInsert[nout->type](dataOut, idxOut, padValue);
-      } else {
-        memcpy(dataOut + idxOut*typeSize, dataIn + idxIn*typeSize, typeSize);
+      idxIn *= szIn[cax];
+      for (RI=0; RI<runNum; RI++) {
+        rr = run + RI;
+        if (rr->pad) {
+          memcpy(dOut, padLine, rr->len*typeSize);
+        } else if (1 == rr->step) {
+          /* interior (or wrapped) run: all contiguous in input */
+          memcpy(dOut, dataIn + (idxIn + rr->inIdx)*typeSize,
+                 rr->len*typeSize);
+        } else if (0 == rr->step) {
+          /* bleeding: copy one value, then keep doubling what's copied */
+          memcpy(dOut, dataIn + (idxIn + rr->inIdx)*typeSize, typeSize);
+          for (done=1; done<rr->len; done += len) {
+            len = AIR_MIN(done, rr->len - done);
+            memcpy(dOut + done*typeSize, dOut, len*typeSize);
+          }
+        } else {
+          /* mirroring: values are copied in reverse */
+          for (oi=0; oi<rr->len; oi++) {
+            memcpy(dOut + oi*typeSize,
+                   dataIn + (idxIn + rr->inIdx - oi)*typeSize, typeSize);
+          }
+        }
+        dOut += rr->len*typeSize;
       }
     }
-    NRRD_COORD_INCR(cOut, szOut, nin->dim, 0);
+    NRRD_COORD_INCR(cOut, szOut, nin->dim, cax+1);
   }
+  airMopOkay(mop);
   if (nrrdAxisInfoCopy(nout, nin, NULL, (NRRD_AXIS_INFO_SIZE_BIT |
                                          NRRD_AXIS_INFO_MIN_BIT |
                                          NRRD_AXIS_INFO_MAX_BIT ))) {
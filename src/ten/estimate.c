@@ -229,6 +229,8 @@ tenEstimateContextNew() {
     tec->verbose = 0;
     tec->progress = AIR_FALSE;
     tec->WLSIterNum = 3;
+    tec->negEvalShift = AIR_FALSE;
+    tec->threadNum = 1;
     for (fi=flagUnknown+1; fi<flagLast; fi++) {
       tec->flag[fi] = AIR_FALSE;
     }
@@ -345,6 +347,29 @@ tenEstimateValueMinSet(tenEstimateContext *tec, double valueMin) {
   return 0;
 }
 
+/*
+******** tenEstimateThreadNumSet
+**
+** sets the number of threads that tenEstimate1TensorVolume4D() uses
+*/
+int
+tenEstimateThreadNumSet(tenEstimateContext *tec, unsigned int threadNum) {
+  static const char me[]="tenEstimateThreadNumSet";
+
+  if (!tec) {
+    biffAddf(TEN, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (!threadNum) {
+    biffAddf(TEN, "%s: need threadNum > 0", me);
+    return 1;
+  }
+
+  tec->threadNum = threadNum;
+
+  return 0;
+}
+
 int
 tenEstimateGradientsSet(tenEstimateContext *tec,
                         const Nrrd *ngrad, double bValue, int estimateB0) {
@@ -1217,14 +1242,16 @@ _tenEstimate1Tensor_LLS(tenEstimateContext *tec) {
     fprintf(stderr, "!%s: estimateB0 = %d\n", me, tec->estimateB0);
   }
   if (tec->estimateB0) {
-    for (ii=0; ii<tec->allNum; ii++) {
-      tmp = AIR_MAX(tec->valueMin, tec->all[ii]);
-      tec->allTmp[ii] = -log(tmp)/(tec->bValue);
+    /* with estimateB0, dwi[] is all the values not skipped, which is
+       what the dwiNum columns of the E-matrix are for */
+    for (ii=0; ii<tec->dwiNum; ii++) {
+      tmp = AIR_MAX(tec->valueMin, tec->dwi[ii]);
+      tec->dwiTmp[ii] = -log(tmp)/(tec->bValue);
     }
     for (jj=0; jj<7; jj++) {
       tmp = 0;
-      for (ii=0; ii<tec->allNum; ii++) {
-        tmp += emat[ii + tec->allNum*jj]*tec->allTmp[ii];
+      for (ii=0; ii<tec->dwiNum; ii++) {
+        tmp += emat[ii + tec->dwiNum*jj]*tec->dwiTmp[ii];
       }
       if (jj < 6) {
         tec->ten[1+jj] = tmp;
@@ -1371,6 +1398,9 @@ _tenEstimate1TensorGradient(tenEstimateContext *tec,
   } else {
     /* we find gradient manually */
     gradTen[0] = 0;
+    /* as with _tenEstimate1Tensor_GradientNLS, B0 isn't (yet) part of the
+       descent; leaving this unset made the descent always fail */
+    *gradB0P = 0;
     for (ti=0; ti<6; ti++) {
       TEN_T_COPY(forwTen, ten);
       TEN_T_COPY(backTen, ten);
@@ -1890,43 +1920,549 @@ tenEstimate1TensorSingle_d(tenEstimateContext *tec,
   return 0;
 }
 
-int
-tenEstimate1TensorVolume4D(tenEstimateContext *tec,
-                           Nrrd *nten, Nrrd **nB0P, Nrrd **nterrP,
-                           const Nrrd *ndwi, int outType) {
+/*
+** _tenEstimateContextClone
+**
+** for the threads of tenEstimate1TensorVolume4D(): a new context that can
+** do single-tensor estimation in the same way as the given (updated)
+** context, without any further updating.  What doesn't change between
+** samples (parameters, B-matrices, E-matrix, skip and norm tables) is
+** copied once from tec, and the clone gets its own buffers for the values
+** and the intermediate results of each sample (including the weights and
+** E-matrix that WLS re-computes).
+*/
+static tenEstimateContext *
+_tenEstimateContextClone(const tenEstimateContext *tec) {
+  static const char me[]="_tenEstimateContextClone";
+  tenEstimateContext *cln;
+  int E;
+
+  cln = tenEstimateContextNew();
+  if (!cln) {
+    biffAddf(TEN, "%s: couldn't allocate context", me);
+    return NULL;
+  }
+  cln->bValue = tec->bValue;
+  cln->valueMin = tec->valueMin;
+  cln->sigma = tec->sigma;
+  cln->dwiConfThresh = tec->dwiConfThresh;
+  cln->dwiConfSoft = tec->dwiConfSoft;
+  cln->_ngrad = tec->_ngrad;
+  cln->_nbmat = tec->_nbmat;
+  cln->simulate = tec->simulate;
+  cln->estimate1Method = tec->estimate1Method;
+  cln->estimateB0 = tec->estimateB0;
+  cln->recordTime = tec->recordTime;
+  cln->recordErrorDwi = tec->recordErrorDwi;
+  cln->recordErrorLogDwi = tec->recordErrorLogDwi;
+  cln->recordLikelihoodDwi = tec->recordLikelihoodDwi;
+  cln->verbose = tec->verbose;
+  cln->negEvalShift = tec->negEvalShift;
+  cln->WLSIterNum = tec->WLSIterNum;
+  cln->allNum = tec->allNum;
+  cln->dwiNum = tec->dwiNum;
+  cln->knownB0 = tec->knownB0;
+  cln->all = AIR_CALLOC(tec->allNum, double);
+  cln->allTmp = AIR_CALLOC(tec->allNum, double);
+  cln->bnorm = AIR_CALLOC(tec->allNum, double);
+  cln->skipLut = AIR_CALLOC(tec->allNum, unsigned char);
+  cln->dwi = AIR_CALLOC(tec->dwiNum, double);
+  cln->dwiTmp = AIR_CALLOC(tec->dwiNum, double);
+  if (!( cln->all && cln->allTmp && cln->bnorm && cln->skipLut
+         && cln->dwi && cln->dwiTmp )) {
+    biffAddf(TEN, "%s: couldn't allocate buffers", me);
+    tenEstimateContextNix(cln);
+    return NULL;
+  }
+  memcpy(cln->bnorm, tec->bnorm, tec->allNum*sizeof(double));
+  memcpy(cln->skipLut, tec->skipLut, tec->allNum*sizeof(unsigned char));
+  E = 0;
+  if (!E) E |= nrrdCopy(cln->nbmat, tec->nbmat);
+  if (!E) E |= nrrdCopy(cln->nwght, tec->nwght);
+  if (!E && tec->nemat->data) E |= nrrdCopy(cln->nemat, tec->nemat);
+  if (E) {
+    biffMovef(TEN, NRRD, "%s: couldn't copy matrices", me);
+    tenEstimateContextNix(cln);
+    return NULL;
+  }
+  return cln;
+}
+
+/*
+** how many samples a thread in tenEstimate1TensorVolume4D() takes at once;
+** small because the time per sample for NLS and MLE varies a lot.  This
+** is also how many samples _tenEstimate1TensorBatch() fits together.
+*/
+#define _TEN_ESTIMATE_CHUNK 32
+
+/*
+** the results at one sample: the tensor (with confidence), the B0 (either
+** estimated or known), and the fitting error (if one is recorded)
+*/
+#define _TEN_ESTIMATE_RES 9
+
+/*
+** _tenEstimate1TensorSample
+**
+** single-tensor estimation at one sample, with the results put in res
+*/
+static int
+_tenEstimate1TensorSample(double *res, tenEstimateContext *tec,
+                          const double *all) {
+
+  if (tenEstimate1TensorSingle_d(tec, res, all)) {
+    return 1;
+  }
+  res[7] = tec->estimateB0 ? tec->estimatedB0 : tec->knownB0;
+  if (tec->recordErrorDwi) {
+    res[8] = tec->errorDwi;
+  } else if (tec->recordErrorLogDwi) {
+    res[8] = tec->errorLogDwi;
+  } else if (tec->recordLikelihoodDwi) {
+    res[8] = tec->likelihoodDwi;
+  } else {
+    res[8] = AIR_NAN;
+  }
+  return 0;
+}
+
+/*
+** index into the packed lower triangle of a cn-by-cn matrix at each of
+** num samples, as used by _tenEstimateBatchSolve
+*/
+#define _TEN_ESTIMATE_TRI(jj, kk, num) ((num)*((jj)*((jj)+1)/2 + (kk)))
+
+/*
+** _tenEstimateBatchSolve
+**
+** for _tenEstimate1TensorBatch: at each of num samples, finds the
+** weighted least-squares solution xx (cn-by-num) of B x = y, with the
+** cn-column B-matrix bmat, and weights ww and values yy (both
+** dwiNum-by-num).  This is the same (B^T W B)^(-1) B^T W y as from
+** ell_Nm_wght_pseudo_inv(), but here the lower triangle of B^T W B is
+** built (packed) in aa, and B^T W y in xx, which are then solved in place
+** by Cholesky decomposition.  Where B^T W B isn't positive-definite,
+** okay[si] is turned off.
+*/
+static void
+_tenEstimateBatchSolve(double *xx, unsigned char *okay, double *aa,
+                       const double *ww, const double *yy,
+                       const double *bmat, unsigned int cn,
+                       unsigned int dwiNum, unsigned int num) {
+  unsigned int ii, jj, kk, ll, si;
+  const double *bb, *wrow, *yrow, *lrow, *krow;
+  double val, *arow, *xrow;
+
+  for (ii=0; ii<_TEN_ESTIMATE_TRI(cn, 0, num); ii++) {
+    aa[ii] = 0;
+  }
+  for (ii=0; ii<cn*num; ii++) {
+    xx[ii] = 0;
+  }
+  for (ii=0; ii<dwiNum; ii++) {
+    bb = bmat + cn*ii;
+    wrow = ww + num*ii;
+    yrow = yy + num*ii;
+    arow = aa;
+    for (jj=0; jj<cn; jj++) {
+      for (kk=0; kk<=jj; kk++) {
+        val = bb[jj]*bb[kk];
+        for (si=0; si<num; si++) {
+          arow[si] += val*wrow[si];
+        }
+        arow += num;
+      }
+      val = bb[jj];
+      xrow = xx + num*jj;
+      for (si=0; si<num; si++) {
+        xrow[si] += val*wrow[si]*yrow[si];
+      }
+    }
+  }
+  /* Cholesky decomposition B^T W B = L L^T, with L over-writing aa */
+  for (jj=0; jj<cn; jj++) {
+    for (kk=0; kk<=jj; kk++) {
+      arow = aa + _TEN_ESTIMATE_TRI(jj, kk, num);
+      for (ll=0; ll<kk; ll++) {
+        lrow = aa + _TEN_ESTIMATE_TRI(jj, ll, num);
+        krow = aa + _TEN_ESTIMATE_TRI(kk, ll, num);
+        for (si=0; si<num; si++) {
+          arow[si] -= lrow[si]*krow[si];
+        }
+      }
+      if (kk < jj) {
+        krow = aa + _TEN_ESTIMATE_TRI(kk, kk, num);
+        for (si=0; si<num; si++) {
+          arow[si] /= krow[si];
+        }
+      } else {
+        for (si=0; si<num; si++) {
+          if (arow[si] > 0) {
+            arow[si] = sqrt(arow[si]);
+          } else {
+            /* carry on with something harmless */
+            okay[si] = AIR_FALSE;
+            arow[si] = 1;
+          }
+        }
+      }
+    }
+  }
+  /* forward substitution with L */
+  for (jj=0; jj<cn; jj++) {
+    xrow = xx + num*jj;
+    for (ll=0; ll<jj; ll++) {
+      lrow = aa + _TEN_ESTIMATE_TRI(jj, ll, num);
+      krow = xx + num*ll;
+      for (si=0; si<num; si++) {
+        xrow[si] -= lrow[si]*krow[si];
+      }
+    }
+    lrow = aa + _TEN_ESTIMATE_TRI(jj, jj, num);
+    for (si=0; si<num; si++) {
+      xrow[si] /= lrow[si];
+    }
+  }
+  /* backward substitution with L^T */
+  for (jj=cn; jj>0; jj--) {
+    xrow = xx + num*(jj-1);
+    for (ll=jj; ll<cn; ll++) {
+      lrow = aa + _TEN_ESTIMATE_TRI(ll, jj-1, num);
+      krow = xx + num*ll;
+      for (si=0; si<num; si++) {
+        xrow[si] -= lrow[si]*krow[si];
+      }
+    }
+    lrow = aa + _TEN_ESTIMATE_TRI(jj-1, jj-1, num);
+    for (si=0; si<num; si++) {
+      xrow[si] /= lrow[si];
+    }
+  }
+  return;
+}
+
+/*
+** how many doubles _tenEstimate1TensorBatch needs in its buffer
+*/
+#define _TEN_ESTIMATE_BATCH_BUFF(dwiNum) \
+  ((3*(dwiNum) + _TEN_ESTIMATE_TRI(7, 0, 1) + 7 + 3)*_TEN_ESTIMATE_CHUNK)
+
+/*
+** _tenEstimate1TensorBatch
+**
+** LLS or WLS estimation at num (at most _TEN_ESTIMATE_CHUNK) samples at
+** once, with the values of sample si at all + tec->allNum*si, and its
+** results (as from _tenEstimate1TensorSample) put at
+** res + _TEN_ESTIMATE_RES*si.  The per-sample steps are re-arranged so
+** that the inner loops are over the samples: the DWIs are transposed into
+** a dwiNum-by-num block, and all their logs are taken together.  For LLS,
+** the tensors are then one product of the E-matrix with that block, in
+** which each sum is in the same order as in _tenEstimate1Tensor_LLS, so
+** the results are the same.  For WLS, the weighted fits of all the
+** samples (at each re-weighting) are done together by
+** _tenEstimateBatchSolve, which solves the same equations as
+** ell_Nm_wght_pseudo_inv(), so the results differ only by round-off.
+**
+** Any sample at which something didn't exist, or a weighted fit wasn't
+** possible, is re-done by _tenEstimate1TensorSample, so that failures
+** (and biff messages) are the same as without batching.  On failure,
+** *failP is the sample that failed.
+*/
+static int
+_tenEstimate1TensorBatch(double *res, unsigned int *failP,
+                         double *buff, unsigned char *okay,
+                         tenEstimateContext *tec, const double *all,
+                         unsigned int num) {
+  unsigned int si, ii, jj, cn, iter, dwiNum;
+  double *dwi, *yy, *ww, *aa, *xx, *knownB0, *conf, *B0, *out,
+    *wrow, *xrow, val, vmin, bval, eval[3];
+  const double *emat, *bmat, *bb;
+
+  dwiNum = tec->dwiNum;
+  cn = AIR_CAST(unsigned int, tec->nbmat->axis[0].size);
+  dwi = buff;
+  yy = dwi + dwiNum*num;
+  ww = yy + dwiNum*num;
+  aa = ww + dwiNum*num;
+  xx = aa + _TEN_ESTIMATE_TRI(cn, 0, num);
+  knownB0 = xx + 7*num;
+  conf = knownB0 + num;
+  B0 = conf + num;
+  bmat = AIR_CAST(const double *, tec->nbmat->data);
+  vmin = tec->valueMin;
+  bval = tec->bValue;
+
+  /* sorting out the values is as at a single sample; they are
+     transposed into dwi */
+  tec->all_f = NULL;
+  for (si=0; si<num; si++) {
+    tec->all_d = all + tec->allNum*si;
+    _tenEstimateValuesSet(tec);
+    for (ii=0; ii<dwiNum; ii++) {
+      dwi[si + num*ii] = tec->dwi[ii];
+    }
+    knownB0[si] = tec->knownB0;
+    conf[si] = tec->conf;
+    okay[si] = AIR_TRUE;
+  }
+  /* the logs of all the values, as in _tenEstimate1Tensor_LLS */
+  if (tec->estimateB0) {
+    for (ii=0; ii<dwiNum*num; ii++) {
+      yy[ii] = -log(AIR_MAX(vmin, dwi[ii]))/bval;
+    }
+  } else {
+    /* B0 is first the log of the known B0 */
+    for (si=0; si<num; si++) {
+      B0[si] = log(AIR_MAX(vmin, knownB0[si]));
+    }
+    for (ii=0; ii<dwiNum; ii++) {
+      for (si=0; si<num; si++) {
+        yy[si + num*ii] = (B0[si]
+                           - log(AIR_MAX(vmin, dwi[si + num*ii])))/bval;
+      }
+    }
+  }
+
+  if (tenEstimate1MethodLLS == tec->estimate1Method) {
+    emat = AIR_CAST(const double *, tec->nemat->data);
+    for (jj=0; jj<cn; jj++) {
+      xrow = xx + num*jj;
+      for (si=0; si<num; si++) {
+        xrow[si] = 0;
+      }
+      for (ii=0; ii<dwiNum; ii++) {
+        val = emat[ii + dwiNum*jj];
+        for (si=0; si<num; si++) {
+          xrow[si] += val*yy[si + num*ii];
+        }
+      }
+    }
+  } else {
+    /* WLS; initial weights are from the values, as in
+       _tenEstimate1Tensor_WLS, with B0 first being their sum */
+    for (si=0; si<num; si++) {
+      B0[si] = 0;
+    }
+    for (ii=0; ii<dwiNum*num; ii++) {
+      val = AIR_MAX(vmin, dwi[ii]);
+      B0[ii % num] += val*val;
+    }
+    for (ii=0; ii<dwiNum*num; ii++) {
+      val = AIR_MAX(vmin, dwi[ii]);
+      ww[ii] = val*val/B0[ii % num];
+    }
+    _tenEstimateBatchSolve(xx, okay, aa, ww, yy, bmat, cn, dwiNum, num);
+    for (iter=0; iter<tec->WLSIterNum; iter++) {
+      for (si=0; si<num; si++) {
+        B0[si] = (tec->estimateB0
+                  ? AIR_MIN(FLT_MAX, exp(bval*xx[si + num*6]))
+                  : knownB0[si]);
+      }
+      /* re-weighting by the simulated values, as from
+         _tenEstimate1TensorSimulateSingle */
+      for (ii=0; ii<dwiNum; ii++) {
+        bb = bmat + cn*ii;
+        wrow = ww + num*ii;
+        for (si=0; si<num; si++) {
+          wrow[si] = 0;
+        }
+        for (jj=0; jj<6; jj++) {
+          xrow = xx + num*jj;
+          for (si=0; si<num; si++) {
+            wrow[si] += bb[jj]*xrow[si];
+          }
+        }
+        for (si=0; si<num; si++) {
+          val = B0[si]*exp(-bval*AIR_MAX(0, wrow[si]));
+          okay[si] &= AIR_EXISTS(val);
+          wrow[si] = AIR_MAX(FLT_MIN, val*val);
+        }
+      }
+      _tenEstimateBatchSolve(xx, okay, aa, ww, yy, bmat, cn, dwiNum, num);
+    }
+  }
+  for (si=0; si<num; si++) {
+    B0[si] = (tec->estimateB0
+              ? AIR_MIN(FLT_MAX, exp(bval*xx[si + num*6]))
+              : knownB0[si]);
+    okay[si] &= AIR_EXISTS(B0[si]);
+    for (jj=0; jj<6; jj++) {
+      okay[si] &= AIR_EXISTS(xx[si + num*jj]);
+    }
+  }
+
+  for (si=0; si<num; si++) {
+    out = res + _TEN_ESTIMATE_RES*si;
+    if (!okay[si]) {
+      if (_tenEstimate1TensorSample(out, tec, all + tec->allNum*si)) {
+        *failP = si;
+        return 1;
+      }
+      continue;
+    }
+    out[0] = conf[si];
+    for (jj=0; jj<6; jj++) {
+      out[1+jj] = xx[si + num*jj];
+    }
+    if (tec->negEvalShift) {
+      tenEigensolve_d(eval, NULL, out);
+      if (eval[2] < 0) {
+        out[1] += -eval[2];
+        out[4] += -eval[2];
+        out[6] += -eval[2];
+      }
+    }
+    out[7] = B0[si];
+    out[8] = AIR_NAN;
+    if (tec->recordErrorDwi || tec->recordErrorLogDwi) {
+      for (ii=0; ii<dwiNum; ii++) {
+        tec->dwi[ii] = dwi[si + num*ii];
+      }
+      if (_tenEstimate1TensorSimulateSingle(tec, 0.0, bval, B0[si], out)) {
+        *failP = si;
+        return 1;
+      }
+      out[8] = (tec->recordErrorDwi
+                ? _tenEstimateErrorDwi(tec)
+                : _tenEstimateErrorLogDwi(tec));
+    }
+  }
+  return 0;
+}
+
+/*
+** _tenEstimateTask, _tenEstimateThreadArg: for tenEstimate1TensorVolume4D
+** and tenEstimate1TensorBootstrap, with chunks of samples handed out to
+** threads
+*/
+typedef struct {
+  const Nrrd *ndwi;
+  Nrrd *nten, *nB0, *nterr;   /* outputs; nB0, nterr may be NULL */
+  unsigned int bootNum,       /* for bootstrapping: samples per voxel */
+    rngSeed;                  /* for bootstrapping: random number seed */
+  size_t NN,                  /* total number of samples */
+    workIdx,                  /* first sample of next chunk to hand out */
+    tick;                     /* progress indication interval */
+  int progress,               /* do progress indication */
+    batch,                    /* use _tenEstimate1TensorBatch */
+    failed;                   /* some thread has failed */
+  airThreadMutex *workMutex;  /* NULL for a single thread */
+} _tenEstimateTask;
+
+typedef struct {
+  _tenEstimateTask *task;
+  tenEstimateContext *tec;    /* context for this thread */
+  double *all,                /* values at the samples of one chunk */
+    *res,                     /* results at the samples of one chunk */
+    *buff;                    /* for batch estimation, else NULL */
+  unsigned char *okay;        /* for batch estimation, else NULL */
+  airRandMTState *rng;        /* for bootstrapping, else NULL */
+  int failed;                 /* estimation failed in this thread */
+  size_t failIdx;             /* at which sample it failed */
+} _tenEstimateThreadArg;
+
+static void *
+_tenEstimateWorker(void *_arg) {
   static const char me[]="tenEstimate1TensorVolume4D";
+  _tenEstimateThreadArg *arg;
+  _tenEstimateTask *task;
+  tenEstimateContext *tec;
   char doneStr[20];
-  size_t sizeTen, sizeX, sizeY, sizeZ, NN, II, tick;
-  double *all, ten[7], (*lup)(const void *, size_t),
+  size_t sizeTen, II, lo, hi;
+  double *all, *res, (*lup)(const void *, size_t),
     (*ins)(void *v, size_t I, double d);
-  unsigned int dd;
-  airArray *mop;
-  int axmap[4];
-  char stmp[AIR_STRLEN_SMALL];
+  unsigned int dd, si, num;
+  int E;
 
-#if 0
-#define NUM 800
-  double val[NUM], minVal=0, maxVal=10, arg;
-  unsigned int valIdx;
-  Nrrd *nval;
-  for (valIdx=0; valIdx<NUM; valIdx++) {
-    arg = AIR_AFFINE(0, valIdx, NUM-1, minVal, maxVal);
-    if (_tenRician(val + valIdx, arg, 1, 1)) {
-      biffAddf(TEN, "%s: you are out of luck", me);
-      return 1;
+  arg = AIR_CAST(_tenEstimateThreadArg *, _arg);
+  task = arg->task;
+  tec = arg->tec;
+  all = arg->all;
+  sizeTen = nrrdKindSize(nrrdKind3DMaskedSymMatrix);
+  lup = nrrdDLookup[task->ndwi->type];
+  ins = nrrdDInsert[task->nten->type];
+  for (;;) {
+    if (task->workMutex) {
+      airThreadMutexLock(task->workMutex);
+    }
+    lo = task->workIdx;
+    hi = task->failed ? lo : AIR_MIN(lo + _TEN_ESTIMATE_CHUNK, task->NN);
+    task->workIdx = hi;
+    if (task->progress && lo < hi && lo/task->tick != hi/task->tick) {
+      fprintf(stderr, "%s", airDoneStr(0, lo, task->NN-1, doneStr));
+    }
+    if (task->workMutex) {
+      airThreadMutexUnlock(task->workMutex);
+    }
+    if (lo == hi) {
+      /* no more work */
+      break;
+    }
+    num = AIR_CAST(unsigned int, hi - lo);
+    for (II=lo; II<hi; II++) {
+      for (dd=0; dd<tec->allNum; dd++) {
+        all[dd + tec->allNum*(II-lo)] = lup(task->ndwi->data,
+                                            dd + tec->allNum*II);
+      }
+    }
+    si = 0;
+    if (task->batch) {
+      E = _tenEstimate1TensorBatch(arg->res, &si, arg->buff, arg->okay,
+                                   tec, all, num);
+    } else {
+      E = 0;
+      for (si=0; si<num; si++) {
+        if (tec->verbose) {
+          fprintf(stderr, "!%s: hello; II=%u\n", me,
+                  AIR_CAST(unsigned int, lo + si));
+        }
+        if ((E = _tenEstimate1TensorSample(arg->res + _TEN_ESTIMATE_RES*si,
+                                           tec, all + tec->allNum*si))) {
+          break;
+        }
+      }
+    }
+    if (E) {
+      arg->failed = AIR_TRUE;
+      arg->failIdx = lo + si;
+      /* other threads stop at their next chunk */
+      if (task->workMutex) {
+        airThreadMutexLock(task->workMutex);
+      }
+      task->failed = AIR_TRUE;
+      if (task->workMutex) {
+        airThreadMutexUnlock(task->workMutex);
+      }
+      break;
+    }
+    for (si=0; si<num; si++) {
+      II = lo + si;
+      res = arg->res + _TEN_ESTIMATE_RES*si;
+      for (dd=0; dd<7; dd++) {
+        ins(task->nten->data, dd + sizeTen*II, res[dd]);
+      }
+      if (task->nB0) {
+        ins(task->nB0->data, II, res[7]);
+      }
+      if (task->nterr) {
+        /* this works because tenEstimate1TensorVolume4D checked that only
+           one of the tec->record* flags is set */
+        ins(task->nterr->data, II, res[8]);
+      }
     }
   }
-  nval = nrrdNew();
-  nrrdWrap(nval, val, nrrdTypeDouble, 1, AIR_CAST(size_t, NUM));
-  nrrdSave("nval.nrrd", nval, NULL);
-  nrrdNix(nval);
-#endif
+  return _arg;
+}
+
+/*
+** checks a DWI volume ndwi and output type for volume estimation with tec
+*/
+static int
+_tenEstimateVolumeCheck(const tenEstimateContext *tec, const Nrrd *ndwi,
+                        int outType) {
+  static const char me[]="_tenEstimateVolumeCheck";
+  char stmp[AIR_STRLEN_SMALL];
 
-  if (!(tec && nten && ndwi)) {
-    /* nerrP and _NB0P can be NULL */
-    biffAddf(TEN, "%s: got NULL pointer", me);
-    return 1;
-  }
   if (nrrdCheck(ndwi)) {
     biffMovef(TEN, NRRD, "%s: DWI volume not valid", me);
     return 1;
@@ -1958,6 +2494,110 @@ tenEstimate1TensorVolume4D(tenEstimateContext *tec,
              airEnumStr(nrrdType, nrrdTypeDouble));
     return 1;
   }
+  return 0;
+}
+
+/*
+** sets up task->workMutex for threadNum threads (but no more than there
+** are chunks of chunkLen samples), and returns how many threads to use,
+** or 0 (with a biff message) if there was a problem
+*/
+static unsigned int
+_tenEstimateThreadSetup(_tenEstimateTask *task, unsigned int threadNum,
+                        size_t chunkLen, airArray *mop,
+                        const char *caller) {
+
+  threadNum = AIR_CAST(unsigned int,
+                       AIR_MIN(threadNum, (task->NN + chunkLen - 1)/chunkLen));
+  threadNum = AIR_MAX(threadNum, 1);
+  if (1 < threadNum) {
+    if (!( task->workMutex = airThreadMutexNew() )) {
+      biffAddf(TEN, "%s: couldn't create work mutex", caller);
+      return 0;
+    }
+    airMopAdd(mop, task->workMutex, (airMopper)airThreadMutexNix,
+              airMopAlways);
+    if (!airThreadCapable) {
+      fprintf(stderr, "%s: WARNING: not multi-threaded; will do %u "
+              "\"threads\" serially !!!\n", caller, threadNum);
+    }
+    /* the estimation code uses biff, sometimes even when it succeeds;
+       this has to happen before the threads start */
+    if (biffThreadSafe()) {
+      biffAddf(TEN, "%s: couldn't make biff thread-safe", caller);
+      return 0;
+    }
+  } else {
+    task->workMutex = NULL;
+  }
+  return threadNum;
+}
+
+/*
+** runs worker on arg[ti] in each of threadNum threads, and reports the
+** first sample at which one of them failed
+*/
+static int
+_tenEstimateThreadRun(_tenEstimateThreadArg *arg, unsigned int threadNum,
+                      void *(*worker)(void *)) {
+  static const char me[]="_tenEstimateThreadRun";
+  char stmp[AIR_STRLEN_SMALL];
+  unsigned int ti;
+
+  if (airThreadRun(worker, arg, sizeof(*arg), threadNum)) {
+    biffAddf(TEN, "%s: couldn't run %u threads", me, threadNum);
+    return 1;
+  }
+  for (ti=0; ti<threadNum; ti++) {
+    if (arg[ti].failed) {
+      biffAddf(TEN, "%s: failed at sample %s", me,
+               airSprintSize_t(stmp, arg[ti].failIdx));
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int
+tenEstimate1TensorVolume4D(tenEstimateContext *tec,
+                           Nrrd *nten, Nrrd **nB0P, Nrrd **nterrP,
+                           const Nrrd *ndwi, int outType) {
+  static const char me[]="tenEstimate1TensorVolume4D";
+  char doneStr[20];
+  size_t sizeTen, sizeX, sizeY, sizeZ;
+  unsigned int ti, threadNum;
+  _tenEstimateTask task;
+  _tenEstimateThreadArg *arg;
+  airArray *mop;
+  int axmap[4];
+
+#if 0
+#define NUM 800
+  double val[NUM], minVal=0, maxVal=10, arg;
+  unsigned int valIdx;
+  Nrrd *nval;
+  for (valIdx=0; valIdx<NUM; valIdx++) {
+    arg = AIR_AFFINE(0, valIdx, NUM-1, minVal, maxVal);
+    if (_tenRician(val + valIdx, arg, 1, 1)) {
+      biffAddf(TEN, "%s: you are out of luck", me);
+      return 1;
+    }
+  }
+  nval = nrrdNew();
+  nrrdWrap(nval, val, nrrdTypeDouble, 1, AIR_CAST(size_t, NUM));
+  nrrdSave("nval.nrrd", nval, NULL);
+  nrrdNix(nval);
+#endif
+
+  if (!(tec && nten && ndwi)) {
+    /* nerrP and _NB0P can be NULL */
+    biffAddf(TEN, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (_tenEstimateVolumeCheck(tec, ndwi, outType)) {
+    biffAddf(TEN, "%s: problem with input", me);
+    return 1;
+  }
   if (nterrP) {
     int recE, recEL, recLK;
     recE = !!(tec->recordErrorDwi);
@@ -1977,12 +2617,6 @@ tenEstimate1TensorVolume4D(tenEstimateContext *tec,
   sizeX = ndwi->axis[1].size;
   sizeY = ndwi->axis[2].size;
   sizeZ = ndwi->axis[3].size;
-  all = AIR_CAST(double *, calloc(tec->allNum, sizeof(double)));
-  if (!all) {
-    biffAddf(TEN, "%s: couldn't allocate length %u array", me, tec->allNum);
-    airMopError(mop); return 1;
-  }
-  airMopAdd(mop, all, airFree, airMopAlways);
 
   if (nrrdMaybeAlloc_va(nten, outType, 4,
                         sizeTen, sizeX, sizeY, sizeZ)) {
@@ -2022,59 +2656,79 @@ tenEstimate1TensorVolume4D(tenEstimateContext *tec,
     airMopAdd(mop, *nterrP, (airMopper)nrrdNuke, airMopOnError);
     airMopAdd(mop, nterrP, (airMopper)airSetNull, airMopOnError);
   }
-  NN = sizeX * sizeY * sizeZ;
-  lup = nrrdDLookup[ndwi->type];
-  ins = nrrdDInsert[outType];
-  if (tec->progress) {
-    fprintf(stderr, "%s:       ", me);
+  task.ndwi = ndwi;
+  task.nten = nten;
+  task.nB0 = nB0P ? *nB0P : NULL;
+  task.nterr = nterrP ? *nterrP : NULL;
+  task.NN = sizeX * sizeY * sizeZ;
+  task.workIdx = 0;
+  task.tick = AIR_MAX(1, task.NN / 200);
+  task.progress = tec->progress;
+  task.failed = AIR_FALSE;
+  /* LLS and WLS can be done many samples at a time, unless there is
+     per-sample verbosity to be had */
+  task.batch = ((tenEstimate1MethodLLS == tec->estimate1Method
+                 || tenEstimate1MethodWLS == tec->estimate1Method)
+                && !tec->verbose);
+  task.bootNum = 0;
+  task.rngSeed = 0;
+  threadNum = _tenEstimateThreadSetup(&task, tec->threadNum,
+                                      _TEN_ESTIMATE_CHUNK, mop, me);
+  if (!threadNum) {
+    airMopError(mop); return 1;
   }
-  fflush(stderr);
-  tick = NN / 200;
-  tick = AIR_MAX(1, tick);
-  for (II=0; II<NN; II++) {
-    if (tec->progress && 0 == II%tick) {
-      fprintf(stderr, "%s", airDoneStr(0, II, NN-1, doneStr));
-    }
-    for (dd=0; dd<tec->allNum; dd++) {
-      all[dd] = lup(ndwi->data, dd + tec->allNum*II);
-    }
-    /*
-    tec->verbose = 10*(II == 42509);
-    */
-    if (tec->verbose) {
-      fprintf(stderr, "!%s: hello; II=%u\n", me, AIR_CAST(unsigned int, II));
+  arg = AIR_CALLOC(threadNum, _tenEstimateThreadArg);
+  airMopAdd(mop, arg, airFree, airMopAlways);
+  if (!arg) {
+    biffAddf(TEN, "%s: couldn't allocate per-thread info", me);
+    airMopError(mop); return 1;
+  }
+  for (ti=0; ti<threadNum; ti++) {
+    arg[ti].task = &task;
+    arg[ti].rng = NULL;
+    arg[ti].failed = AIR_FALSE;
+    arg[ti].failIdx = 0;
+    /* thread 0 uses the given context */
+    if (!ti) {
+      arg[ti].tec = tec;
+    } else {
+      if (!(arg[ti].tec = _tenEstimateContextClone(tec))) {
+        biffAddf(TEN, "%s: couldn't set up context for thread %u", me, ti);
+        airMopError(mop); return 1;
+      }
+      airMopAdd(mop, arg[ti].tec, (airMopper)tenEstimateContextNix,
+                airMopAlways);
+    }
+    arg[ti].all = AIR_CALLOC(tec->allNum*_TEN_ESTIMATE_CHUNK, double);
+    airMopAdd(mop, arg[ti].all, airFree, airMopAlways);
+    arg[ti].res = AIR_CALLOC(_TEN_ESTIMATE_RES*_TEN_ESTIMATE_CHUNK, double);
+    airMopAdd(mop, arg[ti].res, airFree, airMopAlways);
+    if (task.batch) {
+      arg[ti].buff = AIR_CALLOC(_TEN_ESTIMATE_BATCH_BUFF(tec->dwiNum),
+                                double);
+      airMopAdd(mop, arg[ti].buff, airFree, airMopAlways);
+      arg[ti].okay = AIR_CALLOC(_TEN_ESTIMATE_CHUNK, unsigned char);
+      airMopAdd(mop, arg[ti].okay, airFree, airMopAlways);
+    } else {
+      arg[ti].buff = NULL;
+      arg[ti].okay = NULL;
     }
-    if (tenEstimate1TensorSingle_d(tec, ten, all)) {
-      biffAddf(TEN, "%s: failed at sample %s", me,
-               airSprintSize_t(stmp, II));
+    if (!( arg[ti].all && arg[ti].res
+           && (!task.batch || (arg[ti].buff && arg[ti].okay)) )) {
+      biffAddf(TEN, "%s: couldn't allocate buffers for thread %u", me, ti);
       airMopError(mop); return 1;
     }
-    ins(nten->data, 0 + sizeTen*II, ten[0]);
-    ins(nten->data, 1 + sizeTen*II, ten[1]);
-    ins(nten->data, 2 + sizeTen*II, ten[2]);
-    ins(nten->data, 3 + sizeTen*II, ten[3]);
-    ins(nten->data, 4 + sizeTen*II, ten[4]);
-    ins(nten->data, 5 + sizeTen*II, ten[5]);
-    ins(nten->data, 6 + sizeTen*II, ten[6]);
-    if (nB0P) {
-      ins((*nB0P)->data, II, (tec->estimateB0
-                              ? tec->estimatedB0
-                              : tec->knownB0));
-    }
-    if (nterrP) {
-      /* this works because above we checked that only one of the
-         tec->record* flags is set */
-      if (tec->recordErrorDwi) {
-        ins((*nterrP)->data, II, tec->errorDwi);
-      } else if (tec->recordErrorLogDwi) {
-        ins((*nterrP)->data, II, tec->errorLogDwi);
-      } else if (tec->recordLikelihoodDwi) {
-        ins((*nterrP)->data, II, tec->likelihoodDwi);
-      }
-    }
   }
   if (tec->progress) {
-    fprintf(stderr, "%s\n", airDoneStr(0, II, NN-1, doneStr));
+    fprintf(stderr, "%s:       ", me);
+  }
+  fflush(stderr);
+  if (_tenEstimateThreadRun(arg, threadNum, _tenEstimateWorker)) {
+    biffAddf(TEN, "%s: trouble estimating", me);
+    airMopError(mop); return 1;
+  }
+  if (tec->progress) {
+    fprintf(stderr, "%s\n", airDoneStr(0, task.NN, task.NN-1, doneStr));
   }
 
   ELL_4V_SET(axmap, -1, 1, 2, 3);
@@ -2089,3 +2743,250 @@ tenEstimate1TensorVolume4D(tenEstimateContext *tec,
   airMopOkay(mop);
   return 0;
 }
+
+/*
+** how many voxels a thread in tenEstimate1TensorBootstrap() takes at
+** once; each is bootNum+1 estimations
+*/
+#define _TEN_ESTIMATE_BOOT_CHUNK 4
+
+/*
+** _tenEstimate1TensorBoot
+**
+** wild bootstrap of single-tensor estimation at one sample: the tensor
+** is fit to all, and then each of bootNum new sets of values is the
+** values predicted by that fit plus its residuals, each with a random
+** sign.  The tensor fit to bootstrap set bi is put in boot + 7*bi.  buff
+** has to be allocated for 2*tec->allNum.
+*/
+static int
+_tenEstimate1TensorBoot(double *boot, tenEstimateContext *tec, double *buff,
+                        const double *all, unsigned int bootNum,
+                        airRandMTState *rng) {
+  static const char me[]="_tenEstimate1TensorBoot";
+  double ten[7], B0, *pred, *samp;
+  unsigned int ai, di, bi;
+
+  pred = buff;
+  samp = buff + tec->allNum;
+  if (tenEstimate1TensorSingle_d(tec, ten, all)) {
+    biffAddf(TEN, "%s: couldn't fit tensor to sample", me);
+    return 1;
+  }
+  B0 = tec->estimateB0 ? tec->estimatedB0 : tec->knownB0;
+  if (_tenEstimate1TensorSimulateSingle(tec, 0.0, tec->bValue, B0, ten)) {
+    biffAddf(TEN, "%s: couldn't predict values", me);
+    return 1;
+  }
+  /* same sorting of values into DWIs and B0s as _tenEstimateValuesSet;
+     skipped values aren't changed */
+  di = 0;
+  for (ai=0; ai<tec->allNum; ai++) {
+    if (tec->skipLut[ai]) {
+      pred[ai] = all[ai];
+    } else if (tec->estimateB0 || tec->bnorm[ai]) {
+      pred[ai] = tec->dwiTmp[di++];
+    } else {
+      pred[ai] = tec->knownB0;
+    }
+  }
+  for (bi=0; bi<bootNum; bi++) {
+    for (ai=0; ai<tec->allNum; ai++) {
+      samp[ai] = (pred[ai] + ((airUIrandMT_r(rng) & 1) ? 1 : -1)
+                  *(all[ai] - pred[ai]));
+    }
+    if (tenEstimate1TensorSingle_d(tec, boot + 7*bi, samp)) {
+      biffAddf(TEN, "%s: couldn't fit tensor to bootstrap %u", me, bi);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static void *
+_tenEstimateBootWorker(void *_arg) {
+  _tenEstimateThreadArg *arg;
+  _tenEstimateTask *task;
+  tenEstimateContext *tec;
+  char doneStr[20];
+  size_t II, lo, hi;
+  double (*lup)(const void *, size_t), (*ins)(void *v, size_t I, double d);
+  unsigned int dd, bi;
+
+  arg = AIR_CAST(_tenEstimateThreadArg *, _arg);
+  task = arg->task;
+  tec = arg->tec;
+  lup = nrrdDLookup[task->ndwi->type];
+  ins = nrrdDInsert[task->nten->type];
+  while (!arg->failed) {
+    if (task->workMutex) {
+      airThreadMutexLock(task->workMutex);
+    }
+    lo = task->workIdx;
+    hi = task->failed ? lo : AIR_MIN(lo + _TEN_ESTIMATE_BOOT_CHUNK,
+                                     task->NN);
+    task->workIdx = hi;
+    if (task->progress && lo < hi && lo/task->tick != hi/task->tick) {
+      fprintf(stderr, "%s", airDoneStr(0, lo, task->NN-1, doneStr));
+    }
+    if (task->workMutex) {
+      airThreadMutexUnlock(task->workMutex);
+    }
+    if (lo == hi) {
+      /* no more work */
+      break;
+    }
+    for (II=lo; II<hi; II++) {
+      for (dd=0; dd<tec->allNum; dd++) {
+        arg->all[dd] = lup(task->ndwi->data, dd + tec->allNum*II);
+      }
+      /* re-seeded at every voxel, so that the results don't depend on
+         which thread did the voxel */
+      airSrandMT_r(arg->rng, task->rngSeed + AIR_CAST(unsigned int, II));
+      if (_tenEstimate1TensorBoot(arg->res, tec, arg->buff, arg->all,
+                                  task->bootNum, arg->rng)) {
+        arg->failed = AIR_TRUE;
+        arg->failIdx = II;
+        /* other threads stop at their next chunk */
+        if (task->workMutex) {
+          airThreadMutexLock(task->workMutex);
+        }
+        task->failed = AIR_TRUE;
+        if (task->workMutex) {
+          airThreadMutexUnlock(task->workMutex);
+        }
+        break;
+      }
+      for (bi=0; bi<task->bootNum; bi++) {
+        for (dd=0; dd<7; dd++) {
+          ins(task->nten->data, dd + 7*(bi + task->bootNum*II),
+              arg->res[dd + 7*bi]);
+        }
+      }
+    }
+  }
+  return _arg;
+}
+
+/*
+******** tenEstimate1TensorBootstrap
+**
+** wild bootstrap of single-tensor estimation in the 4-D DWI volume ndwi:
+** at each voxel, bootNum tensors are fit to the values predicted by the
+** tensor fit to ndwi, plus the residuals of that fit with random signs
+** (see _tenEstimate1TensorBoot).  These samples of the uncertainty in
+** the tensor are put in nboot, a 5-D 7-by-bootNum-by-X-by-Y-by-Z volume
+** of outType (float or double), which is what tenFiberProbTrace wants.
+**
+** Uses tec->threadNum threads.  The random numbers at each voxel come
+** from rngSeed and the voxel index, so the results are the same for any
+** number of threads.
+*/
+int
+tenEstimate1TensorBootstrap(tenEstimateContext *tec, Nrrd *nboot,
+                            const Nrrd *ndwi, unsigned int bootNum,
+                            unsigned int rngSeed, int outType) {
+  static const char me[]="tenEstimate1TensorBootstrap";
+  char doneStr[20];
+  unsigned int ti, threadNum;
+  _tenEstimateTask task;
+  _tenEstimateThreadArg *arg;
+  airArray *mop;
+  int axmap[5];
+
+  if (!(tec && nboot && ndwi)) {
+    biffAddf(TEN, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (!bootNum) {
+    biffAddf(TEN, "%s: need non-zero number of bootstrap samples", me);
+    return 1;
+  }
+  if (_tenEstimateVolumeCheck(tec, ndwi, outType)) {
+    biffAddf(TEN, "%s: problem with input", me);
+    return 1;
+  }
+  if (nrrdMaybeAlloc_va(nboot, outType, 5,
+                        nrrdKindSize(nrrdKind3DMaskedSymMatrix),
+                        AIR_CAST(size_t, bootNum), ndwi->axis[1].size,
+                        ndwi->axis[2].size, ndwi->axis[3].size)) {
+    biffMovef(TEN, NRRD, "%s: couldn't allocate output", me);
+    return 1;
+  }
+  mop = airMopNew();
+  task.ndwi = ndwi;
+  task.nten = nboot;
+  task.nB0 = task.nterr = NULL;
+  task.bootNum = bootNum;
+  task.rngSeed = rngSeed;
+  task.NN = ndwi->axis[1].size*ndwi->axis[2].size*ndwi->axis[3].size;
+  task.workIdx = 0;
+  task.tick = AIR_MAX(1, task.NN / 200);
+  task.progress = tec->progress;
+  task.batch = AIR_FALSE;
+  task.failed = AIR_FALSE;
+  threadNum = _tenEstimateThreadSetup(&task, tec->threadNum,
+                                      _TEN_ESTIMATE_BOOT_CHUNK, mop, me);
+  if (!threadNum) {
+    airMopError(mop); return 1;
+  }
+  arg = AIR_CALLOC(threadNum, _tenEstimateThreadArg);
+  airMopAdd(mop, arg, airFree, airMopAlways);
+  if (!arg) {
+    biffAddf(TEN, "%s: couldn't allocate per-thread info", me);
+    airMopError(mop); return 1;
+  }
+  for (ti=0; ti<threadNum; ti++) {
+    arg[ti].task = &task;
+    arg[ti].failed = AIR_FALSE;
+    arg[ti].failIdx = 0;
+    arg[ti].okay = NULL;
+    if (!ti) {
+      arg[ti].tec = tec;
+    } else {
+      if (!(arg[ti].tec = _tenEstimateContextClone(tec))) {
+        biffAddf(TEN, "%s: couldn't set up context for thread %u", me, ti);
+        airMopError(mop); return 1;
+      }
+      airMopAdd(mop, arg[ti].tec, (airMopper)tenEstimateContextNix,
+                airMopAlways);
+    }
+    arg[ti].all = AIR_CALLOC(tec->allNum, double);
+    airMopAdd(mop, arg[ti].all, airFree, airMopAlways);
+    arg[ti].res = AIR_CALLOC(7*bootNum, double);
+    airMopAdd(mop, arg[ti].res, airFree, airMopAlways);
+    arg[ti].buff = AIR_CALLOC(2*tec->allNum, double);
+    airMopAdd(mop, arg[ti].buff, airFree, airMopAlways);
+    arg[ti].rng = airRandMTStateNew(0);
+    airMopAdd(mop, arg[ti].rng, (airMopper)airRandMTStateNix, airMopAlways);
+    if (!( arg[ti].all && arg[ti].res && arg[ti].buff && arg[ti].rng )) {
+      biffAddf(TEN, "%s: couldn't allocate buffers for thread %u", me, ti);
+      airMopError(mop); return 1;
+    }
+  }
+  if (tec->progress) {
+    fprintf(stderr, "%s:       ", me);
+  }
+  fflush(stderr);
+  if (_tenEstimateThreadRun(arg, threadNum, _tenEstimateBootWorker)) {
+    biffAddf(TEN, "%s: trouble bootstrapping", me);
+    airMopError(mop); return 1;
+  }
+  if (tec->progress) {
+    fprintf(stderr, "%s\n", airDoneStr(0, task.NN, task.NN-1, doneStr));
+  }
+
+  axmap[0] = axmap[1] = -1;
+  ELL_3V_SET(axmap + 2, 1, 2, 3);
+  nrrdAxisInfoCopy(nboot, ndwi, axmap, NRRD_AXIS_INFO_NONE);
+  nboot->axis[0].kind = nrrdKind3DMaskedSymMatrix;
+  nboot->axis[1].kind = nrrdKindList;
+  if (nrrdBasicInfoCopy(nboot, ndwi,
+                        NRRD_BASIC_INFO_ALL ^ NRRD_BASIC_INFO_SPACE)) {
+    biffMovef(TEN, NRRD, "%s:", me);
+    airMopError(mop); return 1;
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
@@ -34,6 +34,10 @@
 **   tfx->fiberEval (all 3 evals)
 **   tfx->fiberEvec (all 3 eigenvectors)
 **   if (tfx->stop & (1 << tenFiberStopAniso): tfx->fiberAnisoStop
+**   if (tfx->anisoSpeedType): tfx->fiberAnisoSpeed
+**
+** or, with tfx->dcache, these (except for fiberEvec beyond the first
+** eigenvector) are instead interpolated from the cache.
 **
 ** In the case of non-single-tensor tractography, we do so based on
 ** ten2Which (when at the seedpoint) or
@@ -58,6 +62,14 @@ _tenFiberProbe(tenFiberContext *tfx, int *gageRet,
   int ret = 0;
   double tens2[2][7];
 
+  if (tfx->dcache) {
+    /* interpolating the tenFiberDirCache; gage isn't involved */
+    *gageRet = _tenFiberDirCacheProbe(tfx, wPos);
+    if (seedProbe) {
+      ELL_3V_COPY(tfx->seedEvec, tfx->fiberEvec);
+    }
+    return 0;
+  }
   gageShapeWtoI(tfx->gtx->shape, iPos, wPos);
   *gageRet = gageProbe(tfx->gtx, iPos[0], iPos[1], iPos[2]);
 
@@ -75,6 +87,9 @@ _tenFiberProbe(tenFiberContext *tfx, int *gageRet,
     if (tfx->stop & (1 << tenFiberStopAniso)) {
       tfx->fiberAnisoStop = tfx->gageAnisoStop[0];
     }
+    if (tfx->anisoSpeedType) {
+      tfx->fiberAnisoSpeed = tfx->gageAnisoSpeed[0];
+    }
     if (seedProbe) {
       ELL_3V_COPY(tfx->seedEvec, tfx->fiberEvec);
     }
@@ -546,7 +561,8 @@ _fiberTraceSet(tenFiberContext *tfx, Nrrd *nval, Nrrd *nfiber,
     return 1;
   }
   if (gret) {
-    if (gageErrBoundsSpace != tfx->gtx->errNum) {
+    /* with a direction cache, gret only means out of bounds */
+    if (!tfx->dcache && gageErrBoundsSpace != tfx->gtx->errNum) {
       biffAddf(TEN, "%s: gage problem on first _tenFiberProbe: %s (%d)",
               me, tfx->gtx->errStr, tfx->gtx->errNum);
       return 1;
@@ -673,6 +689,13 @@ _fiberTraceSet(tenFiberContext *tfx, Nrrd *nval, Nrrd *nfiber,
         ELL_3V_COPY(currPoint, tfx->wPos);
       }
       if (nval) {
+        if (tfx->dcache) {
+          /* the cache only has what's needed for tracking; the probe
+             item still comes from gage.  The position is known to be
+             inside the volume, so the return is not checked */
+          gageShapeWtoI(tfx->gtx->shape, tmp, tfx->wPos);
+          gageProbe(tfx->gtx, tmp[0], tmp[1], tmp[2]);
+        }
         pansIdx = airArrayLenIncr(pansArr[tfx->halfIdx], 1);
         /* HEY: speed this up */
         memcpy(pans[tfx->halfIdx] + pansLen*pansIdx, pansP,
@@ -1042,30 +1065,209 @@ tenFiberMultiNix(tenFiberMulti *tfm) {
 }
 
 /*
-******** tenFiberMultiTrace
-**
-** does tractography for a list of seedpoints
-**
-** tfml has been returned from tenFiberMultiNew()
+** how many seeds a thread in tenFiberMultiTrace() takes at once
 */
-int
-tenFiberMultiTrace(tenFiberContext *tfx, tenFiberMulti *tfml,
-                   const Nrrd *_nseed) {
+#define _TEN_FIBER_CHUNK 32
+
+/*
+** _tenFiberTask, _tenFiberThreadArg: for tenFiberMultiTrace and
+** tenFiberStreamTrace, with chunks of seeds handed out to threads
+*/
+typedef struct {
+  tenFiberMulti *tfml;        /* where all fibers go, or NULL if ... */
+  tenFiberStream *tfst;       /* ... they go here instead */
+  const double *seedData;
+  const unsigned int *fiberStart; /* fibers of seed ii are
+                                     fiberStart[ii] to fiberStart[ii+1]-1 */
+  unsigned int seedNum,
+    workIdx,                  /* first seed of next chunk to hand out */
+    writeIdx;                 /* first seed of next chunk to write to tfst */
+  int failed;                 /* some thread has failed */
+  airThreadMutex *workMutex;  /* NULL for a single thread */
+  airThreadCond *writeCond;   /* signals change in writeIdx, or failure;
+                                 NULL for a single thread */
+} _tenFiberTask;
+
+typedef struct {
+  _tenFiberTask *task;
+  tenFiberContext *tfx;       /* context for this thread */
+  tenFiberMulti *tfml;        /* with tfst: this thread's fibers of the
+                                 current chunk */
+  int failed,                 /* tracing failed in this thread */
+    failWrite;                /* it was writing to tfst that failed */
+  unsigned int failSeed,      /* at which seed it failed */
+    failDir;                  /* and in which direction */
+} _tenFiberThreadArg;
+
+static void
+_tenFiberFail(_tenFiberTask *task) {
+
+  if (task->workMutex) {
+    airThreadMutexLock(task->workMutex);
+  }
+  task->failed = AIR_TRUE;
+  if (task->writeCond) {
+    airThreadCondBroadcast(task->writeCond);
+  }
+  if (task->workMutex) {
+    airThreadMutexUnlock(task->workMutex);
+  }
+  return;
+}
+
+/*
+** with tfst, writes the fibers of seeds lo through hi-1, once all those
+** before them have been written, so that the fibers are written in seed
+** order.  Chunks are handed out in seed order, so the thread with the
+** next chunk to write is never waiting on another.  Returns non-zero if
+** some thread has failed
+*/
+static int
+_tenFiberWrite(_tenFiberThreadArg *arg, unsigned int lo, unsigned int hi) {
+  _tenFiberTask *task;
+  unsigned int fi, fibrNum;
+  int failed;
+
+  task = arg->task;
+  if (task->workMutex) {
+    airThreadMutexLock(task->workMutex);
+    while (!task->failed && task->writeIdx != lo) {
+      airThreadCondWait(task->writeCond, task->workMutex);
+    }
+    failed = task->failed;
+    airThreadMutexUnlock(task->workMutex);
+  } else {
+    failed = task->failed;
+  }
+  if (failed) {
+    return 1;
+  }
+  fibrNum = task->fiberStart[hi] - task->fiberStart[lo];
+  for (fi=0; fi<fibrNum; fi++) {
+    if (tenFiberStreamAdd(task->tfst, arg->tfml->fiber + fi)) {
+      arg->failed = arg->failWrite = AIR_TRUE;
+      arg->failSeed = lo;
+      _tenFiberFail(task);
+      return 1;
+    }
+  }
+  if (task->workMutex) {
+    airThreadMutexLock(task->workMutex);
+  }
+  task->writeIdx = hi;
+  if (task->writeCond) {
+    airThreadCondBroadcast(task->writeCond);
+  }
+  if (task->workMutex) {
+    airThreadMutexUnlock(task->workMutex);
+  }
+  return 0;
+}
+
+static void *
+_tenFiberWorker(void *_arg) {
   static const char me[]="tenFiberMultiTrace";
+  _tenFiberThreadArg *arg;
+  _tenFiberTask *task;
+  tenFiberContext *tfx;
+  tenFiberSingle *tfbs;
+  double seed[3];
+  unsigned int lo, hi, seedIdx, dirIdx, dirNum, fibrIdx, fibrBase;
+
+  arg = AIR_CAST(_tenFiberThreadArg *, _arg);
+  task = arg->task;
+  tfx = arg->tfx;
+  for (;;) {
+    if (task->workMutex) {
+      airThreadMutexLock(task->workMutex);
+    }
+    lo = task->workIdx;
+    hi = task->failed ? lo : AIR_MIN(lo + _TEN_FIBER_CHUNK, task->seedNum);
+    task->workIdx = hi;
+    if (task->workMutex) {
+      airThreadMutexUnlock(task->workMutex);
+    }
+    if (lo == hi) {
+      /* no more work */
+      break;
+    }
+    if (task->tfst) {
+      /* this chunk's fibers go (temporarily) in arg->tfml, re-using the
+         allocations from the previous chunk */
+      fibrBase = task->fiberStart[lo];
+      airArrayLenSet(arg->tfml->fiberArr, task->fiberStart[hi] - fibrBase);
+      if (!arg->tfml->fiber) {
+        arg->failed = AIR_TRUE;
+        arg->failSeed = lo;
+        arg->failDir = 0;
+        _tenFiberFail(task);
+        return _arg;
+      }
+    } else {
+      fibrBase = 0;
+    }
+    for (seedIdx=lo; seedIdx<hi; seedIdx++) {
+      fibrIdx = task->fiberStart[seedIdx];
+      dirNum = task->fiberStart[seedIdx+1] - fibrIdx;
+      for (dirIdx=0; dirIdx<dirNum; dirIdx++, fibrIdx++) {
+        tfbs = (task->tfst
+                ? arg->tfml->fiber + fibrIdx - fibrBase
+                : task->tfml->fiber + fibrIdx);
+        tfbs->dirNum = dirNum;
+        if (tfx->verbose > 1) {
+          fprintf(stderr, "%s: dir %u/%u on seed %u/%u; # %u\n",
+                  me, dirIdx, dirNum, seedIdx, task->seedNum, fibrIdx);
+        }
+        ELL_3V_COPY(seed, task->seedData + 3*seedIdx);
+        if (tenFiberSingleTrace(tfx, tfbs, seed, dirIdx)) {
+          arg->failed = AIR_TRUE;
+          arg->failSeed = seedIdx;
+          arg->failDir = dirIdx;
+          /* other threads stop at their next chunk */
+          _tenFiberFail(task);
+          return _arg;
+        }
+        if (tfx->verbose) {
+          if (tenFiberStopUnknown == tfbs->whyNowhere) {
+            fprintf(stderr, "%s: (%g,%g,%g) ->\n"
+                    "   steps = %u,%u; len = %g,%g; whyStop = %s,%s\n",
+                    me, seed[0], seed[1], seed[2],
+                    tfbs->stepNum[0], tfbs->stepNum[1],
+                    tfbs->halfLen[0], tfbs->halfLen[1],
+                    airEnumStr(tenFiberStop, tfbs->whyStop[0]),
+                    airEnumStr(tenFiberStop, tfbs->whyStop[1]));
+          } else {
+            fprintf(stderr, "%s: (%g,%g,%g) -> whyNowhere: %s\n",
+                    me, seed[0], seed[1], seed[2],
+                    airEnumStr(tenFiberStop, tfbs->whyNowhere));
+          }
+        }
+      }
+    }
+    if (task->tfst && _tenFiberWrite(arg, lo, hi)) {
+      return _arg;
+    }
+  }
+  return _arg;
+}
+
+/*
+** traces from all the seeds into either tfml (if non-NULL) or tfst;
+** see tenFiberMultiTrace() and tenFiberStreamTrace()
+*/
+static int
+_fiberMultiTrace(tenFiberContext *tfx, tenFiberMulti *tfml,
+                 tenFiberStream *tfst, const Nrrd *_nseed) {
+  static const char me[]="_fiberMultiTrace";
   airArray *mop;
   const double *seedData;
   double seed[3];
-  unsigned int seedNum, seedIdx, fibrNum, dirNum, dirIdx;
+  unsigned int seedNum, seedIdx, fibrNum, dirNum, dirIdx, *fiberStart,
+    ti, threadNum;
   Nrrd *nseed;
+  _tenFiberTask task;
+  _tenFiberThreadArg *arg;
 
-  if (!(tfx && tfml && _nseed)) {
-    biffAddf(TEN, "%s: got NULL pointer", me);
-    return 1;
-  }
-  if (tenFiberMultiCheck(tfml->fiberArr)) {
-    biffAddf(TEN, "%s: problem with fiber array", me);
-    return 1;
-  }
   if (!(2 == _nseed->dim && 3 == _nseed->axis[0].size)) {
     biffAddf(TEN, "%s: seed list should be a 2-D (not %u-D) "
             "3-by-X (not %u-by-X) array", me, _nseed->dim,
@@ -1083,68 +1285,232 @@ tenFiberMultiTrace(tenFiberContext *tfx, tenFiberMulti *tfml,
     airMopAdd(mop, nseed, AIR_CAST(airMopper, nrrdNuke), airMopAlways);
     if (nrrdConvert(nseed, _nseed, nrrdTypeDouble)) {
       biffMovef(TEN, NRRD, "%s: couldn't convert seed list", me);
-      return 1;
+      airMopError(mop); return 1;
     }
     seedData = AIR_CAST(const double *, nseed->data);
   }
 
-  /* HEY: the correctness of the use of the airArray here is quite subtle */
+  /* learn where the fibers of each seed will go */
+  fiberStart = AIR_CALLOC(seedNum+1, unsigned int);
+  airMopAdd(mop, fiberStart, airFree, airMopAlways);
+  if (!fiberStart) {
+    biffAddf(TEN, "%s: couldn't allocate fiber index", me);
+    airMopError(mop); return 1;
+  }
   fibrNum = 0;
   for (seedIdx=0; seedIdx<seedNum; seedIdx++) {
+    ELL_3V_COPY(seed, seedData + 3*seedIdx);
     dirNum = tenFiberDirectionNumber(tfx, seed);
     if (!dirNum) {
       biffAddf(TEN, "%s: couldn't learn dirNum at seed (%g,%g,%g)", me,
               seed[0], seed[1], seed[2]);
-      return 1;
+      airMopError(mop); return 1;
+    }
+    fiberStart[seedIdx] = fibrNum;
+    fibrNum += dirNum;
+  }
+  fiberStart[seedNum] = fibrNum;
+  if (tfml) {
+    /* if the airArray was already this long (from a previous call), this
+       is a no-op, and its tenFiberSingle's (and their allocations) are
+       re-used.  Otherwise, via the callbacks, it will create the new
+       tenFiberSingle's we need, or clear out the ones we don't */
+    airArrayLenSet(tfml->fiberArr, fibrNum);
+    if (fibrNum && !tfml->fiber) {
+      biffAddf(TEN, "%s: couldn't allocate %u fibers", me, fibrNum);
+      airMopError(mop); return 1;
     }
-    for (dirIdx=0; dirIdx<dirNum; dirIdx++) {
-      if (tfx->verbose > 1) {
-        fprintf(stderr, "%s: dir %u/%u on seed %u/%u; len %u; # %u\n",
-                me, dirIdx, dirNum, seedIdx, seedNum,
-                tfml->fiberArr->len, fibrNum);
+    for (seedIdx=0; seedIdx<seedNum; seedIdx++) {
+      dirNum = fiberStart[seedIdx+1] - fiberStart[seedIdx];
+      for (dirIdx=0; dirIdx<dirNum; dirIdx++) {
+        tenFiberSingle *tfbs;
+        tfbs = tfml->fiber + fiberStart[seedIdx] + dirIdx;
+        ELL_3V_COPY(tfbs->seedPos, seedData + 3*seedIdx);
+        tfbs->dirIdx = dirIdx;
+        tfbs->dirNum = dirNum;
       }
-      /* tfml->fiberArr->len can never be < fibrNum */
-      if (tfml->fiberArr->len == fibrNum) {
-        airArrayLenIncr(tfml->fiberArr, 1);
+    }
+  }
+
+  task.tfml = tfml;
+  task.tfst = tfml ? NULL : tfst;
+  task.seedData = seedData;
+  task.fiberStart = fiberStart;
+  task.seedNum = seedNum;
+  task.workIdx = 0;
+  task.writeIdx = 0;
+  task.failed = AIR_FALSE;
+  task.writeCond = NULL;
+  /* no more threads than chunks */
+  threadNum = AIR_MIN(tfx->threadNum,
+                      (seedNum + _TEN_FIBER_CHUNK - 1)/_TEN_FIBER_CHUNK);
+  threadNum = AIR_MAX(threadNum, 1);
+  if (1 < threadNum && tfx->useDwi) {
+    fprintf(stderr, "%s: WARNING: can't copy DWI fiber contexts, so "
+            "using 1 thread, not %u\n", me, threadNum);
+    threadNum = 1;
+  }
+  arg = AIR_CALLOC(threadNum, _tenFiberThreadArg);
+  airMopAdd(mop, arg, airFree, airMopAlways);
+  if (!arg) {
+    biffAddf(TEN, "%s: couldn't allocate per-thread info", me);
+    airMopError(mop); return 1;
+  }
+  if (1 < threadNum) {
+    if (!( task.workMutex = airThreadMutexNew() )) {
+      biffAddf(TEN, "%s: couldn't create work mutex", me);
+      airMopError(mop); return 1;
+    }
+    airMopAdd(mop, task.workMutex, (airMopper)airThreadMutexNix,
+              airMopAlways);
+    if (task.tfst) {
+      if (!( task.writeCond = airThreadCondNew() )) {
+        biffAddf(TEN, "%s: couldn't create write condition", me);
+        airMopError(mop); return 1;
       }
-      ELL_3V_COPY(tfml->fiber[fibrNum].seedPos, seedData + 3*seedIdx);
-      tfml->fiber[fibrNum].dirIdx = dirIdx;
-      tfml->fiber[fibrNum].dirNum = dirNum;
-      ELL_3V_COPY(seed, seedData + 3*seedIdx);
-      if (tenFiberSingleTrace(tfx, &(tfml->fiber[fibrNum]), seed, dirIdx)) {
-        biffAddf(TEN, "%s: trouble on seed (%g,%g,%g) %u/%u, dir %u/%u", me,
-                seed[0], seed[1], seed[2], seedIdx, seedNum, dirIdx, dirNum);
-        return 1;
+      airMopAdd(mop, task.writeCond, (airMopper)airThreadCondNix,
+                airMopAlways);
+    }
+    if (!airThreadCapable) {
+      fprintf(stderr, "%s: WARNING: not multi-threaded; will do %u "
+              "\"threads\" serially !!!\n", me, threadNum);
+    }
+    /* before the threads start, which may use biff */
+    if (biffThreadSafe()) {
+      biffAddf(TEN, "%s: couldn't make biff thread-safe", me);
+      airMopError(mop); return 1;
+    }
+  } else {
+    task.workMutex = NULL;
+  }
+  for (ti=0; ti<threadNum; ti++) {
+    arg[ti].task = &task;
+    arg[ti].failed = arg[ti].failWrite = AIR_FALSE;
+    arg[ti].failSeed = arg[ti].failDir = 0;
+    /* thread 0 uses the given context */
+    if (!ti) {
+      arg[ti].tfx = tfx;
+    } else {
+      if (!(arg[ti].tfx = tenFiberContextCopy(tfx))) {
+        biffAddf(TEN, "%s: couldn't set up context for thread %u", me, ti);
+        airMopError(mop); return 1;
       }
-      if (tfx->verbose) {
-        if (tenFiberStopUnknown == tfml->fiber[fibrNum].whyNowhere) {
-          fprintf(stderr, "%s: (%g,%g,%g) ->\n"
-                  "   steps = %u,%u; len = %g,%g; whyStop = %s,%s\n",
-                  me, seed[0], seed[1], seed[2],
-                  tfml->fiber[fibrNum].stepNum[0],
-                  tfml->fiber[fibrNum].stepNum[1],
-                  tfml->fiber[fibrNum].halfLen[0],
-                  tfml->fiber[fibrNum].halfLen[1],
-                  airEnumStr(tenFiberStop, tfml->fiber[fibrNum].whyStop[0]),
-                  airEnumStr(tenFiberStop, tfml->fiber[fibrNum].whyStop[1]));
-        } else {
-          fprintf(stderr, "%s: (%g,%g,%g) -> whyNowhere: %s\n",
-                  me, seed[0], seed[1], seed[2],
-                  airEnumStr(tenFiberStop, tfml->fiber[fibrNum].whyNowhere));
-        }
+      airMopAdd(mop, arg[ti].tfx, (airMopper)tenFiberContextNix,
+                airMopAlways);
+    }
+    if (task.tfst) {
+      if (!(arg[ti].tfml = tenFiberMultiNew())) {
+        biffAddf(TEN, "%s: couldn't set up fibers for thread %u", me, ti);
+        airMopError(mop); return 1;
+      }
+      airMopAdd(mop, arg[ti].tfml, (airMopper)tenFiberMultiNix,
+                airMopAlways);
+    } else {
+      arg[ti].tfml = NULL;
+    }
+  }
+  if (airThreadRun(_tenFiberWorker, arg, sizeof(*arg), threadNum)) {
+    biffAddf(TEN, "%s: couldn't run %u threads", me, threadNum);
+    airMopError(mop); return 1;
+  }
+  for (ti=0; ti<threadNum; ti++) {
+    if (arg[ti].failed) {
+      seedIdx = arg[ti].failSeed;
+      if (arg[ti].failWrite) {
+        biffAddf(TEN, "%s: trouble writing fibers of seeds %u to %u", me,
+                 seedIdx, AIR_MIN(seedIdx + _TEN_FIBER_CHUNK, seedNum) - 1);
+      } else {
+        ELL_3V_COPY(seed, seedData + 3*seedIdx);
+        biffAddf(TEN, "%s: trouble on seed (%g,%g,%g) %u/%u, dir %u/%u",
+                 me, seed[0], seed[1], seed[2], seedIdx, seedNum,
+                 arg[ti].failDir,
+                 fiberStart[seedIdx+1] - fiberStart[seedIdx]);
       }
-      fibrNum++;
+      airMopError(mop); return 1;
     }
   }
-  /* if the airArray got to be its length only because of the work above,
-     then the following will be a no-op.  Otherwise, via the callbacks,
-     it will clear out the tenFiberSingle's that we didn't create here */
-  airArrayLenSet(tfml->fiberArr, fibrNum);
 
   airMopOkay(mop);
   return 0;
 }
 
+/*
+******** tenFiberMultiTrace
+**
+** does tractography for a list of seedpoints
+**
+** tfml has been returned from tenFiberMultiNew()
+**
+** With tfx->threadNum (tenFiberParmThreadNum) more than one, the seeds
+** are handed out in chunks to that many threads, each with its own copy
+** (from tenFiberContextCopy) of tfx.  Each (seed, direction) pair has its
+** place in tfml->fiber[] decided before any tracing starts, so the
+** fibers are in the same (seed) order, and are the same, regardless of
+** the number of threads.  DWI contexts can't yet be copied, so tracing in
+** DWIs is done with one thread.
+*/
+int
+tenFiberMultiTrace(tenFiberContext *tfx, tenFiberMulti *tfml,
+                   const Nrrd *nseed) {
+  static const char me[]="tenFiberMultiTrace";
+
+  if (!(tfx && tfml && nseed)) {
+    biffAddf(TEN, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (tenFiberMultiCheck(tfml->fiberArr)) {
+    biffAddf(TEN, "%s: problem with fiber array", me);
+    return 1;
+  }
+  if (_fiberMultiTrace(tfx, tfml, NULL, nseed)) {
+    biffAddf(TEN, "%s: problem", me);
+    return 1;
+  }
+  return 0;
+}
+
+/*
+******** tenFiberStreamTrace
+**
+** like tenFiberMultiTrace(), but each fiber is written to tfst (with
+** tenFiberStreamAdd(), so fibers that went nowhere are skipped) soon
+** after it is traced, instead of all of them being kept in memory.
+** tfst has to have been opened with tenFiberStreamOpen(), with valLen
+** matching the tfx->fiberProbeItem answer length (or 0, for no item).
+** With multiple threads, each thread traces a chunk of seeds at a time,
+** and the chunks are written in seed order, so the file is the same
+** regardless of the number of threads.  Closing tfst is up to the
+** caller.
+*/
+int
+tenFiberStreamTrace(tenFiberContext *tfx, tenFiberStream *tfst,
+                    const Nrrd *nseed) {
+  static const char me[]="tenFiberStreamTrace";
+  unsigned int valLen;
+
+  if (!(tfx && tfst && nseed)) {
+    biffAddf(TEN, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (!tfst->file) {
+    biffAddf(TEN, "%s: stream not open for writing", me);
+    return 1;
+  }
+  valLen = (tfx->fiberProbeItem
+            ? gageAnswerLength(tfx->gtx, tfx->pvl, tfx->fiberProbeItem)
+            : 0);
+  if (valLen != tfst->valLen) {
+    biffAddf(TEN, "%s: stream opened for %u values per vertex, but probe "
+             "item gives %u", me, tfst->valLen, valLen);
+    return 1;
+  }
+  if (_fiberMultiTrace(tfx, NULL, tfst, nseed)) {
+    biffAddf(TEN, "%s: problem", me);
+    return 1;
+  }
+  return 0;
+}
+
 static int
 _fiberMultiExtract(tenFiberContext *tfx, Nrrd *nval,
                    limnPolyData *lpld, tenFiberMulti *tfml) {
@@ -0,0 +1,316 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "ten.h"
+#include "privateTen.h"
+
+/*
+** The record for each voxel in a tenFiberDirCache brick is
+** _TEN_FIBER_CACHE_REC floats:
+**    0: confidence
+**  1-6: tensor coefficients Dxx, Dxy, Dxz, Dyy, Dyz, Dzz
+**  7-9: eigenvalues
+** 10-12: the eigenvector being tracked
+**   13: the anisotropy for tenFiberStopAniso
+**   14: the anisotropy for tenFiberAnisoSpeedSet
+*/
+#define _TEN_FIBER_CACHE_REC 15
+#define _TEN_FIBER_CACHE_EVAL 7
+#define _TEN_FIBER_CACHE_EVEC 10
+#define _TEN_FIBER_CACHE_STOP 13
+#define _TEN_FIBER_CACHE_SPEED 14
+/* bricks are 2^_TEN_FIBER_CACHE_SHIFT voxels on edge */
+#define _TEN_FIBER_CACHE_SHIFT 3
+
+/*
+** _tenFiberDirCacheNew
+**
+** sets up (without computing anything) the cache for tracing with tfx,
+** which has to be for a tensor volume (not DWIs), with its fiber type,
+** and its aniso stop and speed types, already set
+*/
+tenFiberDirCache *
+_tenFiberDirCacheNew(const tenFiberContext *tfx) {
+  static const char me[]="_tenFiberDirCacheNew";
+  tenFiberDirCache *dcache;
+  unsigned int ai;
+  size_t bnum;
+
+  if (tfx->useDwi) {
+    biffAddf(TEN, "%s: can't cache directions in DWIs", me);
+    return NULL;
+  }
+  if (!( tenFiberTypeEvec0 == tfx->fiberType
+         || tenFiberTypeEvec1 == tfx->fiberType
+         || tenFiberTypeEvec2 == tfx->fiberType
+         || tenFiberTypeTensorLine == tfx->fiberType )) {
+    biffAddf(TEN, "%s: can't cache directions for fiber type %s", me,
+             airEnumStr(tenFiberType, tfx->fiberType));
+    return NULL;
+  }
+  for (ai=0; ai<3; ai++) {
+    if (!( tfx->nin->axis[1+ai].size >= 2 )) {
+      biffAddf(TEN, "%s: need at least 2 samples along axis %u (not %u)",
+               me, 1+ai, AIR_CAST(unsigned int, tfx->nin->axis[1+ai].size));
+      return NULL;
+    }
+  }
+  if (!( dcache = AIR_CALLOC(1, tenFiberDirCache) )) {
+    biffAddf(TEN, "%s: couldn't allocate cache", me);
+    return NULL;
+  }
+  dcache->nin = tfx->nin;
+  bnum = 1;
+  for (ai=0; ai<3; ai++) {
+    dcache->size[ai] = AIR_CAST(unsigned int, tfx->nin->axis[1+ai].size);
+    dcache->bnum[ai] = ((dcache->size[ai] + (1u << _TEN_FIBER_CACHE_SHIFT) - 1)
+                        >> _TEN_FIBER_CACHE_SHIFT);
+    bnum *= dcache->bnum[ai];
+  }
+  dcache->evecIdx = (tenFiberTypeEvec1 == tfx->fiberType
+                     ? 1
+                     : (tenFiberTypeEvec2 == tfx->fiberType ? 2 : 0));
+  dcache->anisoStopType = ((tfx->stop & (1 << tenFiberStopAniso))
+                           ? tfx->anisoStopType
+                           : tenAnisoUnknown);
+  dcache->anisoSpeedType = tfx->anisoSpeedType;
+  dcache->brickMade = 0;
+  dcache->brick = AIR_CALLOC(bnum, float *);
+  dcache->mutex = airThreadMutexNew();
+  if (!( dcache->brick && dcache->mutex )) {
+    biffAddf(TEN, "%s: couldn't allocate %u bricks", me,
+             AIR_CAST(unsigned int, bnum));
+    _tenFiberDirCacheNix(dcache);
+    return NULL;
+  }
+  return dcache;
+}
+
+tenFiberDirCache *
+_tenFiberDirCacheNix(tenFiberDirCache *dcache) {
+  size_t bi, bnum;
+
+  if (dcache) {
+    if (dcache->brick) {
+      bnum = _tenFiberDirCacheBrickNum(dcache);
+      for (bi=0; bi<bnum; bi++) {
+        airFree(dcache->brick[bi]);
+      }
+      airFree(dcache->brick);
+    }
+    if (dcache->mutex) {
+      airThreadMutexNix(dcache->mutex);
+    }
+    airFree(dcache);
+  }
+  return NULL;
+}
+
+size_t
+_tenFiberDirCacheBrickNum(const tenFiberDirCache *dcache) {
+
+  return (AIR_CAST(size_t, dcache->bnum[0])*dcache->bnum[1]
+          *dcache->bnum[2]);
+}
+
+/* computes the records of brick bidx, or returns NULL if it couldn't be
+   allocated */
+static float *
+_tenFiberDirCacheBrickCompute(const tenFiberDirCache *dcache, size_t bidx) {
+  double (*lup)(const void *, size_t), ten[7], eval[3], evec[9];
+  unsigned int bb[3], lo[3], hi[3], xi, yi, zi, ci, edge;
+  size_t sidx;
+  float *brick, *rec;
+
+  edge = 1u << _TEN_FIBER_CACHE_SHIFT;
+  brick = AIR_CALLOC(edge*edge*edge*_TEN_FIBER_CACHE_REC, float);
+  if (!brick) {
+    return NULL;
+  }
+  bb[0] = AIR_CAST(unsigned int, bidx % dcache->bnum[0]);
+  bb[1] = AIR_CAST(unsigned int, (bidx/dcache->bnum[0]) % dcache->bnum[1]);
+  bb[2] = AIR_CAST(unsigned int, bidx/dcache->bnum[0]/dcache->bnum[1]);
+  for (ci=0; ci<3; ci++) {
+    lo[ci] = bb[ci] << _TEN_FIBER_CACHE_SHIFT;
+    hi[ci] = AIR_MIN(lo[ci] + edge, dcache->size[ci]);
+  }
+  lup = nrrdDLookup[dcache->nin->type];
+  for (zi=lo[2]; zi<hi[2]; zi++) {
+    for (yi=lo[1]; yi<hi[1]; yi++) {
+      for (xi=lo[0]; xi<hi[0]; xi++) {
+        sidx = xi + dcache->size[0]*(yi + AIR_CAST(size_t,
+                                                   dcache->size[1])*zi);
+        for (ci=0; ci<7; ci++) {
+          ten[ci] = lup(dcache->nin->data, ci + 7*sidx);
+        }
+        tenEigensolve_d(eval, evec, ten);
+        rec = brick + _TEN_FIBER_CACHE_REC*((xi - lo[0])
+                                            + edge*((yi - lo[1])
+                                                    + edge*(zi - lo[2])));
+        for (ci=0; ci<7; ci++) {
+          rec[ci] = AIR_CAST(float, ten[ci]);
+        }
+        ELL_3V_COPY_TT(rec + _TEN_FIBER_CACHE_EVAL, float, eval);
+        ELL_3V_COPY_TT(rec + _TEN_FIBER_CACHE_EVEC, float,
+                       evec + 3*dcache->evecIdx);
+        rec[_TEN_FIBER_CACHE_STOP] =
+          (dcache->anisoStopType
+           ? AIR_CAST(float, tenAnisoEval_d(eval, dcache->anisoStopType))
+           : 0.0f);
+        rec[_TEN_FIBER_CACHE_SPEED] =
+          (dcache->anisoSpeedType
+           ? AIR_CAST(float, tenAnisoEval_d(eval, dcache->anisoSpeedType))
+           : 0.0f);
+      }
+    }
+  }
+  return brick;
+}
+
+/*
+** the record for voxel (xi,yi,zi), computing its brick if it hasn't been
+** yet.  As with gageStackLazy, the computation is done without holding
+** the mutex, so that different threads can compute different bricks at
+** the same time, and a context only looks at dcache->brick[] (through
+** the mutex) for bricks that it hasn't already seen.  Returns NULL if
+** the brick couldn't be allocated.
+*/
+static const float *
+_tenFiberDirCacheRecord(tenFiberContext *tfx, unsigned int xi,
+                        unsigned int yi, unsigned int zi) {
+  tenFiberDirCache *dcache;
+  unsigned int sh, mask;
+  size_t bidx;
+  float *data;
+
+  dcache = tfx->dcache;
+  sh = _TEN_FIBER_CACHE_SHIFT;
+  mask = (1u << sh) - 1;
+  bidx = (xi >> sh) + dcache->bnum[0]*((yi >> sh)
+                                       + AIR_CAST(size_t, dcache->bnum[1])
+                                       *(zi >> sh));
+  if (!tfx->dcacheSeen[bidx]) {
+    airThreadMutexLock(dcache->mutex);
+    data = dcache->brick[bidx];
+    airThreadMutexUnlock(dcache->mutex);
+    if (!data) {
+      if (!( data = _tenFiberDirCacheBrickCompute(dcache, bidx) )) {
+        return NULL;
+      }
+      airThreadMutexLock(dcache->mutex);
+      if (!dcache->brick[bidx]) {
+        dcache->brick[bidx] = data;
+        dcache->brickMade++;
+      } else {
+        /* another thread finished it first */
+        airFree(data);
+        data = dcache->brick[bidx];
+      }
+      airThreadMutexUnlock(dcache->mutex);
+    }
+    tfx->dcacheSeen[bidx] = data;
+  }
+  return (tfx->dcacheSeen[bidx]
+          + _TEN_FIBER_CACHE_REC*((xi & mask)
+                                  + ((yi & mask) << sh)
+                                  + ((zi & mask) << (2*sh))));
+}
+
+/*
+** _tenFiberDirCacheProbe
+**
+** the tfx->dcache counterpart of gage probing in _tenFiberProbe(): sets
+** tfx->fiberTen, tfx->fiberEval, the first (tracked) eigenvector in
+** tfx->fiberEvec, tfx->fiberAnisoStop, and tfx->fiberAnisoSpeed, by
+** trilinear interpolation of the cached records at the surrounding
+** voxels.  Eigenvectors have no sign, so each is first flipped as needed
+** to agree with that of the nearest voxel.  Returns non-zero if wPos is
+** outside the volume (by the same bounds that gageProbe uses, with
+** values past the outermost voxels bleeding out from them) or if a brick
+** couldn't be allocated.
+*/
+int
+_tenFiberDirCacheProbe(tenFiberContext *tfx, const double wPos[3]) {
+  tenFiberDirCache *dcache;
+  double iPos[3], frac[3], ww[8], acc[_TEN_FIBER_CACHE_REC], ref[3],
+    sgn, len, wmax, min, max;
+  const float *rec[8];
+  unsigned int ai, ci, ii, lo[3], mi;
+
+  dcache = tfx->dcache;
+  gageShapeWtoI(tfx->gtx->shape, iPos, wPos);
+  for (ai=0; ai<3; ai++) {
+    max = dcache->size[ai] - 1;
+    min = 0;
+    if (nrrdCenterNode != tfx->gtx->shape->center) {
+      min -= 0.5;
+      max += 0.5;
+    }
+    if (!( AIR_IN_CL(min, iPos[ai], max) )) {
+      return 1;
+    }
+    iPos[ai] = AIR_CLAMP(0, iPos[ai], dcache->size[ai] - 1);
+    lo[ai] = AIR_CAST(unsigned int, iPos[ai]);
+    lo[ai] = AIR_MIN(lo[ai], dcache->size[ai] - 2);
+    frac[ai] = iPos[ai] - lo[ai];
+  }
+  mi = 0;
+  wmax = -1;
+  for (ci=0; ci<8; ci++) {
+    ww[ci] = ((ci & 1 ? frac[0] : 1 - frac[0])
+              *(ci & 2 ? frac[1] : 1 - frac[1])
+              *(ci & 4 ? frac[2] : 1 - frac[2]));
+    if (ww[ci] > wmax) {
+      wmax = ww[ci];
+      mi = ci;
+    }
+    if (!( rec[ci] = _tenFiberDirCacheRecord(tfx, lo[0] + (ci & 1),
+                                             lo[1] + !!(ci & 2),
+                                             lo[2] + !!(ci & 4)) )) {
+      return 1;
+    }
+  }
+  ELL_3V_COPY(ref, rec[mi] + _TEN_FIBER_CACHE_EVEC);
+  for (ii=0; ii<_TEN_FIBER_CACHE_REC; ii++) {
+    acc[ii] = 0;
+  }
+  for (ci=0; ci<8; ci++) {
+    for (ii=0; ii<_TEN_FIBER_CACHE_REC; ii++) {
+      acc[ii] += ww[ci]*rec[ci][ii];
+    }
+    /* re-do the eigenvector part with the right sign */
+    sgn = (ELL_3V_DOT(ref, rec[ci] + _TEN_FIBER_CACHE_EVEC) < 0 ? -1 : 1);
+    for (ii=_TEN_FIBER_CACHE_EVEC; ii<_TEN_FIBER_CACHE_EVEC+3; ii++) {
+      acc[ii] += (sgn - 1)*ww[ci]*rec[ci][ii];
+    }
+  }
+  TEN_T_COPY(tfx->fiberTen, acc);
+  ELL_3V_COPY(tfx->fiberEval, acc + _TEN_FIBER_CACHE_EVAL);
+  ELL_3V_NORM(tfx->fiberEvec, acc + _TEN_FIBER_CACHE_EVEC, len);
+  if (!len) {
+    ELL_3V_COPY(tfx->fiberEvec, ref);
+  }
+  tfx->fiberAnisoStop = acc[_TEN_FIBER_CACHE_STOP];
+  tfx->fiberAnisoSpeed = acc[_TEN_FIBER_CACHE_SPEED];
+  return 0;
+}
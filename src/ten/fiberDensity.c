@@ -0,0 +1,691 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "ten.h"
+#include "privateTen.h"
+
+/*
+** how many fibers a thread in tenFiberDensity() or tenFiberConnectivity()
+** takes at once
+*/
+#define _TEN_FIBER_MAP_CHUNK 64
+
+/*
+** _tenFiberMapTask, _tenFiberMapThreadArg: for tenFiberDensity and
+** tenFiberConnectivity, with chunks of fibers handed out to threads, each
+** of which adds into its own counts
+*/
+typedef struct {
+  const tenFiberMulti *tfml;  /* fibers are from here, or if NULL, ... */
+  const tenFiberStream *tfst; /* ... from here */
+  gageShape *shape;           /* to convert vertices to index space, or
+                                 NULL if they're already in index space */
+  unsigned int fiberNum,
+    size[3],                  /* size of the volume that shape is of */
+    workIdx;                  /* first fiber of next chunk to hand out */
+  /* ---- for tenFiberDensity ---- */
+  unsigned int superSample,
+    fsize[3];                 /* size of the supersampled output */
+  /* ---- for tenFiberConnectivity ---- */
+  const void *label;
+  int (*ilup)(const void *, size_t);
+  unsigned int labelNum;      /* one more than the biggest label */
+  airThreadMutex *workMutex;  /* NULL for a single thread */
+} _tenFiberMapTask;
+
+typedef struct {
+  _tenFiberMapTask *task;
+  double *vert;               /* the current fiber's vertices, as given */
+  airArray *vertArr;
+  size_t *visit,              /* voxels the current fiber goes through, ... */
+    visitNum;                 /* ... of which there are this many */
+  airArray *visitArr;         /* allocates visit, in blocks */
+  unsigned int *count;        /* this thread's counts */
+  double *len;                /* this thread's fiber length sums, or NULL */
+  int failed;                 /* couldn't allocate vert or visit */
+} _tenFiberMapThreadArg;
+
+/* the number of vertices of fiber fi, which are copied into arg->vert */
+static unsigned int
+_tenFiberMapVert(_tenFiberMapThreadArg *arg, unsigned int fi) {
+  _tenFiberMapTask *task;
+  const tenFiberSingle *tfbs;
+  const double *vert;
+  size_t base;
+  unsigned int vi, ci, vertNum, recLen;
+
+  task = arg->task;
+  tfbs = task->tfml ? task->tfml->fiber + fi : NULL;
+  if (tfbs) {
+    if (tenFiberStopUnknown != tfbs->whyNowhere
+        || !(tfbs->nvert && tfbs->nvert->data)) {
+      return 0;
+    }
+    vertNum = AIR_CAST(unsigned int, tfbs->nvert->axis[1].size);
+  } else {
+    vertNum = AIR_CAST(unsigned int,
+                       task->tfst->offset[fi+1] - task->tfst->offset[fi]);
+  }
+  if (!vertNum) {
+    return 0;
+  }
+  airArrayLenSet(arg->vertArr, 3*vertNum);
+  if (!arg->vert) {
+    arg->failed = AIR_TRUE;
+    return 0;
+  }
+  if (tfbs) {
+    vert = AIR_CAST(const double *, tfbs->nvert->data);
+    for (vi=0; vi<3*vertNum; vi++) {
+      arg->vert[vi] = vert[vi];
+    }
+  } else {
+    base = AIR_CAST(size_t, task->tfst->offset[fi]);
+    recLen = 3 + task->tfst->valLen;
+    for (vi=0; vi<vertNum; vi++) {
+      for (ci=0; ci<3; ci++) {
+        arg->vert[ci + 3*vi] =
+          _tenFiberStreamLookup(task->tfst, ci + recLen*(base + vi));
+      }
+    }
+  }
+  return vertNum;
+}
+
+/* the index-space position of a vertex */
+static void
+_tenFiberMapIndex(double iPos[3], const _tenFiberMapTask *task,
+                  const double vert[3]) {
+
+  if (task->shape) {
+    gageShapeWtoI(task->shape, iPos, vert);
+  } else {
+    ELL_3V_COPY(iPos, vert);
+  }
+  return;
+}
+
+static int
+_tenFiberMapVisitCompare(const void *_a, const void *_b) {
+  size_t a, b;
+
+  a = *AIR_CAST(const size_t *, _a);
+  b = *AIR_CAST(const size_t *, _b);
+  return (a < b ? -1 : (a > b ? 1 : 0));
+}
+
+/* records supersampled voxel vv as visited, if it's inside the volume */
+static void
+_tenFiberMapVisit(_tenFiberMapThreadArg *arg, const int vv[3]) {
+  const unsigned int *fsize;
+  size_t II;
+
+  fsize = arg->task->fsize;
+  if (!( 0 <= vv[0] && vv[0] < AIR_CAST(int, fsize[0])
+         && 0 <= vv[1] && vv[1] < AIR_CAST(int, fsize[1])
+         && 0 <= vv[2] && vv[2] < AIR_CAST(int, fsize[2]) )) {
+    return;
+  }
+  II = (AIR_CAST(size_t, vv[0])
+        + fsize[0]*(AIR_CAST(size_t, vv[1])
+                    + AIR_CAST(size_t, fsize[1])*AIR_CAST(size_t, vv[2])));
+  /* segments share their end voxels, so this avoids most repeats */
+  if (arg->visitNum && arg->visit[arg->visitNum-1] == II) {
+    return;
+  }
+  if (arg->visitNum == arg->visitArr->len) {
+    airArrayLenIncr(arg->visitArr, AIR_CAST(int, arg->visitArr->incr));
+    if (!arg->visit) {
+      arg->failed = AIR_TRUE;
+      arg->visitNum = 0;
+      return;
+    }
+  }
+  arg->visit[arg->visitNum++] = II;
+  return;
+}
+
+/*
+** records all the supersampled voxels that the segment from p0 to p1 (in
+** supersampled index space, in which voxel v covers [v,v+1)) goes
+** through, by stepping from each voxel to the one across whichever face
+** the segment leaves through first
+*/
+static void
+_tenFiberMapSegment(_tenFiberMapThreadArg *arg, const double p0[3],
+                    const double p1[3]) {
+  double dir[3], tmax[3], tdel[3];
+  int vv[3], v1[3], step[3];
+  unsigned int ai, ni, stepNum;
+
+  stepNum = 0;
+  for (ai=0; ai<3; ai++) {
+    vv[ai] = AIR_CAST(int, floor(p0[ai]));
+    v1[ai] = AIR_CAST(int, floor(p1[ai]));
+    stepNum += AIR_CAST(unsigned int, AIR_ABS(v1[ai] - vv[ai]));
+    dir[ai] = p1[ai] - p0[ai];
+    if (dir[ai] > 0) {
+      step[ai] = 1;
+      tdel[ai] = 1/dir[ai];
+      tmax[ai] = (vv[ai] + 1 - p0[ai])/dir[ai];
+    } else if (dir[ai] < 0) {
+      step[ai] = -1;
+      tdel[ai] = -1/dir[ai];
+      tmax[ai] = (vv[ai] - p0[ai])/dir[ai];
+    } else {
+      step[ai] = 0;
+      tdel[ai] = tmax[ai] = 2;
+    }
+  }
+  _tenFiberMapVisit(arg, vv);
+  for (ni=0; ni<stepNum; ni++) {
+    ai = (tmax[0] < tmax[1]
+          ? (tmax[0] < tmax[2] ? 0 : 2)
+          : (tmax[1] < tmax[2] ? 1 : 2));
+    vv[ai] += step[ai];
+    tmax[ai] += tdel[ai];
+    _tenFiberMapVisit(arg, vv);
+  }
+  return;
+}
+
+/* adds fiber fi to the track density counts of arg */
+static void
+_tenFiberDensityFiber(_tenFiberMapThreadArg *arg, unsigned int fi) {
+  _tenFiberMapTask *task;
+  double iPos[3], pp[2][3];
+  unsigned int vi, vertNum, ai;
+  size_t ii, lastII;
+
+  task = arg->task;
+  vertNum = _tenFiberMapVert(arg, fi);
+  if (!vertNum) {
+    return;
+  }
+  arg->visitNum = 0;
+  for (vi=0; vi<vertNum; vi++) {
+    _tenFiberMapIndex(iPos, task, arg->vert + 3*vi);
+    for (ai=0; ai<3; ai++) {
+      /* voxel v covers [v-0.5,v+0.5) in index space */
+      pp[vi % 2][ai] = (iPos[ai] + 0.5)*task->superSample;
+    }
+    if (!vi) {
+      _tenFiberMapSegment(arg, pp[0], pp[0]);
+    } else {
+      _tenFiberMapSegment(arg, pp[(vi+1) % 2], pp[vi % 2]);
+    }
+  }
+  if (arg->failed) {
+    return;
+  }
+  /* each voxel is counted once per fiber */
+  qsort(arg->visit, arg->visitNum, sizeof(size_t),
+        _tenFiberMapVisitCompare);
+  lastII = 0;
+  for (ii=0; ii<arg->visitNum; ii++) {
+    if (!ii || arg->visit[ii] != lastII) {
+      lastII = arg->visit[ii];
+      arg->count[lastII]++;
+    }
+  }
+  return;
+}
+
+/* the label at the voxel nearest to vertex vi, or 0 if it's outside */
+static unsigned int
+_tenFiberConnectLabel(_tenFiberMapThreadArg *arg, unsigned int vi) {
+  _tenFiberMapTask *task;
+  double iPos[3];
+  unsigned int ai;
+  size_t vv[3];
+
+  task = arg->task;
+  _tenFiberMapIndex(iPos, task, arg->vert + 3*vi);
+  for (ai=0; ai<3; ai++) {
+    if (!( -0.5 <= iPos[ai] && iPos[ai] < task->size[ai] - 0.5 )) {
+      return 0;
+    }
+    vv[ai] = AIR_CAST(size_t, floor(iPos[ai] + 0.5));
+    vv[ai] = AIR_MIN(vv[ai], task->size[ai] - 1);
+  }
+  return AIR_CAST(unsigned int,
+                  task->ilup(task->label,
+                             vv[0] + task->size[0]*(vv[1]
+                                                    + task->size[1]*vv[2])));
+}
+
+/* adds fiber fi to the connectivity counts (and lengths) of arg */
+static void
+_tenFiberConnectFiber(_tenFiberMapThreadArg *arg, unsigned int fi) {
+  _tenFiberMapTask *task;
+  double len, dd[3];
+  unsigned int vi, vertNum, lab0, lab1, LL;
+
+  task = arg->task;
+  vertNum = _tenFiberMapVert(arg, fi);
+  if (!vertNum) {
+    return;
+  }
+  /* the first labeled voxel in from each end */
+  lab0 = lab1 = 0;
+  for (vi=0; vi<vertNum && !lab0; vi++) {
+    lab0 = _tenFiberConnectLabel(arg, vi);
+  }
+  for (vi=vertNum; vi>0 && !lab1; vi--) {
+    lab1 = _tenFiberConnectLabel(arg, vi-1);
+  }
+  LL = task->labelNum;
+  arg->count[lab0 + LL*lab1]++;
+  if (lab0 != lab1) {
+    arg->count[lab1 + LL*lab0]++;
+  }
+  if (arg->len) {
+    len = 0;
+    for (vi=1; vi<vertNum; vi++) {
+      ELL_3V_SUB(dd, arg->vert + 3*vi, arg->vert + 3*(vi-1));
+      len += ELL_3V_LEN(dd);
+    }
+    arg->len[lab0 + LL*lab1] += len;
+    if (lab0 != lab1) {
+      arg->len[lab1 + LL*lab0] += len;
+    }
+  }
+  return;
+}
+
+static void *
+_tenFiberMapWorker(void *_arg) {
+  _tenFiberMapThreadArg *arg;
+  _tenFiberMapTask *task;
+  unsigned int lo, hi, fi;
+
+  arg = AIR_CAST(_tenFiberMapThreadArg *, _arg);
+  task = arg->task;
+  for (;;) {
+    if (task->workMutex) {
+      airThreadMutexLock(task->workMutex);
+    }
+    lo = task->workIdx;
+    hi = AIR_MIN(lo + _TEN_FIBER_MAP_CHUNK, task->fiberNum);
+    task->workIdx = hi;
+    if (task->workMutex) {
+      airThreadMutexUnlock(task->workMutex);
+    }
+    if (lo == hi || arg->failed) {
+      /* no more work, or no point in doing more */
+      break;
+    }
+    for (fi=lo; fi<hi && !arg->failed; fi++) {
+      if (task->superSample) {
+        _tenFiberDensityFiber(arg, fi);
+      } else {
+        _tenFiberConnectFiber(arg, fi);
+      }
+    }
+  }
+  return _arg;
+}
+
+/*
+** sets up task for the fibers of tfml or tfst, on the grid of nvol (with
+** baseDim non-spatial axes), with vertices in index space if indexSpace
+*/
+static int
+_tenFiberMapSetup(_tenFiberMapTask *task, const tenFiberMulti *tfml,
+                  const tenFiberStream *tfst, const Nrrd *nvol,
+                  unsigned int baseDim, int indexSpace, airArray *mop) {
+  static const char me[]="_tenFiberMapSetup";
+  unsigned int ai;
+
+  if (!tfml == !tfst) {
+    biffAddf(TEN, "%s: need exactly one of tenFiberMulti (%p) "
+             "and tenFiberStream (%p)", me, AIR_CVOIDP(tfml),
+             AIR_CVOIDP(tfst));
+    return 1;
+  }
+  if (tfst && !tfst->offset) {
+    biffAddf(TEN, "%s: no stream mapped", me);
+    return 1;
+  }
+  task->tfml = tfml;
+  task->tfst = tfst;
+  task->fiberNum = tfml ? tfml->fiberNum : tfst->fiberNum;
+  for (ai=0; ai<3; ai++) {
+    task->size[ai] = AIR_CAST(unsigned int, nvol->axis[baseDim+ai].size);
+  }
+  if (indexSpace) {
+    task->shape = NULL;
+  } else {
+    task->shape = gageShapeNew();
+    airMopAdd(mop, task->shape, (airMopper)gageShapeNix, airMopAlways);
+    if (gageShapeSet(task->shape, nvol, AIR_CAST(int, baseDim))) {
+      biffMovef(TEN, GAGE, "%s: couldn't learn world space of volume", me);
+      return 1;
+    }
+  }
+  task->workIdx = 0;
+  task->superSample = 0;
+  task->label = NULL;
+  task->ilup = NULL;
+  task->labelNum = 0;
+  return 0;
+}
+
+/*
+** runs the worker in threadNum threads, each with its own counts of
+** countNum (and length sums, if wantLen) in arg[ti], except that thread
+** 0 adds into count0 and len0, which the others are added into at the
+** end
+*/
+static int
+_tenFiberMapRun(_tenFiberMapTask *task, unsigned int threadNum,
+                unsigned int *count0, double *len0, size_t countNum,
+                airArray *mop) {
+  static const char me[]="_tenFiberMapRun";
+  _tenFiberMapThreadArg *arg;
+  unsigned int ti;
+  size_t II;
+
+  /* no more threads than chunks */
+  threadNum = AIR_MIN(threadNum, ((task->fiberNum + _TEN_FIBER_MAP_CHUNK - 1)
+                                  /_TEN_FIBER_MAP_CHUNK));
+  threadNum = AIR_MAX(threadNum, 1);
+  arg = AIR_CALLOC(threadNum, _tenFiberMapThreadArg);
+  airMopAdd(mop, arg, airFree, airMopAlways);
+  if (!arg) {
+    biffAddf(TEN, "%s: couldn't allocate per-thread info", me);
+    return 1;
+  }
+  if (1 < threadNum) {
+    if (!( task->workMutex = airThreadMutexNew() )) {
+      biffAddf(TEN, "%s: couldn't create work mutex", me);
+      return 1;
+    }
+    airMopAdd(mop, task->workMutex, (airMopper)airThreadMutexNix,
+              airMopAlways);
+    if (!airThreadCapable) {
+      fprintf(stderr, "%s: WARNING: not multi-threaded; will do %u "
+              "\"threads\" serially !!!\n", me, threadNum);
+    }
+  } else {
+    task->workMutex = NULL;
+  }
+  for (ti=0; ti<threadNum; ti++) {
+    arg[ti].task = task;
+    arg[ti].vertArr = airArrayNew(AIR_CAST(void **, &(arg[ti].vert)), NULL,
+                                  sizeof(double), 3*256);
+    airMopAdd(mop, arg[ti].vertArr, (airMopper)airArrayNuke, airMopAlways);
+    arg[ti].visitArr = airArrayNew(AIR_CAST(void **, &(arg[ti].visit)),
+                                   NULL, sizeof(size_t), 1024);
+    airMopAdd(mop, arg[ti].visitArr, (airMopper)airArrayNuke,
+              airMopAlways);
+    if (arg[ti].vertArr) {
+      /* buffers are re-used from fiber to fiber */
+      arg[ti].vertArr->noReallocWhenSmaller = AIR_TRUE;
+    }
+    arg[ti].visitNum = 0;
+    arg[ti].failed = AIR_FALSE;
+    if (!ti) {
+      arg[ti].count = count0;
+      arg[ti].len = len0;
+    } else {
+      arg[ti].count = AIR_CALLOC(countNum, unsigned int);
+      airMopAdd(mop, arg[ti].count, airFree, airMopAlways);
+      if (len0) {
+        arg[ti].len = AIR_CALLOC(countNum, double);
+        airMopAdd(mop, arg[ti].len, airFree, airMopAlways);
+      } else {
+        arg[ti].len = NULL;
+      }
+    }
+    if (!( arg[ti].vertArr && arg[ti].visitArr && arg[ti].count
+           && (!len0 || arg[ti].len) )) {
+      biffAddf(TEN, "%s: couldn't allocate buffers for thread %u", me, ti);
+      return 1;
+    }
+  }
+  if (airThreadRun(_tenFiberMapWorker, arg, sizeof(*arg), threadNum)) {
+    biffAddf(TEN, "%s: couldn't run %u threads", me, threadNum);
+    return 1;
+  }
+  for (ti=0; ti<threadNum; ti++) {
+    if (arg[ti].failed) {
+      biffAddf(TEN, "%s: thread %u couldn't allocate its vertex or visit "
+               "list", me, ti);
+      return 1;
+    }
+  }
+  for (ti=1; ti<threadNum; ti++) {
+    for (II=0; II<countNum; II++) {
+      count0[II] += arg[ti].count[II];
+    }
+    if (len0) {
+      for (II=0; II<countNum; II++) {
+        len0[II] += arg[ti].len[II];
+      }
+    }
+  }
+  return 0;
+}
+
+/*
+******** tenFiberDensity
+**
+** track density: counts, in each voxel of a grid superSample times finer
+** (along each axis) than that of nvol, how many fibers go through it.
+** The fibers are from either tfml or (mapped) tfst; the other has to be
+** NULL.  nvol is a 3-D volume, or a 4-D volume with a non-spatial axis 0
+** (such as a tensor volume), which sets the grid, and whose world space
+** (as in gage) the fiber vertices are in, unless indexSpace is non-zero,
+** in which case they are in its index space (as from a tenFiberContext
+** with tenFiberParmUseIndexSpace).  Each voxel of nvol is treated as a
+** cell of unit size in index space, regardless of centering.  Fibers are
+** rasterized exactly, as the voxels that their segments go through, and
+** each fiber counts only once per voxel.
+**
+** With threadNum more than one, the fibers are handed out in chunks to
+** that many threads, each counting in its own volume; these are added up
+** at the end, so the result is the same with any number of threads.  The
+** output ndens is an unsigned int volume, whose orientation is that of
+** nvol, refined by superSample.
+*/
+int
+tenFiberDensity(Nrrd *ndens, const tenFiberMulti *tfml,
+                const tenFiberStream *tfst, const Nrrd *nvol,
+                int indexSpace, unsigned int superSample,
+                unsigned int threadNum) {
+  static const char me[]="tenFiberDensity";
+  airArray *mop;
+  _tenFiberMapTask task;
+  unsigned int ai, baseDim;
+  size_t NN;
+  int axmap[3];
+  double shift;
+
+  if (!( ndens && nvol )) {
+    biffAddf(TEN, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (!( 3 == nvol->dim || 4 == nvol->dim )) {
+    biffAddf(TEN, "%s: need 3-D or 4-D (not %u-D) volume", me, nvol->dim);
+    return 1;
+  }
+  if (!superSample) {
+    biffAddf(TEN, "%s: need positive supersampling", me);
+    return 1;
+  }
+  baseDim = nvol->dim - 3;
+  mop = airMopNew();
+  if (_tenFiberMapSetup(&task, tfml, tfst, nvol, baseDim, indexSpace, mop)) {
+    biffAddf(TEN, "%s: trouble", me);
+    airMopError(mop); return 1;
+  }
+  task.superSample = superSample;
+  for (ai=0; ai<3; ai++) {
+    task.fsize[ai] = superSample*task.size[ai];
+  }
+  if (nrrdMaybeAlloc_va(ndens, nrrdTypeUInt, 3,
+                        AIR_CAST(size_t, task.fsize[0]),
+                        AIR_CAST(size_t, task.fsize[1]),
+                        AIR_CAST(size_t, task.fsize[2]))) {
+    biffMovef(TEN, NRRD, "%s: couldn't allocate output", me);
+    airMopError(mop); return 1;
+  }
+  NN = nrrdElementNumber(ndens);
+  memset(ndens->data, 0, NN*sizeof(unsigned int));
+  if (_tenFiberMapRun(&task, threadNum,
+                      AIR_CAST(unsigned int *, ndens->data), NULL, NN,
+                      mop)) {
+    biffAddf(TEN, "%s: trouble", me);
+    airMopError(mop); return 1;
+  }
+
+  ELL_3V_SET(axmap, AIR_CAST(int, baseDim + 0), AIR_CAST(int, baseDim + 1),
+             AIR_CAST(int, baseDim + 2));
+  if (nrrdAxisInfoCopy(ndens, nvol, axmap,
+                       NRRD_AXIS_INFO_SIZE_BIT
+                       | NRRD_AXIS_INFO_CENTER_BIT)
+      || nrrdBasicInfoCopy(ndens, nvol,
+                           NRRD_BASIC_INFO_DATA_BIT
+                           | NRRD_BASIC_INFO_TYPE_BIT
+                           | NRRD_BASIC_INFO_BLOCKSIZE_BIT
+                           | NRRD_BASIC_INFO_DIMENSION_BIT
+                           | NRRD_BASIC_INFO_CONTENT_BIT
+                           | NRRD_BASIC_INFO_COMMENTS_BIT
+                           | (nrrdStateKeyValuePairsPropagate
+                              ? 0
+                              : NRRD_BASIC_INFO_KEYVALUEPAIRS_BIT))) {
+    biffMovef(TEN, NRRD, "%s: couldn't set output info", me);
+    airMopError(mop); return 1;
+  }
+  /* the first of the finer voxels is centered superSample-1 halves of
+     its size in from the edge of the first voxel of nvol */
+  shift = 0.5/superSample - 0.5;
+  for (ai=0; ai<3; ai++) {
+    ndens->axis[ai].center = nrrdCenterCell;
+    if (AIR_EXISTS(ndens->axis[ai].spacing)) {
+      ndens->axis[ai].spacing /= superSample;
+    }
+    if (ndens->spaceDim) {
+      nrrdSpaceVecScaleAdd2(ndens->spaceOrigin, 1.0, ndens->spaceOrigin,
+                            shift, ndens->axis[ai].spaceDirection);
+      nrrdSpaceVecScale(ndens->axis[ai].spaceDirection, 1.0/superSample,
+                        ndens->axis[ai].spaceDirection);
+    }
+  }
+  airMopOkay(mop);
+  return 0;
+}
+
+/*
+******** tenFiberConnectivity
+**
+** connectivity matrix between the regions of the integral label volume
+** nlabel: ncount is an L-by-L unsigned int matrix, where L is one more
+** than the biggest label, whose entry (a,b) counts the fibers connecting
+** labels a and b, as the labels of the first labeled (non-zero) voxel in
+** from either end of the fiber, with label 0 meaning that no labeled
+** voxel was found.  The matrix is symmetric; a fiber with both ends in
+** label a counts once in (a,a).  If nlen is non-NULL, it is set to the
+** L-by-L double matrix of the mean length of those fibers (in the units
+** of the vertices), or 0 where there are none.  The fibers, vertex space
+** (indexSpace) and threading (threadNum) are as in tenFiberDensity(),
+** with nlabel as the volume.
+*/
+int
+tenFiberConnectivity(Nrrd *ncount, Nrrd *nlen, const tenFiberMulti *tfml,
+                     const tenFiberStream *tfst, const Nrrd *nlabel,
+                     int indexSpace, unsigned int threadNum) {
+  static const char me[]="tenFiberConnectivity";
+  airArray *mop;
+  _tenFiberMapTask task;
+  size_t II, NN;
+  int lab, labMax;
+  unsigned int *count;
+  double *len;
+
+  if (!( ncount && nlabel )) {
+    biffAddf(TEN, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (!( 3 == nlabel->dim
+         && nrrdTypeBlock != nlabel->type
+         && nrrdTypeIsIntegral[nlabel->type] )) {
+    biffAddf(TEN, "%s: need 3-D (not %u-D) label volume of integral "
+             "type (not %s)", me, nlabel->dim,
+             airEnumStr(nrrdType, nlabel->type));
+    return 1;
+  }
+  mop = airMopNew();
+  if (_tenFiberMapSetup(&task, tfml, tfst, nlabel, 0, indexSpace, mop)) {
+    biffAddf(TEN, "%s: trouble", me);
+    airMopError(mop); return 1;
+  }
+  task.label = nlabel->data;
+  task.ilup = nrrdILookup[nlabel->type];
+  NN = nrrdElementNumber(nlabel);
+  labMax = 0;
+  for (II=0; II<NN; II++) {
+    lab = task.ilup(task.label, II);
+    if (lab < 0) {
+      char stmp[AIR_STRLEN_SMALL];
+      biffAddf(TEN, "%s: got negative label %d at %s", me, lab,
+               airSprintSize_t(stmp, II));
+      airMopError(mop); return 1;
+    }
+    labMax = AIR_MAX(labMax, lab);
+  }
+  task.labelNum = AIR_CAST(unsigned int, labMax) + 1;
+
+  NN = AIR_CAST(size_t, task.labelNum)*task.labelNum;
+  if (nrrdMaybeAlloc_va(ncount, nrrdTypeUInt, 2,
+                        AIR_CAST(size_t, task.labelNum),
+                        AIR_CAST(size_t, task.labelNum))
+      || (nlen && nrrdMaybeAlloc_va(nlen, nrrdTypeDouble, 2,
+                                    AIR_CAST(size_t, task.labelNum),
+                                    AIR_CAST(size_t, task.labelNum)))) {
+    biffMovef(TEN, NRRD, "%s: couldn't allocate output", me);
+    airMopError(mop); return 1;
+  }
+  count = AIR_CAST(unsigned int *, ncount->data);
+  memset(count, 0, NN*sizeof(unsigned int));
+  if (nlen) {
+    len = AIR_CAST(double *, nlen->data);
+    for (II=0; II<NN; II++) {
+      len[II] = 0;
+    }
+  } else {
+    len = NULL;
+  }
+  if (_tenFiberMapRun(&task, threadNum, count, len, NN, mop)) {
+    biffAddf(TEN, "%s: trouble", me);
+    airMopError(mop); return 1;
+  }
+  if (len) {
+    for (II=0; II<NN; II++) {
+      len[II] = count[II] ? len[II]/count[II] : 0;
+    }
+  }
+  airMopOkay(mop);
+  return 0;
+}
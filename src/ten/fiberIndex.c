@@ -0,0 +1,858 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "ten.h"
+#include "privateTen.h"
+
+/*
+** with an automatic cell size, the grid has about this many segments per
+** cell
+*/
+#define _TEN_FIBER_INDEX_PER_CELL 4
+
+/*
+** with an automatic cell size, the most cells along an axis (about), and
+** the most cells a grid can have in any case
+*/
+#define _TEN_FIBER_INDEX_AXIS_MAX 512
+#define _TEN_FIBER_INDEX_CELL_MAX (1u << 30)
+
+tenFiberIndex *
+tenFiberIndexNew(void) {
+  tenFiberIndex *tfix;
+
+  tfix = AIR_CALLOC(1, tenFiberIndex);
+  if (tfix) {
+    tfix->fiberNum = 0;
+    tfix->vertNum = 0;
+    tfix->vert = NULL;
+    tfix->vertStart = NULL;
+    ELL_3V_SET(tfix->origin, 0, 0, 0);
+    tfix->cellSize = 0;
+    ELL_3V_SET(tfix->size, 0, 0, 0);
+    tfix->cellStart = NULL;
+    tfix->seg = NULL;
+  }
+  return tfix;
+}
+
+static tenFiberIndex *
+_tenFiberIndexClear(tenFiberIndex *tfix) {
+
+  tfix->vert = AIR_CAST(float *, airFree(tfix->vert));
+  tfix->vertStart = AIR_CAST(size_t *, airFree(tfix->vertStart));
+  tfix->cellStart = AIR_CAST(size_t *, airFree(tfix->cellStart));
+  tfix->seg = AIR_CAST(size_t *, airFree(tfix->seg));
+  tfix->fiberNum = 0;
+  tfix->vertNum = 0;
+  ELL_3V_SET(tfix->size, 0, 0, 0);
+  return tfix;
+}
+
+tenFiberIndex *
+tenFiberIndexNix(tenFiberIndex *tfix) {
+
+  if (tfix) {
+    _tenFiberIndexClear(tfix);
+    airFree(tfix);
+  }
+  return NULL;
+}
+
+/*
+** _tenFiberIndexTask, _tenFiberIndexThreadArg: for tenFiberIndexBuild,
+** with each thread doing a fixed range of fibers in each pass, so that
+** the index is the same with any number of threads
+*/
+typedef struct {
+  tenFiberIndex *tfix;
+  const tenFiberMulti *tfml;  /* fibers are from one of these */
+  const tenFiberStream *tfst;
+  const limnPolyData *lpld;
+  int pass;                   /* 0: copy vertices, 1: count segments per
+                                 cell, 2: put segments in cells */
+} _tenFiberIndexTask;
+
+typedef struct {
+  _tenFiberIndexTask *task;
+  unsigned int fiberLo, fiberHi; /* this thread's fibers */
+  float min[3], max[3];       /* bounds of this thread's vertices */
+  size_t *cellIdx;            /* per cell, a count (pass 1) or where the
+                                 next segment goes (pass 2) */
+} _tenFiberIndexThreadArg;
+
+/* the range of cells (clamped to the grid) overlapping [min,max]; returns
+   non-zero if there are none */
+static int
+_tenFiberIndexCellRange(unsigned int lo[3], unsigned int hi[3],
+                        const tenFiberIndex *tfix, const double min[3],
+                        const double max[3]) {
+  double cmin, cmax;
+  unsigned int ai;
+
+  for (ai=0; ai<3; ai++) {
+    cmin = floor((min[ai] - tfix->origin[ai])/tfix->cellSize);
+    cmax = floor((max[ai] - tfix->origin[ai])/tfix->cellSize);
+    if (cmax < 0 || cmin > tfix->size[ai] - 1) {
+      return 1;
+    }
+    lo[ai] = cmin < 0 ? 0 : AIR_CAST(unsigned int, cmin);
+    hi[ai] = (cmax > tfix->size[ai] - 1
+              ? tfix->size[ai] - 1
+              : AIR_CAST(unsigned int, cmax));
+  }
+  return 0;
+}
+
+/* the last vertex of the segment starting at vertex vi of fiber fi */
+static size_t
+_tenFiberIndexSegEnd(const tenFiberIndex *tfix, unsigned int fi,
+                     size_t vi) {
+
+  return vi + 1 < tfix->vertStart[fi+1] ? vi + 1 : vi;
+}
+
+/* the fiber that vertex vi is part of */
+static unsigned int
+_tenFiberIndexFiber(const tenFiberIndex *tfix, size_t vi) {
+  unsigned int lo, hi, mid;
+
+  /* the last fiber starting at or before vi */
+  lo = 0;
+  hi = tfix->fiberNum - 1;
+  while (lo < hi) {
+    mid = lo + (hi - lo + 1)/2;
+    if (tfix->vertStart[mid] <= vi) {
+      lo = mid;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  return lo;
+}
+
+static void
+_tenFiberIndexCopy(_tenFiberIndexThreadArg *arg) {
+  _tenFiberIndexTask *task;
+  tenFiberIndex *tfix;
+  const double *dvert;
+  const float *xyzw;
+  unsigned int fi, vi, ci, vertNum, recLen, ii;
+  size_t base;
+  float *vert;
+
+  task = arg->task;
+  tfix = task->tfix;
+  ELL_3V_SET(arg->min, AIR_POS_INF, AIR_POS_INF, AIR_POS_INF);
+  ELL_3V_SET(arg->max, AIR_NEG_INF, AIR_NEG_INF, AIR_NEG_INF);
+  for (fi=arg->fiberLo; fi<arg->fiberHi; fi++) {
+    vert = tfix->vert + 3*tfix->vertStart[fi];
+    vertNum = AIR_CAST(unsigned int,
+                       tfix->vertStart[fi+1] - tfix->vertStart[fi]);
+    if (task->tfml) {
+      dvert = (vertNum
+               ? AIR_CAST(const double *, task->tfml->fiber[fi].nvert->data)
+               : NULL);
+      for (vi=0; vi<3*vertNum; vi++) {
+        vert[vi] = AIR_CAST(float, dvert[vi]);
+      }
+    } else if (task->tfst) {
+      base = AIR_CAST(size_t, task->tfst->offset[fi]);
+      recLen = 3 + task->tfst->valLen;
+      for (vi=0; vi<vertNum; vi++) {
+        for (ci=0; ci<3; ci++) {
+          vert[ci + 3*vi] =
+            AIR_CAST(float, _tenFiberStreamLookup(task->tfst,
+                                                  ci + recLen*(base + vi)));
+        }
+      }
+    } else {
+      /* the indices of primitive fi start where those of fiber fi do */
+      for (vi=0; vi<vertNum; vi++) {
+        ii = task->lpld->indx[tfix->vertStart[fi] + vi];
+        xyzw = task->lpld->xyzw + 4*ii;
+        ELL_34V_HOMOG_TT(vert + 3*vi, float, xyzw);
+      }
+    }
+    for (vi=0; vi<vertNum; vi++) {
+      for (ci=0; ci<3; ci++) {
+        arg->min[ci] = AIR_MIN(arg->min[ci], vert[ci + 3*vi]);
+        arg->max[ci] = AIR_MAX(arg->max[ci], vert[ci + 3*vi]);
+      }
+    }
+  }
+  return;
+}
+
+/* counts (pass 1) or records (pass 2) the segments of arg's fibers */
+static void
+_tenFiberIndexBin(_tenFiberIndexThreadArg *arg) {
+  tenFiberIndex *tfix;
+  const float *v0, *v1;
+  double min[3], max[3];
+  unsigned int fi, ai, lo[3], hi[3], cc[3];
+  size_t vi, ve, cellIdx;
+
+  tfix = arg->task->tfix;
+  for (fi=arg->fiberLo; fi<arg->fiberHi; fi++) {
+    for (vi=tfix->vertStart[fi]; vi<tfix->vertStart[fi+1]; vi++) {
+      ve = _tenFiberIndexSegEnd(tfix, fi, vi);
+      if (ve == vi && vi > tfix->vertStart[fi]) {
+        /* the last vertex of a fiber with segments */
+        break;
+      }
+      v0 = tfix->vert + 3*vi;
+      v1 = tfix->vert + 3*ve;
+      for (ai=0; ai<3; ai++) {
+        min[ai] = AIR_MIN(v0[ai], v1[ai]);
+        max[ai] = AIR_MAX(v0[ai], v1[ai]);
+      }
+      if (_tenFiberIndexCellRange(lo, hi, tfix, min, max)) {
+        continue;
+      }
+      for (cc[2]=lo[2]; cc[2]<=hi[2]; cc[2]++) {
+        for (cc[1]=lo[1]; cc[1]<=hi[1]; cc[1]++) {
+          for (cc[0]=lo[0]; cc[0]<=hi[0]; cc[0]++) {
+            cellIdx = cc[0] + tfix->size[0]*(cc[1] + AIR_CAST(size_t,
+                                                              tfix->size[1])
+                                             *cc[2]);
+            if (1 == arg->task->pass) {
+              arg->cellIdx[cellIdx]++;
+            } else {
+              tfix->seg[arg->cellIdx[cellIdx]++] = vi;
+            }
+          }
+        }
+      }
+    }
+  }
+  return;
+}
+
+static void *
+_tenFiberIndexWorker(void *_arg) {
+  _tenFiberIndexThreadArg *arg;
+
+  arg = AIR_CAST(_tenFiberIndexThreadArg *, _arg);
+  if (!arg->task->pass) {
+    _tenFiberIndexCopy(arg);
+  } else {
+    _tenFiberIndexBin(arg);
+  }
+  return _arg;
+}
+
+/* does the current pass of task in threadNum threads */
+static int
+_tenFiberIndexRun(_tenFiberIndexThreadArg *arg, unsigned int threadNum) {
+  static const char me[]="_tenFiberIndexRun";
+
+  if (airThreadRun(_tenFiberIndexWorker, arg, sizeof(*arg), threadNum)) {
+    biffAddf(TEN, "%s: couldn't run %u threads", me, threadNum);
+    return 1;
+  }
+  return 0;
+}
+
+/*
+******** tenFiberIndexBuild
+**
+** builds in tfix a uniform grid of cubic cells, of edge length cellSize
+** (or, if cellSize is not positive, chosen to have a few segments per
+** cell), over the bounding box of the fibers, with each segment between
+** successive vertices of a fiber listed in every cell that its bounding
+** box overlaps.  The fibers are from exactly one of tfml, (mapped) tfst,
+** or lpld (with each primitive a fiber, such as from
+** tenFiberMultiPolyData()), and their vertices are copied (as floats)
+** into tfix, so the fibers don't have to be kept around.  Fiber indices
+** in the query results are those of the given fibers: in tfml, fibers
+** that went nowhere have no vertices, and so are never found.
+**
+** With threadNum more than one, the vertices are copied, and the
+** segments are binned into cells (with a counting sort), by that many
+** threads, each with its own range of fibers; the index is the same with
+** any number of threads.
+*/
+int
+tenFiberIndexBuild(tenFiberIndex *tfix, const tenFiberMulti *tfml,
+                   const tenFiberStream *tfst, const limnPolyData *lpld,
+                   double cellSize, unsigned int threadNum) {
+  static const char me[]="tenFiberIndexBuild";
+  airArray *mop;
+  _tenFiberIndexTask task;
+  _tenFiberIndexThreadArg *arg;
+  unsigned int fi, ti, ai, fiberNum, vertNum;
+  size_t segNum, cellNum, II, sum, cnt;
+  double min[3], max[3], volume, extent;
+  unsigned int dimNum;
+
+  if (!tfix) {
+    biffAddf(TEN, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (1 != !!tfml + !!tfst + !!lpld) {
+    biffAddf(TEN, "%s: need exactly one of tenFiberMulti (%p), "
+             "tenFiberStream (%p), and limnPolyData (%p)", me,
+             AIR_CVOIDP(tfml), AIR_CVOIDP(tfst), AIR_CVOIDP(lpld));
+    return 1;
+  }
+  if (tfst && !tfst->offset) {
+    biffAddf(TEN, "%s: no stream mapped", me);
+    return 1;
+  }
+  _tenFiberIndexClear(tfix);
+  fiberNum = (tfml
+              ? tfml->fiberNum
+              : (tfst ? tfst->fiberNum : lpld->primNum));
+  if (!fiberNum) {
+    biffAddf(TEN, "%s: got no fibers", me);
+    return 1;
+  }
+  mop = airMopNew();
+  airMopAdd(mop, tfix, (airMopper)_tenFiberIndexClear, airMopOnError);
+  tfix->vertStart = AIR_CALLOC(fiberNum+1, size_t);
+  if (!tfix->vertStart) {
+    biffAddf(TEN, "%s: couldn't allocate vertex index", me);
+    airMopError(mop); return 1;
+  }
+  tfix->fiberNum = fiberNum;
+  segNum = 0;
+  for (fi=0; fi<fiberNum; fi++) {
+    if (tfml) {
+      const tenFiberSingle *tfbs;
+      tfbs = tfml->fiber + fi;
+      vertNum = ((tenFiberStopUnknown == tfbs->whyNowhere
+                  && tfbs->nvert && tfbs->nvert->data
+                  && 2 == tfbs->nvert->dim
+                  && nrrdTypeDouble == tfbs->nvert->type
+                  && 3 == tfbs->nvert->axis[0].size)
+                 ? AIR_CAST(unsigned int, tfbs->nvert->axis[1].size)
+                 : 0);
+    } else if (tfst) {
+      vertNum = AIR_CAST(unsigned int, tfst->offset[fi+1] - tfst->offset[fi]);
+    } else {
+      if (limnPrimitiveLineStrip != lpld->type[fi]) {
+        biffAddf(TEN, "%s: primitive %u is %s, not %s", me, fi,
+                 airEnumStr(limnPrimitive, lpld->type[fi]),
+                 airEnumStr(limnPrimitive, limnPrimitiveLineStrip));
+        airMopError(mop); return 1;
+      }
+      vertNum = lpld->icnt[fi];
+    }
+    tfix->vertStart[fi+1] = tfix->vertStart[fi] + vertNum;
+    segNum += vertNum > 1 ? vertNum - 1 : vertNum;
+  }
+  tfix->vertNum = tfix->vertStart[fiberNum];
+  if (lpld && tfix->vertNum > lpld->indxNum) {
+    biffAddf(TEN, "%s: primitives use more indices than the %u there are",
+             me, lpld->indxNum);
+    airMopError(mop); return 1;
+  }
+  if (!segNum) {
+    biffAddf(TEN, "%s: fibers have no vertices", me);
+    airMopError(mop); return 1;
+  }
+  tfix->vert = AIR_CALLOC(3*tfix->vertNum, float);
+  if (!tfix->vert) {
+    biffAddf(TEN, "%s: couldn't allocate vertices", me);
+    airMopError(mop); return 1;
+  }
+
+  task.tfix = tfix;
+  task.tfml = tfml;
+  task.tfst = tfst;
+  task.lpld = lpld;
+  threadNum = AIR_MIN(threadNum, fiberNum);
+  threadNum = AIR_MAX(threadNum, 1);
+  arg = AIR_CALLOC(threadNum, _tenFiberIndexThreadArg);
+  airMopAdd(mop, arg, airFree, airMopAlways);
+  if (!arg) {
+    biffAddf(TEN, "%s: couldn't allocate per-thread info", me);
+    airMopError(mop); return 1;
+  }
+  if (1 < threadNum && !airThreadCapable) {
+    fprintf(stderr, "%s: WARNING: not multi-threaded; will do %u "
+            "\"threads\" serially !!!\n", me, threadNum);
+  }
+  for (ti=0; ti<threadNum; ti++) {
+    arg[ti].task = &task;
+    arg[ti].fiberLo = AIR_CAST(unsigned int,
+                               AIR_CAST(airULLong, fiberNum)*ti/threadNum);
+    arg[ti].fiberHi = AIR_CAST(unsigned int,
+                               AIR_CAST(airULLong, fiberNum)*(ti+1)
+                               /threadNum);
+    arg[ti].cellIdx = NULL;
+  }
+
+  /* pass 0: copy vertices, and learn their bounds */
+  task.pass = 0;
+  if (_tenFiberIndexRun(arg, threadNum)) {
+    biffAddf(TEN, "%s: trouble copying vertices", me);
+    airMopError(mop); return 1;
+  }
+  ELL_3V_COPY(min, arg[0].min);
+  ELL_3V_COPY(max, arg[0].max);
+  for (ti=1; ti<threadNum; ti++) {
+    for (ai=0; ai<3; ai++) {
+      min[ai] = AIR_MIN(min[ai], arg[ti].min[ai]);
+      max[ai] = AIR_MAX(max[ai], arg[ti].max[ai]);
+    }
+  }
+  if (!( ELL_3V_EXISTS(min) && ELL_3V_EXISTS(max) )) {
+    biffAddf(TEN, "%s: got non-existent vertex coordinates", me);
+    airMopError(mop); return 1;
+  }
+  extent = 0;
+  for (ai=0; ai<3; ai++) {
+    extent = AIR_MAX(extent, max[ai] - min[ai]);
+  }
+  if (!( cellSize > 0 )) {
+    if (extent > 0) {
+      /* over the directions in which the fibers aren't flat */
+      volume = 1;
+      dimNum = 0;
+      for (ai=0; ai<3; ai++) {
+        if (max[ai] - min[ai] > extent/_TEN_FIBER_INDEX_AXIS_MAX) {
+          volume *= max[ai] - min[ai];
+          dimNum++;
+        }
+      }
+      cellSize = pow(volume*_TEN_FIBER_INDEX_PER_CELL/segNum, 1.0/dimNum);
+      cellSize = AIR_MAX(cellSize, extent/_TEN_FIBER_INDEX_AXIS_MAX);
+    } else {
+      cellSize = 1;
+    }
+  }
+  cellNum = 1;
+  for (ai=0; ai<3; ai++) {
+    /* the grid has half a cell of slack on either side */
+    double sz;
+    sz = floor((max[ai] - min[ai])/cellSize + 1) + 1;
+    if (!( sz*cellNum <= _TEN_FIBER_INDEX_CELL_MAX )) {
+      biffAddf(TEN, "%s: cell size %g too small for fibers' extent "
+               "[%g,%g]", me, cellSize, min[ai], max[ai]);
+      airMopError(mop); return 1;
+    }
+    tfix->size[ai] = AIR_CAST(unsigned int, sz);
+    tfix->origin[ai] = ((max[ai] + min[ai])/2
+                        - tfix->size[ai]*cellSize/2);
+    cellNum *= tfix->size[ai];
+  }
+  tfix->cellSize = cellSize;
+  tfix->cellStart = AIR_CALLOC(cellNum+1, size_t);
+  if (!tfix->cellStart) {
+    biffAddf(TEN, "%s: couldn't allocate %u cells", me,
+             AIR_CAST(unsigned int, cellNum));
+    airMopError(mop); return 1;
+  }
+  for (ti=0; ti<threadNum; ti++) {
+    arg[ti].cellIdx = AIR_CALLOC(cellNum, size_t);
+    airMopAdd(mop, arg[ti].cellIdx, airFree, airMopAlways);
+    if (!arg[ti].cellIdx) {
+      biffAddf(TEN, "%s: couldn't allocate cell counts for thread %u",
+               me, ti);
+      airMopError(mop); return 1;
+    }
+  }
+
+  /* pass 1: count segments per cell */
+  task.pass = 1;
+  if (_tenFiberIndexRun(arg, threadNum)) {
+    biffAddf(TEN, "%s: trouble counting segments", me);
+    airMopError(mop); return 1;
+  }
+  /* where each thread's segments of each cell go, in fiber order */
+  sum = 0;
+  for (II=0; II<cellNum; II++) {
+    tfix->cellStart[II] = sum;
+    for (ti=0; ti<threadNum; ti++) {
+      cnt = arg[ti].cellIdx[II];
+      arg[ti].cellIdx[II] = sum;
+      sum += cnt;
+    }
+  }
+  tfix->cellStart[cellNum] = sum;
+  tfix->seg = AIR_CALLOC(AIR_MAX(sum, 1), size_t);
+  if (!tfix->seg) {
+    biffAddf(TEN, "%s: couldn't allocate cell contents", me);
+    airMopError(mop); return 1;
+  }
+  /* pass 2: put segments in cells */
+  task.pass = 2;
+  if (_tenFiberIndexRun(arg, threadNum)) {
+    biffAddf(TEN, "%s: trouble binning segments", me);
+    airMopError(mop); return 1;
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
+
+/* squared distance from pos to the segment from v0 to v1 */
+static double
+_tenFiberIndexSegDist2(const double pos[3], const float v0[3],
+                       const float v1[3]) {
+  double dd[3], pp[3], len2, tt;
+
+  ELL_3V_SUB(dd, v1, v0);
+  ELL_3V_SUB(pp, pos, v0);
+  len2 = ELL_3V_DOT(dd, dd);
+  tt = len2 ? AIR_CLAMP(0, ELL_3V_DOT(pp, dd)/len2, 1) : 0;
+  ELL_3V_SCALE_INCR(pp, -tt, dd);
+  return ELL_3V_DOT(pp, pp);
+}
+
+/* non-zero if the vertex is in a non-zero voxel of the mask */
+static int
+_tenFiberIndexInMask(const Nrrd *nmask, const gageShape *shape,
+                     const float vert[3]) {
+  double wPos[3], iPos[3];
+  size_t vv[3];
+  unsigned int ai;
+
+  ELL_3V_COPY(wPos, vert);
+  if (shape) {
+    gageShapeWtoI(shape, iPos, wPos);
+  } else {
+    ELL_3V_COPY(iPos, wPos);
+  }
+  for (ai=0; ai<3; ai++) {
+    if (!( -0.5 <= iPos[ai] && iPos[ai] < nmask->axis[ai].size - 0.5 )) {
+      return 0;
+    }
+    vv[ai] = AIR_CAST(size_t, floor(iPos[ai] + 0.5));
+    vv[ai] = AIR_MIN(vv[ai], nmask->axis[ai].size - 1);
+  }
+  return !!nrrdDLookup[nmask->type](nmask->data,
+                                    vv[0] + nmask->axis[0].size
+                                    *(vv[1] + nmask->axis[1].size*vv[2]));
+}
+
+/*
+** marks in cellMark the cells that overlap some non-zero voxel of the
+** mask (or their bounding boxes in world space)
+*/
+static void
+_tenFiberIndexMaskCells(unsigned char *cellMark, const tenFiberIndex *tfix,
+                        const Nrrd *nmask, const gageShape *shape) {
+  double (*lup)(const void *, size_t), iPos[3], wPos[3], min[3], max[3];
+  unsigned int lo[3], hi[3], cc[3], ci, ai;
+  size_t II, vv[3];
+
+  lup = nrrdDLookup[nmask->type];
+  II = 0;
+  for (vv[2]=0; vv[2]<nmask->axis[2].size; vv[2]++) {
+    for (vv[1]=0; vv[1]<nmask->axis[1].size; vv[1]++) {
+      for (vv[0]=0; vv[0]<nmask->axis[0].size; vv[0]++, II++) {
+        if (!lup(nmask->data, II)) {
+          continue;
+        }
+        ELL_3V_SET(min, AIR_POS_INF, AIR_POS_INF, AIR_POS_INF);
+        ELL_3V_SET(max, AIR_NEG_INF, AIR_NEG_INF, AIR_NEG_INF);
+        /* the eight corners of the voxel */
+        for (ci=0; ci<8; ci++) {
+          ELL_3V_SET(iPos, vv[0] + (ci & 1 ? 0.5 : -0.5),
+                     vv[1] + (ci & 2 ? 0.5 : -0.5),
+                     vv[2] + (ci & 4 ? 0.5 : -0.5));
+          if (shape) {
+            gageShapeItoW(shape, wPos, iPos);
+          } else {
+            ELL_3V_COPY(wPos, iPos);
+          }
+          for (ai=0; ai<3; ai++) {
+            min[ai] = AIR_MIN(min[ai], wPos[ai]);
+            max[ai] = AIR_MAX(max[ai], wPos[ai]);
+          }
+        }
+        if (_tenFiberIndexCellRange(lo, hi, tfix, min, max)) {
+          continue;
+        }
+        for (cc[2]=lo[2]; cc[2]<=hi[2]; cc[2]++) {
+          for (cc[1]=lo[1]; cc[1]<=hi[1]; cc[1]++) {
+            for (cc[0]=lo[0]; cc[0]<=hi[0]; cc[0]++) {
+              cellMark[cc[0] + tfix->size[0]
+                       *(cc[1] + AIR_CAST(size_t, tfix->size[1])*cc[2])]
+                = AIR_TRUE;
+            }
+          }
+        }
+      }
+    }
+  }
+  return;
+}
+
+/*
+******** tenFiberIndexSelect
+**
+** finds the fibers in tfix that go through all the inclusion regions
+** and none of the exclusion regions of the regionNum regions in region,
+** and puts their indices, in increasing order, in nlist (a 1-D array of
+** unsigned ints), or if there are no such fibers, empties nlist (with
+** nrrdEmpty).  With no inclusion regions, all the fibers that go through
+** none of the exclusion regions are found.
+**
+** A fiber goes through a sphere region if one of its segments comes
+** within the radius of the center, and through a mask region if one of
+** its vertices is in a non-zero voxel of the mask.  The vertices are in
+** the world space (as in gage) of the masks, unless indexSpace is
+** non-zero, in which case they are in index space, as with
+** tenFiberDensity().
+*/
+int
+tenFiberIndexSelect(Nrrd *nlist, const tenFiberIndex *tfix,
+                    const tenFiberRegion *region, unsigned int regionNum,
+                    int indexSpace) {
+  static const char me[]="tenFiberIndexSelect";
+  airArray *mop;
+  const tenFiberRegion *rgn;
+  gageShape *shape;
+  unsigned char *cellMark;
+  unsigned int ri, fi, ai, lo[3], hi[3], cc[3], *last, *hits, inclNum,
+    listNum, *list;
+  size_t cellNum, II, si, vi, ve;
+  double min[3], max[3], rad2;
+  int hit;
+
+  if (!( nlist && tfix && (region || !regionNum) )) {
+    biffAddf(TEN, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (!tfix->seg) {
+    biffAddf(TEN, "%s: index not built", me);
+    return 1;
+  }
+  inclNum = 0;
+  for (ri=0; ri<regionNum; ri++) {
+    rgn = region + ri;
+    if (rgn->nmask) {
+      if (!( 3 == rgn->nmask->dim && nrrdTypeBlock != rgn->nmask->type )) {
+        biffAddf(TEN, "%s: region %u mask not a 3-D scalar volume", me, ri);
+        return 1;
+      }
+    } else if (!( ELL_3V_EXISTS(rgn->center) && rgn->radius >= 0 )) {
+      biffAddf(TEN, "%s: region %u sphere center (%g,%g,%g) or radius %g "
+               "invalid", me, ri, rgn->center[0], rgn->center[1],
+               rgn->center[2], rgn->radius);
+      return 1;
+    }
+    inclNum += !rgn->exclude;
+  }
+
+  mop = airMopNew();
+  cellNum = AIR_CAST(size_t, tfix->size[0])*tfix->size[1]*tfix->size[2];
+  /* last[fi] is 1 + the last region that fiber fi was found in, and
+     hits[fi] is how many inclusion regions it's in, or UINT_MAX if it's
+     in an exclusion region */
+  last = AIR_CALLOC(tfix->fiberNum, unsigned int);
+  airMopAdd(mop, last, airFree, airMopAlways);
+  hits = AIR_CALLOC(tfix->fiberNum, unsigned int);
+  airMopAdd(mop, hits, airFree, airMopAlways);
+  cellMark = AIR_CALLOC(cellNum, unsigned char);
+  airMopAdd(mop, cellMark, airFree, airMopAlways);
+  shape = indexSpace ? NULL : gageShapeNew();
+  if (shape) {
+    airMopAdd(mop, shape, (airMopper)gageShapeNix, airMopAlways);
+  }
+  if (!( last && hits && cellMark && (indexSpace || shape) )) {
+    biffAddf(TEN, "%s: couldn't allocate buffers", me);
+    airMopError(mop); return 1;
+  }
+  for (ri=0; ri<regionNum; ri++) {
+    rgn = region + ri;
+    if (rgn->nmask) {
+      if (shape && gageShapeSet(shape, rgn->nmask, 0)) {
+        biffMovef(TEN, GAGE, "%s: couldn't learn world space of region %u "
+                  "mask", me, ri);
+        airMopError(mop); return 1;
+      }
+      /* all the cells, of which the marked ones are searched */
+      memset(cellMark, 0, cellNum);
+      _tenFiberIndexMaskCells(cellMark, tfix, rgn->nmask, shape);
+      ELL_3V_SET(lo, 0, 0, 0);
+      ELL_3V_SET(hi, tfix->size[0] - 1, tfix->size[1] - 1,
+                 tfix->size[2] - 1);
+    } else {
+      /* the cells around the sphere, all of which are searched */
+      for (ai=0; ai<3; ai++) {
+        min[ai] = rgn->center[ai] - rgn->radius;
+        max[ai] = rgn->center[ai] + rgn->radius;
+      }
+      if (_tenFiberIndexCellRange(lo, hi, tfix, min, max)) {
+        continue;
+      }
+    }
+    rad2 = rgn->radius*rgn->radius;
+    for (cc[2]=lo[2]; cc[2]<=hi[2]; cc[2]++) {
+      for (cc[1]=lo[1]; cc[1]<=hi[1]; cc[1]++) {
+        for (cc[0]=lo[0]; cc[0]<=hi[0]; cc[0]++) {
+          II = cc[0] + tfix->size[0]*(cc[1] + AIR_CAST(size_t, tfix->size[1])
+                                      *cc[2]);
+          if (rgn->nmask && !cellMark[II]) {
+            continue;
+          }
+          for (si=tfix->cellStart[II]; si<tfix->cellStart[II+1]; si++) {
+            vi = tfix->seg[si];
+            fi = _tenFiberIndexFiber(tfix, vi);
+            if (ri + 1 == last[fi]) {
+              /* already found in this region */
+              continue;
+            }
+            ve = _tenFiberIndexSegEnd(tfix, fi, vi);
+            if (rgn->nmask) {
+              hit = (_tenFiberIndexInMask(rgn->nmask, shape,
+                                          tfix->vert + 3*vi)
+                     || _tenFiberIndexInMask(rgn->nmask, shape,
+                                             tfix->vert + 3*ve));
+            } else {
+              hit = (_tenFiberIndexSegDist2(rgn->center, tfix->vert + 3*vi,
+                                            tfix->vert + 3*ve) <= rad2);
+            }
+            if (!hit) {
+              continue;
+            }
+            last[fi] = ri + 1;
+            if (rgn->exclude) {
+              hits[fi] = UINT_MAX;
+            } else if (UINT_MAX != hits[fi]) {
+              hits[fi]++;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  listNum = 0;
+  for (fi=0; fi<tfix->fiberNum; fi++) {
+    listNum += (inclNum == hits[fi]
+                && tfix->vertStart[fi] < tfix->vertStart[fi+1]);
+  }
+  if (!listNum) {
+    nrrdEmpty(nlist);
+    airMopOkay(mop);
+    return 0;
+  }
+  if (nrrdMaybeAlloc_va(nlist, nrrdTypeUInt, 1,
+                        AIR_CAST(size_t, listNum))) {
+    biffMovef(TEN, NRRD, "%s: couldn't allocate output", me);
+    airMopError(mop); return 1;
+  }
+  list = AIR_CAST(unsigned int *, nlist->data);
+  listNum = 0;
+  for (fi=0; fi<tfix->fiberNum; fi++) {
+    if (inclNum == hits[fi]
+        && tfix->vertStart[fi] < tfix->vertStart[fi+1]) {
+      list[listNum++] = fi;
+    }
+  }
+  airMopOkay(mop);
+  return 0;
+}
+
+/*
+******** tenFiberIndexNearest
+**
+** finds the fiber in tfix with a segment nearest to pos, and sets its
+** index in *fiberIdxP, and the distance in *distP.  If maxDist is
+** positive, only fibers within maxDist are looked for, and if there are
+** none, *fiberIdxP is set to UINT_MAX and *distP to AIR_POS_INF.
+** Searches outward from pos in shells of cells, stopping once no cell
+** not yet searched could hold anything nearer.
+*/
+int
+tenFiberIndexNearest(unsigned int *fiberIdxP, double *distP,
+                     const tenFiberIndex *tfix, const double pos[3],
+                     double maxDist) {
+  static const char me[]="tenFiberIndexNearest";
+  double cpos, best2, dist2, near;
+  int c0[3], lo[3], hi[3], cc[3], ring, ringMax;
+  unsigned int ai, fi, bestFi;
+  size_t II, si, vi, ve;
+
+  if (!( fiberIdxP && distP && tfix && pos )) {
+    biffAddf(TEN, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (!tfix->seg) {
+    biffAddf(TEN, "%s: index not built", me);
+    return 1;
+  }
+  if (!ELL_3V_EXISTS(pos)) {
+    biffAddf(TEN, "%s: got non-existent position (%g,%g,%g)", me,
+             pos[0], pos[1], pos[2]);
+    return 1;
+  }
+  ringMax = 0;
+  for (ai=0; ai<3; ai++) {
+    /* the (clamped) cell of pos */
+    cpos = floor((pos[ai] - tfix->origin[ai])/tfix->cellSize);
+    cpos = AIR_CLAMP(0, cpos, tfix->size[ai] - 1);
+    c0[ai] = AIR_CAST(int, cpos);
+    ringMax = AIR_MAX(ringMax, c0[ai]);
+    ringMax = AIR_MAX(ringMax, AIR_CAST(int, tfix->size[ai]) - 1 - c0[ai]);
+  }
+  best2 = maxDist > 0 ? maxDist*maxDist : AIR_POS_INF;
+  bestFi = UINT_MAX;
+  for (ring=0; ring<=ringMax; ring++) {
+    /* the cells of this ring, and beyond, are at least this far away */
+    near = (ring - 1)*tfix->cellSize;
+    if (ring > 1 && near*near > best2) {
+      break;
+    }
+    for (ai=0; ai<3; ai++) {
+      lo[ai] = AIR_MAX(c0[ai] - ring, 0);
+      hi[ai] = AIR_MIN(c0[ai] + ring, AIR_CAST(int, tfix->size[ai]) - 1);
+    }
+    for (cc[2]=lo[2]; cc[2]<=hi[2]; cc[2]++) {
+      for (cc[1]=lo[1]; cc[1]<=hi[1]; cc[1]++) {
+        for (cc[0]=lo[0]; cc[0]<=hi[0]; cc[0]++) {
+          if (AIR_ABS(cc[0] - c0[0]) != ring
+              && AIR_ABS(cc[1] - c0[1]) != ring
+              && AIR_ABS(cc[2] - c0[2]) != ring) {
+            /* not on the shell; was searched in an earlier ring */
+            continue;
+          }
+          II = (AIR_CAST(size_t, cc[0])
+                + tfix->size[0]*(AIR_CAST(size_t, cc[1])
+                                 + AIR_CAST(size_t, tfix->size[1])
+                                 *AIR_CAST(size_t, cc[2])));
+          for (si=tfix->cellStart[II]; si<tfix->cellStart[II+1]; si++) {
+            vi = tfix->seg[si];
+            fi = _tenFiberIndexFiber(tfix, vi);
+            ve = _tenFiberIndexSegEnd(tfix, fi, vi);
+            dist2 = _tenFiberIndexSegDist2(pos, tfix->vert + 3*vi,
+                                           tfix->vert + 3*ve);
+            if (dist2 < best2 || (dist2 == best2 && fi < bestFi)) {
+              best2 = dist2;
+              bestFi = fi;
+            }
+          }
+        }
+      }
+    }
+  }
+  *fiberIdxP = bestFi;
+  *distP = UINT_MAX == bestFi ? AIR_POS_INF : sqrt(best2);
+  return 0;
+}
@@ -177,6 +177,11 @@ _tenFiberContextCommonNew(const Nrrd *vol, int useDwi,
   tfx->minRadius = 1;    /* above lament applies here as well */
   tfx->minFraction = 0.5; /* and here */
   tfx->wPunct = tenDefFiberWPunct;
+  tfx->threadNum = 1;
+  tfx->dirCache = AIR_FALSE;
+  tfx->dcache = NULL;
+  tfx->dcacheOwn = AIR_FALSE;
+  tfx->dcacheSeen = NULL;
 
   GAGE_QUERY_RESET(tfx->query);
   tfx->mframe[0] = vol->measurementFrame[0][0];
@@ -370,6 +375,29 @@ tenFiberTypeSet(tenFiberContext *tfx, int ftype) {
   return 0;
 }
 
+/*
+** the tenGage item for fast computation of the given tenAniso anisotropy,
+** or 0 if there isn't one
+*/
+static int
+_tenFiberAnisoGage(int aniso) {
+  int ret;
+
+  switch(aniso) {
+  case tenAniso_FA:      ret = tenGageFA;      break;
+  case tenAniso_Cl1:     ret = tenGageCl1;     break;
+  case tenAniso_Cp1:     ret = tenGageCp1;     break;
+  case tenAniso_Ca1:     ret = tenGageCa1;     break;
+  case tenAniso_Clpmin1: ret = tenGageClpmin1; break;
+  case tenAniso_Cl2:     ret = tenGageCl2;     break;
+  case tenAniso_Cp2:     ret = tenGageCp2;     break;
+  case tenAniso_Ca2:     ret = tenGageCa2;     break;
+  case tenAniso_Clpmin2: ret = tenGageClpmin2; break;
+  default:               ret = 0;              break;
+  }
+  return ret;
+}
+
 /*
 ******** tenFiberStopSet
 **
@@ -419,39 +447,11 @@ tenFiberStopSet(tenFiberContext *tfx, int stop, ...) {
          item to turn on here... */
       tfx->gageAnisoStop = NULL;
     } else { /* using tensors */
-      switch(tfx->anisoStopType) {
-      case tenAniso_FA:
-        anisoGage = tenGageFA;
-        break;
-      case tenAniso_Cl1:
-        anisoGage = tenGageCl1;
-        break;
-      case tenAniso_Cp1:
-        anisoGage = tenGageCp1;
-        break;
-      case tenAniso_Ca1:
-        anisoGage = tenGageCa1;
-        break;
-      case tenAniso_Clpmin1:
-        anisoGage = tenGageClpmin1;
-        break;
-      case tenAniso_Cl2:
-        anisoGage = tenGageCl2;
-        break;
-      case tenAniso_Cp2:
-        anisoGage = tenGageCp2;
-        break;
-      case tenAniso_Ca2:
-        anisoGage = tenGageCa2;
-        break;
-      case tenAniso_Clpmin2:
-        anisoGage = tenGageClpmin2;
-        break;
-      default:
+      anisoGage = _tenFiberAnisoGage(tfx->anisoStopType);
+      if (!anisoGage) {
         biffAddf(TEN, "%s: sorry, currently don't have fast %s computation "
                 "via gage", me, airEnumStr(tenAniso, tfx->anisoStopType));
         ret = 1; goto end;
-        break;
       }
       /* NOTE: we are no longer computing ALL anisotropy measures ...
          GAGE_QUERY_ITEM_ON(tfx->query, tenGageAniso);
@@ -644,33 +644,11 @@ tenFiberAnisoSpeedSet(tenFiberContext *tfx, int aniso,
     biffAddf(TEN, "%s: aniso %d not valid", me, aniso);
     return 1;
   }
-  switch(aniso) {
-  case tenAniso_FA:
-    anisoGage = tenGageFA;
-    break;
-  case tenAniso_Cl1:
-    anisoGage = tenGageCl1;
-    break;
-  case tenAniso_Cp1:
-    anisoGage = tenGageCp1;
-    break;
-  case tenAniso_Ca1:
-    anisoGage = tenGageCa1;
-    break;
-  case tenAniso_Cl2:
-    anisoGage = tenGageCl2;
-    break;
-  case tenAniso_Cp2:
-    anisoGage = tenGageCp2;
-    break;
-  case tenAniso_Ca2:
-    anisoGage = tenGageCa2;
-    break;
-  default:
+  anisoGage = _tenFiberAnisoGage(aniso);
+  if (!anisoGage) {
     biffAddf(TEN, "%s: sorry, currently don't have fast %s computation "
-            "via gage", me, airEnumStr(tenAniso, tfx->anisoStopType));
+            "via gage", me, airEnumStr(tenAniso, aniso));
     return 1;
-    break;
   }
   tfx->anisoSpeedType = aniso;
   if (tfx->useDwi) {
@@ -769,6 +747,12 @@ tenFiberParmSet(tenFiberContext *tfx, int parm, double val) {
     case tenFiberParmVerbose:
       tfx->verbose = AIR_CAST(int, val);
       break;
+    case tenFiberParmThreadNum:
+      tfx->threadNum = AIR_CAST(unsigned int, AIR_MAX(1, val));
+      break;
+    case tenFiberParmDirCache:
+      tfx->dirCache = !!val;
+      break;
     default:
       fprintf(stderr, "%s: WARNING!!! tenFiberParm %d not handled\n",
               me, parm);
@@ -823,6 +807,26 @@ tenFiberUpdate(tenFiberContext *tfx) {
       return 1;
     }
   }
+  /* the cache depends on fiber type and anisos, so it's always re-made */
+  if (tfx->dcacheOwn) {
+    tfx->dcache = _tenFiberDirCacheNix(tfx->dcache);
+  }
+  tfx->dcache = NULL;
+  tfx->dcacheOwn = AIR_FALSE;
+  tfx->dcacheSeen = AIR_CAST(const float **, airFree(tfx->dcacheSeen));
+  if (tfx->dirCache) {
+    if (!( tfx->dcache = _tenFiberDirCacheNew(tfx) )) {
+      biffAddf(TEN, "%s: couldn't set up direction cache", me);
+      return 1;
+    }
+    tfx->dcacheOwn = AIR_TRUE;
+    tfx->dcacheSeen = AIR_CALLOC(_tenFiberDirCacheBrickNum(tfx->dcache),
+                                 const float *);
+    if (!tfx->dcacheSeen) {
+      biffAddf(TEN, "%s: couldn't allocate direction cache bricks", me);
+      return 1;
+    }
+  }
   return 0;
 }
 
@@ -844,6 +848,26 @@ tenFiberContextCopy(tenFiberContext *oldTfx) {
   memcpy(tfx, oldTfx, sizeof(tenFiberContext));
   tfx->ksp = nrrdKernelSpecCopy(oldTfx->ksp);
   tfx->gtx = gageContextCopy(oldTfx->gtx);
+  if (!tfx->gtx) {
+    biffMovef(TEN, GAGE, "%s: couldn't copy gage context", me);
+    nrrdKernelSpecNix(tfx->ksp);
+    free(tfx);
+    return NULL;
+  }
+  /* the direction cache is shared, but what's been seen of it is not */
+  tfx->dcacheOwn = AIR_FALSE;
+  tfx->dcacheSeen = NULL;
+  if (tfx->dcache) {
+    tfx->dcacheSeen = AIR_CALLOC(_tenFiberDirCacheBrickNum(tfx->dcache),
+                                 const float *);
+    if (!tfx->dcacheSeen) {
+      biffAddf(TEN, "%s: couldn't allocate direction cache bricks", me);
+      gageContextNix(tfx->gtx);
+      nrrdKernelSpecNix(tfx->ksp);
+      free(tfx);
+      return NULL;
+    }
+  }
   tfx->pvl = tfx->gtx->pvl[0];  /* HEY! gage API sucks */
   tfx->gageTen = gageAnswerPointer(tfx->gtx, tfx->pvl, tenGageTensor);
   tfx->gageEval = gageAnswerPointer(tfx->gtx, tfx->pvl, tenGageEval0);
@@ -855,11 +879,16 @@ tenFiberContextCopy(tenFiberContext *oldTfx) {
                          : (tenFiberTypeEvec1 == tfx->fiberType
                             ? tenGageEvec1
                             : tenGageEvec2)));
-  tfx->gageAnisoStop = gageAnswerPointer(tfx->gtx, tfx->pvl,
-                                         tfx->anisoStopType);
-  tfx->gageAnisoSpeed = (tfx->anisoSpeedType
+  /* anisoStopType and anisoSpeedType are from tenAniso, not tenGage */
+  tfx->gageAnisoStop = (oldTfx->gageAnisoStop
+                        ? gageAnswerPointer(tfx->gtx, tfx->pvl,
+                                            _tenFiberAnisoGage(
+                                              tfx->anisoStopType))
+                        : NULL);
+  tfx->gageAnisoSpeed = (oldTfx->gageAnisoSpeed
                          ? gageAnswerPointer(tfx->gtx, tfx->pvl,
-                                             tfx->anisoSpeedType)
+                                             _tenFiberAnisoGage(
+                                               tfx->anisoSpeedType))
                          : NULL);
   return tfx;
 }
@@ -870,6 +899,10 @@ tenFiberContextNix(tenFiberContext *tfx) {
   if (tfx) {
     tfx->ksp = nrrdKernelSpecNix(tfx->ksp);
     tfx->gtx = gageContextNix(tfx->gtx);
+    if (tfx->dcacheOwn) {
+      tfx->dcache = _tenFiberDirCacheNix(tfx->dcache);
+    }
+    airFree(tfx->dcacheSeen);
     free(tfx);
   }
   return NULL;
@@ -0,0 +1,466 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "ten.h"
+#include "privateTen.h"
+
+/* how many visits a thread collects before adding them to the output */
+#define _TEN_FIBER_PROB_FLUSH 4096
+
+/*
+** _tenFiberProbTask, _tenFiberProbThreadArg: for tenFiberProbTrace, with
+** seeds handed out one at a time to threads
+*/
+typedef struct {
+  const tenFiberContext *tfx;
+  const void *boot;           /* bootstrap tensors */
+  double (*lup)(const void *, size_t);
+  unsigned int bootNum,       /* tensors per voxel in boot */
+    size[3],                  /* volume size */
+    evecIdx,                  /* which eigenvector is followed */
+    seedNum, walkNum, rngSeed,
+    workIdx;                  /* next seed to hand out */
+  const double *seed;         /* world-space seed points */
+  double minCos;              /* smallest cosine between successive steps
+                                 allowed by tenFiberStopRadius */
+  unsigned int *count;        /* output visit counts */
+  airThreadMutex *workMutex;  /* NULL for a single thread; also held
+                                 while adding to count */
+} _tenFiberProbTask;
+
+typedef struct {
+  _tenFiberProbTask *task;
+  airRandMTState *rng;        /* random numbers of this thread */
+  size_t *visit,              /* voxels visited by finished walks (once per
+                                 walk), followed by those of the current
+                                 walk, yet to be added to task->count */
+    visitNum,                 /* length of visit */
+    walkStart;                /* where the current walk starts in visit */
+  airArray *visitArr;         /* allocates visit, in blocks */
+  int failed;                 /* couldn't allocate visit */
+} _tenFiberProbThreadArg;
+
+static int
+_tenFiberProbVisitCompare(const void *_a, const void *_b) {
+  size_t a, b;
+
+  a = *AIR_CAST(const size_t *, _a);
+  b = *AIR_CAST(const size_t *, _b);
+  return (a < b ? -1 : (a > b ? 1 : 0));
+}
+
+/* adds the visits of finished walks to the output */
+static void
+_tenFiberProbFlush(_tenFiberProbThreadArg *arg) {
+  _tenFiberProbTask *task;
+  size_t ii;
+
+  task = arg->task;
+  if (task->workMutex) {
+    airThreadMutexLock(task->workMutex);
+  }
+  for (ii=0; ii<arg->walkStart; ii++) {
+    task->count[arg->visit[ii]]++;
+  }
+  if (task->workMutex) {
+    airThreadMutexUnlock(task->workMutex);
+  }
+  arg->visitNum = arg->walkStart = 0;
+  return;
+}
+
+/* records voxel II as visited by the current walk */
+static void
+_tenFiberProbVisit(_tenFiberProbThreadArg *arg, size_t II) {
+
+  /* successive steps are often in the same voxel */
+  if (arg->visitNum > arg->walkStart && arg->visit[arg->visitNum-1] == II) {
+    return;
+  }
+  if (arg->visitNum == arg->visitArr->len) {
+    airArrayLenIncr(arg->visitArr, AIR_CAST(int, arg->visitArr->incr));
+    if (!arg->visit) {
+      arg->failed = AIR_TRUE;
+      arg->visitNum = arg->walkStart = 0;
+      return;
+    }
+  }
+  arg->visit[arg->visitNum++] = II;
+  return;
+}
+
+/*
+** ends the current walk: its voxels are sorted so that each is kept only
+** once, and the visits are added to the output if there are enough
+*/
+static void
+_tenFiberProbWalkDone(_tenFiberProbThreadArg *arg) {
+  size_t ii, jj, *visit;
+
+  visit = arg->visit + arg->walkStart;
+  qsort(visit, arg->visitNum - arg->walkStart, sizeof(size_t),
+        _tenFiberProbVisitCompare);
+  jj = 0;
+  for (ii=0; ii<arg->visitNum - arg->walkStart; ii++) {
+    if (!ii || visit[ii] != visit[jj-1]) {
+      visit[jj++] = visit[ii];
+    }
+  }
+  arg->visitNum = arg->walkStart = arg->walkStart + jj;
+  if (arg->walkStart >= _TEN_FIBER_PROB_FLUSH) {
+    _tenFiberProbFlush(arg);
+  }
+  return;
+}
+
+/*
+** one random walk from seed (in world space): both halves of a fiber, each
+** step of which follows the eigenvector of a randomly chosen bootstrap
+** tensor at the nearest voxel.  Each voxel visited by the walk is
+** counted once.
+*/
+static void
+_tenFiberProbWalk(_tenFiberProbThreadArg *arg, const double seed[3]) {
+  _tenFiberProbTask *task;
+  const tenFiberContext *tfx;
+  double wPos[3], iPos[3], ten[7], eval[3], evec[9], dir[3], lastDir[3],
+    seedDir[3], len, dot, min, max[3];
+  unsigned int halfIdx, stepIdx, ai, vi[3], bi, ci;
+  size_t II;
+  int stop;
+
+  task = arg->task;
+  tfx = task->tfx;
+  /* same bounds as gageProbe */
+  min = nrrdCenterNode == tfx->gtx->shape->center ? 0 : -0.5;
+  for (ai=0; ai<3; ai++) {
+    max[ai] = task->size[ai] - 1 - min;
+  }
+  ELL_3V_SET(seedDir, 0, 0, 0);
+  ELL_3V_SET(lastDir, 0, 0, 0);
+  for (halfIdx=0; halfIdx<=1; halfIdx++) {
+    ELL_3V_COPY(wPos, seed);
+    len = 0;
+    for (stepIdx=0; AIR_TRUE; stepIdx++) {
+      gageShapeWtoI(tfx->gtx->shape, iPos, wPos);
+      stop = AIR_FALSE;
+      for (ai=0; ai<3; ai++) {
+        if (!( AIR_IN_CL(min, iPos[ai], max[ai]) )) {
+          stop = AIR_TRUE;
+          break;
+        }
+        vi[ai] = AIR_CAST(unsigned int, floor(iPos[ai] + 0.5));
+        vi[ai] = AIR_MIN(vi[ai], task->size[ai] - 1);
+      }
+      if (stop) {
+        break;
+      }
+      II = vi[0] + task->size[0]*(vi[1] + AIR_CAST(size_t, task->size[1])
+                                  *vi[2]);
+      _tenFiberProbVisit(arg, II);
+      if (((tfx->stop & (1 << tenFiberStopNumSteps))
+           && stepIdx >= tfx->maxNumSteps)
+          || ((tfx->stop & (1 << tenFiberStopLength))
+              && len >= tfx->maxHalfLen)
+          || stepIdx >= TEN_FIBER_NUM_STEPS_MAX) {
+        break;
+      }
+      bi = task->bootNum > 1 ? airRandInt_r(arg->rng, task->bootNum) : 0;
+      for (ci=0; ci<7; ci++) {
+        ten[ci] = task->lup(task->boot, ci + 7*(bi + task->bootNum*II));
+      }
+      if ((tfx->stop & (1 << tenFiberStopConfidence))
+          && ten[0] < tfx->confThresh) {
+        break;
+      }
+      tenEigensolve_d(eval, evec, ten);
+      if ((tfx->stop & (1 << tenFiberStopAniso))
+          && tenAnisoEval_d(eval, tfx->anisoStopType) < tfx->anisoThresh) {
+        break;
+      }
+      ELL_3V_COPY(dir, evec + 3*task->evecIdx);
+      if (!stepIdx) {
+        /* as in _tenFiberAlign, the second half starts opposite to where
+           the first half went */
+        if (!halfIdx) {
+          ELL_3V_COPY(seedDir, dir);
+        } else if (ELL_3V_DOT(dir, seedDir) > 0) {
+          ELL_3V_SCALE(dir, -1, dir);
+        }
+      } else {
+        dot = ELL_3V_DOT(dir, lastDir);
+        if (dot < 0) {
+          ELL_3V_SCALE(dir, -1, dir);
+          dot = -dot;
+        }
+        if (dot < task->minCos) {
+          break;
+        }
+      }
+      ELL_3V_SCALE_INCR(wPos, tfx->stepSize, dir);
+      len += tfx->stepSize;
+      ELL_3V_COPY(lastDir, dir);
+    }
+  }
+  _tenFiberProbWalkDone(arg);
+  return;
+}
+
+static void *
+_tenFiberProbWorker(void *_arg) {
+  _tenFiberProbThreadArg *arg;
+  _tenFiberProbTask *task;
+  unsigned int seedIdx, walkIdx;
+
+  arg = AIR_CAST(_tenFiberProbThreadArg *, _arg);
+  task = arg->task;
+  for (;;) {
+    if (task->workMutex) {
+      airThreadMutexLock(task->workMutex);
+    }
+    seedIdx = task->workIdx;
+    if (seedIdx < task->seedNum) {
+      task->workIdx++;
+    }
+    if (task->workMutex) {
+      airThreadMutexUnlock(task->workMutex);
+    }
+    if (seedIdx == task->seedNum) {
+      /* no more work */
+      break;
+    }
+    /* re-seeded at every seed, so that the results don't depend on which
+       thread did the seed */
+    airSrandMT_r(arg->rng, task->rngSeed + seedIdx);
+    for (walkIdx=0; walkIdx<task->walkNum; walkIdx++) {
+      _tenFiberProbWalk(arg, task->seed + 3*seedIdx);
+    }
+  }
+  _tenFiberProbFlush(arg);
+  return _arg;
+}
+
+/*
+******** tenFiberProbTrace
+**
+** probabilistic tractography: walkNum random walks from each of the seeds
+** in nseed (3-by-N, in index space if tfx->useIndexSpace, else world
+** space).  At each step of a walk, one of the tensors at the nearest
+** voxel of nboot is chosen at random, and the walk follows the eigenvector
+** that tfx->fiberType says to (evec0, evec1, or evec2), aligned with the
+** previous step.  nboot is a 7-by-N-by-X-by-Y-by-Z volume of N samples of
+** the tensor at each voxel, such as from tenEstimate1TensorBootstrap (or
+** a tensor volume, for N=1), on the same grid as the tensor volume of
+** tfx.  The walks use the step size, the number of threads, and these
+** stopping criteria of tfx: tenFiberStopAniso, tenFiberStopConfidence,
+** tenFiberStopNumSteps, tenFiberStopLength, and tenFiberStopRadius (as a
+** limit on the turning angle between steps), as well as leaving the
+** volume.
+**
+** The output nvisit is an unsigned int volume counting, at each voxel,
+** how many walks visited it.  Each thread keeps a list of the voxels
+** visited by its walks, and adds them to nvisit (under a mutex) only every
+** so often, so the memory used per thread doesn't depend on the volume
+** size, and there is no locking in the walks.  Each seed has its own
+** random numbers (from rngSeed and the seed index), so the results are the
+** same with any number of threads.
+*/
+int
+tenFiberProbTrace(Nrrd *nvisit, tenFiberContext *tfx, const Nrrd *nboot,
+                  const Nrrd *_nseed, unsigned int walkNum,
+                  unsigned int rngSeed) {
+  static const char me[]="tenFiberProbTrace";
+  airArray *mop;
+  _tenFiberProbTask task;
+  _tenFiberProbThreadArg *arg;
+  unsigned int ai, ti, si, threadNum;
+  size_t NN;
+  double *seed, sinHalf;
+  int axmap[3];
+  Nrrd *nseed;
+
+  if (!( nvisit && tfx && nboot && _nseed )) {
+    biffAddf(TEN, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (tfx->useDwi) {
+    biffAddf(TEN, "%s: need a tensor, not DWI, context", me);
+    return 1;
+  }
+  if (!( tenFiberTypeEvec0 == tfx->fiberType
+         || tenFiberTypeEvec1 == tfx->fiberType
+         || tenFiberTypeEvec2 == tfx->fiberType )) {
+    biffAddf(TEN, "%s: need fiber type %s, %s, or %s (not %s)", me,
+             airEnumStr(tenFiberType, tenFiberTypeEvec0),
+             airEnumStr(tenFiberType, tenFiberTypeEvec1),
+             airEnumStr(tenFiberType, tenFiberTypeEvec2),
+             airEnumStr(tenFiberType, tfx->fiberType));
+    return 1;
+  }
+  if (!( (4 == nboot->dim || 5 == nboot->dim)
+         && 7 == nboot->axis[0].size
+         && nrrdTypeBlock != nboot->type )) {
+    biffAddf(TEN, "%s: need 4-D or 5-D (not %u-D) scalar nboot with "
+             "7 (not %u) values on axis 0", me, nboot->dim,
+             AIR_CAST(unsigned int, nboot->axis[0].size));
+    return 1;
+  }
+  task.bootNum = (5 == nboot->dim
+                  ? AIR_CAST(unsigned int, nboot->axis[1].size)
+                  : 1);
+  for (ai=0; ai<3; ai++) {
+    task.size[ai] = AIR_CAST(unsigned int, tfx->nin->axis[1+ai].size);
+    if (task.size[ai] != nboot->axis[nboot->dim-3+ai].size) {
+      biffAddf(TEN, "%s: nboot axis %u size %u != tensor axis %u size %u",
+               me, nboot->dim-3+ai,
+               AIR_CAST(unsigned int, nboot->axis[nboot->dim-3+ai].size),
+               1+ai, task.size[ai]);
+      return 1;
+    }
+  }
+  if (!( 2 == _nseed->dim && 3 == _nseed->axis[0].size )) {
+    biffAddf(TEN, "%s: seed list should be a 2-D (not %u-D) "
+             "3-by-X (not %u-by-X) array", me, _nseed->dim,
+             AIR_CAST(unsigned int, _nseed->axis[0].size));
+    return 1;
+  }
+  if (!( walkNum > 0 && tfx->stepSize > 0 )) {
+    biffAddf(TEN, "%s: need positive walkNum (%u) and step size (%g)", me,
+             walkNum, tfx->stepSize);
+    return 1;
+  }
+
+  mop = airMopNew();
+  NN = AIR_CAST(size_t, task.size[0])*task.size[1]*task.size[2];
+  if (nrrdMaybeAlloc_va(nvisit, nrrdTypeUInt, 3,
+                        AIR_CAST(size_t, task.size[0]),
+                        AIR_CAST(size_t, task.size[1]),
+                        AIR_CAST(size_t, task.size[2]))) {
+    biffMovef(TEN, NRRD, "%s: couldn't allocate output", me);
+    airMopError(mop); return 1;
+  }
+  task.count = AIR_CAST(unsigned int *, nvisit->data);
+  memset(task.count, 0, NN*sizeof(unsigned int));
+  /* seeds are converted to world space once */
+  nseed = nrrdNew();
+  airMopAdd(mop, nseed, (airMopper)nrrdNuke, airMopAlways);
+  if (nrrdConvert(nseed, _nseed, nrrdTypeDouble)) {
+    biffMovef(TEN, NRRD, "%s: couldn't convert seed list", me);
+    airMopError(mop); return 1;
+  }
+  task.seedNum = AIR_CAST(unsigned int, nseed->axis[1].size);
+  seed = AIR_CAST(double *, nseed->data);
+  if (tfx->useIndexSpace) {
+    double tmp[3];
+    for (si=0; si<task.seedNum; si++) {
+      ELL_3V_COPY(tmp, seed + 3*si);
+      gageShapeItoW(tfx->gtx->shape, seed + 3*si, tmp);
+    }
+  }
+  task.tfx = tfx;
+  task.boot = nboot->data;
+  task.lup = nrrdDLookup[nboot->type];
+  task.evecIdx = (tenFiberTypeEvec1 == tfx->fiberType
+                  ? 1
+                  : (tenFiberTypeEvec2 == tfx->fiberType ? 2 : 0));
+  task.seed = seed;
+  task.walkNum = walkNum;
+  task.rngSeed = rngSeed;
+  task.workIdx = 0;
+  /* a turn by angle theta between steps of length s is on a circle of
+     radius s/(2 sin(theta/2)) */
+  task.minCos = -2;
+  if (tfx->stop & (1 << tenFiberStopRadius)) {
+    sinHalf = tfx->stepSize/(2*tfx->minRadius);
+    if (sinHalf < 1) {
+      task.minCos = 1 - 2*sinHalf*sinHalf;
+    }
+  }
+  /* no more threads than seeds */
+  threadNum = AIR_MIN(tfx->threadNum, task.seedNum);
+  threadNum = AIR_MAX(threadNum, 1);
+  arg = AIR_CALLOC(threadNum, _tenFiberProbThreadArg);
+  airMopAdd(mop, arg, airFree, airMopAlways);
+  if (!arg) {
+    biffAddf(TEN, "%s: couldn't allocate per-thread info", me);
+    airMopError(mop); return 1;
+  }
+  if (1 < threadNum) {
+    if (!( task.workMutex = airThreadMutexNew() )) {
+      biffAddf(TEN, "%s: couldn't create work mutex", me);
+      airMopError(mop); return 1;
+    }
+    airMopAdd(mop, task.workMutex, (airMopper)airThreadMutexNix,
+              airMopAlways);
+    if (!airThreadCapable) {
+      fprintf(stderr, "%s: WARNING: not multi-threaded; will do %u "
+              "\"threads\" serially !!!\n", me, threadNum);
+    }
+  } else {
+    task.workMutex = NULL;
+  }
+  for (ti=0; ti<threadNum; ti++) {
+    arg[ti].task = &task;
+    arg[ti].rng = airRandMTStateNew(0);
+    airMopAdd(mop, arg[ti].rng, (airMopper)airRandMTStateNix, airMopAlways);
+    arg[ti].visitArr = airArrayNew(AIR_CAST(void **, &(arg[ti].visit)),
+                                   NULL, sizeof(size_t),
+                                   _TEN_FIBER_PROB_FLUSH);
+    airMopAdd(mop, arg[ti].visitArr, (airMopper)airArrayNuke,
+              airMopAlways);
+    arg[ti].visitNum = arg[ti].walkStart = 0;
+    arg[ti].failed = AIR_FALSE;
+    if (!( arg[ti].rng && arg[ti].visitArr )) {
+      biffAddf(TEN, "%s: couldn't allocate buffers for thread %u", me, ti);
+      airMopError(mop); return 1;
+    }
+  }
+  if (airThreadRun(_tenFiberProbWorker, arg, sizeof(*arg), threadNum)) {
+    biffAddf(TEN, "%s: couldn't run %u threads", me, threadNum);
+    airMopError(mop); return 1;
+  }
+  for (ti=0; ti<threadNum; ti++) {
+    if (arg[ti].failed) {
+      biffAddf(TEN, "%s: thread %u couldn't allocate its visit list", me, ti);
+      airMopError(mop); return 1;
+    }
+  }
+
+  ELL_3V_SET(axmap, 1, 2, 3);
+  if (nrrdAxisInfoCopy(nvisit, tfx->nin, axmap, NRRD_AXIS_INFO_NONE)
+      || nrrdBasicInfoCopy(nvisit, tfx->nin,
+                           NRRD_BASIC_INFO_DATA_BIT
+                           | NRRD_BASIC_INFO_TYPE_BIT
+                           | NRRD_BASIC_INFO_BLOCKSIZE_BIT
+                           | NRRD_BASIC_INFO_DIMENSION_BIT
+                           | NRRD_BASIC_INFO_CONTENT_BIT
+                           | NRRD_BASIC_INFO_COMMENTS_BIT
+                           | (nrrdStateKeyValuePairsPropagate
+                              ? 0
+                              : NRRD_BASIC_INFO_KEYVALUEPAIRS_BIT))) {
+    biffMovef(TEN, NRRD, "%s: couldn't set output info", me);
+    airMopError(mop); return 1;
+  }
+  airMopOkay(mop);
+  return 0;
+}
@@ -0,0 +1,740 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2013, 2012, 2011, 2010, 2009  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "ten.h"
+#include "privateTen.h"
+
+#ifdef _WIN32
+/* no mmap(); streams are read into memory instead */
+#define _TEN_FIBER_STREAM_MMAP 0
+#else
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define _TEN_FIBER_STREAM_MMAP 1
+#endif
+
+/*
+** A stream written to "foo.nhdr" is three files: the "foo.nhdr" detached
+** nrrd header of the vertex records, their raw data in "foo.raw" (which
+** tenFiberStreamAdd() appends to, fiber by fiber), and the offsets in
+** "foo-offset.nrrd", named by the _TEN_FIBER_STREAM_OFF_KEY key/value
+** pair of the header.  Both headers are written by tenFiberStreamClose(),
+** and the vertex header also records with the _TEN_FIBER_STREAM_REC_KEY
+** key/value pair whether the records are floats or half floats (the
+** latter stored as unsigned shorts).  Since nrrds can't be empty, a
+** stream with no fibers has a single all-zero record after its last one.
+*/
+#define _TEN_FIBER_STREAM_OFF_KEY "tenFiberStreamOffset"
+#define _TEN_FIBER_STREAM_REC_KEY "tenFiberStreamRecord"
+#define _TEN_FIBER_STREAM_REC_FLOAT "float"
+#define _TEN_FIBER_STREAM_REC_HALF "half"
+#define _TEN_FIBER_STREAM_OFF_SUFF "-offset" NRRD_EXT_NRRD
+#define _TEN_FIBER_STREAM_DATA_SUFF ".raw"
+
+typedef union {
+  airULLong **u;
+  void **v;
+} _offunion;
+
+tenFiberStream *
+tenFiberStreamNew(void) {
+  tenFiberStream *tfst;
+  _offunion ou;
+
+  tfst = AIR_CALLOC(1, tenFiberStream);
+  if (tfst) {
+    tfst->half = AIR_FALSE;
+    tfst->valLen = 0;
+    tfst->fiberNum = 0;
+    tfst->vertNum = 0;
+    tfst->record = NULL;
+    tfst->offset = NULL;
+    tfst->headName = NULL;
+    tfst->file = NULL;
+    tfst->off = NULL;
+    ou.u = &(tfst->off);
+    tfst->offArr = airArrayNew(ou.v, NULL, sizeof(airULLong), 1024);
+    tfst->buff = NULL;
+    tfst->buffSize = 0;
+    tfst->map[0] = tfst->map[1] = NULL;
+    tfst->mapSize[0] = tfst->mapSize[1] = 0;
+    tfst->nrecord = nrrdNew();
+    tfst->noffset = nrrdNew();
+    if (!( tfst->offArr && tfst->nrecord && tfst->noffset )) {
+      airArrayNuke(tfst->offArr);
+      nrrdNuke(tfst->nrecord);
+      nrrdNuke(tfst->noffset);
+      tfst = AIR_CAST(tenFiberStream *, airFree(tfst));
+    }
+  }
+  return tfst;
+}
+
+/* closes (without finishing) any file being written, and lets go of any
+   stream that was mapped or read */
+static void
+_tenFiberStreamClear(tenFiberStream *tfst) {
+  unsigned int mi;
+
+  if (tfst->file) {
+    fclose(tfst->file);
+    tfst->file = NULL;
+  }
+  tfst->headName = AIR_CAST(char *, airFree(tfst->headName));
+  for (mi=0; mi<2; mi++) {
+#if _TEN_FIBER_STREAM_MMAP
+    if (tfst->map[mi]) {
+      munmap(tfst->map[mi], tfst->mapSize[mi]);
+    }
+#endif
+    tfst->map[mi] = NULL;
+    tfst->mapSize[mi] = 0;
+  }
+  nrrdEmpty(tfst->nrecord);
+  nrrdEmpty(tfst->noffset);
+  tfst->record = NULL;
+  tfst->offset = NULL;
+  tfst->fiberNum = 0;
+  tfst->vertNum = 0;
+  airArrayLenSet(tfst->offArr, 0);
+  return;
+}
+
+tenFiberStream *
+tenFiberStreamNix(tenFiberStream *tfst) {
+
+  if (tfst) {
+    _tenFiberStreamClear(tfst);
+    airArrayNuke(tfst->offArr);
+    nrrdNuke(tfst->nrecord);
+    nrrdNuke(tfst->noffset);
+    airFree(tfst->buff);
+    airFree(tfst);
+  }
+  return NULL;
+}
+
+/* the name of a file to go with the header named head: head with its
+   ".nhdr" replaced by suff, and with head's directory if full, else
+   without it (as the file is named inside the header) */
+static char *
+_tenFiberStreamName(const char *head, const char *suff, int full) {
+  const char *base;
+  char *name;
+  size_t len;
+
+  base = strrchr(head, '/');
+  base = (full || !base) ? head : base + 1;
+  len = strlen(base) - strlen(NRRD_EXT_NHDR);
+  name = AIR_CALLOC(len + strlen(suff) + 1, char);
+  if (name) {
+    memcpy(name, base, len);
+    strcpy(name + len, suff);
+  }
+  return name;
+}
+
+/* size in bytes of one vertex record */
+static size_t
+_tenFiberStreamRecordSize(const tenFiberStream *tfst) {
+
+  return (3 + tfst->valLen)*(tfst->half
+                             ? sizeof(unsigned short)
+                             : sizeof(float));
+}
+
+/*
+******** tenFiberStreamOpen
+**
+** starts writing fibers to a new stream, with vertex header filename
+** (which has to end in ".nhdr"), with (if half) coordinates and values
+** stored as 16-bit half-precision floats, else as floats, and with valLen
+** values per vertex (as set by tenFiberProbeItemSet), or none if valLen
+** is 0.  The stream has to be finished with tenFiberStreamClose() before
+** tenFiberStreamMap() can read it.
+*/
+int
+tenFiberStreamOpen(tenFiberStream *tfst, const char *filename,
+                   int half, unsigned int valLen) {
+  static const char me[]="tenFiberStreamOpen";
+  char *dataName;
+
+  if (!(tfst && filename)) {
+    biffAddf(TEN, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (!airEndsWith(filename, NRRD_EXT_NHDR)) {
+    biffAddf(TEN, "%s: filename \"%s\" doesn't end in \"%s\"", me,
+             filename, NRRD_EXT_NHDR);
+    return 1;
+  }
+  _tenFiberStreamClear(tfst);
+  tfst->half = !!half;
+  tfst->valLen = valLen;
+  airArrayLenSet(tfst->offArr, 1);
+  if (!tfst->off) {
+    biffAddf(TEN, "%s: couldn't allocate offsets", me);
+    return 1;
+  }
+  tfst->off[0] = 0;
+  tfst->headName = airStrdup(filename);
+  dataName = _tenFiberStreamName(filename, _TEN_FIBER_STREAM_DATA_SUFF,
+                                 AIR_TRUE);
+  if (!( tfst->headName && dataName )) {
+    biffAddf(TEN, "%s: couldn't allocate filenames", me);
+    airFree(dataName);
+    return 1;
+  }
+  if (!(tfst->file = fopen(dataName, "wb"))) {
+    biffAddf(TEN, "%s: couldn't open \"%s\" for writing", me, dataName);
+    airFree(dataName);
+    return 1;
+  }
+  airFree(dataName);
+  return 0;
+}
+
+/*
+******** tenFiberStreamAdd
+**
+** writes the vertices (and probed values, if tfst->valLen) of one traced
+** fiber.  Like tenFiberMultiPolyData(), fibers that went nowhere are
+** skipped.
+*/
+int
+tenFiberStreamAdd(tenFiberStream *tfst, const tenFiberSingle *tfbs) {
+  static const char me[]="tenFiberStreamAdd";
+  const double *vert, *val;
+  unsigned short *hout;
+  float *fout;
+  size_t vi, vertNum, size;
+  unsigned int ci, recLen;
+
+  if (!(tfst && tfbs)) {
+    biffAddf(TEN, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (!tfst->file) {
+    biffAddf(TEN, "%s: stream not open for writing", me);
+    return 1;
+  }
+  if (tenFiberStopUnknown != tfbs->whyNowhere) {
+    return 0;
+  }
+  if (!(tfbs->nvert && 2 == tfbs->nvert->dim
+        && nrrdTypeDouble == tfbs->nvert->type
+        && 3 == tfbs->nvert->axis[0].size)) {
+    biffAddf(TEN, "%s: fiber vertices not a 3-by-N array of %s", me,
+             airEnumStr(nrrdType, nrrdTypeDouble));
+    return 1;
+  }
+  vertNum = tfbs->nvert->axis[1].size;
+  if (tfst->valLen) {
+    if (!(tfbs->nval && 2 == tfbs->nval->dim
+          && nrrdTypeDouble == tfbs->nval->type
+          && tfst->valLen == tfbs->nval->axis[0].size
+          && vertNum == tfbs->nval->axis[1].size)) {
+      biffAddf(TEN, "%s: fiber values not a %u-by-%u array of %s", me,
+               tfst->valLen, AIR_CAST(unsigned int, vertNum),
+               airEnumStr(nrrdType, nrrdTypeDouble));
+      return 1;
+    }
+    val = AIR_CAST(const double *, tfbs->nval->data);
+  } else {
+    val = NULL;
+  }
+  vert = AIR_CAST(const double *, tfbs->nvert->data);
+  size = vertNum*_tenFiberStreamRecordSize(tfst);
+  if (size > tfst->buffSize) {
+    airFree(tfst->buff);
+    if (!(tfst->buff = malloc(size))) {
+      biffAddf(TEN, "%s: couldn't allocate %u-byte buffer", me,
+               AIR_CAST(unsigned int, size));
+      tfst->buffSize = 0;
+      return 1;
+    }
+    tfst->buffSize = size;
+  }
+  recLen = 3 + tfst->valLen;
+  hout = AIR_CAST(unsigned short *, tfst->buff);
+  fout = AIR_CAST(float *, tfst->buff);
+  for (vi=0; vi<vertNum; vi++) {
+    for (ci=0; ci<recLen; ci++) {
+      float fv;
+      fv = AIR_CAST(float, (ci < 3
+                            ? vert[ci + 3*vi]
+                            : val[ci - 3 + tfst->valLen*vi]));
+      if (tfst->half) {
+        hout[ci + recLen*vi] = airHalfFromFloat(fv);
+      } else {
+        fout[ci + recLen*vi] = fv;
+      }
+    }
+  }
+  if (size && 1 != fwrite(tfst->buff, size, 1, tfst->file)) {
+    biffAddf(TEN, "%s: couldn't write fiber %u", me, tfst->fiberNum);
+    return 1;
+  }
+  airArrayLenIncr(tfst->offArr, 1);
+  if (!tfst->off) {
+    biffAddf(TEN, "%s: couldn't grow offsets", me);
+    return 1;
+  }
+  tfst->vertNum += vertNum;
+  tfst->fiberNum++;
+  tfst->off[tfst->fiberNum] = tfst->vertNum;
+  return 0;
+}
+
+/*
+******** tenFiberStreamClose
+**
+** finishes the stream started by tenFiberStreamOpen(), by closing the
+** vertex data file and writing the offsets and the vertex header.  A
+** stream with no fibers (or vertices) is still valid, and maps to
+** tfst->fiberNum == 0.  tfst->fiberNum and tfst->vertNum remain set.
+*/
+int
+tenFiberStreamClose(tenFiberStream *tfst) {
+  static const char me[]="tenFiberStreamClose";
+  airArray *mop;
+  NrrdIoState *nio;
+  Nrrd *nrec, *noff;
+  char *offName, *offBase, *dataBase;
+  FILE *file;
+  unsigned int ii;
+  int bad;
+  size_t recNum;
+
+  if (!tfst) {
+    biffAddf(TEN, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (!tfst->file) {
+    biffAddf(TEN, "%s: stream not open for writing", me);
+    return 1;
+  }
+  bad = AIR_FALSE;
+  recNum = tfst->vertNum;
+  if (!recNum) {
+    /* the sentinel record that keeps the vertex nrrd from being empty */
+    size_t size;
+    size = _tenFiberStreamRecordSize(tfst);
+    if (size > tfst->buffSize) {
+      airFree(tfst->buff);
+      tfst->buff = calloc(size, 1);
+      tfst->buffSize = tfst->buff ? size : 0;
+    } else {
+      memset(tfst->buff, 0, size);
+    }
+    bad = !( tfst->buff && 1 == fwrite(tfst->buff, size, 1, tfst->file) );
+    recNum = 1;
+  }
+  bad |= fclose(tfst->file);
+  tfst->file = NULL;
+  if (bad) {
+    biffAddf(TEN, "%s: couldn't finish vertex data file", me);
+    return 1;
+  }
+  mop = airMopNew();
+  nrec = nrrdNew();
+  airMopAdd(mop, nrec, (airMopper)nrrdNix, airMopAlways);
+  noff = nrrdNew();
+  airMopAdd(mop, noff, (airMopper)nrrdNix, airMopAlways);
+  nio = nrrdIoStateNew();
+  airMopAdd(mop, nio, (airMopper)nrrdIoStateNix, airMopAlways);
+  offName = _tenFiberStreamName(tfst->headName, _TEN_FIBER_STREAM_OFF_SUFF,
+                                AIR_TRUE);
+  airMopAdd(mop, offName, airFree, airMopAlways);
+  offBase = _tenFiberStreamName(tfst->headName, _TEN_FIBER_STREAM_OFF_SUFF,
+                                AIR_FALSE);
+  airMopAdd(mop, offBase, airFree, airMopAlways);
+  dataBase = _tenFiberStreamName(tfst->headName, _TEN_FIBER_STREAM_DATA_SUFF,
+                                 AIR_FALSE);
+  if (!( nrec && noff && nio && offName && offBase && dataBase )) {
+    biffAddf(TEN, "%s: couldn't allocate", me);
+    airFree(dataBase);
+    airMopError(mop); return 1;
+  }
+  /* the vertex data file, as named in the header, is freed with nio */
+  ii = airArrayLenIncr(nio->dataFNArr, 1);
+  if (!nio->dataFN) {
+    biffAddf(TEN, "%s: couldn't allocate data filename", me);
+    airFree(dataBase);
+    airMopError(mop); return 1;
+  }
+  nio->dataFN[ii] = dataBase;
+  if (nrrdWrap_va(noff, tfst->off, nrrdTypeULLong, 1,
+                  AIR_CAST(size_t, tfst->fiberNum + 1))
+      || nrrdSave(offName, noff, NULL)) {
+    biffMovef(TEN, NRRD, "%s: couldn't save offsets", me);
+    airMopError(mop); return 1;
+  }
+  /* the vertex records are already in the data file, and aren't in
+     memory, so only the header is written, by the format's own writer
+     (as with "unu make -h"), since nrrdWrite() would want nrec->data */
+  nrec->type = tfst->half ? nrrdTypeUShort : nrrdTypeFloat;
+  nrec->dim = 2;
+  nrrdAxisInfoSet_va(nrec, nrrdAxisInfoSize,
+                     AIR_CAST(size_t, 3 + tfst->valLen), recNum);
+  nio->encoding = nrrdEncodingRaw;
+  nio->detachedHeader = AIR_TRUE;
+  nio->skipData = AIR_TRUE;
+  if (nrrdKeyValueAdd(nrec, _TEN_FIBER_STREAM_OFF_KEY, offBase)
+      || nrrdKeyValueAdd(nrec, _TEN_FIBER_STREAM_REC_KEY,
+                         (tfst->half
+                          ? _TEN_FIBER_STREAM_REC_HALF
+                          : _TEN_FIBER_STREAM_REC_FLOAT))) {
+    biffMovef(TEN, NRRD, "%s: couldn't set key/value pairs", me);
+    airMopError(mop); return 1;
+  }
+  if (!(file = fopen(tfst->headName, "wb"))) {
+    biffAddf(TEN, "%s: couldn't open \"%s\" for writing", me,
+             tfst->headName);
+    airMopError(mop); return 1;
+  }
+  airMopAdd(mop, file, (airMopper)airFclose, airMopAlways);
+  if (nrrdFormatNRRD->write(file, nrec, nio)) {
+    biffMovef(TEN, NRRD, "%s: couldn't write header \"%s\"", me,
+              tfst->headName);
+    airMopError(mop); return 1;
+  }
+  airMopOkay(mop);
+  return 0;
+}
+
+/*
+** reads the header of the nrrd in fname into nrrd, and makes its data
+** available at *dataP.  When the data is raw, in one file, in this
+** machine's endianness, and of the given type (or any type if type is
+** nrrdTypeUnknown), that file is mapped (read-only) into memory with
+** mmap(), and the map and its size are saved in *mapP and *mapSizeP.
+** Otherwise the data is read (and converted to type) into nrrd.
+*/
+static int
+_tenFiberStreamNrrdMap(Nrrd *nrrd, void **mapP, size_t *mapSizeP,
+                       const void **dataP, const char *fname, int type) {
+  static const char me[]="_tenFiberStreamNrrdMap";
+  airArray *mop;
+  NrrdIoState *nio;
+  Nrrd *ntmp;
+  char *map;
+
+  mop = airMopNew();
+  nio = nrrdIoStateNew();
+  airMopAdd(mop, nio, (airMopper)nrrdIoStateNix, airMopAlways);
+  if (!nio) {
+    biffAddf(TEN, "%s: couldn't allocate", me);
+    airMopError(mop); return 1;
+  }
+  /* as with "unu data", this leaves the (single) data file open, at the
+     start of the data, after any line and byte skips */
+  nio->skipData = AIR_TRUE;
+  nio->keepNrrdDataFileOpen = AIR_TRUE;
+  if (nrrdLoad(nrrd, fname, nio)) {
+    biffMovef(TEN, NRRD, "%s: couldn't read header \"%s\"", me, fname);
+    airMopAdd(mop, nio->dataFile, (airMopper)airFclose, airMopAlways);
+    airMopError(mop); return 1;
+  }
+  airMopAdd(mop, nio->dataFile, (airMopper)airFclose, airMopAlways);
+  map = NULL;
+#if _TEN_FIBER_STREAM_MMAP
+  if (nio->dataFile
+      && nrrdEncodingRaw == nio->encoding
+      && (nrrdTypeUnknown == type || type == nrrd->type)
+      && (1 == nrrdElementSize(nrrd) || airMyEndian() == nio->endian)) {
+    char stmp[2][AIR_STRLEN_SMALL];
+    struct stat st;
+    size_t size;
+    long pos;
+
+    pos = ftell(nio->dataFile);
+    size = nrrdElementNumber(nrrd)*nrrdElementSize(nrrd);
+    if (pos < 0 || fstat(fileno(nio->dataFile), &st)) {
+      biffAddf(TEN, "%s: couldn't locate data of \"%s\"", me, fname);
+      airMopError(mop); return 1;
+    }
+    *mapSizeP = AIR_CAST(size_t, pos) + size;
+    if (AIR_CAST(size_t, st.st_size) < *mapSizeP) {
+      biffAddf(TEN, "%s: data file of \"%s\" has %s bytes, not %s", me,
+               fname, airSprintSize_t(stmp[0], AIR_CAST(size_t, st.st_size)),
+               airSprintSize_t(stmp[1], *mapSizeP));
+      *mapSizeP = 0;
+      airMopError(mop); return 1;
+    }
+    map = AIR_CAST(char *, mmap(NULL, *mapSizeP, PROT_READ, MAP_SHARED,
+                                fileno(nio->dataFile), 0));
+    if (AIR_CAST(char *, MAP_FAILED) == map) {
+      /* it will be read instead */
+      map = NULL;
+      *mapSizeP = 0;
+    } else {
+      *mapP = map;
+      *dataP = map + pos;
+    }
+  }
+#endif
+  if (!map) {
+    if (nrrdTypeUnknown == type || type == nrrd->type) {
+      if (nrrdLoad(nrrd, fname, NULL)) {
+        biffMovef(TEN, NRRD, "%s: couldn't read \"%s\"", me, fname);
+        airMopError(mop); return 1;
+      }
+    } else {
+      ntmp = nrrdNew();
+      airMopAdd(mop, ntmp, (airMopper)nrrdNuke, airMopAlways);
+      if (nrrdLoad(ntmp, fname, NULL)
+          || nrrdConvert(nrrd, ntmp, type)) {
+        biffMovef(TEN, NRRD, "%s: couldn't read \"%s\" as %s", me, fname,
+                  airEnumStr(nrrdType, type));
+        airMopError(mop); return 1;
+      }
+    }
+    *dataP = nrrd->data;
+  }
+  airMopOkay(mop);
+  return 0;
+}
+
+/*
+******** tenFiberStreamMap
+**
+** makes the fibers of a stream written by tenFiberStreamOpen() et al.,
+** given the name of its vertex header, available in tfst->record and
+** tfst->offset: the records of fiber ii are tfst->offset[ii] through
+** tfst->offset[ii+1]-1, and each record is 3 coordinates and then
+** tfst->valLen values, as tfst->half ? unsigned short half floats (see
+** airHalfToFloat) : floats.  The vertex and offset data files are mapped
+** (read-only) into memory with mmap(), at the data start given by their
+** headers, so streams needn't fit in memory.  Only when a file can't be
+** mapped (no mmap(), or it was re-encoded or, for the offsets, converted
+** to another type, as by unu) is it read into memory instead.
+*/
+int
+tenFiberStreamMap(tenFiberStream *tfst, const char *filename) {
+  static const char me[]="tenFiberStreamMap";
+  airArray *mop;
+  char *offBase, *offName, *recKind;
+  const char *dirEnd;
+  const void *data;
+  const airULLong *offset;
+  size_t dirLen, recNum;
+  unsigned int fi;
+
+  if (!(tfst && filename)) {
+    biffAddf(TEN, "%s: got NULL pointer", me);
+    return 1;
+  }
+  _tenFiberStreamClear(tfst);
+  if (_tenFiberStreamNrrdMap(tfst->nrecord, tfst->map + 0, tfst->mapSize + 0,
+                             &data, filename, nrrdTypeUnknown)) {
+    biffAddf(TEN, "%s: couldn't map vertices", me);
+    _tenFiberStreamClear(tfst); return 1;
+  }
+  tfst->record = data;
+  if (!( 2 == tfst->nrecord->dim
+         && (nrrdTypeFloat == tfst->nrecord->type
+             || nrrdTypeUShort == tfst->nrecord->type)
+         && 3 <= tfst->nrecord->axis[0].size )) {
+    biffAddf(TEN, "%s: vertices not a 2-D %s or %s array with axis 0 "
+             "size >= 3", me, airEnumStr(nrrdType, nrrdTypeFloat),
+             airEnumStr(nrrdType, nrrdTypeUShort));
+    _tenFiberStreamClear(tfst); return 1;
+  }
+  mop = airMopNew();
+  recKind = nrrdKeyValueGet(tfst->nrecord, _TEN_FIBER_STREAM_REC_KEY);
+  airMopAdd(mop, recKind, airFree, airMopAlways);
+  offBase = nrrdKeyValueGet(tfst->nrecord, _TEN_FIBER_STREAM_OFF_KEY);
+  airMopAdd(mop, offBase, airFree, airMopAlways);
+  if (!( recKind && offBase )) {
+    biffAddf(TEN, "%s: \"%s\" is missing \"%s\" or \"%s\" key/value pair",
+             me, filename, _TEN_FIBER_STREAM_REC_KEY,
+             _TEN_FIBER_STREAM_OFF_KEY);
+    _tenFiberStreamClear(tfst); airMopError(mop); return 1;
+  }
+  /* unsigned shorts are only taken as half floats when the header says
+     so, and the type has to match what the header says */
+  tfst->half = !strcmp(_TEN_FIBER_STREAM_REC_HALF, recKind);
+  if (!( (tfst->half && nrrdTypeUShort == tfst->nrecord->type)
+         || (!strcmp(_TEN_FIBER_STREAM_REC_FLOAT, recKind)
+             && nrrdTypeFloat == tfst->nrecord->type) )) {
+    biffAddf(TEN, "%s: \"%s\" records (\"%s\" key/value pair) not "
+             "stored as %s", me, recKind, _TEN_FIBER_STREAM_REC_KEY,
+             airEnumStr(nrrdType, tfst->nrecord->type));
+    _tenFiberStreamClear(tfst); airMopError(mop); return 1;
+  }
+  /* like a detached data file, the offsets are relative to the header */
+  dirEnd = strrchr(filename, '/');
+  dirLen = ('/' != offBase[0] && dirEnd) ? AIR_CAST(size_t,
+                                                    dirEnd + 1 - filename) : 0;
+  offName = AIR_CALLOC(dirLen + strlen(offBase) + 1, char);
+  airMopAdd(mop, offName, airFree, airMopAlways);
+  if (!offName) {
+    biffAddf(TEN, "%s: couldn't allocate", me);
+    _tenFiberStreamClear(tfst); airMopError(mop); return 1;
+  }
+  memcpy(offName, filename, dirLen);
+  strcpy(offName + dirLen, offBase);
+  if (_tenFiberStreamNrrdMap(tfst->noffset, tfst->map + 1, tfst->mapSize + 1,
+                             &data, offName, nrrdTypeULLong)) {
+    biffAddf(TEN, "%s: couldn't map offsets", me);
+    _tenFiberStreamClear(tfst); airMopError(mop); return 1;
+  }
+  if (!( 1 == tfst->noffset->dim )) {
+    biffAddf(TEN, "%s: offsets not a 1-D array", me);
+    _tenFiberStreamClear(tfst); airMopError(mop); return 1;
+  }
+  offset = AIR_CAST(const airULLong *, data);
+  tfst->valLen = AIR_CAST(unsigned int, tfst->nrecord->axis[0].size - 3);
+  recNum = tfst->nrecord->axis[1].size;
+  tfst->fiberNum = AIR_CAST(unsigned int, tfst->noffset->axis[0].size - 1);
+  for (fi=0; fi<tfst->fiberNum; fi++) {
+    if (offset[fi] > offset[fi+1]) {
+      break;
+    }
+  }
+  tfst->vertNum = AIR_CAST(size_t, offset[tfst->fiberNum]);
+  /* an empty stream has one sentinel record */
+  if (!( 0 == offset[0] && fi == tfst->fiberNum
+         && (recNum == tfst->vertNum
+             || (!tfst->vertNum && 1 == recNum)) )) {
+    biffAddf(TEN, "%s: offsets in \"%s\" aren't consistent with %u "
+             "records", me, offName, AIR_CAST(unsigned int, recNum));
+    _tenFiberStreamClear(tfst); airMopError(mop); return 1;
+  }
+  tfst->offset = offset;
+  airMopOkay(mop);
+  return 0;
+}
+
+/* one coordinate or value, by its index among all those of the records */
+double
+_tenFiberStreamLookup(const tenFiberStream *tfst, size_t II) {
+
+  return (tfst->half
+          ? airHalfToFloat(AIR_CAST(const unsigned short *, tfst->record)[II])
+          : AIR_CAST(const float *, tfst->record)[II]);
+}
+
+/*
+******** tenFiberStreamGet
+**
+** copies out of the mapped stream the vertices (into nvert, 3-by-N) and,
+** if nval is non-NULL, the values (into nval, valLen-by-N) of one fiber,
+** as doubles, as in tenFiberSingle->nvert and ->nval
+*/
+int
+tenFiberStreamGet(Nrrd *nvert, Nrrd *nval, const tenFiberStream *tfst,
+                  unsigned int fiberIdx) {
+  static const char me[]="tenFiberStreamGet";
+  size_t vi, vertNum, base;
+  unsigned int ci, recLen;
+  double *vert, *val;
+
+  if (!(nvert && tfst)) {
+    biffAddf(TEN, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (!tfst->offset) {
+    biffAddf(TEN, "%s: no stream mapped", me);
+    return 1;
+  }
+  if (!( fiberIdx < tfst->fiberNum )) {
+    biffAddf(TEN, "%s: fiber %u not in [0,%u)", me, fiberIdx,
+             tfst->fiberNum);
+    return 1;
+  }
+  if (nval && !tfst->valLen) {
+    biffAddf(TEN, "%s: want values but stream has none", me);
+    return 1;
+  }
+  base = AIR_CAST(size_t, tfst->offset[fiberIdx]);
+  vertNum = AIR_CAST(size_t, tfst->offset[fiberIdx+1]) - base;
+  if (nrrdMaybeAlloc_va(nvert, nrrdTypeDouble, 2,
+                        AIR_CAST(size_t, 3), vertNum)
+      || (nval && nrrdMaybeAlloc_va(nval, nrrdTypeDouble, 2,
+                                    AIR_CAST(size_t, tfst->valLen),
+                                    vertNum))) {
+    biffMovef(TEN, NRRD, "%s: couldn't allocate output", me);
+    return 1;
+  }
+  recLen = 3 + tfst->valLen;
+  vert = AIR_CAST(double *, nvert->data);
+  val = nval ? AIR_CAST(double *, nval->data) : NULL;
+  for (vi=0; vi<vertNum; vi++) {
+    for (ci=0; ci<3; ci++) {
+      vert[ci + 3*vi] = _tenFiberStreamLookup(tfst, ci + recLen*(base + vi));
+    }
+    if (val) {
+      for (ci=0; ci<tfst->valLen; ci++) {
+        val[ci + tfst->valLen*vi] =
+          _tenFiberStreamLookup(tfst, 3 + ci + recLen*(base + vi));
+      }
+    }
+  }
+  return 0;
+}
+
+/*
+******** tenFiberStreamPolyData
+**
+** converts the mapped stream to polydata, the same as
+** tenFiberMultiPolyData() would have made from the same fibers
+*/
+int
+tenFiberStreamPolyData(limnPolyData *lpld, const tenFiberStream *tfst) {
+  static const char me[]="tenFiberStreamPolyData";
+  unsigned int fi, vi, ci, recLen;
+
+  if (!(lpld && tfst)) {
+    biffAddf(TEN, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (!tfst->offset) {
+    biffAddf(TEN, "%s: no stream mapped", me);
+    return 1;
+  }
+  if (limnPolyDataAlloc(lpld, 0, /* no extra per-vertex info */
+                        AIR_CAST(unsigned int, tfst->vertNum),
+                        AIR_CAST(unsigned int, tfst->vertNum),
+                        tfst->fiberNum)) {
+    biffMovef(TEN, LIMN, "%s: couldn't allocate output", me);
+    return 1;
+  }
+  recLen = 3 + tfst->valLen;
+  for (vi=0; vi<tfst->vertNum; vi++) {
+    for (ci=0; ci<3; ci++) {
+      lpld->xyzw[ci + 4*vi] =
+        AIR_CAST(float, _tenFiberStreamLookup(tfst, ci + recLen*vi));
+    }
+    lpld->xyzw[3 + 4*vi] = 1.0;
+    lpld->indx[vi] = vi;
+  }
+  for (fi=0; fi<tfst->fiberNum; fi++) {
+    lpld->type[fi] = limnPrimitiveLineStrip;
+    lpld->icnt[fi] = AIR_CAST(unsigned int,
+                              tfst->offset[fi+1] - tfst->offset[fi]);
+  }
+  return 0;
+}
@@ -89,6 +89,15 @@ extern "C" {
     nrrdNuke(npadtmp);                                                  \
   }
 
+/* fiberStream.c */
+extern double _tenFiberStreamLookup(const tenFiberStream *tfst, size_t II);
+
+/* fiberCache.c */
+extern tenFiberDirCache *_tenFiberDirCacheNew(const tenFiberContext *tfx);
+extern tenFiberDirCache *_tenFiberDirCacheNix(tenFiberDirCache *dcache);
+extern size_t _tenFiberDirCacheBrickNum(const tenFiberDirCache *dcache);
+extern int _tenFiberDirCacheProbe(tenFiberContext *tfx, const double wPos[3]);
+
 /* qseg.c: 2-tensor estimation */
 extern void _tenQball(const double b, const int gradcount,
                       const double svals[], const double grads[],
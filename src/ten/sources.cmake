@@ -10,6 +10,11 @@ set(TEN_SOURCES
   epireg.c
   estimate.c
   fiber.c
+  fiberCache.c
+  fiberDensity.c
+  fiberIndex.c
+  fiberProb.c
+  fiberStream.c
   fiberMethods.c
   glyph.c
   grads.c
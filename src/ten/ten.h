@@ -779,9 +779,13 @@ enum {
                                   instead of default world */
   tenFiberParmWPunct,          /* 3: tensor-line parameter */
   tenFiberParmVerbose,         /* 4: verbosity */
+  tenFiberParmThreadNum,       /* 5: number of threads to use in
+                                  tenFiberMultiTrace */
+  tenFiberParmDirCache,        /* 6: non-zero iff tracking should use a
+                                  tenFiberDirCache instead of gage */
   tenFiberParmLast
 };
-#define TEN_FIBER_PARM_MAX        4
+#define TEN_FIBER_PARM_MAX        6
 
 enum {
   tenTripleTypeUnknown,    /* 0: nobody knows */
@@ -798,6 +802,31 @@ enum {
 };
 #define TEN_TRIPLE_TYPE_MAX   9
 
+/*
+******** tenFiberDirCache
+**
+** per-voxel eigensystem and anisotropies of a tensor volume, computed
+** lazily (on first touch, a brick of voxels at a time) so that fiber
+** tracking can interpolate these instead of probing the tensor with gage
+** and solving for its eigensystem at every step.  Set up by tenFiberUpdate
+** when tenFiberParmDirCache is on, and shared by the copies made with
+** tenFiberContextCopy.
+*/
+typedef struct {
+  const Nrrd *nin;          /* tensor volume (not owned) */
+  unsigned int size[3],     /* number of voxels along each axis */
+    bnum[3],                /* number of bricks along each axis */
+    evecIdx;                /* which eigenvector is tracked */
+  int anisoStopType,        /* anisotropy cached for stopping, or
+                               tenAnisoUnknown if not needed */
+    anisoSpeedType;         /* anisotropy cached for step size, or
+                               tenAnisoUnknown if not needed */
+  float **brick;            /* records of each brick, or NULL if that
+                               brick hasn't been computed yet */
+  size_t brickMade;         /* number of bricks computed so far */
+  airThreadMutex *mutex;    /* guards brick[] and brickMade */
+} tenFiberDirCache;
+
 /*
 ******** tenFiberContext
 **
@@ -831,8 +860,17 @@ typedef struct {
     minRadius,          /* minimum radius of curvature of path */
     minFraction;        /* minimum fractional constituency in multi-tensor */
   double wPunct;        /* knob for tensor lines */
-  unsigned int ten2Which;  /* which path to follow in 2-tensor tracking */
+  unsigned int ten2Which,  /* which path to follow in 2-tensor tracking */
+    threadNum;             /* number of threads to use in
+                              tenFiberMultiTrace */
+  int dirCache;         /* interpolate from a tenFiberDirCache, instead
+                           of probing with gage */
   /* ---- internal ----- */
+  tenFiberDirCache *dcache; /* cache used if dirCache, else NULL */
+  int dcacheOwn;        /* this context (not a copy) owns dcache */
+  const float **dcacheSeen; /* per brick: what this context has seen of
+                               dcache->brick[], so it only needs the
+                               mutex the first time */
   gageQuery query;      /* query we'll send to gageQuerySet */
   int halfIdx,          /* current fiber half being computed (0 or 1) */
     mframeUse;          /* need to use mframe[] and mframeT[] */
@@ -899,6 +937,83 @@ typedef struct {
   airArray *fiberArr;
 } tenFiberMulti;
 
+/*
+******** tenFiberStream
+**
+** fibers written one fiber at a time as they are traced (by
+** tenFiberStreamAdd() or tenFiberStreamTrace()) rather than accumulated
+** in a tenFiberMulti, and read back (with tenFiberStreamMap()).  On
+** disk, a stream is a nrrd with a detached header (a ".nhdr" file) for
+** the vertices, which is a (3+valLen)-by-vertNum array of records of 3
+** coordinates and then valLen probed values, as floats or (as unsigned
+** shorts) 16-bit half floats, plus a 1-D nrrd of fiberNum+1 vertex
+** offsets saying where each fiber's records start, named by the
+** "tenFiberStreamOffset" key/value pair of the vertex header.  Reading
+** maps these files into memory, so streams needn't fit in memory.
+*/
+typedef struct {
+  /* ---- set by tenFiberStreamOpen() or tenFiberStreamMap() ---- */
+  int half;                 /* records are half floats, not floats */
+  unsigned int valLen,      /* # values per vertex after coordinates */
+    fiberNum;               /* # fibers written or read */
+  size_t vertNum;           /* total # vertices (records) */
+  /* ---- set by tenFiberStreamMap() ---- */
+  const void *record;       /* all the vertex records */
+  const airULLong *offset;  /* fiberNum+1 vertex offsets: records of fiber
+                               ii are offset[ii] through offset[ii+1]-1 */
+  /* ---- internal ----- */
+  char *headName;           /* name of header being written */
+  FILE *file;               /* data file being written */
+  airULLong *off;           /* offsets written so far, managed by offArr */
+  airArray *offArr;
+  void *buff;               /* records of one fiber being written */
+  size_t buffSize;          /* allocated size of buff, in bytes */
+  void *map[2];             /* mmap()ed vertex and offset files, ... */
+  size_t mapSize[2];        /* ... of these sizes, or NULL if ... */
+  Nrrd *nrecord,            /* ... the vertex records, and ... */
+    *noffset;               /* ... the offsets were read into these;
+                               either way these have the headers */
+} tenFiberStream;
+
+/*
+******** tenFiberIndex
+**
+** a uniform grid of cubic cells over a set of fibers, for finding which
+** fibers go through regions (with tenFiberIndexSelect()), or which is
+** nearest a point (with tenFiberIndexNearest()), without looking at all
+** of them.  Each cell lists the segments (by the index of their first
+** vertex) whose bounding boxes overlap it.  Made by tenFiberIndexBuild().
+*/
+typedef struct {
+  unsigned int fiberNum;    /* # fibers */
+  size_t vertNum;           /* total # vertices */
+  float *vert;              /* 3*vertNum coordinates, fiber by fiber */
+  size_t *vertStart;        /* fiberNum+1 offsets: vertices of fiber ii
+                               are vertStart[ii] to vertStart[ii+1]-1 */
+  double origin[3],         /* low corner of the grid */
+    cellSize;               /* edge length of the cells */
+  unsigned int size[3];     /* # cells along each axis */
+  size_t *cellStart;        /* cellNum+1 offsets: segments of cell ii are
+                               seg[cellStart[ii]] to
+                               seg[cellStart[ii+1]-1] */
+  size_t *seg;              /* first vertex of each segment of each cell */
+} tenFiberIndex;
+
+/*
+******** tenFiberRegion
+**
+** one region for tenFiberIndexSelect(): a mask volume if nmask is
+** non-NULL, or else a sphere.  Fibers going through an exclusion region
+** (with non-zero exclude) are never selected.  All fields are set
+** directly.
+*/
+typedef struct {
+  const Nrrd *nmask;        /* non-zero voxels are the region, or NULL */
+  double center[3],         /* if nmask is NULL, center and radius of */
+    radius;                 /* the sphere that is the region */
+  int exclude;              /* fibers through here are excluded */
+} tenFiberRegion;
+
 /*
 ******** struct tenEmBimodalParm
 **
@@ -1044,7 +1159,9 @@ typedef struct {
     negEvalShift,          /* if non-zero, shift eigenvalues upwards so that
                               smallest one is non-negative */
     progress;              /* progress indication for volume processing */
-  unsigned int WLSIterNum; /* number of iterations for WLS */
+  unsigned int WLSIterNum, /* number of iterations for WLS */
+    threadNum;             /* number of threads to use in
+                              tenEstimate1TensorVolume4D() */
   /* internal -------- */
   /* a "dwi" in here is basically any value (diffusion-weighted or not)
      that varies as a function of the model parameters being estimated */
@@ -1462,6 +1579,8 @@ TEN_EXPORT int tenEstimateSigmaSet(tenEstimateContext *tec,
                                    double sigma);
 TEN_EXPORT int tenEstimateValueMinSet(tenEstimateContext *tec,
                                       double valueMin);
+TEN_EXPORT int tenEstimateThreadNumSet(tenEstimateContext *tec,
+                                      unsigned int threadNum);
 TEN_EXPORT int tenEstimateGradientsSet(tenEstimateContext *tec,
                                        const Nrrd *ngrad,
                                        double bValue, int estimateB0);
@@ -1502,6 +1621,11 @@ TEN_EXPORT int tenEstimate1TensorVolume4D(tenEstimateContext *tec,
                                           Nrrd *nten,
                                           Nrrd **nB0P, Nrrd **nterrP,
                                           const Nrrd *ndwi, int outType);
+TEN_EXPORT int tenEstimate1TensorBootstrap(tenEstimateContext *tec,
+                                           Nrrd *nboot, const Nrrd *ndwi,
+                                           unsigned int bootNum,
+                                           unsigned int rngSeed,
+                                           int outType);
 TEN_EXPORT tenEstimateContext *tenEstimateContextNix(tenEstimateContext *tec);
 
 /* aniso.c */
@@ -1599,6 +1723,55 @@ TEN_EXPORT int tenFiberMultiPolyData(tenFiberContext *tfx,
                                      limnPolyData *lpld, tenFiberMulti *tfml);
 TEN_EXPORT int tenFiberMultiProbeVals(tenFiberContext *tfx,
                                       Nrrd *nval, tenFiberMulti *tfml);
+TEN_EXPORT int tenFiberStreamTrace(tenFiberContext *tfx,
+                                   tenFiberStream *tfst,
+                                   const Nrrd *nseed);
+
+/* fiberStream.c */
+TEN_EXPORT tenFiberStream *tenFiberStreamNew(void);
+TEN_EXPORT tenFiberStream *tenFiberStreamNix(tenFiberStream *tfst);
+TEN_EXPORT int tenFiberStreamOpen(tenFiberStream *tfst, const char *filename,
+                                  int half, unsigned int valLen);
+TEN_EXPORT int tenFiberStreamAdd(tenFiberStream *tfst,
+                                 const tenFiberSingle *tfbs);
+TEN_EXPORT int tenFiberStreamClose(tenFiberStream *tfst);
+TEN_EXPORT int tenFiberStreamMap(tenFiberStream *tfst, const char *filename);
+TEN_EXPORT int tenFiberStreamGet(Nrrd *nvert, Nrrd *nval,
+                                 const tenFiberStream *tfst,
+                                 unsigned int fiberIdx);
+TEN_EXPORT int tenFiberStreamPolyData(limnPolyData *lpld,
+                                      const tenFiberStream *tfst);
+
+/* fiberDensity.c */
+TEN_EXPORT int tenFiberDensity(Nrrd *ndens, const tenFiberMulti *tfml,
+                               const tenFiberStream *tfst, const Nrrd *nvol,
+                               int indexSpace, unsigned int superSample,
+                               unsigned int threadNum);
+TEN_EXPORT int tenFiberConnectivity(Nrrd *ncount, Nrrd *nlen,
+                                    const tenFiberMulti *tfml,
+                                    const tenFiberStream *tfst,
+                                    const Nrrd *nlabel, int indexSpace,
+                                    unsigned int threadNum);
+
+/* fiberIndex.c */
+TEN_EXPORT tenFiberIndex *tenFiberIndexNew(void);
+TEN_EXPORT tenFiberIndex *tenFiberIndexNix(tenFiberIndex *tfix);
+TEN_EXPORT int tenFiberIndexBuild(tenFiberIndex *tfix,
+                                  const tenFiberMulti *tfml,
+                                  const tenFiberStream *tfst,
+                                  const limnPolyData *lpld,
+                                  double cellSize, unsigned int threadNum);
+TEN_EXPORT int tenFiberIndexSelect(Nrrd *nlist, const tenFiberIndex *tfix,
+                                   const tenFiberRegion *region,
+                                   unsigned int regionNum, int indexSpace);
+TEN_EXPORT int tenFiberIndexNearest(unsigned int *fiberIdxP, double *distP,
+                                    const tenFiberIndex *tfix,
+                                    const double pos[3], double maxDist);
+
+/* fiberProb.c */
+TEN_EXPORT int tenFiberProbTrace(Nrrd *nvisit, tenFiberContext *tfx,
+                                 const Nrrd *nboot, const Nrrd *nseed,
+                                 unsigned int walkNum, unsigned int rngSeed);
 
 /* epireg.c */
 TEN_EXPORT int _tenEpiRegThresholdFind(double *DWthrP, Nrrd **nin,
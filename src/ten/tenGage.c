@@ -24,10 +24,102 @@
 #include "ten.h"
 #include "privateTen.h"
 
+/*
+** _tenGageAnswer() is a long walk through item tests, most of which are
+** false for any given query.  The tests are grouped into sections, and
+** _tenGagePvlDataUpdate() "compiles" the query (once per gageUpdate())
+** into a flag per section, so that each probe skips over the sections
+** it has nothing to compute in.  Every item tested in a section of
+** _tenGageAnswer() has to be listed in that section here.
+*/
+enum {
+  _tenGageSectionGrad,        /* 0: invariant and eigenvalue gradients */
+  _tenGageSectionHess,        /* 1: invariant Hessians, curvatures */
+  _tenGageSectionEvec0,       /* 2: gradients dotted with evec0 */
+  _tenGageSectionCovar,       /* 3: covariance, interpolation hacks */
+  _tenGageSectionClpGrad,     /* 4: cl1, cp1, ca1 gradients */
+  _tenGageSectionEigenFrame,  /* 5: eigenframe gradients and Hessians */
+  _tenGageSectionLast
+};
+
+/* each list is ended by tenGageUnknown, and sized by its initializer */
+static const int
+_tenGageSectionGradItem[] = {
+  tenGageDelNormK2, tenGageDelNormK3, tenGageDelNormR1, tenGageDelNormR2,
+  tenGageDelNormPhi1, tenGageDelNormPhi2, tenGageDelNormPhi3,
+  tenGageTensorGrad, tenGageTensorGradMag, tenGageTraceGradVec,
+  tenGageTraceGradMag, tenGageTraceNormal, tenGageBGradVec, tenGageBGradMag,
+  tenGageBNormal, tenGageDetGradVec, tenGageDetGradMag, tenGageDetNormal,
+  tenGageSGradVec, tenGageSGradMag, tenGageSNormal, tenGageNormGradVec,
+  tenGageNormGradMag, tenGageNormNormal, tenGageQGradVec, tenGageQGradMag,
+  tenGageQNormal, tenGageFAGradVec, tenGageFAGradMag, tenGageFANormal,
+  tenGageRGradVec, tenGageRGradMag, tenGageRNormal, tenGageModeGradVec,
+  tenGageModeGradMag, tenGageModeNormal, tenGageThetaGradVec,
+  tenGageThetaGradMag, tenGageThetaNormal, tenGageOmegaGradVec,
+  tenGageOmegaGradMag, tenGageOmegaNormal, tenGageInvarKGrads,
+  tenGageInvarKGradMags, tenGageInvarRGrads, tenGageInvarRGradMags,
+  tenGageEvalGrads, tenGageRotTans, tenGageRotTanMags, tenGageUnknown};
+
+static const int
+_tenGageSectionHessItem[] = {
+  tenGageHessian, tenGageTraceHessian, tenGageTraceHessianEvec,
+  tenGageTraceHessianEval, tenGageTraceHessianFrob, tenGageBHessian,
+  tenGageDetHessian, tenGageSHessian, tenGageQHessian, tenGageFAHessian,
+  tenGageFAHessianEvec, tenGageFAHessianEval, tenGageFAHessianFrob,
+  tenGageFARidgeSurfaceStrength, tenGageFAValleySurfaceStrength,
+  tenGageFALaplacian, tenGageFAHessianEvalMode, tenGageFARidgeLineAlignment,
+  tenGageFARidgeSurfaceAlignment, tenGageFA2ndDD, tenGageFAGeomTens,
+  tenGageFATotalCurv, tenGageFAKappa1, tenGageFAKappa2, tenGageFAMeanCurv,
+  tenGageFAShapeIndex, tenGageFAGaussCurv, tenGageFACurvDir1,
+  tenGageFACurvDir2, tenGageFAFlowlineCurv, tenGageRHessian,
+  tenGageModeHessian, tenGageModeHessianEvec, tenGageModeHessianEval,
+  tenGageModeHessianFrob, tenGageOmegaHessian, tenGageOmegaHessianEvec,
+  tenGageOmegaHessianEval, tenGageOmegaLaplacian, tenGageOmega2ndDD,
+  tenGageOmegaHessianContrTenEvec0, tenGageOmegaHessianContrTenEvec1,
+  tenGageOmegaHessianContrTenEvec2, tenGageUnknown};
+
+static const int
+_tenGageSectionEvec0Item[] = {
+  tenGageTraceGradVecDotEvec0, tenGageTraceDiffusionAlign,
+  tenGageTraceDiffusionFraction, tenGageFAGradVecDotEvec0,
+  tenGageFADiffusionAlign, tenGageFADiffusionFraction,
+  tenGageOmegaGradVecDotEvec0, tenGageOmegaDiffusionAlign,
+  tenGageOmegaDiffusionFraction, tenGageConfGradVecDotEvec0,
+  tenGageConfDiffusionAlign, tenGageConfDiffusionFraction, tenGageUnknown};
+
+static const int
+_tenGageSectionCovarItem[] = {
+  tenGageCovariance, tenGageCovarianceRGRT, tenGageCovarianceKGRT,
+  tenGageTensorLogEuclidean, tenGageTensorQuatGeoLoxK,
+  tenGageTensorQuatGeoLoxR, tenGageTensorRThetaPhiLinear, tenGageUnknown};
+
+static const int
+_tenGageSectionClpGradItem[] = {
+  tenGageCl1GradVec, tenGageCl1GradMag, tenGageCl1Normal, tenGageCp1GradVec,
+  tenGageCp1GradMag, tenGageCp1Normal, tenGageCa1GradVec, tenGageCa1GradMag,
+  tenGageCa1Normal, tenGageUnknown};
+
+static const int
+_tenGageSectionEigenFrameItem[] = {
+  tenGageTensorGradRotE, tenGageEvalHessian, tenGageCl1Hessian,
+  tenGageCl1HessianEvec, tenGageCl1HessianEval, tenGageCp1Hessian,
+  tenGageCp1HessianEvec, tenGageCp1HessianEval, tenGageCa1Hessian,
+  tenGageCa1HessianEvec, tenGageCa1HessianEval, tenGageFiberCurving,
+  tenGageFiberDispersion, tenGageUnknown};
+
+static const int *const
+_tenGageSectionItem[_tenGageSectionLast] = {
+  _tenGageSectionGradItem, _tenGageSectionHessItem,
+  _tenGageSectionEvec0Item, _tenGageSectionCovarItem,
+  _tenGageSectionClpGradItem, _tenGageSectionEigenFrameItem
+};
+
 typedef struct {
   double *buffTen, *buffWght;
   tenInterpParm *tip;  /* sneakiness: using tip->allocLen to record
                           allocation sizes of buffTen and buffWght, too */
+  int section[_tenGageSectionLast]; /* which _tenGageSectionItem sections
+                                       of _tenGageAnswer() are needed */
 } _tenGagePvlData;
 
 gageItemEntry
@@ -397,7 +489,9 @@ _tenGageAnswer(gageContext *ctx, gagePerVolume *pvl) {
   double hessCbA[9]={0,0,0,0,0,0,0,0,0},
     hessCbC[9]={0,0,0,0,0,0,0,0,0};
   int ci;
+  _tenGagePvlData *pvlData;
 
+  pvlData = AIR_CAST(_tenGagePvlData *, pvl->data);
   tenAns = pvl->directAnswer[tenGageTensor];
   evalAns = pvl->directAnswer[tenGageEval];
   evecAns = pvl->directAnswer[tenGageEvec];
@@ -495,6 +589,10 @@ _tenGageAnswer(gageContext *ctx, gagePerVolume *pvl) {
     tenEigensolve_d(evalAns, NULL, tenAns);
   }
 
+  /* --- gradients of invariants and eigenvalues --- */
+  if (!pvlData->section[_tenGageSectionGrad]) {
+    goto gradDone;
+  }
   if (GAGE_QUERY_ITEM_TEST(pvl->query, tenGageDelNormK2)
       || GAGE_QUERY_ITEM_TEST(pvl->query, tenGageDelNormK3)) {
     double tmp[7];
@@ -890,6 +988,7 @@ _tenGageAnswer(gageContext *ctx, gagePerVolume *pvl) {
                ELL_3V_LEN(pvl->directAnswer[tenGageRotTans] + 1*3),
                ELL_3V_LEN(pvl->directAnswer[tenGageRotTans] + 2*3));
   }
+ gradDone:
   /* --- C{l,p,a,lpmin}1 --- */
   if (GAGE_QUERY_ITEM_TEST(pvl->query, tenGageCl1)) {
     tmp0 = tenAnisoEval_d(evalAns, tenAniso_Cl1);
@@ -925,6 +1024,9 @@ _tenGageAnswer(gageContext *ctx, gagePerVolume *pvl) {
     pvl->directAnswer[tenGageClpmin2][0] = AIR_CLAMP(0, tmp0, 1);
   }
   /* --- Hessian madness (the derivative, not the soldier) --- */
+  if (!pvlData->section[_tenGageSectionHess]) {
+    goto hessDone;
+  }
   if (GAGE_QUERY_ITEM_TEST(pvl->query, tenGageHessian)) {
     /* done if doD2; still have to set up pointers */
     matTmp = pvl->directAnswer[tenGageHessian];
@@ -1301,7 +1403,11 @@ _tenGageAnswer(gageContext *ctx, gagePerVolume *pvl) {
     pvl->directAnswer[tenGageOmegaHessianContrTenEvec2][0] = ELL_3V_DOT(evec, tmpv);
   }
 
+ hessDone:
   /* --- evec0 dot products */
+  if (!pvlData->section[_tenGageSectionEvec0]) {
+    goto evec0Done;
+  }
   if (GAGE_QUERY_ITEM_TEST(pvl->query, tenGageTraceGradVecDotEvec0)) {
     tmp0 = ELL_3V_DOT(evecAns + 0*3, pvl->directAnswer[tenGageTraceGradVec]);
     pvl->directAnswer[tenGageTraceGradVecDotEvec0][0] = AIR_ABS(tmp0);
@@ -1378,7 +1484,11 @@ _tenGageAnswer(gageContext *ctx, gagePerVolume *pvl) {
   }
 
 
+ evec0Done:
   /* --- Covariance --- */
+  if (!pvlData->section[_tenGageSectionCovar]) {
+    goto covarDone;
+  }
   if (GAGE_QUERY_ITEM_TEST(pvl->query, tenGageCovariance)) {
     unsigned int cc, tt, taa, tbb,
       vijk, vii, vjj, vkk, fd, fddd;
@@ -1473,11 +1583,9 @@ _tenGageAnswer(gageContext *ctx, gagePerVolume *pvl) {
       GAGE_QUERY_ITEM_TEST(pvl->query, tenGageTensorQuatGeoLoxR) ||
       GAGE_QUERY_ITEM_TEST(pvl->query, tenGageTensorRThetaPhiLinear)) {
     unsigned int vijk, vii, vjj, vkk, fd, fddd;
-    _tenGagePvlData *pvlData;
     double *ans;
     int qret;
 
-    pvlData = AIR_CAST(_tenGagePvlData *, pvl->data);
     /* HEY: casting because radius is signed (shouldn't be) */
     fd = AIR_CAST(unsigned int, 2*ctx->radius);
     fddd = fd*fd*fd;
@@ -1524,7 +1632,11 @@ _tenGageAnswer(gageContext *ctx, gagePerVolume *pvl) {
     }
   }
 
+ covarDone:
   /* --- cl/cp/ca gradients --- */
+  if (!pvlData->section[_tenGageSectionClpGrad]) {
+    goto clpGradDone;
+  }
   if (GAGE_QUERY_ITEM_TEST(pvl->query, tenGageCl1GradVec)) {
     vecTmp = pvl->directAnswer[tenGageCl1GradVec];
 
@@ -1597,7 +1709,11 @@ _tenGageAnswer(gageContext *ctx, gagePerVolume *pvl) {
                  magTmp ? 1/magTmp : 0, vecTmp);
   }
 
+ clpGradDone:
   /* --- tensor gradient, rotated into eigenframe of the tensor itself --- */
+  if (!pvlData->section[_tenGageSectionEigenFrame]) {
+    goto eigenFrameDone;
+  }
   if (GAGE_QUERY_ITEM_TEST(pvl->query, tenGageTensorGradRotE)) {
     /* confidence not affected by rotation */
     double evecsT[9], evecs[9], tmp[9], tmp2[9];
@@ -2022,6 +2138,7 @@ _tenGageAnswer(gageContext *ctx, gagePerVolume *pvl) {
     }
   }
 
+ eigenFrameDone:
   /* --- Aniso --- */
   if (GAGE_QUERY_ITEM_TEST(pvl->query, tenGageAniso)) {
     for (ci=tenAnisoUnknown+1; ci<=TEN_ANISO_MAX; ci++) {
@@ -2036,6 +2153,7 @@ _tenGageAnswer(gageContext *ctx, gagePerVolume *pvl) {
 void *
 _tenGagePvlDataNew(const struct gageKind_t *kind) {
   _tenGagePvlData *pvlData;
+  unsigned int si;
 
   AIR_UNUSED(kind);
   pvlData = AIR_CALLOC(1, _tenGagePvlData);
@@ -2043,6 +2161,10 @@ _tenGagePvlDataNew(const struct gageKind_t *kind) {
     pvlData->buffTen = NULL;
     pvlData->buffWght = NULL;
     pvlData->tip = tenInterpParmNew();
+    /* until the query is known, every section is needed */
+    for (si=0; si<_tenGageSectionLast; si++) {
+      pvlData->section[si] = AIR_TRUE;
+    }
   }
   return pvlData;
 }
@@ -2051,7 +2173,7 @@ void *
 _tenGagePvlDataCopy(const struct gageKind_t *kind,
                     const void *_pvlDataOld) {
   _tenGagePvlData *pvlDataNew, *pvlDataOld;
-  unsigned int num;
+  unsigned int num, si;
 
   AIR_UNUSED(kind);
   pvlDataOld = AIR_CAST(_tenGagePvlData *, _pvlDataOld);
@@ -2061,6 +2183,9 @@ _tenGagePvlDataCopy(const struct gageKind_t *kind,
     pvlDataNew->buffTen = AIR_CALLOC(7*num, double);
     pvlDataNew->buffWght = AIR_CALLOC(num, double);
     pvlDataNew->tip = tenInterpParmCopy(pvlDataOld->tip);
+    for (si=0; si<_tenGageSectionLast; si++) {
+      pvlDataNew->section[si] = pvlDataOld->section[si];
+    }
   }
   return pvlDataNew;
 }
@@ -2084,11 +2209,21 @@ _tenGagePvlDataUpdate(const struct gageKind_t *kind,
                       const gageContext *ctx, const gagePerVolume *pvl,
                       const void *_pvlData) {
   _tenGagePvlData *pvlData;
-  unsigned int fd, num;
+  unsigned int fd, num, si, ii;
+  int item;
 
   AIR_UNUSED(kind);
-  AIR_UNUSED(pvl);
   pvlData = AIR_CAST(_tenGagePvlData *, _pvlData);
+  /* compile the query into the sections of _tenGageAnswer() to run */
+  for (si=0; si<_tenGageSectionLast; si++) {
+    pvlData->section[si] = AIR_FALSE;
+    for (ii=0; (item = _tenGageSectionItem[si][ii]); ii++) {
+      if (GAGE_QUERY_ITEM_TEST(pvl->query, item)) {
+        pvlData->section[si] = AIR_TRUE;
+        break;
+      }
+    }
+  }
   fd = AIR_CAST(unsigned int, 2*ctx->radius);
   num = fd*fd*fd;
   if (num != pvlData->tip->allocLen) {
@@ -46,7 +46,7 @@ tend_estimMain(int argc, const char **argv, const char *me,
   char *outS, *terrS, *bmatS, *eb0S;
   float soft, scale, sigma;
   int dwiax, EE, knownB0, oldstuff, estmeth, verbose, fixneg;
-  unsigned int ninLen, axmap[4], wlsi, *skip, skipNum, skipIdx;
+  unsigned int ninLen, axmap[4], wlsi, *skip, skipNum, skipIdx, threadNum;
   double valueMin, thresh;
 
   Nrrd *ngradKVP=NULL, *nbmatKVP=NULL;
@@ -73,6 +73,10 @@ tend_estimMain(int argc, const char **argv, const char *me,
              "eigenvalues by adding (to all eigenvalues) the amount by which "
              "the smallest is negative (corresponding to increasing the "
              "non-DWI image value).");
+  hestOptAdd(&hopt, "nt", "# threads", airTypeUInt, 1, 1, &threadNum, "1",
+             "number of threads to estimate with (not used with -old); "
+             "most useful with \"-est nls\" or \"-est mle\", which take "
+             "much longer per sample");
   hestOptAdd(&hopt, "ee", "filename", airTypeString, 1, 1, &terrS, "",
              "Giving a filename here allows you to save out the tensor "
              "estimation error: a value which measures how much error there "
@@ -271,6 +275,7 @@ tend_estimMain(int argc, const char **argv, const char *me,
     if (!EE) EE |= tenEstimateMethodSet(tec, estmeth);
     if (!EE) EE |= tenEstimateBMatricesSet(tec, nbmat, bval, !knownB0);
     if (!EE) EE |= tenEstimateValueMinSet(tec, valueMin);
+    if (!EE) EE |= tenEstimateThreadNumSet(tec, threadNum);
     for (skipIdx=0; skipIdx<skipNum; skipIdx++) {
       /* fprintf(stderr, "%s: skipping %u\n", me, skip[skipIdx]); */
       if (!EE) EE |= tenEstimateSkipSet(tec, skip[skipIdx], AIR_TRUE);
@@ -36,7 +36,7 @@ tend_fiberMain(int argc, const char **argv, const char *me,
   hestOpt *hopt = NULL;
   char *perr, *err;
   airArray *mop;
-  char *outS;
+  char *outS, *streamS;
 
   tenFiberContext *tfx;
   tenFiberSingle *tfbs;
@@ -45,11 +45,12 @@ tend_fiberMain(int argc, const char **argv, const char *me,
   const airEnum *ftypeEnum;
   char *ftypeS;
   int E, intg, useDwi, allPaths, verbose, worldSpace, worldSpaceOut,
-    ftype, ftypeDef;
+    ftype, ftypeDef, half, dirCache;
   Nrrd *nin, *nseed, *nmat, *_nmat;
-  unsigned int si, stopLen, whichPath;
+  unsigned int si, stopLen, whichPath, threadNum;
   double matx[16]={1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1};
   tenFiberMulti *tfml;
+  tenFiberStream *tfst;
   limnPolyData *fiberPld;
 
   hestOptAdd(&hopt, "i", "nin", airTypeOther, 1, 1, &nin, "-",
@@ -109,11 +110,27 @@ tend_fiberMain(int argc, const char **argv, const char *me,
              &stopLen, NULL, tendFiberStopCB);
   hestOptAdd(&hopt, "v", "verbose", airTypeInt, 1, 1, &verbose, "0",
              "verbosity level");
+  hestOptAdd(&hopt, "nt", "# threads", airTypeUInt, 1, 1, &threadNum, "1",
+             "number of threads to use when tracing from a list of seeds "
+             "(with \"-ap\")");
+  hestOptAdd(&hopt, "dc", NULL, airTypeInt, 0, 0, &dirCache, NULL,
+             "track by interpolating per-voxel eigenvectors and "
+             "anisotropies, computed as needed and cached, rather than "
+             "by probing the tensor with the kernel (which is then only "
+             "used for the values of the probe item, if any)");
   hestOptAdd(&hopt, "nmat", "transform", airTypeOther, 1, 1, &_nmat, "",
              "a 4x4 homogenous transform matrix (as a nrrd, or just a text "
              "file) given with this option will be applied to the output "
              "tractography vertices just prior to output",
              NULL, NULL, nrrdHestNrrd);
+  hestOptAdd(&hopt, "so", "stream out", airTypeString, 1, 1, &streamS, "",
+             "with \"-ap\": instead of making polydata for \"-o\", write "
+             "fibers as they are traced to a nrrd stream with this \".nhdr\" "
+             "vertex header (see tenFiberStreamOpen); can't be used with "
+             "\"-wspo\" or \"-nmat\"");
+  hestOptAdd(&hopt, "half", NULL, airTypeInt, 0, 0, &half, NULL,
+             "with \"-so\": store vertices as 16-bit half floats, rather "
+             "than floats");
   hestOptAdd(&hopt, "o", "out", airTypeString, 1, 1, &outS, "-",
              "output fiber(s)");
 
@@ -218,6 +235,8 @@ tend_fiberMain(int argc, const char **argv, const char *me,
   if (!E) E |= tenFiberParmSet(tfx, tenFiberParmStepSize, step);
   if (!E) E |= tenFiberParmSet(tfx, tenFiberParmUseIndexSpace,
                                worldSpace ? AIR_FALSE: AIR_TRUE);
+  if (!E) E |= tenFiberParmSet(tfx, tenFiberParmThreadNum, threadNum);
+  if (!E) E |= tenFiberParmSet(tfx, tenFiberParmDirCache, dirCache);
   if (!E) E |= tenFiberUpdate(tfx);
   if (E) {
     airMopAdd(mop, err = biffGetDone(TEN), airFree, airMopAlways);
@@ -261,6 +280,26 @@ tend_fiberMain(int argc, const char **argv, const char *me,
       fprintf(stderr, "%s: didn't get seed nrrd via \"-ns\"\n", me);
       airMopError(mop); return 1;
     }
+    if (airStrlen(streamS)) {
+      if (worldSpaceOut || _nmat) {
+        fprintf(stderr, "%s: can't transform output of \"-so\"\n", me);
+        airMopError(mop); return 1;
+      }
+      tfst = tenFiberStreamNew();
+      airMopAdd(mop, tfst, (airMopper)tenFiberStreamNix, airMopAlways);
+      if (!tfst
+          || tenFiberStreamOpen(tfst, streamS, half, 0)
+          || tenFiberStreamTrace(tfx, tfst, nseed)
+          || tenFiberStreamClose(tfst)) {
+        airMopAdd(mop, err = biffGetDone(TEN), airFree, airMopAlways);
+        fprintf(stderr, "%s: trouble:\n%s\n", me, err);
+        airMopError(mop); return 1;
+      }
+      fprintf(stderr, "%s: wrote %u fibers (%u vertices) to \"%s\"\n", me,
+              tfst->fiberNum, AIR_CAST(unsigned int, tfst->vertNum), streamS);
+      airMopOkay(mop);
+      return 0;
+    }
     tfml = tenFiberMultiNew();
     airMopAdd(mop, tfml, (airMopper)tenFiberMultiNix, airMopAlways);
     /*